@@ -0,0 +1,397 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <system.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <adc.h>
+#include <usb/usb.h>
+#include <usb/usb_device_cdc.h>
+
+#include <app_analog.h>
+#include <usb_config.h>
+
+/** DEFINITIONS ****************************************************/
+
+/* Sampling
+ *
+ * Timer2 triggers a conversion every 125us (ADC_TIMER2_PERIOD).  The ADC
+ * interrupt adds the result to the channel's accumulator and switches to
+ * the next channel, which then has a full period to settle.  After
+ * ANALOG_OVERSAMPLE rounds the sums are scaled to 12 bits and smoothed
+ * with a first order IIR filter:
+ *
+ *   frame rate = 7979Hz / (ANALOG_CHANNEL_COUNT * ANALOG_OVERSAMPLE)
+ *              = 249Hz for two channels, i.e. a new frame every 4ms
+ *
+ * The filter state keeps ANALOG_FILTER_FRACTION extra bits so small steps
+ * are not lost; with ANALOG_FILTER_SHIFT = 1 a step settles in ~3 frames.
+ */
+#define ANALOG_OVERSAMPLE           16      // 16 x 10-bit = 14-bit sum
+#define ANALOG_OVERSAMPLE_SHIFT     2       // 14-bit sum -> 12-bit sample
+#define ANALOG_FILTER_FRACTION      3
+#define ANALOG_FILTER_SHIFT         1
+
+/* Stream queue of 12-bit samples, filled by the interrupt and drained by
+ * APP_AnalogTasks().  A CDC packet is [CDC_TYPE_ANALOG_SAMPLES] followed
+ * by ANALOG_SAMPLES_PER_PACKET samples packed two to three bytes:
+ *
+ *   [a7..a0] [b3..b0 a11..a8] [b11..b4]
+ */
+#define ANALOG_QUEUE_SIZE           64      // samples, power of 2
+#define ANALOG_QUEUE_MASK           (ANALOG_QUEUE_SIZE - 1)
+#define ANALOG_PACKET_DATA_SIZE     (CDC_DATA_IN_EP_SIZE - 1)
+#define ANALOG_SAMPLES_PER_PACKET   ((ANALOG_PACKET_DATA_SIZE / 3) * 2)
+
+/* Joystick reports are only sent when an axis moved more than this. */
+#define ANALOG_JOYSTICK_DEADBAND    2
+
+#if ((ANALOG_SAMPLES_PER_PACKET % ANALOG_CHANNEL_COUNT) != 0)
+    #error "A CDC sample packet must hold whole frames: change ANALOG_CHANNEL_COUNT."
+#endif
+#if (ANALOG_SAMPLES_PER_PACKET > (ANALOG_QUEUE_SIZE - ANALOG_CHANNEL_COUNT))
+    #error "ANALOG_QUEUE_SIZE is too small for one CDC sample packet."
+#endif
+
+/** VARIABLES ******************************************************/
+
+static const ADC_CHANNEL analogChannels[ANALOG_CHANNEL_COUNT] = {ANALOG_CHANNEL_LIST};
+
+static volatile uint8_t analogMode;
+
+/* Interrupt context only */
+static uint8_t channelIndex;
+static uint8_t oversampleCount;
+static uint16_t accumulator[ANALOG_CHANNEL_COUNT];
+static int16_t filter[ANALOG_CHANNEL_COUNT];
+
+/* Latest filtered frame, for the joystick report */
+static volatile uint16_t analogValue[ANALOG_CHANNEL_COUNT];
+static volatile bool analogFrameReady;
+
+/* Stream queue: queueHead is only written by the interrupt and queueTail
+ * only by APP_AnalogTasks(), so neither needs a lock. */
+static uint16_t analogQueue[ANALOG_QUEUE_SIZE];
+static volatile uint8_t queueHead;
+static volatile uint8_t queueTail;
+
+static volatile uint16_t samplesDropped;
+static uint32_t samplesSent;
+
+#if !defined(JOYSTICK_INPUT_REPORT_DATA_BUFFER_ADDRESS_TAG)
+    #define JOYSTICK_INPUT_REPORT_DATA_BUFFER_ADDRESS_TAG
+#endif
+static uint8_t joystickReport[HID_JOYSTICK_REPORT_SIZE] JOYSTICK_INPUT_REPORT_DATA_BUFFER_ADDRESS_TAG;
+static uint16_t joystickLast[ANALOG_CHANNEL_COUNT];
+static bool joystickForce;
+
+/*********************************************************************
+* Function: void APP_AnalogInitialize(void);
+*
+* Overview: Enables the analog channels and starts the Timer2 triggered
+*           sampling.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_AnalogInitialize(void)
+{
+    uint8_t i;
+
+    for(i = 0; i < ANALOG_CHANNEL_COUNT; i++)
+    {
+        ADC_Enable(analogChannels[i]);
+    }
+
+    APP_AnalogSetMode(ANALOG_MODE_DEFAULT);
+
+    ADC_SetConfiguration(ADC_CONFIGURATION_TIMER2_TRIGGER);
+    ADC_SelectChannel(analogChannels[0]);
+
+    PIR1bits.ADIF = 0;
+    PIE1bits.ADIE = 1;
+    INTCONbits.PEIE = 1;
+}
+
+/*********************************************************************
+* Function: void APP_AnalogInterruptHandler(void);
+*
+* Overview: Takes one ADC result and builds a frame every
+*           ANALOG_OVERSAMPLE rounds over all channels.
+*
+* PreCondition: PIR1bits.ADIF is set
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_AnalogInterruptHandler(void)
+{
+    uint8_t i;
+    uint16_t sample;
+    bool enqueue;
+
+    PIR1bits.ADIF = 0;
+
+    accumulator[channelIndex] += ADC_ReadResult();
+
+    channelIndex++;
+    if(channelIndex < ANALOG_CHANNEL_COUNT)
+    {
+        ADC_SelectChannel(analogChannels[channelIndex]);
+        return;
+    }
+    channelIndex = 0;
+    ADC_SelectChannel(analogChannels[0]);
+
+    oversampleCount++;
+    if(oversampleCount < ANALOG_OVERSAMPLE)
+    {
+        return;
+    }
+    oversampleCount = 0;
+
+    /* A frame is queued whole or dropped whole, so the stream never gets
+     * out of step with the channel order. */
+    enqueue = false;
+    if(analogMode == ANALOG_MODE_CDC)
+    {
+        if((uint8_t)(queueHead - queueTail) <= (ANALOG_QUEUE_SIZE - ANALOG_CHANNEL_COUNT))
+        {
+            enqueue = true;
+        }
+        else if(samplesDropped <= (0xFFFF - ANALOG_CHANNEL_COUNT))
+        {
+            samplesDropped += ANALOG_CHANNEL_COUNT;
+        }
+    }
+
+    for(i = 0; i < ANALOG_CHANNEL_COUNT; i++)
+    {
+        sample = accumulator[i] >> ANALOG_OVERSAMPLE_SHIFT;
+        accumulator[i] = 0;
+
+        filter[i] += ((int16_t)(sample << ANALOG_FILTER_FRACTION) - filter[i]) >> ANALOG_FILTER_SHIFT;
+        sample = (uint16_t)filter[i] >> ANALOG_FILTER_FRACTION;
+
+        analogValue[i] = sample;
+        if(enqueue == true)
+        {
+            analogQueue[(uint8_t)(queueHead + i) & ANALOG_QUEUE_MASK] = sample;
+        }
+    }
+
+    if(enqueue == true)
+    {
+        queueHead += ANALOG_CHANNEL_COUNT;
+    }
+    analogFrameReady = true;
+}
+
+/*********************************************************************
+* Function: void APP_AnalogTasks(void);
+*
+* Overview: Sends one CDC sample packet when a full packet is queued and
+*           the CDC IN endpoint is free.
+*
+* PreCondition: APP_AnalogInitialize() has been called and the device
+*               is configured.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_AnalogTasks(void)
+{
+    uint8_t *packet;
+    uint8_t tail;
+    uint8_t i;
+    uint16_t a;
+    uint16_t b;
+
+    if(analogMode != ANALOG_MODE_CDC)
+    {
+        return;
+    }
+
+    if((uint8_t)(queueHead - queueTail) < ANALOG_SAMPLES_PER_PACKET)
+    {
+        return;
+    }
+
+    if(USBUSARTIsTxTrfReady() == false)
+    {
+        return;
+    }
+
+    packet = USBUSARTTxBuffer();
+    *packet++ = CDC_TYPE_ANALOG_SAMPLES;
+
+    tail = queueTail;
+    for(i = 0; i < ANALOG_SAMPLES_PER_PACKET; i += 2)
+    {
+        a = analogQueue[tail & ANALOG_QUEUE_MASK];
+        tail++;
+        b = analogQueue[tail & ANALOG_QUEUE_MASK];
+        tail++;
+
+        packet[0] = (uint8_t)a;
+        packet[1] = (uint8_t)(a >> 8) | (uint8_t)(b << 4);
+        packet[2] = (uint8_t)(b >> 4);
+        packet += 3;
+    }
+    queueTail = tail;
+
+    USBUSARTTxBufferSend(1 + ((ANALOG_SAMPLES_PER_PACKET / 2) * 3));
+    samplesSent += ANALOG_SAMPLES_PER_PACKET;
+}
+
+/*********************************************************************
+* Function: const uint8_t* APP_AnalogJoystickReport(void);
+*
+* Overview: Builds the joystick INPUT report from the latest frame if an
+*           axis moved by more than ANALOG_JOYSTICK_DEADBAND.
+*
+* PreCondition: The HID IN endpoint is free.
+*
+* Input: None
+*
+* Output: const uint8_t* - the report, or NULL if there is nothing new.
+*
+********************************************************************/
+const uint8_t* APP_AnalogJoystickReport(void)
+{
+    uint16_t value[ANALOG_CHANNEL_COUNT];
+    int16_t delta;
+    bool moved;
+    uint8_t i;
+
+    if((analogMode != ANALOG_MODE_HID) || (analogFrameReady == false))
+    {
+        return NULL;
+    }
+
+    PIE1bits.ADIE = 0;
+    for(i = 0; i < ANALOG_CHANNEL_COUNT; i++)
+    {
+        value[i] = analogValue[i];
+    }
+    analogFrameReady = false;
+    PIE1bits.ADIE = 1;
+
+    moved = joystickForce;
+    for(i = 0; i < ANALOG_CHANNEL_COUNT; i++)
+    {
+        delta = (int16_t)(value[i] - joystickLast[i]);
+        if((delta > ANALOG_JOYSTICK_DEADBAND) || (delta < -ANALOG_JOYSTICK_DEADBAND))
+        {
+            moved = true;
+        }
+    }
+
+    if(moved == false)
+    {
+        return NULL;
+    }
+
+    joystickForce = false;
+    joystickReport[0] = HID_REPORT_ID_JOYSTICK;
+    for(i = 0; i < ANALOG_CHANNEL_COUNT; i++)
+    {
+        joystickLast[i] = value[i];
+        joystickReport[1 + (i * 2)] = (uint8_t)value[i];
+        joystickReport[2 + (i * 2)] = (uint8_t)(value[i] >> 8);
+    }
+
+    return joystickReport;
+}
+
+/*********************************************************************
+* Function: bool APP_AnalogSetMode(uint8_t mode);
+*
+* Overview: Selects where the samples go and clears the stream queue and
+*           the statistics.
+*
+* PreCondition: None
+*
+* Input: uint8_t mode - ANALOG_MODE
+*
+* Output: bool - false for an unknown mode
+*
+********************************************************************/
+bool APP_AnalogSetMode(uint8_t mode)
+{
+    bool interruptEnabled;
+
+    if(mode >= ANALOG_MODE_MAX)
+    {
+        return false;
+    }
+
+    interruptEnabled = PIE1bits.ADIE;
+    PIE1bits.ADIE = 0;
+
+    analogMode = mode;
+    queueHead = 0;
+    queueTail = 0;
+    samplesDropped = 0;
+    samplesSent = 0;
+    joystickForce = true;   // report the current position right away
+
+    if(interruptEnabled)
+    {
+        PIE1bits.ADIE = 1;
+    }
+
+    return true;
+}
+
+/*********************************************************************
+* Function: void APP_AnalogGetStatistics(ANALOG_STATISTICS *statistics);
+*
+* Overview: Returns the stream throughput and dropped sample counters.
+*
+* PreCondition: None
+*
+* Input: ANALOG_STATISTICS *statistics - filled in
+*
+* Output: None
+*
+********************************************************************/
+void APP_AnalogGetStatistics(ANALOG_STATISTICS *statistics)
+{
+    statistics->samplesSent = samplesSent;
+
+    PIE1bits.ADIE = 0;
+    statistics->samplesDropped = samplesDropped;
+    PIE1bits.ADIE = 1;
+}
@@ -0,0 +1,141 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+#ifndef APP_ANALOG_H
+#define APP_ANALOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** Analog Input Definitions ***************************************/
+// The channels sampled are listed in io_mapping.h (ANALOG_CHANNEL_LIST).
+
+typedef enum
+{
+    ANALOG_MODE_OFF = 0,        // sampling runs, nothing is sent
+    ANALOG_MODE_HID = 1,        // HID joystick axes (HID_REPORT_ID_JOYSTICK)
+    ANALOG_MODE_CDC = 2,        // packed 12-bit samples in full CDC packets
+    ANALOG_MODE_MAX
+} ANALOG_MODE;
+
+typedef struct
+{
+    uint32_t samplesSent;       // samples sent in CDC stream packets
+    uint16_t samplesDropped;    // samples lost because the stream fell behind (saturates)
+} ANALOG_STATISTICS;
+
+/*********************************************************************
+* Function: void APP_AnalogInitialize(void);
+*
+* Overview: Enables the analog channels and starts the Timer2 triggered
+*           sampling.  Results are collected from the ADC interrupt.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_AnalogInitialize(void);
+
+/*********************************************************************
+* Function: void APP_AnalogInterruptHandler(void);
+*
+* Overview: Takes one ADC result, selects the next channel and, once all
+*           channels have been oversampled, filters them into a new frame.
+*           Called from the interrupt when PIR1bits.ADIF is set.
+*
+* PreCondition: APP_AnalogInitialize() has been called.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_AnalogInterruptHandler(void);
+
+/*********************************************************************
+* Function: void APP_AnalogTasks(void);
+*
+* Overview: Sends the CDC sample stream in ANALOG_MODE_CDC.  A packet is
+*           only built once enough samples for a full packet are queued,
+*           and is sent in one go so it does not interleave with the
+*           other CDC messages.
+*
+* PreCondition: APP_AnalogInitialize() has been called and the device
+*               is configured.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_AnalogTasks(void);
+
+/*********************************************************************
+* Function: const uint8_t* APP_AnalogJoystickReport(void);
+*
+* Overview: Returns the joystick INPUT report if an axis moved since the
+*           last report was taken, in ANALOG_MODE_HID.  The keyboard task
+*           sends it when it has no keyboard report of its own to send.
+*
+* PreCondition: APP_AnalogInitialize() has been called.
+*
+* Input: None
+*
+* Output: const uint8_t* - HID_JOYSTICK_REPORT_SIZE byte report in USB
+*         RAM, or NULL if there is nothing new.
+*
+********************************************************************/
+const uint8_t* APP_AnalogJoystickReport(void);
+
+/*********************************************************************
+* Function: bool APP_AnalogSetMode(uint8_t mode);
+*
+* Overview: Selects where the samples go.  The stream queue and the
+*           statistics are cleared.
+*
+* PreCondition: APP_AnalogInitialize() has been called.
+*
+* Input: uint8_t mode - ANALOG_MODE
+*
+* Output: bool - false for an unknown mode
+*
+********************************************************************/
+bool APP_AnalogSetMode(uint8_t mode);
+
+/*********************************************************************
+* Function: void APP_AnalogGetStatistics(ANALOG_STATISTICS *statistics);
+*
+* Overview: Returns the stream throughput and dropped sample counters.
+*
+* PreCondition: APP_AnalogInitialize() has been called.
+*
+* Input: ANALOG_STATISTICS *statistics - filled in
+*
+* Output: None
+*
+********************************************************************/
+void APP_AnalogGetStatistics(ANALOG_STATISTICS *statistics);
+
+#endif //APP_ANALOG_H
@@ -31,14 +31,21 @@
 
 #include <app_led_usb_status.h>
 #include <app_device_cdc_basic.h>
+#include <app_keymap.h>
+#include <app_analog.h>
 #include <usb_config.h>
 
+#include "bootloader/bootloader.h"
+
 /** VARIABLES ******************************************************/
 
 static bool buttonPressed;
-static char buttonMessage[] = "Button pressed.\r\n";
-static uint8_t readBuffer[CDC_DATA_OUT_EP_SIZE];
-static uint8_t writeBuffer[CDC_DATA_IN_EP_SIZE];
+
+/* Packets are built and parsed in place in the CDC endpoint buffers
+ * (USBUSARTTxBuffer()/USBUSARTRxBuffer()), so no local copies are kept. */
+
+/** PRIVATE PROTOTYPES *********************************************/
+static void APP_DeviceCDCBasicCommandTasks(void);
 
 /*********************************************************************
 * Function: void APP_DeviceCDCBasicDemoInitialize(void);
@@ -81,79 +88,28 @@ void APP_DeviceCDCBasicDemoInitialize()
 ********************************************************************/
 void APP_DeviceCDCBasicDemoTasks()
 {
+    BUTTON button;
+    BUTTON launchButton;
+
     /* message format
      * byte[0] : message type (0x01: normal key)
      * byte[1] : payload
      */
 #if 1
-    if(BUTTON_IsPressed(BUTTON_S1) == true)
-    {
-        if(buttonPressed == false)
-        {
-            if(mUSBUSARTIsTxTrfReady() == true)
-            {
-                writeBuffer[0] = CDC_TYPE_LAUNCH;
-                writeBuffer[1] = CDC_VAL_KEY1;
-                putUSBUSART(writeBuffer,2);
-                buttonPressed = true;
-            }
-        }
-    }
-    else if(BUTTON_IsPressed(BUTTON_S2) == true)
-    {
-        /* Make sure that we only send the message once per button press and
-         * not continuously as the button is held.
-         */
-        if(buttonPressed == false)
-        {
-            /* Make sure that the CDC driver is ready for a transmission.
-             */
-            if(mUSBUSARTIsTxTrfReady() == true)
-            {
-                writeBuffer[0] = CDC_TYPE_LAUNCH;
-                writeBuffer[1] = CDC_VAL_KEY2;
-                putUSBUSART(writeBuffer,2);
-                buttonPressed = true;
-            }
-        }
-    }
-    else if(BUTTON_IsPressed(BUTTON_S3) == true)
+    /* Find the first pressed button that the key map sends as a CDC launch
+     * code. */
+    launchButton = BUTTON_NONE;
+    for(button = BUTTON_S1; button <= BUTTON_S6; button++)
     {
-        /* Make sure that we only send the message once per button press and
-         * not continuously as the button is held.
-         */
-        if(buttonPressed == false)
+        if((APP_KeyMapGet(button)->action == KEYMAP_ACTION_CDC_LAUNCH) &&
+           (BUTTON_IsPressed(button) == true))
         {
-            /* Make sure that the CDC driver is ready for a transmission.
-             */
-            if(mUSBUSARTIsTxTrfReady() == true)
-            {
-                writeBuffer[0] = CDC_TYPE_LAUNCH;
-                writeBuffer[1] = CDC_VAL_KEY3;
-                putUSBUSART(writeBuffer,2);
-                buttonPressed = true;
-            }
+            launchButton = button;
+            break;
         }
     }
-    else if(BUTTON_IsPressed(BUTTON_S4) == true)
-    {
-        /* Make sure that we only send the message once per button press and
-         * not continuously as the button is held.
-         */
-        if(buttonPressed == false)
-        {
-            /* Make sure that the CDC driver is ready for a transmission.
-             */
-            if(mUSBUSARTIsTxTrfReady() == true)
-            {
-                writeBuffer[0] = CDC_TYPE_LAUNCH;
-                writeBuffer[1] = CDC_VAL_KEY4;
-                putUSBUSART(writeBuffer,2);
-                buttonPressed = true;
-            }
-        }
-    }
-    else if(BUTTON_IsPressed(BUTTON_S5) == true)
+
+    if(launchButton != BUTTON_NONE)
     {
         /* Make sure that we only send the message once per button press and
          * not continuously as the button is held.
@@ -164,9 +120,9 @@ void APP_DeviceCDCBasicDemoTasks()
              */
             if(mUSBUSARTIsTxTrfReady() == true)
             {
-                writeBuffer[0] = CDC_TYPE_LAUNCH;
-                writeBuffer[1] = CDC_VAL_KEY5;
-                putUSBUSART(writeBuffer,2);
+                USBUSARTTxBuffer()[0] = CDC_TYPE_LAUNCH;
+                USBUSARTTxBuffer()[1] = APP_KeyMapGet(launchButton)->value;
+                USBUSARTTxBufferSend(2);
                 buttonPressed = true;
             }
         }
@@ -178,6 +134,8 @@ void APP_DeviceCDCBasicDemoTasks()
          */
         buttonPressed = false;
     }
+
+    APP_DeviceCDCBasicCommandTasks();
 #endif
 #if 0    
     /* Check to see if there is a transmission in progress, if there isn't, then
@@ -188,19 +146,19 @@ void APP_DeviceCDCBasicDemoTasks()
         uint8_t i;
         uint8_t numBytesRead;
 
-        numBytesRead = getsUSBUSART(readBuffer, sizeof(readBuffer));
+        numBytesRead = USBUSARTRxBufferGetLength();
 
         /* For every byte that was read... */
         for(i=0; i<numBytesRead; i++)
         {
-            switch(readBuffer[i])
+            switch(USBUSARTRxBuffer()[i])
             {
                 /* If we receive new line or line feed commands, just echo
                  * them direct.
                  */
                 case 0x0A:
                 case 0x0D:
-                    writeBuffer[i] = readBuffer[i];
+                    USBUSARTTxBuffer()[i] = USBUSARTRxBuffer()[i];
                     break;
 
                 /* If we receive something else, then echo it plus one
@@ -209,19 +167,129 @@ void APP_DeviceCDCBasicDemoTasks()
                  * terminal program.
                  */
                 default:
-                    writeBuffer[i] = readBuffer[i] + 1;
+                    USBUSARTTxBuffer()[i] = USBUSARTRxBuffer()[i] + 1;
                     break;
             }
         }
 
         if(numBytesRead > 0)
         {
-            /* After processing all of the received data, we need to send out
-             * the "echo" data now.
+            /* After processing all of the received data, hand the OUT
+             * buffer back and send out the "echo" data now.
              */
-            putUSBUSART(writeBuffer,numBytesRead);
+            USBUSARTRxBufferRelease();
+            USBUSARTTxBufferSend(numBytesRead);
         }
     }
 #endif
     CDCTxService();
-}
\ No newline at end of file
+}
+
+/*********************************************************************
+* Function: static void APP_DeviceCDCBasicCommandTasks(void);
+*
+* Overview: Handles key map, analog input and bootloader entry commands
+*           from the host.
+*
+*   [CDC_TYPE_KEYMAP_SET][button][action][value]
+*       -> [CDC_TYPE_KEYMAP_SET][CDC_STATUS_OK or CDC_STATUS_ERROR]
+*   [CDC_TYPE_KEYMAP_GET][button]
+*       -> [CDC_TYPE_KEYMAP_GET][button][action][value]
+*   [CDC_TYPE_ANALOG_MODE][ANALOG_MODE]
+*       -> [CDC_TYPE_ANALOG_MODE][CDC_STATUS_OK or CDC_STATUS_ERROR]
+*   [CDC_TYPE_ANALOG_STATS]
+*       -> [CDC_TYPE_ANALOG_STATS][samplesSent (4)][samplesDropped (2)]
+*          both little endian
+*   [CDC_TYPE_BOOTLOADER][BOOTLOADER_KEY]
+*       -> no reply, the device resets into the USB HID bootloader
+*
+*   button is the BUTTON value (BUTTON_S1 = 1), action a KEYMAP_ACTION.
+*   Other packets are dropped.
+*
+* PreCondition: APP_DeviceCDCBasicDemoInitialize() has been called.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void APP_DeviceCDCBasicCommandTasks(void)
+{
+    uint8_t numBytesRead;
+    const KEYMAP_ENTRY *entry;
+    ANALOG_STATISTICS statistics;
+
+    /* The reply is built in the IN buffer, so leave the command in the OUT
+     * buffer until the IN endpoint is free again. */
+    if(USBUSARTIsTxTrfReady() == false)
+    {
+        return;
+    }
+
+    numBytesRead = USBUSARTRxBufferGetLength();
+    if(numBytesRead == 0)
+    {
+        return;
+    }
+
+    switch(USBUSARTRxBuffer()[0])
+    {
+        case CDC_TYPE_KEYMAP_SET:
+            USBUSARTTxBuffer()[0] = CDC_TYPE_KEYMAP_SET;
+            USBUSARTTxBuffer()[1] = CDC_STATUS_ERROR;
+            if(numBytesRead >= 4)
+            {
+                if(APP_KeyMapSet((BUTTON)USBUSARTRxBuffer()[1], USBUSARTRxBuffer()[2], USBUSARTRxBuffer()[3]) == true)
+                {
+                    USBUSARTTxBuffer()[1] = CDC_STATUS_OK;
+                }
+            }
+            USBUSARTTxBufferSend(2);
+            break;
+
+        case CDC_TYPE_KEYMAP_GET:
+            if(numBytesRead >= 2)
+            {
+                entry = APP_KeyMapGet((BUTTON)USBUSARTRxBuffer()[1]);
+                USBUSARTTxBuffer()[0] = CDC_TYPE_KEYMAP_GET;
+                USBUSARTTxBuffer()[1] = USBUSARTRxBuffer()[1];
+                USBUSARTTxBuffer()[2] = entry->action;
+                USBUSARTTxBuffer()[3] = entry->value;
+                USBUSARTTxBufferSend(4);
+            }
+            break;
+
+        case CDC_TYPE_ANALOG_MODE:
+            USBUSARTTxBuffer()[0] = CDC_TYPE_ANALOG_MODE;
+            USBUSARTTxBuffer()[1] = CDC_STATUS_ERROR;
+            if(numBytesRead >= 2)
+            {
+                if(APP_AnalogSetMode(USBUSARTRxBuffer()[1]) == true)
+                {
+                    USBUSARTTxBuffer()[1] = CDC_STATUS_OK;
+                }
+            }
+            USBUSARTTxBufferSend(2);
+            break;
+
+        case CDC_TYPE_ANALOG_STATS:
+            APP_AnalogGetStatistics(&statistics);
+            USBUSARTTxBuffer()[0] = CDC_TYPE_ANALOG_STATS;
+            memcpy(&USBUSARTTxBuffer()[1], &statistics.samplesSent, sizeof(statistics.samplesSent));
+            memcpy(&USBUSARTTxBuffer()[5], &statistics.samplesDropped, sizeof(statistics.samplesDropped));
+            USBUSARTTxBufferSend(7);
+            break;
+
+        case CDC_TYPE_BOOTLOADER:
+            if((numBytesRead >= 2) && (USBUSARTRxBuffer()[1] == BOOTLOADER_KEY))
+            {
+                BOOTLOADER_Request();
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    USBUSARTRxBufferRelease();
+}
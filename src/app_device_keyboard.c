@@ -51,6 +51,8 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include <usb/usb_device_hid.h>
 
 #include "app_led_usb_status.h"
+#include "app_keymap.h"
+#include "app_analog.h"
 
 // *****************************************************************************
 // *****************************************************************************
@@ -64,12 +66,19 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 // *****************************************************************************
 // *****************************************************************************
 
-/* This typedef defines the only INPUT report found in the HID report
+/* This typedef defines the keyboard INPUT report found in the HID report
  * descriptor and gives an easy way to create the OUTPUT report. */
 typedef struct __attribute__((packed))
 {
-    /* The union below represents the first byte of the INPUT report.  It is
-     * formed by the following HID report items:
+    /* The HID interface also carries the joystick collection (see
+     * app_analog.c), so every report starts with its report ID:
+     *
+     *  0x85, HID_REPORT_ID_KEYBOARD,  //   REPORT_ID (1)
+     */
+    uint8_t reportId;
+
+    /* The union below represents the first data byte of the INPUT report.  It
+     * is formed by the following HID report items:
      *
      *  0x19, 0xe0, //   USAGE_MINIMUM (Keyboard LeftControl)
      *  0x29, 0xe7, //   USAGE_MAXIMUM (Keyboard Right GUI)
@@ -157,45 +166,51 @@ typedef struct __attribute__((packed))
 
 /* This typedef defines the only OUTPUT report found in the HID report
  * descriptor and gives an easy way to parse the OUTPUT report. */
-typedef union __attribute__((packed))
+typedef struct __attribute__((packed))
 {
-    /* The OUTPUT report is comprised of only one byte of data. */
-    uint8_t value;
-    struct
+    /* HID_REPORT_ID_KEYBOARD, sent by the host in front of the LED byte. */
+    uint8_t reportId;
+
+    /* The OUTPUT report data is comprised of only one byte. */
+    union __attribute__((packed))
     {
-        /* There are two report items that form the one byte of OUTPUT report
-         * data.  The first report item defines 5 LED indicators:
-         *
-         *  0x95, 0x05,                    //   REPORT_COUNT (5)
-         *  0x75, 0x01,                    //   REPORT_SIZE (1)
-         *  0x05, 0x08,                    //   USAGE_PAGE (LEDs)
-         *  0x19, 0x01,                    //   USAGE_MINIMUM (Num Lock)
-         *  0x29, 0x05,                    //   USAGE_MAXIMUM (Kana)
-         *  0x91, 0x02,                    //   OUTPUT (Data,Var,Abs)
-         *
-         * The report count indicates there are 5 entries.
-         * The report size is 1 indicating each entry is just one bit.
-         * These items are located on the LED usage page
-         * These items are all of the usages between Num Lock (the usage
-         * minimum) and Kana (the usage maximum).
-         */
-        unsigned numLock        :1;
-        unsigned capsLock       :1;
-        unsigned scrollLock     :1;
-        unsigned compose        :1;
-        unsigned kana           :1;
-
-        /* The second OUTPUT report item defines 3 bits of constant data
-         * (padding) used to make a complete byte:
-         *
-         *  0x95, 0x01,                    //   REPORT_COUNT (1)
-         *  0x75, 0x03,                    //   REPORT_SIZE (3)
-         *  0x91, 0x03,                    //   OUTPUT (Cnst,Var,Abs)
-         *
-         * Report count of 1 indicates that there is one entry
-         * Report size of 3 indicates the entry is 3 bits long. */
-        unsigned                :3;
-    } leds;
+        uint8_t value;
+        struct
+        {
+            /* There are two report items that form the one byte of OUTPUT report
+             * data.  The first report item defines 5 LED indicators:
+             *
+             *  0x95, 0x05,                    //   REPORT_COUNT (5)
+             *  0x75, 0x01,                    //   REPORT_SIZE (1)
+             *  0x05, 0x08,                    //   USAGE_PAGE (LEDs)
+             *  0x19, 0x01,                    //   USAGE_MINIMUM (Num Lock)
+             *  0x29, 0x05,                    //   USAGE_MAXIMUM (Kana)
+             *  0x91, 0x02,                    //   OUTPUT (Data,Var,Abs)
+             *
+             * The report count indicates there are 5 entries.
+             * The report size is 1 indicating each entry is just one bit.
+             * These items are located on the LED usage page
+             * These items are all of the usages between Num Lock (the usage
+             * minimum) and Kana (the usage maximum).
+             */
+            unsigned numLock        :1;
+            unsigned capsLock       :1;
+            unsigned scrollLock     :1;
+            unsigned compose        :1;
+            unsigned kana           :1;
+
+            /* The second OUTPUT report item defines 3 bits of constant data
+             * (padding) used to make a complete byte:
+             *
+             *  0x95, 0x01,                    //   REPORT_COUNT (1)
+             *  0x75, 0x03,                    //   REPORT_SIZE (3)
+             *  0x91, 0x03,                    //   OUTPUT (Cnst,Var,Abs)
+             *
+             * Report count of 1 indicates that there is one entry
+             * Report size of 3 indicates the entry is 3 bits long. */
+            unsigned                :3;
+        } leds;
+    } data;
 } KEYBOARD_OUTPUT_REPORT;
 
 
@@ -285,6 +300,9 @@ void APP_KeyboardTasks(void)
     signed int TimeDeltaMilliseconds;
     unsigned char i;
     bool needToSendNewReportPacket;
+    const uint8_t *joystickReport;
+    BUTTON button;
+    BUTTON keyButton;
 
     //Copy the (possibly) interrupt context SOFCounter value into a local variable.
     //Using a while() loop to do this since the SOFCounter isn't necessarily atomically
@@ -319,6 +337,7 @@ void APP_KeyboardTasks(void)
     {
         /* Clear the INPUT report buffer.  Set to all zeros. */
         memset(&inputReport, 0, sizeof(inputReport));
+        inputReport.reportId = HID_REPORT_ID_KEYBOARD;
 #if 0
         if( BUTTON_IsPressed(BUTTON_S1) == true )
         {
@@ -387,12 +406,25 @@ void APP_KeyboardTasks(void)
         }
 #endif
 #if 1
-        if(BUTTON_IsPressed(BUTTON_S6) == true )
+        /* Find the first pressed button that the key map sends as a
+         * keyboard key (by default BUTTON_S6 -> KEY_VAL_ESC). */
+        keyButton = BUTTON_NONE;
+        for(button = BUTTON_S1; button <= BUTTON_S6; button++)
+        {
+            if((APP_KeyMapGet(button)->action == KEYMAP_ACTION_KEYBOARD) &&
+               (BUTTON_IsPressed(button) == true))
+            {
+                keyButton = button;
+                break;
+            }
+        }
+
+        if(keyButton != BUTTON_NONE)
         {
             if(keyboard.waitingForRelease == false)
             {
                 keyboard.waitingForRelease = true;
-                keyboard.key = KEY_VAL_ESC;
+                keyboard.key = APP_KeyMapGet(keyButton)->value;
                 inputReport.keys[0] = keyboard.key;
             }
         }
@@ -435,16 +467,27 @@ void APP_KeyboardTasks(void)
             //infinite idle rate setting.
             oldInputReport = inputReport;
 
-            /* Send the 8 byte packet over USB to the host. */
+            /* Send the report ID and the 8 byte report over USB to the host. */
             keyboard.lastINTransmission = HIDTxPacket(HID_EP, (uint8_t*)&inputReport, sizeof(inputReport));
             OldSOFCount = LocalSOFCount;    //Save the current time, so we know when to send the next packet (which depends in part on the idle rate setting)
         }
+        else
+        {
+            /* The joystick report shares the IN endpoint.  It only gets the
+             * endpoint when there is no keyboard report to send, so key
+             * presses are never delayed behind analog updates. */
+            joystickReport = APP_AnalogJoystickReport();
+            if(joystickReport != NULL)
+            {
+                keyboard.lastINTransmission = HIDTxPacket(HID_EP, (uint8_t*)joystickReport, HID_JOYSTICK_REPORT_SIZE);
+            }
+        }
 
     }//if(HIDTxHandleBusy(keyboard.lastINTransmission) == false)
 
 
     /* Check if any data was sent from the PC to the keyboard device.  Report
-     * descriptor allows host to send 1 byte of data.  Bits 0-4 are LED states,
+     * descriptor allows host to send 1 byte of data after the report ID.  Bits 0-4 are LED states,
      * bits 5-7 are unused pad bits.  The host can potentially send this OUT
      * report data through the HID OUT endpoint (EP1 OUT), or, alternatively,
      * the host may try to send LED state information by sending a SET_REPORT
@@ -461,7 +504,12 @@ void APP_KeyboardTasks(void)
 
 static void APP_KeyboardProcessOutputReport(void)
 {
-    if(outputReport.leds.capsLock)
+    if(outputReport.reportId != HID_REPORT_ID_KEYBOARD)
+    {
+        return;
+    }
+
+    if(outputReport.data.leds.capsLock)
     {
         //LED_On(LED_USB_DEVICE_HID_KEYBOARD_CAPS_LOCK);
     }
@@ -473,9 +521,10 @@ static void APP_KeyboardProcessOutputReport(void)
 
 static void USBHIDCBSetReportComplete(void)
 {
-    /* 1 byte of LED state data should now be in the CtrlTrfData buffer.  Copy
-     * it to the OUTPUT report buffer for processing */
-    outputReport.value = CtrlTrfData[0];
+    /* The report ID and 1 byte of LED state data should now be in the
+     * CtrlTrfData buffer.  Copy them to the OUTPUT report buffer for processing */
+    outputReport.reportId = CtrlTrfData[0];
+    outputReport.data.value = CtrlTrfData[1];
 
     /* Process the OUTPUT report. */
     APP_KeyboardProcessOutputReport();
@@ -484,8 +533,8 @@ static void USBHIDCBSetReportComplete(void)
 void USBHIDCBSetReportHandler(void)
 {
     /* Prepare to receive the keyboard LED state data through a SET_REPORT
-     * control transfer on endpoint 0.  The host should only send 1 byte,
-     * since this is all that the report descriptor allows it to send. */
+     * control transfer on endpoint 0.  The host should only send the report
+     * ID and 1 byte, since this is all that the report descriptor allows. */
     USBEP0Receive((uint8_t*)&CtrlTrfData, USB_EP0_BUFF_SIZE, USBHIDCBSetReportComplete);
 }
 
@@ -495,9 +544,8 @@ void USBHIDCBSetReportHandler(void)
 void USBHIDCBSetIdleRateHandler(uint8_t reportID, uint8_t newIdleRate)
 {
     //Make sure the report ID matches the keyboard input report id number.
-    //If however the firmware doesn't implement/use report ID numbers,
-    //then it should be == 0.
-    if(reportID == 0)
+    //A report ID of 0 applies the idle rate to all input reports.
+    if((reportID == 0) || (reportID == HID_REPORT_ID_KEYBOARD))
     {
         keyboardIdleRate = newIdleRate;
     }
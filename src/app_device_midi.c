@@ -0,0 +1,224 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <system.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <usb/usb.h>
+#include <usb/usb_device_midi.h>
+
+#include <app_device_midi.h>
+#include <app_keymap.h>
+#include <usb_config.h>
+
+/** DEFINITIONS ****************************************************/
+#define MIDI_STATUS_NOTE_OFF        0x80
+#define MIDI_STATUS_NOTE_ON         0x90
+#define MIDI_STATUS_CONTROL_CHANGE  0xB0
+#define MIDI_DATA_MAX               0x7F
+
+#if (KEYMAP_NUM_BUTTONS > MIDI_EVENTS_PER_PACKET)
+    #error "All button edges of one scan must fit a single MIDI IN packet."
+#endif
+
+/** VARIABLES ******************************************************/
+static uint8_t midiInBuffer[MIDI_IN_EP_SIZE] MIDI_IN_DATA_BUFFER_ADDRESS_TAG;
+static uint8_t midiOutBuffer[MIDI_OUT_EP_SIZE] MIDI_OUT_DATA_BUFFER_ADDRESS_TAG;
+
+static USB_HANDLE midiInHandle;
+static USB_HANDLE midiOutHandle;
+
+/* One bit per button (BUTTON_S1 = bit 0): the state of the MIDI mapped
+ * buttons as last reported to the host. */
+static uint8_t reportedButtons;
+
+/* The mapping each button had when its press was sent.  The release uses
+ * it, so a button remapped while held still turns off the note or
+ * controller it turned on. */
+static KEYMAP_ENTRY pressedEntry[KEYMAP_NUM_BUTTONS];
+
+/** PRIVATE PROTOTYPES *********************************************/
+static uint8_t APP_DeviceMIDIScanButtons(void);
+
+/*********************************************************************
+* Function: void APP_DeviceMIDIInitialize(void);
+*
+* Overview: Enables the MIDIStreaming endpoints and takes the current
+*           button state as the reference for the next edges.
+*
+* PreCondition: The device is configured (EVENT_CONFIGURED).
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceMIDIInitialize(void)
+{
+    uint8_t i;
+
+    midiInHandle = NULL;
+
+    USBEnableEndpoint(MIDI_EP, USB_IN_ENABLED|USB_OUT_ENABLED|USB_HANDSHAKE_ENABLED|USB_DISALLOW_SETUP);
+    midiOutHandle = USBRxOnePacket(MIDI_EP, midiOutBuffer, MIDI_OUT_EP_SIZE);
+
+    /* Buttons already held at configuration time do not send a Note On,
+     * so their release does not send a Note Off either. */
+    reportedButtons = APP_DeviceMIDIScanButtons();
+    for(i = 0; i < KEYMAP_NUM_BUTTONS; i++)
+    {
+        pressedEntry[i].action = KEYMAP_ACTION_NONE;
+    }
+}
+
+/*********************************************************************
+* Function: void APP_DeviceMIDITasks(void);
+*
+* Overview: Turns button edges into Note On/Off or Control Change events
+*           and sends every event that is pending in one bulk packet as
+*           soon as the IN endpoint is free.  Data from the host is
+*           accepted and discarded.
+*
+* PreCondition: APP_DeviceMIDIInitialize() has been called.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceMIDITasks(void)
+{
+    BUTTON button;
+    KEYMAP_ENTRY *entry;
+    uint8_t *event;
+    uint8_t pressed;
+    uint8_t changed;
+    uint8_t mask;
+    bool on;
+
+    /* There are no MIDI OUT jacks to drive, so hand the buffer straight
+     * back to the endpoint. */
+    if(USBHandleBusy(midiOutHandle) == false)
+    {
+        midiOutHandle = USBRxOnePacket(MIDI_EP, midiOutBuffer, MIDI_OUT_EP_SIZE);
+    }
+
+    /* The events are built in the endpoint buffer itself, so wait until the
+     * previous packet is gone.  Edges seen in the meantime are not lost: they
+     * are still a difference from reportedButtons and all go out together in
+     * the next packet. */
+    if(USBHandleBusy(midiInHandle) == true)
+    {
+        return;
+    }
+
+    pressed = APP_DeviceMIDIScanButtons();
+    changed = pressed ^ reportedButtons;
+    if(changed == 0)
+    {
+        return;
+    }
+    reportedButtons = pressed;
+
+    event = midiInBuffer;
+    for(button = BUTTON_S1, mask = 0x01; button <= BUTTON_S6; button++, mask <<= 1)
+    {
+        if((changed & mask) == 0)
+        {
+            continue;
+        }
+
+        on = ((pressed & mask) != 0);
+        entry = &pressedEntry[button - BUTTON_S1];
+        if(on == true)
+        {
+            *entry = *APP_KeyMapGet(button);
+        }
+
+        if(entry->action == KEYMAP_ACTION_MIDI_NOTE)
+        {
+            event[0] = (MIDI_CABLE << 4) | (on ? MIDI_CIN_NOTE_ON : MIDI_CIN_NOTE_OFF);
+            event[1] = (on ? MIDI_STATUS_NOTE_ON : MIDI_STATUS_NOTE_OFF) | MIDI_CHANNEL;
+            event[2] = entry->value & MIDI_DATA_MAX;
+            event[3] = on ? MIDI_NOTE_VELOCITY : 0;
+        }
+        else if(entry->action == KEYMAP_ACTION_MIDI_CC)
+        {
+            event[0] = (MIDI_CABLE << 4) | MIDI_CIN_CONTROL_CHANGE;
+            event[1] = MIDI_STATUS_CONTROL_CHANGE | MIDI_CHANNEL;
+            event[2] = entry->value & MIDI_DATA_MAX;
+            event[3] = on ? MIDI_DATA_MAX : 0;
+        }
+        else
+        {
+            /* Held since before the device was configured. */
+            continue;
+        }
+        event += MIDI_EVENT_SIZE;
+
+        if(on == false)
+        {
+            entry->action = KEYMAP_ACTION_NONE;
+        }
+    }
+
+    if(event != midiInBuffer)
+    {
+        midiInHandle = USBTxOnePacket(MIDI_EP, midiInBuffer, (uint16_t)(event - midiInBuffer));
+    }
+}
+
+/*********************************************************************
+* Function: static uint8_t APP_DeviceMIDIScanButtons(void);
+*
+* Overview: Reads the buttons that the key map sends as MIDI events.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: uint8_t - one bit per pressed button, BUTTON_S1 = bit 0
+*
+********************************************************************/
+static uint8_t APP_DeviceMIDIScanButtons(void)
+{
+    BUTTON button;
+    uint8_t action;
+    uint8_t mask;
+    uint8_t pressed;
+
+    pressed = 0;
+    for(button = BUTTON_S1, mask = 0x01; button <= BUTTON_S6; button++, mask <<= 1)
+    {
+        action = APP_KeyMapGet(button)->action;
+        if(((action == KEYMAP_ACTION_MIDI_NOTE) || (action == KEYMAP_ACTION_MIDI_CC)) &&
+           (BUTTON_IsPressed(button) == true))
+        {
+            pressed |= mask;
+        }
+    }
+
+    return pressed;
+}
@@ -0,0 +1,68 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+#ifndef APP_DEVICE_MIDI_H
+#define APP_DEVICE_MIDI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** MIDI Definitions ***********************************************/
+// Buttons mapped to KEYMAP_ACTION_MIDI_NOTE or KEYMAP_ACTION_MIDI_CC
+// (see app_keymap.h) send USB-MIDI event packets on MIDI_EP.  The
+// channel, cable and velocity are set in io_mapping.h.
+#define MIDI_EVENT_SIZE             4
+#define MIDI_EVENTS_PER_PACKET      (MIDI_IN_EP_SIZE / MIDI_EVENT_SIZE)
+
+/*********************************************************************
+* Function: void APP_DeviceMIDIInitialize(void);
+*
+* Overview: Enables the MIDIStreaming endpoints and takes the current
+*           button state as the reference for the next edges.
+*
+* PreCondition: The device is configured (EVENT_CONFIGURED).
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceMIDIInitialize(void);
+
+/*********************************************************************
+* Function: void APP_DeviceMIDITasks(void);
+*
+* Overview: Turns button edges into Note On/Off or Control Change events
+*           and sends every event that is pending in one bulk packet as
+*           soon as the IN endpoint is free.  Data from the host is
+*           accepted and discarded.
+*
+* PreCondition: APP_DeviceMIDIInitialize() has been called.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_DeviceMIDITasks(void);
+
+#endif //APP_DEVICE_MIDI_H
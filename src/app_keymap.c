@@ -0,0 +1,299 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <system.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <flash.h>
+#include <app_keymap.h>
+
+/** DEFINITIONS ****************************************************/
+
+/* Flash layout
+ *
+ * The HEF area is split into two banks of two rows each.  Only one bank is
+ * active at a time.  Slot 0 of a bank is its header and slots 1..15 hold key
+ * records appended in order, so a later record for a button overrides an
+ * earlier one.  When the active bank is full, the RAM table is written to the
+ * other bank, whose header (with the next generation number) is written last.
+ * Both banks wear evenly, and a reset during compaction leaves the old bank
+ * in use.
+ *
+ *   header: [KEYMAP_HEADER_TAG][generation][0x00][check]
+ *   record: [KEYMAP_RECORD_TAG | button index][action][value][check]
+ *
+ * check = ~(byte0 + byte1 + byte2), which never matches an erased slot.
+ */
+#define KEYMAP_SLOT_SIZE            4
+#define KEYMAP_BANK_SIZE            (FLASH_HEF_SIZE / 2)
+#define KEYMAP_SLOTS_PER_BANK       (KEYMAP_BANK_SIZE / KEYMAP_SLOT_SIZE)
+#define KEYMAP_BANK_ADDRESS(bank)   (FLASH_HEF_START_ADDRESS + ((uint16_t)(bank) * KEYMAP_BANK_SIZE))
+
+#define KEYMAP_HEADER_TAG           0x4B
+#define KEYMAP_RECORD_TAG           0x50
+#define KEYMAP_RECORD_TAG_MASK      0xF0
+#define KEYMAP_RECORD_INDEX_MASK    0x0F
+
+#define KEYMAP_NO_BANK              0xFF
+
+/** VARIABLES ******************************************************/
+
+/* Compile-time mapping, used for buttons that have no record in flash. */
+static const KEYMAP_ENTRY defaultKeyMap[KEYMAP_NUM_BUTTONS] =
+{
+    {KEYMAP_ACTION_CDC_LAUNCH, CDC_VAL_KEY1},   // BUTTON_S1
+    {KEYMAP_ACTION_CDC_LAUNCH, CDC_VAL_KEY2},   // BUTTON_S2
+    {KEYMAP_ACTION_CDC_LAUNCH, CDC_VAL_KEY3},   // BUTTON_S3
+    {KEYMAP_ACTION_CDC_LAUNCH, CDC_VAL_KEY4},   // BUTTON_S4
+    {KEYMAP_ACTION_CDC_LAUNCH, CDC_VAL_KEY5},   // BUTTON_S5
+    {KEYMAP_ACTION_KEYBOARD,   KEY_VAL_ESC},    // BUTTON_S6
+};
+
+static const KEYMAP_ENTRY unmappedKey = {KEYMAP_ACTION_NONE, 0};
+
+static KEYMAP_ENTRY keyMap[KEYMAP_NUM_BUTTONS];
+static uint8_t activeBank;
+static uint8_t activeGeneration;
+static uint8_t nextSlot;
+
+/** PRIVATE PROTOTYPES *********************************************/
+static uint8_t APP_KeyMapCheck(const uint8_t *slot);
+static void APP_KeyMapReadSlot(uint16_t address, uint8_t *slot);
+static void APP_KeyMapWriteSlot(uint16_t address, uint8_t tag, uint8_t data1, uint8_t data2);
+static void APP_KeyMapCompact(void);
+
+/*********************************************************************
+* Function: void APP_KeyMapInitialize(void);
+*
+* Overview: Loads the button key map from high-endurance flash into the
+*           RAM lookup table.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_KeyMapInitialize(void)
+{
+    uint8_t slot[KEYMAP_SLOT_SIZE];
+    uint8_t bank;
+    uint8_t index;
+    uint16_t address;
+
+    memcpy(keyMap, defaultKeyMap, sizeof(keyMap));
+    activeBank = KEYMAP_NO_BANK;
+    activeGeneration = 0;
+    nextSlot = KEYMAP_SLOTS_PER_BANK;
+
+    /* Pick the bank with the newest valid header.  The generation wraps,
+     * so compare it as a signed difference. */
+    for(bank = 0; bank < 2; bank++)
+    {
+        APP_KeyMapReadSlot(KEYMAP_BANK_ADDRESS(bank), slot);
+        if((slot[0] != KEYMAP_HEADER_TAG) || (slot[3] != APP_KeyMapCheck(slot)))
+        {
+            continue;
+        }
+
+        if((activeBank == KEYMAP_NO_BANK) || ((int8_t)(slot[1] - activeGeneration) > 0))
+        {
+            activeBank = bank;
+            activeGeneration = slot[1];
+        }
+    }
+
+    if(activeBank == KEYMAP_NO_BANK)
+    {
+        return;
+    }
+
+    /* Replay the records up to the first erased slot. */
+    address = KEYMAP_BANK_ADDRESS(activeBank) + KEYMAP_SLOT_SIZE;
+    for(nextSlot = 1; nextSlot < KEYMAP_SLOTS_PER_BANK; nextSlot++)
+    {
+        APP_KeyMapReadSlot(address, slot);
+        if(slot[0] == FLASH_ERASED_BYTE)
+        {
+            break;
+        }
+
+        /* A slot that was only partly programmed (reset during the write)
+         * fails the check and is skipped. */
+        index = slot[0] & KEYMAP_RECORD_INDEX_MASK;
+        if(((slot[0] & KEYMAP_RECORD_TAG_MASK) == KEYMAP_RECORD_TAG) &&
+           (index < KEYMAP_NUM_BUTTONS) &&
+           (slot[1] < KEYMAP_ACTION_MAX) &&
+           (slot[3] == APP_KeyMapCheck(slot)))
+        {
+            keyMap[index].action = slot[1];
+            keyMap[index].value = slot[2];
+        }
+
+        address += KEYMAP_SLOT_SIZE;
+    }
+}
+
+/*********************************************************************
+* Function: const KEYMAP_ENTRY* APP_KeyMapGet(BUTTON button);
+*
+* Overview: Returns the current mapping of a button from the RAM table.
+*
+* PreCondition: APP_KeyMapInitialize() has been called.
+*
+* Input: BUTTON button - BUTTON_S1 .. BUTTON_S6
+*
+* Output: const KEYMAP_ENTRY* - the mapping
+*
+********************************************************************/
+const KEYMAP_ENTRY* APP_KeyMapGet(BUTTON button)
+{
+    uint8_t index;
+
+    index = (uint8_t)(button - BUTTON_S1);
+    if(index >= KEYMAP_NUM_BUTTONS)
+    {
+        return &unmappedKey;
+    }
+
+    return &keyMap[index];
+}
+
+/*********************************************************************
+* Function: bool APP_KeyMapSet(BUTTON button, uint8_t action, uint8_t value);
+*
+* Overview: Changes the mapping of a button and appends it to the flash
+*           store.
+*
+* PreCondition: APP_KeyMapInitialize() has been called.
+*
+* Input: BUTTON button - BUTTON_S1 .. BUTTON_S6
+*        uint8_t action - KEYMAP_ACTION
+*        uint8_t value - CDC code, HID keyboard usage, MIDI note or
+*                        MIDI controller number
+*
+* Output: bool - true if the mapping was stored
+*
+********************************************************************/
+bool APP_KeyMapSet(BUTTON button, uint8_t action, uint8_t value)
+{
+    uint8_t index;
+
+    index = (uint8_t)(button - BUTTON_S1);
+    if((index >= KEYMAP_NUM_BUTTONS) || (action >= KEYMAP_ACTION_MAX))
+    {
+        return false;
+    }
+
+    /* Don't spend a flash write on a mapping that doesn't change. */
+    if((keyMap[index].action == action) && (keyMap[index].value == value))
+    {
+        return true;
+    }
+
+    keyMap[index].action = action;
+    keyMap[index].value = value;
+
+    if((activeBank == KEYMAP_NO_BANK) || (nextSlot >= KEYMAP_SLOTS_PER_BANK))
+    {
+        APP_KeyMapCompact();
+    }
+    else
+    {
+        APP_KeyMapWriteSlot(KEYMAP_BANK_ADDRESS(activeBank) + ((uint16_t)nextSlot * KEYMAP_SLOT_SIZE),
+                            KEYMAP_RECORD_TAG | index, action, value);
+        nextSlot++;
+    }
+
+    return true;
+}
+
+/*********************************************************************
+* Function: static void APP_KeyMapCompact(void);
+*
+* Overview: Writes the whole RAM table into the inactive bank and makes
+*           it the active one.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void APP_KeyMapCompact(void)
+{
+    uint8_t bank;
+    uint8_t i;
+    uint16_t address;
+
+    bank = (activeBank == 0) ? 1 : 0;
+    address = KEYMAP_BANK_ADDRESS(bank);
+
+    FLASH_EraseRow(address);
+    FLASH_EraseRow(address + FLASH_ROW_SIZE);
+
+    for(i = 0; i < KEYMAP_NUM_BUTTONS; i++)
+    {
+        APP_KeyMapWriteSlot(address + ((uint16_t)(i + 1) * KEYMAP_SLOT_SIZE),
+                            KEYMAP_RECORD_TAG | i, keyMap[i].action, keyMap[i].value);
+    }
+
+    /* The header goes last: until it is written the old bank stays active. */
+    activeGeneration++;
+    APP_KeyMapWriteSlot(address, KEYMAP_HEADER_TAG, activeGeneration, 0x00);
+
+    activeBank = bank;
+    nextSlot = KEYMAP_NUM_BUTTONS + 1;
+}
+
+static uint8_t APP_KeyMapCheck(const uint8_t *slot)
+{
+    return (uint8_t)~(uint8_t)(slot[0] + slot[1] + slot[2]);
+}
+
+static void APP_KeyMapReadSlot(uint16_t address, uint8_t *slot)
+{
+    uint8_t i;
+
+    for(i = 0; i < KEYMAP_SLOT_SIZE; i++)
+    {
+        slot[i] = FLASH_ReadByte(address + i);
+    }
+}
+
+static void APP_KeyMapWriteSlot(uint16_t address, uint8_t tag, uint8_t data1, uint8_t data2)
+{
+    uint8_t slot[KEYMAP_SLOT_SIZE];
+
+    slot[0] = tag;
+    slot[1] = data1;
+    slot[2] = data2;
+    slot[3] = APP_KeyMapCheck(slot);
+
+    FLASH_WriteBytes(address, slot, KEYMAP_SLOT_SIZE);
+}
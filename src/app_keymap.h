@@ -0,0 +1,102 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+#ifndef APP_KEYMAP_H
+#define APP_KEYMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <buttons.h>
+
+/*** Key Map Definitions ********************************************/
+#define KEYMAP_NUM_BUTTONS      6       // BUTTON_S1 .. BUTTON_S6
+
+typedef enum
+{
+    KEYMAP_ACTION_NONE = 0,             // button is ignored
+    KEYMAP_ACTION_CDC_LAUNCH = 1,       // send [CDC_TYPE_LAUNCH][value] on the serial port
+    KEYMAP_ACTION_KEYBOARD = 2,         // press HID keyboard usage 'value'
+    KEYMAP_ACTION_MIDI_NOTE = 3,        // MIDI Note On/Off for note 'value'
+    KEYMAP_ACTION_MIDI_CC = 4,          // MIDI Control Change 'value', 127 pressed / 0 released
+    KEYMAP_ACTION_MAX
+} KEYMAP_ACTION;
+
+typedef struct
+{
+    uint8_t action;                     // KEYMAP_ACTION
+    uint8_t value;
+} KEYMAP_ENTRY;
+
+/*********************************************************************
+* Function: void APP_KeyMapInitialize(void);
+*
+* Overview: Loads the button key map from high-endurance flash into the
+*           RAM lookup table.  Buttons without a stored record get the
+*           compile-time defaults from io_mapping.h.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void APP_KeyMapInitialize(void);
+
+/*********************************************************************
+* Function: const KEYMAP_ENTRY* APP_KeyMapGet(BUTTON button);
+*
+* Overview: Returns the current mapping of a button from the RAM table.
+*
+* PreCondition: APP_KeyMapInitialize() has been called.
+*
+* Input: BUTTON button - BUTTON_S1 .. BUTTON_S6
+*
+* Output: const KEYMAP_ENTRY* - the mapping.  Buttons outside the table
+*         map to KEYMAP_ACTION_NONE.
+*
+********************************************************************/
+const KEYMAP_ENTRY* APP_KeyMapGet(BUTTON button);
+
+/*********************************************************************
+* Function: bool APP_KeyMapSet(BUTTON button, uint8_t action, uint8_t value);
+*
+* Overview: Changes the mapping of a button and appends it to the flash
+*           store, so it survives a reset.  Takes one row write (~2ms),
+*           or a few when the active flash bank is full and has to be
+*           compacted.
+*
+* PreCondition: APP_KeyMapInitialize() has been called.
+*
+* Input: BUTTON button - BUTTON_S1 .. BUTTON_S6
+*        uint8_t action - KEYMAP_ACTION
+*        uint8_t value - CDC code, HID keyboard usage, MIDI note or
+*                        MIDI controller number
+*
+* Output: bool - true if the mapping was stored.  false for an invalid
+*         button or action.
+*
+********************************************************************/
+bool APP_KeyMapSet(BUTTON button, uint8_t action, uint8_t value);
+
+#endif //APP_KEYMAP_H
@@ -0,0 +1,87 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+#ifndef BOOTLOADER_H
+#define BOOTLOADER_H
+
+/*** Program Memory Map *********************************************/
+// 0x0000 - 0x0FFF  USB HID bootloader (this directory)
+// 0x1000 - 0x1F7D  application, linked with --codeoffset=0x1000
+// 0x1F7E - 0x1F7F  application CRC, written by the bootloader once the
+//                  uploaded image has been verified
+// 0x1F80 - 0x1FFF  high-endurance flash (key map, see app_keymap.c)
+//
+// The bootloader owns the reset and interrupt vectors and forwards them
+// to BOOTLOADER_APP_RESET_VECTOR / BOOTLOADER_APP_INTERRUPT_VECTOR.
+#define BOOTLOADER_APP_RESET_VECTOR         0x1000
+#define BOOTLOADER_APP_INTERRUPT_VECTOR     0x1004
+#define BOOTLOADER_APP_START_ADDRESS        BOOTLOADER_APP_RESET_VECTOR
+#define BOOTLOADER_APP_CRC_ADDRESS          0x1F7E
+#define BOOTLOADER_APP_END_ADDRESS          0x1F80  //first row after the application area
+
+/*** Bootloader Entry ***********************************************/
+// The application enters the bootloader by writing BOOTLOADER_KEY to
+// BOOTLOADER_KEY_ADDRESS and executing a RESET instruction.  The
+// bootloader only stays resident when both the key and the RESET flag
+// (PCON.nRI) are found, so a random RAM value after power-up can not
+// hold the device in the bootloader.  The address is the last byte of
+// bank 2, which neither image uses for USB buffers (the application
+// checks this in main.c).
+#define BOOTLOADER_KEY_ADDRESS              0x16F
+#define BOOTLOADER_KEY                      0xB7
+
+#define BOOTLOADER_Request()                            \
+    do {                                                \
+        INTCONbits.GIE = 0;                             \
+        *((volatile uint8_t*)BOOTLOADER_KEY_ADDRESS) = BOOTLOADER_KEY; \
+        RESET();                                        \
+    } while(0)
+
+/*** HID Protocol ***************************************************/
+// All reports are BOOTLOADER_PACKET_SIZE bytes, without a report ID.
+//
+//   [QUERY]                      -> [QUERY][version][row size]
+//                                   [start L][start H][end L][end H]
+//   [ERASE]                      -> [ERASE][status]
+//   [PROGRAM][addr L][addr H][n] -> n raw row packets, then
+//                                   [PROGRAM][status]
+//   [VERIFY][crc L][crc H]       -> [VERIFY][status][crc L][crc H]
+//   [RESET]                      -> (device detaches and starts the app)
+//
+// A row packet holds FLASH_ROW_SIZE words as little-endian byte pairs.
+// PROGRAM does not answer each row, so the host keeps sending while the
+// previous row is being written.  The CRC is CRC-16/CCITT (0x1021, initial
+// value 0xFFFF) over the words from BOOTLOADER_APP_START_ADDRESS up to
+// BOOTLOADER_APP_CRC_ADDRESS, low byte first.
+#define BOOTLOADER_PACKET_SIZE              64
+#define BOOTLOADER_VERSION                  0x01
+
+#define BOOTLOADER_CMD_QUERY                0x01
+#define BOOTLOADER_CMD_ERASE                0x02
+#define BOOTLOADER_CMD_PROGRAM              0x03
+#define BOOTLOADER_CMD_VERIFY               0x04
+#define BOOTLOADER_CMD_RESET                0x05
+
+#define BOOTLOADER_STATUS_OK                0x00
+#define BOOTLOADER_STATUS_ERROR             0x01
+
+#endif //BOOTLOADER_H
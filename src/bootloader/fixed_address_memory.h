@@ -0,0 +1,46 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+#ifndef FIXED_MEMORY_ADDRESS_H
+#define FIXED_MEMORY_ADDRESS_H
+
+#define FIXED_ADDRESS_MEMORY
+
+/* Bootloader endpoint buffers
+ *
+ * The BDT and the EP0 buffers take 0x2000-0x202F linear (bank 0).  Each
+ * 64 byte HID report buffer gets a GPR bank of its own, so the two OUT
+ * buffers can be armed on the even and odd ping-pong BDs at the same time:
+ * the next row packet is received while the previous one is programmed.
+ *
+ *   bank 1  0x0A0  packetOutEven    BOOTLOADER_PACKET_SIZE
+ *   bank 2  0x120  packetOutOdd     BOOTLOADER_PACKET_SIZE
+ *   bank 3  0x1A0  packetIn         BOOTLOADER_PACKET_SIZE */
+#define BOOT_OUT_EVEN_BUFFER_ADDR       0x0A0
+#define BOOT_OUT_ODD_BUFFER_ADDR        0x120
+#define BOOT_IN_BUFFER_ADDR             0x1A0
+
+#define BOOT_OUT_EVEN_BUFFER_ADDRESS_TAG    @BOOT_OUT_EVEN_BUFFER_ADDR
+#define BOOT_OUT_ODD_BUFFER_ADDRESS_TAG     @BOOT_OUT_ODD_BUFFER_ADDR
+#define BOOT_IN_BUFFER_ADDRESS_TAG          @BOOT_IN_BUFFER_ADDR
+
+#endif //FIXED_MEMORY_ADDRESS
@@ -0,0 +1,436 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+/** INCLUDES *******************************************************/
+#include <system.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <usb/usb.h>
+#include <usb/usb_device_hid.h>
+
+#include <flash.h>
+
+#include "bootloader.h"
+
+/** VARIABLES ******************************************************/
+
+/* Written by the application right before it executes RESET, see
+ * BOOTLOADER_Request().  persistent: not cleared by the startup code. */
+persistent volatile uint8_t bootloaderKey @ BOOTLOADER_KEY_ADDRESS;
+
+static uint8_t packetOutEven[BOOTLOADER_PACKET_SIZE] BOOT_OUT_EVEN_BUFFER_ADDRESS_TAG;
+static uint8_t packetOutOdd[BOOTLOADER_PACKET_SIZE] BOOT_OUT_ODD_BUFFER_ADDRESS_TAG;
+static uint8_t packetIn[BOOTLOADER_PACKET_SIZE] BOOT_IN_BUFFER_ADDRESS_TAG;
+
+static USB_HANDLE rxHandleEven;
+static USB_HANDLE rxHandleOdd;
+static USB_HANDLE txHandle;
+static bool rxOdd;
+
+/* Rows still expected by the current PROGRAM command and where the next
+ * one goes. */
+static uint8_t programRows;
+static uint16_t programAddress;
+
+/** PRIVATE PROTOTYPES *********************************************/
+static bool BOOT_StayInBootloader(void);
+static uint16_t BOOT_ApplicationCRC(void);
+static void BOOT_Tasks(void);
+static void BOOT_ProcessPacket(uint8_t *packet);
+static void BOOT_ProgramRow(uint8_t *packet);
+static void BOOT_Reply(uint8_t command, uint8_t status);
+static void BOOT_Reset(void);
+
+/*********************************************************************
+* Function: void main(void);
+*
+* Overview: Starts the application unless it is missing, corrupt or has
+*           asked for an update; otherwise runs the HID bootloader.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+MAIN_RETURN main(void)
+{
+    SYSTEM_Initialize(SYSTEM_STATE_USB_START);
+
+    if(BOOT_StayInBootloader() == false)
+    {
+        asm("ljmp " ___mkstr(BOOTLOADER_APP_RESET_VECTOR));
+    }
+
+    USBDeviceInit();
+    USBDeviceAttach();
+
+    while(1)
+    {
+        /* Polled: the interrupt vector belongs to the application. */
+        USBDeviceTasks();
+
+        if((USBGetDeviceState() < CONFIGURED_STATE) || (USBIsDeviceSuspended() == true))
+        {
+            continue;
+        }
+
+        BOOT_Tasks();
+    }
+}
+
+/*********************************************************************
+* Function: static bool BOOT_StayInBootloader(void);
+*
+* Overview: Decides whether the bootloader should run.  It does when the
+*           application requested it (key + RESET instruction), when the
+*           entry button is held, or when the application image does not
+*           match the CRC stored after its last verified upload.
+*
+* PreCondition: SYSTEM_Initialize() has been called.
+*
+* Input: None
+*
+* Output: bool - true to stay in the bootloader
+*
+********************************************************************/
+static bool BOOT_StayInBootloader(void)
+{
+    bool requested;
+    uint16_t crc;
+
+    requested = ((PCONbits.nRI == 0) && (bootloaderKey == BOOTLOADER_KEY));
+    PCONbits.nRI = 1;
+    bootloaderKey = 0;
+
+    if(requested == true)
+    {
+        return true;
+    }
+
+    if(BUTTON_IsPressed(BUTTON_BOOTLOADER_ENTRY) == true)
+    {
+        return true;
+    }
+
+    if(FLASH_ReadWord(BOOTLOADER_APP_RESET_VECTOR) == 0x3FFF)
+    {
+        return true;
+    }
+
+    crc = BOOT_ApplicationCRC();
+    if((FLASH_ReadByte(BOOTLOADER_APP_CRC_ADDRESS) != (uint8_t)crc) ||
+       (FLASH_ReadByte(BOOTLOADER_APP_CRC_ADDRESS + 1) != (uint8_t)(crc >> 8)))
+    {
+        return true;
+    }
+
+    return false;
+}
+
+/*********************************************************************
+* Function: static uint16_t BOOT_ApplicationCRC(void);
+*
+* Overview: CRC-16/CCITT of the application area, each word low byte
+*           first.  Uses the shift form of the polynomial instead of a
+*           table, which is about 20 instructions per byte.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: uint16_t - the CRC
+*
+********************************************************************/
+static uint16_t BOOT_ApplicationCRC(void)
+{
+    uint16_t address;
+    uint16_t word;
+    uint16_t crc;
+    uint8_t data;
+    uint8_t x;
+    uint8_t i;
+
+    crc = 0xFFFF;
+    for(address = BOOTLOADER_APP_START_ADDRESS; address < BOOTLOADER_APP_CRC_ADDRESS; address++)
+    {
+        word = FLASH_ReadWord(address);
+        data = (uint8_t)word;
+        for(i = 0; i < 2; i++)
+        {
+            x = (uint8_t)(crc >> 8) ^ data;
+            x ^= x >> 4;
+            crc = (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+            data = (uint8_t)(word >> 8);
+        }
+    }
+
+    return crc;
+}
+
+/*********************************************************************
+* Function: static void BOOT_Tasks(void);
+*
+* Overview: Takes the received OUT packets in ping-pong order.  A buffer
+*           is re-armed right after it has been processed, while the
+*           other one is already armed, so the host never waits for a
+*           flash write before it can send the next row.
+*
+* PreCondition: The device is configured.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void BOOT_Tasks(void)
+{
+    /* Each packet may need a reply, so only take one while IN is free. */
+    if(HIDTxHandleBusy(txHandle) == true)
+    {
+        return;
+    }
+
+    if(rxOdd == false)
+    {
+        if(HIDRxHandleBusy(rxHandleEven) == false)
+        {
+            BOOT_ProcessPacket(packetOutEven);
+            rxHandleEven = HIDRxPacket(HID_EP, packetOutEven, BOOTLOADER_PACKET_SIZE);
+            rxOdd = true;
+        }
+    }
+    else
+    {
+        if(HIDRxHandleBusy(rxHandleOdd) == false)
+        {
+            BOOT_ProcessPacket(packetOutOdd);
+            rxHandleOdd = HIDRxPacket(HID_EP, packetOutOdd, BOOTLOADER_PACKET_SIZE);
+            rxOdd = false;
+        }
+    }
+}
+
+/*********************************************************************
+* Function: static void BOOT_ProcessPacket(uint8_t *packet);
+*
+* Overview: Handles one command or row packet, see bootloader.h.
+*
+* PreCondition: The IN endpoint is free.
+*
+* Input: uint8_t *packet - BOOTLOADER_PACKET_SIZE bytes from the host
+*
+* Output: None
+*
+********************************************************************/
+static void BOOT_ProcessPacket(uint8_t *packet)
+{
+    uint16_t address;
+    uint16_t crc;
+
+    if(programRows != 0)
+    {
+        BOOT_ProgramRow(packet);
+        return;
+    }
+
+    switch(packet[0])
+    {
+        case BOOTLOADER_CMD_QUERY:
+            packetIn[2] = FLASH_ROW_SIZE;
+            packetIn[3] = (uint8_t)BOOTLOADER_APP_START_ADDRESS;
+            packetIn[4] = (uint8_t)(BOOTLOADER_APP_START_ADDRESS >> 8);
+            packetIn[5] = (uint8_t)BOOTLOADER_APP_END_ADDRESS;
+            packetIn[6] = (uint8_t)(BOOTLOADER_APP_END_ADDRESS >> 8);
+            BOOT_Reply(BOOTLOADER_CMD_QUERY, BOOTLOADER_VERSION);
+            break;
+
+        case BOOTLOADER_CMD_ERASE:
+            /* Top row first: it holds the CRC, so an interrupted erase
+             * leaves an image that fails the check at boot. */
+            address = BOOTLOADER_APP_END_ADDRESS;
+            do
+            {
+                address -= FLASH_ROW_SIZE;
+                FLASH_EraseRow(address);
+            } while(address != BOOTLOADER_APP_START_ADDRESS);
+            BOOT_Reply(BOOTLOADER_CMD_ERASE, BOOTLOADER_STATUS_OK);
+            break;
+
+        case BOOTLOADER_CMD_PROGRAM:
+            address = ((uint16_t)packet[2] << 8) | packet[1];
+            if(((address & (FLASH_ROW_SIZE - 1)) != 0) ||
+               (address < BOOTLOADER_APP_START_ADDRESS) ||
+               (address >= BOOTLOADER_APP_END_ADDRESS) ||
+               (packet[3] == 0) ||
+               (packet[3] > ((BOOTLOADER_APP_END_ADDRESS - address) / FLASH_ROW_SIZE)))
+            {
+                BOOT_Reply(BOOTLOADER_CMD_PROGRAM, BOOTLOADER_STATUS_ERROR);
+                break;
+            }
+            /* No reply until the last row has been written. */
+            programAddress = address;
+            programRows = packet[3];
+            break;
+
+        case BOOTLOADER_CMD_VERIFY:
+            crc = BOOT_ApplicationCRC();
+            packetIn[2] = (uint8_t)crc;
+            packetIn[3] = (uint8_t)(crc >> 8);
+            if((packet[1] != packetIn[2]) || (packet[2] != packetIn[3]))
+            {
+                BOOT_Reply(BOOTLOADER_CMD_VERIFY, BOOTLOADER_STATUS_ERROR);
+                break;
+            }
+            /* Marks the application valid for BOOT_StayInBootloader(). */
+            FLASH_WriteBytes(BOOTLOADER_APP_CRC_ADDRESS, &packetIn[2], 2);
+            BOOT_Reply(BOOTLOADER_CMD_VERIFY, BOOTLOADER_STATUS_OK);
+            break;
+
+        case BOOTLOADER_CMD_RESET:
+            BOOT_Reset();
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*********************************************************************
+* Function: static void BOOT_ProgramRow(uint8_t *packet);
+*
+* Overview: Writes one row packet of the current PROGRAM command.  The CRC
+*           words are kept erased here; only VERIFY may write them.
+*
+* PreCondition: A PROGRAM command is in progress.
+*
+* Input: uint8_t *packet - FLASH_ROW_SIZE words, low byte first
+*
+* Output: None
+*
+********************************************************************/
+static void BOOT_ProgramRow(uint8_t *packet)
+{
+    uint8_t i;
+
+    if(programAddress == (BOOTLOADER_APP_CRC_ADDRESS & ~(FLASH_ROW_SIZE - 1)))
+    {
+        for(i = (BOOTLOADER_APP_CRC_ADDRESS & (FLASH_ROW_SIZE - 1)) * 2; i < BOOTLOADER_PACKET_SIZE; i++)
+        {
+            packet[i] = 0xFF;
+        }
+    }
+
+    FLASH_WriteRow(programAddress, packet);
+    programAddress += FLASH_ROW_SIZE;
+
+    programRows--;
+    if(programRows == 0)
+    {
+        BOOT_Reply(BOOTLOADER_CMD_PROGRAM, BOOTLOADER_STATUS_OK);
+    }
+}
+
+/*********************************************************************
+* Function: static void BOOT_Reply(uint8_t command, uint8_t status);
+*
+* Overview: Sends packetIn with the command and status in the first two
+*           bytes.  Any other reply bytes are filled in by the caller.
+*
+* PreCondition: The IN endpoint is free.
+*
+* Input: uint8_t command - command being answered
+*        uint8_t status - BOOTLOADER_STATUS_xxx, or the version for QUERY
+*
+* Output: None
+*
+********************************************************************/
+static void BOOT_Reply(uint8_t command, uint8_t status)
+{
+    packetIn[0] = command;
+    packetIn[1] = status;
+    txHandle = HIDTxPacket(HID_EP, packetIn, BOOTLOADER_PACKET_SIZE);
+}
+
+/*********************************************************************
+* Function: static void BOOT_Reset(void);
+*
+* Overview: Detaches from the bus long enough for the host to notice and
+*           resets.  bootloaderKey is already cleared, so the reset starts
+*           the application if it is valid.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void BOOT_Reset(void)
+{
+    UCON = 0;           // Disable the module and the D+ pull-up
+
+    __delay_ms(10);
+
+    RESET();
+}
+
+/*********************************************************************
+* Function: bool USER_USB_CALLBACK_EVENT_HANDLER(USB_EVENT event, void *pdata, uint16_t size);
+*
+* Overview: USB stack events.  On configuration both OUT ping-pong buffers
+*           are armed so two packets can be in flight.
+*
+* PreCondition: None
+*
+* Input: USB_EVENT event - the type of event
+*        void *pdata - pointer to the event data
+*        uint16_t size - size of the event data
+*
+* Output: bool - always true
+*
+********************************************************************/
+bool USER_USB_CALLBACK_EVENT_HANDLER(USB_EVENT event, void *pdata, uint16_t size)
+{
+    switch((int)event)
+    {
+        case EVENT_CONFIGURED:
+            USBEnableEndpoint(HID_EP, USB_IN_ENABLED|USB_OUT_ENABLED|USB_HANDSHAKE_ENABLED|USB_DISALLOW_SETUP);
+            txHandle = NULL;
+            programRows = 0;
+            rxOdd = false;
+            rxHandleEven = HIDRxPacket(HID_EP, packetOutEven, BOOTLOADER_PACKET_SIZE);
+            rxHandleOdd = HIDRxPacket(HID_EP, packetOutOdd, BOOTLOADER_PACKET_SIZE);
+            break;
+
+        case EVENT_EP0_REQUEST:
+            USBCheckHIDRequest();
+            break;
+
+        default:
+            break;
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+#include <system.h>
+#include <system_config.h>
+#include <usb/usb.h>
+#include <usb/usb_device.h>
+
+#include "bootloader.h"
+
+/** CONFIGURATION Bits **********************************************/
+// The bootloader hex carries the configuration words; the application's
+// settings in ../system.c must match them.
+// CONFIG1
+#pragma config FOSC = INTOSC    // Oscillator Selection Bits (INTOSC oscillator: I/O function on CLKIN pin)
+#pragma config WDTE = OFF       // Watchdog Timer Enable (WDT disabled)
+#pragma config PWRTE = OFF      // Power-up Timer Enable (PWRT disabled)
+#pragma config MCLRE = OFF      // MCLR Pin Function Select (MCLR/VPP pin function is digital input)
+#pragma config CP = OFF         // Flash Program Memory Code Protection (Program memory code protection is disabled)
+#pragma config BOREN = ON       // Brown-out Reset Enable (Brown-out Reset enabled)
+#pragma config CLKOUTEN = OFF   // Clock Out Enable (CLKOUT function is disabled. I/O or oscillator function on the CLKOUT pin)
+#pragma config IESO = OFF       // Internal/External Switchover Mode (Internal/External Switchover Mode is disabled)
+#pragma config FCMEN = OFF      // Fail-Safe Clock Monitor Enable (Fail-Safe Clock Monitor is disabled)
+
+// CONFIG2
+#pragma config WRT = OFF        // Flash Memory Self-Write Protection (Write protection off)
+#pragma config CPUDIV = NOCLKDIV// CPU System Clock Selection Bit (NO CPU system divide)
+#pragma config USBLSCLK = 48MHz // USB Low SPeed Clock Selection bit (System clock expects 48 MHz, FS/LS USB CLKENs divide-by is set to 8.)
+#pragma config PLLMULT = 3x     // PLL Multipler Selection Bit (3x Output Frequency Selected)
+#pragma config PLLEN = ENABLED  // PLL Enable Bit (3x or 4x PLL Enabled)
+#pragma config STVREN = ON      // Stack Overflow/Underflow Reset Enable (Stack Overflow or Underflow will cause a Reset)
+#pragma config BORV = LO        // Brown-out Reset Voltage Selection (Brown-out Reset Voltage (Vbor), low trip point selected.)
+#pragma config LPBOR = OFF      // Low-Power Brown Out Reset (Low-Power BOR is disabled)
+#pragma config LVP = OFF        // Low-Voltage Programming Enable (High-voltage on MCLR/VPP must be used for programming)
+
+/*********************************************************************
+* Function: void SYSTEM_Initialize( SYSTEM_STATE state )
+*
+* Overview: Initializes the system.
+*
+* PreCondition: None
+*
+* Input:  SYSTEM_STATE - the state to initialize the system into
+*
+* Output: None
+*
+********************************************************************/
+void SYSTEM_Initialize( SYSTEM_STATE state )
+{
+    switch(state)
+    {
+        case SYSTEM_STATE_USB_START:
+            //Full speed USB from the INTOSC needs active clock tuning.  The
+            //clock is also what keeps the boot time CRC check short.
+            OSCCON = 0xFC;  //HFINTOSC @ 16MHz, 3X PLL, PLL enabled
+            ACTCON = 0x90;  //Active clock tuning enabled for USB
+            BUTTON_Enable(BUTTON_BOOTLOADER_ENTRY);
+            break;
+
+        case SYSTEM_STATE_USB_SUSPEND:
+            break;
+
+        case SYSTEM_STATE_USB_RESUME:
+            break;
+    }
+}
+
+/*********************************************************************
+* Function: void interrupt SYS_InterruptRedirect(void)
+*
+* Overview: The bootloader never enables interrupts, so any interrupt
+*           belongs to the application.  The context is already saved
+*           by the hardware; jump straight to the relocated vector.
+*
+* PreCondition: None
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+void interrupt SYS_InterruptRedirect(void)
+{
+    asm("ljmp " ___mkstr(BOOTLOADER_APP_INTERRUPT_VECTOR));
+}
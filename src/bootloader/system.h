@@ -0,0 +1,69 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+#ifndef SYSTEM_H
+#define SYSTEM_H
+
+#include <xc.h>
+#include <stdbool.h>
+
+#include <buttons.h>
+#include <fixed_address_memory.h>
+
+// Bootloader build of system.h.  The USB stack includes "system.h", so the
+// bootloader is built with this directory first on the include path and
+// gets its own clock, button and buffer setup instead of the application's.
+
+//Internal oscillator option setting.  The bootloader always runs from the
+//HFINTOSC with active clock tuning, the same as the application.
+#define USE_INTERNAL_OSC
+
+#define _XTAL_FREQ                  48000000    //for __delay_ms()
+
+#define MAIN_RETURN void
+
+/* Button held at reset to stay in the bootloader. */
+#define BUTTON_BOOTLOADER_ENTRY     BUTTON_S1
+
+/*** System States **************************************************/
+typedef enum
+{
+    SYSTEM_STATE_USB_START,
+    SYSTEM_STATE_USB_SUSPEND,
+    SYSTEM_STATE_USB_RESUME
+} SYSTEM_STATE;
+
+/*********************************************************************
+* Function: void SYSTEM_Initialize( SYSTEM_STATE state )
+*
+* Overview: Initializes the system.
+*
+* PreCondition: None
+*
+* Input:  SYSTEM_STATE - the state to initialize the system into
+*
+* Output: None
+*
+********************************************************************/
+void SYSTEM_Initialize( SYSTEM_STATE state );
+
+#endif //SYSTEM_H
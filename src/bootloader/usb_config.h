@@ -0,0 +1,95 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+/*********************************************************************
+ * Descriptor specific type definitions are defined in: usbd.h
+ ********************************************************************/
+
+#ifndef USBCFG_H
+#define USBCFG_H
+
+#include "usb/usb_ch9.h"
+
+/** DEFINITIONS ****************************************************/
+#define USB_EP0_BUFF_SIZE		8	// Valid Options: 8, 16, 32, or 64 bytes.
+
+#define USB_MAX_NUM_INT     	1  //Set this number to match the maximum interface number used in the descriptors for this firmware project
+#define USB_MAX_EP_NUMBER	    1   //Set this number to match the maximum endpoint number used in the descriptors for this firmware project
+
+//Device descriptor - if these two definitions are not defined then
+//  a const USB_DEVICE_DESCRIPTOR variable by the exact name of device_dsc
+//  must exist.
+#define USB_USER_DEVICE_DESCRIPTOR &device_dsc
+#define USB_USER_DEVICE_DESCRIPTOR_INCLUDE extern const USB_DEVICE_DESCRIPTOR device_dsc
+
+//Configuration descriptors - if these two definitions do not exist then
+//  a const BYTE *const variable named exactly USB_CD_Ptr[] must exist.
+#define USB_USER_CONFIG_DESCRIPTOR USB_CD_Ptr
+#define USB_USER_CONFIG_DESCRIPTOR_INCLUDE extern const uint8_t *const USB_CD_Ptr[]
+
+//Full ping-pong is required: the two HID OUT buffers are armed on the even
+//and odd BDs so a row packet can be received during a flash write.
+#define USB_PING_PONG_MODE USB_PING_PONG__FULL_PING_PONG
+
+#define USB_FULL_PING_PONG
+#define USB_EP0_OUT_ONLY
+
+//The bootloader runs with interrupts off (the interrupt vector belongs to
+//the application), so the stack is polled from the main loop.
+#define USB_POLLING
+//#define USB_INTERRUPT
+
+/* Parameter definitions are defined in usb_device.h */
+#define USB_PULLUP_OPTION USB_PULLUP_ENABLE
+
+#define USB_TRANSCEIVER_OPTION USB_INTERNAL_TRANSCEIVER
+
+//Full speed, like the application: low speed limits interrupt endpoints
+//to 8 byte packets, and a 64 byte report carries one flash row.
+#define USB_SPEED_OPTION USB_FULL_SPEED
+
+#define MY_VID 0x04D8
+#define MY_PID 0x005F
+
+#define USB_ENABLE_STATUS_STAGE_TIMEOUTS    //Comment this out to disable this feature.
+#define USB_STATUS_STAGE_TIMEOUT     (uint8_t)45   //Approximate timeout in milliseconds
+
+#define USB_SUPPORT_DEVICE
+
+#define USB_NUM_STRING_DESCRIPTORS 3
+
+/** DEVICE CLASS USAGE *********************************************/
+#define USB_USE_HID
+
+/** ENDPOINTS ALLOCATION *******************************************/
+
+/* HID */
+#define HID_INTF_ID             0x00
+#define HID_EP 					1
+#define HID_INT_OUT_EP_SIZE     64
+#define HID_INT_IN_EP_SIZE      64
+#define HID_NUM_OF_DSC          1
+#define HID_RPT01_SIZE          29
+
+/** DEFINITIONS ****************************************************/
+
+#endif //USBCFG_H
@@ -0,0 +1,150 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+#include <stdint.h>
+
+#include <usb/usb.h>
+#include <usb/usb_device_hid.h>
+
+/* Device Descriptor */
+const USB_DEVICE_DESCRIPTOR device_dsc=
+{
+    0x12,    // Size of this descriptor in bytes
+    USB_DESCRIPTOR_DEVICE,                // DEVICE descriptor type
+    0x0200,                 // USB Spec Release Number in BCD format
+    0x00,                   // Class Code
+    0x00,                   // Subclass code
+    0x00,                   // Protocol code
+    USB_EP0_BUFF_SIZE,          // Max packet size for EP0, see usb_config.h
+    MY_VID,                 // Vendor ID
+    MY_PID,                 // Product ID: HID bootloader
+    0x0001,                 // Device release number in BCD format
+    0x01,                   // Manufacturer string index
+    0x02,                   // Product string index
+    0x00,                   // Device serial number string index
+    0x01                    // Number of possible configurations
+};
+
+/* Configuration 1 Descriptor */
+const uint8_t configDescriptor1[]={
+    /* Configuration Descriptor */
+    0x09,//sizeof(USB_CFG_DSC),    // Size of this descriptor in bytes
+    USB_DESCRIPTOR_CONFIGURATION,                // CONFIGURATION descriptor type
+    DESC_CONFIG_WORD(0x0029),   // Total length of data for this cfg
+    1,                      // Number of interfaces in this cfg
+    1,                      // Index value of this configuration
+    0,                      // Configuration string index
+    _DEFAULT,               // Attributes, see usb_device.h
+    50,                     // Max power consumption (2X mA)
+
+    /* Interface Descriptor */
+    0x09,//sizeof(USB_INTF_DSC),   // Size of this descriptor in bytes
+    USB_DESCRIPTOR_INTERFACE,               // INTERFACE descriptor type
+    HID_INTF_ID,            // Interface Number
+    0,                      // Alternate Setting Number
+    2,                      // Number of endpoints in this intf
+    HID_INTF,               // Class code
+    0,                      // Subclass code
+    0,                      // Protocol code
+    0,                      // Interface string index
+
+    /* HID Class-Specific Descriptor */
+    0x09,//sizeof(USB_HID_DSC)+3,    // Size of this descriptor in bytes
+    DSC_HID,                // HID descriptor type
+    DESC_CONFIG_WORD(0x0111),                 // HID Spec Release Number in BCD format (1.11)
+    0x00,                   // Country Code (0x00 for Not supported)
+    HID_NUM_OF_DSC,         // Number of class descriptors, see usb_config.h
+    DSC_RPT,                // Report descriptor type
+    DESC_CONFIG_WORD(HID_RPT01_SIZE),   // Size of the report descriptor
+
+    /* Endpoint Descriptor */
+    0x07,/*sizeof(USB_EP_DSC)*/
+    USB_DESCRIPTOR_ENDPOINT,    //Endpoint Descriptor
+    HID_EP | _EP_IN,            //EndpointAddress
+    _INTERRUPT,                       //Attributes
+    DESC_CONFIG_WORD(HID_INT_IN_EP_SIZE),        //size
+    0x01,                        //Interval
+
+    /* Endpoint Descriptor */
+    0x07,/*sizeof(USB_EP_DSC)*/
+    USB_DESCRIPTOR_ENDPOINT,    //Endpoint Descriptor
+    HID_EP | _EP_OUT,            //EndpointAddress
+    _INTERRUPT,                       //Attributes
+    DESC_CONFIG_WORD(HID_INT_OUT_EP_SIZE),        //size
+    0x01                        //Interval
+};
+
+//Language code string descriptor
+const struct{uint8_t bLength;uint8_t bDscType;uint16_t string[1];}sd000={
+    sizeof(sd000),
+    USB_DESCRIPTOR_STRING,
+    {0x0409} //0x0409 = Language ID code for US English
+};
+
+//Manufacturer string descriptor
+const struct{uint8_t bLength;uint8_t bDscType;uint16_t string[25];}sd001={
+    sizeof(sd001),
+    USB_DESCRIPTOR_STRING,
+    {'M','i','c','r','o','c','h','i','p',' ',
+    'T','e','c','h','n','o','l','o','g','y',' ','I','n','c','.'
+    }
+};
+
+//Product string descriptor
+const struct{uint8_t bLength;uint8_t bDscType;uint16_t string[14];}sd002={
+    sizeof(sd002),
+    USB_DESCRIPTOR_STRING,
+    {'H','I','D',' ','B','o','o','t','l','o','a','d','e','r'
+    }
+};
+
+//Class specific descriptor - vendor defined 64 byte reports
+const struct{uint8_t report[HID_RPT01_SIZE];}hid_rpt01={
+{   0x06, 0x00, 0xFF,              // USAGE_PAGE (Vendor Defined 0xFF00)
+    0x09, 0x01,                    // USAGE (Vendor Usage 1)
+    0xa1, 0x01,                    // COLLECTION (Application)
+    0x19, 0x01,                    //   USAGE_MINIMUM (1)
+    0x29, 0x40,                    //   USAGE_MAXIMUM (64)
+    0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+    0x26, 0xFF, 0x00,              //   LOGICAL_MAXIMUM (255)
+    0x75, 0x08,                    //   REPORT_SIZE (8)
+    0x95, 0x40,                    //   REPORT_COUNT (64)
+    0x81, 0x00,                    //   INPUT (Data,Ary,Abs)
+    0x19, 0x01,                    //   USAGE_MINIMUM (1)
+    0x29, 0x40,                    //   USAGE_MAXIMUM (64)
+    0x91, 0x00,                    //   OUTPUT (Data,Ary,Abs)
+    0xc0}                          // End Collection
+};
+
+//Array of configuration descriptors
+const uint8_t *const USB_CD_Ptr[]=
+{
+    (const uint8_t *const)&configDescriptor1
+};
+
+//Array of string descriptors
+const uint8_t *const USB_SD_Ptr[]=
+{
+    (const uint8_t *const)&sd000,
+    (const uint8_t *const)&sd001,
+    (const uint8_t *const)&sd002
+};
@@ -57,7 +57,9 @@ uint8_t ADC_ReadPercentage
 
     switch(channel)
     {
-        case ADC_CHANNEL_10:
+        case ADC_CHANNEL_4:
+        case ADC_CHANNEL_5:
+        case ADC_CHANNEL_6:
             break;
         default:
             return 0xFF;
@@ -97,7 +99,9 @@ uint16_t ADC_Read10bit(ADC_CHANNEL channel)
 
     switch(channel)
     {
-        case ADC_CHANNEL_10:
+        case ADC_CHANNEL_4:
+        case ADC_CHANNEL_5:
+        case ADC_CHANNEL_6:
             break;
         default:
             return 0xFFFF;
@@ -132,9 +136,19 @@ bool ADC_Enable(ADC_CHANNEL channel)
 {
     switch(channel)
     {
-        case ADC_CHANNEL_10:
-            TRISBbits.TRISB4 = PIN_INPUT;
-            ANSELBbits.ANSB4 = PIN_ANALOG;
+        case ADC_CHANNEL_4:
+            TRISCbits.TRISC0 = PIN_INPUT;
+            ANSELCbits.ANSC0 = PIN_ANALOG;
+            return true;
+
+        case ADC_CHANNEL_5:
+            TRISCbits.TRISC1 = PIN_INPUT;
+            ANSELCbits.ANSC1 = PIN_ANALOG;
+            return true;
+
+        case ADC_CHANNEL_6:
+            TRISCbits.TRISC2 = PIN_INPUT;
+            ANSELCbits.ANSC2 = PIN_ANALOG;
             return true;
 
         default:
@@ -158,12 +172,65 @@ bool ADC_SetConfiguration(ADC_CONFIGURATION configuration)
 {
     if(configuration == ADC_CONFIGURATION_DEFAULT)
     {
-        ADCON0=0x29;
+        ADCON0=0x11;    //AN4, ADC on
         ADCON1=0xE0;
         ADCON2=0x00;
         
         return true;
     }
 
+    if(configuration == ADC_CONFIGURATION_TIMER2_TRIGGER)
+    {
+        ADCON0=0x11;
+        ADCON1=0xE0;    //right justified, Fosc/64, VDD reference
+        ADCON2=0x50;    //TRIGSEL = Timer2 match
+
+        PR2 = ADC_TIMER2_PERIOD;
+        TMR2 = 0;
+        T2CON = 0x06;   //1:16 prescaler, 1:1 postscaler, Timer2 on
+
+        return true;
+    }
+
     return false;
 }
+
+/*********************************************************************
+* Function: void ADC_SelectChannel(ADC_CHANNEL channel)
+*
+* Overview: Connects the channel to the ADC.
+*
+* PreCondition: channel is enabled via ADC_Enable()
+*
+* Input: ADC_CHANNEL channel - the channel to convert next
+*
+* Output: None
+*
+********************************************************************/
+void ADC_SelectChannel(ADC_CHANNEL channel)
+{
+    ADCON0bits.CHS = channel;
+}
+
+/*********************************************************************
+* Function: uint16_t ADC_ReadResult(void)
+*
+* Overview: Returns the result of the last conversion.
+*
+* PreCondition: The conversion is complete
+*
+* Input: None
+*
+* Output: uint16_t the right adjusted 10-bit result
+*
+********************************************************************/
+uint16_t ADC_ReadResult(void)
+{
+    uint16_t result;
+
+    result = ADRESH;
+    result <<= 8;
+    result |= ADRESL;
+
+    return result;
+}
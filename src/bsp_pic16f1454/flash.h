@@ -0,0 +1,123 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+#ifndef FLASH_H
+#define FLASH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*** High-Endurance Flash Definitions ********************************/
+// The last 128 words of program memory are high-endurance flash (HEF).
+// Only the low byte of each word has the extended endurance, so HEF is
+// used as 128 bytes of byte-wide storage.  The area must be kept free of
+// code with the linker option --ROM=default,-1f80-1fff.
+#define FLASH_HEF_START_ADDRESS     0x1F80
+#define FLASH_HEF_SIZE              128
+#define FLASH_ROW_SIZE              32
+
+#define FLASH_ERASED_BYTE           0xFF
+
+/*********************************************************************
+* Function: uint8_t FLASH_ReadByte(uint16_t address);
+*
+* Overview: Reads the low byte of a program memory word.
+*
+* PreCondition: None
+*
+* Input: uint16_t address - program memory word address
+*
+* Output: uint8_t - low byte of the word.  An erased word reads as
+*         FLASH_ERASED_BYTE.
+*
+********************************************************************/
+uint8_t FLASH_ReadByte(uint16_t address);
+
+/*********************************************************************
+* Function: uint16_t FLASH_ReadWord(uint16_t address);
+*
+* Overview: Reads a full 14-bit program memory word.
+*
+* PreCondition: None
+*
+* Input: uint16_t address - program memory word address
+*
+* Output: uint16_t - the word.  An erased word reads as 0x3FFF.
+*
+********************************************************************/
+uint16_t FLASH_ReadWord(uint16_t address);
+
+/*********************************************************************
+* Function: void FLASH_EraseRow(uint16_t address);
+*
+* Overview: Erases the FLASH_ROW_SIZE word row that contains address.
+*           The CPU stalls for the erase time (~2ms).  Interrupts are
+*           disabled only for the unlock sequence.
+*
+* PreCondition: None
+*
+* Input: uint16_t address - any program memory word address in the row
+*
+* Output: None
+*
+********************************************************************/
+void FLASH_EraseRow(uint16_t address);
+
+/*********************************************************************
+* Function: void FLASH_WriteBytes(uint16_t address, const uint8_t *data, uint8_t length);
+*
+* Overview: Programs length bytes into the low byte of consecutive words
+*           starting at address, with a single row write.  The words must
+*           be erased and must not cross a row boundary.
+*
+* PreCondition: The target words are erased.
+*
+* Input: uint16_t address - program memory word address of the first byte
+*        const uint8_t *data - bytes to write
+*        uint8_t length - number of bytes (1 to FLASH_ROW_SIZE)
+*
+* Output: None
+*
+********************************************************************/
+void FLASH_WriteBytes(uint16_t address, const uint8_t *data, uint8_t length);
+
+/*********************************************************************
+* Function: void FLASH_WriteRow(uint16_t address, const uint8_t *data);
+*
+* Overview: Programs one full row of FLASH_ROW_SIZE words.  The words
+*           are taken from data as little-endian byte pairs (low byte,
+*           then the upper 6 bits), so data holds FLASH_ROW_SIZE * 2
+*           bytes.  The CPU stalls for the write time (~2ms), but the
+*           USB module keeps receiving into endpoint buffers that are
+*           already armed.
+*
+* PreCondition: The row is erased.
+*
+* Input: uint16_t address - program memory word address of the row start
+*        const uint8_t *data - FLASH_ROW_SIZE * 2 bytes to write
+*
+* Output: None
+*
+********************************************************************/
+void FLASH_WriteRow(uint16_t address, const uint8_t *data);
+
+#endif //FLASH_H
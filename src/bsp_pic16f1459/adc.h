@@ -31,14 +31,24 @@
 
 typedef enum
 {
-    ADC_CHANNEL_10 = 10,
+    ADC_CHANNEL_4 = 4,      // RC0
+    ADC_CHANNEL_5 = 5,      // RC1
+    ADC_CHANNEL_6 = 6,      // RC2
+    ADC_CHANNEL_10 = 10,    // RB4
 } ADC_CHANNEL;
 
 typedef enum
 {
-    ADC_CONFIGURATION_DEFAULT
+    ADC_CONFIGURATION_DEFAULT,
+    ADC_CONFIGURATION_TIMER2_TRIGGER
 } ADC_CONFIGURATION;
 
+/* ADC_CONFIGURATION_TIMER2_TRIGGER: Timer2 runs from Fosc/4 (12MHz) with a
+ * 1:16 prescaler and starts a conversion on every PR2 match, so conversions
+ * are evenly spaced without any CPU involvement:
+ *   rate = 12MHz / 16 / (ADC_TIMER2_PERIOD + 1) = 7979Hz */
+#define ADC_TIMER2_PERIOD       93
+
 /*********************************************************************
 * Function: ADC_ReadPercentage(ADC_CHANNEL channel);
 *
@@ -108,4 +118,34 @@ bool ADC_Enable(ADC_CHANNEL channel);
 ********************************************************************/
 bool ADC_SetConfiguration(ADC_CONFIGURATION configuration);
 
+/*********************************************************************
+* Function: void ADC_SelectChannel(ADC_CHANNEL channel)
+*
+* Overview: Connects the channel to the ADC.  The next conversion must
+*           not start before the acquisition time (~5us) has passed.
+*
+* PreCondition: channel is enabled via ADC_Enable()
+*
+* Input: ADC_CHANNEL channel - the channel to convert next
+*
+* Output: None
+*
+********************************************************************/
+void ADC_SelectChannel(ADC_CHANNEL channel);
+
+/*********************************************************************
+* Function: uint16_t ADC_ReadResult(void)
+*
+* Overview: Returns the result of the last conversion without starting
+*           a new one, for use with ADC_CONFIGURATION_TIMER2_TRIGGER.
+*
+* PreCondition: The conversion is complete (PIR1bits.ADIF is set)
+*
+* Input: None
+*
+* Output: uint16_t the right adjusted 10-bit result
+*
+********************************************************************/
+uint16_t ADC_ReadResult(void);
+
 #endif  //ADC_H
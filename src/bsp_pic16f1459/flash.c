@@ -0,0 +1,225 @@
+/********************************************************************
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PIC(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PIC Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *******************************************************************/
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <flash.h>
+
+/*** Private Prototypes *********************************************/
+static void FLASH_Unlock(void);
+
+/*********************************************************************
+* Function: uint8_t FLASH_ReadByte(uint16_t address);
+*
+* Overview: Reads the low byte of a program memory word.
+*
+* PreCondition: None
+*
+* Input: uint16_t address - program memory word address
+*
+* Output: uint8_t - low byte of the word.  An erased word reads as
+*         FLASH_ERASED_BYTE.
+*
+********************************************************************/
+uint8_t FLASH_ReadByte(uint16_t address)
+{
+    PMADRL = (uint8_t)address;
+    PMADRH = (uint8_t)(address >> 8);
+
+    PMCON1bits.CFGS = 0;    // Program memory, not configuration space
+    PMCON1bits.RD = 1;      // Start the read
+    NOP();                  // The two instructions after RD are ignored
+    NOP();
+
+    return PMDATL;
+}
+
+/*********************************************************************
+* Function: uint16_t FLASH_ReadWord(uint16_t address);
+*
+* Overview: Reads a full 14-bit program memory word.
+*
+* PreCondition: None
+*
+* Input: uint16_t address - program memory word address
+*
+* Output: uint16_t - the word.  An erased word reads as 0x3FFF.
+*
+********************************************************************/
+uint16_t FLASH_ReadWord(uint16_t address)
+{
+    uint8_t low;
+
+    low = FLASH_ReadByte(address);
+
+    return ((uint16_t)PMDATH << 8) | low;
+}
+
+/*********************************************************************
+* Function: void FLASH_EraseRow(uint16_t address);
+*
+* Overview: Erases the FLASH_ROW_SIZE word row that contains address.
+*
+* PreCondition: None
+*
+* Input: uint16_t address - any program memory word address in the row
+*
+* Output: None
+*
+********************************************************************/
+void FLASH_EraseRow(uint16_t address)
+{
+    PMADRL = (uint8_t)address;
+    PMADRH = (uint8_t)(address >> 8);
+
+    PMCON1bits.CFGS = 0;
+    PMCON1bits.FREE = 1;    // Row erase
+    PMCON1bits.WREN = 1;
+    FLASH_Unlock();         // CPU stalls here until the erase is done
+
+    PMCON1bits.WREN = 0;
+    PMCON1bits.FREE = 0;
+}
+
+/*********************************************************************
+* Function: void FLASH_WriteBytes(uint16_t address, const uint8_t *data, uint8_t length);
+*
+* Overview: Programs length bytes into the low byte of consecutive words
+*           starting at address, with a single row write.
+*
+* PreCondition: The target words are erased.
+*
+* Input: uint16_t address - program memory word address of the first byte
+*        const uint8_t *data - bytes to write
+*        uint8_t length - number of bytes (1 to FLASH_ROW_SIZE)
+*
+* Output: None
+*
+********************************************************************/
+void FLASH_WriteBytes(uint16_t address, const uint8_t *data, uint8_t length)
+{
+    PMCON1bits.CFGS = 0;
+    PMCON1bits.FREE = 0;
+    PMCON1bits.WREN = 1;
+    PMCON1bits.LWLO = 1;    // Only load the write latches for now
+
+    while(length != 0)
+    {
+        PMADRL = (uint8_t)address;
+        PMADRH = (uint8_t)(address >> 8);
+        PMDATL = *data;
+        PMDATH = 0x3F;      // Upper bits left erased; only the low byte is used
+
+        length--;
+        if(length == 0)
+        {
+            // Last word: write all of the loaded latches to the row.
+            // Latches that were not loaded stay 0x3FFF and leave the
+            // corresponding words unchanged.
+            PMCON1bits.LWLO = 0;
+        }
+        FLASH_Unlock();
+
+        address++;
+        data++;
+    }
+
+    PMCON1bits.WREN = 0;
+}
+
+/*********************************************************************
+* Function: void FLASH_WriteRow(uint16_t address, const uint8_t *data);
+*
+* Overview: Programs one full row of FLASH_ROW_SIZE words from
+*           FLASH_ROW_SIZE * 2 little-endian data bytes.
+*
+* PreCondition: The row is erased.
+*
+* Input: uint16_t address - program memory word address of the row start
+*        const uint8_t *data - FLASH_ROW_SIZE * 2 bytes to write
+*
+* Output: None
+*
+********************************************************************/
+void FLASH_WriteRow(uint16_t address, const uint8_t *data)
+{
+    uint8_t i;
+
+    PMCON1bits.CFGS = 0;
+    PMCON1bits.FREE = 0;
+    PMCON1bits.WREN = 1;
+    PMCON1bits.LWLO = 1;
+
+    for(i = 0; i < FLASH_ROW_SIZE; i++)
+    {
+        PMADRL = (uint8_t)address;
+        PMADRH = (uint8_t)(address >> 8);
+        PMDATL = data[0];
+        PMDATH = data[1] & 0x3F;
+
+        if(i == (FLASH_ROW_SIZE - 1))
+        {
+            PMCON1bits.LWLO = 0;    // Last latch loaded: write the row
+        }
+        FLASH_Unlock();
+
+        address++;
+        data += 2;
+    }
+
+    PMCON1bits.WREN = 0;
+}
+
+/*********************************************************************
+* Function: static void FLASH_Unlock(void);
+*
+* Overview: Runs the required 0x55/0xAA unlock sequence and starts the
+*           operation selected in PMCON1.  The sequence must not be
+*           interrupted, so the (USB) interrupt is held off around it.
+*
+* PreCondition: PMCON1 has been set up for the operation.
+*
+* Input: None
+*
+* Output: None
+*
+********************************************************************/
+static void FLASH_Unlock(void)
+{
+    bool interruptsEnabled;
+
+    interruptsEnabled = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+
+    PMCON2 = 0x55;
+    PMCON2 = 0xAA;
+    PMCON1bits.WR = 1;
+    NOP();                  // The two instructions after WR are ignored
+    NOP();
+
+    if(interruptsEnabled)
+    {
+        INTCONbits.GIE = 1;
+    }
+}
@@ -26,8 +26,65 @@
 #define FIXED_ADDRESS_MEMORY
 
 #define DEVCE_AUDIO_MICROPHONE_DATA_BUFFER_ADDRESS 0x2050
-#define IN_DATA_BUFFER_ADDRESS_TAG      @0x0A0
-#define OUT_DATA_BUFFER_ADDRESS_TAG     @0x120
-#define CONTROL_BUFFER_ADDRESS_TAG      @0x1A0
+
+/* USB endpoint buffer arena
+ *
+ * All non-EP0 endpoint buffers share one block of dual-port RAM that starts
+ * right after the BDT and the EP0 setup/data buffers.  With endpoints 0-4
+ * in full ping-pong mode the BDT fills bank 0 (0x2000-0x204F linear) and the
+ * EP0 buffers take the first 16 bytes of bank 1.  The application works on
+ * these buffers in place, so it does not need its own copies of the CDC,
+ * HID and MIDI packets.
+ *
+ * A 64 byte bulk buffer is kept inside a single 80 byte GPR bank so it can be
+ * accessed with banked addressing.  The tail of each bank is then used for
+ * the small buffers instead of being left unused.
+ *
+ *   bank 1  0x0A0  SetupPkt, CtrlTrfData (placed by the USB stack)
+ *           0x0B0  cdc_data_tx      CDC_DATA_IN_EP_SIZE
+ *   bank 2  0x120  cdc_data_rx      CDC_DATA_OUT_EP_SIZE
+ *           0x160  outputReport     HID_INT_OUT_EP_SIZE
+ *           0x162  inputReport      HID_INT_IN_EP_SIZE
+ *           0x16F  bootloader entry key, see bootloader/bootloader.h
+ *   bank 3  0x1A0  midiInBuffer     MIDI_IN_EP_SIZE
+ *           0x1E0  joystickReport   HID_JOYSTICK_REPORT_SIZE
+ *           0x1E5  midiOutBuffer    MIDI_OUT_EP_SIZE
+ *
+ * The layout is checked at compile time in main.c, and "make usb-memory-map"
+ * lists the addresses the linker actually used. */
+#define USB_ARENA_BANK_SIZE             80
+#define USB_ARENA_BANK1_BASE            0x0A0
+#define USB_ARENA_BANK2_BASE            0x120
+#define USB_ARENA_BANK3_BASE            0x1A0
+
+/* Linear (FSR) address of a banked GPR address, for comparing with the
+ * addresses the USB stack uses. */
+#define USB_ARENA_LINEAR(addr)          (0x2000 + (((addr) >> 7) * USB_ARENA_BANK_SIZE) + (((addr) & 0x7F) - 0x20))
+
+#define USB_ARENA_BANK1_ADDR            (USB_ARENA_BANK1_BASE + (2 * USB_EP0_BUFF_SIZE))
+#define IN_DATA_BUFFER_ADDR             USB_ARENA_BANK1_ADDR
+#define USB_ARENA_BANK1_END             (IN_DATA_BUFFER_ADDR + CDC_DATA_IN_EP_SIZE)
+
+#define OUT_DATA_BUFFER_ADDR            USB_ARENA_BANK2_BASE
+#define KEYBOARD_OUTPUT_REPORT_DATA_BUFFER_ADDR (OUT_DATA_BUFFER_ADDR + CDC_DATA_OUT_EP_SIZE)
+#define KEYBOARD_INPUT_REPORT_DATA_BUFFER_ADDR  (KEYBOARD_OUTPUT_REPORT_DATA_BUFFER_ADDR + HID_INT_OUT_EP_SIZE)
+#define USB_ARENA_BANK2_END             (KEYBOARD_INPUT_REPORT_DATA_BUFFER_ADDR + HID_INT_IN_EP_SIZE)
+
+#define MIDI_IN_DATA_BUFFER_ADDR        USB_ARENA_BANK3_BASE
+#define JOYSTICK_INPUT_REPORT_DATA_BUFFER_ADDR  (MIDI_IN_DATA_BUFFER_ADDR + MIDI_IN_EP_SIZE)
+#define MIDI_OUT_DATA_BUFFER_ADDR       (JOYSTICK_INPUT_REPORT_DATA_BUFFER_ADDR + HID_JOYSTICK_REPORT_SIZE)
+#define USB_ARENA_BANK3_END             (MIDI_OUT_DATA_BUFFER_ADDR + MIDI_OUT_EP_SIZE)
+
+#define IN_DATA_BUFFER_ADDRESS_TAG      @IN_DATA_BUFFER_ADDR
+#define OUT_DATA_BUFFER_ADDRESS_TAG     @OUT_DATA_BUFFER_ADDR
+#define KEYBOARD_INPUT_REPORT_DATA_BUFFER_ADDRESS_TAG   @KEYBOARD_INPUT_REPORT_DATA_BUFFER_ADDR
+#define KEYBOARD_OUTPUT_REPORT_DATA_BUFFER_ADDRESS_TAG  @KEYBOARD_OUTPUT_REPORT_DATA_BUFFER_ADDR
+#define JOYSTICK_INPUT_REPORT_DATA_BUFFER_ADDRESS_TAG   @JOYSTICK_INPUT_REPORT_DATA_BUFFER_ADDR
+#define MIDI_IN_DATA_BUFFER_ADDRESS_TAG @MIDI_IN_DATA_BUFFER_ADDR
+#define MIDI_OUT_DATA_BUFFER_ADDRESS_TAG    @MIDI_OUT_DATA_BUFFER_ADDR
+
+/* The CDC control buffer is not used by this project (controlBuffer is
+ * commented out in usb_device_cdc.c), so no RAM is reserved for it. */
+#define CONTROL_BUFFER_ADDRESS_TAG
 
 #endif //FIXED_MEMORY_ADDRESS
\ No newline at end of file
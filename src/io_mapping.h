@@ -40,12 +40,38 @@
 #define KEY_VAL_VOL_DN                                  (129)
 #define KEY_VAL_ESC                                     (0x29)
 
+/* CDC message types, see app_device_cdc_basic.c */
 #define CDC_TYPE_LAUNCH                                 (0x01)
+#define CDC_TYPE_KEYMAP_SET                             (0x02)
+#define CDC_TYPE_KEYMAP_GET                             (0x03)
+#define CDC_TYPE_BOOTLOADER                             (0x04)
+#define CDC_TYPE_ANALOG_MODE                            (0x05)
+#define CDC_TYPE_ANALOG_STATS                           (0x06)
+#define CDC_TYPE_ANALOG_SAMPLES                         (0x07)
+
+#define CDC_STATUS_OK                                   (0x00)
+#define CDC_STATUS_ERROR                                (0x01)
+
+/* Default button mapping (S1-S5 send CDC_VAL_KEYn, S6 presses ESC).  These
+ * are used until the host changes a mapping, see app_keymap.c. */
 #define CDC_VAL_KEY1                                    (1)
 #define CDC_VAL_KEY2                                    (2)
 #define CDC_VAL_KEY3                                    (3)
 #define CDC_VAL_KEY4                                    (4)
 #define CDC_VAL_KEY5                                    (5)
 
+/* Analog inputs (panel slider and knob), see app_analog.c.  The joystick
+ * report shares the tail of a USB RAM bank (checked in main.c); the CDC
+ * stream needs the count to divide ANALOG_SAMPLES_PER_PACKET (42). */
+#define ANALOG_CHANNEL_COUNT                            2
+#define ANALOG_CHANNEL_LIST                             ADC_CHANNEL_4, ADC_CHANNEL_5
+#define ANALOG_MODE_DEFAULT                             ANALOG_MODE_HID
+
+/* MIDI events of buttons mapped to KEYMAP_ACTION_MIDI_NOTE/_CC, see
+ * app_device_midi.c.  MIDI_CHANNEL is 0-15 for channels 1-16. */
+#define MIDI_CABLE                                      0
+#define MIDI_CHANNEL                                    0
+#define MIDI_NOTE_VELOCITY                              0x7F
+
 /* USB Stack I/O options. */
 #define self_power                                      1
@@ -60,6 +60,10 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 /* Demo project includes */
 #include "app_led_usb_status.h"
 #include "app_device_keyboard.h"
+#include "app_keymap.h"
+#include "app_analog.h"
+#include "app_device_midi.h"
+#include "bootloader/bootloader.h"
 
 
 
@@ -70,6 +74,22 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 // *****************************************************************************
 volatile signed int SOFCounter = 0;
 
+/* Check the USB endpoint buffer arena described in fixed_address_memory.h.
+ * Each bank must hold its buffers without spilling into the next one, and
+ * the arena must not overlap the BDT and EP0 buffers placed by the stack. */
+#if (USB_ARENA_BANK1_END > (USB_ARENA_BANK1_BASE + USB_ARENA_BANK_SIZE))
+    #error "USB arena bank 1 overflow: reduce CDC_DATA_IN_EP_SIZE or USB_EP0_BUFF_SIZE."
+#endif
+#if (USB_ARENA_BANK2_END > BOOTLOADER_KEY_ADDRESS)
+    #error "USB arena bank 2 overflow: reduce CDC_DATA_OUT_EP_SIZE, HID_INT_OUT_EP_SIZE or HID_INT_IN_EP_SIZE."
+#endif
+#if (USB_ARENA_BANK3_END > (USB_ARENA_BANK3_BASE + USB_ARENA_BANK_SIZE))
+    #error "USB arena bank 3 overflow: reduce MIDI_IN_EP_SIZE, MIDI_OUT_EP_SIZE or ANALOG_CHANNEL_COUNT."
+#endif
+#if ((CTRL_TRF_DATA_ADDR + USB_EP0_BUFF_SIZE) > USB_ARENA_LINEAR(USB_ARENA_BANK1_ADDR))
+    #error "The BDT and EP0 buffers extend into the USB arena in bank 1."
+#endif
+
 
 // *****************************************************************************
 // *****************************************************************************
@@ -88,6 +108,12 @@ int main(void)
 {
     SYSTEM_Initialize( SYSTEM_STATE_USB_START );
 
+    /* Load the button key map from high-endurance flash. */
+    APP_KeyMapInitialize();
+
+    /* Start the Timer2 triggered sampling of the analog inputs. */
+    APP_AnalogInitialize();
+
     USBDeviceInit();
     USBDeviceAttach();
 
@@ -137,6 +163,8 @@ int main(void)
 
         /* Run the keyboard demo tasks. */
         APP_KeyboardTasks();
+        APP_AnalogTasks();
+        APP_DeviceMIDITasks();
         APP_DeviceCDCBasicDemoTasks();
     }//end while
 }//end main
@@ -179,6 +207,7 @@ bool USER_USB_CALLBACK_EVENT_HANDLER(USB_EVENT event, void *pdata, uint16_t size
              * demo code. */
             APP_KeyboardInit();
             APP_DeviceCDCBasicDemoInitialize();
+            APP_DeviceMIDIInitialize();
             break;
 
         case EVENT_SET_DESCRIPTOR:
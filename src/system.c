@@ -24,7 +24,11 @@
 #include <system_config.h>
 #include <usb/usb.h>
 #include <usb/usb_device.h>
+
+#include "app_analog.h"
 /** CONFIGURATION Bits **********************************************/
+// The configuration words are programmed with the bootloader
+// (bootloader/system.c); hidboot does not write these.  Keep both the same.
 // PIC16F1459 configuration bit settings:
 #if defined (USE_INTERNAL_OSC)	    // Define this in system.h if using the HFINTOSC for USB operation
     // CONFIG1
@@ -119,7 +123,17 @@ void SYSTEM_Initialize( SYSTEM_STATE state )
 			
 void interrupt SYS_InterruptHigh(void)
 {
+    /* The ADC interrupt comes every 125us, so it is handled first and the
+     * USB stack is only entered when it has something pending. */
+    if((PIE1bits.ADIE == 1) && (PIR1bits.ADIF == 1))
+    {
+        APP_AnalogInterruptHandler();
+    }
+
     #if defined(USB_INTERRUPT)
-        USBDeviceTasks();
+        if(USBInterruptFlag == 1)
+        {
+            USBDeviceTasks();
+        }
     #endif
 }
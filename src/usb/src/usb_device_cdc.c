@@ -570,6 +570,76 @@ uint8_t getsUSBUSART(uint8_t *buffer, uint8_t len)
     
 }//end getsUSBUSART
 
+/**********************************************************************************
+  Function:
+        uint8_t USBUSARTRxBufferGetLength(void)
+
+  Summary:
+    Returns the number of bytes waiting in the CDC bulk OUT endpoint buffer,
+    without copying them anywhere.
+
+  Description:
+    This is the in place counterpart of getsUSBUSART().  When a packet has
+    been received, its bytes can be read directly from USBUSARTRxBuffer().
+    The buffer stays owned by the application until
+    USBUSARTRxBufferRelease() is called, which hands it back to the USB
+    module for the next OUT transaction.
+
+    Typical Usage:
+    <code>
+        uint8_t numBytes;
+
+        numBytes = USBUSARTRxBufferGetLength();
+        if(numBytes \> 0)
+        {
+            //Use USBUSARTRxBuffer()[0..numBytes-1] here.
+            USBUSARTRxBufferRelease();
+        }
+    </code>
+  Conditions:
+    None
+  Output:
+    uint8_t - the number of bytes received, or 0 if no packet is waiting.
+              A zero length packet is released immediately and reported as 0.
+
+  **********************************************************************************/
+uint8_t USBUSARTRxBufferGetLength(void)
+{
+    uint8_t len;
+
+    if(USBHandleBusy(CDCDataOutHandle))
+    {
+        return 0;
+    }
+
+    len = USBHandleGetLength(CDCDataOutHandle);
+    if(len == 0)
+    {
+        USBUSARTRxBufferRelease();
+    }
+    return len;
+}//end USBUSARTRxBufferGetLength
+
+/**********************************************************************************
+  Function:
+        void USBUSARTRxBufferRelease(void)
+
+  Summary:
+    Re-arms the CDC bulk OUT endpoint after the application has finished
+    reading USBUSARTRxBuffer() in place.
+
+  Conditions:
+    USBUSARTRxBufferGetLength() returned a non-zero value.
+
+  **********************************************************************************/
+void USBUSARTRxBufferRelease(void)
+{
+    if(!USBHandleBusy(CDCDataOutHandle))
+    {
+        CDCDataOutHandle = USBRxOnePacket(CDC_DATA_EP,(uint8_t*)&cdc_data_rx,sizeof(cdc_data_rx));
+    }
+}//end USBUSARTRxBufferRelease
+
 /******************************************************************************
   Function:
 	void putUSBUSART(char *data, uint8_t length)
@@ -643,6 +713,66 @@ void putUSBUSART(uint8_t *data, uint8_t  length)
     USBUnmaskInterrupts();
 }//end putUSBUSART
 
+/******************************************************************************
+  Function:
+	void USBUSARTTxBufferSend(uint8_t length)
+
+  Summary:
+    Sends the first 'length' bytes of USBUSARTTxBuffer() to the host, without
+    copying them.
+
+  Description:
+    This is the in place counterpart of putUSBUSART().  The application builds
+    its packet directly in the CDC bulk IN endpoint buffer and then hands it
+    to the USB module.  Because no copy is made, at most one endpoint buffer
+    (CDC_DATA_IN_EP_SIZE bytes) can be sent per call.
+
+    Typical Usage:
+    <code>
+        if(USBUSARTIsTxTrfReady())
+        {
+            USBUSARTTxBuffer()[0] = 0x01;
+            USBUSARTTxBuffer()[1] = 0x02;
+            USBUSARTTxBufferSend(2);
+        }
+    </code>
+
+  Conditions:
+    USBUSARTIsTxTrfReady() must return true, both before writing into
+    USBUSARTTxBuffer() and before calling this function.  While a transfer is
+    in progress the buffer is owned by the USB module.  CDCTxService() must
+    still be called periodically to complete the transfer.
+
+  Input:
+    uint8_t length - the number of bytes to send, up to CDC_DATA_IN_EP_SIZE.
+
+ *****************************************************************************/
+void USBUSARTTxBufferSend(uint8_t length)
+{
+    USBMaskInterrupts();
+    if(cdc_trf_state == CDC_TX_READY)
+    {
+        if(length > sizeof(cdc_data_tx))
+        {
+            length = sizeof(cdc_data_tx);
+        }
+
+        cdc_tx_len = 0;
+
+        /*
+         * A full packet must be followed by a zero length packet.
+         * See explanation in USB Specification 2.0: Section 5.8.3
+         */
+        if(length == CDC_DATA_IN_EP_SIZE)
+            cdc_trf_state = CDC_TX_BUSY_ZLP;
+        else
+            cdc_trf_state = CDC_TX_COMPLETING;
+
+        CDCDataInHandle = USBTxOnePacket(CDC_DATA_EP,(uint8_t*)&cdc_data_tx,length);
+    }
+    USBUnmaskInterrupts();
+}//end USBUSARTTxBufferSend
+
 /******************************************************************************
 	Function:
 		void putsUSBUSART(char *data)
@@ -35,6 +35,8 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 #elif defined (__PIC32MX__)
     #include "p32xxxx.h"
     #include "usb_pic32.h"
+#elif defined(USB_SIMULATOR)
+    #include <usb/usb_hal_sim.h>
 #else
     #error "Error!  Unsupported processor"
 #endif
@@ -176,9 +178,12 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 /* Buffer Descriptor Table (BDT) definition
  *************************************************************************
  * These data structures define the buffer descriptor table used by the
- * USB OTG Core to manage endpoint DMA.
+ * USB OTG Core to manage endpoint DMA.  The simulated controller uses
+ * BDT_ENTRY from usb_hal_sim.h instead.
  */
 
+#if !defined(USB_SIMULATOR)
+
 /*
  * This is union describes the bitmap of
  * the Setup & Status entry in the BDT.
@@ -291,6 +296,8 @@ typedef union _BUFFER_DESCRIPTOR
 
 } BUF_DESC, *pBUF_DESC;
 
+#endif  // !defined(USB_SIMULATOR)
+
 
 /* USB_HAL_PIPE
  *************************************************************************
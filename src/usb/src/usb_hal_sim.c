@@ -0,0 +1,1375 @@
+/******************************************************************************
+
+    USB Hardware Abstraction Layer (HAL) - Simulated Host Controller
+
+Summary:
+    This file implements a simulated USB OTG module in host mode, so that the
+    host stack can be built and run on a PC.
+
+Description:
+    This file implements a simulated USB OTG module in host mode, so that the
+    host stack can be built and run on a PC.  usb_host.c is compiled with
+    USB_SIMULATOR defined; usb_hal_sim.h then maps the U1xxx registers to a
+    register file in RAM.  When the host writes a token, USBSimStep() runs
+    the transaction against the attached device model, updates the Buffer
+    Descriptor and U1STAT the same way the SIE does, and services the USB
+    interrupt by calling USB_HostInterruptHandler().  Start of frame and the
+    1ms timer are generated from a virtual clock that advances by the length
+    of each transaction on the wire, so enumeration time and throughput can
+    be measured, and a run is repeatable.
+
+    The controller answers the standard requests of the device itself, from
+    the descriptors of the model, and keeps the device address, the data
+    toggles and the halt state of the endpoints.  Device models are described
+    in usb_hal_sim.h (USB_SIM_DEVICE).
+
+    A hub model on the root port connects devices behind it with
+    USBSimHubPortAttach() once it has reset and enabled one of its ports.
+    Each token then goes to the device whose address is in U1ADDR; a low
+    speed device behind the hub only answers tokens sent with the low speed
+    bit (bit 7) of U1ADDR set.
+
+    Define USB_SIM_TRACE to print every transaction on stdout.
+
+*******************************************************************************/
+//DOM-IGNORE-BEGIN
+/******************************************************************************
+
+ File Description:
+
+ This file implements the simulated USB host controller.
+
+ Filename:        usb_hal_sim.c
+ Dependancies:    usb_host.c
+ Processor:       PC (simulation)
+ Hardware:        None
+ Compiler:        GCC, Clang
+ Company:         Microchip Technology, Inc.
+
+ Software License Agreement:
+
+ The software supplied herewith by Microchip Technology Incorporated
+ (the "Company") for its PICmicro(R) Microcontroller is intended and
+ supplied to you, the Company's customer, for use solely and
+ exclusively on Microchip PICmicro Microcontroller products. The
+ software is owned by the Company and/or its supplier, and is
+ protected under applicable copyright laws. All rights are reserved.
+ Any use in violation of the foregoing restrictions may subject the
+ user to criminal sanctions under applicable laws, as well as to
+ civil liability for the breach of the terms and conditions of this
+ license.
+
+ THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+ WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+ TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+ IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+
+********************************************************************/
+//DOM-IGNORE-END
+
+#include <stdio.h>
+#include <string.h>
+#include "usb/usb.h"
+
+#if defined(USB_SIMULATOR)
+
+//******************************************************************************
+//******************************************************************************
+// Section: Constants
+//******************************************************************************
+//******************************************************************************
+
+// Interrupt flag masks of U1IR and U1OTGIR.
+#define USB_SIM_IR_DETACH           0x01
+#define USB_SIM_IR_ERROR            0x02
+#define USB_SIM_IR_SOF              0x04
+#define USB_SIM_IR_TRANSFER         0x08
+#define USB_SIM_IR_ATTACH           0x40
+#define USB_SIM_OTGIR_T1MSEC        0x40
+#define USB_SIM_EIR_TIMEOUT         0x10
+
+#define USB_SIM_SETUP_TYPE_MASK         0x60    // bmRequestType type bits
+#define USB_SIM_SETUP_RECIPIENT_MASK    0x1F    // bmRequestType recipient bits
+
+// Bus overhead of a transaction, in bit times: SYNC, PID, address and CRC5
+// of the token, SYNC, PID and CRC16 of the data packet, the handshake
+// packet, and the turnaround and inter-packet delays.
+#define USB_SIM_TOKEN_BITS          32
+#define USB_SIM_DATA_OVERHEAD_BITS  32
+#define USB_SIM_HANDSHAKE_BITS      16
+#define USB_SIM_TURNAROUND_BITS     16
+#define USB_SIM_TIMEOUT_BITS        18
+#define USB_SIM_EOF_BITS            32      // No transaction is started this close to the end of the frame.
+
+// Control pipe stages of the simulated device.
+#define USB_SIM_CONTROL_IDLE        0
+#define USB_SIM_CONTROL_DATA_IN     1
+#define USB_SIM_CONTROL_DATA_OUT    2
+#define USB_SIM_CONTROL_STATUS_IN   3
+#define USB_SIM_CONTROL_STATUS_OUT  4
+
+//******************************************************************************
+//******************************************************************************
+// Section: Data Structures
+//******************************************************************************
+//******************************************************************************
+
+// State of an attached device, kept by the simulated controller.
+typedef struct
+{
+    USB_SIM_DEVICE          *pModel;            // Attached device model, NULL if none.
+    uint8_t                 address;            // Current device address.
+    uint8_t                 pendingAddress;     // Address set by SET_ADDRESS, used after the status stage.
+    uint8_t                 configuration;      // Current configuration, 0 if not configured.
+    bool                    inReset;            // The host is driving reset.
+    uint16_t                inToggle;           // Data toggle of the IN endpoints, one bit per endpoint.
+    uint16_t                halted[2];          // Halted endpoints, [OUT] and [IN], one bit per endpoint.
+
+    struct
+    {
+        uint8_t                 stage;          // USB_SIM_CONTROL_xxx
+        bool                    stall;          // The current request is stalled.
+        bool                    setAddress;     // The current request is SET_ADDRESS.
+        uint8_t                 toggle;         // Data toggle of the next IN packet.
+        USB_SIM_SETUP_PACKET    setup;          // Current request.
+        uint16_t                length;         // Bytes in data.
+        uint16_t                offset;         // Bytes of data already transferred.
+        uint8_t                 data[USB_SIM_CONTROL_BUFFER_SIZE];
+    } control;
+} USB_SIM_DEVICE_STATE;
+
+//******************************************************************************
+//******************************************************************************
+// Section: Global Variables
+//******************************************************************************
+//******************************************************************************
+
+USB_SIM_REGISTERS               usbSimRegisters;
+
+static USB_SIM_DEVICE_STATE     simDevices[1 + USB_SIM_HUB_PORTS];  // [0] is the root port.
+static USB_SIM_DEVICE_STATE    *pSimDevice;         // Device of the current transaction.
+static USB_SIM_STATISTICS       simStatistics;
+static uint64_t                 simTime;            // Virtual clock, in ns.
+static uint64_t                 simFrameEnd;        // End of the current frame, in ns.
+static uint32_t                 simFrameNumber;
+static bool                     simDetachPending;   // DETACHIF is latched until it is serviced.
+
+//******************************************************************************
+//******************************************************************************
+// Section: Local Prototypes
+//******************************************************************************
+//******************************************************************************
+
+static int16_t      _USBSim_ControlIn( uint8_t *data, uint16_t maxSize );
+static int16_t      _USBSim_ControlOut( const uint8_t *data, uint16_t size );
+static void         _USBSim_ControlSetup( const uint8_t *data );
+static USB_SIM_DEVICE_STATE *_USBSim_FindDevice( uint8_t address );
+static BDT_ENTRY   *_USBSim_GetOwnedBD( bool in, bool *pOdd );
+static void         _USBSim_Interrupt( uint8_t irFlags, uint8_t otgirFlags );
+static void         _USBSim_NextFrame( void );
+static void         _USBSim_ResetDevice( USB_SIM_DEVICE_STATE *pState );
+static bool         _USBSim_StandardRequest( void );
+static uint32_t     _USBSim_TransactionTime( uint16_t dataBytes, bool handshake );
+
+//******************************************************************************
+//******************************************************************************
+// Section: Application Callable Functions
+//******************************************************************************
+//******************************************************************************
+
+/****************************************************************************
+  Function:
+    void USBSimInitialize( void )
+
+  Description:
+    This function resets the simulated controller, the bus statistics and the
+    virtual clock, and detaches all devices, including those behind a hub.
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+void USBSimInitialize( void )
+{
+    memset( &usbSimRegisters, 0, sizeof(usbSimRegisters) );
+    memset( simDevices, 0, sizeof(simDevices) );
+    memset( &simStatistics, 0, sizeof(simStatistics) );
+
+    simTime             = 0;
+    simFrameEnd         = USB_SIM_FRAME_TIME;
+    simFrameNumber      = 0;
+    simDetachPending    = false;
+    pSimDevice          = &simDevices[0];
+}
+
+
+/****************************************************************************
+  Function:
+    void USBSimAttach( USB_SIM_DEVICE *pDevice )
+
+  Description:
+    This function connects a device model to the root port.  The host sees
+    the attach the next time it enables the attach interrupt.
+
+  Precondition:
+    USBSimInitialize() has been called.
+
+  Parameters:
+    USB_SIM_DEVICE *pDevice - Device model to attach
+
+  Returns:
+    None
+
+  Remarks:
+    Any device already attached is detached first.
+  ***************************************************************************/
+
+void USBSimAttach( USB_SIM_DEVICE *pDevice )
+{
+    if (simDevices[0].pModel != NULL)
+    {
+        USBSimDetach();
+    }
+
+    memset( &simDevices[0], 0, sizeof(simDevices[0]) );
+    simDevices[0].pModel    = pDevice;
+    simDetachPending        = false;
+    _USBSim_ResetDevice( &simDevices[0] );
+
+    #ifdef USB_SIM_TRACE
+        printf( "%10lu.%03lu  attach %s\n", (unsigned long)(simTime / 1000000ul),
+                (unsigned long)((simTime / 1000) % 1000), pDevice->name );
+    #endif
+}
+
+
+/****************************************************************************
+  Function:
+    void USBSimDetach( void )
+
+  Description:
+    This function disconnects the device model from the root port.
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    If the device is a hub, the devices behind it are disconnected too.
+  ***************************************************************************/
+
+void USBSimDetach( void )
+{
+    uint8_t     port;
+
+    if (simDevices[0].pModel == NULL)
+    {
+        return;
+    }
+
+    for (port = 1; port <= USB_SIM_HUB_PORTS; port++)
+    {
+        USBSimHubPortDetach( port );
+    }
+
+    #ifdef USB_SIM_TRACE
+        printf( "%10lu.%03lu  detach %s\n", (unsigned long)(simTime / 1000000ul),
+                (unsigned long)((simTime / 1000) % 1000), simDevices[0].pModel->name );
+    #endif
+
+    simDevices[0].pModel    = NULL;
+    simDetachPending        = true;
+    U1IRbits.ATTACHIF       = 0;
+}
+
+
+/****************************************************************************
+  Function:
+    void USBSimHubPortAttach( uint8_t port, USB_SIM_DEVICE *pDevice )
+
+  Description:
+    This function connects a device model behind the hub on the root port.
+    The device is in the default state, at address 0, and answers tokens
+    right away.
+
+  Precondition:
+    USBSimInitialize() has been called.
+
+  Parameters:
+    uint8_t port            - Hub port, 1 to USB_SIM_HUB_PORTS
+    USB_SIM_DEVICE *pDevice - Device model to attach
+
+  Returns:
+    None
+
+  Remarks:
+    The hub model calls this when the host has reset and enabled the port,
+    so the host never sees two devices at address 0.  Any device already on
+    the port is disconnected first.
+  ***************************************************************************/
+
+void USBSimHubPortAttach( uint8_t port, USB_SIM_DEVICE *pDevice )
+{
+    if ((port == 0) || (port > USB_SIM_HUB_PORTS))
+    {
+        return;
+    }
+
+    USBSimHubPortDetach( port );
+
+    simDevices[port].pModel = pDevice;
+    _USBSim_ResetDevice( &simDevices[port] );
+
+    #ifdef USB_SIM_TRACE
+        printf( "%10lu.%03lu  attach %s to hub port %u\n", (unsigned long)(simTime / 1000000ul),
+                (unsigned long)((simTime / 1000) % 1000), pDevice->name, port );
+    #endif
+}
+
+
+/****************************************************************************
+  Function:
+    void USBSimHubPortDetach( uint8_t port )
+
+  Description:
+    This function disconnects the device model behind the given hub port.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t port    - Hub port, 1 to USB_SIM_HUB_PORTS
+
+  Returns:
+    None
+
+  Remarks:
+    The host only learns of the detach through the hub.
+  ***************************************************************************/
+
+void USBSimHubPortDetach( uint8_t port )
+{
+    if ((port == 0) || (port > USB_SIM_HUB_PORTS) || (simDevices[port].pModel == NULL))
+    {
+        return;
+    }
+
+    #ifdef USB_SIM_TRACE
+        printf( "%10lu.%03lu  detach %s from hub port %u\n", (unsigned long)(simTime / 1000000ul),
+                (unsigned long)((simTime / 1000) % 1000), simDevices[port].pModel->name, port );
+    #endif
+
+    memset( &simDevices[port], 0, sizeof(simDevices[port]) );
+}
+
+
+/****************************************************************************
+  Function:
+    bool USBSimStep( void )
+
+  Description:
+    This function runs the next event on the simulated bus.  If the host has
+    written a token, the transaction is run with the addressed device, the
+    virtual clock advances by its length on the wire, and the transfer done
+    (or error) interrupt is serviced.  Otherwise, or if the transaction
+    would not fit in the current frame, the clock advances to the next frame
+    and the start of frame and 1ms timer interrupts are serviced.
+
+  Precondition:
+    USBSimInitialize() has been called.
+
+  Parameters:
+    None - None
+
+  Return Values:
+    true    - A transaction was run.
+    false   - The clock advanced to the next frame.
+
+  Remarks:
+    The application calls this between calls to USBHostTasks(), in place of
+    the hardware running in parallel with the CPU.  USB_HostInterruptHandler()
+    is called from here.
+  ***************************************************************************/
+
+bool USBSimStep( void )
+{
+    USB_SIM_DEVICE  *pModel;
+    BDT_ENTRY       *pBDT;
+    uint8_t         pid;
+    uint8_t         endpoint;
+    uint8_t         direction;
+    uint8_t         *pData;
+    uint16_t        size;
+    int16_t         result;
+    uint32_t        duration;
+    bool            odd;
+    bool            isochronous;
+
+    // Bus state seen by the host: the J state of a full speed device is D+
+    // high, and reset is driven for as long as USBRST is set.
+    // Only the device on the root port sees it.
+    pModel              = simDevices[0].pModel;
+    U1CONbits.JSTATE    = (pModel != NULL) && !pModel->lowSpeed;
+    if (U1CONbits.USBRST)
+    {
+        if (!simDevices[0].inReset && (pModel != NULL))
+        {
+            _USBSim_ResetDevice( &simDevices[0] );
+        }
+        simDevices[0].inReset = true;
+    }
+    else
+    {
+        simDevices[0].inReset = false;
+    }
+
+    // The attach interrupt is level triggered; the detach interrupt stays
+    // latched until it is serviced.
+    if ((pModel != NULL) && U1CONbits.HOSTEN && U1IEbits.ATTACHIE)
+    {
+        _USBSim_Interrupt( USB_SIM_IR_ATTACH, 0 );
+    }
+    if (simDetachPending && U1IEbits.DETACHIE)
+    {
+        simDetachPending = false;
+        _USBSim_Interrupt( USB_SIM_IR_DETACH, 0 );
+    }
+
+    // Find a token written by the host.  The SIE only runs a token if the
+    // host has given it a Buffer Descriptor.
+    pid         = U1TOK >> 4;
+    endpoint    = U1TOK & 0x0F;
+    pBDT        = NULL;
+    if ((pid == USB_TOKEN_SETUP) || (pid == USB_TOKEN_OUT) || (pid == USB_TOKEN_IN))
+    {
+        pBDT = _USBSim_GetOwnedBD( pid == USB_TOKEN_IN, &odd );
+    }
+    if (pBDT == NULL)
+    {
+        _USBSim_NextFrame();
+        return false;
+    }
+
+    isochronous = !U1EP0bits.EPHSHK;
+    duration    = _USBSim_TransactionTime( (pid == USB_TOKEN_IN) ? 0 : pBDT->count, !isochronous );
+    if (simTime + duration + USB_SIM_EOF_BITS * USB_SIM_FULL_SPEED_BIT_TIME > simFrameEnd)
+    {
+        // The token is held until the next frame.
+        _USBSim_NextFrame();
+        return false;
+    }
+
+    simStatistics.tokens++;
+    pData       = pBDT->ADR;
+    size        = pBDT->count;
+    direction   = (pid == USB_TOKEN_IN) ? 1 : 0;
+
+    pSimDevice  = _USBSim_FindDevice( U1ADDR );
+    if (pSimDevice == NULL)
+    {
+        // Nobody answers.  The SIE reports a bus turnaround timeout.
+        simStatistics.timeouts++;
+        duration            = _USBSim_TransactionTime( (pid == USB_TOKEN_IN) ? 0 : size, false ) +
+                                USB_SIM_TIMEOUT_BITS * USB_SIM_FULL_SPEED_BIT_TIME;
+        pBDT->STAT.Val      = 0;
+        U1EIR               = USB_SIM_EIR_TIMEOUT;
+        U1STAT              = ((direction ? 0 : 1) << 3) | ((odd ? 1 : 0) << 2);
+        simTime            += duration;
+        simStatistics.busTime += duration;
+
+        #ifdef USB_SIM_TRACE
+            printf( "%10lu.%03lu  %-5s %d.%d  timeout\n", (unsigned long)(simTime / 1000000ul),
+                    (unsigned long)((simTime / 1000) % 1000),
+                    (pid == USB_TOKEN_SETUP) ? "SETUP" : (pid == USB_TOKEN_IN) ? "IN" : "OUT",
+                    U1ADDR & 0x7F, endpoint );
+        #endif
+
+        _USBSim_Interrupt( USB_SIM_IR_TRANSFER | USB_SIM_IR_ERROR, 0 );
+        return true;
+    }
+    pModel = pSimDevice->pModel;
+
+    if (pid == USB_TOKEN_SETUP)
+    {
+        // A SETUP is always accepted, and clears a stalled control pipe.
+        _USBSim_ControlSetup( pData );
+        result = USB_SIM_ACK;
+    }
+    else if ((endpoint != 0) && (pSimDevice->halted[direction] & (1u << endpoint)))
+    {
+        result = USB_SIM_STALL;
+    }
+    else if (pid == USB_TOKEN_OUT)
+    {
+        if (endpoint == 0)
+        {
+            result = _USBSim_ControlOut( pData, size );
+        }
+        else if (pModel->Out != NULL)
+        {
+            result = pModel->Out( pModel->context, endpoint, pData, size );
+        }
+        else
+        {
+            result = USB_SIM_STALL;
+        }
+    }
+    else
+    {
+        if (endpoint == 0)
+        {
+            if ((pModel->pDeviceDescriptor != NULL) && (size > pModel->pDeviceDescriptor[7]))
+            {
+                size = pModel->pDeviceDescriptor[7];    // bMaxPacketSize0
+            }
+            result = _USBSim_ControlIn( pData, size );
+        }
+        else if (pModel->In != NULL)
+        {
+            result = pModel->In( pModel->context, endpoint, pData, size );
+        }
+        else
+        {
+            result = USB_SIM_STALL;
+        }
+
+        if (isochronous && (result == USB_SIM_NAK))
+        {
+            // An isochronous endpoint with nothing to send returns a zero
+            // length packet.
+            result = 0;
+        }
+    }
+
+    if ((result == USB_SIM_STALL) && (endpoint != 0))
+    {
+        pSimDevice->halted[direction] |= 1u << endpoint;
+    }
+
+    // Update the Buffer Descriptor and U1STAT the way the SIE does.
+    pBDT->STAT.Val = 0;
+    if (result == USB_SIM_NAK)
+    {
+        pBDT->STAT.PID = PID_NAK;
+        simStatistics.naks++;
+        duration = _USBSim_TransactionTime( (pid == USB_TOKEN_IN) ? 0 : size, true );
+    }
+    else if (result == USB_SIM_STALL)
+    {
+        pBDT->STAT.PID = PID_STALL;
+        simStatistics.stalls++;
+        duration = _USBSim_TransactionTime( (pid == USB_TOKEN_IN) ? 0 : size, true );
+    }
+    else if (pid == USB_TOKEN_IN)
+    {
+        if ((uint16_t)result > pBDT->count)
+        {
+            result = pBDT->count;
+        }
+        pBDT->count = result;
+        if (endpoint == 0)
+        {
+            pBDT->STAT.PID = pSimDevice->control.toggle ? PID_DATA1 : PID_DATA0;
+            pSimDevice->control.toggle ^= 1;
+        }
+        else
+        {
+            pBDT->STAT.PID = (pSimDevice->inToggle & (1u << endpoint)) ? PID_DATA1 : PID_DATA0;
+            pSimDevice->inToggle ^= 1u << endpoint;
+        }
+        simStatistics.bytesIn += result;
+        duration = _USBSim_TransactionTime( result, !isochronous );
+    }
+    else
+    {
+        pBDT->STAT.PID = PID_ACK;
+        simStatistics.bytesOut += size;
+    }
+
+    if (pModel->lowSpeed)
+    {
+        duration = (uint32_t)(((uint64_t)duration * USB_SIM_LOW_SPEED_BIT_TIME) / USB_SIM_FULL_SPEED_BIT_TIME);
+    }
+    U1STAT                  = ((direction ? 0 : 1) << 3) | ((odd ? 1 : 0) << 2);
+    simTime                += duration;
+    simStatistics.busTime  += duration;
+
+    #ifdef USB_SIM_TRACE
+        printf( "%10lu.%03lu  %-5s %d.%d  %-5s %u\n", (unsigned long)(simTime / 1000000ul),
+                (unsigned long)((simTime / 1000) % 1000),
+                (pid == USB_TOKEN_SETUP) ? "SETUP" : (pid == USB_TOKEN_IN) ? "IN" : "OUT",
+                U1ADDR & 0x7F, endpoint,
+                (result == USB_SIM_NAK) ? "NAK" : (result == USB_SIM_STALL) ? "STALL" :
+                (pid == USB_TOKEN_IN) ? "DATA" : "ACK",
+                (unsigned)((pid == USB_TOKEN_IN) ? ((result >= 0) ? result : 0) : size) );
+    #endif
+
+    _USBSim_Interrupt( USB_SIM_IR_TRANSFER, 0 );
+    return true;
+}
+
+
+/****************************************************************************
+  Function:
+    uint64_t USBSimGetTime( void )
+
+  Description:
+    This function returns the virtual clock, in ns since USBSimInitialize().
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Returns:
+    Virtual time, in ns
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint64_t USBSimGetTime( void )
+{
+    return simTime;
+}
+
+
+/****************************************************************************
+  Function:
+    void USBSimGetStatistics( USB_SIM_STATISTICS *pStatistics )
+
+  Description:
+    This function returns the bus statistics since USBSimInitialize().
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_SIM_STATISTICS *pStatistics - Returned statistics
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+void USBSimGetStatistics( USB_SIM_STATISTICS *pStatistics )
+{
+    *pStatistics = simStatistics;
+}
+
+
+/****************************************************************************
+  Function:
+    void USBSimSetBDTAddress( BDT_ENTRY *pBDT )
+
+  Description:
+    This function sets the Buffer Descriptor Table used by the simulated
+    controller.  It takes the place of the U1BDTPx registers, which cannot
+    hold a PC address.
+
+  Precondition:
+    None
+
+  Parameters:
+    BDT_ENTRY *pBDT - Buffer Descriptor Table
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+void USBSimSetBDTAddress( BDT_ENTRY *pBDT )
+{
+    usbSimRegisters.pBDT = pBDT;
+}
+
+
+//******************************************************************************
+//******************************************************************************
+// Section: Internal Functions
+//******************************************************************************
+//******************************************************************************
+
+/****************************************************************************
+  Function:
+    BDT_ENTRY *_USBSim_GetOwnedBD( bool in, bool *pOdd )
+
+  Description:
+    This function returns the EP0 Buffer Descriptor of the given direction
+    that the host has handed to the SIE, using the same table layout as
+    usb_host.c for the configured ping-pong mode.
+
+  Precondition:
+    None
+
+  Parameters:
+    bool in     - true for the IN Buffer Descriptor, false for OUT
+    bool *pOdd  - Returns true if the odd Buffer Descriptor was found
+
+  Returns:
+    The Buffer Descriptor, or NULL if the SIE does not own one.
+
+  Remarks:
+    usb_host.c keeps track of the ping-pong buffers itself, and only gives
+    one Buffer Descriptor to the SIE at a time.
+  ***************************************************************************/
+
+static BDT_ENTRY *_USBSim_GetOwnedBD( bool in, bool *pOdd )
+{
+    BDT_ENTRY   *pEven;
+    BDT_ENTRY   *pOddBD;
+
+    if (usbSimRegisters.pBDT == NULL)
+    {
+        return NULL;
+    }
+
+    #if (USB_PING_PONG_MODE == USB_PING_PONG__FULL_PING_PONG)
+        pEven   = &usbSimRegisters.pBDT[in ? 0 : 2];
+        pOddBD  = &usbSimRegisters.pBDT[in ? 1 : 3];
+    #elif (USB_PING_PONG_MODE == USB_PING_PONG__EP0_OUT_ONLY)
+        pEven   = &usbSimRegisters.pBDT[in ? 0 : 1];
+        pOddBD  = in ? NULL : &usbSimRegisters.pBDT[2];
+    #else
+        pEven   = &usbSimRegisters.pBDT[in ? 0 : 1];
+        pOddBD  = NULL;
+    #endif
+
+    *pOdd = false;
+    if (pEven->STAT.UOWN)
+    {
+        return pEven;
+    }
+    if ((pOddBD != NULL) && pOddBD->STAT.UOWN)
+    {
+        *pOdd = true;
+        return pOddBD;
+    }
+    return NULL;
+}
+
+
+/****************************************************************************
+  Function:
+    void _USBSim_Interrupt( uint8_t irFlags, uint8_t otgirFlags )
+
+  Description:
+    This function raises interrupt flags and services the USB interrupt if
+    any of them is enabled.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t irFlags     - U1IR flags to raise
+    uint8_t otgirFlags  - U1OTGIR flags to raise
+
+  Returns:
+    None
+
+  Remarks:
+    The flags are written into U1IR and U1OTGIR before the interrupt handler
+    runs, and cleared afterwards, except for the level triggered attach
+    flag.  This takes the place of the write-one-to-clear behaviour of the
+    hardware, which a plain variable cannot copy.
+  ***************************************************************************/
+
+static void _USBSim_Interrupt( uint8_t irFlags, uint8_t otgirFlags )
+{
+    uint8_t     attach;
+
+    attach  = ((simDevices[0].pModel != NULL) && U1CONbits.HOSTEN) ? USB_SIM_IR_ATTACH : 0;
+    U1IR    = irFlags | attach;
+    U1OTGIR = otgirFlags;
+
+    if ((U1IR & U1IE) || (U1OTGIR & U1OTGIE))
+    {
+        USB_HostInterruptHandler();
+    }
+
+    U1IR    = attach;
+    U1OTGIR = 0;
+    U1EIR   = 0;
+}
+
+
+/****************************************************************************
+  Function:
+    void _USBSim_NextFrame( void )
+
+  Description:
+    This function advances the virtual clock to the start of the next frame,
+    and services the start of frame and 1ms timer interrupts.
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static void _USBSim_NextFrame( void )
+{
+    USB_SIM_DEVICE  *pModel;
+    uint8_t         irFlags;
+    uint8_t         i;
+
+    simTime      = simFrameEnd;
+    simFrameEnd += USB_SIM_FRAME_TIME;
+    simFrameNumber++;
+    simStatistics.frames++;
+
+    irFlags = 0;
+    if (U1CONbits.SOFEN)
+    {
+        irFlags = USB_SIM_IR_SOF;
+
+        for (i = 0; i < 1 + USB_SIM_HUB_PORTS; i++)
+        {
+            pModel = simDevices[i].pModel;
+            if ((pModel != NULL) && !simDevices[i].inReset && (pModel->Frame != NULL))
+            {
+                pModel->Frame( pModel->context, simFrameNumber );
+            }
+        }
+    }
+
+    _USBSim_Interrupt( irFlags, USB_SIM_OTGIR_T1MSEC );
+}
+
+
+/****************************************************************************
+  Function:
+    uint32_t _USBSim_TransactionTime( uint16_t dataBytes, bool handshake )
+
+  Description:
+    This function returns the time a full speed transaction takes on the
+    wire.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint16_t dataBytes  - Bytes in the data packet
+    bool handshake      - The transaction has a handshake packet
+
+  Returns:
+    Transaction time, in ns
+
+  Remarks:
+    Bit stuffing is not counted.
+  ***************************************************************************/
+
+static uint32_t _USBSim_TransactionTime( uint16_t dataBytes, bool handshake )
+{
+    uint32_t    bits;
+
+    bits = USB_SIM_TOKEN_BITS + USB_SIM_DATA_OVERHEAD_BITS + 8ul * dataBytes + USB_SIM_TURNAROUND_BITS;
+    if (handshake)
+    {
+        bits += USB_SIM_HANDSHAKE_BITS + USB_SIM_TURNAROUND_BITS;
+    }
+
+    return bits * USB_SIM_FULL_SPEED_BIT_TIME;
+}
+
+
+/****************************************************************************
+  Function:
+    void _USBSim_ResetDevice( USB_SIM_DEVICE_STATE *pState )
+
+  Description:
+    This function puts an attached device into the default state after a
+    bus reset or attach.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_SIM_DEVICE_STATE *pState    - The device
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static void _USBSim_ResetDevice( USB_SIM_DEVICE_STATE *pState )
+{
+    pState->address             = 0;
+    pState->pendingAddress      = 0;
+    pState->configuration       = 0;
+    pState->inToggle            = 0;
+    pState->halted[0]           = 0;
+    pState->halted[1]           = 0;
+    pState->control.stage       = USB_SIM_CONTROL_IDLE;
+    pState->control.stall       = false;
+
+    if ((pState->pModel != NULL) && (pState->pModel->Reset != NULL))
+    {
+        pState->pModel->Reset( pState->pModel->context );
+    }
+}
+
+
+/****************************************************************************
+  Function:
+    USB_SIM_DEVICE_STATE *_USBSim_FindDevice( uint8_t address )
+
+  Description:
+    This function returns the device that answers a token sent to the given
+    address.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t address - Contents of U1ADDR
+
+  Returns:
+    The device, or NULL if no device answers.
+
+  Remarks:
+    The device on the root port ignores the low speed bit.  Behind the hub
+    the bit selects the low speed devices, which do not see full speed
+    traffic.
+  ***************************************************************************/
+
+static USB_SIM_DEVICE_STATE *_USBSim_FindDevice( uint8_t address )
+{
+    USB_SIM_DEVICE_STATE    *pState;
+    uint8_t                 i;
+
+    for (i = 0; i < 1 + USB_SIM_HUB_PORTS; i++)
+    {
+        pState = &simDevices[i];
+        if ((pState->pModel == NULL) || pState->inReset || ((address & 0x7F) != pState->address))
+        {
+            continue;
+        }
+        if ((i != 0) && (pState->pModel->lowSpeed != ((address & 0x80) != 0)))
+        {
+            continue;
+        }
+        return pState;
+    }
+
+    return NULL;
+}
+
+
+/****************************************************************************
+  Function:
+    void _USBSim_ControlSetup( const uint8_t *data )
+
+  Description:
+    This function starts a control request on the addressed device.  Standard
+    requests are answered by the simulated controller where it can; all other
+    requests, such as class and vendor requests or GET_DESCRIPTOR for a class
+    descriptor, are passed to the device model.
+
+  Precondition:
+    A device is attached.
+
+  Parameters:
+    const uint8_t *data - The 8 byte SETUP packet
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static void _USBSim_ControlSetup( const uint8_t *data )
+{
+    USB_SIM_DEVICE          *pModel;
+    USB_SIM_SETUP_PACKET    *pSetup;
+    int16_t                 result;
+
+    pModel  = pSimDevice->pModel;
+    pSetup  = &pSimDevice->control.setup;
+
+    pSetup->bmRequestType   = data[0];
+    pSetup->bRequest        = data[1];
+    pSetup->wValue          = data[2] | ((uint16_t)data[3] << 8);
+    pSetup->wIndex          = data[4] | ((uint16_t)data[5] << 8);
+    pSetup->wLength         = data[6] | ((uint16_t)data[7] << 8);
+
+    pSimDevice->control.stall         = false;
+    pSimDevice->control.setAddress    = false;
+    pSimDevice->control.toggle        = 1;
+    pSimDevice->control.length        = 0;
+    pSimDevice->control.offset        = 0;
+
+    if (((pSetup->bmRequestType & USB_SIM_SETUP_TYPE_MASK) == USB_SETUP_TYPE_STANDARD) &&
+        _USBSim_StandardRequest())
+    {
+        // Answered from the descriptors.
+    }
+    else if (pSetup->bmRequestType & USB_SETUP_DEVICE_TO_HOST)
+    {
+        result = USB_SIM_STALL;
+        if (pModel->Request != NULL)
+        {
+            result = pModel->Request( pModel->context, pSetup, pSimDevice->control.data );
+        }
+
+        if (result < 0)
+        {
+            pSimDevice->control.stall = true;
+        }
+        else
+        {
+            pSimDevice->control.length = result;
+        }
+    }
+    else if (pSetup->wLength == 0)
+    {
+        // No data stage.  Run the request now, the host asks for the status.
+        result = USB_SIM_STALL;
+        if (pModel->Request != NULL)
+        {
+            result = pModel->Request( pModel->context, pSetup, pSimDevice->control.data );
+        }
+        pSimDevice->control.stall = (result < 0);
+    }
+
+    if (pSetup->bmRequestType & USB_SETUP_DEVICE_TO_HOST)
+    {
+        if (pSimDevice->control.length > pSetup->wLength)
+        {
+            pSimDevice->control.length = pSetup->wLength;
+        }
+        pSimDevice->control.stage = USB_SIM_CONTROL_DATA_IN;
+    }
+    else if (pSetup->wLength != 0)
+    {
+        pSimDevice->control.stage = USB_SIM_CONTROL_DATA_OUT;
+    }
+    else
+    {
+        pSimDevice->control.stage = USB_SIM_CONTROL_STATUS_IN;
+    }
+}
+
+
+/****************************************************************************
+  Function:
+    int16_t _USBSim_ControlIn( uint8_t *data, uint16_t maxSize )
+
+  Description:
+    This function answers an IN token on endpoint 0.
+
+  Precondition:
+    A device is attached.
+
+  Parameters:
+    uint8_t *data       - Where to put the packet
+    uint16_t maxSize    - Maximum packet size
+
+  Returns:
+    The packet length, or USB_SIM_STALL.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static int16_t _USBSim_ControlIn( uint8_t *data, uint16_t maxSize )
+{
+    uint16_t    size;
+
+    if (pSimDevice->control.stall)
+    {
+        return USB_SIM_STALL;
+    }
+
+    switch (pSimDevice->control.stage)
+    {
+        case USB_SIM_CONTROL_DATA_IN:
+            size = pSimDevice->control.length - pSimDevice->control.offset;
+            if (size > maxSize)
+            {
+                size = maxSize;
+            }
+            memcpy( data, &pSimDevice->control.data[pSimDevice->control.offset], size );
+            pSimDevice->control.offset += size;
+            return size;
+            break;
+
+        case USB_SIM_CONTROL_STATUS_IN:
+            // Zero length status packet, always DATA1.  A new address takes
+            // effect once the status stage of SET_ADDRESS is complete.
+            pSimDevice->control.toggle    = 1;
+            pSimDevice->control.stage     = USB_SIM_CONTROL_IDLE;
+            if (pSimDevice->control.setAddress)
+            {
+                pSimDevice->address = pSimDevice->pendingAddress;
+            }
+            return 0;
+            break;
+
+        default:
+            break;
+    }
+
+    return USB_SIM_STALL;
+}
+
+
+/****************************************************************************
+  Function:
+    int16_t _USBSim_ControlOut( const uint8_t *data, uint16_t size )
+
+  Description:
+    This function answers an OUT token on endpoint 0.
+
+  Precondition:
+    A device is attached.
+
+  Parameters:
+    const uint8_t *data - Packet data
+    uint16_t size       - Packet length
+
+  Returns:
+    USB_SIM_ACK or USB_SIM_STALL.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static int16_t _USBSim_ControlOut( const uint8_t *data, uint16_t size )
+{
+    USB_SIM_DEVICE  *pModel;
+    int16_t         result;
+
+    if (pSimDevice->control.stall)
+    {
+        return USB_SIM_STALL;
+    }
+
+    switch (pSimDevice->control.stage)
+    {
+        case USB_SIM_CONTROL_DATA_OUT:
+            if (pSimDevice->control.offset + size <= USB_SIM_CONTROL_BUFFER_SIZE)
+            {
+                memcpy( &pSimDevice->control.data[pSimDevice->control.offset], data, size );
+            }
+            pSimDevice->control.offset += size;
+
+            if (pSimDevice->control.offset >= pSimDevice->control.setup.wLength)
+            {
+                // The data stage is complete, run the request.
+                pModel = pSimDevice->pModel;
+                result = USB_SIM_STALL;
+                if (pModel->Request != NULL)
+                {
+                    result = pModel->Request( pModel->context, &pSimDevice->control.setup, pSimDevice->control.data );
+                }
+                pSimDevice->control.stage = USB_SIM_CONTROL_STATUS_IN;
+                pSimDevice->control.stall = (result < 0);
+            }
+            return USB_SIM_ACK;
+            break;
+
+        case USB_SIM_CONTROL_DATA_IN:
+        case USB_SIM_CONTROL_STATUS_OUT:
+            // Status stage of a control read.
+            pSimDevice->control.stage = USB_SIM_CONTROL_IDLE;
+            return USB_SIM_ACK;
+            break;
+
+        default:
+            break;
+    }
+
+    return USB_SIM_STALL;
+}
+
+
+/****************************************************************************
+  Function:
+    bool _USBSim_StandardRequest( void )
+
+  Description:
+    This function answers the standard request in the current SETUP packet.
+
+  Precondition:
+    The SETUP packet has been decoded into pSimDevice->control.setup.
+
+  Parameters:
+    None - None
+
+  Return Values:
+    true    - The request is supported.  For a device to host request, the
+                data is in pSimDevice->control.data.
+    false   - The request is not handled here, pass it to the model.
+
+  Remarks:
+    CLEAR_FEATURE(ENDPOINT_HALT) is also passed to the Request() function
+    of the model, if there is one, so that it can recover from the stall.
+  ***************************************************************************/
+
+static bool _USBSim_StandardRequest( void )
+{
+    USB_SIM_DEVICE          *pModel;
+    USB_SIM_SETUP_PACKET    *pSetup;
+    const uint8_t           *pDescriptor;
+    uint8_t                 endpoint;
+    uint8_t                 direction;
+    uint16_t                length;
+
+    pModel      = pSimDevice->pModel;
+    pSetup      = &pSimDevice->control.setup;
+    endpoint    = pSetup->wIndex & 0x0F;
+    direction   = (pSetup->wIndex & 0x80) ? 1 : 0;
+
+    switch (pSetup->bRequest)
+    {
+        case USB_REQUEST_GET_DESCRIPTOR:
+            pDescriptor = NULL;
+            length      = 0;
+            switch (pSetup->wValue >> 8)
+            {
+                case USB_DESCRIPTOR_DEVICE:
+                    pDescriptor = pModel->pDeviceDescriptor;
+                    length      = (pDescriptor != NULL) ? pDescriptor[0] : 0;
+                    break;
+
+                case USB_DESCRIPTOR_CONFIGURATION:
+                    pDescriptor = pModel->pConfigurationDescriptor;
+                    length      = (pDescriptor != NULL) ? (pDescriptor[2] | ((uint16_t)pDescriptor[3] << 8)) : 0;
+                    break;
+
+                case USB_DESCRIPTOR_STRING:
+                    if ((pSetup->wValue & 0xFF) < pModel->numStringDescriptors)
+                    {
+                        pDescriptor = pModel->pStringDescriptors[pSetup->wValue & 0xFF];
+                        length      = pDescriptor[0];
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+
+            if (pDescriptor == NULL)
+            {
+                return false;
+            }
+            if (length > USB_SIM_CONTROL_BUFFER_SIZE)
+            {
+                length = USB_SIM_CONTROL_BUFFER_SIZE;
+            }
+            memcpy( pSimDevice->control.data, pDescriptor, length );
+            pSimDevice->control.length = length;
+            return true;
+            break;
+
+        case USB_REQUEST_SET_ADDRESS:
+            pSimDevice->pendingAddress        = pSetup->wValue & 0x7F;
+            pSimDevice->control.setAddress    = true;
+            return true;
+            break;
+
+        case USB_REQUEST_SET_CONFIGURATION:
+            if ((pSetup->wValue & 0xFF) > 1)
+            {
+                return false;
+            }
+            pSimDevice->configuration = pSetup->wValue & 0xFF;
+            pSimDevice->inToggle      = 0;
+            pSimDevice->halted[0]     = 0;
+            pSimDevice->halted[1]     = 0;
+            return true;
+            break;
+
+        case USB_REQUEST_GET_CONFIGURATION:
+            pSimDevice->control.data[0]   = pSimDevice->configuration;
+            pSimDevice->control.length    = 1;
+            return true;
+            break;
+
+        case USB_REQUEST_SET_INTERFACE:
+            pSimDevice->inToggle = 0;
+            return true;
+            break;
+
+        case USB_REQUEST_GET_INTERFACE:
+            pSimDevice->control.data[0]   = 0;
+            pSimDevice->control.length    = 1;
+            return true;
+            break;
+
+        case USB_REQUEST_GET_STATUS:
+            pSimDevice->control.data[0]   = 0;
+            pSimDevice->control.data[1]   = 0;
+            if ((pSetup->bmRequestType & USB_SIM_SETUP_RECIPIENT_MASK) == USB_SETUP_RECIPIENT_ENDPOINT)
+            {
+                pSimDevice->control.data[0] = (pSimDevice->halted[direction] >> endpoint) & 0x01;
+            }
+            pSimDevice->control.length    = 2;
+            return true;
+            break;
+
+        case USB_REQUEST_CLEAR_FEATURE:
+        case USB_REQUEST_SET_FEATURE:
+            if (((pSetup->bmRequestType & USB_SIM_SETUP_RECIPIENT_MASK) == USB_SETUP_RECIPIENT_ENDPOINT) &&
+                (pSetup->wValue == USB_FEATURE_ENDPOINT_HALT))
+            {
+                if (pSetup->bRequest == USB_REQUEST_SET_FEATURE)
+                {
+                    pSimDevice->halted[direction] |= 1u << endpoint;
+                }
+                else
+                {
+                    pSimDevice->halted[direction] &= ~(1u << endpoint);
+                    if (direction)
+                    {
+                        pSimDevice->inToggle &= ~(1u << endpoint);
+                    }
+                    if (pModel->Request != NULL)
+                    {
+                        pModel->Request( pModel->context, pSetup, pSimDevice->control.data );
+                    }
+                }
+            }
+            return true;
+            break;
+
+        default:
+            break;
+    }
+
+    return false;
+}
+
+#endif  // USB_SIMULATOR
@@ -68,10 +68,6 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 
 #define USB_FREE_AND_CLEAR(ptr) {USB_FREE(ptr); ptr = NULL;}
 
-#if defined( USB_ENABLE_TRANSFER_EVENT )
-    #include "usb/usb_struct_queue.h"
-#endif
-
 // *****************************************************************************
 // Low Level Functionality Configurations.
 
@@ -143,27 +139,22 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
     extern BDT_ENTRY BDT[] __attribute__ ((aligned (512)));
 #endif
 
-// These should all be moved into the USB_DEVICE_INFO structure.
-static uint8_t                          countConfigurations;                        // Count the Configuration Descriptors read during enumeration.
-static uint8_t                          numCommandTries;                            // The number of times the current command has been tried.
-static uint8_t                          numEnumerationTries;                        // The number of times enumeration has been attempted on the attached device.
 static volatile uint16_t                 numTimerInterrupts;                         // The number of milliseconds elapsed during the current waiting period.
 static volatile USB_ENDPOINT_INFO   *pCurrentEndpoint;                           // Pointer to the endpoint currently performing a transfer.
-uint8_t                                *pCurrentConfigurationDescriptor    = NULL;  // Pointer to the current configuration descriptor of the attached device.
-uint8_t                                *pDeviceDescriptor                  = NULL;  // Pointer to the Device Descriptor of the attached device.
-static uint8_t                         *pEP0Data                           = NULL;  // A data buffer for use by EP0.
-static volatile uint16_t                 usbHostState;                               // State machine state of the attached device.
-volatile uint16_t                 usbOverrideHostState;                       // Next state machine state, when set by interrupt processing.
+static USB_DEVICE_INFO * volatile    pCurrentEndpointDevice;                     // Device that owns pCurrentEndpoint.
+static USB_DEVICE_INFO              *pCurrentDevice;                             // Device whose state machine USBHostTasks() is running.
+volatile uint16_t                 usbOverrideHostState;                       // Next state machine state of the root port device, when set by interrupt processing.
 #ifdef ENABLE_STATE_TRACE   // Debug trace support
     static uint16_t prevHostState;
 #endif
 
 static USB_BUS_INFO                  usbBusInfo;                                 // Information about the USB bus.
-static USB_DEVICE_INFO               usbDeviceInfo;                              // A collection of information about the attached device.
+static USB_DEVICE_INFO               usbDeviceInfo[USB_MAX_DEVICES];             // The root port device, then the devices behind the hub.
 #if defined( USB_ENABLE_TRANSFER_EVENT )
     static USB_EVENT_QUEUE           usbEventQueue;                              // Queue of USB events used to synchronize ISR to main tasks loop.
 #endif
 static USB_ROOT_HUB_INFO             usbRootHubInfo;                             // Information about a specific port.
+static uint32_t                      usbEnumerationMemory[USB_MAX_DEVICES][(USB_ENUMERATION_ARENA_SIZE + 3) / 4];   // Descriptors and configuration lists of each device.
 
 static volatile uint16_t msec_count = 0;                                             // The current millisecond count.
 
@@ -204,15 +195,17 @@ static volatile uint16_t msec_count = 0;
 
 uint8_t USBHostClearEndpointErrors( uint8_t deviceAddress, uint8_t endpoint )
 {
+    USB_DEVICE_INFO   *pDevice;
     USB_ENDPOINT_INFO *ep;
 
     // Find the required device
-    if (deviceAddress != usbDeviceInfo.deviceAddress)
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
     {
         return USB_UNKNOWN_DEVICE;
     }
 
-    ep = _USB_FindEndpoint( endpoint );
+    ep = _USB_FindEndpoint( pDevice, endpoint );
 
     if (ep != NULL)
     {
@@ -273,7 +266,14 @@ uint8_t USBHostClearEndpointErrors( uint8_t deviceAddress, uint8_t endpoint )
 
 bool    USBHostDeviceSpecificClientDriver( uint8_t deviceAddress )
 {
-    return usbDeviceInfo.flags.bfUseDeviceClientDriver;
+    USB_DEVICE_INFO *pDevice;
+
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
+    {
+        return false;
+    }
+    return pDevice->flags.bfUseDeviceClientDriver;
 }
 
 
@@ -298,7 +298,7 @@ bool    USBHostDeviceSpecificClientDriver( uint8_t deviceAddress )
     USB_DEVICE_ATTACHED                 - Device is attached and running
     USB_DEVICE_DETACHED                 - No device is attached
     USB_DEVICE_ENUMERATING              - Device is enumerating
-    USB_HOLDING_OUT_OF_MEMORY           - Not enough heap space available
+    USB_HOLDING_OUT_OF_MEMORY           - Not enough enumeration memory available
     USB_HOLDING_UNSUPPORTED_DEVICE      - Invalid configuration or
                                             unsupported class
     USB_HOLDING_UNSUPPORTED_HUB         - Hubs are not supported
@@ -317,14 +317,28 @@ bool    USBHostDeviceSpecificClientDriver( uint8_t deviceAddress )
 
 uint8_t USBHostDeviceStatus( uint8_t deviceAddress )
 {
-    if ((usbHostState & STATE_MASK) == STATE_DETACHED)
+    USB_DEVICE_INFO *pDevice;
+
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
+    {
+        // The device on the root port is always given the first address,
+        // but it does not have it until it has been addressed.
+        if (deviceAddress != USB_SINGLE_DEVICE_ADDRESS)
+        {
+            return USB_DEVICE_DETACHED;
+        }
+        pDevice = USB_ROOT_DEVICE;
+    }
+
+    if ((pDevice->state & STATE_MASK) == STATE_DETACHED)
     {
         return USB_DEVICE_DETACHED;
     }
 
-    if ((usbHostState & STATE_MASK) == STATE_RUNNING)
+    if ((pDevice->state & STATE_MASK) == STATE_RUNNING)
     {
-        if ((usbHostState & SUBSTATE_MASK) == SUBSTATE_SUSPEND_AND_RESUME)
+        if ((pDevice->state & SUBSTATE_MASK) == SUBSTATE_SUSPEND_AND_RESUME)
         {
             return USB_DEVICE_SUSPENDED;
         }
@@ -334,14 +348,356 @@ uint8_t USBHostDeviceStatus( uint8_t deviceAddress )
         }
     }
 
-    if ((usbHostState & STATE_MASK) == STATE_HOLDING)
+    if ((pDevice->state & STATE_MASK) == STATE_HOLDING)
     {
-        return usbDeviceInfo.errorCode;
+        return pDevice->errorCode;
     }
 
     return USB_DEVICE_ENUMERATING;
 }
 
+/****************************************************************************
+  Function:
+    uint8_t * USBHostGetCurrentConfigurationDescriptor( uint8_t deviceAddress )
+
+  Description:
+    This function returns a pointer to the current configuration descriptor
+    of the requested device.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress  - Address of device
+
+  Returns:
+    uint8_t *  - Pointer to the Configuration Descriptor, or NULL if the
+                device is not attached.
+
+  Remarks:
+    During enumeration, this is the configuration being set up, so client
+    drivers can read it from their initialization routines.
+  ***************************************************************************/
+
+uint8_t * USBHostGetCurrentConfigurationDescriptor( uint8_t deviceAddress )
+{
+    USB_DEVICE_INFO     *pDevice;
+
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
+    {
+        return NULL;
+    }
+
+    return pDevice->pCurrentConfigurationDescriptor;
+}
+
+
+/****************************************************************************
+  Function:
+    uint8_t * USBHostGetDeviceDescriptor( uint8_t deviceAddress )
+
+  Description:
+    This function returns a pointer to the device descriptor of the
+    requested device.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress  - Address of device
+
+  Returns:
+    uint8_t *  - Pointer to the Device Descriptor, or NULL if the device is
+                not attached.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint8_t * USBHostGetDeviceDescriptor( uint8_t deviceAddress )
+{
+    USB_DEVICE_INFO     *pDevice;
+
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
+    {
+        return NULL;
+    }
+
+    return pDevice->pDeviceDescriptor;
+}
+
+
+/****************************************************************************
+  Function:
+    void USBHostGetEnumerationMemoryStats( USB_ENUMERATION_MEMORY_STATS *stats )
+
+  Description:
+    This function returns the current and high-water use of the memory
+    that holds the descriptors and configuration lists of the device on the
+    root port.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_ENUMERATION_MEMORY_STATS *stats - Filled in with the statistics
+
+  Returns:
+    None
+
+  Remarks:
+    If a device is holding with USB_HOLDING_OUT_OF_MEMORY,
+    failedAllocations will be non-zero; increase
+    USB_ENUMERATION_ARENA_SIZE.  Each device behind the hub has an arena
+    of the same size.
+  ***************************************************************************/
+
+void USBHostGetEnumerationMemoryStats( USB_ENUMERATION_MEMORY_STATS *stats )
+{
+    stats->size                 = USB_ENUMERATION_ARENA_SIZE;
+    stats->used                 = USB_ROOT_DEVICE->arena.top;
+    stats->highWater            = USB_ROOT_DEVICE->arena.highWater;
+    stats->failedAllocations    = USB_ROOT_DEVICE->arena.failedAllocations;
+}
+
+
+/****************************************************************************
+  Function:
+    void USBHostGetEventQueueStats( USB_EVENT_QUEUE_STATS *stats )
+
+  Description:
+    This function returns the high-water mark and overflow count of the
+    transfer event queue.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_EVENT_QUEUE_STATS *stats - Filled in with the statistics
+
+  Returns:
+    None
+
+  Remarks:
+    Only available if USB_ENABLE_TRANSFER_EVENT is defined.
+  ***************************************************************************/
+
+#if defined( USB_ENABLE_TRANSFER_EVENT )
+void USBHostGetEventQueueStats( USB_EVENT_QUEUE_STATS *stats )
+{
+    stats->depth        = USB_EVENT_QUEUE_DEPTH;
+    stats->highWater    = usbEventQueue.highWater;
+    stats->overflows    = usbEventQueue.overflows;
+}
+#endif
+
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostGetFrameNumber( void )
+
+  Description:
+    This function returns the number of frames that have started since the
+    host was initialized, modulo 65536.
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Returns:
+    The frame counter
+
+  Remarks:
+    The counter advances once per millisecond while the bus is running.
+    Class drivers use differences of it to measure transfer latency.
+  ***************************************************************************/
+
+uint16_t USBHostGetFrameNumber( void )
+{
+    return usbBusInfo.frameNumber;
+}
+
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostHubPortAttach( uint8_t hubAddress, uint8_t port,
+                bool lowSpeed )
+
+  Summary:
+    This function starts the enumeration of a device behind the hub.
+
+  Description:
+    This function is called by the hub client driver once a hub port has
+    been reset and the device on it is waiting at address 0.  The device
+    gets an entry in the device table and is enumerated by USBHostTasks()
+    like the device on the root port: it is given the next free address,
+    configured, and handed to its client drivers, which are sent the
+    device's own address.
+
+  Precondition:
+    USBHostHubPortBusy() is false.  The port was reset after that was
+    checked.
+
+  Parameters:
+    uint8_t hubAddress - Address of the hub
+    uint8_t port       - Port number on the hub, starting at 1
+    bool lowSpeed      - The device on the port is low speed
+
+  Return Values:
+    USB_SUCCESS         - Enumeration has started
+    USB_UNKNOWN_DEVICE  - The hub is not attached
+    USB_BUSY            - Another device is at address 0, or the device
+                            table is full; try again later
+
+  Remarks:
+    Only available if USB_HUB_SUPPORT_INCLUDED is defined.  The device is
+    not reset again if enumeration fails; it is held with
+    USB_CANNOT_ENUMERATE until USBHostHubPortDetach() is called.
+  ***************************************************************************/
+
+#if defined( USB_HUB_SUPPORT_INCLUDED )
+uint8_t USBHostHubPortAttach( uint8_t hubAddress, uint8_t port, bool lowSpeed )
+{
+    USB_DEVICE_INFO     *pSavedDevice;
+    uint8_t             i;
+
+    if (_USB_FindDevice( hubAddress ) == NULL)
+    {
+        return USB_UNKNOWN_DEVICE;
+    }
+
+    // Only one device can be at address 0.
+    if (USBHostHubPortBusy())
+    {
+        return USB_BUSY;
+    }
+
+    for (i=1; (i<USB_MAX_DEVICES) && (usbDeviceInfo[i].hubAddress != 0); i++) {}
+    if (i == USB_MAX_DEVICES)
+    {
+        return USB_BUSY;
+    }
+
+    pSavedDevice    = pCurrentDevice;
+    pCurrentDevice  = &usbDeviceInfo[i];
+
+    // Start from an empty arena and a clean EP0, as a reset of the root
+    // port does.
+    _USB_FreeMemory();
+    _USB_InitDevice();
+    pCurrentDevice->pEP0Data = (uint8_t *)_USB_AllocEnumerationMemory( 8 );
+    _USB_InitErrorCounters();
+
+    pCurrentDevice->flags.bfIsLowSpeed      = lowSpeed;
+    pCurrentDevice->deviceAddressAndSpeed   = lowSpeed ? 0x80 : 0x00;
+    pCurrentDevice->state                   = STATE_ATTACHED | SUBSTATE_GET_DEVICE_DESCRIPTOR_SIZE;
+    pCurrentDevice->hubPort                 = port;
+
+    // The entry is in use, and seen by the interrupt, once the hub address
+    // is set.
+    pCurrentDevice->hubAddress              = hubAddress;
+
+    pCurrentDevice = pSavedDevice;
+    return USB_SUCCESS;
+}
+#endif
+
+
+/****************************************************************************
+  Function:
+    bool USBHostHubPortBusy( void )
+
+  Summary:
+    This function tells whether a device behind the hub is at address 0.
+
+  Description:
+    This function tells whether a device behind the hub is still at address
+    0.  A hub port must not be reset while this is true, since two devices
+    would then answer at address 0.
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Return Values:
+    true    - A device behind the hub has not been given an address yet
+    false   - Another hub port can be reset
+
+  Remarks:
+    Only available if USB_HUB_SUPPORT_INCLUDED is defined.  A device that
+    fails enumeration before it has an address keeps this true until its
+    port is detached.
+  ***************************************************************************/
+
+#if defined( USB_HUB_SUPPORT_INCLUDED )
+bool USBHostHubPortBusy( void )
+{
+    uint8_t     i;
+
+    for (i=1; i<USB_MAX_DEVICES; i++)
+    {
+        if ((usbDeviceInfo[i].hubAddress != 0) && ((usbDeviceInfo[i].deviceAddressAndSpeed & 0x7F) == 0))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+#endif
+
+
+/****************************************************************************
+  Function:
+    void USBHostHubPortDetach( uint8_t hubAddress, uint8_t port )
+
+  Summary:
+    This function removes the device behind a hub port.
+
+  Description:
+    This function is called by the hub client driver when the device on a
+    hub port is removed, or the port is disabled.  The client drivers of
+    the device are sent EVENT_DETACH and its entry in the device table is
+    released.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t hubAddress - Address of the hub
+    uint8_t port       - Port number on the hub, starting at 1
+
+  Returns:
+    None
+
+  Remarks:
+    Only available if USB_HUB_SUPPORT_INCLUDED is defined.  Nothing is done
+    if no device was attached through the port.
+  ***************************************************************************/
+
+#if defined( USB_HUB_SUPPORT_INCLUDED )
+void USBHostHubPortDetach( uint8_t hubAddress, uint8_t port )
+{
+    uint8_t     i;
+
+    for (i=1; i<USB_MAX_DEVICES; i++)
+    {
+        if ((hubAddress != 0) && (usbDeviceInfo[i].hubAddress == hubAddress) &&
+            (usbDeviceInfo[i].hubPort == port))
+        {
+            _USB_DetachHubDevice( &usbDeviceInfo[i] );
+        }
+    }
+}
+#endif
+
+
 /****************************************************************************
   Function:
     bool USBHostInit(  unsigned long flags  )
@@ -374,36 +730,50 @@ uint8_t USBHostDeviceStatus( uint8_t deviceAddress )
 
 bool USBHostInit(  unsigned long flags  )
 {
-    // Allocate space for Endpoint 0.  We will initialize it in the state machine,
-    // so we can reinitialize when another device connects.  If the Endpoint 0
-    // node already exists, free all other allocated memory.
-    if (usbDeviceInfo.pEndpoint0 == NULL)
+    uint8_t i;
+
+    // Allocate space for Endpoint 0 of every device table entry.  We will
+    // initialize it in the state machine, so we can reinitialize when another
+    // device connects.  If the Endpoint 0 node already exists, free all other
+    // allocated memory.
+    for (i=0; i<USB_MAX_DEVICES; i++)
     {
-        if ((usbDeviceInfo.pEndpoint0 = (USB_ENDPOINT_INFO*)USB_MALLOC( sizeof(USB_ENDPOINT_INFO) )) == NULL)
+        pCurrentDevice = &usbDeviceInfo[i];
+        if (pCurrentDevice->pEndpoint0 == NULL)
         {
+            if ((pCurrentDevice->pEndpoint0 = (USB_ENDPOINT_INFO*)USB_MALLOC( sizeof(USB_ENDPOINT_INFO) )) == NULL)
+            {
 #if defined (DEBUG_ENABLE)
-            DEBUG_PutString( "HOST: Cannot allocate for endpoint 0.\r\n" );
+                DEBUG_PutString( "HOST: Cannot allocate for endpoint 0.\r\n" );
 #endif
-            return false;
+                return false;
+            }
+            pCurrentDevice->pEndpoint0->next = NULL;
         }
-        usbDeviceInfo.pEndpoint0->next = NULL;
-    }
-    else
-    {
-        _USB_FreeMemory();
+        else
+        {
+            _USB_FreeMemory();
+        }
+
+        pCurrentDevice->state                   = STATE_DETACHED;
+        pCurrentDevice->hubAddress              = 0;
+        pCurrentDevice->hubPort                 = 0;
+        pCurrentDevice->deviceAddressAndSpeed   = 0;
+        pCurrentDevice->deviceAddress           = 0;
     }
 
     // Initialize other variables.
-    pCurrentEndpoint                        = usbDeviceInfo.pEndpoint0;
-    usbHostState                            = STATE_DETACHED;
+    pCurrentDevice                          = USB_ROOT_DEVICE;
+    pCurrentEndpointDevice                  = USB_ROOT_DEVICE;
+    pCurrentEndpoint                        = USB_ROOT_DEVICE->pEndpoint0;
     usbOverrideHostState                    = NO_STATE;
-    usbDeviceInfo.deviceAddressAndSpeed     = 0;
-    usbDeviceInfo.deviceAddress             = 0;
+    usbBusInfo.bulkDevice                   = 0;
     usbRootHubInfo.flags.bPowerGoodPort0    = 1;
 
-    // Initialize event queue
+    // Initialize event queue.  The statistics are kept across calls.
     #if defined( USB_ENABLE_TRANSFER_EVENT )
-        StructQueueInit(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
+        usbEventQueue.head = 0;
+        usbEventQueue.tail = 0;
     #endif
 
     return true;
@@ -429,7 +799,8 @@ bool USBHostInit(  unsigned long flags  )
   Return Values:
     true    - All buffers are allocated successfully.
     false   - Not enough heap space to allocate all buffers - adjust the 
-                project to provide more heap space.
+                project to provide more heap space - or numberOfBuffers is
+                not between 2 and USB_MAX_ISOCHRONOUS_DATA_BUFFERS.
 
   Remarks:
     This function is available only if USB_SUPPORT_ISOCHRONOUS_TRANSFERS
@@ -442,6 +813,11 @@ bool USBHostIsochronousBuffersCreate( ISOCHRONOUS_DATA * isocData, uint8_t numbe
     uint8_t i;
     uint8_t j;
 
+    if ((numberOfBuffers < 2) || (numberOfBuffers > USB_MAX_ISOCHRONOUS_DATA_BUFFERS))
+    {
+        return false;
+    }
+
     USBHostIsochronousBuffersReset( isocData, numberOfBuffers );
     for (i=0; i<numberOfBuffers; i++)
     {
@@ -512,8 +888,9 @@ void USBHostIsochronousBuffersDestroy( ISOCHRONOUS_DATA * isocData, uint8_t numb
     void USBHostIsochronousBuffersReset( ISOCHRONOUS_DATA * isocData, uint8_t numberOfBuffers )
     
   Description:
-    This function resets all the isochronous data buffers.  It does not do 
-    anything with the space allocated for the buffers.
+    This function resets all the isochronous data buffers and clears the
+    overrun and underrun counts.  It does not do anything with the space
+    allocated for the buffers, or with the watermark settings.
 
   Precondition:
     None
@@ -534,9 +911,15 @@ void USBHostIsochronousBuffersReset( ISOCHRONOUS_DATA * isocData, uint8_t number
 {
     uint8_t    i;
 
+    if (numberOfBuffers > USB_MAX_ISOCHRONOUS_DATA_BUFFERS)
+    {
+        numberOfBuffers = USB_MAX_ISOCHRONOUS_DATA_BUFFERS;
+    }
+
     for (i=0; i<numberOfBuffers; i++)
     {
         isocData->buffers[i].dataLength        = 0;
+        isocData->buffers[i].frameNumber       = 0;
         isocData->buffers[i].bfDataLengthValid = 0;
     }
 
@@ -544,26 +927,135 @@ void USBHostIsochronousBuffersReset( ISOCHRONOUS_DATA * isocData, uint8_t number
     isocData->currentBufferUser    = 0;
     isocData->currentBufferUSB     = 0;
     isocData->pDataUser            = NULL;
+    isocData->highWater            = 0;
+    isocData->overruns             = 0;
+    isocData->underruns            = 0;
 }
 #endif
 
+
 /****************************************************************************
   Function:
-    uint8_t USBHostIssueDeviceRequest( uint8_t deviceAddress, uint8_t bmRequestType,
-                    uint8_t bRequest, uint16_t wValue, uint16_t wIndex, uint16_t wLength,
-                    uint8_t *data, uint8_t dataDirection, uint8_t clientDriverID )
-
-  Summary:
-    This function sends a standard device request to the attached device.
-
+    uint8_t USBHostIsochronousBuffersFilled( ISOCHRONOUS_DATA * isocData )
+    
   Description:
-    This function sends a standard device request to the attached device.
-    The user must pass in the parameters of the device request.  If there is
-    input or output data associated with the request, a pointer to the data
-    must be provided.  The direction of the associated data (input or output)
-    must also be indicated.
+    This function returns the number of isochronous data buffers that are
+    held: received and not yet released, or not yet sent.
 
-    This function does no special processing in regards to the request except
+  Precondition:
+    None
+
+  Parameters:
+    ISOCHRONOUS_DATA * isocData - The isochronous data buffers
+
+  Returns:
+    The number of buffers held
+
+  Remarks:
+    The buffers are counted rather than tracked with a counter, since the
+    USB interrupt and the application change them independently.
+***************************************************************************/
+#ifdef USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+
+uint8_t USBHostIsochronousBuffersFilled( ISOCHRONOUS_DATA * isocData )
+{
+    uint8_t    i;
+    uint8_t    filled;
+
+    filled = 0;
+    for (i=0; i<isocData->totalBuffers; i++)
+    {
+        if (isocData->buffers[i].bfDataLengthValid)
+        {
+            filled++;
+        }
+    }
+    return filled;
+}
+#endif
+
+
+/****************************************************************************
+  Function:
+    ISOCHRONOUS_DATA_BUFFER * USBHostIsochronousBufferGet( ISOCHRONOUS_DATA * isocData )
+    
+  Description:
+    This function returns the oldest received buffer of an isochronous read.
+
+  Precondition:
+    None
+
+  Parameters:
+    ISOCHRONOUS_DATA * isocData - The isochronous data buffers
+
+  Returns:
+    The buffer at currentBufferUser, or NULL if it holds no data yet.
+
+  Remarks:
+    None
+***************************************************************************/
+#ifdef USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+
+ISOCHRONOUS_DATA_BUFFER * USBHostIsochronousBufferGet( ISOCHRONOUS_DATA * isocData )
+{
+    if (isocData->buffers[isocData->currentBufferUser].bfDataLengthValid)
+    {
+        return &isocData->buffers[isocData->currentBufferUser];
+    }
+    return NULL;
+}
+#endif
+
+
+/****************************************************************************
+  Function:
+    void USBHostIsochronousBufferRelease( ISOCHRONOUS_DATA * isocData )
+    
+  Description:
+    This function releases the buffer at currentBufferUser so that it can
+    receive data again, and moves on to the next buffer.
+
+  Precondition:
+    USBHostIsochronousBufferGet() returned a buffer.
+
+  Parameters:
+    ISOCHRONOUS_DATA * isocData - The isochronous data buffers
+
+  Returns:
+    None
+
+  Remarks:
+    None
+***************************************************************************/
+#ifdef USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+
+void USBHostIsochronousBufferRelease( ISOCHRONOUS_DATA * isocData )
+{
+    isocData->buffers[isocData->currentBufferUser].bfDataLengthValid = 0;
+    if (++isocData->currentBufferUser >= isocData->totalBuffers)
+    {
+        isocData->currentBufferUser = 0;
+    }
+}
+#endif
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostIssueDeviceRequest( uint8_t deviceAddress, uint8_t bmRequestType,
+                    uint8_t bRequest, uint16_t wValue, uint16_t wIndex, uint16_t wLength,
+                    uint8_t *data, uint8_t dataDirection, uint8_t clientDriverID )
+
+  Summary:
+    This function sends a standard device request to the attached device.
+
+  Description:
+    This function sends a standard device request to the attached device.
+    The user must pass in the parameters of the device request.  If there is
+    input or output data associated with the request, a pointer to the data
+    must be provided.  The direction of the associated data (input or output)
+    must also be indicated.
+
+    This function does no special processing in regards to the request except
     for three requests.  If SET INTERFACE is sent, then DTS is reset for all
     endpoints.  If CLEAR FEATURE (ENDPOINT HALT) is sent, then DTS is reset
     for that endpoint.  If SET CONFIGURATION is sent, the request is aborted
@@ -607,20 +1099,23 @@ uint8_t USBHostIssueDeviceRequest( uint8_t deviceAddress, uint8_t bmRequestType,
             uint16_t wValue, uint16_t wIndex, uint16_t wLength, uint8_t *data, uint8_t dataDirection,
             uint8_t clientDriverID )
 {
+    USB_DEVICE_INFO     *pDevice;
+
     // Find the required device
-    if (deviceAddress != usbDeviceInfo.deviceAddress)
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
     {
         return USB_UNKNOWN_DEVICE;
     }
 
     // If we are not in a normal user running state, we cannot do this.
-    if ((usbHostState & STATE_MASK) != STATE_RUNNING)
+    if ((pDevice->state & STATE_MASK) != STATE_RUNNING)
     {
         return USB_INVALID_STATE;
     }
 
     // Make sure no other reads or writes on EP0 are in progress.
-    if (!usbDeviceInfo.pEndpoint0->status.bfTransferComplete)
+    if (!pDevice->pEndpoint0->status.bfTransferComplete)
     {
         return USB_ENDPOINT_BUSY;
     }
@@ -642,7 +1137,7 @@ uint8_t USBHostIssueDeviceRequest( uint8_t deviceAddress, uint8_t bmRequestType,
 
         // Make sure there are no transfers currently in progress on the current
         // interface setting.
-        pInterface = usbDeviceInfo.pInterfaceList;
+        pInterface = pDevice->pInterfaceList;
         while (pInterface && (pInterface->interface != wIndex))
         {
             pInterface = pInterface->next;
@@ -676,6 +1171,7 @@ uint8_t USBHostIssueDeviceRequest( uint8_t deviceAddress, uint8_t bmRequestType,
 
         // Set the pointer to the new setting.
         pInterface->pCurrentSetting = pSetting;
+        _USB_BuildEndpointTable( pDevice );
     }
 
     // If the user is doing a CLEAR FEATURE(ENDPOINT_HALT), we must reset DATA0 for that endpoint.
@@ -686,7 +1182,7 @@ uint8_t USBHostIssueDeviceRequest( uint8_t deviceAddress, uint8_t bmRequestType,
             case 0x00:
             case 0x01:
             case 0x02:
-                _USB_ResetDATA0( (uint8_t)wIndex );
+                _USB_ResetDATA0( pDevice, (uint8_t)wIndex );
                 break;
             default:
                 break;
@@ -694,27 +1190,27 @@ uint8_t USBHostIssueDeviceRequest( uint8_t deviceAddress, uint8_t bmRequestType,
     }
 
     // Set up the control packet.
-    pEP0Data[0] = bmRequestType;
-    pEP0Data[1] = bRequest;
-    pEP0Data[2] = wValue & 0xFF;
-    pEP0Data[3] = (wValue >> 8) & 0xFF;
-    pEP0Data[4] = wIndex & 0xFF;
-    pEP0Data[5] = (wIndex >> 8) & 0xFF;
-    pEP0Data[6] = wLength & 0xFF;
-    pEP0Data[7] = (wLength >> 8) & 0xFF;
+    pDevice->pEP0Data[0] = bmRequestType;
+    pDevice->pEP0Data[1] = bRequest;
+    pDevice->pEP0Data[2] = wValue & 0xFF;
+    pDevice->pEP0Data[3] = (wValue >> 8) & 0xFF;
+    pDevice->pEP0Data[4] = wIndex & 0xFF;
+    pDevice->pEP0Data[5] = (wIndex >> 8) & 0xFF;
+    pDevice->pEP0Data[6] = wLength & 0xFF;
+    pDevice->pEP0Data[7] = (wLength >> 8) & 0xFF;
 
     // Set up the client driver for the event.
-    usbDeviceInfo.pEndpoint0->clientDriver = clientDriverID;
+    pDevice->pEndpoint0->clientDriver = clientDriverID;
 
     if (dataDirection == USB_DEVICE_REQUEST_SET)
     {
         // We are doing a SET command that requires data be sent.
-        _USB_InitControlWrite( usbDeviceInfo.pEndpoint0, pEP0Data,8, data, wLength );
+        _USB_InitControlWrite( pDevice->pEndpoint0, pDevice->pEP0Data,8, data, wLength );
     }
     else
     {
         // We are doing a GET request.
-        _USB_InitControlRead( usbDeviceInfo.pEndpoint0, pEP0Data, 8, data, wLength );
+        _USB_InitControlRead( pDevice->pEndpoint0, pDevice->pEP0Data, 8, data, wLength );
     }
 
     return USB_SUCCESS;
@@ -774,21 +1270,23 @@ uint8_t USBHostIssueDeviceRequest( uint8_t deviceAddress, uint8_t bmRequestType,
 
 uint8_t USBHostRead( uint8_t deviceAddress, uint8_t endpoint, uint8_t *pData, uint32_t size )
 {
+    USB_DEVICE_INFO   *pDevice;
     USB_ENDPOINT_INFO *ep;
 
     // Find the required device
-    if (deviceAddress != usbDeviceInfo.deviceAddress)
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
     {
         return USB_UNKNOWN_DEVICE;
     }
 
     // If we are not in a normal user running state, we cannot do this.
-    if ((usbHostState & STATE_MASK) != STATE_RUNNING)
+    if ((pDevice->state & STATE_MASK) != STATE_RUNNING)
     {
         return USB_INVALID_STATE;
     }
 
-    ep = _USB_FindEndpoint( endpoint );
+    ep = _USB_FindEndpoint( pDevice, endpoint );
     if (ep)
     {
         if (ep->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_CONTROL)
@@ -824,6 +1322,10 @@ uint8_t USBHostRead( uint8_t deviceAddress, uint8_t endpoint, uint8_t *pData, ui
         }
 
         _USB_InitRead( ep, pData, size );
+        _USB_MarkEndpointReady( pDevice, ep );
+        #if defined( USB_SUPPORT_BULK_TRANSFERS )
+            _USB_ReopenBulkPass( ep );
+        #endif
 
         return USB_SUCCESS;
     }
@@ -858,22 +1360,35 @@ uint8_t USBHostRead( uint8_t deviceAddress, uint8_t endpoint, uint8_t *pData, ui
     rather than a reset state.  The ATTACH interrupt will automatically be
     triggered when the module is re-enabled, and the proper reset will be
     performed.
+
+    Devices behind the hub cannot be reset this way; USB_ILLEGAL_REQUEST
+    is returned.
   ***************************************************************************/
 
 uint8_t USBHostResetDevice( uint8_t deviceAddress )
 {
+    USB_DEVICE_INFO     *pDevice;
+
     // Find the required device
-    if (deviceAddress != usbDeviceInfo.deviceAddress)
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
     {
         return USB_UNKNOWN_DEVICE;
     }
 
-    if ((usbHostState & STATE_MASK) == STATE_DETACHED)
+    // Devices behind the hub are reset, suspended, and resumed through
+    // their hub port.
+    if (pDevice->hubAddress != 0)
+    {
+        return USB_ILLEGAL_REQUEST;
+    }
+
+    if ((pDevice->state & STATE_MASK) == STATE_DETACHED)
     {
         return USB_ILLEGAL_REQUEST;
     }
 
-    usbHostState = STATE_DETACHED;
+    pDevice->state = STATE_DETACHED;
 
     return USB_SUCCESS;
 }
@@ -901,18 +1416,28 @@ uint8_t USBHostResetDevice( uint8_t deviceAddress )
     USB_ILLEGAL_REQUEST - Device cannot RESUME unless it is suspended
 
   Remarks:
-    None
+    Devices behind the hub return USB_ILLEGAL_REQUEST.
   ***************************************************************************/
 
 uint8_t USBHostResumeDevice( uint8_t deviceAddress )
 {
+    USB_DEVICE_INFO     *pDevice;
+
     // Find the required device
-    if (deviceAddress != usbDeviceInfo.deviceAddress)
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
     {
         return USB_UNKNOWN_DEVICE;
     }
 
-    if (usbHostState != (STATE_RUNNING | SUBSTATE_SUSPEND_AND_RESUME | SUBSUBSTATE_SUSPEND))
+    // Devices behind the hub are reset, suspended, and resumed through
+    // their hub port.
+    if (pDevice->hubAddress != 0)
+    {
+        return USB_ILLEGAL_REQUEST;
+    }
+
+    if (pDevice->state != (STATE_RUNNING | SUBSTATE_SUSPEND_AND_RESUME | SUBSUBSTATE_SUSPEND))
     {
         return USB_ILLEGAL_REQUEST;
     }
@@ -984,38 +1509,41 @@ uint8_t USBHostResumeDevice( uint8_t deviceAddress )
 
 uint8_t USBHostSetDeviceConfiguration( uint8_t deviceAddress, uint8_t configuration )
 {
+    USB_DEVICE_INFO     *pDevice;
+
     // Find the required device
-    if (deviceAddress != usbDeviceInfo.deviceAddress)
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
     {
         return USB_UNKNOWN_DEVICE;
     }
 
     // If we are not in a normal user running state, we cannot do this.
-    if ((usbHostState & STATE_MASK) != STATE_RUNNING)
+    if ((pDevice->state & STATE_MASK) != STATE_RUNNING)
     {
         return USB_INVALID_STATE;
     }
 
     // Make sure no other reads or writes are in progress.
-    if (_USB_TransferInProgress())
+    if (_USB_TransferInProgress( pDevice ))
     {
         return USB_BUSY;
     }
 
     // Set the new device configuration.
-    usbDeviceInfo.currentConfiguration = configuration;
+    pDevice->currentConfiguration = configuration;
 
     // We're going to be sending Endpoint 0 commands, so be sure the
     // client driver indicates the host driver, so we do not send events up
     // to a client driver.
-    usbDeviceInfo.pEndpoint0->clientDriver = CLIENT_DRIVER_HOST;
+    pDevice->pEndpoint0->clientDriver = CLIENT_DRIVER_HOST;
 
     // Set the state back to configure the device.  This will destroy the
     // endpoint list and terminate any current transactions.  We already have
     // the configuration, so we can jump into the Select Configuration state.
     // If the configuration value is invalid, the state machine will error and
     // put the device into a holding state.
-    usbHostState = STATE_CONFIGURING | SUBSTATE_SELECT_CONFIGURATION;
+    pDevice->state = STATE_CONFIGURING | SUBSTATE_SELECT_CONFIGURATION;
 
     return USB_SUCCESS;
 }
@@ -1056,15 +1584,17 @@ uint8_t USBHostSetDeviceConfiguration( uint8_t deviceAddress, uint8_t configurat
 
 uint8_t USBHostSetNAKTimeout( uint8_t deviceAddress, uint8_t endpoint, uint16_t flags, uint16_t timeoutCount )
 {
+    USB_DEVICE_INFO   *pDevice;
     USB_ENDPOINT_INFO *ep;
 
     // Find the required device
-    if (deviceAddress != usbDeviceInfo.deviceAddress)
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
     {
         return USB_UNKNOWN_DEVICE;
     }
 
-    ep = _USB_FindEndpoint( endpoint );
+    ep = _USB_FindEndpoint( pDevice, endpoint );
     if (ep)
     {
         ep->status.bfNAKTimeoutEnabled  = flags & 0x01;
@@ -1103,6 +1633,19 @@ uint8_t USBHostSetNAKTimeout( uint8_t deviceAddress, uint8_t endpoint, uint16_t
 
 void USBHostShutdown( void )
 {
+    #if defined( USB_HUB_SUPPORT_INCLUDED )
+        uint8_t i;
+
+        // The devices behind the hub go before the hub itself.
+        for (i=1; i<USB_MAX_DEVICES; i++)
+        {
+            if (usbDeviceInfo[i].hubAddress != 0)
+            {
+                _USB_DetachHubDevice( &usbDeviceInfo[i] );
+            }
+        }
+    #endif
+
     // Shut off the power to the module first, in case we are in an
     // overcurrent situation.
 
@@ -1111,16 +1654,16 @@ void USBHostShutdown( void )
         {
             // If we currently have an attached device, notify the higher layers that
             // the device is being removed.
-            if (usbDeviceInfo.deviceAddress)
+            if (USB_ROOT_DEVICE->deviceAddress)
             {
                 USB_VBUS_POWER_EVENT_DATA   powerRequest;
 
                 powerRequest.port = 0;  // Currently was have only one port.
 
-                USB_HOST_APP_EVENT_HANDLER( usbDeviceInfo.deviceAddress, EVENT_VBUS_RELEASE_POWER,
+                USB_HOST_APP_EVENT_HANDLER( USB_ROOT_DEVICE->deviceAddress, EVENT_VBUS_RELEASE_POWER,
                     &powerRequest, sizeof(USB_VBUS_POWER_EVENT_DATA) );
-                _USB_NotifyClients(usbDeviceInfo.deviceAddress, EVENT_DETACH,
-                    &usbDeviceInfo.deviceAddress, sizeof(uint8_t) );
+                _USB_NotifyClients(USB_ROOT_DEVICE->deviceAddress, EVENT_DETACH,
+                    &USB_ROOT_DEVICE->deviceAddress, sizeof(uint8_t) );
 
 
             }
@@ -1130,21 +1673,21 @@ void USBHostShutdown( void )
 
         // If we currently have an attached device, notify the higher layers that
         // the device is being removed.
-        if (usbDeviceInfo.deviceAddress)
+        if (USB_ROOT_DEVICE->deviceAddress)
         {
             USB_VBUS_POWER_EVENT_DATA   powerRequest;
 
             powerRequest.port = 0;  // Currently was have only one port.
 
-            USB_HOST_APP_EVENT_HANDLER( usbDeviceInfo.deviceAddress,
+            USB_HOST_APP_EVENT_HANDLER( USB_ROOT_DEVICE->deviceAddress,
                                         EVENT_VBUS_RELEASE_POWER,
                                         &powerRequest,
                                         sizeof(USB_VBUS_POWER_EVENT_DATA)
                                       );
             
-            _USB_NotifyClients( usbDeviceInfo.deviceAddress,
+            _USB_NotifyClients( USB_ROOT_DEVICE->deviceAddress,
                                 EVENT_DETACH,
-                                &usbDeviceInfo.deviceAddress,
+                                &USB_ROOT_DEVICE->deviceAddress,
                                 sizeof(uint8_t)
                               );
 
@@ -1182,18 +1725,28 @@ void USBHostShutdown( void )
     USB_ILLEGAL_REQUEST - Cannot suspend unless device is in normal run mode
 
   Remarks:
-    None
+    Devices behind the hub return USB_ILLEGAL_REQUEST.
   ***************************************************************************/
 
 uint8_t USBHostSuspendDevice( uint8_t deviceAddress )
 {
+    USB_DEVICE_INFO     *pDevice;
+
     // Find the required device
-    if (deviceAddress != usbDeviceInfo.deviceAddress)
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
     {
         return USB_UNKNOWN_DEVICE;
     }
 
-    if (usbHostState != (STATE_RUNNING | SUBSTATE_NORMAL_RUN))
+    // Devices behind the hub are reset, suspended, and resumed through
+    // their hub port.
+    if (pDevice->hubAddress != 0)
+    {
+        return USB_ILLEGAL_REQUEST;
+    }
+
+    if (pDevice->state != (STATE_RUNNING | SUBSTATE_NORMAL_RUN))
     {
         return USB_ILLEGAL_REQUEST;
     }
@@ -1202,7 +1755,7 @@ uint8_t USBHostSuspendDevice( uint8_t deviceAddress )
     U1CONbits.SOFEN = 0;
 
     // Put the state machine in suspend mode.
-    usbHostState = STATE_RUNNING | SUBSTATE_SUSPEND_AND_RESUME | SUBSUBSTATE_SUSPEND;
+    pDevice->state = STATE_RUNNING | SUBSTATE_SUSPEND_AND_RESUME | SUBSUBSTATE_SUSPEND;
 
     return USB_SUCCESS;
 }
@@ -1243,65 +1796,28 @@ uint8_t USBHostSuspendDevice( uint8_t deviceAddress )
 
 void USBHostTasks( void )
 {
-    static USB_CONFIGURATION    *pCurrentConfigurationNode;  //MR - made static for OTG
-    USB_INTERFACE_INFO          *pCurrentInterface;
-    uint8_t                        *pTemp;
-    uint8_t                        temp;
-    USB_VBUS_POWER_EVENT_DATA   powerRequest;
+    uint8_t i;
 
     // The PIC32MX detach interrupt is not reliable.  If we are not in one of
     // the detached states, we'll do a check here to see if we've detached.
     // If the ATTACH bit is 0, we have detached.
     #ifdef __PIC32MX__
         #ifdef USE_MANUAL_DETACH_DETECT
-            if (((usbHostState & STATE_MASK) != STATE_DETACHED) && !U1IRbits.ATTACHIF)
+            if (((USB_ROOT_DEVICE->state & STATE_MASK) != STATE_DETACHED) && !U1IRbits.ATTACHIF)
             {
 #if defined (DEBUG_ENABLE)
                 DEBUG_PutChar( '>' );
                 DEBUG_PutChar( ']' );
 #endif
 
-                usbHostState = STATE_DETACHED;
+                USB_ROOT_DEVICE->state = STATE_DETACHED;
             }
         #endif
     #endif
 
     // Send any queued events to the client and application layers.
     #if defined ( USB_ENABLE_TRANSFER_EVENT )
-    {
-        USB_EVENT_DATA *item;
-        #if defined( __C30__ ) || defined __XC16__
-            uint16_t        interrupt_mask;
-        #elif defined( __PIC32MX__ )
-            uint32_t      interrupt_mask;
-        #else
-            #error Cannot save interrupt status
-        #endif
-
-        while (StructQueueIsNotEmpty(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-        {
-            item = StructQueuePeekTail(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-
-            switch(item->event)
-            {
-                case EVENT_TRANSFER:
-                case EVENT_BUS_ERROR:
-                    _USB_NotifyClients( usbDeviceInfo.deviceAddress, item->event, &item->TransferData, sizeof(HOST_TRANSFER_DATA) );
-                    break;
-                default:
-                    break;
-            }
-
-            // Guard against USB interrupts
-            interrupt_mask = U1IE;
-            U1IE = 0;
-
-            item = StructQueueRemove(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-
-            // Re-enable USB interrupts
-            U1IE = interrupt_mask;
-        }
-    }
+        _USB_DrainEventQueue();
     #endif
 
     // See if we got an interrupt to change our state.
@@ -1311,1502 +1827,1703 @@ void USBHostTasks( void )
         DEBUG_PutChar('>');
 #endif
 
-        usbHostState = usbOverrideHostState;
+        USB_ROOT_DEVICE->state = usbOverrideHostState;
         usbOverrideHostState = NO_STATE;
     }
 
-    //-------------------------------------------------------------------------
-    // Main State Machine
-
-    switch (usbHostState & STATE_MASK)
+    // Run the state machine of the device on the root port, then of each
+    // device enumerated behind the hub.
+    pCurrentDevice = USB_ROOT_DEVICE;
+    _USB_DeviceTasks();
+    for (i=1; i<USB_MAX_DEVICES; i++)
     {
-        case STATE_DETACHED:
-            switch (usbHostState & SUBSTATE_MASK)
-            {
-                case SUBSTATE_INITIALIZE:
-                    // We got here either from initialization or from the user
-                    // unplugging the device at any point in time.
+        if (usbDeviceInfo[i].hubAddress != 0)
+        {
+            pCurrentDevice = &usbDeviceInfo[i];
+            _USB_DeviceTasks();
+        }
+    }
+    pCurrentDevice = USB_ROOT_DEVICE;
+}
 
-                    // Turn off the module and free up memory.
-                    USBHostShutdown();
+/****************************************************************************
+  Function:
+    void USBHostTerminateTransfer( uint8_t deviceAddress, uint8_t endpoint )
 
-#if defined (DEBUG_ENABLE)
-                    DEBUG_PutString( "HOST: Initializing DETACHED state.\r\n" );
-#endif
 
-                    // Initialize Endpoint 0 attributes.
-                    usbDeviceInfo.pEndpoint0->next                         = NULL;
-                    usbDeviceInfo.pEndpoint0->status.val                   = 0x00;
-                    usbDeviceInfo.pEndpoint0->status.bfUseDTS              = 1;
-                    usbDeviceInfo.pEndpoint0->status.bfTransferComplete    = 1;    // Initialize to success to allow preprocessing loops.
-                    usbDeviceInfo.pEndpoint0->status.bfNAKTimeoutEnabled   = 1;    // So we can catch devices that NAK forever during enumeration
-                    usbDeviceInfo.pEndpoint0->timeoutNAKs                  = USB_NUM_CONTROL_NAKS;
-                    usbDeviceInfo.pEndpoint0->wMaxPacketSize               = 64;
-                    usbDeviceInfo.pEndpoint0->dataCount                    = 0;    // Initialize to 0 since we set bfTransferComplete.
-                    usbDeviceInfo.pEndpoint0->bEndpointAddress             = 0;
-                    usbDeviceInfo.pEndpoint0->transferState                = TSTATE_IDLE;
-                    usbDeviceInfo.pEndpoint0->bmAttributes.bfTransferType  = USB_TRANSFER_TYPE_CONTROL;
-                    usbDeviceInfo.pEndpoint0->clientDriver                 = CLIENT_DRIVER_HOST;
-
-                    // Initialize any device specific information.
-                    numEnumerationTries                 = USB_NUM_ENUMERATION_TRIES;
-                    usbDeviceInfo.currentConfiguration  = 0; // Will be overwritten by config process or the user later
-                    usbDeviceInfo.attributesOTG         = 0;
-                    usbDeviceInfo.deviceAddressAndSpeed = 0;
-                    usbDeviceInfo.flags.val             = 0;
-                    usbDeviceInfo.pInterfaceList        = NULL;
-                    usbBusInfo.flags.val                = 0;
-                    
-                    // Set up the hardware.
-                    U1IE                = 0;        // Clear and turn off interrupts.
-                    U1IR                = 0xFF;
-                    U1OTGIE             &= 0x8C;
-                    U1OTGIR             = 0x7D;
-                    U1EIE               = 0;
-                    U1EIR               = 0xFF;
+  Summary:
+    This function terminates the current transfer for the given endpoint.
 
-                    // Initialize the Buffer Descriptor Table pointer.
-                    #if defined(__C30__) || defined __XC16__
-                       U1BDTP1 = (uint16_t)(&BDT) >> 8;
-                    #elif defined(__PIC32MX__)
-                       U1BDTP1 = ((uint32_t)KVA_TO_PA(&BDT) & 0x0000FF00) >> 8;
-                       U1BDTP2 = ((uint32_t)KVA_TO_PA(&BDT) & 0x00FF0000) >> 16;
-                       U1BDTP3 = ((uint32_t)KVA_TO_PA(&BDT) & 0xFF000000) >> 24;
-                    #else
-                        #error Cannot set up the Buffer Descriptor Table pointer.
-                    #endif
+  Description:
+    This function terminates the current transfer for the given endpoint.  It
+    can be used to terminate reads or writes that the device is not
+    responding to.  It is also the only way to terminate an isochronous
+    transfer.
 
-                    // Configure the module
-                    U1CON               = USB_HOST_MODE_ENABLE | USB_SOF_DISABLE;                       // Turn of SOF's to cut down noise
-                    U1CON               = USB_HOST_MODE_ENABLE | USB_PINGPONG_RESET | USB_SOF_DISABLE;  // Reset the ping-pong buffers
-                    U1CON               = USB_HOST_MODE_ENABLE | USB_SOF_DISABLE;                       // Release the ping-pong buffers
-                    #ifdef  USB_SUPPORT_OTG
-                        U1OTGCON            |= USB_DPLUS_PULLDOWN_ENABLE | USB_DMINUS_PULLDOWN_ENABLE | USB_OTG_ENABLE; // Pull down D+ and D-
-                    #else
-                        U1OTGCON            = USB_DPLUS_PULLDOWN_ENABLE | USB_DMINUS_PULLDOWN_ENABLE; // Pull down D+ and D-
-                    #endif
+  Precondition:
+    None
 
-                    #if defined(__PIC32MX__)
-                        U1OTGCON |= USB_VBUS_ON;
-                    #endif
+  Parameters:
+    uint8_t deviceAddress  - Device address
+    uint8_t endpoint       - Endpoint number
 
-                    U1CNFG1             = USB_PING_PONG_MODE;
-                    #if defined(__C30__) || defined __XC16__
-                        U1CNFG2         = USB_VBUS_BOOST_ENABLE | USB_VBUS_COMPARE_ENABLE | USB_ONCHIP_ENABLE;
-                    #endif
-                    U1ADDR              = 0;                        // Set default address and LSPDEN to 0
-                    U1EP0bits.LSPD      = 0;
-                    U1SOF               = USB_SOF_THRESHOLD_64;     // Maximum EP0 packet size
+  Returns:
+    None
 
-                    // Set the next substate.  We do this before we enable
-                    // interrupts in case the interrupt changes states.
-                    _USB_SetNextSubState();
-                    break;
+  Remarks:
+    None
+  ***************************************************************************/
 
-                case SUBSTATE_WAIT_FOR_POWER:
-                    // We will wait here until the application tells us we can
-                    // turn on power.
-                    if (usbRootHubInfo.flags.bPowerGoodPort0)
-                    {
-                        _USB_SetNextSubState();
-                    }
-                    break;
+void USBHostTerminateTransfer( uint8_t deviceAddress, uint8_t endpoint )
+{
+    USB_DEVICE_INFO   *pDevice;
+    USB_ENDPOINT_INFO *ep;
 
-                case SUBSTATE_TURN_ON_POWER:
-                    powerRequest.port       = 0;
-                    powerRequest.current    = USB_INITIAL_VBUS_CURRENT;
-                    if (USB_HOST_APP_EVENT_HANDLER( USB_ROOT_HUB, EVENT_VBUS_REQUEST_POWER,
-                            &powerRequest, sizeof(USB_VBUS_POWER_EVENT_DATA) ))
-                    {
-                        // Power on the module
-                        U1PWRC                = USB_NORMAL_OPERATION | USB_ENABLED;
+    // Find the required device
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
+    {
+        return; // USB_UNKNOWN_DEVICE;
+    }
 
-                        #if defined( __C30__ ) || defined __XC16__
-                            IFS5            &= 0xFFBF;
-                            IPC21           &= 0xF0FF;
-                            IPC21           |= 0x0600;
-                            IEC5            |= 0x0040;
-                        #elif defined( __PIC32MX__ )
-                            // Enable the USB interrupt.
-                            IFS1CLR         = _IFS1_USBIF_MASK;
-                            #if defined(_IPC11_USBIP_MASK)
-                                IPC11CLR        = _IPC11_USBIP_MASK | _IPC11_USBIS_MASK;
-                                IPC11SET        = _IPC11_USBIP_MASK & (0x00000004 << _IPC11_USBIP_POSITION);
-                            #elif defined(_IPC7_USBIP_MASK)
-                                IPC7CLR        = _IPC7_USBIP_MASK | _IPC7_USBIS_MASK;
-                                IPC7SET        = _IPC7_USBIP_MASK & (0x00000004 << _IPC7_USBIP_POSITION);
-                            #else
-                                #error "The selected PIC32 device is not currently supported by usb_host.c."
-                            #endif
-                            IEC1SET         = _IEC1_USBIE_MASK;                        
-                        #else
-                            #error Cannot enable USB interrupt.
-                        #endif
+    ep = _USB_FindEndpoint( pDevice, endpoint );
+    if (ep != NULL)
+    {
+        ep->status.bfUserAbort          = 1;
+        ep->status.bfTransferComplete   = 1;
+    }
+}
 
-                        // Set the next substate.  We do this before we enable
-                        // interrupts in case the interrupt changes states.
-                        _USB_SetNextSubState();
+/****************************************************************************
+  Function:
+    bool USBHostTransferIsComplete( uint8_t deviceAddress, uint8_t endpoint,
+                        uint8_t *errorCode, uint32_t *byteCount )
 
-                        // Enable the ATTACH interrupt.
-                        U1IEbits.ATTACHIE = 1;
+  Summary:
+    This function initiates whether or not the last endpoint transaction is
+    complete.
 
-                        #if defined(USB_ENABLE_1MS_EVENT)
-                            U1OTGIR                 = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
-                            U1OTGIEbits.T1MSECIE    = 1;
-                        #endif
-                    }
-                    else
-                    {
-                        usbRootHubInfo.flags.bPowerGoodPort0 = 0;
-                        usbHostState = STATE_DETACHED | SUBSTATE_WAIT_FOR_POWER;
-                    }
-                    break;
+  Description:
+    This function initiates whether or not the last endpoint transaction is
+    complete.  If it is complete, an error code and the number of bytes
+    transferred are returned.
 
-                case SUBSTATE_WAIT_FOR_DEVICE:
-                    // Wait here for the ATTACH interrupt.
-                    #ifdef  USB_SUPPORT_OTG
-                        U1IEbits.ATTACHIE = 1;
-                    #endif
-                break;
-            }
-            break;
+    For isochronous transfers, byteCount is not valid.  Instead, use the
+    returned byte counts for each EVENT_TRANSFER event that was generated
+    during the transfer.
 
-        case STATE_ATTACHED:
-            switch (usbHostState & SUBSTATE_MASK)
-            {
-                case SUBSTATE_SETTLE:
-                    // Wait 100ms for the insertion process to complete and power
-                    // at the device to be stable.
-                    switch (usbHostState & SUBSUBSTATE_MASK)
-                    {
-                        case SUBSUBSTATE_START_SETTLING_DELAY:
-#if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Starting settling delay.\r\n" );
-#endif
+  Precondition:
+    None
 
-                            // Clear and turn on the DETACH interrupt.
-                            U1IR                    = USB_INTERRUPT_DETACH;   // The interrupt is cleared by writing a '1' to the flag.
-                            U1IEbits.DETACHIE       = 1;
+  Parameters:
+    uint8_t deviceAddress  - Device address
+    uint8_t endpoint       - Endpoint number
+    uint8_t *errorCode     - Error code indicating the status of the transfer.
+                            Only valid if the transfer is complete.
+    uint32_t *byteCount    - The number of bytes sent or received.  Invalid
+                            for isochronous transfers.
 
-                            // Configure and turn on the settling timer - 100ms.
-                            numTimerInterrupts      = USB_INSERT_TIME;
-                            U1OTGIR                 = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
-                            U1OTGIEbits.T1MSECIE    = 1;
-                            _USB_SetNextSubSubState();
-                            break;
+  Return Values:
+    true    - Transfer is complete.
+    false   - Transfer is not complete.
 
-                        case SUBSUBSTATE_WAIT_FOR_SETTLING:
-                            // Wait for the timer to finish in the background.
-                            break;
+  Remarks:
+    Possible values for errorCode are:
+        * USB_SUCCESS                     - Transfer successful
+        * USB_UNKNOWN_DEVICE              - Device not attached
+        * USB_ENDPOINT_STALLED            - Endpoint STALL'd
+        * USB_ENDPOINT_ERROR_ILLEGAL_PID  - Illegal PID returned
+        * USB_ENDPOINT_ERROR_BIT_STUFF
+        * USB_ENDPOINT_ERROR_DMA
+        * USB_ENDPOINT_ERROR_TIMEOUT
+        * USB_ENDPOINT_ERROR_DATA_FIELD
+        * USB_ENDPOINT_ERROR_CRC16
+        * USB_ENDPOINT_ERROR_END_OF_FRAME
+        * USB_ENDPOINT_ERROR_PID_CHECK
+        * USB_ENDPOINT_ERROR              - Other error
+  ***************************************************************************/
 
-                        case SUBSUBSTATE_SETTLING_DONE:
-                            _USB_SetNextSubState();
-                            break;
+bool USBHostTransferIsComplete( uint8_t deviceAddress, uint8_t endpoint, uint8_t *errorCode,
+            uint32_t *byteCount )
+{
+    USB_DEVICE_INFO     *pDevice;
+    USB_ENDPOINT_INFO   *ep;
+    uint8_t                transferComplete;
 
-                        default:
-                            // We shouldn't get here.
-                            break;
-                    }
-                    break;
+    // Find the required device
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
+    {
+        *errorCode = USB_UNKNOWN_DEVICE;
+        *byteCount = 0;
+        return true;
+    }
 
-                case SUBSTATE_RESET_DEVICE:
-                    // Reset the device.  We have to do the reset timing ourselves.
-                    switch (usbHostState & SUBSUBSTATE_MASK)
-                    {
-                        case SUBSUBSTATE_SET_RESET:
-#if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Resetting the device.\r\n" );
-#endif
+    ep = _USB_FindEndpoint( pDevice, endpoint );
+    if (ep != NULL)
+    {
+        // bfTransferComplete, the status flags, and byte count can be
+        // changed in an interrupt service routine.  Therefore, we'll
+        // grab it first, save it locally, and then determine the rest of
+        // the information.  It is better to say that the transfer is not
+        // yet complete, since the caller will simply try again.
 
-                            // Prepare a data buffer for us to use.  We'll make it 8 bytes for now,
-                            // which is the minimum wMaxPacketSize for EP0.
-                            if (pEP0Data != NULL)
-                            {
-                                USB_FREE_AND_CLEAR( pEP0Data );
-                            }
+        // Save off the Transfer Complete status.  That way, we won't
+        // load up bad values and then say the transfer is complete.
+        transferComplete = ep->status.bfTransferComplete;
 
-                            if ((pEP0Data = (uint8_t *)USB_MALLOC( 8 )) == NULL)
-                            {
-#if defined (DEBUG_ENABLE)
-                                DEBUG_PutString( "HOST: Error alloc-ing pEP0Data\r\n" );
-#endif
+        // Set up error code.  This is only valid if the transfer is complete.
+        if (ep->status.bfTransferSuccessful)
+        {
+            *errorCode = USB_SUCCESS;
+            *byteCount = ep->dataCount;
+        }
+        else if (ep->status.bfStalled)
+        {
+            *errorCode = USB_ENDPOINT_STALLED;
+        }
+        else if (ep->status.bfError)
+        {
+            *errorCode = ep->bErrorCode;
+        }
+        else
+        {
+            *errorCode = USB_ENDPOINT_UNRESOLVED_STATE;
+        }
 
-                                _USB_SetErrorCode( USB_HOLDING_OUT_OF_MEMORY );
-                                _USB_SetHoldState();
-                                break;
-                            }
+        return transferComplete;
+    }
 
-                            // Initialize the USB Device information
-                            usbDeviceInfo.currentConfiguration      = 0;
-                            usbDeviceInfo.attributesOTG             = 0;
-                            usbDeviceInfo.flags.val                 = 0;
+    // The endpoint was not found.  Return true so we can return a valid error code.
+    *errorCode = USB_ENDPOINT_NOT_FOUND;
+    return true;
+}
 
-                            _USB_InitErrorCounters();
+/****************************************************************************
+  Function:
+    uint8_t  USBHostVbusEvent( USB_EVENT vbusEvent, uint8_t hubAddress,
+                                        uint8_t portNumber)
 
-                            // Disable all EP's except EP0.
-                            U1EP0  = USB_ENDPOINT_CONTROL_SETUP;
-                            U1EP1  = USB_DISABLE_ENDPOINT;
-                            U1EP2  = USB_DISABLE_ENDPOINT;
-                            U1EP3  = USB_DISABLE_ENDPOINT;
-                            U1EP4  = USB_DISABLE_ENDPOINT;
-                            U1EP5  = USB_DISABLE_ENDPOINT;
-                            U1EP6  = USB_DISABLE_ENDPOINT;
-                            U1EP7  = USB_DISABLE_ENDPOINT;
-                            U1EP8  = USB_DISABLE_ENDPOINT;
-                            U1EP9  = USB_DISABLE_ENDPOINT;
-                            U1EP10 = USB_DISABLE_ENDPOINT;
-                            U1EP11 = USB_DISABLE_ENDPOINT;
-                            U1EP12 = USB_DISABLE_ENDPOINT;
-                            U1EP13 = USB_DISABLE_ENDPOINT;
-                            U1EP14 = USB_DISABLE_ENDPOINT;
-                            U1EP15 = USB_DISABLE_ENDPOINT;
+  Summary:
+    This function handles Vbus events that are detected by the application.
 
-                            // See if the device is low speed.
-                            if (!U1CONbits.JSTATE)
-                            {
-#if defined (DEBUG_ENABLE)
-                                DEBUG_PutString( "HOST: Low Speed!\r\n" );
-#endif
+  Description:
+    This function handles Vbus events that are detected by the application.
+    Since Vbus management is application dependent, the application is
+    responsible for monitoring Vbus and detecting overcurrent conditions
+    and removal of the overcurrent condition.  If the application detects
+    an overcurrent condition, it should call this function with the event
+    EVENT_VBUS_OVERCURRENT with the address of the hub and port number that
+    has the condition.  When a port returns to normal operation, the
+    application should call this function with the event
+    EVENT_VBUS_POWER_AVAILABLE so the stack knows that it can allow devices
+    to attach to that port.
 
-                                usbDeviceInfo.flags.bfIsLowSpeed    = 1;
-                                usbDeviceInfo.deviceAddressAndSpeed = 0x80;
-                                U1ADDR                              = 0x80;
-                                U1EP0bits.LSPD                      = 1;
-                            }
+  Precondition:
+    None
 
-                            // Reset all ping-pong buffers if they are being used.
-                            U1CONbits.PPBRST                    = 1;
-                            U1CONbits.PPBRST                    = 0;
-                            usbDeviceInfo.flags.bfPingPongIn    = 0;
-                            usbDeviceInfo.flags.bfPingPongOut   = 0;
+  Parameters:
+    USB_EVENT vbusEvent     - Vbus event that occured.  Valid events:
+                                    * EVENT_VBUS_OVERCURRENT
+                                    * EVENT_VBUS_POWER_AVAILABLE
+    uint8_t hubAddress         - Address of the hub device (USB_ROOT_HUB for the
+                                root hub)
+    uint8_t portNumber         - Number of the physical port on the hub (0 - based)
 
-                            #ifdef  USB_SUPPORT_OTG
-                                //Disable HNP
-                                USBOTGDisableHnp();
-                                USBOTGDeactivateHnp();
-                            #endif
+  Return Values:
+    USB_SUCCESS             - Event handled
+    USB_ILLEGAL_REQUEST     - Invalid event, hub, or port
 
-                            // Assert reset for 10ms.  Start a timer countdown.
-                            U1CONbits.USBRST                    = 1;
-                            numTimerInterrupts                  = USB_RESET_TIME;
-                            //U1OTGIRbits.T1MSECIF                = 1;       // The interrupt is cleared by writing a '1' to the flag.
-                            U1OTGIR                             = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
-                            U1OTGIEbits.T1MSECIE                = 1;
+  Remarks:
+    None
+  ***************************************************************************/
 
-                            _USB_SetNextSubSubState();
-                            break;
+uint8_t  USBHostVbusEvent(USB_EVENT vbusEvent, uint8_t hubAddress, uint8_t portNumber)
+{
+    if ((hubAddress == USB_ROOT_HUB) &&
+        (portNumber == 0 ))
+    {
+        if (vbusEvent == EVENT_VBUS_OVERCURRENT)
+        {
+            USBHostShutdown();
+            usbRootHubInfo.flags.bPowerGoodPort0 = 0;
+            return USB_SUCCESS;
+        }
+        if (vbusEvent == EVENT_VBUS_POWER_AVAILABLE)
+        {
+            usbRootHubInfo.flags.bPowerGoodPort0 = 1;
+            return USB_SUCCESS;
+        }
+    }
 
-                        case SUBSUBSTATE_RESET_WAIT:
-                            // Wait for the timer to finish in the background.
-                            break;
+    return USB_ILLEGAL_REQUEST;
+}
 
-                        case SUBSUBSTATE_RESET_RECOVERY:
-#if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Reset complete.\r\n" );
-#endif
 
-                            // Deassert reset.
-                            U1CONbits.USBRST        = 0;
+/****************************************************************************
+  Function:
+    uint8_t USBHostWrite( uint8_t deviceAddress, uint8_t endpoint, uint8_t *data,
+                        uint32_t size )
 
-                            // Start sending SOF's.
-                            U1CONbits.SOFEN         = 1;
+  Summary:
+    This function initiates a write to the attached device.
 
-                            // Wait for the reset recovery time.
-                            numTimerInterrupts      = USB_RESET_RECOVERY_TIME;
-                            U1OTGIR                 = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
-                            U1OTGIEbits.T1MSECIE    = 1;
+  Description:
+    This function initiates a write to the attached device.  The data buffer
+    pointed to by *data must remain valid during the entire time that the
+    write is taking place; the data is not buffered by the stack.
 
-                            _USB_SetNextSubSubState();
-                            break;
+    If the endpoint is isochronous, special conditions apply.  The pData and
+    size parameters have slightly different meanings, since multiple buffers
+    are required.  Once started, an isochronous transfer will continue with
+    no upper layer intervention until USBHostTerminateTransfer() is called.
+    The ISOCHRONOUS_DATA_BUFFERS structure should not be manipulated until
+    the transfer is terminated.
 
-                        case SUBSUBSTATE_RECOVERY_WAIT:
-                            // Wait for the timer to finish in the background.
-                            break;
+    To clarify parameter usage and to simplify casting, use the macro
+    USBHostWriteIsochronous() when writing to an isochronous endpoint.
 
-                        case SUBSUBSTATE_RESET_COMPLETE:
-#if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Reset complete.\r\n" );
-#endif
+  Precondition:
+    None
 
-                            // Enable USB interrupts
-                            U1IE                    = USB_INTERRUPT_TRANSFER | USB_INTERRUPT_SOF | USB_INTERRUPT_ERROR | USB_INTERRUPT_DETACH;
-                            U1EIE                   = 0xFF;
+  Parameters:
+    uint8_t deviceAddress  - Device address
+    uint8_t endpoint       - Endpoint number
+    uint8_t *data          - Pointer to where the data is stored. If the endpoint
+                            is isochronous, this points to an
+                            ISOCHRONOUS_DATA_BUFFERS structure, with multiple
+                            data buffer pointers.
+    uint32_t size          - Number of data bytes to send. If the endpoint is
+                            isochronous, this is the number of data buffer
+                            pointers pointed to by pData.
 
-                            _USB_SetNextSubState();
-                            break;
+  Return Values:
+    USB_SUCCESS                     - Write started successfully.
+    USB_UNKNOWN_DEVICE              - Device with the specified address not found.
+    USB_INVALID_STATE               - We are not in a normal running state.
+    USB_ENDPOINT_ILLEGAL_TYPE       - Must use USBHostControlWrite to write
+                                        to a control endpoint.
+    USB_ENDPOINT_ILLEGAL_DIRECTION  - Must write to an OUT endpoint.
+    USB_ENDPOINT_STALLED            - Endpoint is stalled.  Must be cleared
+                                        by the application.
+    USB_ENDPOINT_ERROR              - Endpoint has too many errors.  Must be
+                                        cleared by the application.
+    USB_ENDPOINT_BUSY               - A Write is already in progress.
+    USB_ENDPOINT_NOT_FOUND          - Invalid endpoint.
 
-                        default:
-                            // We shouldn't get here.
-                            break;
-                    }
-                    break;
+  Remarks:
+    None
+  ***************************************************************************/
 
-                case SUBSTATE_GET_DEVICE_DESCRIPTOR_SIZE:
-                    // Send the GET DEVICE DESCRIPTOR command to get just the size
-                    // of the descriptor and the max packet size, so we can allocate
-                    // a large enough buffer for getting the whole thing and enough
-                    // buffer space for each piece.
-                    switch (usbHostState & SUBSUBSTATE_MASK)
-                    {
-                        case SUBSUBSTATE_SEND_GET_DEVICE_DESCRIPTOR_SIZE:
-#if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Getting Device Descriptor size.\r\n" );
-#endif
+uint8_t USBHostWrite( uint8_t deviceAddress, uint8_t endpoint, uint8_t *data, uint32_t size )
+{
+    USB_DEVICE_INFO   *pDevice;
+    USB_ENDPOINT_INFO *ep;
 
-                            // Set up and send GET DEVICE DESCRIPTOR
-                            if (pDeviceDescriptor != NULL)
-                            {
-                                USB_FREE_AND_CLEAR( pDeviceDescriptor );
-                            }
+    // Find the required device
+    pDevice = _USB_FindDevice( deviceAddress );
+    if (pDevice == NULL)
+    {
+        return USB_UNKNOWN_DEVICE;
+    }
 
-                            pEP0Data[0] = USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
-                            pEP0Data[1] = USB_REQUEST_GET_DESCRIPTOR;
-                            pEP0Data[2] = 0; // Index
-                            pEP0Data[3] = USB_DESCRIPTOR_DEVICE; // Type
-                            pEP0Data[4] = 0;
-                            pEP0Data[5] = 0;
-                            pEP0Data[6] = 8;
-                            pEP0Data[7] = 0;
+    // If we are not in a normal user running state, we cannot do this.
+    if ((pDevice->state & STATE_MASK) != STATE_RUNNING)
+    {
+        return USB_INVALID_STATE;
+    }
 
-                            _USB_InitControlRead( usbDeviceInfo.pEndpoint0, pEP0Data, 8, pEP0Data, 8 );
-                            _USB_SetNextSubSubState();
-                            break;
+    ep = _USB_FindEndpoint( pDevice, endpoint );
+    if (ep != NULL)
+    {
+        if (ep->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_CONTROL)
+        {
+            // Must not be a control endpoint.
+            return USB_ENDPOINT_ILLEGAL_TYPE;
+        }
 
-                        case SUBSUBSTATE_WAIT_FOR_GET_DEVICE_DESCRIPTOR_SIZE:
-                            if (usbDeviceInfo.pEndpoint0->status.bfTransferComplete)
-                            {
-                                if (usbDeviceInfo.pEndpoint0->status.bfTransferSuccessful)
-                                {
-                                    #ifndef USB_HUB_SUPPORT_INCLUDED
-                                        // See if a hub is attached.  Hubs are not supported.
-                                        if (pEP0Data[4] == USB_HUB_CLASSCODE)   // bDeviceClass
-                                        {
-                                            _USB_SetErrorCode( USB_HOLDING_UNSUPPORTED_HUB );
-                                            _USB_SetHoldState();
-                                        }
-                                        else
-                                        {
-                                            _USB_SetNextSubSubState();
-                                        }
-                                    #else
-                                        _USB_SetNextSubSubState();
-                                    #endif
-                                }
-                                else
-                                {
-                                    // We are here because of either a STALL or a NAK.  See if
-                                    // we have retries left to try the command again or try to
-                                    // enumerate again.
-                                    _USB_CheckCommandAndEnumerationAttempts();
-                                }
-                            }
-                            break;
+        if (ep->bEndpointAddress & 0x80)
+        {
+            // Trying to do an OUT with an IN endpoint.
+            return USB_ENDPOINT_ILLEGAL_DIRECTION;
+        }
 
-                        case SUBSUBSTATE_GET_DEVICE_DESCRIPTOR_SIZE_COMPLETE:
-                            // Allocate a buffer for the entire Device Descriptor
-                            if ((pDeviceDescriptor = (uint8_t *)USB_MALLOC( *pEP0Data )) == NULL)
-                            {
-                                // We cannot continue.  Freeze until the device is removed.
-                                _USB_SetErrorCode( USB_HOLDING_OUT_OF_MEMORY );
-                                _USB_SetHoldState();
-                                break;
-                            }
-                            // Save the descriptor size in the descriptor (bLength)
-                            *pDeviceDescriptor = *pEP0Data;
+        if (ep->status.bfStalled)
+        {
+            // The endpoint is stalled.  It must be restarted before a write
+            // can be performed.
+            return USB_ENDPOINT_STALLED;
+        }
 
-                            // Set the EP0 packet size.
-                            usbDeviceInfo.pEndpoint0->wMaxPacketSize = ((USB_DEVICE_DESCRIPTOR *)pEP0Data)->bMaxPacketSize0;
+        if (ep->status.bfError)
+        {
+            // The endpoint has errored.  The error must be cleared before a
+            // write can be performed.
+            return USB_ENDPOINT_ERROR;
+        }
 
-                            // Make our pEP0Data buffer the size of the max packet.
-                            USB_FREE_AND_CLEAR( pEP0Data );
-                            if ((pEP0Data = (uint8_t *)USB_MALLOC( usbDeviceInfo.pEndpoint0->wMaxPacketSize )) == NULL)
-                            {
-                                // We cannot continue.  Freeze until the device is removed.
-#if defined (DEBUG_ENABLE)
-                                DEBUG_PutString( "HOST: Error re-alloc-ing pEP0Data\r\n" );
-#endif
+        if (!ep->status.bfTransferComplete)
+        {
+            // We are already processing a request for this endpoint.
+            return USB_ENDPOINT_BUSY;
+        }
 
-                                _USB_SetErrorCode( USB_HOLDING_OUT_OF_MEMORY );
-                                _USB_SetHoldState();
-                                break;
-                            }
+        _USB_InitWrite( ep, data, size );
+        _USB_MarkEndpointReady( pDevice, ep );
+        #if defined( USB_SUPPORT_BULK_TRANSFERS )
+            _USB_ReopenBulkPass( ep );
+        #endif
 
-                            // Clean up and advance to the next substate.
-                            _USB_InitErrorCounters();
-                            _USB_SetNextSubState();
-                            break;
+        return USB_SUCCESS;
+    }
+    return USB_ENDPOINT_NOT_FOUND;   // Endpoint not found
+}
 
-                        default:
-                            break;
-                    }
-                    break;
 
-                case SUBSTATE_GET_DEVICE_DESCRIPTOR:
-                    // Send the GET DEVICE DESCRIPTOR command and receive the response
-                    switch (usbHostState & SUBSUBSTATE_MASK)
-                    {
-                        case SUBSUBSTATE_SEND_GET_DEVICE_DESCRIPTOR:
-#if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Getting device descriptor.\r\n" );
-#endif
+// *****************************************************************************
+// *****************************************************************************
+// Section: Internal Functions
+// *****************************************************************************
+// *****************************************************************************
 
-                            // If we are currently sending a token, we cannot do anything.
-                            if (usbBusInfo.flags.bfTokenAlreadyWritten)   //(U1CONbits.TOKBUSY)
-                                break;
+/****************************************************************************
+  Function:
+    void * _USB_AllocEnumerationMemory( uint16_t size )
 
-                            // Set up and send GET DEVICE DESCRIPTOR
-                            pEP0Data[0] = USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
-                            pEP0Data[1] = USB_REQUEST_GET_DESCRIPTOR;
-                            pEP0Data[2] = 0; // Index
-                            pEP0Data[3] = USB_DESCRIPTOR_DEVICE; // Type
-                            pEP0Data[4] = 0;
-                            pEP0Data[5] = 0;
-                            pEP0Data[6] = *pDeviceDescriptor;
-                            pEP0Data[7] = 0;
-                            _USB_InitControlRead( usbDeviceInfo.pEndpoint0, pEP0Data, 8, pDeviceDescriptor, *pDeviceDescriptor  );
-                            _USB_SetNextSubSubState();
-                            break;
+  Description:
+    This function allocates a block from the enumeration arena of
+    pCurrentDevice.
 
-                        case SUBSUBSTATE_WAIT_FOR_GET_DEVICE_DESCRIPTOR:
-                            if (usbDeviceInfo.pEndpoint0->status.bfTransferComplete)
-                            {
-                                if (usbDeviceInfo.pEndpoint0->status.bfTransferSuccessful)
-                                {
-                                    _USB_SetNextSubSubState();
-                                }
-                                else
-                                {
-                                    // We are here because of either a STALL or a NAK.  See if
-                                    // we have retries left to try the command again or try to
-                                    // enumerate again.
-                                    _USB_CheckCommandAndEnumerationAttempts();
-                                }
-                            }
-                            break;
+  Precondition:
+    None
 
-                        case SUBSUBSTATE_GET_DEVICE_DESCRIPTOR_COMPLETE:
-                            // Clean up and advance to the next substate.
-                            _USB_InitErrorCounters();
-                            _USB_SetNextSubState();
-                            break;
+  Parameters:
+    uint16_t size   - Number of bytes needed
 
-                        default:
-                            break;
-                    }
-                    break;
+  Returns:
+    Pointer to the block, or NULL if it does not fit.
 
-                case SUBSTATE_VALIDATE_VID_PID:
-#if defined (DEBUG_ENABLE)
-                    DEBUG_PutString( "HOST: Validating VID and PID.\r\n" );
-#endif
+  Remarks:
+    Blocks are not freed individually.  See _USB_FreeConfigMemory() and
+    _USB_FreeMemory().
+  ***************************************************************************/
 
-                    // Search the TPL for the device's VID & PID.  If a client driver is
-                    // available for the over-all device, use it.  Otherwise, we'll search
-                    // again later for an appropriate class driver.
-                    _USB_FindDeviceLevelClientDriver();
+void * _USB_AllocEnumerationMemory( uint16_t size )
+{
+    void    *pBlock;
 
-                    // Advance to the next state to assign an address to the device.
-                    //
-                    // Note: We assign an address to all devices and hold later if
-                    // we can't find a supported configuration.
-                    _USB_SetNextState();
-                    break;
-            }
-            break;
+    size = (size + (USB_ENUMERATION_ARENA_ALIGNMENT - 1)) & ~(USB_ENUMERATION_ARENA_ALIGNMENT - 1);
+    if ((size == 0) || (size > (USB_ENUMERATION_ARENA_SIZE - pCurrentDevice->arena.top)))
+    {
+        pCurrentDevice->arena.failedAllocations ++;
+        return NULL;
+    }
 
-        case STATE_ADDRESSING:
-            switch (usbHostState & SUBSTATE_MASK)
-            {
-                case SUBSTATE_SET_DEVICE_ADDRESS:
-                    // Send the SET ADDRESS command.  We can't set the device address
-                    // in hardware until the entire transaction is complete.
-                    switch (usbHostState & SUBSUBSTATE_MASK)
-                    {
-                        case SUBSUBSTATE_SEND_SET_DEVICE_ADDRESS:
-#if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Setting device address.\r\n" );
-#endif
+    pBlock = (uint8_t *)usbEnumerationMemory[pCurrentDevice - usbDeviceInfo] + pCurrentDevice->arena.top;
+    pCurrentDevice->arena.top += size;
+    if (pCurrentDevice->arena.top > pCurrentDevice->arena.highWater)
+    {
+        pCurrentDevice->arena.highWater = pCurrentDevice->arena.top;
+    }
 
-                            // Select an address for the device.  Store it so we can access it again
-                            // easily.  We'll put the low speed indicator on later.
-                            // This has been broken out so when we allow multiple devices, we have
-                            // a single interface point to allocate a new address.
-                            usbDeviceInfo.deviceAddress = USB_SINGLE_DEVICE_ADDRESS;
+    return pBlock;
+}
 
-                            // Set up and send SET ADDRESS
-                            pEP0Data[0] = USB_SETUP_HOST_TO_DEVICE | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
-                            pEP0Data[1] = USB_REQUEST_SET_ADDRESS;
-                            pEP0Data[2] = usbDeviceInfo.deviceAddress;
-                            pEP0Data[3] = 0;
-                            pEP0Data[4] = 0;
-                            pEP0Data[5] = 0;
-                            pEP0Data[6] = 0;
-                            pEP0Data[7] = 0;
-                            _USB_InitControlWrite( usbDeviceInfo.pEndpoint0, pEP0Data, 8, NULL, 0 );
-                            _USB_SetNextSubSubState();
-                            break;
 
-                        case SUBSUBSTATE_WAIT_FOR_SET_DEVICE_ADDRESS:
-                            if (usbDeviceInfo.pEndpoint0->status.bfTransferComplete)
-                            {
-                                if (usbDeviceInfo.pEndpoint0->status.bfTransferSuccessful)
-                                {
-                                    _USB_SetNextSubSubState();
-                                }
-                                else
-                                {
-                                    // We are here because of either a STALL or a NAK.  See if
-                                    // we have retries left to try the command again or try to
-                                    // enumerate again.
-                                    _USB_CheckCommandAndEnumerationAttempts();
-                                }
-                            }
-                            break;
+/****************************************************************************
+  Function:
+    void _USB_CheckCommandAndEnumerationAttempts( void )
 
-                        case SUBSUBSTATE_SET_DEVICE_ADDRESS_COMPLETE:
-                            // Set the device's address here.
-                            usbDeviceInfo.deviceAddressAndSpeed = (usbDeviceInfo.flags.bfIsLowSpeed << 7) | usbDeviceInfo.deviceAddress;
+  Summary:
+    This function is called when we've received a STALL or a NAK when trying
+    to enumerate.
 
-                            // Clean up and advance to the next state.
-                            _USB_InitErrorCounters();
-                            _USB_SetNextState();
-                            break;
+  Description:
+    This function is called when we've received a STALL or a NAK when trying
+    to enumerate.  We allow so many attempts at each command, and so many
+    attempts at enumeration.  If the command fails and there are more command
+    attempts, we try the command again.  If the command fails and there are
+    more enumeration attempts, we reset and try to enumerate again.
+    Otherwise, we go to the holding state.
 
-                        default:
-                            break;
-                    }
-                    break;
-            }
-            break;
+  Precondition:
+    pCurrentDevice->state != STATE_RUNNING
 
-        case STATE_CONFIGURING:
-            switch (usbHostState & SUBSTATE_MASK)
-            {
-                case SUBSTATE_INIT_CONFIGURATION:
-                    // Delete the old list of configuration descriptors and
-                    // initialize the counter.  We will request the descriptors
-                    // from highest to lowest so the lowest will be first in
-                    // the list.
-                    countConfigurations = ((USB_DEVICE_DESCRIPTOR *)pDeviceDescriptor)->bNumConfigurations;
-                    while (usbDeviceInfo.pConfigurationDescriptorList != NULL)
-                    {
-                        pTemp = (uint8_t *)usbDeviceInfo.pConfigurationDescriptorList->next;
-                        USB_FREE_AND_CLEAR( usbDeviceInfo.pConfigurationDescriptorList->descriptor );
-                        USB_FREE_AND_CLEAR( usbDeviceInfo.pConfigurationDescriptorList );
-                        usbDeviceInfo.pConfigurationDescriptorList = (USB_CONFIGURATION *)pTemp;
-                    }
-                    _USB_SetNextSubState();
-                    break;
+  Parameters:
+    None - None
 
-                case SUBSTATE_GET_CONFIG_DESCRIPTOR_SIZE:
-                    // Get the size of the Configuration Descriptor for the current configuration
-                    switch (usbHostState & SUBSUBSTATE_MASK)
-                    {
-                        case SUBSUBSTATE_SEND_GET_CONFIG_DESCRIPTOR_SIZE:
+  Returns:
+    None
+
+  Remarks:
+    Only the device on the root port can be reset from here.  A device
+    behind the hub goes to the holding state once its command attempts are
+    used up.
+  ***************************************************************************/
+
+void _USB_CheckCommandAndEnumerationAttempts( void )
+{
 #if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Getting Config Descriptor size.\r\n" );
+    DEBUG_PutChar( '=' );
 #endif
 
-                            // Set up and send GET CONFIGURATION (n) DESCRIPTOR with a length of 8
-                            pEP0Data[0] = USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
-                            pEP0Data[1] = USB_REQUEST_GET_DESCRIPTOR;
+    // Clear the error and stall flags.  A stall here does not require
+    // host intervention to clear.  pCurrentEndpoint may already belong to
+    // another device.
+    pCurrentDevice->pEndpoint0->status.bfError    = 0;
+    pCurrentDevice->pEndpoint0->status.bfStalled  = 0;
 
-                            //MCHP: probably should get all of the configuration descriptors.
-                            pEP0Data[2] = 0;
-//                            pEP0Data[2] = countConfigurations-1;    // USB 2.0 - range is 0 - count-1
-                            pEP0Data[3] = USB_DESCRIPTOR_CONFIGURATION;
-                            pEP0Data[4] = 0;
-                            pEP0Data[5] = 0;
-                            pEP0Data[6] = 8;
-                            pEP0Data[7] = 0;
-                            _USB_InitControlRead( usbDeviceInfo.pEndpoint0, pEP0Data, 8, pEP0Data, 8 );
-                            _USB_SetNextSubSubState();
-                            break;
+    pCurrentDevice->numCommandTries --;
+    if (pCurrentDevice->numCommandTries != 0)
+    {
+        // We still have retries left on this command.  Try again.
+        pCurrentDevice->state &= ~SUBSUBSTATE_MASK;
+    }
+    else
+    {
+        // This command has timed out.
+        // We are enumerating.  See if we can try to enumerate again.
+        pCurrentDevice->numEnumerationTries --;
+        if ((pCurrentDevice->numEnumerationTries != 0) && (pCurrentDevice->hubAddress == 0))
+        {
+            // We still have retries left to try to enumerate.  Reset and try again.
+            pCurrentDevice->state = STATE_ATTACHED | SUBSTATE_RESET_DEVICE;
+        }
+        else
+        {
+            // Give up.  The device is not responding properly.
+            _USB_SetErrorCode( USB_CANNOT_ENUMERATE );
+            _USB_SetHoldState();
+        }
+    }
+}
 
-                        case SUBSUBSTATE_WAIT_FOR_GET_CONFIG_DESCRIPTOR_SIZE:
-                            if (usbDeviceInfo.pEndpoint0->status.bfTransferComplete)
-                            {
-                                if (usbDeviceInfo.pEndpoint0->status.bfTransferSuccessful)
-                                {
-                                    _USB_SetNextSubSubState();
-                                }
-                                else
-                                {
-                                    // We are here because of either a STALL or a NAK.  See if
-                                    // we have retries left to try the command again or try to
-                                    // enumerate again.
-                                    _USB_CheckCommandAndEnumerationAttempts();
-                                }
-                            }
-                            break;
 
-                        case SUBSUBSTATE_GET_CONFIG_DESCRIPTOR_SIZECOMPLETE:
-                            // Allocate a buffer for an entry in the configuration descriptor list.
-                            if ((pTemp = (uint8_t *)USB_MALLOC( sizeof (USB_CONFIGURATION) )) == NULL)
-                            {
-                                // We cannot continue.  Freeze until the device is removed.
-                                _USB_SetErrorCode( USB_HOLDING_OUT_OF_MEMORY );
-                                _USB_SetHoldState();
-                                break;
-                            }
+/****************************************************************************
+  Function:
+    void _USB_DetachHubDevice( USB_DEVICE_INFO *pDevice )
 
-                            // Allocate a buffer for the entire Configuration Descriptor
-                            if ((((USB_CONFIGURATION *)pTemp)->descriptor = (uint8_t *)USB_MALLOC( ((uint16_t)pEP0Data[3] << 8) + (uint16_t)pEP0Data[2] )) == NULL)
-                            {
-                                // Not enough memory for the descriptor!
-                                USB_FREE_AND_CLEAR( pTemp );
+  Description:
+    This function removes a device behind the hub.  Its client drivers are
+    sent EVENT_DETACH, its memory is freed, and its entry in the device
+    table is released.
 
-                                // We cannot continue.  Freeze until the device is removed.
-                                _USB_SetErrorCode( USB_HOLDING_OUT_OF_MEMORY );
-                                _USB_SetHoldState();
-                                break;
-                            }
+  Precondition:
+    pDevice is a device behind the hub.
 
-                            // Save wTotalLength
-                            ((USB_CONFIGURATION_DESCRIPTOR *)((USB_CONFIGURATION *)pTemp)->descriptor)->wTotalLength =
-                                    ((uint16_t)pEP0Data[3] << 8) + (uint16_t)pEP0Data[2];
+  Parameters:
+    USB_DEVICE_INFO *pDevice    - The device.
 
-                            // Put the new node at the front of the list.
-                            ((USB_CONFIGURATION *)pTemp)->next = usbDeviceInfo.pConfigurationDescriptorList;
-                            usbDeviceInfo.pConfigurationDescriptorList = (USB_CONFIGURATION *)pTemp;
+  Returns:
+    None
 
-                            // Save the configuration descriptor pointer and number
-                            pCurrentConfigurationDescriptor            = ((USB_CONFIGURATION *)pTemp)->descriptor;
-                            ((USB_CONFIGURATION *)pTemp)->configNumber = countConfigurations;
+  Remarks:
+    A token to the device that is still on the bus completes into the
+    device's own endpoint blocks, which stay valid until the entry is
+    used again.
+  ***************************************************************************/
 
-                            // Clean up and advance to the next state.
-                            _USB_InitErrorCounters();
-                            _USB_SetNextSubState();
-                            break;
+#if defined( USB_HUB_SUPPORT_INCLUDED )
+void _USB_DetachHubDevice( USB_DEVICE_INFO *pDevice )
+{
+    #if defined( __C30__ ) || defined __XC16__ || defined( USB_SIMULATOR )
+        uint16_t        interrupt_mask;
+    #elif defined( __PIC32MX__ )
+        uint32_t        interrupt_mask;
+    #else
+        #error Cannot save interrupt status
+    #endif
+    USB_DEVICE_INFO     *pSavedDevice;
+    uint8_t             address;
 
-                        default:
-                            break;
-                    }
-                    break;
+    pSavedDevice    = pCurrentDevice;
+    pCurrentDevice  = pDevice;
 
-                case SUBSTATE_GET_CONFIG_DESCRIPTOR:
-                    // Get the entire Configuration Descriptor for this configuration
-                    switch (usbHostState & SUBSUBSTATE_MASK)
-                    {
-                        case SUBSUBSTATE_SEND_GET_CONFIG_DESCRIPTOR:
-#if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Getting Config Descriptor.\r\n" );
-#endif
+    address = pDevice->deviceAddress;
+    if (address != 0)
+    {
+        _USB_NotifyClients( address, EVENT_DETACH, &address, sizeof(uint8_t) );
+    }
 
-                            // Set up and send GET CONFIGURATION (n) DESCRIPTOR.
-                            pEP0Data[0] = USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
-                            pEP0Data[1] = USB_REQUEST_GET_DESCRIPTOR;
-                            //MCHP: probably should get all of the configuration descriptors.
-                            pEP0Data[2] = 0;
-                            pEP0Data[3] = USB_DESCRIPTOR_CONFIGURATION;
-                            pEP0Data[4] = 0;
-                            pEP0Data[5] = 0;
-                            pEP0Data[6] = usbDeviceInfo.pConfigurationDescriptorList->descriptor[2];    // wTotalLength
-                            pEP0Data[7] = usbDeviceInfo.pConfigurationDescriptorList->descriptor[3];
-                            _USB_InitControlRead( usbDeviceInfo.pEndpoint0, pEP0Data, 8, usbDeviceInfo.pConfigurationDescriptorList->descriptor,
-                                    ((USB_CONFIGURATION_DESCRIPTOR *)usbDeviceInfo.pConfigurationDescriptorList->descriptor)->wTotalLength );
-                            _USB_SetNextSubSubState();
-                            break;
+    // Guard against USB interrupts while the device leaves the table.
+    interrupt_mask = U1IE;
+    U1IE = 0;
 
-                        case SUBSUBSTATE_WAIT_FOR_GET_CONFIG_DESCRIPTOR:
-                            if (usbDeviceInfo.pEndpoint0->status.bfTransferComplete)
-                            {
-                                if (usbDeviceInfo.pEndpoint0->status.bfTransferSuccessful)
-                                {
-                                    _USB_SetNextSubSubState();
-                                }
-                                else
-                                {
-                                    // We are here because of either a STALL or a NAK.  See if
-                                    // we have retries left to try the command again or try to
-                                    // enumerate again.
-                                    _USB_CheckCommandAndEnumerationAttempts();
-                                }
-                            }
-                            break;
+    pDevice->hubAddress             = 0;
+    pDevice->hubPort                = 0;
+    pDevice->deviceAddress          = 0;
+    pDevice->deviceAddressAndSpeed  = 0;
+    pDevice->state                  = STATE_DETACHED;
 
-                        case SUBSUBSTATE_GET_CONFIG_DESCRIPTOR_COMPLETE:
-                            // Clean up and advance to the next state.  Keep the data for later use.
-                            _USB_InitErrorCounters();
-                            countConfigurations --;
-                            if (countConfigurations)
-                            {
-                                // There are more descriptors that we need to get.
-                                usbHostState = STATE_CONFIGURING | SUBSTATE_GET_CONFIG_DESCRIPTOR_SIZE;
-                            }
-                            else
-                            {
-                                // Start configuring the device.
-                                _USB_SetNextSubState();
-                              }
-                            break;
+    U1IE = interrupt_mask;
 
-                        default:
-                            break;
-                    }
-                    break;
+    _USB_FreeMemory();
 
-                case SUBSTATE_SELECT_CONFIGURATION:
-                    // Set the OTG configuration of the device
-                    switch (usbHostState & SUBSUBSTATE_MASK)
-                    {
-                        case SUBSUBSTATE_SELECT_CONFIGURATION:
-                            // Free the old configuration (if any)
-                            _USB_FreeConfigMemory();
+    pCurrentDevice = pSavedDevice;
+}
+#endif
 
-                            // If the configuration wasn't selected based on the VID & PID
-                            if (usbDeviceInfo.currentConfiguration == 0)
-                            {
-                                // Search for a supported class-specific configuration.
-                                pCurrentConfigurationNode = usbDeviceInfo.pConfigurationDescriptorList;
-                                while (pCurrentConfigurationNode)
-                                {
-                                    pCurrentConfigurationDescriptor = pCurrentConfigurationNode->descriptor;
-                                    if (_USB_ParseConfigurationDescriptor())
-                                    {
-                                        break;
-                                    }
-                                    else
-                                    {
-                                        // Free the memory allocated and
-                                        // advance to  next configuration
-                                        _USB_FreeConfigMemory();
-                                        pCurrentConfigurationNode = pCurrentConfigurationNode->next;
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                // Configuration selected by VID & PID, initialize data structures
-                                pCurrentConfigurationNode = usbDeviceInfo.pConfigurationDescriptorList;
-                                while (pCurrentConfigurationNode && pCurrentConfigurationNode->configNumber != usbDeviceInfo.currentConfiguration)
-                                {
-                                    pCurrentConfigurationNode = pCurrentConfigurationNode->next;
-                                }
-                                pCurrentConfigurationDescriptor = pCurrentConfigurationNode->descriptor;
-                                if (!_USB_ParseConfigurationDescriptor())
-                                {
-                                    // Free the memory allocated, config attempt failed.
-                                    _USB_FreeConfigMemory();
-                                    pCurrentConfigurationNode = NULL;
-                                }
-                            }
 
-                            //If No OTG Then
-                            if (usbDeviceInfo.flags.bfConfiguredOTG)
-                            {
-                                // Did we fail to configure?
-                                if (pCurrentConfigurationNode == NULL)
-                                {
-                                    // Failed to find a supported configuration.
-                                    _USB_SetErrorCode( USB_HOLDING_UNSUPPORTED_DEVICE );
-                                    _USB_SetHoldState();
-                                }
-                                else
-                                {
-                                    _USB_SetNextSubSubState();
-                                }
-                            }
-                            else
-                            {
-                                _USB_SetNextSubSubState();
-                            }
-                            break;
+/****************************************************************************
+  Function:
+    void _USB_DeviceTasks( void )
 
-                        case SUBSUBSTATE_SEND_SET_OTG:
-#if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Determine OTG capability.\r\n" );
-#endif
+  Description:
+    This function runs one step of the attach, enumeration, and
+    configuration state machine of pCurrentDevice.
 
-                            // If the device does not support OTG, or
-                            // if the device has already been configured, bail.
-                            // Otherwise, send SET FEATURE to configure it.
-                            if (!usbDeviceInfo.flags.bfConfiguredOTG)
-                            {
-#if defined (DEBUG_ENABLE)
-                                DEBUG_PutString( "HOST: ...OTG needs configuring.\r\n" );
-#endif
+  Precondition:
+    None
 
-                                usbDeviceInfo.flags.bfConfiguredOTG = 1;
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    The device on the root port goes through every state.  A device behind
+    the hub starts at SUBSTATE_GET_DEVICE_DESCRIPTOR_SIZE, after its hub
+    port has been reset (see USBHostHubPortAttach()), and never enters the
+    DETACHED states or suspends.
+  ***************************************************************************/
+
+void _USB_DeviceTasks( void )
+{
+    USB_CONFIGURATION           *pCurrentConfigurationNode;
+    USB_INTERFACE_INFO          *pCurrentInterface;
+    uint8_t                        *pTemp;
+    uint8_t                        temp;
+    USB_VBUS_POWER_EVENT_DATA   powerRequest;
+
+    switch (pCurrentDevice->state & STATE_MASK)
+    {
+        case STATE_DETACHED:
+            switch (pCurrentDevice->state & SUBSTATE_MASK)
+            {
+                case SUBSTATE_INITIALIZE:
+                    // We got here either from initialization or from the user
+                    // unplugging the device at any point in time.
+
+                    // Turn off the module and free up memory.
+                    USBHostShutdown();
 
-                                // Send SET FEATURE
-                                pEP0Data[0] = USB_SETUP_HOST_TO_DEVICE | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
-                                pEP0Data[1] = USB_REQUEST_SET_FEATURE;
-                                if (usbDeviceInfo.flags.bfAllowHNP) // Needs to be set by the user
-                                {
-                                    pEP0Data[2] = OTG_FEATURE_B_HNP_ENABLE;
-                                }
-                                else
-                                {
-                                    pEP0Data[2] = OTG_FEATURE_A_HNP_SUPPORT;
-                                }
-                                pEP0Data[3] = 0;
-                                pEP0Data[4] = 0;
-                                pEP0Data[5] = 0;
-                                pEP0Data[6] = 0;
-                                pEP0Data[7] = 0;
-                                _USB_InitControlWrite( usbDeviceInfo.pEndpoint0, pEP0Data, 8, NULL, 0 );
-                                _USB_SetNextSubSubState();
-                            }
-                            else
-                            {
 #if defined (DEBUG_ENABLE)
-                                DEBUG_PutString( "HOST: ...No OTG.\r\n" );
+                    DEBUG_PutString( "HOST: Initializing DETACHED state.\r\n" );
 #endif
 
-                                _USB_SetNextSubState();
-                            }
-                            break;
+                    // Initialize Endpoint 0 and the device information.
+                    _USB_InitDevice();
+                    usbBusInfo.flags.val                = 0;
+                    
+                    // Set up the hardware.
+                    U1IE                = 0;        // Clear and turn off interrupts.
+                    U1IR                = 0xFF;
+                    U1OTGIE             &= 0x8C;
+                    U1OTGIR             = 0x7D;
+                    U1EIE               = 0;
+                    U1EIR               = 0xFF;
 
-                        case SUBSUBSTATE_WAIT_FOR_SET_OTG_DONE:
-                            if (usbDeviceInfo.pEndpoint0->status.bfTransferComplete)
-                            {
-                                if (usbDeviceInfo.pEndpoint0->status.bfTransferSuccessful)
-                                {
-                                    #ifdef  USB_SUPPORT_OTG
-                                        if (usbDeviceInfo.flags.bfAllowHNP)
-                                        {
-                                            USBOTGEnableHnp();
-                                        }
-                                     #endif
-                                    _USB_SetNextSubSubState();
-                                }
-                                else
-                                {
-                                    #ifdef  USB_SUPPORT_OTG
-                                        USBOTGDisableHnp();
-                                    #endif
-                                    // We are here because of either a STALL or a NAK.  See if
-                                    // we have retries left to try the command again or try to
-                                    // enumerate again.
-                                    _USB_CheckCommandAndEnumerationAttempts();
+                    // Initialize the Buffer Descriptor Table pointer.
+                    #if defined(__C30__) || defined __XC16__
+                       U1BDTP1 = (uint16_t)(&BDT) >> 8;
+                    #elif defined(__PIC32MX__)
+                       U1BDTP1 = ((uint32_t)KVA_TO_PA(&BDT) & 0x0000FF00) >> 8;
+                       U1BDTP2 = ((uint32_t)KVA_TO_PA(&BDT) & 0x00FF0000) >> 16;
+                       U1BDTP3 = ((uint32_t)KVA_TO_PA(&BDT) & 0xFF000000) >> 24;
+                    #elif defined(USB_SIMULATOR)
+                       USBSimSetBDTAddress( BDT );
+                    #else
+                        #error Cannot set up the Buffer Descriptor Table pointer.
+                    #endif
 
-                                    #if defined(USB_SUPPORT_OTG)
+                    // Configure the module
+                    U1CON               = USB_HOST_MODE_ENABLE | USB_SOF_DISABLE;                       // Turn of SOF's to cut down noise
+                    U1CON               = USB_HOST_MODE_ENABLE | USB_PINGPONG_RESET | USB_SOF_DISABLE;  // Reset the ping-pong buffers
+                    U1CON               = USB_HOST_MODE_ENABLE | USB_SOF_DISABLE;                       // Release the ping-pong buffers
+                    #ifdef  USB_SUPPORT_OTG
+                        U1OTGCON            |= USB_DPLUS_PULLDOWN_ENABLE | USB_DMINUS_PULLDOWN_ENABLE | USB_OTG_ENABLE; // Pull down D+ and D-
+                    #else
+                        U1OTGCON            = USB_DPLUS_PULLDOWN_ENABLE | USB_DMINUS_PULLDOWN_ENABLE; // Pull down D+ and D-
+                    #endif
+
+                    #if defined(__PIC32MX__)
+                        U1OTGCON |= USB_VBUS_ON;
+                    #endif
+
+                    U1CNFG1             = USB_PING_PONG_MODE;
+                    #if defined(__C30__) || defined __XC16__
+                        U1CNFG2         = USB_VBUS_BOOST_ENABLE | USB_VBUS_COMPARE_ENABLE | USB_ONCHIP_ENABLE;
+                    #endif
+                    U1ADDR              = 0;                        // Set default address and LSPDEN to 0
+                    U1EP0bits.LSPD      = 0;
+                    U1SOF               = USB_SOF_THRESHOLD_64;     // Maximum EP0 packet size
+
+                    // Set the next substate.  We do this before we enable
+                    // interrupts in case the interrupt changes states.
+                    _USB_SetNextSubState();
+                    break;
+
+                case SUBSTATE_WAIT_FOR_POWER:
+                    // We will wait here until the application tells us we can
+                    // turn on power.
+                    if (usbRootHubInfo.flags.bPowerGoodPort0)
+                    {
+                        _USB_SetNextSubState();
+                    }
+                    break;
+
+                case SUBSTATE_TURN_ON_POWER:
+                    powerRequest.port       = 0;
+                    powerRequest.current    = USB_INITIAL_VBUS_CURRENT;
+                    if (USB_HOST_APP_EVENT_HANDLER( USB_ROOT_HUB, EVENT_VBUS_REQUEST_POWER,
+                            &powerRequest, sizeof(USB_VBUS_POWER_EVENT_DATA) ))
+                    {
+                        // Power on the module
+                        U1PWRC                = USB_NORMAL_OPERATION | USB_ENABLED;
+
+                        #if defined( __C30__ ) || defined __XC16__
+                            IFS5            &= 0xFFBF;
+                            IPC21           &= 0xF0FF;
+                            IPC21           |= 0x0600;
+                            IEC5            |= 0x0040;
+                        #elif defined( __PIC32MX__ )
+                            // Enable the USB interrupt.
+                            IFS1CLR         = _IFS1_USBIF_MASK;
+                            #if defined(_IPC11_USBIP_MASK)
+                                IPC11CLR        = _IPC11_USBIP_MASK | _IPC11_USBIS_MASK;
+                                IPC11SET        = _IPC11_USBIP_MASK & (0x00000004 << _IPC11_USBIP_POSITION);
+                            #elif defined(_IPC7_USBIP_MASK)
+                                IPC7CLR        = _IPC7_USBIP_MASK | _IPC7_USBIS_MASK;
+                                IPC7SET        = _IPC7_USBIP_MASK & (0x00000004 << _IPC7_USBIP_POSITION);
+                            #else
+                                #error "The selected PIC32 device is not currently supported by usb_host.c."
+                            #endif
+                            IEC1SET         = _IEC1_USBIE_MASK;                        
+                        #elif defined(USB_SIMULATOR)
+                            // The simulated controller calls the interrupt
+                            // handler from USBSimStep().
+                        #else
+                            #error Cannot enable USB interrupt.
+                        #endif
+
+                        // Set the next substate.  We do this before we enable
+                        // interrupts in case the interrupt changes states.
+                        _USB_SetNextSubState();
+
+                        // Enable the ATTACH interrupt.
+                        U1IEbits.ATTACHIE = 1;
+
+                        #if defined(USB_ENABLE_1MS_EVENT)
+                            U1OTGIR                 = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
+                            U1OTGIEbits.T1MSECIE    = 1;
+                        #endif
+                    }
+                    else
+                    {
+                        usbRootHubInfo.flags.bPowerGoodPort0 = 0;
+                        pCurrentDevice->state = STATE_DETACHED | SUBSTATE_WAIT_FOR_POWER;
+                    }
+                    break;
+
+                case SUBSTATE_WAIT_FOR_DEVICE:
+                    // Wait here for the ATTACH interrupt.
+                    #ifdef  USB_SUPPORT_OTG
+                        U1IEbits.ATTACHIE = 1;
+                    #endif
+                break;
+            }
+            break;
+
+        case STATE_ATTACHED:
+            switch (pCurrentDevice->state & SUBSTATE_MASK)
+            {
+                case SUBSTATE_SETTLE:
+                    // Wait 100ms for the insertion process to complete and power
+                    // at the device to be stable.
+                    switch (pCurrentDevice->state & SUBSUBSTATE_MASK)
+                    {
+                        case SUBSUBSTATE_START_SETTLING_DELAY:
 #if defined (DEBUG_ENABLE)
-                                        DEBUG_PutString( "\r\n***** USB OTG Error - Set Feature B_HNP_ENABLE Stalled - Device Not Responding *****\r\n" );
+                            DEBUG_PutString( "HOST: Starting settling delay.\r\n" );
 #endif
-                                    #endif
 
-                                }
-                            }
+                            // Clear and turn on the DETACH interrupt.
+                            U1IR                    = USB_INTERRUPT_DETACH;   // The interrupt is cleared by writing a '1' to the flag.
+                            U1IEbits.DETACHIE       = 1;
+
+                            // Configure and turn on the settling timer - 100ms.
+                            numTimerInterrupts      = USB_INSERT_TIME;
+                            U1OTGIR                 = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
+                            U1OTGIEbits.T1MSECIE    = 1;
+                            _USB_SetNextSubSubState();
                             break;
 
-                        case SUBSUBSTATE_SET_OTG_COMPLETE:
-                             // Clean up and advance to the next state.
-                           _USB_InitErrorCounters();
+                        case SUBSUBSTATE_WAIT_FOR_SETTLING:
+                            // Wait for the timer to finish in the background.
+                            break;
 
-                            //MR - Moved For OTG Set Feature Support For Unsupported Devices
-                            // Did we fail to configure?
-                            if (pCurrentConfigurationNode == NULL)
-                            {
-                                // Failed to find a supported configuration.
-                                _USB_SetErrorCode( USB_HOLDING_UNSUPPORTED_DEVICE );
-                                _USB_SetHoldState();
-                            }
-                            else
-                            {
-                                //_USB_SetNextSubSubState();
-                                _USB_InitErrorCounters();
-                                _USB_SetNextSubState();
-                            }
+                        case SUBSUBSTATE_SETTLING_DONE:
+                            _USB_SetNextSubState();
                             break;
 
                         default:
+                            // We shouldn't get here.
                             break;
                     }
                     break;
 
-                case SUBSTATE_SET_CONFIGURATION:
-                    // Set the configuration to the one specified for this device
-                    switch (usbHostState & SUBSUBSTATE_MASK)
+                case SUBSTATE_RESET_DEVICE:
+                    // Reset the device.  We have to do the reset timing ourselves.
+                    switch (pCurrentDevice->state & SUBSUBSTATE_MASK)
                     {
-                        case SUBSUBSTATE_SEND_SET_CONFIGURATION:
+                        case SUBSUBSTATE_SET_RESET:
 #if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Set configuration.\r\n" );
+                            DEBUG_PutString( "HOST: Resetting the device.\r\n" );
 #endif
 
-                            // Set up and send SET CONFIGURATION.
-                            pEP0Data[0] = USB_SETUP_HOST_TO_DEVICE | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
-                            pEP0Data[1] = USB_REQUEST_SET_CONFIGURATION;
-                            pEP0Data[2] = usbDeviceInfo.currentConfiguration;
-                            pEP0Data[3] = 0;
-                            pEP0Data[4] = 0;
-                            pEP0Data[5] = 0;
-                            pEP0Data[6] = 0;
-                            pEP0Data[7] = 0;
-                            _USB_InitControlWrite( usbDeviceInfo.pEndpoint0, pEP0Data, 8, NULL, 0 );
-                            _USB_SetNextSubSubState();
-                            break;
+                            // Drop everything left from an earlier enumeration attempt.
+                            _USB_FreeMemory();
 
-                        case SUBSUBSTATE_WAIT_FOR_SET_CONFIGURATION:
-                            if (usbDeviceInfo.pEndpoint0->status.bfTransferComplete)
-                            {
-                                if (usbDeviceInfo.pEndpoint0->status.bfTransferSuccessful)
-                                {
-                                    _USB_SetNextSubSubState();
-                                }
-                                else
-                                {
-                                    // We are here because of either a STALL or a NAK.  See if
-                                    // we have retries left to try the command again or try to
-                                    // enumerate again.
-                                    _USB_CheckCommandAndEnumerationAttempts();
-                                }
+                            // Prepare a data buffer for us to use.  We'll make it 8 bytes for now,
+                            // which is the minimum wMaxPacketSize for EP0.
+                            if ((pCurrentDevice->pEP0Data = (uint8_t *)_USB_AllocEnumerationMemory( 8 )) == NULL)
+                            {
+#if defined (DEBUG_ENABLE)
+                                DEBUG_PutString( "HOST: Error alloc-ing pCurrentDevice->pEP0Data\r\n" );
+#endif
+
+                                _USB_SetErrorCode( USB_HOLDING_OUT_OF_MEMORY );
+                                _USB_SetHoldState();
+                                break;
                             }
-                            break;
 
-                        case SUBSUBSTATE_SET_CONFIGURATION_COMPLETE:
-                            // Clean up and advance to the next state.
+                            // Initialize the USB Device information
+                            pCurrentDevice->currentConfiguration      = 0;
+                            pCurrentDevice->attributesOTG             = 0;
+                            pCurrentDevice->flags.val                 = 0;
+
                             _USB_InitErrorCounters();
-                            _USB_SetNextSubSubState();
-                            break;
 
-                        case SUBSUBSTATE_INIT_CLIENT_DRIVERS:
-#if defined (DEBUG_ENABLE)
-                            DEBUG_PutString( "HOST: Initializing client drivers...\r\n" );
-#endif
+                            // Disable all EP's except EP0.
+                            U1EP0  = USB_ENDPOINT_CONTROL_SETUP;
+                            U1EP1  = USB_DISABLE_ENDPOINT;
+                            U1EP2  = USB_DISABLE_ENDPOINT;
+                            U1EP3  = USB_DISABLE_ENDPOINT;
+                            U1EP4  = USB_DISABLE_ENDPOINT;
+                            U1EP5  = USB_DISABLE_ENDPOINT;
+                            U1EP6  = USB_DISABLE_ENDPOINT;
+                            U1EP7  = USB_DISABLE_ENDPOINT;
+                            U1EP8  = USB_DISABLE_ENDPOINT;
+                            U1EP9  = USB_DISABLE_ENDPOINT;
+                            U1EP10 = USB_DISABLE_ENDPOINT;
+                            U1EP11 = USB_DISABLE_ENDPOINT;
+                            U1EP12 = USB_DISABLE_ENDPOINT;
+                            U1EP13 = USB_DISABLE_ENDPOINT;
+                            U1EP14 = USB_DISABLE_ENDPOINT;
+                            U1EP15 = USB_DISABLE_ENDPOINT;
 
-                            _USB_SetNextState();
-                            // Initialize client driver(s) for this configuration.
-                            if (usbDeviceInfo.flags.bfUseDeviceClientDriver)
+                            // See if the device is low speed.
+                            if (!U1CONbits.JSTATE)
                             {
-                                // We have a device that requires only one client driver.  Make sure
-                                // that client driver can initialize this device.  If the client
-                                // driver initialization fails, we cannot enumerate this device.
 #if defined (DEBUG_ENABLE)
-                                DEBUG_PutString( "HOST: Using device client driver.\r\n" );
+                                DEBUG_PutString( "HOST: Low Speed!\r\n" );
 #endif
 
-                                temp = usbDeviceInfo.deviceClientDriver;
-                                if (!usbClientDrvTable[temp].Initialize(usbDeviceInfo.deviceAddress, usbClientDrvTable[temp].flags, temp))
-                                {
-                                    _USB_SetErrorCode( USB_HOLDING_CLIENT_INIT_ERROR );
-                                    _USB_SetHoldState();
-                                }
+                                pCurrentDevice->flags.bfIsLowSpeed      = 1;
+                                pCurrentDevice->deviceAddressAndSpeed   = 0x80;
+                                U1ADDR                                  = 0x80;
+                                U1EP0bits.LSPD                          = 1;
                             }
-                            else
-                            {
-                                // We have a device that requires multiple client drivers.  Make sure
-                                // every required client driver can initialize this device.  If any
-                                // client driver initialization fails, we cannot enumerate the device.
-#if defined (DEBUG_ENABLE)
-                                DEBUG_PutString( "HOST: Scanning interfaces.\r\n" );
-#endif
 
-                                pCurrentInterface = usbDeviceInfo.pInterfaceList;
-                                while (pCurrentInterface)
-                                {
-                                    temp = pCurrentInterface->clientDriver;
-                                    if (!usbClientDrvTable[temp].Initialize(usbDeviceInfo.deviceAddress, usbClientDrvTable[temp].flags, temp))
-                                    {
-                                        _USB_SetErrorCode( USB_HOLDING_CLIENT_INIT_ERROR );
-                                        _USB_SetHoldState();
-                                    }
-                                    pCurrentInterface = pCurrentInterface->next;
-                                }
-                            }
+                            // Reset all ping-pong buffers if they are being used.
+                            U1CONbits.PPBRST                    = 1;
+                            U1CONbits.PPBRST                    = 0;
+                            usbBusInfo.flags.bfPingPongIn       = 0;
+                            usbBusInfo.flags.bfPingPongOut      = 0;
 
-                            //Load the EP0 driver, if there was any
-                            if(usbDeviceInfo.flags.bfUseEP0Driver == 1)
-                            {
-                                temp = usbDeviceInfo.deviceEP0Driver;
-                                if (!usbClientDrvTable[temp].Initialize(usbDeviceInfo.deviceAddress, usbClientDrvTable[temp].flags, temp))
-                                {
-                                    _USB_SetErrorCode( USB_HOLDING_CLIENT_INIT_ERROR );
-                                    _USB_SetHoldState();
-                                }
-                            }
+                            #ifdef  USB_SUPPORT_OTG
+                                //Disable HNP
+                                USBOTGDisableHnp();
+                                USBOTGDeactivateHnp();
+                            #endif
+
+                            // Assert reset for 10ms.  Start a timer countdown.
+                            U1CONbits.USBRST                    = 1;
+                            numTimerInterrupts                  = USB_RESET_TIME;
+                            //U1OTGIRbits.T1MSECIF                = 1;       // The interrupt is cleared by writing a '1' to the flag.
+                            U1OTGIR                             = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
+                            U1OTGIEbits.T1MSECIE                = 1;
 
+                            _USB_SetNextSubSubState();
                             break;
 
-                        default:
+                        case SUBSUBSTATE_RESET_WAIT:
+                            // Wait for the timer to finish in the background.
                             break;
-                    }
-                    break;
-            }
-            break;
 
-        case STATE_RUNNING:
-            switch (usbHostState & SUBSTATE_MASK)
-            {
-                case SUBSTATE_NORMAL_RUN:
-                    break;
+                        case SUBSUBSTATE_RESET_RECOVERY:
+#if defined (DEBUG_ENABLE)
+                            DEBUG_PutString( "HOST: Reset complete.\r\n" );
+#endif
 
-                case SUBSTATE_SUSPEND_AND_RESUME:
-                    switch (usbHostState & SUBSUBSTATE_MASK)
-                    {
-                        case SUBSUBSTATE_SUSPEND:
-                            // The IDLE state has already been set.  We need to wait here
-                            // until the application decides to RESUME.
-                            break;
+                            // Deassert reset.
+                            U1CONbits.USBRST        = 0;
 
-                        case SUBSUBSTATE_RESUME:
-                            // Issue a RESUME.
-                            U1CONbits.RESUME = 1;
+                            // Start sending SOF's.
+                            U1CONbits.SOFEN         = 1;
 
-                            // Wait for the RESUME time.
-                            numTimerInterrupts      = USB_RESUME_TIME;
+                            // Wait for the reset recovery time.
+                            numTimerInterrupts      = USB_RESET_RECOVERY_TIME;
                             U1OTGIR                 = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
                             U1OTGIEbits.T1MSECIE    = 1;
 
                             _USB_SetNextSubSubState();
                             break;
 
-                        case SUBSUBSTATE_RESUME_WAIT:
-                            // Wait here until the timer expires.
+                        case SUBSUBSTATE_RECOVERY_WAIT:
+                            // Wait for the timer to finish in the background.
                             break;
 
-                        case SUBSUBSTATE_RESUME_RECOVERY:
-                            // Turn off RESUME.
-                            U1CONbits.RESUME        = 0;
-
-                            // Start sending SOF's, so the device doesn't go back into the SUSPEND state.
-                            U1CONbits.SOFEN         = 1;
-
-                            // Wait for the RESUME recovery time.
-                            numTimerInterrupts      = USB_RESUME_RECOVERY_TIME;
-                            U1OTGIR                 = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
-                            U1OTGIEbits.T1MSECIE    = 1;
+                        case SUBSUBSTATE_RESET_COMPLETE:
+#if defined (DEBUG_ENABLE)
+                            DEBUG_PutString( "HOST: Reset complete.\r\n" );
+#endif
 
-                            _USB_SetNextSubSubState();
-                            break;
+                            // Enable USB interrupts
+                            U1IE                    = USB_INTERRUPT_TRANSFER | USB_INTERRUPT_SOF | USB_INTERRUPT_ERROR | USB_INTERRUPT_DETACH;
+                            U1EIE                   = 0xFF;
 
-                        case SUBSUBSTATE_RESUME_RECOVERY_WAIT:
-                            // Wait here until the timer expires.
+                            _USB_SetNextSubState();
                             break;
 
-                        case SUBSUBSTATE_RESUME_COMPLETE:
-                            // Go back to normal running.
-                            usbHostState = STATE_RUNNING | SUBSTATE_NORMAL_RUN;
+                        default:
+                            // We shouldn't get here.
                             break;
                     }
-            }
-            break;
+                    break;
 
-        case STATE_HOLDING:
-            switch (usbHostState & SUBSTATE_MASK)
-            {
-                case SUBSTATE_HOLD_INIT:
-                    // We're here because we cannot communicate with the current device
-                    // that is plugged in.  Turn off SOF's and all interrupts except
-                    // the DETACH interrupt.
+                case SUBSTATE_GET_DEVICE_DESCRIPTOR_SIZE:
+                    // Send the GET DEVICE DESCRIPTOR command to get just the size
+                    // of the descriptor and the max packet size, so we can allocate
+                    // a large enough buffer for getting the whole thing and enough
+                    // buffer space for each piece.
+                    switch (pCurrentDevice->state & SUBSUBSTATE_MASK)
+                    {
+                        case SUBSUBSTATE_SEND_GET_DEVICE_DESCRIPTOR_SIZE:
 #if defined (DEBUG_ENABLE)
-                    DEBUG_PutString( "HOST: Holding.\r\n" );
+                            DEBUG_PutString( "HOST: Getting Device Descriptor size.\r\n" );
 #endif
 
-                    U1CON               = USB_HOST_MODE_ENABLE | USB_SOF_DISABLE;                       // Turn of SOF's to cut down noise
-                    U1IE                = 0;
-                    U1IR                = 0xFF;
-                    U1OTGIE             &= 0x8C;
-                    U1OTGIR             = 0x7D;
-                    U1EIE               = 0;
-                    U1EIR               = 0xFF;
-                    U1IEbits.DETACHIE   = 1;
-
-                    #if defined(USB_ENABLE_1MS_EVENT)
-                        U1OTGIR                 = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
-                        U1OTGIEbits.T1MSECIE    = 1;
-                    #endif
+                            // Set up and send GET DEVICE DESCRIPTOR
+                            pCurrentDevice->pEP0Data[0] = USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
+                            pCurrentDevice->pEP0Data[1] = USB_REQUEST_GET_DESCRIPTOR;
+                            pCurrentDevice->pEP0Data[2] = 0; // Index
+                            pCurrentDevice->pEP0Data[3] = USB_DESCRIPTOR_DEVICE; // Type
+                            pCurrentDevice->pEP0Data[4] = 0;
+                            pCurrentDevice->pEP0Data[5] = 0;
+                            pCurrentDevice->pEP0Data[6] = 8;
+                            pCurrentDevice->pEP0Data[7] = 0;
+
+                            _USB_InitControlRead( pCurrentDevice->pEndpoint0, pCurrentDevice->pEP0Data, 8, pCurrentDevice->pEP0Data, 8 );
+                            _USB_SetNextSubSubState();
+                            break;
 
-                    switch (usbDeviceInfo.errorCode )
-                    {
-                        case USB_HOLDING_UNSUPPORTED_HUB:
-                            temp = EVENT_HUB_ATTACH;
+                        case SUBSUBSTATE_WAIT_FOR_GET_DEVICE_DESCRIPTOR_SIZE:
+                            if (pCurrentDevice->pEndpoint0->status.bfTransferComplete)
+                            {
+                                if (pCurrentDevice->pEndpoint0->status.bfTransferSuccessful)
+                                {
+                                    #ifndef USB_HUB_SUPPORT_INCLUDED
+                                        // See if a hub is attached.  Hubs are not supported.
+                                        if (pCurrentDevice->pEP0Data[4] == USB_HUB_CLASSCODE)   // bDeviceClass
+                                        {
+                                            _USB_SetErrorCode( USB_HOLDING_UNSUPPORTED_HUB );
+                                            _USB_SetHoldState();
+                                        }
+                                        else
+                                        {
+                                            _USB_SetNextSubSubState();
+                                        }
+                                    #else
+                                        _USB_SetNextSubSubState();
+                                    #endif
+                                }
+                                else
+                                {
+                                    // We are here because of either a STALL or a NAK.  See if
+                                    // we have retries left to try the command again or try to
+                                    // enumerate again.
+                                    _USB_CheckCommandAndEnumerationAttempts();
+                                }
+                            }
                             break;
 
-                        case USB_HOLDING_UNSUPPORTED_DEVICE:
-                            temp = EVENT_UNSUPPORTED_DEVICE;
+                        case SUBSUBSTATE_GET_DEVICE_DESCRIPTOR_SIZE_COMPLETE:
+                            // Allocate a buffer for the entire Device Descriptor
+                            if ((pCurrentDevice->pDeviceDescriptor = (uint8_t *)_USB_AllocEnumerationMemory( *pCurrentDevice->pEP0Data )) == NULL)
+                            {
+                                // We cannot continue.  Freeze until the device is removed.
+                                _USB_SetErrorCode( USB_HOLDING_OUT_OF_MEMORY );
+                                _USB_SetHoldState();
+                                break;
+                            }
+                            // Save the descriptor size in the descriptor (bLength)
+                            *pCurrentDevice->pDeviceDescriptor = *pCurrentDevice->pEP0Data;
 
-                            #ifdef  USB_SUPPORT_OTG
-                            //Abort HNP
-                            USB_OTGEventHandler (0, OTG_EVENT_HNP_ABORT , 0, 0 );
-                            #endif
+                            // Set the EP0 packet size.
+                            pCurrentDevice->pEndpoint0->wMaxPacketSize = ((USB_DEVICE_DESCRIPTOR *)pCurrentDevice->pEP0Data)->bMaxPacketSize0;
 
-                            break;
+                            // Make our pEP0Data buffer the size of the max packet.  The
+                            // 8 byte buffer stays in the arena until the next reset.
+                            if ((pCurrentDevice->pEP0Data = (uint8_t *)_USB_AllocEnumerationMemory( pCurrentDevice->pEndpoint0->wMaxPacketSize )) == NULL)
+                            {
+                                // We cannot continue.  Freeze until the device is removed.
+#if defined (DEBUG_ENABLE)
+                                DEBUG_PutString( "HOST: Error re-alloc-ing pCurrentDevice->pEP0Data\r\n" );
+#endif
 
-                        case USB_CANNOT_ENUMERATE:
-                            temp = EVENT_CANNOT_ENUMERATE;
-                            break;
+                                _USB_SetErrorCode( USB_HOLDING_OUT_OF_MEMORY );
+                                _USB_SetHoldState();
+                                break;
+                            }
 
-                        case USB_HOLDING_CLIENT_INIT_ERROR:
-                            temp = EVENT_CLIENT_INIT_ERROR;
+                            // Clean up and advance to the next substate.
+                            _USB_InitErrorCounters();
+                            _USB_SetNextSubState();
                             break;
 
-                        case USB_HOLDING_OUT_OF_MEMORY:
-                            temp = EVENT_OUT_OF_MEMORY;
+                        default:
                             break;
+                    }
+                    break;
 
-                        default:
-                            temp = EVENT_UNSPECIFIED_ERROR; // This should never occur
+                case SUBSTATE_GET_DEVICE_DESCRIPTOR:
+                    // Send the GET DEVICE DESCRIPTOR command and receive the response
+                    switch (pCurrentDevice->state & SUBSUBSTATE_MASK)
+                    {
+                        case SUBSUBSTATE_SEND_GET_DEVICE_DESCRIPTOR:
+#if defined (DEBUG_ENABLE)
+                            DEBUG_PutString( "HOST: Getting device descriptor.\r\n" );
+#endif
+
+                            // If we are currently sending a token, we cannot do anything.
+                            if (usbBusInfo.flags.bfTokenAlreadyWritten)   //(U1CONbits.TOKBUSY)
+                                break;
+
+                            // Set up and send GET DEVICE DESCRIPTOR
+                            pCurrentDevice->pEP0Data[0] = USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
+                            pCurrentDevice->pEP0Data[1] = USB_REQUEST_GET_DESCRIPTOR;
+                            pCurrentDevice->pEP0Data[2] = 0; // Index
+                            pCurrentDevice->pEP0Data[3] = USB_DESCRIPTOR_DEVICE; // Type
+                            pCurrentDevice->pEP0Data[4] = 0;
+                            pCurrentDevice->pEP0Data[5] = 0;
+                            pCurrentDevice->pEP0Data[6] = *pCurrentDevice->pDeviceDescriptor;
+                            pCurrentDevice->pEP0Data[7] = 0;
+                            _USB_InitControlRead( pCurrentDevice->pEndpoint0, pCurrentDevice->pEP0Data, 8, pCurrentDevice->pDeviceDescriptor, *pCurrentDevice->pDeviceDescriptor  );
+                            _USB_SetNextSubSubState();
                             break;
-                    }
 
-                    // Report the problem to the application.
-                    USB_HOST_APP_EVENT_HANDLER( usbDeviceInfo.deviceAddress, temp, &usbDeviceInfo.currentConfigurationPower , 1 );
+                        case SUBSUBSTATE_WAIT_FOR_GET_DEVICE_DESCRIPTOR:
+                            if (pCurrentDevice->pEndpoint0->status.bfTransferComplete)
+                            {
+                                if (pCurrentDevice->pEndpoint0->status.bfTransferSuccessful)
+                                {
+                                    _USB_SetNextSubSubState();
+                                }
+                                else
+                                {
+                                    // We are here because of either a STALL or a NAK.  See if
+                                    // we have retries left to try the command again or try to
+                                    // enumerate again.
+                                    _USB_CheckCommandAndEnumerationAttempts();
+                                }
+                            }
+                            break;
 
-                    _USB_SetNextSubState();
-                    break;
+                        case SUBSUBSTATE_GET_DEVICE_DESCRIPTOR_COMPLETE:
+                            // Clean up and advance to the next substate.
+                            _USB_InitErrorCounters();
+                            _USB_SetNextSubState();
+                            break;
 
-                case SUBSTATE_HOLD:
-                    // Hold here until a DETACH interrupt frees us.
+                        default:
+                            break;
+                    }
                     break;
 
-                default:
+                case SUBSTATE_VALIDATE_VID_PID:
+#if defined (DEBUG_ENABLE)
+                    DEBUG_PutString( "HOST: Validating VID and PID.\r\n" );
+#endif
+
+                    // Search the TPL for the device's VID & PID.  If a client driver is
+                    // available for the over-all device, use it.  Otherwise, we'll search
+                    // again later for an appropriate class driver.
+                    _USB_FindDeviceLevelClientDriver();
+
+                    // Advance to the next state to assign an address to the device.
+                    //
+                    // Note: We assign an address to all devices and hold later if
+                    // we can't find a supported configuration.
+                    _USB_SetNextState();
                     break;
             }
             break;
-    }
 
-}
+        case STATE_ADDRESSING:
+            switch (pCurrentDevice->state & SUBSTATE_MASK)
+            {
+                case SUBSTATE_SET_DEVICE_ADDRESS:
+                    // Send the SET ADDRESS command.  We can't set the device address
+                    // in hardware until the entire transaction is complete.
+                    switch (pCurrentDevice->state & SUBSUBSTATE_MASK)
+                    {
+                        case SUBSUBSTATE_SEND_SET_DEVICE_ADDRESS:
+#if defined (DEBUG_ENABLE)
+                            DEBUG_PutString( "HOST: Setting device address.\r\n" );
+#endif
 
-/****************************************************************************
-  Function:
-    void USBHostTerminateTransfer( uint8_t deviceAddress, uint8_t endpoint )
+                            // Select an address for the device.  Store it so we can access it again
+                            // easily.  We'll put the low speed indicator on later.
+                            pCurrentDevice->deviceAddress = _USB_FindFreeAddress();
 
+                            // Set up and send SET ADDRESS
+                            pCurrentDevice->pEP0Data[0] = USB_SETUP_HOST_TO_DEVICE | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
+                            pCurrentDevice->pEP0Data[1] = USB_REQUEST_SET_ADDRESS;
+                            pCurrentDevice->pEP0Data[2] = pCurrentDevice->deviceAddress;
+                            pCurrentDevice->pEP0Data[3] = 0;
+                            pCurrentDevice->pEP0Data[4] = 0;
+                            pCurrentDevice->pEP0Data[5] = 0;
+                            pCurrentDevice->pEP0Data[6] = 0;
+                            pCurrentDevice->pEP0Data[7] = 0;
+                            _USB_InitControlWrite( pCurrentDevice->pEndpoint0, pCurrentDevice->pEP0Data, 8, NULL, 0 );
+                            _USB_SetNextSubSubState();
+                            break;
 
-  Summary:
-    This function terminates the current transfer for the given endpoint.
+                        case SUBSUBSTATE_WAIT_FOR_SET_DEVICE_ADDRESS:
+                            if (pCurrentDevice->pEndpoint0->status.bfTransferComplete)
+                            {
+                                if (pCurrentDevice->pEndpoint0->status.bfTransferSuccessful)
+                                {
+                                    _USB_SetNextSubSubState();
+                                }
+                                else
+                                {
+                                    // We are here because of either a STALL or a NAK.  See if
+                                    // we have retries left to try the command again or try to
+                                    // enumerate again.
+                                    _USB_CheckCommandAndEnumerationAttempts();
+                                }
+                            }
+                            break;
 
-  Description:
-    This function terminates the current transfer for the given endpoint.  It
-    can be used to terminate reads or writes that the device is not
-    responding to.  It is also the only way to terminate an isochronous
-    transfer.
+                        case SUBSUBSTATE_SET_DEVICE_ADDRESS_COMPLETE:
+                            // Set the device's address here.
+                            pCurrentDevice->deviceAddressAndSpeed = (pCurrentDevice->flags.bfIsLowSpeed << 7) | pCurrentDevice->deviceAddress;
 
-  Precondition:
-    None
+                            // Clean up and advance to the next state.
+                            _USB_InitErrorCounters();
+                            _USB_SetNextState();
+                            break;
 
-  Parameters:
-    uint8_t deviceAddress  - Device address
-    uint8_t endpoint       - Endpoint number
+                        default:
+                            break;
+                    }
+                    break;
+            }
+            break;
 
-  Returns:
-    None
+        case STATE_CONFIGURING:
+            switch (pCurrentDevice->state & SUBSTATE_MASK)
+            {
+                case SUBSTATE_INIT_CONFIGURATION:
+                    // Start a new list of configuration descriptors and
+                    // initialize the counter.  We will request the descriptors
+                    // from highest to lowest so the lowest will be first in
+                    // the list.  Any old list went with the arena reset.
+                    pCurrentDevice->countConfigurations = ((USB_DEVICE_DESCRIPTOR *)pCurrentDevice->pDeviceDescriptor)->bNumConfigurations;
+                    pCurrentDevice->pConfigurationDescriptorList = NULL;
+                    _USB_SetNextSubState();
+                    break;
 
-  Remarks:
-    None
-  ***************************************************************************/
+                case SUBSTATE_GET_CONFIG_DESCRIPTOR_SIZE:
+                    // Get the size of the Configuration Descriptor for the current configuration
+                    switch (pCurrentDevice->state & SUBSUBSTATE_MASK)
+                    {
+                        case SUBSUBSTATE_SEND_GET_CONFIG_DESCRIPTOR_SIZE:
+#if defined (DEBUG_ENABLE)
+                            DEBUG_PutString( "HOST: Getting Config Descriptor size.\r\n" );
+#endif
 
-void USBHostTerminateTransfer( uint8_t deviceAddress, uint8_t endpoint )
-{
-    USB_ENDPOINT_INFO *ep;
+                            // Set up and send GET CONFIGURATION (n) DESCRIPTOR with a length of 8
+                            pCurrentDevice->pEP0Data[0] = USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
+                            pCurrentDevice->pEP0Data[1] = USB_REQUEST_GET_DESCRIPTOR;
 
-    // Find the required device
-    if (deviceAddress != usbDeviceInfo.deviceAddress)
-    {
-        return; // USB_UNKNOWN_DEVICE;
-    }
+                            //MCHP: probably should get all of the configuration descriptors.
+                            pCurrentDevice->pEP0Data[2] = 0;
+//                            pCurrentDevice->pEP0Data[2] = pCurrentDevice->countConfigurations-1;    // USB 2.0 - range is 0 - count-1
+                            pCurrentDevice->pEP0Data[3] = USB_DESCRIPTOR_CONFIGURATION;
+                            pCurrentDevice->pEP0Data[4] = 0;
+                            pCurrentDevice->pEP0Data[5] = 0;
+                            pCurrentDevice->pEP0Data[6] = 8;
+                            pCurrentDevice->pEP0Data[7] = 0;
+                            _USB_InitControlRead( pCurrentDevice->pEndpoint0, pCurrentDevice->pEP0Data, 8, pCurrentDevice->pEP0Data, 8 );
+                            _USB_SetNextSubSubState();
+                            break;
 
-    ep = _USB_FindEndpoint( endpoint );
-    if (ep != NULL)
-    {
-        ep->status.bfUserAbort          = 1;
-        ep->status.bfTransferComplete   = 1;
-    }
-}
+                        case SUBSUBSTATE_WAIT_FOR_GET_CONFIG_DESCRIPTOR_SIZE:
+                            if (pCurrentDevice->pEndpoint0->status.bfTransferComplete)
+                            {
+                                if (pCurrentDevice->pEndpoint0->status.bfTransferSuccessful)
+                                {
+                                    _USB_SetNextSubSubState();
+                                }
+                                else
+                                {
+                                    // We are here because of either a STALL or a NAK.  See if
+                                    // we have retries left to try the command again or try to
+                                    // enumerate again.
+                                    _USB_CheckCommandAndEnumerationAttempts();
+                                }
+                            }
+                            break;
 
-/****************************************************************************
-  Function:
-    bool USBHostTransferIsComplete( uint8_t deviceAddress, uint8_t endpoint,
-                        uint8_t *errorCode, uint32_t *byteCount )
+                        case SUBSUBSTATE_GET_CONFIG_DESCRIPTOR_SIZECOMPLETE:
+                            // Allocate a buffer for an entry in the configuration descriptor list.
+                            if ((pTemp = (uint8_t *)_USB_AllocEnumerationMemory( sizeof (USB_CONFIGURATION) )) == NULL)
+                            {
+                                // We cannot continue.  Freeze until the device is removed.
+                                _USB_SetErrorCode( USB_HOLDING_OUT_OF_MEMORY );
+                                _USB_SetHoldState();
+                                break;
+                            }
 
-  Summary:
-    This function initiates whether or not the last endpoint transaction is
-    complete.
+                            // Allocate a buffer for the entire Configuration Descriptor
+                            if ((((USB_CONFIGURATION *)pTemp)->descriptor = (uint8_t *)_USB_AllocEnumerationMemory( ((uint16_t)pCurrentDevice->pEP0Data[3] << 8) + (uint16_t)pCurrentDevice->pEP0Data[2] )) == NULL)
+                            {
+                                // Not enough memory for the descriptor!
+                                // We cannot continue.  Freeze until the device is removed.
+                                _USB_SetErrorCode( USB_HOLDING_OUT_OF_MEMORY );
+                                _USB_SetHoldState();
+                                break;
+                            }
 
-  Description:
-    This function initiates whether or not the last endpoint transaction is
-    complete.  If it is complete, an error code and the number of bytes
-    transferred are returned.
+                            // Save wTotalLength
+                            ((USB_CONFIGURATION_DESCRIPTOR *)((USB_CONFIGURATION *)pTemp)->descriptor)->wTotalLength =
+                                    ((uint16_t)pCurrentDevice->pEP0Data[3] << 8) + (uint16_t)pCurrentDevice->pEP0Data[2];
 
-    For isochronous transfers, byteCount is not valid.  Instead, use the
-    returned byte counts for each EVENT_TRANSFER event that was generated
-    during the transfer.
+                            // Put the new node at the front of the list.
+                            ((USB_CONFIGURATION *)pTemp)->next = pCurrentDevice->pConfigurationDescriptorList;
+                            pCurrentDevice->pConfigurationDescriptorList = (USB_CONFIGURATION *)pTemp;
 
-  Precondition:
-    None
+                            // Save the configuration descriptor pointer and number
+                            pCurrentDevice->pCurrentConfigurationDescriptor            = ((USB_CONFIGURATION *)pTemp)->descriptor;
+                            ((USB_CONFIGURATION *)pTemp)->configNumber = pCurrentDevice->countConfigurations;
 
-  Parameters:
-    uint8_t deviceAddress  - Device address
-    uint8_t endpoint       - Endpoint number
-    uint8_t *errorCode     - Error code indicating the status of the transfer.
-                            Only valid if the transfer is complete.
-    uint32_t *byteCount    - The number of bytes sent or received.  Invalid
-                            for isochronous transfers.
+                            // Clean up and advance to the next state.
+                            _USB_InitErrorCounters();
+                            _USB_SetNextSubState();
+                            break;
 
-  Return Values:
-    true    - Transfer is complete.
-    false   - Transfer is not complete.
+                        default:
+                            break;
+                    }
+                    break;
 
-  Remarks:
-    Possible values for errorCode are:
-        * USB_SUCCESS                     - Transfer successful
-        * USB_UNKNOWN_DEVICE              - Device not attached
-        * USB_ENDPOINT_STALLED            - Endpoint STALL'd
-        * USB_ENDPOINT_ERROR_ILLEGAL_PID  - Illegal PID returned
-        * USB_ENDPOINT_ERROR_BIT_STUFF
-        * USB_ENDPOINT_ERROR_DMA
-        * USB_ENDPOINT_ERROR_TIMEOUT
-        * USB_ENDPOINT_ERROR_DATA_FIELD
-        * USB_ENDPOINT_ERROR_CRC16
-        * USB_ENDPOINT_ERROR_END_OF_FRAME
-        * USB_ENDPOINT_ERROR_PID_CHECK
-        * USB_ENDPOINT_ERROR              - Other error
-  ***************************************************************************/
+                case SUBSTATE_GET_CONFIG_DESCRIPTOR:
+                    // Get the entire Configuration Descriptor for this configuration
+                    switch (pCurrentDevice->state & SUBSUBSTATE_MASK)
+                    {
+                        case SUBSUBSTATE_SEND_GET_CONFIG_DESCRIPTOR:
+#if defined (DEBUG_ENABLE)
+                            DEBUG_PutString( "HOST: Getting Config Descriptor.\r\n" );
+#endif
 
-bool USBHostTransferIsComplete( uint8_t deviceAddress, uint8_t endpoint, uint8_t *errorCode,
-            uint32_t *byteCount )
-{
-    USB_ENDPOINT_INFO   *ep;
-    uint8_t                transferComplete;
+                            // Set up and send GET CONFIGURATION (n) DESCRIPTOR.
+                            pCurrentDevice->pEP0Data[0] = USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
+                            pCurrentDevice->pEP0Data[1] = USB_REQUEST_GET_DESCRIPTOR;
+                            //MCHP: probably should get all of the configuration descriptors.
+                            pCurrentDevice->pEP0Data[2] = 0;
+                            pCurrentDevice->pEP0Data[3] = USB_DESCRIPTOR_CONFIGURATION;
+                            pCurrentDevice->pEP0Data[4] = 0;
+                            pCurrentDevice->pEP0Data[5] = 0;
+                            pCurrentDevice->pEP0Data[6] = pCurrentDevice->pConfigurationDescriptorList->descriptor[2];    // wTotalLength
+                            pCurrentDevice->pEP0Data[7] = pCurrentDevice->pConfigurationDescriptorList->descriptor[3];
+                            _USB_InitControlRead( pCurrentDevice->pEndpoint0, pCurrentDevice->pEP0Data, 8, pCurrentDevice->pConfigurationDescriptorList->descriptor,
+                                    ((USB_CONFIGURATION_DESCRIPTOR *)pCurrentDevice->pConfigurationDescriptorList->descriptor)->wTotalLength );
+                            _USB_SetNextSubSubState();
+                            break;
 
-    // Find the required device
-    if (deviceAddress != usbDeviceInfo.deviceAddress)
-    {
-        *errorCode = USB_UNKNOWN_DEVICE;
-        *byteCount = 0;
-        return true;
-    }
+                        case SUBSUBSTATE_WAIT_FOR_GET_CONFIG_DESCRIPTOR:
+                            if (pCurrentDevice->pEndpoint0->status.bfTransferComplete)
+                            {
+                                if (pCurrentDevice->pEndpoint0->status.bfTransferSuccessful)
+                                {
+                                    _USB_SetNextSubSubState();
+                                }
+                                else
+                                {
+                                    // We are here because of either a STALL or a NAK.  See if
+                                    // we have retries left to try the command again or try to
+                                    // enumerate again.
+                                    _USB_CheckCommandAndEnumerationAttempts();
+                                }
+                            }
+                            break;
 
-    ep = _USB_FindEndpoint( endpoint );
-    if (ep != NULL)
-    {
-        // bfTransferComplete, the status flags, and byte count can be
-        // changed in an interrupt service routine.  Therefore, we'll
-        // grab it first, save it locally, and then determine the rest of
-        // the information.  It is better to say that the transfer is not
-        // yet complete, since the caller will simply try again.
+                        case SUBSUBSTATE_GET_CONFIG_DESCRIPTOR_COMPLETE:
+                            // Clean up and advance to the next state.  Keep the data for later use.
+                            _USB_InitErrorCounters();
+                            pCurrentDevice->countConfigurations --;
+                            if (pCurrentDevice->countConfigurations)
+                            {
+                                // There are more descriptors that we need to get.
+                                pCurrentDevice->state = STATE_CONFIGURING | SUBSTATE_GET_CONFIG_DESCRIPTOR_SIZE;
+                            }
+                            else
+                            {
+                                // Start configuring the device.
+                                _USB_SetNextSubState();
+                              }
+                            break;
 
-        // Save off the Transfer Complete status.  That way, we won't
-        // load up bad values and then say the transfer is complete.
-        transferComplete = ep->status.bfTransferComplete;
+                        default:
+                            break;
+                    }
+                    break;
 
-        // Set up error code.  This is only valid if the transfer is complete.
-        if (ep->status.bfTransferSuccessful)
-        {
-            *errorCode = USB_SUCCESS;
-            *byteCount = ep->dataCount;
-        }
-        else if (ep->status.bfStalled)
-        {
-            *errorCode = USB_ENDPOINT_STALLED;
-        }
-        else if (ep->status.bfError)
-        {
-            *errorCode = ep->bErrorCode;
-        }
-        else
-        {
-            *errorCode = USB_ENDPOINT_UNRESOLVED_STATE;
-        }
+                case SUBSTATE_SELECT_CONFIGURATION:
+                    // Set the OTG configuration of the device
+                    switch (pCurrentDevice->state & SUBSUBSTATE_MASK)
+                    {
+                        case SUBSUBSTATE_SELECT_CONFIGURATION:
+                            // Free the old configuration (if any)
+                            _USB_FreeConfigMemory();
 
-        return transferComplete;
-    }
+                            // If the configuration wasn't selected based on the VID & PID
+                            if (pCurrentDevice->currentConfiguration == 0)
+                            {
+                                // Search for a supported class-specific configuration.
+                                pCurrentConfigurationNode = pCurrentDevice->pConfigurationDescriptorList;
+                                while (pCurrentConfigurationNode)
+                                {
+                                    pCurrentDevice->pCurrentConfigurationDescriptor = pCurrentConfigurationNode->descriptor;
+                                    if (_USB_ParseConfigurationDescriptor())
+                                    {
+                                        break;
+                                    }
+                                    else
+                                    {
+                                        // Free the memory allocated and
+                                        // advance to  next configuration
+                                        _USB_FreeConfigMemory();
+                                        pCurrentConfigurationNode = pCurrentConfigurationNode->next;
+                                    }
+                                }
+                            }
+                            else
+                            {
+                                // Configuration selected by VID & PID, initialize data structures
+                                pCurrentConfigurationNode = pCurrentDevice->pConfigurationDescriptorList;
+                                while (pCurrentConfigurationNode && pCurrentConfigurationNode->configNumber != pCurrentDevice->currentConfiguration)
+                                {
+                                    pCurrentConfigurationNode = pCurrentConfigurationNode->next;
+                                }
+                                pCurrentDevice->pCurrentConfigurationDescriptor = pCurrentConfigurationNode->descriptor;
+                                if (!_USB_ParseConfigurationDescriptor())
+                                {
+                                    // Free the memory allocated, config attempt failed.
+                                    _USB_FreeConfigMemory();
+                                    pCurrentConfigurationNode = NULL;
+                                }
+                            }
 
-    // The endpoint was not found.  Return true so we can return a valid error code.
-    *errorCode = USB_ENDPOINT_NOT_FOUND;
-    return true;
-}
+                            // Keep the selection for SUBSUBSTATE_SET_OTG_COMPLETE.
+                            pCurrentDevice->currentConfigurationDescriptor = pCurrentConfigurationNode;
 
-/****************************************************************************
-  Function:
-    uint8_t  USBHostVbusEvent( USB_EVENT vbusEvent, uint8_t hubAddress,
-                                        uint8_t portNumber)
+                            //If No OTG Then
+                            if (pCurrentDevice->flags.bfConfiguredOTG)
+                            {
+                                // Did we fail to configure?
+                                if (pCurrentConfigurationNode == NULL)
+                                {
+                                    // Failed to find a supported configuration.
+                                    _USB_SetErrorCode( USB_HOLDING_UNSUPPORTED_DEVICE );
+                                    _USB_SetHoldState();
+                                }
+                                else
+                                {
+                                    _USB_SetNextSubSubState();
+                                }
+                            }
+                            else
+                            {
+                                _USB_SetNextSubSubState();
+                            }
+                            break;
 
-  Summary:
-    This function handles Vbus events that are detected by the application.
+                        case SUBSUBSTATE_SEND_SET_OTG:
+#if defined (DEBUG_ENABLE)
+                            DEBUG_PutString( "HOST: Determine OTG capability.\r\n" );
+#endif
 
-  Description:
-    This function handles Vbus events that are detected by the application.
-    Since Vbus management is application dependent, the application is
-    responsible for monitoring Vbus and detecting overcurrent conditions
-    and removal of the overcurrent condition.  If the application detects
-    an overcurrent condition, it should call this function with the event
-    EVENT_VBUS_OVERCURRENT with the address of the hub and port number that
-    has the condition.  When a port returns to normal operation, the
-    application should call this function with the event
-    EVENT_VBUS_POWER_AVAILABLE so the stack knows that it can allow devices
-    to attach to that port.
+                            // If the device does not support OTG, or
+                            // if the device has already been configured, bail.
+                            // Otherwise, send SET FEATURE to configure it.
+                            if (!pCurrentDevice->flags.bfConfiguredOTG)
+                            {
+#if defined (DEBUG_ENABLE)
+                                DEBUG_PutString( "HOST: ...OTG needs configuring.\r\n" );
+#endif
 
-  Precondition:
-    None
+                                pCurrentDevice->flags.bfConfiguredOTG = 1;
 
-  Parameters:
-    USB_EVENT vbusEvent     - Vbus event that occured.  Valid events:
-                                    * EVENT_VBUS_OVERCURRENT
-                                    * EVENT_VBUS_POWER_AVAILABLE
-    uint8_t hubAddress         - Address of the hub device (USB_ROOT_HUB for the
-                                root hub)
-    uint8_t portNumber         - Number of the physical port on the hub (0 - based)
+                                // Send SET FEATURE
+                                pCurrentDevice->pEP0Data[0] = USB_SETUP_HOST_TO_DEVICE | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
+                                pCurrentDevice->pEP0Data[1] = USB_REQUEST_SET_FEATURE;
+                                if (pCurrentDevice->flags.bfAllowHNP) // Needs to be set by the user
+                                {
+                                    pCurrentDevice->pEP0Data[2] = OTG_FEATURE_B_HNP_ENABLE;
+                                }
+                                else
+                                {
+                                    pCurrentDevice->pEP0Data[2] = OTG_FEATURE_A_HNP_SUPPORT;
+                                }
+                                pCurrentDevice->pEP0Data[3] = 0;
+                                pCurrentDevice->pEP0Data[4] = 0;
+                                pCurrentDevice->pEP0Data[5] = 0;
+                                pCurrentDevice->pEP0Data[6] = 0;
+                                pCurrentDevice->pEP0Data[7] = 0;
+                                _USB_InitControlWrite( pCurrentDevice->pEndpoint0, pCurrentDevice->pEP0Data, 8, NULL, 0 );
+                                _USB_SetNextSubSubState();
+                            }
+                            else
+                            {
+#if defined (DEBUG_ENABLE)
+                                DEBUG_PutString( "HOST: ...No OTG.\r\n" );
+#endif
 
-  Return Values:
-    USB_SUCCESS             - Event handled
-    USB_ILLEGAL_REQUEST     - Invalid event, hub, or port
+                                _USB_SetNextSubState();
+                            }
+                            break;
 
-  Remarks:
-    None
-  ***************************************************************************/
+                        case SUBSUBSTATE_WAIT_FOR_SET_OTG_DONE:
+                            if (pCurrentDevice->pEndpoint0->status.bfTransferComplete)
+                            {
+                                if (pCurrentDevice->pEndpoint0->status.bfTransferSuccessful)
+                                {
+                                    #ifdef  USB_SUPPORT_OTG
+                                        if (pCurrentDevice->flags.bfAllowHNP)
+                                        {
+                                            USBOTGEnableHnp();
+                                        }
+                                     #endif
+                                    _USB_SetNextSubSubState();
+                                }
+                                else
+                                {
+                                    #ifdef  USB_SUPPORT_OTG
+                                        USBOTGDisableHnp();
+                                    #endif
+                                    // We are here because of either a STALL or a NAK.  See if
+                                    // we have retries left to try the command again or try to
+                                    // enumerate again.
+                                    _USB_CheckCommandAndEnumerationAttempts();
 
-uint8_t  USBHostVbusEvent(USB_EVENT vbusEvent, uint8_t hubAddress, uint8_t portNumber)
-{
-    if ((hubAddress == USB_ROOT_HUB) &&
-        (portNumber == 0 ))
-    {
-        if (vbusEvent == EVENT_VBUS_OVERCURRENT)
-        {
-            USBHostShutdown();
-            usbRootHubInfo.flags.bPowerGoodPort0 = 0;
-            return USB_SUCCESS;
-        }
-        if (vbusEvent == EVENT_VBUS_POWER_AVAILABLE)
-        {
-            usbRootHubInfo.flags.bPowerGoodPort0 = 1;
-            return USB_SUCCESS;
-        }
-    }
+                                    #if defined(USB_SUPPORT_OTG)
+#if defined (DEBUG_ENABLE)
+                                        DEBUG_PutString( "\r\n***** USB OTG Error - Set Feature B_HNP_ENABLE Stalled - Device Not Responding *****\r\n" );
+#endif
+                                    #endif
 
-    return USB_ILLEGAL_REQUEST;
-}
+                                }
+                            }
+                            break;
 
+                        case SUBSUBSTATE_SET_OTG_COMPLETE:
+                             // Clean up and advance to the next state.
+                           _USB_InitErrorCounters();
 
-/****************************************************************************
-  Function:
-    uint8_t USBHostWrite( uint8_t deviceAddress, uint8_t endpoint, uint8_t *data,
-                        uint32_t size )
+                            //MR - Moved For OTG Set Feature Support For Unsupported Devices
+                            // Did we fail to configure?
+                            if (pCurrentDevice->currentConfigurationDescriptor == NULL)
+                            {
+                                // Failed to find a supported configuration.
+                                _USB_SetErrorCode( USB_HOLDING_UNSUPPORTED_DEVICE );
+                                _USB_SetHoldState();
+                            }
+                            else
+                            {
+                                //_USB_SetNextSubSubState();
+                                _USB_InitErrorCounters();
+                                _USB_SetNextSubState();
+                            }
+                            break;
 
-  Summary:
-    This function initiates a write to the attached device.
+                        default:
+                            break;
+                    }
+                    break;
 
-  Description:
-    This function initiates a write to the attached device.  The data buffer
-    pointed to by *data must remain valid during the entire time that the
-    write is taking place; the data is not buffered by the stack.
+                case SUBSTATE_SET_CONFIGURATION:
+                    // Set the configuration to the one specified for this device
+                    switch (pCurrentDevice->state & SUBSUBSTATE_MASK)
+                    {
+                        case SUBSUBSTATE_SEND_SET_CONFIGURATION:
+#if defined (DEBUG_ENABLE)
+                            DEBUG_PutString( "HOST: Set configuration.\r\n" );
+#endif
 
-    If the endpoint is isochronous, special conditions apply.  The pData and
-    size parameters have slightly different meanings, since multiple buffers
-    are required.  Once started, an isochronous transfer will continue with
-    no upper layer intervention until USBHostTerminateTransfer() is called.
-    The ISOCHRONOUS_DATA_BUFFERS structure should not be manipulated until
-    the transfer is terminated.
+                            // Set up and send SET CONFIGURATION.
+                            pCurrentDevice->pEP0Data[0] = USB_SETUP_HOST_TO_DEVICE | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_DEVICE;
+                            pCurrentDevice->pEP0Data[1] = USB_REQUEST_SET_CONFIGURATION;
+                            pCurrentDevice->pEP0Data[2] = pCurrentDevice->currentConfiguration;
+                            pCurrentDevice->pEP0Data[3] = 0;
+                            pCurrentDevice->pEP0Data[4] = 0;
+                            pCurrentDevice->pEP0Data[5] = 0;
+                            pCurrentDevice->pEP0Data[6] = 0;
+                            pCurrentDevice->pEP0Data[7] = 0;
+                            _USB_InitControlWrite( pCurrentDevice->pEndpoint0, pCurrentDevice->pEP0Data, 8, NULL, 0 );
+                            _USB_SetNextSubSubState();
+                            break;
+
+                        case SUBSUBSTATE_WAIT_FOR_SET_CONFIGURATION:
+                            if (pCurrentDevice->pEndpoint0->status.bfTransferComplete)
+                            {
+                                if (pCurrentDevice->pEndpoint0->status.bfTransferSuccessful)
+                                {
+                                    _USB_SetNextSubSubState();
+                                }
+                                else
+                                {
+                                    // We are here because of either a STALL or a NAK.  See if
+                                    // we have retries left to try the command again or try to
+                                    // enumerate again.
+                                    _USB_CheckCommandAndEnumerationAttempts();
+                                }
+                            }
+                            break;
+
+                        case SUBSUBSTATE_SET_CONFIGURATION_COMPLETE:
+                            // Clean up and advance to the next state.
+                            _USB_InitErrorCounters();
+                            _USB_SetNextSubSubState();
+                            break;
+
+                        case SUBSUBSTATE_INIT_CLIENT_DRIVERS:
+#if defined (DEBUG_ENABLE)
+                            DEBUG_PutString( "HOST: Initializing client drivers...\r\n" );
+#endif
+
+                            _USB_SetNextState();
+                            // Initialize client driver(s) for this configuration.
+                            if (pCurrentDevice->flags.bfUseDeviceClientDriver)
+                            {
+                                // We have a device that requires only one client driver.  Make sure
+                                // that client driver can initialize this device.  If the client
+                                // driver initialization fails, we cannot enumerate this device.
+#if defined (DEBUG_ENABLE)
+                                DEBUG_PutString( "HOST: Using device client driver.\r\n" );
+#endif
+
+                                temp = pCurrentDevice->deviceClientDriver;
+                                if (!usbClientDrvTable[temp].Initialize(pCurrentDevice->deviceAddress, usbClientDrvTable[temp].flags, temp))
+                                {
+                                    _USB_SetErrorCode( USB_HOLDING_CLIENT_INIT_ERROR );
+                                    _USB_SetHoldState();
+                                }
+                            }
+                            else
+                            {
+                                // We have a device that requires multiple client drivers.  Make sure
+                                // every required client driver can initialize this device.  If any
+                                // client driver initialization fails, we cannot enumerate the device.
+#if defined (DEBUG_ENABLE)
+                                DEBUG_PutString( "HOST: Scanning interfaces.\r\n" );
+#endif
+
+                                pCurrentInterface = pCurrentDevice->pInterfaceList;
+                                while (pCurrentInterface)
+                                {
+                                    temp = pCurrentInterface->clientDriver;
+                                    if (!usbClientDrvTable[temp].Initialize(pCurrentDevice->deviceAddress, usbClientDrvTable[temp].flags, temp))
+                                    {
+                                        _USB_SetErrorCode( USB_HOLDING_CLIENT_INIT_ERROR );
+                                        _USB_SetHoldState();
+                                    }
+                                    pCurrentInterface = pCurrentInterface->next;
+                                }
+                            }
+
+                            //Load the EP0 driver, if there was any
+                            if(pCurrentDevice->flags.bfUseEP0Driver == 1)
+                            {
+                                temp = pCurrentDevice->deviceEP0Driver;
+                                if (!usbClientDrvTable[temp].Initialize(pCurrentDevice->deviceAddress, usbClientDrvTable[temp].flags, temp))
+                                {
+                                    _USB_SetErrorCode( USB_HOLDING_CLIENT_INIT_ERROR );
+                                    _USB_SetHoldState();
+                                }
+                            }
+
+                            break;
+
+                        default:
+                            break;
+                    }
+                    break;
+            }
+            break;
+
+        case STATE_RUNNING:
+            switch (pCurrentDevice->state & SUBSTATE_MASK)
+            {
+                case SUBSTATE_NORMAL_RUN:
+                    break;
+
+                case SUBSTATE_SUSPEND_AND_RESUME:
+                    switch (pCurrentDevice->state & SUBSUBSTATE_MASK)
+                    {
+                        case SUBSUBSTATE_SUSPEND:
+                            // The IDLE state has already been set.  We need to wait here
+                            // until the application decides to RESUME.
+                            break;
+
+                        case SUBSUBSTATE_RESUME:
+                            // Issue a RESUME.
+                            U1CONbits.RESUME = 1;
+
+                            // Wait for the RESUME time.
+                            numTimerInterrupts      = USB_RESUME_TIME;
+                            U1OTGIR                 = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
+                            U1OTGIEbits.T1MSECIE    = 1;
+
+                            _USB_SetNextSubSubState();
+                            break;
+
+                        case SUBSUBSTATE_RESUME_WAIT:
+                            // Wait here until the timer expires.
+                            break;
+
+                        case SUBSUBSTATE_RESUME_RECOVERY:
+                            // Turn off RESUME.
+                            U1CONbits.RESUME        = 0;
+
+                            // Start sending SOF's, so the device doesn't go back into the SUSPEND state.
+                            U1CONbits.SOFEN         = 1;
+
+                            // Wait for the RESUME recovery time.
+                            numTimerInterrupts      = USB_RESUME_RECOVERY_TIME;
+                            U1OTGIR                 = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
+                            U1OTGIEbits.T1MSECIE    = 1;
+
+                            _USB_SetNextSubSubState();
+                            break;
+
+                        case SUBSUBSTATE_RESUME_RECOVERY_WAIT:
+                            // Wait here until the timer expires.
+                            break;
+
+                        case SUBSUBSTATE_RESUME_COMPLETE:
+                            // Go back to normal running.
+                            pCurrentDevice->state = STATE_RUNNING | SUBSTATE_NORMAL_RUN;
+                            break;
+                    }
+            }
+            break;
 
-    To clarify parameter usage and to simplify casting, use the macro
-    USBHostWriteIsochronous() when writing to an isochronous endpoint.
+        case STATE_HOLDING:
+            switch (pCurrentDevice->state & SUBSTATE_MASK)
+            {
+                case SUBSTATE_HOLD_INIT:
+                    // We're here because we cannot communicate with the current device
+                    // that is plugged in.  Turn off SOF's and all interrupts except
+                    // the DETACH interrupt.  A device behind the hub just stops
+                    // being serviced; the others are still using the bus.
+#if defined (DEBUG_ENABLE)
+                    DEBUG_PutString( "HOST: Holding.\r\n" );
+#endif
 
-  Precondition:
-    None
+                    if (pCurrentDevice->hubAddress == 0)
+                    {
+                        U1CON               = USB_HOST_MODE_ENABLE | USB_SOF_DISABLE;                       // Turn of SOF's to cut down noise
+                        U1IE                = 0;
+                        U1IR                = 0xFF;
+                        U1OTGIE             &= 0x8C;
+                        U1OTGIR             = 0x7D;
+                        U1EIE               = 0;
+                        U1EIR               = 0xFF;
+                        U1IEbits.DETACHIE   = 1;
 
-  Parameters:
-    uint8_t deviceAddress  - Device address
-    uint8_t endpoint       - Endpoint number
-    uint8_t *data          - Pointer to where the data is stored. If the endpoint
-                            is isochronous, this points to an
-                            ISOCHRONOUS_DATA_BUFFERS structure, with multiple
-                            data buffer pointers.
-    uint32_t size          - Number of data bytes to send. If the endpoint is
-                            isochronous, this is the number of data buffer
-                            pointers pointed to by pData.
+                        #if defined(USB_ENABLE_1MS_EVENT)
+                            U1OTGIR                 = USB_INTERRUPT_T1MSECIF; // The interrupt is cleared by writing a '1' to the flag.
+                            U1OTGIEbits.T1MSECIE    = 1;
+                        #endif
+                    }
 
-  Return Values:
-    USB_SUCCESS                     - Write started successfully.
-    USB_UNKNOWN_DEVICE              - Device with the specified address not found.
-    USB_INVALID_STATE               - We are not in a normal running state.
-    USB_ENDPOINT_ILLEGAL_TYPE       - Must use USBHostControlWrite to write
-                                        to a control endpoint.
-    USB_ENDPOINT_ILLEGAL_DIRECTION  - Must write to an OUT endpoint.
-    USB_ENDPOINT_STALLED            - Endpoint is stalled.  Must be cleared
-                                        by the application.
-    USB_ENDPOINT_ERROR              - Endpoint has too many errors.  Must be
-                                        cleared by the application.
-    USB_ENDPOINT_BUSY               - A Write is already in progress.
-    USB_ENDPOINT_NOT_FOUND          - Invalid endpoint.
+                    switch (pCurrentDevice->errorCode )
+                    {
+                        case USB_HOLDING_UNSUPPORTED_HUB:
+                            temp = EVENT_HUB_ATTACH;
+                            break;
 
-  Remarks:
-    None
-  ***************************************************************************/
+                        case USB_HOLDING_UNSUPPORTED_DEVICE:
+                            temp = EVENT_UNSUPPORTED_DEVICE;
 
-uint8_t USBHostWrite( uint8_t deviceAddress, uint8_t endpoint, uint8_t *data, uint32_t size )
-{
-    USB_ENDPOINT_INFO *ep;
+                            #ifdef  USB_SUPPORT_OTG
+                            //Abort HNP
+                            USB_OTGEventHandler (0, OTG_EVENT_HNP_ABORT , 0, 0 );
+                            #endif
 
-    // Find the required device
-    if (deviceAddress != usbDeviceInfo.deviceAddress)
-    {
-        return USB_UNKNOWN_DEVICE;
-    }
+                            break;
 
-    // If we are not in a normal user running state, we cannot do this.
-    if ((usbHostState & STATE_MASK) != STATE_RUNNING)
-    {
-        return USB_INVALID_STATE;
-    }
+                        case USB_CANNOT_ENUMERATE:
+                            temp = EVENT_CANNOT_ENUMERATE;
+                            break;
 
-    ep = _USB_FindEndpoint( endpoint );
-    if (ep != NULL)
-    {
-        if (ep->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_CONTROL)
-        {
-            // Must not be a control endpoint.
-            return USB_ENDPOINT_ILLEGAL_TYPE;
-        }
+                        case USB_HOLDING_CLIENT_INIT_ERROR:
+                            temp = EVENT_CLIENT_INIT_ERROR;
+                            break;
 
-        if (ep->bEndpointAddress & 0x80)
-        {
-            // Trying to do an OUT with an IN endpoint.
-            return USB_ENDPOINT_ILLEGAL_DIRECTION;
-        }
+                        case USB_HOLDING_OUT_OF_MEMORY:
+                            temp = EVENT_OUT_OF_MEMORY;
+                            break;
 
-        if (ep->status.bfStalled)
-        {
-            // The endpoint is stalled.  It must be restarted before a write
-            // can be performed.
-            return USB_ENDPOINT_STALLED;
-        }
+                        default:
+                            temp = EVENT_UNSPECIFIED_ERROR; // This should never occur
+                            break;
+                    }
 
-        if (ep->status.bfError)
-        {
-            // The endpoint has errored.  The error must be cleared before a
-            // write can be performed.
-            return USB_ENDPOINT_ERROR;
-        }
+                    // Report the problem to the application.
+                    USB_HOST_APP_EVENT_HANDLER( pCurrentDevice->deviceAddress, temp, &pCurrentDevice->currentConfigurationPower , 1 );
 
-        if (!ep->status.bfTransferComplete)
-        {
-            // We are already processing a request for this endpoint.
-            return USB_ENDPOINT_BUSY;
-        }
+                    _USB_SetNextSubState();
+                    break;
 
-        _USB_InitWrite( ep, data, size );
+                case SUBSTATE_HOLD:
+                    // Hold here until a DETACH interrupt frees us.
+                    break;
 
-        return USB_SUCCESS;
+                default:
+                    break;
+            }
+            break;
     }
-    return USB_ENDPOINT_NOT_FOUND;   // Endpoint not found
-}
 
+}
 
-// *****************************************************************************
-// *****************************************************************************
-// Section: Internal Functions
-// *****************************************************************************
-// *****************************************************************************
 
 /****************************************************************************
   Function:
-    void _USB_CheckCommandAndEnumerationAttempts( void )
-
-  Summary:
-    This function is called when we've received a STALL or a NAK when trying
-    to enumerate.
+    void _USB_DrainEventQueue( void )
 
   Description:
-    This function is called when we've received a STALL or a NAK when trying
-    to enumerate.  We allow so many attempts at each command, and so many
-    attempts at enumeration.  If the command fails and there are more command
-    attempts, we try the command again.  If the command fails and there are
-    more enumeration attempts, we reset and try to enumerate again.
-    Otherwise, we go to the holding state.
+    This function delivers the transfer events queued by the USB interrupt
+    to the client drivers.
 
   Precondition:
-    usbHostState != STATE_RUNNING
+    None
 
   Parameters:
     None - None
@@ -2815,44 +3532,37 @@ uint8_t USBHostWrite( uint8_t deviceAddress, uint8_t endpoint, uint8_t *data, ui
     None
 
   Remarks:
-    None
+    Only the events already waiting when the function is called are
+    delivered, so a steady stream of events from the interrupt cannot keep
+    USBHostTasks() from running the state machine.  Each entry is released
+    as soon as it has been delivered, so the interrupt can reuse it.
   ***************************************************************************/
 
-void _USB_CheckCommandAndEnumerationAttempts( void )
+#if defined( USB_ENABLE_TRANSFER_EVENT )
+void _USB_DrainEventQueue( void )
 {
-#if defined (DEBUG_ENABLE)
-    DEBUG_PutChar( '=' );
-#endif
-
-    // Clear the error and stall flags.  A stall here does not require
-    // host intervention to clear.
-    pCurrentEndpoint->status.bfError    = 0;
-    pCurrentEndpoint->status.bfStalled  = 0;
+    USB_EVENT_DATA  *item;
+    uint8_t         head;
 
-    numCommandTries --;
-    if (numCommandTries != 0)
-    {
-        // We still have retries left on this command.  Try again.
-        usbHostState &= ~SUBSUBSTATE_MASK;
-    }
-    else
+    head = usbEventQueue.head;
+    while (usbEventQueue.tail != head)
     {
-        // This command has timed out.
-        // We are enumerating.  See if we can try to enumerate again.
-        numEnumerationTries --;
-        if (numEnumerationTries != 0)
-        {
-            // We still have retries left to try to enumerate.  Reset and try again.
-            usbHostState = STATE_ATTACHED | SUBSTATE_RESET_DEVICE;
-        }
-        else
+        item = _USB_EventQueueEntry( usbEventQueue.tail );
+
+        switch(item->event)
         {
-            // Give up.  The device is not responding properly.
-            _USB_SetErrorCode( USB_CANNOT_ENUMERATE );
-            _USB_SetHoldState();
+            case EVENT_TRANSFER:
+            case EVENT_BUS_ERROR:
+                _USB_NotifyClients( item->deviceAddress, item->event, &item->TransferData, sizeof(HOST_TRANSFER_DATA) );
+                break;
+            default:
+                break;
         }
+
+        usbEventQueue.tail++;
     }
 }
+#endif
 
 
 /****************************************************************************
@@ -2888,7 +3598,7 @@ bool _USB_FindClassDriver( uint8_t bClass, uint8_t bSubClass, uint8_t bProtocol,
 {
     USB_OVERRIDE_CLIENT_DRIVER_EVENT_DATA   eventData;
     int                                     i;
-    USB_DEVICE_DESCRIPTOR                   *pDesc = (USB_DEVICE_DESCRIPTOR *)pDeviceDescriptor;
+    USB_DEVICE_DESCRIPTOR                   *pDesc = (USB_DEVICE_DESCRIPTOR *)pCurrentDevice->pDeviceDescriptor;
 
     i = 0;
     while (i < NUM_TPL_ENTRIES)
@@ -2931,6 +3641,97 @@ bool _USB_FindClassDriver( uint8_t bClass, uint8_t bSubClass, uint8_t bProtocol,
 } // _USB_FindClassDriver
 
 
+/****************************************************************************
+  Function:
+    USB_DEVICE_INFO * _USB_FindDevice( uint8_t address )
+
+  Description:
+    This function finds the attached device with the given address.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t address    - Device address
+
+  Returns:
+    The device, or NULL if no attached device has the address.
+
+  Remarks:
+    A device is found by its address as soon as one has been selected for
+    it, before SET ADDRESS completes.
+  ***************************************************************************/
+
+USB_DEVICE_INFO * _USB_FindDevice( uint8_t address )
+{
+    uint8_t     i;
+
+    if (address == 0)
+    {
+        return NULL;
+    }
+
+    for (i=0; i<USB_MAX_DEVICES; i++)
+    {
+        if (_USB_DeviceInUse( i ) && (usbDeviceInfo[i].deviceAddress == address))
+        {
+            return &usbDeviceInfo[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+/****************************************************************************
+  Function:
+    uint8_t _USB_FindFreeAddress( void )
+
+  Description:
+    This function selects an address for pCurrentDevice: the lowest address
+    that no other attached device is using.
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Returns:
+    The address
+
+  Remarks:
+    There are far fewer devices than addresses, so one is always free.  The
+    device on the root port always gets USB_SINGLE_DEVICE_ADDRESS, since it
+    is enumerated before anything behind the hub.
+  ***************************************************************************/
+
+uint8_t _USB_FindFreeAddress( void )
+{
+    uint8_t     address;
+    uint8_t     i;
+
+    for (address=USB_SINGLE_DEVICE_ADDRESS; address<127; address++)
+    {
+        for (i=0; i<USB_MAX_DEVICES; i++)
+        {
+            if ((&usbDeviceInfo[i] != pCurrentDevice) && _USB_DeviceInUse( i ) &&
+                (usbDeviceInfo[i].deviceAddress == address))
+            {
+                break;
+            }
+        }
+
+        if (i == USB_MAX_DEVICES)
+        {
+            break;
+        }
+    }
+
+    return address;
+}
+
+
 /****************************************************************************
   Function:
     bool _USB_FindDeviceLevelClientDriver( void )
@@ -2940,7 +3741,7 @@ bool _USB_FindClassDriver( uint8_t bClass, uint8_t bSubClass, uint8_t bProtocol,
     driver.
 
   Precondition:
-    * usbHostState == STATE_ATTACHED|SUBSTATE_VALIDATE_VID_PID
+    * pCurrentDevice->state == STATE_ATTACHED|SUBSTATE_VALIDATE_VID_PID
     * usbTPL must be define by the application.
 
   Parameters:
@@ -2959,12 +3760,12 @@ bool _USB_FindClassDriver( uint8_t bClass, uint8_t bSubClass, uint8_t bProtocol,
 bool _USB_FindDeviceLevelClientDriver( void )
 {
     uint16_t                   i;
-    USB_DEVICE_DESCRIPTOR *pDesc = (USB_DEVICE_DESCRIPTOR *)pDeviceDescriptor;
+    USB_DEVICE_DESCRIPTOR *pDesc = (USB_DEVICE_DESCRIPTOR *)pCurrentDevice->pDeviceDescriptor;
 
     // Scan TPL
     i = 0;
-    usbDeviceInfo.flags.bfUseDeviceClientDriver = 0;
-    usbDeviceInfo.flags.bfUseEP0Driver = 0;
+    pCurrentDevice->flags.bfUseDeviceClientDriver = 0;
+    pCurrentDevice->flags.bfUseEP0Driver = 0;
     while (i < NUM_TPL_ENTRIES)
     {
         if (usbTPL[i].flags.bfIsClassDriver)
@@ -2978,7 +3779,7 @@ bool _USB_FindDeviceLevelClientDriver( void )
                 DEBUG_PutString( "HOST: Device validated by class\r\n" );
 #endif
 
-                usbDeviceInfo.flags.bfUseDeviceClientDriver = 1;
+                pCurrentDevice->flags.bfUseDeviceClientDriver = 1;
             }
         }
         else
@@ -2989,13 +3790,13 @@ bool _USB_FindDeviceLevelClientDriver( void )
             {
                 if( usbTPL[i].flags.bfEP0OnlyCustomDriver == 1 )
                 {
-                    usbDeviceInfo.flags.bfUseEP0Driver = 1;
-                    usbDeviceInfo.deviceEP0Driver = usbTPL[i].ClientDriver;
+                    pCurrentDevice->flags.bfUseEP0Driver = 1;
+                    pCurrentDevice->deviceEP0Driver = usbTPL[i].ClientDriver;
 
                     // Select configuration if it is given in the TPL
                     if (usbTPL[i].flags.bfSetConfiguration)
                     {
-                        usbDeviceInfo.currentConfiguration = usbTPL[i].bConfiguration;
+                        pCurrentDevice->currentConfiguration = usbTPL[i].bConfiguration;
                     }
                 }
                 else
@@ -3004,7 +3805,7 @@ bool _USB_FindDeviceLevelClientDriver( void )
                     DEBUG_PutString( "HOST: Device validated by VID/PID\r\n" );
 #endif
 
-                    usbDeviceInfo.flags.bfUseDeviceClientDriver = 1;
+                    pCurrentDevice->flags.bfUseDeviceClientDriver = 1;
                 }
             }
 
@@ -3030,21 +3831,21 @@ bool _USB_FindDeviceLevelClientDriver( void )
                     DEBUG_PutString( "HOST: Device validated by VID/PID\r\n" );
 #endif
 
-                    usbDeviceInfo.flags.bfUseDeviceClientDriver = 1;
+                    pCurrentDevice->flags.bfUseDeviceClientDriver = 1;
                 }
             }    
             #endif
         }
 
-        if (usbDeviceInfo.flags.bfUseDeviceClientDriver)
+        if (pCurrentDevice->flags.bfUseDeviceClientDriver)
         {
             // Save client driver info
-            usbDeviceInfo.deviceClientDriver = usbTPL[i].ClientDriver;
+            pCurrentDevice->deviceClientDriver = usbTPL[i].ClientDriver;
 
             // Select configuration if it is given in the TPL
             if (usbTPL[i].flags.bfSetConfiguration)
             {
-                usbDeviceInfo.currentConfiguration = usbTPL[i].bConfiguration;
+                pCurrentDevice->currentConfiguration = usbTPL[i].bConfiguration;
             }
 
             return true;
@@ -3053,46 +3854,92 @@ bool _USB_FindDeviceLevelClientDriver( void )
         i++;
     }
 
-#if defined (DEBUG_ENABLE)
-    DEBUG_PutString( "HOST: Device not yet validated\r\n" );
-#endif
+#if defined (DEBUG_ENABLE)
+    DEBUG_PutString( "HOST: Device not yet validated\r\n" );
+#endif
+
+    return false;
+}
+
+
+/****************************************************************************
+  Function:
+    USB_ENDPOINT_INFO * _USB_FindEndpoint( USB_DEVICE_INFO *pDevice, uint8_t endpoint )
+
+  Description:
+    This function looks up the specified endpoint in the endpoint table of
+    a device.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_DEVICE_INFO *pDevice    - The device.
+    uint8_t endpoint            - The endpoint to find.
+
+  Returns:
+    Returns a pointer to the USB_ENDPOINT_INFO structure for the endpoint,
+    or NULL if the endpoint is not part of a current interface setting.
+
+  Remarks:
+    The table is kept up to date by _USB_BuildEndpointTable(), so this is
+    a constant time lookup however many interfaces the device has.
+  ***************************************************************************/
+
+USB_ENDPOINT_INFO * _USB_FindEndpoint( USB_DEVICE_INFO *pDevice, uint8_t endpoint )
+{
+    if (endpoint == 0)
+    {
+        return pDevice->pEndpoint0;
+    }
+
+    // Bits 4-6 of an endpoint address are reserved.
+    if (endpoint & 0x70)
+    {
+        return NULL;
+    }
 
-    return false;
+    return pDevice->pEndpointTable[_USB_EndpointTableIndex(endpoint)];
 }
 
 
+#if defined( USB_SIMULATOR )
 /****************************************************************************
   Function:
-    USB_ENDPOINT_INFO * _USB_FindEndpoint( uint8_t endpoint )
+    USB_ENDPOINT_INFO * _USB_FindEndpointInList( USB_DEVICE_INFO *pDevice, uint8_t endpoint )
 
   Description:
-    This function searches the list of interfaces to try to find the specified
-    endpoint.
+    This function looks up the specified endpoint by walking the current
+    setting of every interface, the way _USB_FindEndpoint() did before the
+    endpoint table.
 
   Precondition:
     None
 
   Parameters:
-    uint8_t endpoint   - The endpoint to find.
+    USB_DEVICE_INFO *pDevice    - The device.
+    uint8_t endpoint            - The endpoint to find.
 
   Returns:
-    Returns a pointer to the USB_ENDPOINT_INFO structure for the endpoint.
+    Returns a pointer to the USB_ENDPOINT_INFO structure for the endpoint,
+    or NULL if the endpoint is not part of a current interface setting.
 
   Remarks:
-    None
+    Only built for the simulated controller.  usbhostsim checks the table
+    against it and times the two lookups.
   ***************************************************************************/
 
-USB_ENDPOINT_INFO * _USB_FindEndpoint( uint8_t endpoint )
+USB_ENDPOINT_INFO * _USB_FindEndpointInList( USB_DEVICE_INFO *pDevice, uint8_t endpoint )
 {
     USB_ENDPOINT_INFO           *pEndpoint;
     USB_INTERFACE_INFO          *pInterface;
 
     if (endpoint == 0)
     {
-        return usbDeviceInfo.pEndpoint0;
+        return pDevice->pEndpoint0;
     }
 
-    pInterface = usbDeviceInfo.pInterfaceList;
+    pInterface = pDevice->pInterfaceList;
     while (pInterface)
     {
         // Look for the endpoint in the currently active setting.
@@ -3109,13 +3956,173 @@ USB_ENDPOINT_INFO * _USB_FindEndpoint( uint8_t endpoint )
                 pEndpoint = pEndpoint->next;
             }
         }
-        
+
         // Go to the next interface.
         pInterface = pInterface->next;
     }
 
     return NULL;
 }
+#endif
+
+
+/****************************************************************************
+  Function:
+    void _USB_BuildEndpointTable( USB_DEVICE_INFO *pDevice )
+
+  Description:
+    This function rebuilds the endpoint address table used by
+    _USB_FindEndpoint() from the current setting of every interface of a
+    device.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_DEVICE_INFO *pDevice    - The device.
+
+  Returns:
+    None
+
+  Remarks:
+    This must be called whenever the interface list or a current setting
+    changes: after a configuration is parsed (SET CONFIGURATION), after a
+    SET INTERFACE, and when the configuration memory is freed.
+
+    The same pass assigns the frame slots of the interrupt and isochronous
+    endpoints (see _USB_FindServiceEndpoint()) and rebuilds the ready masks,
+    so transfers pending on other interfaces stay scheduled.  The ISR may
+    run while the table is rebuilt; every entry is written only once.
+
+    The periodic endpoints of the other devices on the bus keep their
+    slots, and are counted when the slots of this device are picked.
+  ***************************************************************************/
+
+void _USB_BuildEndpointTable( USB_DEVICE_INFO *pDevice )
+{
+    USB_ENDPOINT_INFO           *pEndpoint;
+    USB_ENDPOINT_INFO           *pTable[USB_ENDPOINT_TABLE_SIZE];
+    USB_INTERFACE_INFO          *pInterface;
+    uint32_t                    ready[4];
+    uint8_t                     frameLoad[USB_PERIODIC_SCHEDULE_FRAMES];
+    uint8_t                     span;
+    uint8_t                     phase;
+    uint8_t                     bestPhase;
+    uint8_t                     bestLoad;
+    uint8_t                     worstLoad;
+    uint8_t                     i;
+    uint8_t                     j;
+
+    for (i=0; i<USB_ENDPOINT_TABLE_SIZE; i++)
+    {
+        pTable[i] = NULL;
+    }
+    for (i=0; i<USB_PERIODIC_SCHEDULE_FRAMES; i++)
+    {
+        frameLoad[i] = 0;
+    }
+    ready[0] = ready[1] = ready[2] = ready[3] = 0;
+
+    // Count the slots already used by the other devices.
+    for (j=0; j<USB_MAX_DEVICES; j++)
+    {
+        if ((&usbDeviceInfo[j] == pDevice) || ((j != 0) && (usbDeviceInfo[j].hubAddress == 0)))
+        {
+            continue;
+        }
+        for (i=0; i<USB_ENDPOINT_TABLE_SIZE; i++)
+        {
+            pEndpoint = usbDeviceInfo[j].pEndpointTable[i];
+            if ((pEndpoint != NULL) &&
+                ((pEndpoint->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_INTERRUPT) ||
+                 (pEndpoint->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_ISOCHRONOUS)))
+            {
+                span = USB_PERIODIC_SCHEDULE_FRAMES;
+                if (pEndpoint->wInterval < USB_PERIODIC_SCHEDULE_FRAMES)
+                {
+                    span = (uint8_t)pEndpoint->wInterval;
+                }
+                for (phase=pEndpoint->schedulePhase; phase<USB_PERIODIC_SCHEDULE_FRAMES; phase+=span)
+                {
+                    frameLoad[phase]++;
+                }
+            }
+        }
+    }
+
+    pInterface = pDevice->pInterfaceList;
+    while (pInterface)
+    {
+        if (pInterface->pCurrentSetting)
+        {
+            pEndpoint = pInterface->pCurrentSetting->pEndpointList;
+            while (pEndpoint)
+            {
+                if ((pEndpoint->bEndpointAddress & 0x70) == 0)
+                {
+                    i = _USB_EndpointTableIndex(pEndpoint->bEndpointAddress);
+                    pTable[i] = pEndpoint;
+                    if (!pEndpoint->status.bfTransferComplete)
+                    {
+                        ready[pEndpoint->bmAttributes.bfTransferType] |= (uint32_t)1 << i;
+                    }
+
+                    if ((pEndpoint->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_INTERRUPT) ||
+                        (pEndpoint->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_ISOCHRONOUS))
+                    {
+                        // Pick the phase whose busiest frame slot has the
+                        // fewest periodic endpoints in it.  Intervals of
+                        // USB_PERIODIC_SCHEDULE_FRAMES or more are counted as
+                        // using their slot in every schedule period.
+                        span = USB_PERIODIC_SCHEDULE_FRAMES;
+                        if (pEndpoint->wInterval < USB_PERIODIC_SCHEDULE_FRAMES)
+                        {
+                            span = (uint8_t)pEndpoint->wInterval;
+                        }
+
+                        bestPhase = 0;
+                        bestLoad  = 0xFF;
+                        for (phase=0; phase<span; phase++)
+                        {
+                            worstLoad = 0;
+                            for (i=phase; i<USB_PERIODIC_SCHEDULE_FRAMES; i+=span)
+                            {
+                                if (frameLoad[i] > worstLoad)
+                                {
+                                    worstLoad = frameLoad[i];
+                                }
+                            }
+                            if (worstLoad < bestLoad)
+                            {
+                                bestLoad  = worstLoad;
+                                bestPhase = phase;
+                            }
+                        }
+
+                        for (i=bestPhase; i<USB_PERIODIC_SCHEDULE_FRAMES; i+=span)
+                        {
+                            frameLoad[i]++;
+                        }
+                        pEndpoint->schedulePhase = bestPhase;
+                    }
+                }
+                pEndpoint = pEndpoint->next;
+            }
+        }
+        pInterface = pInterface->next;
+    }
+
+    for (i=0; i<USB_ENDPOINT_TABLE_SIZE; i++)
+    {
+        pDevice->pEndpointTable[i] = pTable[i];
+    }
+    for (i=0; i<4; i++)
+    {
+        pDevice->readyEndpoints[i] = ready[i];
+    }
+    pDevice->bulkServedMask = 0;
+    pDevice->bulkNext       = 0;
+}
 
 
 /****************************************************************************
@@ -3142,7 +4149,7 @@ USB_ENDPOINT_INFO * _USB_FindEndpoint( uint8_t endpoint )
 /*
 USB_INTERFACE_INFO * _USB_FindInterface ( uint8_t bInterface, uint8_t bAltSetting )
 {
-    USB_INTERFACE_INFO *pCurIntf = usbDeviceInfo.pInterfaceList;
+    USB_INTERFACE_INFO *pCurIntf = pCurrentDevice->pInterfaceList;
 
     while (pCurIntf)
     {
@@ -3187,8 +4194,8 @@ void _USB_FindNextToken( void )
 
     // If the device is suspended or resuming, do not send any tokens.  We will
     // send the next token on an SOF interrupt after the resume recovery time
-    // has expired.
-    if ((usbHostState & (SUBSTATE_MASK | SUBSUBSTATE_MASK)) == (STATE_RUNNING | SUBSTATE_SUSPEND_AND_RESUME))
+    // has expired.  Only the device on the root port is ever suspended.
+    if ((USB_ROOT_DEVICE->state & (SUBSTATE_MASK | SUBSUBSTATE_MASK)) == (STATE_RUNNING | SUBSTATE_SUSPEND_AND_RESUME))
     {
         return;
     }
@@ -3237,23 +4244,7 @@ void _USB_FindNextToken( void )
                             pCurrentEndpoint->transferState               = TSTATE_IDLE;
                             pCurrentEndpoint->status.bfTransferComplete   = 1;
                             #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                {
-                                    USB_EVENT_DATA *data;
-
-                                    data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                    data->event = EVENT_TRANSFER;
-                                    data->TransferData.dataCount        = pCurrentEndpoint->dataCount;
-                                    data->TransferData.pUserData        = pCurrentEndpoint->pUserData;
-                                    data->TransferData.bErrorCode       = USB_SUCCESS;
-                                    data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                    data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                    data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                }
-                                else
-                                {
-                                    pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                }
+                                _USB_QueueTransferEvent( EVENT_TRANSFER, pCurrentEndpoint->dataCount, pCurrentEndpoint->pUserData, USB_SUCCESS );
                             #endif
                     break;
 
@@ -3261,23 +4252,7 @@ void _USB_FindNextToken( void )
                             pCurrentEndpoint->transferState               = TSTATE_IDLE;
                             pCurrentEndpoint->status.bfTransferComplete   = 1;
                             #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                {
-                                    USB_EVENT_DATA *data;
-
-                                    data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                    data->event = EVENT_BUS_ERROR;
-                                    data->TransferData.dataCount        = 0;
-                                    data->TransferData.pUserData        = NULL;
-                                    data->TransferData.bErrorCode       = pCurrentEndpoint->bErrorCode;
-                                    data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                    data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                    data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                }
-                                else
-                                {
-                                    pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                }
+                                _USB_QueueTransferEvent( EVENT_BUS_ERROR, 0, NULL, pCurrentEndpoint->bErrorCode );
                             #endif
                             break;
 
@@ -3324,23 +4299,7 @@ void _USB_FindNextToken( void )
                             pCurrentEndpoint->transferState               = TSTATE_IDLE;
                             pCurrentEndpoint->status.bfTransferComplete   = 1;
                             #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                {
-                                    USB_EVENT_DATA *data;
-
-                                    data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                    data->event = EVENT_TRANSFER;
-                                    data->TransferData.dataCount        = pCurrentEndpoint->dataCount;
-                                    data->TransferData.pUserData        = pCurrentEndpoint->pUserData;
-                                    data->TransferData.bErrorCode       = USB_SUCCESS;
-                                    data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                    data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                    data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                }
-                                else
-                                {
-                                    pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                }
+                                _USB_QueueTransferEvent( EVENT_TRANSFER, pCurrentEndpoint->dataCount, pCurrentEndpoint->pUserData, USB_SUCCESS );
                             #endif
                             break;
 
@@ -3348,23 +4307,7 @@ void _USB_FindNextToken( void )
                             pCurrentEndpoint->transferState               = TSTATE_IDLE;
                             pCurrentEndpoint->status.bfTransferComplete   = 1;
                             #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                {
-                                    USB_EVENT_DATA *data;
-
-                                    data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                    data->event = EVENT_BUS_ERROR;
-                                    data->TransferData.dataCount        = 0;
-                                    data->TransferData.pUserData        = NULL;
-                                    data->TransferData.bErrorCode       = pCurrentEndpoint->bErrorCode;
-                                    data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                    data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                    data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                }
-                                else
-                                {
-                                    pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                }
+                                _USB_QueueTransferEvent( EVENT_BUS_ERROR, 0, NULL, pCurrentEndpoint->bErrorCode );
                             #endif
                             break;
 
@@ -3411,23 +4354,7 @@ void _USB_FindNextToken( void )
                             pCurrentEndpoint->transferState               = TSTATE_IDLE;
                             pCurrentEndpoint->status.bfTransferComplete   = 1;
                             #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                {
-                                    USB_EVENT_DATA *data;
-
-                                    data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                    data->event = EVENT_TRANSFER;
-                                    data->TransferData.dataCount        = pCurrentEndpoint->dataCount;
-                                    data->TransferData.pUserData        = pCurrentEndpoint->pUserData;
-                                    data->TransferData.bErrorCode       = USB_SUCCESS;
-                                    data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                    data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                    data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                }
-                                else
-                                {
-                                    pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                }
+                                _USB_QueueTransferEvent( EVENT_TRANSFER, pCurrentEndpoint->dataCount, pCurrentEndpoint->pUserData, USB_SUCCESS );
                             #endif
                             break;
 
@@ -3435,23 +4362,7 @@ void _USB_FindNextToken( void )
                             pCurrentEndpoint->transferState               = TSTATE_IDLE;
                             pCurrentEndpoint->status.bfTransferComplete   = 1;
                             #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                {
-                                    USB_EVENT_DATA *data;
-
-                                    data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                    data->event = EVENT_BUS_ERROR;
-                                    data->TransferData.dataCount        = 0;
-                                    data->TransferData.pUserData        = NULL;
-                                    data->TransferData.bErrorCode       = pCurrentEndpoint->bErrorCode;
-                                    data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                    data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                    data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                }
-                                else
-                                {
-                                    pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                }
+                                _USB_QueueTransferEvent( EVENT_BUS_ERROR, 0, NULL, pCurrentEndpoint->bErrorCode );
                             #endif
                             break;
 
@@ -3488,10 +4399,10 @@ void _USB_FindNextToken( void )
 
         // MCHP: Implement scheduling by using usbBusInfo.dBytesSentInFrame
 
-        // Current Limitation:  The stack currently supports only one attached
-        // device.  We will make the assumption that the control, isochronous, and
-        // interrupt transfers requested by a single device will not exceed one
-        // frame, and defer the scheduler.
+        // Current Limitation:  We will make the assumption that the control,
+        // isochronous, and interrupt transfers requested by the attached devices
+        // will not exceed one frame, and defer the scheduler.  The periodic
+        // endpoints are spread over the frames by _USB_BuildEndpointTable().
 
         // Due to the nature of isochronous transfers, transfer events must be used.
         #if !defined( USB_ENABLE_TRANSFER_EVENT )
@@ -3512,7 +4423,9 @@ void _USB_FindNextToken( void )
                                 // Don't overwrite data the user has not yet processed.  We will skip this interval.    
                                 if (((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].bfDataLengthValid)
                                 {
-                                    // We have buffer overflow.
+                                    // We have buffer overflow.  Skip this interval.
+                                    ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->overruns++;
+                                    pCurrentEndpoint->wIntervalCount    = pCurrentEndpoint->wInterval;
                                 }
                                 else
                                 {
@@ -3536,33 +4449,22 @@ void _USB_FindNextToken( void )
 
                                 // Update the valid data length for this buffer.
                                 ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].dataLength = pCurrentEndpoint->dataCount;
+                                ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].frameNumber = usbBusInfo.frameNumber;
                                 ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].bfDataLengthValid = 1;
                                 #if defined( USB_ENABLE_ISOC_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_TRANSFER;
-                                        data->TransferData.dataCount        = pCurrentEndpoint->dataCount;
-                                        data->TransferData.pUserData        = ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].pBuffer;
-                                        data->TransferData.bErrorCode       = USB_SUCCESS;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                        data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_TRANSFER, pCurrentEndpoint->dataCount, ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].pBuffer, USB_SUCCESS );
                                 #endif
                                 
                                 // If the user wants an event from the interrupt handler to handle the data as quickly as
-                                // possible, send up the event.  Then mark the packet as used.
+                                // possible, send up the event.  If the data was handled, mark the packet as used;
+                                // otherwise it stays in the ring until the application releases it.
                                 #ifdef USB_HOST_APP_DATA_EVENT_HANDLER
-                                    usbClientDrvTable[pCurrentEndpoint->clientDriver].DataEventHandler( usbDeviceInfo.deviceAddress, EVENT_DATA_ISOC_READ, ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].pBuffer, pCurrentEndpoint->dataCount );
-                                    ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].bfDataLengthValid = 0;
+                                    if (usbClientDrvTable[pCurrentEndpoint->clientDriver].DataEventHandler( pCurrentEndpointDevice->deviceAddress, EVENT_DATA_ISOC_READ, ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].pBuffer, pCurrentEndpoint->dataCount ))
+                                    {
+                                        ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].bfDataLengthValid = 0;
+                                    }
                                 #endif
+                                _USB_IsochronousFillChanged( (ISOCHRONOUS_DATA *)pCurrentEndpoint->pUserData );
                                 
                                 // Move to the next data buffer.
                                 ((ISOCHRONOUS_DATA *)pCurrentEndpoint->pUserData)->currentBufferUSB++;
@@ -3579,22 +4481,7 @@ void _USB_FindNextToken( void )
                                 pCurrentEndpoint->transferState     = TSTATE_ISOCHRONOUS_READ | TSUBSTATE_ISOCHRONOUS_READ_DATA;
                                 pCurrentEndpoint->wIntervalCount    = pCurrentEndpoint->wInterval;
                                 #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_BUS_ERROR;
-                                        data->TransferData.dataCount        = 0;
-                                        data->TransferData.pUserData        = NULL;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bErrorCode       = pCurrentEndpoint->bErrorCode;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_BUS_ERROR, 0, NULL, pCurrentEndpoint->bErrorCode );
                                 #endif
                                 break;
 
@@ -3610,7 +4497,9 @@ void _USB_FindNextToken( void )
                             case TSUBSTATE_ISOCHRONOUS_WRITE_DATA:
                                 if (!((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].bfDataLengthValid)
                                 {
-                                    // We have buffer underrun.
+                                    // We have buffer underrun.  Skip this interval.
+                                    ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->underruns++;
+                                    pCurrentEndpoint->wIntervalCount    = pCurrentEndpoint->wInterval;
                                 }
                                 else
                                 {
@@ -3631,31 +4520,16 @@ void _USB_FindNextToken( void )
                                 pCurrentEndpoint->transferState     = TSTATE_ISOCHRONOUS_WRITE | TSUBSTATE_ISOCHRONOUS_WRITE_DATA;
 
                                 // Update the valid data length for this buffer.
+                                ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].frameNumber = usbBusInfo.frameNumber;
                                 ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].bfDataLengthValid = 0;
                                 #if defined( USB_ENABLE_ISOC_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_TRANSFER;
-                                        data->TransferData.dataCount        = pCurrentEndpoint->dataCount;
-                                        data->TransferData.pUserData        = ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].pBuffer;
-                                        data->TransferData.bErrorCode       = USB_SUCCESS;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                        data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_TRANSFER, pCurrentEndpoint->dataCount, ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].pBuffer, USB_SUCCESS );
                                 #endif
 
                                 // If the user wants an event from the interrupt handler to handle the data as quickly as
                                 // possible, send up the event.
                                 #ifdef USB_HOST_APP_DATA_EVENT_HANDLER
-                                    usbClientDrvTable[pCurrentEndpoint->clientDriver].DataEventHandler( usbDeviceInfo.deviceAddress, EVENT_DATA_ISOC_WRITE, ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].pBuffer, pCurrentEndpoint->dataCount );
+                                    usbClientDrvTable[pCurrentEndpoint->clientDriver].DataEventHandler( pCurrentEndpointDevice->deviceAddress, EVENT_DATA_ISOC_WRITE, ((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].pBuffer, pCurrentEndpoint->dataCount );
                                 #endif
                                                                 
                                 // Move to the next data buffer.
@@ -3665,6 +4539,7 @@ void _USB_FindNextToken( void )
                                     ((ISOCHRONOUS_DATA *)pCurrentEndpoint->pUserData)->currentBufferUSB = 0;
                                 }
 								((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].bfDataLengthValid = 1;                                
+                                _USB_IsochronousFillChanged( (ISOCHRONOUS_DATA *)pCurrentEndpoint->pUserData );
                                 break;
 
                             case TSUBSTATE_ERROR:
@@ -3675,23 +4550,7 @@ void _USB_FindNextToken( void )
                                 pCurrentEndpoint->wIntervalCount    = pCurrentEndpoint->wInterval;
 
                                 #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_BUS_ERROR;
-                                        data->TransferData.dataCount        = 0;
-                                        data->TransferData.pUserData        = NULL;
-                                        data->TransferData.bErrorCode       = pCurrentEndpoint->bErrorCode;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                        data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_BUS_ERROR, 0, NULL, pCurrentEndpoint->bErrorCode );
                                 #endif
                                 break;
 
@@ -3743,23 +4602,7 @@ void _USB_FindNextToken( void )
                                 pCurrentEndpoint->wIntervalCount            = pCurrentEndpoint->wInterval;
                                 pCurrentEndpoint->status.bfTransferComplete = 1;
                                 #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_TRANSFER;
-                                        data->TransferData.dataCount        = pCurrentEndpoint->dataCount;
-                                        data->TransferData.pUserData        = pCurrentEndpoint->pUserData;
-                                        data->TransferData.bErrorCode       = USB_SUCCESS;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                        data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_TRANSFER, pCurrentEndpoint->dataCount, pCurrentEndpoint->pUserData, USB_SUCCESS );
                                 #endif
                                 break;
 
@@ -3768,23 +4611,7 @@ void _USB_FindNextToken( void )
                                 pCurrentEndpoint->wIntervalCount            = pCurrentEndpoint->wInterval;
                                 pCurrentEndpoint->status.bfTransferComplete = 1;
                                 #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_BUS_ERROR;
-                                        data->TransferData.dataCount        = 0;
-                                        data->TransferData.pUserData        = NULL;
-                                        data->TransferData.bErrorCode       = pCurrentEndpoint->bErrorCode;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                        data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_BUS_ERROR, 0, NULL, pCurrentEndpoint->bErrorCode );
                                 #endif
                                 break;
 
@@ -3808,23 +4635,7 @@ void _USB_FindNextToken( void )
                                 pCurrentEndpoint->wIntervalCount            = pCurrentEndpoint->wInterval;
                                 pCurrentEndpoint->status.bfTransferComplete = 1;
                                 #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_TRANSFER;
-                                        data->TransferData.dataCount        = pCurrentEndpoint->dataCount;
-                                        data->TransferData.pUserData        = pCurrentEndpoint->pUserData;
-                                        data->TransferData.bErrorCode       = USB_SUCCESS;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                        data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_TRANSFER, pCurrentEndpoint->dataCount, pCurrentEndpoint->pUserData, USB_SUCCESS );
                                 #endif
                                 break;
 
@@ -3833,23 +4644,7 @@ void _USB_FindNextToken( void )
                                 pCurrentEndpoint->wIntervalCount            = pCurrentEndpoint->wInterval;
                                 pCurrentEndpoint->status.bfTransferComplete = 1;
                                 #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_BUS_ERROR;
-                                        data->TransferData.dataCount        = 0;
-                                        data->TransferData.pUserData        = NULL;
-                                        data->TransferData.bErrorCode       = pCurrentEndpoint->bErrorCode;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                        data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_BUS_ERROR, 0, NULL, pCurrentEndpoint->bErrorCode );
                                 #endif
                                 break;
 
@@ -3910,23 +4705,7 @@ TryBulk:
                                 pCurrentEndpoint->transferState               = TSTATE_IDLE;
                                 pCurrentEndpoint->status.bfTransferComplete   = 1;
                                 #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_TRANSFER;
-                                        data->TransferData.dataCount        = pCurrentEndpoint->dataCount;
-                                        data->TransferData.pUserData        = pCurrentEndpoint->pUserData;
-                                        data->TransferData.bErrorCode       = USB_SUCCESS;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                        data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_TRANSFER, pCurrentEndpoint->dataCount, pCurrentEndpoint->pUserData, USB_SUCCESS );
                                 #endif
                                 break;
 
@@ -3934,23 +4713,7 @@ TryBulk:
                                 pCurrentEndpoint->transferState               = TSTATE_IDLE;
                                 pCurrentEndpoint->status.bfTransferComplete   = 1;
                                 #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_BUS_ERROR;
-                                        data->TransferData.dataCount        = 0;
-                                        data->TransferData.pUserData        = NULL;
-                                        data->TransferData.bErrorCode       = pCurrentEndpoint->bErrorCode;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                        data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_BUS_ERROR, 0, NULL, pCurrentEndpoint->bErrorCode );
                                 #endif
                                 break;
 
@@ -3973,23 +4736,7 @@ TryBulk:
                                 pCurrentEndpoint->transferState               = TSTATE_IDLE;
                                 pCurrentEndpoint->status.bfTransferComplete   = 1;
                                 #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_TRANSFER;
-                                        data->TransferData.dataCount        = pCurrentEndpoint->dataCount;
-                                        data->TransferData.pUserData        = pCurrentEndpoint->pUserData;
-                                        data->TransferData.bErrorCode       = USB_SUCCESS;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                        data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_TRANSFER, pCurrentEndpoint->dataCount, pCurrentEndpoint->pUserData, USB_SUCCESS );
                                 #endif
                                 break;
 
@@ -3997,23 +4744,7 @@ TryBulk:
                                 pCurrentEndpoint->transferState               = TSTATE_IDLE;
                                 pCurrentEndpoint->status.bfTransferComplete   = 1;
                                 #if defined( USB_ENABLE_TRANSFER_EVENT )
-                                    if (StructQueueIsNotFull(&usbEventQueue, USB_EVENT_QUEUE_DEPTH))
-                                    {
-                                        USB_EVENT_DATA *data;
-
-                                        data = StructQueueAdd(&usbEventQueue, USB_EVENT_QUEUE_DEPTH);
-                                        data->event = EVENT_BUS_ERROR;
-                                        data->TransferData.dataCount        = 0;
-                                        data->TransferData.pUserData        = NULL;
-                                        data->TransferData.bErrorCode       = pCurrentEndpoint->bErrorCode;
-                                        data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
-                                        data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
-                                        data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
-                                    }
-                                    else
-                                    {
-                                        pCurrentEndpoint->bmAttributes.val = USB_EVENT_QUEUE_FULL;
-                                    }
+                                    _USB_QueueTransferEvent( EVENT_BUS_ERROR, 0, NULL, pCurrentEndpoint->bErrorCode );
                                 #endif
                                 break;
 
@@ -4043,7 +4774,7 @@ TryBulk:
             #ifdef ALLOW_MULTIPLE_BULK_TRANSACTIONS_PER_FRAME
                 if (usbBusInfo.countBulkTransactions)
                 {
-                    usbBusInfo.lastBulkTransaction = 0;
+                    _USB_StartBulkPass();
                     goto TryBulk;
 
                 }
@@ -4052,9 +4783,130 @@ TryBulk:
             // If we've gone through all the endpoints, we do not have any more bulk transfers.
             usbBusInfo.flags.bfBulkTransfersDone = 1;
         }
-    #endif
+    #endif
+
+    return;
+}
+
+
+/****************************************************************************
+  Function:
+    bool _USB_FindDeviceServiceEndpoint( USB_DEVICE_INFO *pDevice, uint8_t transferType )
+
+  Description:
+    This function finds an endpoint of the specified transfer type that is
+    ready for servicing on one device.  If it finds one, pCurrentEndpoint is
+    updated to point to the endpoint information structure.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_DEVICE_INFO *pDevice - The device.
+    uint8_t transferType - Endpoint transfer type.  Valid values are:
+                            * USB_TRANSFER_TYPE_CONTROL
+                            * USB_TRANSFER_TYPE_ISOCHRONOUS
+                            * USB_TRANSFER_TYPE_INTERRUPT
+                            * USB_TRANSFER_TYPE_BULK
+
+  Return Values:
+    true    - An endpoint of the indicated transfer type needs to be serviced,
+                and pCurrentEndpoint has been updated to point to the endpoint.
+    false   - No endpoints of the indicated transfer type need to be serviced.
+
+  Remarks:
+    Only the endpoints on the ready list of the transfer type are examined.
+    Entries whose transfer has completed are removed from the list here.
+
+    Interrupt and isochronous endpoints are only returned in their frame
+    slot (wIntervalCount == 0, set by the SOF interrupt).  Bulk endpoints are
+    searched round robin starting after the last one serviced, and each one
+    is returned at most once per pass (pDevice->bulkServedMask).
+  ***************************************************************************/
+bool _USB_FindDeviceServiceEndpoint( USB_DEVICE_INFO *pDevice, uint8_t transferType )
+{
+    USB_ENDPOINT_INFO           *pEndpoint;
+    uint32_t                    pending;
+    uint32_t                    bit;
+    uint8_t                     i;
+
+    // Check endpoint 0.
+    if ((pDevice->pEndpoint0->bmAttributes.bfTransferType == transferType) &&
+        !pDevice->pEndpoint0->status.bfTransferComplete)
+    {
+        pCurrentEndpoint = pDevice->pEndpoint0;
+        return true;
+    }
+
+    i = 0;
+    if (transferType == USB_TRANSFER_TYPE_BULK)
+    {
+        i = pDevice->bulkNext;
+    }
+
+    pending = pDevice->readyEndpoints[transferType];
+    while (pending)
+    {
+        bit = (uint32_t)1 << i;
+        if (pending & bit)
+        {
+            pending &= ~bit;
+
+            pEndpoint = pDevice->pEndpointTable[i];
+            if ((pEndpoint == NULL) || pEndpoint->status.bfTransferComplete)
+            {
+                // The transfer has finished, so take the endpoint off the list.
+                pDevice->readyEndpoints[transferType] &= ~bit;
+            }
+            else
+            {
+                switch (transferType)
+                {
+                    case USB_TRANSFER_TYPE_CONTROL:
+                        pCurrentEndpoint = pEndpoint;
+                        return true;
+                        break;
+
+                    #ifdef USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+                    case USB_TRANSFER_TYPE_ISOCHRONOUS:
+                    #endif
+                    #ifdef USB_SUPPORT_INTERRUPT_TRANSFERS
+                    case USB_TRANSFER_TYPE_INTERRUPT:
+                    #endif
+                    #if defined( USB_SUPPORT_ISOCHRONOUS_TRANSFERS ) || defined( USB_SUPPORT_INTERRUPT_TRANSFERS )
+                        if (pEndpoint->wIntervalCount == 0)
+                        {
+                            pCurrentEndpoint = pEndpoint;
+                            return true;
+                        }
+                        break;
+                    #endif
+
+                    #ifdef USB_SUPPORT_BULK_TRANSFERS
+                    case USB_TRANSFER_TYPE_BULK:
+                        #ifndef ALLOW_MULTIPLE_NAKS_PER_FRAME
+                        if (!pEndpoint->status.bfLastTransferNAKd)
+                        #endif
+                        {
+                            usbBusInfo.countBulkTransactions ++;
+                            if (!(pDevice->bulkServedMask & bit))
+                            {
+                                pDevice->bulkServedMask   |= bit;
+                                pDevice->bulkNext         = (i + 1) & (USB_ENDPOINT_TABLE_SIZE - 1);
+                                pCurrentEndpoint            = pEndpoint;
+                                return true;
+                            }
+                        }
+                        break;
+                    #endif
+                }
+            }
+        }
+        i = (i + 1) & (USB_ENDPOINT_TABLE_SIZE - 1);
+    }
 
-    return;
+    // No endpoints with the desired description are ready for servicing.
+    return false;
 }
 
 
@@ -4064,8 +4916,9 @@ TryBulk:
 
   Description:
     This function finds an endpoint of the specified transfer type that is
-    ready for servicing.  If it finds one, usbDeviceInfo.pCurrentEndpoint is
-    updated to point to the endpoint information structure.
+    ready for servicing on any attached device.  If it finds one,
+    pCurrentEndpoint is updated to point to the endpoint information
+    structure and pCurrentEndpointDevice to the device.
 
   Precondition:
     None
@@ -4083,109 +4936,34 @@ TryBulk:
     false   - No endpoints of the indicated transfer type need to be serviced.
 
   Remarks:
-    The EP 0 block is retained.
+    The devices are searched in device table order, except for bulk: the
+    bulk search starts at the device after the one last serviced, so a
+    device with a long bulk transfer cannot keep the others off the bus.
   ***************************************************************************/
 bool _USB_FindServiceEndpoint( uint8_t transferType )
 {
-    USB_ENDPOINT_INFO           *pEndpoint;
-    USB_INTERFACE_INFO          *pInterface;
-
-    // Check endpoint 0.
-    if ((usbDeviceInfo.pEndpoint0->bmAttributes.bfTransferType == transferType) &&
-        !usbDeviceInfo.pEndpoint0->status.bfTransferComplete)
-    {
-        pCurrentEndpoint = usbDeviceInfo.pEndpoint0;
-        return true;
-    }
+    uint8_t                     i;
+    uint8_t                     n;
 
-    usbBusInfo.countBulkTransactions = 0;
-    pEndpoint = NULL;
-    pInterface = usbDeviceInfo.pInterfaceList;
-    if (pInterface && pInterface->pCurrentSetting)
+    i = 0;
+    if (transferType == USB_TRANSFER_TYPE_BULK)
     {
-        pEndpoint = pInterface->pCurrentSetting->pEndpointList;
+        usbBusInfo.countBulkTransactions = 0;
+        i = usbBusInfo.bulkDevice;
     }
 
-    while (pInterface)
+    for (n=0; n<USB_MAX_DEVICES; n++)
     {
-        if (pEndpoint != NULL)
-        {
-			if (pEndpoint->bmAttributes.bfTransferType == transferType)
-			{
-				switch (transferType)
-				{
-					case USB_TRANSFER_TYPE_CONTROL:
-						if (!pEndpoint->status.bfTransferComplete)
-						{
-							pCurrentEndpoint = pEndpoint;
-							return true;
-						}
-						break;
-
-					#ifdef USB_SUPPORT_ISOCHRONOUS_TRANSFERS
-					case USB_TRANSFER_TYPE_ISOCHRONOUS:
-					#endif
-					#ifdef USB_SUPPORT_INTERRUPT_TRANSFERS
-					case USB_TRANSFER_TYPE_INTERRUPT:
-					#endif
-					#if defined( USB_SUPPORT_ISOCHRONOUS_TRANSFERS ) || defined( USB_SUPPORT_INTERRUPT_TRANSFERS )
-						if (pEndpoint->status.bfTransferComplete)
-						{
-							// The endpoint doesn't need servicing.  If the interval count
-							// has reached 0 and the user has not initiated another transaction,
-							// reset the interval count for the next interval.
-							if (pEndpoint->wIntervalCount == 0)
-							{
-								// Reset the interval count for the next packet.
-								pEndpoint->wIntervalCount = pEndpoint->wInterval;
-							}
-						}
-						else
-						{
-							if (pEndpoint->wIntervalCount == 0)
-							{
-    							pCurrentEndpoint = pEndpoint;
-    							return true;
-    			            }				
-						}
-						break;
-					#endif
-
-					#ifdef USB_SUPPORT_BULK_TRANSFERS
-					case USB_TRANSFER_TYPE_BULK:
-						#ifdef ALLOW_MULTIPLE_NAKS_PER_FRAME
-						if (!pEndpoint->status.bfTransferComplete)
-						#else
-						if (!pEndpoint->status.bfTransferComplete &&
-							!pEndpoint->status.bfLastTransferNAKd)
-						#endif
-						{
-							usbBusInfo.countBulkTransactions ++;
-							if (usbBusInfo.countBulkTransactions > usbBusInfo.lastBulkTransaction)
-							{
-								usbBusInfo.lastBulkTransaction  = usbBusInfo.countBulkTransactions;
-								pCurrentEndpoint                = pEndpoint;
-								return true;
-							}
-						}
-						break;
-					#endif
-				}
-			}
-
-	        // Go to the next endpoint.
-            pEndpoint = pEndpoint->next;
-        }
-
-        if (pEndpoint == NULL)
+        if (_USB_DeviceInUse( i ) && _USB_FindDeviceServiceEndpoint( &usbDeviceInfo[i], transferType ))
         {
-            // Go to the next interface.
-            pInterface = pInterface->next;
-            if (pInterface && pInterface->pCurrentSetting)
+            pCurrentEndpointDevice = &usbDeviceInfo[i];
+            if (transferType == USB_TRANSFER_TYPE_BULK)
             {
-                pEndpoint = pInterface->pCurrentSetting->pEndpointList;
+                usbBusInfo.bulkDevice = (i + 1) % USB_MAX_DEVICES;
             }
+            return true;
         }
+        i = (i + 1) % USB_MAX_DEVICES;
     }
 
     // No endpoints with the desired description are ready for servicing.
@@ -4199,7 +4977,7 @@ bool _USB_FindServiceEndpoint( uint8_t transferType )
 
   Description:
     This function frees the interface and endpoint lists associated
-                with a configuration.
+                with a configuration of the current device.
 
   Precondition:
     None
@@ -4211,37 +4989,24 @@ bool _USB_FindServiceEndpoint( uint8_t transferType )
     None
 
   Remarks:
-    The EP 0 block is retained.
+    The EP 0 block is retained.  The lists were the last thing allocated
+    from the enumeration arena, so they are freed by returning the arena to
+    the mark taken in _USB_ParseConfigurationDescriptor().
   ***************************************************************************/
 
 void _USB_FreeConfigMemory( void )
 {
-    USB_INTERFACE_INFO          *pTempInterface;
-    USB_INTERFACE_SETTING_INFO  *pTempSetting;
-    USB_ENDPOINT_INFO           *pTempEndpoint;
-
-    while (usbDeviceInfo.pInterfaceList != NULL)
+    pCurrentDevice->pInterfaceList = NULL;
+    if (pCurrentDevice->arena.configMark != USB_ENUMERATION_ARENA_NO_MARK)
     {
-        pTempInterface = usbDeviceInfo.pInterfaceList->next;
-
-        while (usbDeviceInfo.pInterfaceList->pInterfaceSettings != NULL)
-        {
-            pTempSetting = usbDeviceInfo.pInterfaceList->pInterfaceSettings->next;
-
-            while (usbDeviceInfo.pInterfaceList->pInterfaceSettings->pEndpointList != NULL)
-            {
-                pTempEndpoint = usbDeviceInfo.pInterfaceList->pInterfaceSettings->pEndpointList->next;
-                USB_FREE_AND_CLEAR( usbDeviceInfo.pInterfaceList->pInterfaceSettings->pEndpointList );
-                usbDeviceInfo.pInterfaceList->pInterfaceSettings->pEndpointList = pTempEndpoint;
-            }
-            USB_FREE_AND_CLEAR( usbDeviceInfo.pInterfaceList->pInterfaceSettings );
-            usbDeviceInfo.pInterfaceList->pInterfaceSettings = pTempSetting;
-        }
-        USB_FREE_AND_CLEAR( usbDeviceInfo.pInterfaceList );
-        usbDeviceInfo.pInterfaceList = pTempInterface;
+        pCurrentDevice->arena.top = pCurrentDevice->arena.configMark;
     }
+    _USB_BuildEndpointTable( pCurrentDevice );
 
-    pCurrentEndpoint = usbDeviceInfo.pEndpoint0;
+    if (pCurrentEndpointDevice == pCurrentDevice)
+    {
+        pCurrentEndpoint = pCurrentDevice->pEndpoint0;
+    }
 
 } // _USB_FreeConfigMemory
 
@@ -4251,8 +5016,8 @@ void _USB_FreeConfigMemory( void )
     void _USB_FreeMemory( void )
 
   Description:
-    This function frees all memory that can be freed.  Only the EP0
-    information block is retained.
+    This function frees all memory of the current device that can be
+    freed.  Only the EP0 information block is retained.
 
   Precondition:
     None
@@ -4264,31 +5029,18 @@ void _USB_FreeConfigMemory( void )
     None
 
   Remarks:
-    None
+    Everything else was allocated from the enumeration arena, which is
+    reset in one step.
   ***************************************************************************/
 
 void _USB_FreeMemory( void )
 {
-    uint8_t    *pTemp;
-
-    while (usbDeviceInfo.pConfigurationDescriptorList != NULL)
-    {
-        pTemp = (uint8_t *)usbDeviceInfo.pConfigurationDescriptorList->next;
-        USB_FREE_AND_CLEAR( usbDeviceInfo.pConfigurationDescriptorList->descriptor );
-        USB_FREE_AND_CLEAR( usbDeviceInfo.pConfigurationDescriptorList );
-        usbDeviceInfo.pConfigurationDescriptorList = (USB_CONFIGURATION *)pTemp;
-    }
-    if (pDeviceDescriptor != NULL)
-    {
-        USB_FREE_AND_CLEAR( pDeviceDescriptor );
-    }
-    if (pEP0Data != NULL)
-    {
-        USB_FREE_AND_CLEAR( pEP0Data );
-    }
+    pCurrentDevice->pConfigurationDescriptorList    = NULL;
+    pCurrentDevice->pDeviceDescriptor               = NULL;
+    pCurrentDevice->pEP0Data                        = NULL;
 
     _USB_FreeConfigMemory();
-
+    _USB_ResetEnumerationArena();
 }
 
 
@@ -4406,6 +5158,55 @@ void _USB_InitControlWrite( USB_ENDPOINT_INFO *pEndpoint, uint8_t *pControlData,
 }
 
 
+/****************************************************************************
+  Function:
+    void _USB_InitDevice( void )
+
+  Description:
+    This function initializes EP0 and the enumeration information of
+    pCurrentDevice before a new device is enumerated with it.
+
+  Precondition:
+    pCurrentDevice->pEndpoint0 has been allocated.
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+void _USB_InitDevice( void )
+{
+    // Initialize Endpoint 0 attributes.
+    pCurrentDevice->pEndpoint0->next                         = NULL;
+    pCurrentDevice->pEndpoint0->status.val                   = 0x00;
+    pCurrentDevice->pEndpoint0->status.bfUseDTS              = 1;
+    pCurrentDevice->pEndpoint0->status.bfTransferComplete    = 1;    // Initialize to success to allow preprocessing loops.
+    pCurrentDevice->pEndpoint0->status.bfNAKTimeoutEnabled   = 1;    // So we can catch devices that NAK forever during enumeration
+    pCurrentDevice->pEndpoint0->timeoutNAKs                  = USB_NUM_CONTROL_NAKS;
+    pCurrentDevice->pEndpoint0->wMaxPacketSize               = 64;
+    pCurrentDevice->pEndpoint0->dataCount                    = 0;    // Initialize to 0 since we set bfTransferComplete.
+    pCurrentDevice->pEndpoint0->bEndpointAddress             = 0;
+    pCurrentDevice->pEndpoint0->transferState                = TSTATE_IDLE;
+    pCurrentDevice->pEndpoint0->bmAttributes.bfTransferType  = USB_TRANSFER_TYPE_CONTROL;
+    pCurrentDevice->pEndpoint0->clientDriver                 = CLIENT_DRIVER_HOST;
+
+    // Initialize any device specific information.
+    pCurrentDevice->numEnumerationTries     = USB_NUM_ENUMERATION_TRIES;
+    pCurrentDevice->currentConfiguration    = 0; // Will be overwritten by config process or the user later
+    pCurrentDevice->attributesOTG           = 0;
+    pCurrentDevice->deviceAddressAndSpeed   = 0;
+    pCurrentDevice->deviceAddress           = 0;
+    pCurrentDevice->flags.val               = 0;
+    pCurrentDevice->pInterfaceList          = NULL;
+    _USB_BuildEndpointTable( pCurrentDevice );
+}
+
+
 /****************************************************************************
   Function:
     void _USB_InitRead( USB_ENDPOINT_INFO *pEndpoint, uint8_t *pData,
@@ -4541,6 +5342,49 @@ void _USB_InitWrite( USB_ENDPOINT_INFO *pEndpoint, uint8_t *pData, uint16_t size
 }
 
 
+/****************************************************************************
+  Function:
+    void _USB_IsochronousFillChanged( ISOCHRONOUS_DATA *isocData )
+
+  Description:
+    This function is called from the USB interrupt after a buffer of an
+    isochronous transfer has been received or sent.  It updates the
+    high-water mark of the buffers, and calls the watermark handler if the
+    fill level is now at the watermark.
+
+  Precondition:
+    None
+
+  Parameters:
+    ISOCHRONOUS_DATA *isocData  - The isochronous data buffers
+
+  Returns:
+    None
+
+  Remarks:
+    A receive only raises the fill level and a send only lowers it, so the
+    handler is called when the level crosses the watermark in the direction
+    that needs the application's attention.
+  ***************************************************************************/
+#ifdef USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+
+void _USB_IsochronousFillChanged( ISOCHRONOUS_DATA *isocData )
+{
+    uint8_t    filled;
+
+    filled = USBHostIsochronousBuffersFilled( isocData );
+    if (filled > isocData->highWater)
+    {
+        isocData->highWater = filled;
+    }
+    if ((isocData->watermark != 0) && (filled == isocData->watermark) && (isocData->pWatermarkHandler != NULL))
+    {
+        isocData->pWatermarkHandler( isocData, filled );
+    }
+}
+#endif
+
+
 /****************************************************************************
   Function:
     void _USB_NotifyClients( uint8_t address, USB_EVENT event, void *data,
@@ -4563,12 +5407,12 @@ void _USB_InitWrite( USB_ENDPOINT_INFO *pEndpoint, uint8_t *pData, uint16_t size
     None
 
   Remarks:
-    When this driver is modified to support multiple devices, this function
-    will require modification.
+    None
   ***************************************************************************/
 
 void _USB_NotifyClients( uint8_t address, USB_EVENT event, void *data, unsigned int size )
 {
+    USB_DEVICE_INFO     *pDevice;
     USB_INTERFACE_INFO  *pInterface;
 
     // Some events go to all drivers, some only to specific drivers.
@@ -4582,16 +5426,22 @@ void _USB_NotifyClients( uint8_t address, USB_EVENT event, void *data, unsigned
             }
             break;
         default:
-            pInterface = usbDeviceInfo.pInterfaceList;
+            pDevice = _USB_FindDevice( address );
+            if (pDevice == NULL)
+            {
+                break;
+            }
+
+            pInterface = pDevice->pInterfaceList;
             while (pInterface != NULL)  // Scan the interface list for all active drivers.
             {
                 usbClientDrvTable[pInterface->clientDriver].EventHandler(address, event, data, size);
                 pInterface = pInterface->next;
             }
 
-            if(usbDeviceInfo.flags.bfUseEP0Driver == 1)
+            if(pDevice->flags.bfUseEP0Driver == 1)
             {
-                usbClientDrvTable[usbDeviceInfo.deviceEP0Driver].EventHandler(address, event, data, size);
+                usbClientDrvTable[pDevice->deviceEP0Driver].EventHandler(address, event, data, size);
             }
             break;
     }
@@ -4599,7 +5449,7 @@ void _USB_NotifyClients( uint8_t address, USB_EVENT event, void *data, unsigned
 
 /****************************************************************************
   Function:
-    void _USB_NotifyClients( uint8_t address, USB_EVENT event, void *data,
+    void _USB_NotifyDataClients( uint8_t address, USB_EVENT event, void *data,
                 unsigned int size )
 
   Description:
@@ -4610,7 +5460,8 @@ void _USB_NotifyClients( uint8_t address, USB_EVENT event, void *data, unsigned
     None
 
   Parameters:
-    uint8_t address        - Address of the device generating the event
+    uint8_t address        - Address of the device generating the event, or
+                            0 for every attached device
     USB_EVENT event     - Event ID
     void *data          - Pointer to event data
     unsigned int size   - Size of data pointed to by data
@@ -4619,27 +5470,33 @@ void _USB_NotifyClients( uint8_t address, USB_EVENT event, void *data, unsigned
     None
 
   Remarks:
-    When this driver is modified to support multiple devices, this function
-    will require modification.
+    When the event is for every device, each driver is given the address
+    of its own device.
   ***************************************************************************/
 
 void _USB_NotifyDataClients( uint8_t address, USB_EVENT event, void *data, unsigned int size )
 {
+    uint8_t             i;
+    USB_DEVICE_INFO     *pDevice;
     USB_INTERFACE_INFO  *pInterface;
 
-    // Some events go to all drivers, some only to specific drivers.
-    switch(event)
+    for (i=0; i<USB_MAX_DEVICES; i++)
     {
-        default:
-            pInterface = usbDeviceInfo.pInterfaceList;
-            while (pInterface != NULL)  // Scan the interface list for all active drivers.
-            {
-                usbClientDrvTable[pInterface->clientDriver].DataEventHandler(address, event, data, size);
-                pInterface = pInterface->next;
-            }
-            break;
+        pDevice = &usbDeviceInfo[i];
+        if (!_USB_DeviceInUse(i) ||
+            ((address != 0) && (pDevice->deviceAddress != address)))
+        {
+            continue;
+        }
+
+        pInterface = pDevice->pInterfaceList;
+        while (pInterface != NULL)  // Scan the interface list for all active drivers.
+        {
+            usbClientDrvTable[pInterface->clientDriver].DataEventHandler(pDevice->deviceAddress, event, data, size);
+            pInterface = pInterface->next;
+        }
     }
-} // _USB_NotifyClients
+} // _USB_NotifyDataClients
 
 /****************************************************************************
   Function:
@@ -4677,7 +5534,11 @@ void _USB_NotifyAllDataClients( uint8_t address, USB_EVENT event, void *data, un
         default:
             for(i=0;i<NUM_CLIENT_DRIVER_ENTRIES;i++)
             {
-                usbClientDrvTable[i].DataEventHandler(address, event, data, size);
+                // Not every driver has a data event handler.
+                if (usbClientDrvTable[i].DataEventHandler != NULL)
+                {
+                    usbClientDrvTable[i].DataEventHandler(address, event, data, size);
+                }
             }
             break;
     }
@@ -4694,10 +5555,10 @@ void _USB_NotifyAllDataClients( uint8_t address, USB_EVENT event, void *data, un
     information.
 
   Precondition:
-    pCurrentConfigurationDescriptor points to a valid Configuration
-    Descriptor, which contains the endpoint descriptors.  The current
-    interface and the current interface settings must be set up in
-    usbDeviceInfo.
+    pCurrentDevice->pCurrentConfigurationDescriptor points to a valid
+    Configuration Descriptor, which contains the endpoint descriptors.  The
+    current interface and the current interface settings must be set up in
+    pCurrentDevice.
 
   Parameters:
     None - None
@@ -4760,17 +5621,20 @@ bool _USB_ParseConfigurationDescriptor( void )
     currentEndpoint         = 0;
     error                   = false;
     index                   = 0;
-    ptr                     = pCurrentConfigurationDescriptor;
+    ptr                     = pCurrentDevice->pCurrentConfigurationDescriptor;
     currentInterface        = 0;
     currentAlternateSetting = 0;
-    pTempInterfaceList      = usbDeviceInfo.pInterfaceList; // Don't set until everything is in place.
+    pTempInterfaceList      = pCurrentDevice->pInterfaceList; // Don't set until everything is in place.
+
+    // Everything allocated from here on belongs to this configuration.
+    pCurrentDevice->arena.configMark = pCurrentDevice->arena.top;
 
     // Assume no OTG support (determine otherwise, below).
-    usbDeviceInfo.flags.bfSupportsOTG   = 0;
-    usbDeviceInfo.flags.bfConfiguredOTG = 1;
+    pCurrentDevice->flags.bfSupportsOTG   = 0;
+    pCurrentDevice->flags.bfConfiguredOTG = 1;
 
     #ifdef USB_SUPPORT_OTG
-        usbDeviceInfo.flags.bfAllowHNP = 1;  //Allow HNP From Host
+        pCurrentDevice->flags.bfAllowHNP = 1;  //Allow HNP From Host
     #endif
 
     // Load up the values from the Configuration Descriptor
@@ -4790,13 +5654,13 @@ bool _USB_ParseConfigurationDescriptor( void )
     if (!USB_HOST_APP_EVENT_HANDLER( USB_ROOT_HUB, EVENT_VBUS_REQUEST_POWER,
             &powerRequest, sizeof(USB_VBUS_POWER_EVENT_DATA) ))
     {
-        usbDeviceInfo.errorCode = USB_ERROR_INSUFFICIENT_POWER;
+        pCurrentDevice->errorCode = USB_ERROR_INSUFFICIENT_POWER;
         error = true;
     }
 
     // Skip over the rest of the Configuration Descriptor
     index += bLength;
-    ptr    = &pCurrentConfigurationDescriptor[index];
+    ptr    = &pCurrentDevice->pCurrentConfigurationDescriptor[index];
 
     while (!error && (index < wTotalLength))
     {
@@ -4809,18 +5673,18 @@ bool _USB_ParseConfigurationDescriptor( void )
         if (bDescriptorType == USB_DESCRIPTOR_OTG)
         {
             // We found an OTG Descriptor, so the device supports OTG.
-            usbDeviceInfo.flags.bfSupportsOTG = 1;
-            usbDeviceInfo.attributesOTG       = *ptr;
+            pCurrentDevice->flags.bfSupportsOTG = 1;
+            pCurrentDevice->attributesOTG       = *ptr;
 
             // See if we need to send the SET FEATURE command.  If we do,
             // clear the bConfiguredOTG flag.
-            if ( (usbDeviceInfo.attributesOTG & OTG_HNP_SUPPORT) && (usbDeviceInfo.flags.bfAllowHNP))
+            if ( (pCurrentDevice->attributesOTG & OTG_HNP_SUPPORT) && (pCurrentDevice->flags.bfAllowHNP))
             {
-                usbDeviceInfo.flags.bfConfiguredOTG = 0;
+                pCurrentDevice->flags.bfConfiguredOTG = 0;
             }
             else
             {
-                usbDeviceInfo.flags.bfAllowHNP = 0;
+                pCurrentDevice->flags.bfAllowHNP = 0;
             }
         }
 
@@ -4829,7 +5693,7 @@ bool _USB_ParseConfigurationDescriptor( void )
         {
             // Skip over the rest of the Descriptor
             index += bLength;
-            ptr = &pCurrentConfigurationDescriptor[index];
+            ptr = &pCurrentDevice->pCurrentConfigurationDescriptor[index];
         }
         else
         {
@@ -4842,9 +5706,9 @@ bool _USB_ParseConfigurationDescriptor( void )
             Protocol          = *ptr++;
 
             // Get client driver index
-            if (usbDeviceInfo.flags.bfUseDeviceClientDriver)
+            if (pCurrentDevice->flags.bfUseDeviceClientDriver)
             {
-                ClientDriver = usbDeviceInfo.deviceClientDriver;
+                ClientDriver = pCurrentDevice->deviceClientDriver;
             }
             else
             {
@@ -4852,7 +5716,7 @@ bool _USB_ParseConfigurationDescriptor( void )
                 {
                     // If we cannot support this interface, skip it.
                     index += bLength;
-                    ptr = &pCurrentConfigurationDescriptor[index];
+                    ptr = &pCurrentDevice->pCurrentConfigurationDescriptor[index];
                     continue;
                 }
             }
@@ -4866,7 +5730,7 @@ bool _USB_ParseConfigurationDescriptor( void )
             if (newInterfaceInfo == NULL)
             {
                 // This is the first instance of this interface, so create a new node for it.
-                if ((newInterfaceInfo = (USB_INTERFACE_INFO *)USB_MALLOC( sizeof(USB_INTERFACE_INFO) )) == NULL)
+                if ((newInterfaceInfo = (USB_INTERFACE_INFO *)_USB_AllocEnumerationMemory( sizeof(USB_INTERFACE_INFO) )) == NULL)
                 {
                     // Out of memory
                     error = true; 
@@ -4890,7 +5754,7 @@ bool _USB_ParseConfigurationDescriptor( void )
             if (!error)
             {
                 // Create a new setting for this interface, and add it to the list.
-                if ((newSettingInfo = (USB_INTERFACE_SETTING_INFO *)USB_MALLOC( sizeof(USB_INTERFACE_SETTING_INFO) )) == NULL)
+                if ((newSettingInfo = (USB_INTERFACE_SETTING_INFO *)_USB_AllocEnumerationMemory( sizeof(USB_INTERFACE_SETTING_INFO) )) == NULL)
                 {
                     // Out of memory
                     error = true;   
@@ -4910,7 +5774,7 @@ bool _USB_ParseConfigurationDescriptor( void )
 
                 // Skip over the rest of the Interface Descriptor
                 index += bLength;
-                ptr = &pCurrentConfigurationDescriptor[index];
+                ptr = &pCurrentDevice->pCurrentConfigurationDescriptor[index];
 
                 // Find the Endpoint Descriptors.  There might be Class and Vendor descriptors in here
                 currentEndpoint = 0;
@@ -4923,12 +5787,12 @@ bool _USB_ParseConfigurationDescriptor( void )
                     {
                         // Skip over the rest of the Descriptor
                         index += bLength;
-                        ptr = &pCurrentConfigurationDescriptor[index];
+                        ptr = &pCurrentDevice->pCurrentConfigurationDescriptor[index];
                     }
                     else
                     {
                         // Create an entry for the new endpoint.
-                        if ((newEndpointInfo = (USB_ENDPOINT_INFO *)USB_MALLOC( sizeof(USB_ENDPOINT_INFO) )) == NULL)
+                        if ((newEndpointInfo = (USB_ENDPOINT_INFO *)_USB_AllocEnumerationMemory( sizeof(USB_ENDPOINT_INFO) )) == NULL)
                         {
                             // Out of memory
                             error = true;   
@@ -4957,6 +5821,16 @@ bool _USB_ParseConfigurationDescriptor( void )
                             // Disable DTS
                             newEndpointInfo->status.bfUseDTS = 0;
                         }
+                        else if (newEndpointInfo->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_INTERRUPT)
+                        {
+                            // The periodic schedule works in power of 2 frame intervals.  Polling
+                            // more often than bInterval is allowed, so round down.
+                            if (newEndpointInfo->wInterval == 0) newEndpointInfo->wInterval = 1;
+                            while (newEndpointInfo->wInterval & (newEndpointInfo->wInterval - 1))
+                            {
+                                newEndpointInfo->wInterval &= newEndpointInfo->wInterval - 1;
+                            }
+                        }
 
                         // Initialize interval count
                         newEndpointInfo->wIntervalCount = newEndpointInfo->wInterval;
@@ -4972,7 +5846,7 @@ bool _USB_ParseConfigurationDescriptor( void )
                         // Get ready for the next endpoint.
                         currentEndpoint++;
                         index += bLength;
-                        ptr = &pCurrentConfigurationDescriptor[index];
+                        ptr = &pCurrentDevice->pCurrentConfigurationDescriptor[index];
                     }
                 }
             }    
@@ -5005,45 +5879,23 @@ bool _USB_ParseConfigurationDescriptor( void )
 
     if (error)
     {
-        // Destroy whatever list of interfaces, settings, and endpoints we created.
-        // The "new" variables point to the current node we are trying to remove.
-        while (pTempInterfaceList != NULL)
-        {
-            newInterfaceInfo = pTempInterfaceList;
-            pTempInterfaceList = pTempInterfaceList->next;
-            
-            while (newInterfaceInfo->pInterfaceSettings != NULL)
-            {
-                newSettingInfo = newInterfaceInfo->pInterfaceSettings;
-                newInterfaceInfo->pInterfaceSettings = newInterfaceInfo->pInterfaceSettings->next;
-                
-                while (newSettingInfo->pEndpointList != NULL)
-                {
-                    newEndpointInfo = newSettingInfo->pEndpointList;
-                    newSettingInfo->pEndpointList = newSettingInfo->pEndpointList->next;
-                    
-                    USB_FREE_AND_CLEAR( newEndpointInfo );
-                }    
-    
-                USB_FREE_AND_CLEAR( newSettingInfo );
-            }
-    
-            USB_FREE_AND_CLEAR( newInterfaceInfo );
-        }    
+        // Drop whatever list of interfaces, settings, and endpoints we created.
+        pCurrentDevice->arena.top = pCurrentDevice->arena.configMark;
         return false;
     }
     else
     {    
         // Set configuration.
-        usbDeviceInfo.currentConfiguration      = currentConfiguration;
-        usbDeviceInfo.currentConfigurationPower = bMaxPower;
+        pCurrentDevice->currentConfiguration      = currentConfiguration;
+        pCurrentDevice->currentConfigurationPower = bMaxPower;
     
         // Success!
 #if defined (DEBUG_ENABLE)
         DEBUG_PutString( "HOST: Parse Descriptor success\r\n" );
 #endif
 
-        usbDeviceInfo.pInterfaceList = pTempInterfaceList;
+        pCurrentDevice->pInterfaceList = pTempInterfaceList;
+        _USB_BuildEndpointTable( pCurrentDevice );
         return true;
     }    
 }
@@ -5051,16 +5903,83 @@ bool _USB_ParseConfigurationDescriptor( void )
 
 /****************************************************************************
   Function:
-    void _USB_ResetDATA0( uint8_t endpoint )
+    void _USB_ReopenBulkPass( USB_ENDPOINT_INFO *pEndpoint )
+
+  Description:
+    This function starts a bulk transfer that was just posted in the
+    current frame, if the bus is idle.  A transfer posted after the bulk
+    pass of the frame is over would otherwise wait for the next SOF, so a
+    class driver that posts transfers back to back, such as the CDC
+    gathered send, would get at most one transfer per frame.
+
+  Precondition:
+    The transfer has been set up with _USB_InitRead() or _USB_InitWrite().
+
+  Parameters:
+    USB_ENDPOINT_INFO *pEndpoint  - The endpoint of the new transfer
+
+  Returns:
+    None
+
+  Remarks:
+    If a token is on the bus, the token done interrupt finds the new
+    transfer anyway.  The SIE holds a token that does not fit in the rest of
+    the frame until the next one.  An endpoint that was NAKed in this frame
+    is still not tried again until the next SOF.
+
+    This function runs in the main context, so it turns off the USB
+    interrupts in U1IE while it works on the bus state.  USBMaskInterrupts()
+    cannot be used: on most hosts it does nothing, since it is only defined
+    for USB_INTERRUPT.  The bulk pass may queue transfer events, which is
+    safe for the event queue because the ISR cannot run meanwhile.
+  ***************************************************************************/
+
+#if defined( USB_SUPPORT_BULK_TRANSFERS )
+void _USB_ReopenBulkPass( USB_ENDPOINT_INFO *pEndpoint )
+{
+    #if defined( __C30__ ) || defined __XC16__ || defined( USB_SIMULATOR )
+        uint16_t        interrupt_mask;
+    #elif defined( __PIC32MX__ )
+        uint32_t        interrupt_mask;
+    #else
+        #error Cannot save interrupt status
+    #endif
+
+    if (pEndpoint->bmAttributes.bfTransferType != USB_TRANSFER_TYPE_BULK)
+    {
+        return;
+    }
+
+    // Guard against USB interrupts
+    interrupt_mask = U1IE;
+    U1IE = 0;
+
+    if (usbBusInfo.flags.bfBulkTransfersDone && !usbBusInfo.flags.bfTokenAlreadyWritten)
+    {
+        usbBusInfo.flags.bfBulkTransfersDone    = 0;
+        _USB_StartBulkPass();
+        _USB_FindNextToken();
+    }
+
+    // Re-enable USB interrupts
+    U1IE = interrupt_mask;
+}
+#endif
+
+
+/****************************************************************************
+  Function:
+    void _USB_ResetDATA0( USB_DEVICE_INFO *pDevice, uint8_t endpoint )
 
   Description:
-    This function resets DATA0 for the specified endpoint.  If the
-    specified endpoint is 0, it resets DATA0 for all endpoints.
+    This function resets DATA0 for the specified endpoint of a device.  If
+    the specified endpoint is 0, it resets DATA0 for all endpoints.
 
   Precondition:
     None
 
   Parameters:
+    USB_DEVICE_INFO *pDevice    - The device.
     uint8_t endpoint   - Endpoint number to reset.
 
 
@@ -5071,7 +5990,7 @@ bool _USB_ParseConfigurationDescriptor( void )
     None
   ***************************************************************************/
 
-void _USB_ResetDATA0( uint8_t endpoint )
+void _USB_ResetDATA0( USB_DEVICE_INFO *pDevice, uint8_t endpoint )
 {
     USB_ENDPOINT_INFO   *pEndpoint;
 
@@ -5081,7 +6000,7 @@ void _USB_ResetDATA0( uint8_t endpoint )
         USB_INTERFACE_INFO          *pInterface;
         USB_INTERFACE_SETTING_INFO  *pSetting;
 
-        pInterface = usbDeviceInfo.pInterfaceList;
+        pInterface = pDevice->pInterfaceList;
         while (pInterface)
         {
             pSetting = pInterface->pInterfaceSettings;
@@ -5100,7 +6019,7 @@ void _USB_ResetDATA0( uint8_t endpoint )
     }
     else
     {
-        pEndpoint = _USB_FindEndpoint( endpoint );
+        pEndpoint = _USB_FindEndpoint( pDevice, endpoint );
         if (pEndpoint != NULL)
         {
             pEndpoint->status.bfNextDATA01 = 0;
@@ -5109,6 +6028,68 @@ void _USB_ResetDATA0( uint8_t endpoint )
 }
 
 
+/****************************************************************************
+  Function:
+    void _USB_QueueTransferEvent( USB_EVENT event, uint32_t dataCount,
+                        uint8_t *pUserData, uint8_t errorCode )
+
+  Description:
+    This function queues a transfer event on the current endpoint for
+    delivery by USBHostTasks().
+
+  Precondition:
+    Called from the USB interrupt, or with the USB interrupts off in U1IE,
+    with pCurrentEndpoint set.
+
+  Parameters:
+    USB_EVENT event     - EVENT_TRANSFER or EVENT_BUS_ERROR
+    uint32_t dataCount  - Number of bytes transferred
+    uint8_t *pUserData  - Transfer data
+    uint8_t errorCode   - Transfer error code
+
+  Returns:
+    None
+
+  Remarks:
+    If the queue is full, the event is dropped and counted in
+    usbEventQueue.overflows.  The entry is filled in before head is
+    advanced, so USBHostTasks() never sees a partial entry.
+  ***************************************************************************/
+
+#if defined( USB_ENABLE_TRANSFER_EVENT )
+void _USB_QueueTransferEvent( USB_EVENT event, uint32_t dataCount, uint8_t *pUserData, uint8_t errorCode )
+{
+    USB_EVENT_DATA  *data;
+    uint8_t         count;
+
+    count = _USB_EventQueueCount();
+    if (count >= USB_EVENT_QUEUE_DEPTH)
+    {
+        usbEventQueue.overflows ++;
+        return;
+    }
+
+    data = _USB_EventQueueEntry( usbEventQueue.head );
+    data->event = event;
+    data->deviceAddress                 = pCurrentEndpointDevice->deviceAddress;
+    data->TransferData.dataCount        = dataCount;
+    data->TransferData.pUserData        = pUserData;
+    data->TransferData.bErrorCode       = errorCode;
+    data->TransferData.bEndpointAddress = pCurrentEndpoint->bEndpointAddress;
+    data->TransferData.bmAttributes.val = pCurrentEndpoint->bmAttributes.val;
+    data->TransferData.clientDriver     = pCurrentEndpoint->clientDriver;
+
+    usbEventQueue.head++;
+
+    count++;
+    if (count > usbEventQueue.highWater)
+    {
+        usbEventQueue.highWater = count;
+    }
+}
+#endif
+
+
 /****************************************************************************
   Function:
     void _USB_SendToken( uint8_t endpoint, uint8_t tokenType )
@@ -5127,8 +6108,10 @@ void _USB_ResetDATA0( uint8_t endpoint )
     None
 
   Remarks:
-    If the device is low speed, the transfer must be set to low speed.  If
-    the endpoint is isochronous, handshaking must be disabled.
+    If the device is low speed, the transfer must be set to low speed.  A
+    low speed device behind a hub is reached at full speed with a preamble,
+    so only the address carries the low speed bit.  If the endpoint is
+    isochronous, handshaking must be disabled.
   ***************************************************************************/
 
 void _USB_SendToken( uint8_t endpoint, uint8_t tokenType )
@@ -5138,8 +6121,8 @@ void _USB_SendToken( uint8_t endpoint, uint8_t tokenType )
     // Disable retries, disable control transfers, enable Rx and Tx and handshaking.
     temp = 0x5D;
 
-    // Enable low speed transfer if the device is low speed.
-    if (usbDeviceInfo.flags.bfIsLowSpeed)
+    // Enable low speed transfer if the device is low speed and attached directly.
+    if (pCurrentEndpointDevice->flags.bfIsLowSpeed && (pCurrentEndpointDevice->hubAddress == 0))
     {
         temp |= 0x80;   // Set LSPD
     }
@@ -5158,7 +6141,7 @@ void _USB_SendToken( uint8_t endpoint, uint8_t tokenType )
 
     U1EP0 = temp;
 
-    U1ADDR = usbDeviceInfo.deviceAddressAndSpeed;
+    U1ADDR = pCurrentEndpointDevice->deviceAddressAndSpeed;
     U1TOK = (tokenType << 4) | (endpoint & 0x7F);
 
     // Lock out anyone from writing another token until this one has finished.
@@ -5203,7 +6186,7 @@ void _USB_SetBDT( uint8_t token )
         // Find the BDT we need to use.
         #if (USB_PING_PONG_MODE == USB_PING_PONG__FULL_PING_PONG)
             pBDT = BDT_IN;
-            if (usbDeviceInfo.flags.bfPingPongIn)
+            if (usbBusInfo.flags.bfPingPongIn)
             {
                 pBDT = BDT_IN_ODD;
             }
@@ -5213,7 +6196,7 @@ void _USB_SetBDT( uint8_t token )
 
         // Set up ping-pong for the next transfer
         #if (USB_PING_PONG_MODE == USB_PING_PONG__FULL_PING_PONG)
-            usbDeviceInfo.flags.bfPingPongIn = ~usbDeviceInfo.flags.bfPingPongIn;
+            usbBusInfo.flags.bfPingPongIn = ~usbBusInfo.flags.bfPingPongIn;
         #endif
     }
     else  // USB_TOKEN_OUT or USB_TOKEN_SETUP
@@ -5221,7 +6204,7 @@ void _USB_SetBDT( uint8_t token )
         // Find the BDT we need to use.
         #if (USB_PING_PONG_MODE == USB_PING_PONG__FULL_PING_PONG) || (USB_PING_PONG_MODE == USB_PING_PONG__EP0_OUT_ONLY)
             pBDT = BDT_OUT;
-            if (usbDeviceInfo.flags.bfPingPongOut)
+            if (usbBusInfo.flags.bfPingPongOut)
             {
                 pBDT = BDT_OUT_ODD;
             }
@@ -5231,7 +6214,7 @@ void _USB_SetBDT( uint8_t token )
 
         // Set up ping-pong for the next transfer
         #if (USB_PING_PONG_MODE == USB_PING_PONG__FULL_PING_PONG) || (USB_PING_PONG_MODE == USB_PING_PONG__EP0_OUT_ONLY)
-            usbDeviceInfo.flags.bfPingPongOut = ~usbDeviceInfo.flags.bfPingPongOut;
+            usbBusInfo.flags.bfPingPongOut = ~usbBusInfo.flags.bfPingPongOut;
         #endif
     }
 
@@ -5279,7 +6262,7 @@ void _USB_SetBDT( uint8_t token )
     // Load up the BDT address.
     if (token == USB_TOKEN_SETUP)
     {
-        #if defined(__C30__) || defined(__PIC32MX__) || defined __XC16__
+        #if defined(__C30__) || defined(__PIC32MX__) || defined __XC16__ || defined(USB_SIMULATOR)
             pBDT->ADR  = ConvertToPhysicalAddress(pCurrentEndpoint->pUserDataSETUP);
         #else
             #error Cannot set BDT address.
@@ -5305,6 +6288,15 @@ void _USB_SetBDT( uint8_t token )
             {
                 pBDT->ADR  = ConvertToPhysicalAddress((uint32_t)pCurrentEndpoint->pUserData + (uint32_t)pCurrentEndpoint->dataCount);
             }
+        #elif defined(USB_SIMULATOR)
+            if (pCurrentEndpoint->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_ISOCHRONOUS)
+            {
+                pBDT->ADR  = ConvertToPhysicalAddress(((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->buffers[((ISOCHRONOUS_DATA *)(pCurrentEndpoint->pUserData))->currentBufferUSB].pBuffer);
+            }
+            else
+            {
+                pBDT->ADR  = ConvertToPhysicalAddress((uint8_t *)pCurrentEndpoint->pUserData + pCurrentEndpoint->dataCount);
+            }
         #else
             #error Cannot set BDT address.
         #endif
@@ -5323,11 +6315,11 @@ void _USB_SetBDT( uint8_t token )
 
 /****************************************************************************
   Function:
-    bool _USB_TransferInProgress( void )
+    void _USB_StartBulkPass( void )
 
   Description:
-    This function checks to see if any read or write transfers are in
-    progress.
+    This function starts a new pass over the bulk ready lists, so every
+    bulk endpoint of every device can be serviced again.
 
   Precondition:
     None
@@ -5335,6 +6327,38 @@ void _USB_SetBDT( uint8_t token )
   Parameters:
     None - None
 
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+void _USB_StartBulkPass( void )
+{
+    uint8_t i;
+
+    for (i=0; i<USB_MAX_DEVICES; i++)
+    {
+        usbDeviceInfo[i].bulkServedMask = 0;
+    }
+}
+
+
+/****************************************************************************
+  Function:
+    bool _USB_TransferInProgress( USB_DEVICE_INFO *pDevice )
+
+  Description:
+    This function checks to see if any read or write transfers are in
+    progress on a device.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_DEVICE_INFO *pDevice    - The device.
+
   Returns:
     true    - At least one read or write transfer is occurring.
     false   - No read or write transfers are occurring.
@@ -5343,20 +6367,20 @@ void _USB_SetBDT( uint8_t token )
     None
   ***************************************************************************/
 
-bool _USB_TransferInProgress( void )
+bool _USB_TransferInProgress( USB_DEVICE_INFO *pDevice )
 {
     USB_ENDPOINT_INFO           *pEndpoint;
     USB_INTERFACE_INFO          *pInterface;
     USB_INTERFACE_SETTING_INFO  *pSetting;
 
     // Check EP0.
-    if (!usbDeviceInfo.pEndpoint0->status.bfTransferComplete)
+    if (!pDevice->pEndpoint0->status.bfTransferComplete)
     {
         return true;
     }
 
     // Check all of the other endpoints.
-    pInterface = usbDeviceInfo.pInterfaceList;
+    pInterface = pDevice->pInterfaceList;
     while (pInterface)
     {
         pSetting = pInterface->pInterfaceSettings;
@@ -5426,6 +6450,8 @@ void USB_HostInterruptHandler(void)
         IFS5 &= 0xFFBF;
     #elif defined( __PIC32MX__)
         IFS1CLR = _IFS1_USBIF_MASK;
+    #elif defined(USB_SIMULATOR)
+        // The simulated controller has no interrupt controller flag.
     #else
         #error Cannot clear USB interrupt.
     #endif
@@ -5483,11 +6509,12 @@ void USB_HostInterruptHandler(void)
                             U1OTGIEbits.T1MSECIE = 0;
                         #endif
     
-                        if((usbHostState & STATE_MASK) != STATE_DETACHED)
+                        if((USB_ROOT_DEVICE->state & STATE_MASK) != STATE_DETACHED)
                         {
                             // Advance to the next state.  We can do this here, because the only time
-                            // we'll get a timer interrupt is while we are in one of the holding states.
-                            _USB_SetNextSubSubState();
+                            // we'll get a timer interrupt is while we are in one of the holding states
+                            // of the root port device.
+                            USB_ROOT_DEVICE->state = USB_ROOT_DEVICE->state + NEXT_SUBSUBSTATE;
                         }
                     }
                 }
@@ -5507,11 +6534,12 @@ void USB_HostInterruptHandler(void)
                         U1OTGIEbits.T1MSECIE = 0;
                     #endif
 
-                    if((usbHostState & STATE_MASK) != STATE_DETACHED)
+                    if((USB_ROOT_DEVICE->state & STATE_MASK) != STATE_DETACHED)
                     {
                         // Advance to the next state.  We can do this here, because the only time
-                        // we'll get a timer interrupt is while we are in one of the holding states.
-                        _USB_SetNextSubSubState();
+                        // we'll get a timer interrupt is while we are in one of the holding states
+                        // of the root port device.
+                        USB_ROOT_DEVICE->state = USB_ROOT_DEVICE->state + NEXT_SUBSUBSTATE;
                     }
                 }
             }
@@ -5533,7 +6561,7 @@ void USB_HostInterruptHandler(void)
         U1IEbits.ATTACHIE   = 0;
         U1IR                = USB_INTERRUPT_ATTACH;
 
-        if (usbHostState == (STATE_DETACHED | SUBSTATE_WAIT_FOR_DEVICE))
+        if (USB_ROOT_DEVICE->state == (STATE_DETACHED | SUBSTATE_WAIT_FOR_DEVICE))
         {
             usbOverrideHostState = STATE_ATTACHED;
         }
@@ -5646,7 +6674,7 @@ void USB_HostInterruptHandler(void)
     if ((U1IEbits.TRNIE && U1IRbits.TRNIF) &&
         (!(U1IEbits.UERRIE && U1IRbits.UERRIF) || (pCurrentEndpoint->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_ISOCHRONOUS)))
     {
-        #if defined(__C30__) || defined __XC16__
+        #if defined(__C30__) || defined __XC16__ || defined(USB_SIMULATOR)
             U1STATBITS          copyU1STATbits;
         #elif defined(__PIC32MX__)
             __U1STATbits_t      copyU1STATbits;
@@ -5912,8 +6940,11 @@ void USB_HostInterruptHandler(void)
 
     if (U1IEbits.SOFIE && U1IRbits.SOFIF)
     {
+        USB_DEVICE_INFO             *pDevice;
         USB_ENDPOINT_INFO           *pEndpoint;
-        USB_INTERFACE_INFO          *pInterface;
+        uint32_t                    pending;
+        uint8_t                     i;
+        uint8_t                     j;
 
         #if defined(USB_ENABLE_SOF_EVENT) && defined(USB_HOST_APP_DATA_EVENT_HANDLER)
             //Notify ping all client drivers of SOF event (address, event, data, sizeof_data)
@@ -5922,41 +6953,52 @@ void USB_HostInterruptHandler(void)
 
         U1IR = USB_INTERRUPT_SOF; // Clear the interrupt by writing a '1' to the flag.
 
-        pInterface = usbDeviceInfo.pInterfaceList;
-        while (pInterface)
+        usbBusInfo.frameNumber++;
+
+        for (j=0; j<USB_MAX_DEVICES; j++)
         {
-            if (pInterface->pCurrentSetting)
+            if (!_USB_DeviceInUse( j ))
             {
-                pEndpoint = pInterface->pCurrentSetting->pEndpointList;
-                while (pEndpoint)
+                continue;
+            }
+            pDevice = &usbDeviceInfo[j];
+
+            // Open the frame slot of the queued interrupt and isochronous
+            // endpoints that are scheduled in this frame.  wIntervalCount stays 0
+            // until the endpoint has been serviced.
+            pending = pDevice->readyEndpoints[USB_TRANSFER_TYPE_INTERRUPT] |
+                      pDevice->readyEndpoints[USB_TRANSFER_TYPE_ISOCHRONOUS];
+            for (i=0; pending != 0; i++, pending >>= 1)
+            {
+                if (pending & 1)
                 {
-                    // Decrement the interval count of all active interrupt and isochronous endpoints.
-                    if ((pEndpoint->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_INTERRUPT) ||
-                        (pEndpoint->bmAttributes.bfTransferType == USB_TRANSFER_TYPE_ISOCHRONOUS))
+                    pEndpoint = pDevice->pEndpointTable[i];
+                    if ((pEndpoint != NULL) &&
+                        ((((uint16_t)(usbBusInfo.frameNumber - pEndpoint->schedulePhase)) & (pEndpoint->wInterval - 1)) == 0))
                     {
-                        if (pEndpoint->wIntervalCount != 0)
-                        {
-                            pEndpoint->wIntervalCount--;
-                        }
+                        pEndpoint->wIntervalCount = 0;
                     }
-    
-                    #ifndef ALLOW_MULTIPLE_NAKS_PER_FRAME
-                        pEndpoint->status.bfLastTransferNAKd = 0;
-                    #endif
-    
-                    pEndpoint = pEndpoint->next;
                 }
             }
-            
-            pInterface = pInterface->next;
+
+            #ifndef ALLOW_MULTIPLE_NAKS_PER_FRAME
+                pending = pDevice->readyEndpoints[USB_TRANSFER_TYPE_BULK];
+                for (i=0; pending != 0; i++, pending >>= 1)
+                {
+                    if ((pending & 1) && (pDevice->pEndpointTable[i] != NULL))
+                    {
+                        pDevice->pEndpointTable[i]->status.bfLastTransferNAKd = 0;
+                    }
+                }
+            #endif
         }
+        _USB_StartBulkPass();
 
         usbBusInfo.flags.bfControlTransfersDone     = 0;
         usbBusInfo.flags.bfInterruptTransfersDone   = 0;
         usbBusInfo.flags.bfIsochronousTransfersDone = 0;
         usbBusInfo.flags.bfBulkTransfersDone        = 0;
         //usbBusInfo.dBytesSentInFrame                = 0;
-        usbBusInfo.lastBulkTransaction              = 0;
 
         _USB_FindNextToken();
     }
@@ -98,6 +98,15 @@ typedef enum
 
 } ANDROID_DEVICE_STATUS;
 
+//A HID report waiting in the queue of a device
+typedef struct
+{
+    uint8_t id;
+    uint8_t length;
+    bool    absolute;                               //A newer report with the same id replaces it
+    uint8_t report[ANDROID_HID_MAX_REPORT_SIZE];
+} ANDROID_HID_EVENT;
+
 typedef struct
 {
     uint8_t address;
@@ -126,6 +135,15 @@ typedef struct
         uint8_t  HIDEventSent      :1;
     } hid;
 
+    //Reports waiting to be sent.  The oldest one, at head, is the one being
+    //  sent while hid.HIDEventSent is set.
+    struct
+    {
+        ANDROID_HID_EVENT events[ANDROID_HID_EVENT_QUEUE_SIZE];
+        uint8_t head;
+        uint8_t count;
+    } hidQueue;
+
 } ANDROID_DEVICE_DATA;
 
 //************************************************************
@@ -142,6 +160,8 @@ static uint8_t AndroidCommandSendString(void *handle, ANDROID_ACCESSORY_STRINGS
 static uint8_t AndroidCommandStart(void *handle);
 static bool AndroidIsLastCommandComplete(uint8_t address, uint8_t *errorCode, uint32_t *uint8_tCount);
 static uint8_t AndroidCommandGetProtocol(ANDROID_DEVICE_DATA* device, uint16_t *protocol);
+static uint8_t AndroidHIDQueueEvent(uint8_t address, uint8_t id, uint8_t* report, uint8_t length, bool absolute);
+static void AndroidHIDSendNextEvent(ANDROID_DEVICE_DATA* device);
 //************************************************************
 // Internal macro helper functions
 //************************************************************
@@ -772,6 +792,11 @@ void AndroidTasks(void)
                 break; 
              
             case READY:
+                //Start any HID reports that were queued while EP0 was in use.
+                if((device->hidQueue.count != 0) && (device->hid.HIDEventSent == 0) && (device->status.EP0TransferPending == 0))
+                {
+                    AndroidHIDSendNextEvent(device);
+                }
                 break;
 
             case REGISTERING_HID:
@@ -1165,6 +1190,16 @@ bool AndroidAppEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
                 if(device->hid.HIDEventSent == 1)
                 {
                     device->hid.HIDEventSent = 0;
+                    device->hidQueue.head = (device->hidQueue.head + 1) % ANDROID_HID_EVENT_QUEUE_SIZE;
+                    device->hidQueue.count--;
+
+                    //Start the next report before telling the application,
+                    //  so the reports go out back to back.
+                    if(device->state == READY)
+                    {
+                        AndroidHIDSendNextEvent(device);
+                    }
+
                     USB_HOST_APP_EVENT_HANDLER(device->address, EVENT_ANDROID_HID_SEND_EVENT_COMPLETE, device, sizeof(ANDROID_DEVICE_DATA*));
                 }
             }
@@ -1183,6 +1218,29 @@ bool AndroidAppEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
             return true;
 
         case EVENT_BUS_ERROR:            // BUS error has occurred
+            for(i=0;i<NUM_ANDROID_DEVICES_SUPPORTED;i++)
+            {
+                if(devices[i].address == address)
+                {
+                    device = &devices[i];
+                }
+            }
+
+            //If a HID report failed, drop it so the ones behind it are not
+            //  stuck in the queue.
+            if((device != NULL) && (transfer_data != NULL) && (transfer_data->bEndpointAddress == 0x00) &&
+               (device->hid.HIDEventSent == 1))
+            {
+                device->status.EP0TransferPending = 0;
+                device->hid.HIDEventSent = 0;
+                device->hidQueue.head = (device->hidQueue.head + 1) % ANDROID_HID_EVENT_QUEUE_SIZE;
+                device->hidQueue.count--;
+
+                if(device->state == READY)
+                {
+                    AndroidHIDSendNextEvent(device);
+                }
+            }
             return true;
 
         default:
@@ -1193,57 +1251,12 @@ bool AndroidAppEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
 
 uint8_t AndroidAppHIDSendEvent(uint8_t address, uint8_t id, uint8_t* report, uint8_t length)
 {
-    ANDROID_DEVICE_DATA* device = NULL;
-    uint8_t errorCode = USB_ENDPOINT_BUSY;
-    uint32_t uint8_tCount;
-    uint8_t i;
-
-    for(i=0;i<NUM_ANDROID_DEVICES_SUPPORTED;i++)
-    {
-        if(devices[i].address == address)
-        {
-            device = &devices[i];
-            break;
-        }
-    }
-
-    if(device == NULL)
-    {
-        return USB_UNKNOWN_DEVICE;
-    }
-    
-    if(device->status.EP0TransferPending == 0)
-    {
-        //MCHP: should switch this to use the transfer events instead.  It is safer.
-        if(AndroidIsLastCommandComplete(device->address, &errorCode, &uint8_tCount) == true)
-        {
-            //Set the audio mode
-            errorCode = USBHostIssueDeviceRequest(  device->address,                    //uint8_t deviceAddress,
-                                        USB_SETUP_HOST_TO_DEVICE            //uint8_t bmRequestType,
-                                            | USB_SETUP_TYPE_VENDOR
-                                            | USB_SETUP_RECIPIENT_DEVICE,
-                                        ANDROID_ACCESSORY_SEND_HID_EVENT,   //uint8_t bRequest,
-                                        id,                                  //uint16_t wValue,
-                                        0,                                  //uint16_t wIndex,
-                                        length,                                  //uint16_t wLength,
-                                        report,                               //uint8_t *data,
-                                        USB_DEVICE_REQUEST_SET,             //uint8_t dataDirection,
-                                        device->clientDriverID              //uint8_t clientDriverID
-                                     );
-
-            if(errorCode == USB_SUCCESS)
-            {
-                device->hid.id = id;
-                device->hid.length = length;
-                device->hid.data = report;
-                device->hid.HIDEventSent = 1;
-
-                device->status.EP0TransferPending = 1;
-            }
-        }
-    }
+    return AndroidHIDQueueEvent(address, id, report, length, false);
+}
 
-    return errorCode; 
+uint8_t AndroidAppHIDSendState(uint8_t address, uint8_t id, uint8_t* report, uint8_t length)
+{
+    return AndroidHIDQueueEvent(address, id, report, length, true);
 }
 
 bool AndroidAppHIDRegister(uint8_t address, uint8_t id, uint8_t* descriptor, uint8_t length)
@@ -1416,6 +1429,168 @@ static bool AndroidIsLastCommandComplete(uint8_t address, uint8_t *errorCode, ui
                                     );
 }
 
+/****************************************************************************
+  Function:
+    static uint8_t AndroidHIDQueueEvent(uint8_t address, uint8_t id, uint8_t* report, uint8_t length, bool absolute)
+
+  Summary:
+    Queues a HID report for the specified Android device.
+
+  Description:
+    Copies a HID report into the HID queue of the device, and starts sending
+    it if nothing else is using EP0.  If absolute is true, the report is the
+    whole state of the HID device, so it replaces an absolute report with the
+    same id at the tail of the queue that has not been started yet, instead
+    of taking a new entry.  Only the tail is replaced, so the reports still
+    reach the device in the order they were queued.
+
+  Precondition:
+    AndroidAppStart() function has been called before the first calling of this function
+
+  Parameters:
+    uint8_t address - address of the device to send the report to
+    uint8_t id - Report ID of the report
+    uint8_t* report - data for the report
+    uint8_t length - length of the report
+    bool absolute - true if a newer report with the same id replaces this one
+
+  Return Values:
+    USB_SUCCESS - the report was queued
+    USB_UNKNOWN_DEVICE - no Android device with that address
+    USB_INVALID_STATE - the device is not ready yet
+    USB_ILLEGAL_REQUEST - the report is longer than ANDROID_HID_MAX_REPORT_SIZE
+    USB_ENDPOINT_BUSY - the queue is full
+
+  Remarks:
+    Internal API only.  Should not be called by a user.
+  ***************************************************************************/
+static uint8_t AndroidHIDQueueEvent(uint8_t address, uint8_t id, uint8_t* report, uint8_t length, bool absolute)
+{
+    ANDROID_DEVICE_DATA* device = NULL;
+    ANDROID_HID_EVENT* event;
+    uint8_t i;
+    uint8_t index;
+
+    for(i=0;i<NUM_ANDROID_DEVICES_SUPPORTED;i++)
+    {
+        if(devices[i].address == address)
+        {
+            device = &devices[i];
+            break;
+        }
+    }
+
+    if(device == NULL)
+    {
+        return USB_UNKNOWN_DEVICE;
+    }
+
+    if(device->state < READY)
+    {
+        return USB_INVALID_STATE;
+    }
+
+    if(length > ANDROID_HID_MAX_REPORT_SIZE)
+    {
+        return USB_ILLEGAL_REQUEST;
+    }
+
+    event = NULL;
+
+    if((absolute == true) && (device->hidQueue.count > device->hid.HIDEventSent))
+    {
+        //Replace the last report if it has the same id and is still waiting.
+        //  The one at head may already be on the bus, so it is never
+        //  replaced, and an earlier one is not either, since the new state
+        //  would then overtake the reports queued after it.
+        index = (device->hidQueue.head + device->hidQueue.count - 1) % ANDROID_HID_EVENT_QUEUE_SIZE;
+        if((device->hidQueue.events[index].id == id) && (device->hidQueue.events[index].absolute == true))
+        {
+            event = &device->hidQueue.events[index];
+        }
+    }
+
+    if(event == NULL)
+    {
+        if(device->hidQueue.count == ANDROID_HID_EVENT_QUEUE_SIZE)
+        {
+            return USB_ENDPOINT_BUSY;
+        }
+
+        index = (device->hidQueue.head + device->hidQueue.count) % ANDROID_HID_EVENT_QUEUE_SIZE;
+        event = &device->hidQueue.events[index];
+        device->hidQueue.count++;
+    }
+
+    event->id = id;
+    event->length = length;
+    event->absolute = absolute;
+    memcpy(event->report, report, length);
+
+    if((device->state == READY) && (device->hid.HIDEventSent == 0) && (device->status.EP0TransferPending == 0))
+    {
+        AndroidHIDSendNextEvent(device);
+    }
+
+    return USB_SUCCESS;
+}
+
+/****************************************************************************
+  Function:
+    static void AndroidHIDSendNextEvent(ANDROID_DEVICE_DATA* device)
+
+  Summary:
+    Starts sending the oldest report in the HID queue of a device.
+
+  Description:
+    Starts sending the oldest report in the HID queue of a device.  If EP0
+    cannot take the request now, the report stays in the queue and is
+    started again from AndroidTasks().
+
+  Precondition:
+    EP0 is not in use by this driver.
+
+  Parameters:
+    ANDROID_DEVICE_DATA* device - the device to send to
+
+  Return Values:
+    None
+
+  Remarks:
+    Internal API only.  Should not be called by a user.
+  ***************************************************************************/
+static void AndroidHIDSendNextEvent(ANDROID_DEVICE_DATA* device)
+{
+    ANDROID_HID_EVENT* event;
+    uint8_t errorCode;
+
+    if(device->hidQueue.count == 0)
+    {
+        return;
+    }
+
+    event = &device->hidQueue.events[device->hidQueue.head];
+
+    errorCode = USBHostIssueDeviceRequest(  device->address,                    //uint8_t deviceAddress,
+                                USB_SETUP_HOST_TO_DEVICE            //uint8_t bmRequestType,
+                                    | USB_SETUP_TYPE_VENDOR
+                                    | USB_SETUP_RECIPIENT_DEVICE,
+                                ANDROID_ACCESSORY_SEND_HID_EVENT,   //uint8_t bRequest,
+                                event->id,                          //uint16_t wValue,
+                                0,                                  //uint16_t wIndex,
+                                event->length,                      //uint16_t wLength,
+                                event->report,                      //uint8_t *data,
+                                USB_DEVICE_REQUEST_SET,             //uint8_t dataDirection,
+                                device->clientDriverID              //uint8_t clientDriverID
+                             );
+
+    if(errorCode == USB_SUCCESS)
+    {
+        device->hid.HIDEventSent = 1;
+        device->status.EP0TransferPending = 1;
+    }
+}
+
 /****************************************************************************
   Function:
     uint8_t AndroidCommandGetProtocol(ANDROID_DEVICE_DATA* device, uint16_t *protocol)
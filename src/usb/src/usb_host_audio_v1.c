@@ -94,6 +94,22 @@ Currently this must be set to 1, due to limitations in the USB Host layer.
     #define USB_MAX_AUDIO_DEVICES        1
 #endif
 
+// *****************************************************************************
+/* Rate Matching
+
+If USB_AUDIO_RATE_MATCHING is defined, USBHostAudioV1ReadSamples() takes the
+received samples out of the isochronous data buffers and resamples them from
+the rate the device's clock actually runs at to the nominal sampling
+frequency, so that an application consuming samples at the nominal rate
+neither fills nor drains the buffers over a long stream.  The samples must
+be 16 bits, with up to USB_AUDIO_MAX_CHANNELS channels.
+*/
+#if defined( USB_AUDIO_RATE_MATCHING )
+    #ifndef USB_AUDIO_MAX_CHANNELS
+        #define USB_AUDIO_MAX_CHANNELS   2
+    #endif
+#endif
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Constants
@@ -134,6 +150,14 @@ Currently this must be set to 1, due to limitations in the USB Host layer.
 #define USB_AUDIO_FORMAT_TYPE_II                    0x02
 #define USB_AUDIO_FORMAT_TYPE_III                   0x03
 
+// *****************************************************************************
+// Section: Rate Matching Constants
+// *****************************************************************************
+
+#define USB_AUDIO_RATE_WINDOW                       1000        // Packets per rate measurement.  With one packet per frame, the count is the rate in Hz.
+#define USB_AUDIO_RATE_AVERAGE                      4           // Measurements averaged into the rate.
+#define USB_AUDIO_STEP_ONE                          0x01000000ul // 1.0 in the 8.24 fixed point of step and phase.
+
 // *****************************************************************************
 // Section: Device Request Constants
 // *****************************************************************************
@@ -197,6 +221,19 @@ typedef struct _USB_AUDIO_DEVICE_INFO
     uint8_t                                settingZeroBandwidth;   // The zero bandwidth alternate setting.
     uint8_t                                settingFullBandwidth;   // The full bandwidth alternate setting.
     uint8_t                                endpointAudioStream;    // Streaming audio endpoint.
+    #if defined( USB_AUDIO_RATE_MATCHING )
+    ISOCHRONOUS_DATA                    *pIsochronousData;      // Buffers of the current stream.
+    uint32_t                            nominalRate;            // Sampling frequency, Hz.
+    uint32_t                            measuredRate;           // Device rate by the host frame clock, 1/256 Hz.
+    uint32_t                            windowSamples;          // Samples counted in the current measurement.
+    uint16_t                            windowPackets;          // Packets counted in the current measurement.
+    uint16_t                            windows;                // Measurements completed.
+    uint32_t                            step;                   // Input samples per output sample, 8.24 fixed point.
+    uint32_t                            phase;                  // Output position after history[0], 8.24 fixed point.
+    uint16_t                            packetOffset;           // Bytes already taken from the packet at currentBufferUser.
+    uint8_t                             historyCount;           // Input samples in history.
+    int16_t                             history[2][USB_AUDIO_MAX_CHANNELS]; // The input samples on either side of the output position.
+    #endif
 } USB_AUDIO_DEVICE_INFO;
 
 
@@ -207,6 +244,10 @@ typedef struct _USB_AUDIO_DEVICE_INFO
 //******************************************************************************
 //******************************************************************************
 
+#if defined( USB_AUDIO_RATE_MATCHING )
+bool _USBHostAudioV1_NextInput( uint8_t i, uint8_t channels );
+void _USBHostAudioV1_MeasureRate( uint8_t i, uint16_t samples );
+#endif
 
 
 //******************************************************************************
@@ -266,6 +307,15 @@ static USB_AUDIO_DEVICE_INFO         deviceInfoAudioV1[USB_MAX_AUDIO_DEVICES] __
     Some devices require other operations between setting the full bandwidth
     interface and starting the streaming audio data.  Therefore, these two 
     functions are broken out separately.
+
+    Received packets are passed to the application's data event handler as
+    EVENT_AUDIO_STREAM_RECEIVED.  If it does not handle them (returns false,
+    or USB_HOST_APP_DATA_EVENT_HANDLER is not defined), they stay in the
+    buffers of pIsochronousData until the application takes them with
+    USBHostIsochronousBufferGet() and USBHostIsochronousBufferRelease().
+    Use enough buffers to cover the longest time the application may not
+    get to them; packets that arrive while all buffers are held are counted
+    in pIsochronousData->overruns.
   ***************************************************************************/
 
 uint8_t USBHostAudioV1ReceiveAudioData( uint8_t deviceAddress,
@@ -296,6 +346,22 @@ uint8_t USBHostAudioV1ReceiveAudioData( uint8_t deviceAddress,
     if (errorCode)
     {
     }
+    #if defined( USB_AUDIO_RATE_MATCHING )
+    else
+    {
+        // Start the rate measurement and the resampler over.  Until the
+        // first measurement is done, assume the device runs at the nominal rate.
+        deviceInfoAudioV1[i].pIsochronousData   = pIsochronousData;
+        deviceInfoAudioV1[i].measuredRate       = deviceInfoAudioV1[i].nominalRate << 8;
+        deviceInfoAudioV1[i].windowSamples      = 0;
+        deviceInfoAudioV1[i].windowPackets      = 0;
+        deviceInfoAudioV1[i].windows            = 0;
+        deviceInfoAudioV1[i].step               = USB_AUDIO_STEP_ONE;
+        deviceInfoAudioV1[i].phase              = 0;
+        deviceInfoAudioV1[i].packetOffset       = 0;
+        deviceInfoAudioV1[i].historyCount       = 0;
+    }
+    #endif
     
     return errorCode;    
 }
@@ -555,6 +621,10 @@ uint8_t USBHostAudioV1SetSamplingFrequency( uint8_t deviceAddress, uint8_t *freq
     {
         // Set a flag so we will send back the correct event when the request is done.
         deviceInfoAudioV1[i].flags.bfSettingFrequency   = 1;
+
+        #if defined( USB_AUDIO_RATE_MATCHING )
+            deviceInfoAudioV1[i].nominalRate = (uint32_t)frequency[0] | ((uint32_t)frequency[1] << 8) | ((uint32_t)frequency[2] << 16);
+        #endif
     }
     
     return errorCode;
@@ -651,11 +721,8 @@ uint8_t * USBHostAudioV1SupportedFrequencies( uint8_t deviceAddress )
         return NULL;
     }
 
-    #if defined( __PIC32MX__)
-        return (uint8_t *)((UINT32)deviceInfoAudioV1[i].pFormatTypeDescriptor + (UINT32)7);
-    #else
-        return (uint8_t *)((uint16_t)deviceInfoAudioV1[i].pFormatTypeDescriptor + (uint16_t)7);
-    #endif
+    // bSamFreqType, followed by the frequencies.
+    return &deviceInfoAudioV1[i].pFormatTypeDescriptor[7];
 }
 
 
@@ -707,6 +774,143 @@ void USBHostAudioV1TerminateTransfer( uint8_t deviceAddress )
     return;
 }
 
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostAudioV1ReadSamples( uint8_t deviceAddress, int16_t *samples,
+        uint16_t count )
+
+  Summary:
+    This function reads received audio at the nominal sampling frequency.
+
+  Description:
+    This function takes received audio out of the isochronous data buffers
+    of the current stream and resamples it from the rate the device's clock
+    actually runs at to the nominal sampling frequency.  The device rate is
+    measured against the host's frame clock by counting the samples in each
+    USB_AUDIO_RATE_WINDOW packets, and the samples are interpolated between
+    the received samples on either side of each output sample.
+
+  Precondition:
+    USBHostAudioV1ReceiveAudioData() has started the stream, and the
+    received packets are not taken by the application's data event handler.
+
+  Parameters:
+    uint8_t deviceAddress  - Device address
+    int16_t *samples    - Buffer for count samples of each channel,
+                            interleaved as they are received
+    uint16_t count      - Number of samples per channel to read
+
+  Returns:
+    The number of samples per channel read.  This is less than count if
+    the buffers ran out of received data, or 0 if the format is not 16 bit
+    PCM with up to USB_AUDIO_MAX_CHANNELS channels.
+
+  Remarks:
+    Only available if USB_AUDIO_RATE_MATCHING is defined.  The nominal rate
+    is the frequency last set with USBHostAudioV1SetSamplingFrequency(), or
+    the first one the device supports.  Do not also take buffers with
+    USBHostIsochronousBufferGet() while using this function.
+  ***************************************************************************/
+
+#if defined( USB_AUDIO_RATE_MATCHING )
+uint16_t USBHostAudioV1ReadSamples( uint8_t deviceAddress, int16_t *samples, uint16_t count )
+{
+    uint8_t     c;
+    uint8_t     channels;
+    int32_t     fraction;
+    uint8_t     i;
+    uint16_t    n;
+
+    // Find the correct device.
+    for (i=0; (i<USB_MAX_AUDIO_DEVICES) && (deviceInfoAudioV1[i].ID.deviceAddress != deviceAddress); i++);
+    if ((i == USB_MAX_AUDIO_DEVICES) || (deviceInfoAudioV1[i].pIsochronousData == NULL))
+    {
+        return 0;
+    }
+
+    // Only 16 bit samples are supported.
+    channels = deviceInfoAudioV1[i].pFormatTypeDescriptor[4];
+    if ((deviceInfoAudioV1[i].pFormatTypeDescriptor[5] != 2) || (channels == 0) || (channels > USB_AUDIO_MAX_CHANNELS))
+    {
+        return 0;
+    }
+
+    for (n = 0; n < count; n++)
+    {
+        // Take input samples until the output position lies between the two
+        // in the history.
+        while ((deviceInfoAudioV1[i].historyCount < 2) || (deviceInfoAudioV1[i].phase >= USB_AUDIO_STEP_ONE))
+        {
+            if (!_USBHostAudioV1_NextInput( i, channels ))
+            {
+                return n;
+            }
+        }
+
+        // Interpolate with 15 bits of the position, so that the product fits
+        // in 32 bits.
+        fraction = (int32_t)(deviceInfoAudioV1[i].phase >> 9);
+        for (c = 0; c < channels; c++)
+        {
+            *samples++ = (int16_t)(deviceInfoAudioV1[i].history[0][c] +
+                    ((((int32_t)deviceInfoAudioV1[i].history[1][c] - deviceInfoAudioV1[i].history[0][c]) * fraction) >> 15));
+        }
+        deviceInfoAudioV1[i].phase += deviceInfoAudioV1[i].step;
+    }
+    return n;
+}
+#endif
+
+
+/****************************************************************************
+  Function:
+    bool USBHostAudioV1GetRateInfo( uint8_t deviceAddress,
+        USB_AUDIO_V1_RATE_INFO *pInfo )
+
+  Summary:
+    This function returns the measured device sample rate.
+
+  Description:
+    This function returns the nominal sampling frequency, the rate the
+    device's clock actually runs at as measured against the host's frame
+    clock, and the resampling step USBHostAudioV1ReadSamples() uses.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress           - Device address
+    USB_AUDIO_V1_RATE_INFO *pInfo   - Returns the rate information
+
+  Return Values:
+    true    - The rate information was returned
+    false   - No device with the specified address
+
+  Remarks:
+    Only available if USB_AUDIO_RATE_MATCHING is defined.
+  ***************************************************************************/
+
+#if defined( USB_AUDIO_RATE_MATCHING )
+bool USBHostAudioV1GetRateInfo( uint8_t deviceAddress, USB_AUDIO_V1_RATE_INFO *pInfo )
+{
+    uint8_t     i;
+
+    // Find the correct device.
+    for (i=0; (i<USB_MAX_AUDIO_DEVICES) && (deviceInfoAudioV1[i].ID.deviceAddress != deviceAddress); i++);
+    if (i == USB_MAX_AUDIO_DEVICES)
+    {
+        return false;
+    }
+
+    pInfo->nominalRate  = deviceInfoAudioV1[i].nominalRate;
+    pInfo->measuredRate = deviceInfoAudioV1[i].measuredRate;
+    pInfo->step         = deviceInfoAudioV1[i].step;
+    pInfo->measurements = deviceInfoAudioV1[i].windows;
+    return true;
+}
+#endif
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Host Stack Interface Functions
@@ -895,6 +1099,19 @@ bool USBHostAudioV1Initialize( uint8_t address, uint32_t flags, uint8_t clientDr
                     deviceInfoAudioV1[device].ID.deviceAddress  = address;
                     deviceInfoAudioV1[device].ID.clientDriverID = clientDriverID;
 
+                    #if defined( USB_AUDIO_RATE_MATCHING )
+                        // Until the application sets one, the nominal rate is the
+                        // first discrete frequency, if there is one.
+                        deviceInfoAudioV1[device].pIsochronousData = NULL;
+                        deviceInfoAudioV1[device].nominalRate = 0;
+                        if (deviceInfoAudioV1[device].pFormatTypeDescriptor[7] != 0)
+                        {
+                            deviceInfoAudioV1[device].nominalRate = (uint32_t)deviceInfoAudioV1[device].pFormatTypeDescriptor[8] |
+                                    ((uint32_t)deviceInfoAudioV1[device].pFormatTypeDescriptor[9] << 8) |
+                                    ((uint32_t)deviceInfoAudioV1[device].pFormatTypeDescriptor[10] << 16);
+                        }
+                    #endif
+
                     // Tell the application layer that we have a device.
                     USB_HOST_APP_EVENT_HANDLER( deviceInfoAudioV1[device].ID.deviceAddress, EVENT_AUDIO_ATTACH, &(deviceInfoAudioV1[device].ID), sizeof(USB_AUDIO_V1_DEVICE_ID) );
 
@@ -964,6 +1181,9 @@ bool USBHostAudioV1EventHandler( uint8_t address, USB_EVENT event, void *data, u
                 deviceInfoAudioV1[i].flags.val              = 0;
                 deviceInfoAudioV1[i].endpointAudioStream    = 0;
                 deviceInfoAudioV1[i].pFormatTypeDescriptor  = NULL;
+                #if defined( USB_AUDIO_RATE_MATCHING )
+                    deviceInfoAudioV1[i].pIsochronousData   = NULL;
+                #endif
             }
             return true;
             break;
@@ -1000,7 +1220,7 @@ bool USBHostAudioV1EventHandler( uint8_t address, USB_EVENT event, void *data, u
             {
                 // If we received streaming audio data, pass the event up to the application.
                 // It's only one more byte of information more than they need (bmAttributes).
-                USB_HOST_APP_EVENT_HANDLER( i, EVENT_AUDIO_RECEIVE_STREAM, data, size );
+                USB_HOST_APP_EVENT_HANDLER( i, EVENT_AUDIO_STREAM_RECEIVED, data, size );
             }    
             #endif
             break;
@@ -1059,4 +1279,154 @@ bool USBHostAudioV1EventHandler( uint8_t address, USB_EVENT event, void *data, u
 // *****************************************************************************
 // *****************************************************************************
 
+/****************************************************************************
+  Function:
+    bool _USBHostAudioV1_NextInput( uint8_t i, uint8_t channels )
+
+  Description:
+    This function moves the next received sample of each channel into the
+    resampler history, taking it from the packet at currentBufferUser.  A
+    packet is counted for the rate measurement when it is first taken, and
+    released as soon as all of its samples have been taken.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t i           - Index into the device information table
+    uint8_t channels    - Number of channels
+
+  Return Values:
+    true    - The history holds a new input sample
+    false   - No received data is waiting
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+#if defined( USB_AUDIO_RATE_MATCHING )
+bool _USBHostAudioV1_NextInput( uint8_t i, uint8_t channels )
+{
+    ISOCHRONOUS_DATA_BUFFER    *pPacket;
+    uint8_t                    *pData;
+    uint8_t                     c;
+    uint8_t                     size;
+
+    size = channels * 2;
+    while ((pPacket = USBHostIsochronousBufferGet( deviceInfoAudioV1[i].pIsochronousData )) != NULL)
+    {
+        if (deviceInfoAudioV1[i].packetOffset == 0)
+        {
+            _USBHostAudioV1_MeasureRate( i, pPacket->dataLength / size );
+        }
+
+        if (deviceInfoAudioV1[i].packetOffset + size <= pPacket->dataLength)
+        {
+            pData = &pPacket->pBuffer[deviceInfoAudioV1[i].packetOffset];
+            for (c = 0; c < channels; c++)
+            {
+                deviceInfoAudioV1[i].history[0][c] = deviceInfoAudioV1[i].history[1][c];
+                deviceInfoAudioV1[i].history[1][c] = (int16_t)(pData[2*c] | (pData[2*c+1] << 8));
+            }
+
+            // Give the buffer back as soon as it is empty.
+            deviceInfoAudioV1[i].packetOffset += size;
+            if (deviceInfoAudioV1[i].packetOffset + size > pPacket->dataLength)
+            {
+                USBHostIsochronousBufferRelease( deviceInfoAudioV1[i].pIsochronousData );
+                deviceInfoAudioV1[i].packetOffset = 0;
+            }
+
+            if (deviceInfoAudioV1[i].historyCount < 2)
+            {
+                deviceInfoAudioV1[i].historyCount++;
+            }
+            else
+            {
+                deviceInfoAudioV1[i].phase -= USB_AUDIO_STEP_ONE;
+            }
+            return true;
+        }
+
+        // Empty packet.
+        USBHostIsochronousBufferRelease( deviceInfoAudioV1[i].pIsochronousData );
+        deviceInfoAudioV1[i].packetOffset = 0;
+    }
+    return false;
+}
+#endif
+
+
+/****************************************************************************
+  Function:
+    void _USBHostAudioV1_MeasureRate( uint8_t i, uint16_t samples )
+
+  Description:
+    This function counts the samples of one received packet towards the
+    measurement of the device rate.  The device sends one packet per frame,
+    so USB_AUDIO_RATE_WINDOW packets take USB_AUDIO_RATE_WINDOW ms by the
+    host's clock, whatever the device's clock does.  Each window updates the
+    measured rate, averaged over USB_AUDIO_RATE_AVERAGE windows to smooth
+    out the sample or two the count varies by, and the resampling step.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t i           - Index into the device information table
+    uint16_t samples    - Samples per channel in the packet
+
+  Returns:
+    None
+
+  Remarks:
+    Packets lost to overruns are not counted, so they do not affect the
+    measurement.
+  ***************************************************************************/
+
+#if defined( USB_AUDIO_RATE_MATCHING )
+void _USBHostAudioV1_MeasureRate( uint8_t i, uint16_t samples )
+{
+    uint32_t    nominal;
+    uint32_t    rate;
+    uint32_t    remainder;
+
+    deviceInfoAudioV1[i].windowSamples += samples;
+    if (++deviceInfoAudioV1[i].windowPackets < USB_AUDIO_RATE_WINDOW)
+    {
+        return;
+    }
+
+    // The samples in the window, in 1/256 Hz.
+    rate = deviceInfoAudioV1[i].windowSamples << 8;
+    if (deviceInfoAudioV1[i].windows == 0)
+    {
+        deviceInfoAudioV1[i].measuredRate = rate;
+    }
+    else
+    {
+        deviceInfoAudioV1[i].measuredRate += ((int32_t)(rate - deviceInfoAudioV1[i].measuredRate)) / USB_AUDIO_RATE_AVERAGE;
+    }
+    if (deviceInfoAudioV1[i].windows < 0xFFFF)
+    {
+        deviceInfoAudioV1[i].windows++;
+    }
+    deviceInfoAudioV1[i].windowSamples = 0;
+    deviceInfoAudioV1[i].windowPackets = 0;
+
+    // step = measuredRate / (nominalRate * 256) in 8.24 fixed point, divided
+    // in three parts so that nothing overflows 32 bits.
+    nominal = deviceInfoAudioV1[i].nominalRate;
+    if (nominal != 0)
+    {
+        rate        = deviceInfoAudioV1[i].measuredRate;
+        remainder   = (rate % nominal) << 8;
+        deviceInfoAudioV1[i].step = (rate / nominal) << 16;
+        deviceInfoAudioV1[i].step += (remainder / nominal) << 8;
+        remainder   = (remainder % nominal) << 8;
+        deviceInfoAudioV1[i].step += remainder / nominal;
+    }
+}
+#endif
+
 
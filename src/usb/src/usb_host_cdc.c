@@ -220,7 +220,18 @@ Currently this must be set to 1, due to limitations in the USB Host layer.
 //******************************************************************************
 //******************************************************************************
 void _USBHostCDC_ResetStateJump( uint8_t i );
+uint8_t _USBHostCDC_WriteChunk( uint8_t i );
+#if defined( USB_CDC_TX_QUEUE_DEPTH )
+void _USBHostCDC_NextSegment( uint8_t i );
+void _USBHostCDC_PackSegments( uint8_t i );
+#endif
 void USBHostCDC_Init_CDC_Buffers(void);
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+void _USBHostCDC_RxReset( uint8_t i );
+void _USBHostCDC_RxTransferDone( uint8_t i, uint8_t errorCode, uint32_t byteCount );
+void _USBHostCDC_RxService( uint8_t i );
+void _USBHostCDC_RxPost( uint8_t i );
+#endif
 
 //******************************************************************************
 //******************************************************************************
@@ -244,6 +255,15 @@ void USBHostCDC_Init_CDC_Buffers(void);
                                                     }
 #endif
 
+// True if a write on the data OUT endpoint has more data to send.
+#if defined( USB_CDC_TX_QUEUE_DEPTH )
+    #define _USBHostCDC_MoreToWrite()           ((deviceInfoCDC[i].endpointDATA != 0x00) &&                             \
+                                                 ((deviceInfoCDC[i].remainingBytes != 0) || (deviceInfoCDC[i].txCount != 0) || \
+                                                  (deviceInfoCDC[i].txPacketLength != 0)))
+#else
+    #define _USBHostCDC_MoreToWrite()           ((deviceInfoCDC[i].endpointDATA != 0x00) && (deviceInfoCDC[i].remainingBytes != 0))
+#endif
+
 
 //******************************************************************************
 //******************************************************************************
@@ -439,6 +459,52 @@ uint8_t    USBHostCDCDeviceStatus( uint8_t deviceAddress )
     }    
 }
     
+/*******************************************************************************
+  Function:
+    uint8_t USBHostCDCGetRxStats( uint8_t deviceAddress, USB_CDC_RX_STATS *stats )
+
+  Summary:
+    This function returns the continuous receive statistics of a device.
+
+  Description:
+    This function returns the number of bytes received, the high-water mark
+    of the receive ring, and the number of times reception paused because
+    the ring was full.
+
+  Preconditions:
+    None
+
+  Parameters:
+    uint8_t deviceAddress      - Device address
+    USB_CDC_RX_STATS *stats    - Filled in with the statistics
+
+  Return Values:
+    USB_SUCCESS                 - The statistics were returned
+    USB_CDC_DEVICE_NOT_FOUND    - No device with specified address
+
+  Remarks:
+    Only available if USB_CDC_RX_BUFFER_SIZE is defined.  If overruns keeps
+    increasing, the application does not read the data fast enough; call
+    USBHostCDCRxRead() more often or increase USB_CDC_RX_BUFFER_SIZE.
+*******************************************************************************/
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+uint8_t USBHostCDCGetRxStats( uint8_t deviceAddress, USB_CDC_RX_STATS *stats )
+{
+    uint8_t    i;
+
+    // Find the correct device.
+    for (i=0; (i<USB_MAX_CDC_DEVICES) && (deviceInfoCDC[i].deviceAddress != deviceAddress); i++);
+    if ((deviceAddress == 0) || (i == USB_MAX_CDC_DEVICES))
+    {
+        return USB_CDC_DEVICE_NOT_FOUND;
+    }
+
+    *stats      = deviceInfoCDC[i].rx.stats;
+    stats->size = USB_CDC_RX_BUFFER_SIZE;
+    return USB_SUCCESS;
+}
+#endif
+
 /*******************************************************************************
   Function:
     uint8_t USBHostCDCResetDevice( uint8_t deviceAddress )
@@ -504,6 +570,123 @@ uint8_t USBHostCDCResetDevice( uint8_t deviceAddress )
 }
 
 
+/*******************************************************************************
+  Function:
+    uint16_t USBHostCDCRxAvailable( uint8_t deviceAddress )
+
+  Summary:
+    This function returns the number of received bytes waiting to be read.
+
+  Description:
+    This function returns the number of bytes in the receive ring of the
+    device.  That many bytes can be taken with USBHostCDCRxRead() without
+    waiting.
+
+  Preconditions:
+    None
+
+  Parameters:
+    uint8_t deviceAddress      - Device address
+
+  Returns:
+    Number of bytes that can be read.  0 if the device is not found.
+
+  Remarks:
+    Only available if USB_CDC_RX_BUFFER_SIZE is defined.
+*******************************************************************************/
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+uint16_t USBHostCDCRxAvailable( uint8_t deviceAddress )
+{
+    uint8_t    i;
+
+    // Find the correct device.
+    for (i=0; (i<USB_MAX_CDC_DEVICES) && (deviceInfoCDC[i].deviceAddress != deviceAddress); i++);
+    if ((deviceAddress == 0) || (i == USB_MAX_CDC_DEVICES))
+    {
+        return 0;
+    }
+
+    return deviceInfoCDC[i].rx.count;
+}
+#endif
+
+
+/*******************************************************************************
+  Function:
+    uint16_t USBHostCDCRxRead( uint8_t deviceAddress, uint8_t *data, uint16_t size )
+
+  Summary:
+    This function takes received data from the receive ring.
+
+  Description:
+    This function copies up to size bytes from the receive ring of the
+    device into the application buffer, and returns at once.  If reception
+    was paused because the ring was full, it resumes.
+
+  Preconditions:
+    None
+
+  Parameters:
+    uint8_t deviceAddress      - Device address
+    uint8_t *data              - Pointer to the application buffer
+    uint16_t size              - Size of the application buffer
+
+  Returns:
+    Number of bytes copied.  0 if no data was waiting or the device is not
+    found.
+
+  Remarks:
+    Only available if USB_CDC_RX_BUFFER_SIZE is defined.
+*******************************************************************************/
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+uint16_t USBHostCDCRxRead( uint8_t deviceAddress, uint8_t *data, uint16_t size )
+{
+    USB_CDC_RX_BUFFER  *rx;
+    uint16_t            copied;
+    uint16_t            part;
+    uint8_t             i;
+
+    // Find the correct device.
+    for (i=0; (i<USB_MAX_CDC_DEVICES) && (deviceInfoCDC[i].deviceAddress != deviceAddress); i++);
+    if ((deviceAddress == 0) || (i == USB_MAX_CDC_DEVICES))
+    {
+        return 0;
+    }
+
+    rx = &deviceInfoCDC[i].rx;
+    if (size > rx->count)
+    {
+        size = rx->count;
+    }
+
+    // Copy in at most two pieces, up to the end of the ring and from its start.
+    for (copied = 0; copied < size; copied += part)
+    {
+        part = size - copied;
+        if (part > USB_CDC_RX_BUFFER_SIZE - rx->head)
+        {
+            part = USB_CDC_RX_BUFFER_SIZE - rx->head;
+        }
+        memcpy( &data[copied], &rx->ring[rx->head], part );
+        rx->head += part;
+        if (rx->head == USB_CDC_RX_BUFFER_SIZE)
+        {
+            rx->head = 0;
+        }
+        rx->count -= part;
+    }
+
+    // Move waiting packets into the freed space, and repost if reception
+    // had paused.
+    if (rx->paused)
+    {
+        _USBHostCDC_RxService( i );
+    }
+
+    return copied;
+}
+#endif
+
 /*******************************************************************************
   Function:
      void USBHostCDCTasks( void )
@@ -662,6 +845,18 @@ void USBHostCDCTasks( void )
                 break;
 
             case STATE_RUNNING:
+                #if defined( USB_CDC_RX_BUFFER_SIZE )
+                    // Keep the continuous receive going alongside any transfer.
+                    if (deviceInfoCDC[i].rx.posted &&
+                        USBHostTransferIsComplete( deviceInfoCDC[i].deviceAddress, deviceInfoCDC[i].dataInterface.endpointIN, &errorCode, &byteCount ))
+                    {
+                        _USBHostCDC_RxTransferDone( i, errorCode, byteCount );
+                    }
+                    else
+                    {
+                        _USBHostCDC_RxService( i );
+                    }
+                #endif
                 switch (deviceInfoCDC[i].state & SUBSTATE_MASK)
                 {
                     case SUBSTATE_WAITING_FOR_REQ:   
@@ -751,23 +946,8 @@ void USBHostCDCTasks( void )
                                                USB_DEVICE_REQUEST_SET , deviceInfoCDC[i].clientDriverID );
                               }
                               else
-                              {   // if transfer size is more than 64 Bytes, multiple transactions are used to transfer the data
-                                  if(deviceInfoCDC[i].remainingBytes > USB_CDC_MAX_PACKET_SIZE)
-                                  {
-                                    deviceInfoCDC[i].bytesTransferred = USB_CDC_MAX_PACKET_SIZE; // max transaction size is 64 bytes
-                                    deviceInfoCDC[i].remainingBytes -= USB_CDC_MAX_PACKET_SIZE;
-                                    errorCode = USBHostWrite( deviceInfoCDC[i].deviceAddress, deviceInfoCDC[i].endpointDATA,
-                                                    deviceInfoCDC[i].userData, deviceInfoCDC[i].bytesTransferred );
-                                    deviceInfoCDC[i].userData = deviceInfoCDC[i].userData + USB_CDC_MAX_PACKET_SIZE;
-                                  }
-                                  else
-                                  {
-                                    deviceInfoCDC[i].bytesTransferred = deviceInfoCDC[i].remainingBytes;
-                                    deviceInfoCDC[i].remainingBytes = 0;
-                                    errorCode = USBHostWrite( deviceInfoCDC[i].deviceAddress, deviceInfoCDC[i].endpointDATA,
-                                                    deviceInfoCDC[i].userData, deviceInfoCDC[i].bytesTransferred );
-                                  }
-
+                              {   // if transfer size is more than USB_CDC_MAX_PACKET_SIZE, multiple transactions are used to transfer the data
+                                  errorCode = _USBHostCDC_WriteChunk( i );
                               }
 
                               if (errorCode)
@@ -811,10 +991,14 @@ void USBHostCDCTasks( void )
                                 {
                                     USBHostClearEndpointErrors( deviceInfoCDC[i].deviceAddress, deviceInfoCDC[i].endpointDATA );
                                     // this is to check if there are any remaining data bytes to be transferred
-                                    if(deviceInfoCDC[i].remainingBytes != 0)
+                                    if(_USBHostCDC_MoreToWrite())
                                     {
-                                        // set up another OUT request
-                                        deviceInfoCDC[i].state = STATE_RUNNING | SUBSTATE_SEND_WRITE_REQ;
+                                        // post the next OUT request now, rather than on the next pass
+                                        if (_USBHostCDC_WriteChunk( i ))
+                                        {
+                                            // SUBSTATE_SEND_WRITE_REQ tries again and handles the error
+                                            deviceInfoCDC[i].state = STATE_RUNNING | SUBSTATE_SEND_WRITE_REQ;
+                                        }
                                     }
                                     else
                                     {
@@ -956,6 +1140,14 @@ uint8_t USBHostCDCTransfer( uint8_t deviceAddress,uint8_t request , uint8_t dire
         {
             return USB_CDC_DEVICE_BUSY;
         }
+
+    #if defined( USB_CDC_RX_BUFFER_SIZE )
+        // The driver keeps its own read posted on the data IN endpoint.
+        if (direction && (endpointDATA != 0x00) && (endpointDATA == deviceInfoCDC[i].dataInterface.endpointIN))
+        {
+            return USB_CDC_ILLEGAL_REQUEST;
+        }
+    #endif
      
     // Initialize the transfer information.
     deviceInfoCDC[i].bytesTransferred  = 0;
@@ -966,6 +1158,11 @@ uint8_t USBHostCDCTransfer( uint8_t deviceAddress,uint8_t request , uint8_t dire
     deviceInfoCDC[i].interface         = interfaceNum;
     deviceInfoCDC[i].endpointDATA      = endpointDATA;
     deviceInfoCDC[i].commRequest       = request;       // invalid entry if DATA transfer is requested
+    #if defined( USB_CDC_TX_QUEUE_DEPTH )
+        deviceInfoCDC[i].txCount       = 0;
+        deviceInfoCDC[i].txPacketLength = 0;
+        deviceInfoCDC[i].flags.bfSegment = 0;
+    #endif
     #ifdef DEBUG_MODE
         UART2PrintString( "Data EP: " );
         UART2PutHex( deviceInfoCDC[i].endpointDATA );
@@ -996,8 +1193,7 @@ uint8_t USBHostCDCTransfer( uint8_t deviceAddress,uint8_t request , uint8_t dire
                 }
                 else
                 {
-                    errorCode                   = USBHostWrite( deviceInfoCDC[i].deviceAddress, deviceInfoCDC[i].endpointDATA,
-                                                            deviceInfoCDC[i].userData, deviceInfoCDC[i].reportSize );
+                    errorCode                   = _USBHostCDC_WriteChunk( i );
                     deviceInfoCDC[i].state         = STATE_WRITE_REQ_WAIT;
                 }
             }
@@ -1029,6 +1225,132 @@ uint8_t USBHostCDCTransfer( uint8_t deviceAddress,uint8_t request , uint8_t dire
     #endif
     return USB_SUCCESS;
 }
+
+/*******************************************************************************
+  Function:
+    uint8_t USBHostCDCSendSegments( uint8_t deviceAddress,
+                        const USB_CDC_TX_SEGMENT *segments, uint8_t count )
+
+  Summary:
+    This function sends several application buffers as one stream.
+
+  Description:
+    This function adds the buffers to the send queue of the device.  If the
+    device is already sending on the data OUT endpoint, the buffers are sent
+    when the ones before them are done.  Otherwise the send is started.
+    Empty buffers are skipped.
+
+  Preconditions:
+    None
+
+  Parameters:
+    uint8_t deviceAddress              - Device address
+    const USB_CDC_TX_SEGMENT *segments - List of buffers to send
+    uint8_t count                      - Number of buffers in the list
+
+  Return Values:
+    USB_SUCCESS                 - The buffers were queued
+    USB_CDC_DEVICE_NOT_FOUND    - No device with specified address
+    USB_CDC_DEVICE_BUSY         - The device is busy with another transfer,
+                                  or there is no room for all of the buffers
+
+  Remarks:
+    None
+*******************************************************************************/
+#if defined( USB_CDC_TX_QUEUE_DEPTH )
+uint8_t USBHostCDCSendSegments( uint8_t deviceAddress, const USB_CDC_TX_SEGMENT *segments, uint8_t count )
+{
+    uint8_t    i;
+    uint8_t    tail;
+    bool       sending;
+    #ifdef USB_ENABLE_TRANSFER_EVENT
+    uint8_t    errorCode;
+    #endif
+
+    // Find the correct device.
+    for (i=0; (i<USB_MAX_CDC_DEVICES) && (deviceInfoCDC[i].deviceAddress != deviceAddress); i++);
+    if (i == USB_MAX_CDC_DEVICES)
+    {
+        return USB_CDC_DEVICE_NOT_FOUND;
+    }
+
+    // A write on the data OUT endpoint takes more buffers; otherwise the
+    // device must be ready for a new transfer.
+    #ifndef USB_ENABLE_TRANSFER_EVENT
+        sending = (deviceInfoCDC[i].state == (STATE_RUNNING | SUBSTATE_SEND_WRITE_REQ)) ||
+                  (deviceInfoCDC[i].state == (STATE_RUNNING | SUBSTATE_WRITE_REQ_WAIT));
+        if (!sending && (deviceInfoCDC[i].state != (STATE_RUNNING | SUBSTATE_WAITING_FOR_REQ)))
+    #else
+        sending = (deviceInfoCDC[i].state == STATE_WRITE_REQ_WAIT);
+        if (!sending && (deviceInfoCDC[i].state != STATE_RUNNING))
+    #endif
+        {
+            return USB_CDC_DEVICE_BUSY;
+        }
+    if (sending && ((deviceInfoCDC[i].endpointDATA == 0x00) ||
+                    (deviceInfoCDC[i].endpointDATA != deviceInfoCDC[i].dataInterface.endpointOUT)))
+    {
+        return USB_CDC_DEVICE_BUSY;
+    }
+    if (!sending)
+    {
+        deviceInfoCDC[i].txHead         = 0;
+        deviceInfoCDC[i].txCount        = 0;
+        deviceInfoCDC[i].txPacketLength = 0;
+    }
+    if (count > (USB_CDC_TX_QUEUE_DEPTH - deviceInfoCDC[i].txCount))
+    {
+        return USB_CDC_DEVICE_BUSY;
+    }
+
+    // Only the list is copied, not the data.
+    tail = (uint8_t)((deviceInfoCDC[i].txHead + deviceInfoCDC[i].txCount) % USB_CDC_TX_QUEUE_DEPTH);
+    for ( ; count != 0; count--, segments++)
+    {
+        if (segments->length != 0)
+        {
+            deviceInfoCDC[i].txQueue[tail] = *segments;
+            if (++tail == USB_CDC_TX_QUEUE_DEPTH)
+            {
+                tail = 0;
+            }
+            deviceInfoCDC[i].txCount++;
+        }
+    }
+    if (sending || (deviceInfoCDC[i].txCount == 0))
+    {
+        return USB_SUCCESS;
+    }
+
+    // Initialize the transfer information.
+    deviceInfoCDC[i].bytesTransferred  = 0;
+    deviceInfoCDC[i].errorCode         = USB_SUCCESS;
+    deviceInfoCDC[i].userData          = NULL;
+    deviceInfoCDC[i].reportSize        = 0;
+    deviceInfoCDC[i].remainingBytes    = 0;
+    deviceInfoCDC[i].interface         = deviceInfoCDC[i].dataInterface.interfaceNum;
+    deviceInfoCDC[i].endpointDATA      = deviceInfoCDC[i].dataInterface.endpointOUT;
+    deviceInfoCDC[i].commRequest       = 0;
+
+    #ifndef USB_ENABLE_TRANSFER_EVENT
+        deviceInfoCDC[i].state             = STATE_RUNNING | SUBSTATE_SEND_WRITE_REQ;
+    #else
+        USBHostClearEndpointErrors( deviceInfoCDC[i].deviceAddress, deviceInfoCDC[i].endpointDATA );
+        errorCode                      = _USBHostCDC_WriteChunk( i );
+        deviceInfoCDC[i].state         = STATE_WRITE_REQ_WAIT;
+        if(errorCode)
+            {
+                _USBHostCDC_TerminateTransfer( USB_CDC_RESET_ERROR );
+            }
+        else
+            {
+                deviceInfoCDC[i].flags.bfReset = 0;
+            }
+    #endif
+    return USB_SUCCESS;
+}
+#endif
+
 /*******************************************************************************
   Function:
     bool USBHostCDCTransferIsComplete( uint8_t deviceAddress,
@@ -1179,6 +1501,13 @@ bool USBHostCDCEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
                     UART2PutHex( deviceInfoCDC[i].state );
                     UART2PrintString( "\r\n" );
                 #endif
+                #if defined( USB_CDC_RX_BUFFER_SIZE )
+                    if (deviceInfoCDC[i].rx.posted && (transfer_data->bEndpointAddress == deviceInfoCDC[i].dataInterface.endpointIN))
+                    {
+                        _USBHostCDC_RxTransferDone( i, transfer_data->bErrorCode, transfer_data->dataCount );
+                        return true;
+                    }
+                #endif
                 switch (deviceInfoCDC[i].state)
                 {
 
@@ -1267,6 +1596,9 @@ bool USBHostCDCEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
                                 // device is ready to TX/RX data 
                                 USB_HOST_APP_EVENT_HANDLER(deviceInfoCDC[i].deviceAddress,EVENT_CDC_ATTACH,NULL, 0);
                                 deviceInfoCDC[i].state     = STATE_RUNNING;
+                                #if defined( USB_CDC_RX_BUFFER_SIZE )
+                                    _USBHostCDC_RxService( i );
+                                #endif
                             }
                         }   
 
@@ -1332,6 +1664,15 @@ bool USBHostCDCEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
                                     // Clear the STALL.  Since it is EP0, we do not have to clear the stall.
                                     USBHostClearEndpointErrors( deviceInfoCDC[i].deviceAddress, deviceInfoCDC[i].endpointDATA );
                                     deviceInfoCDC[i].bytesTransferred = byteCount; /* Can compare with report size and flag error ???*/
+                                    if(_USBHostCDC_MoreToWrite())
+                                    {
+                                        // post the next chunk straight from the completion
+                                        if (_USBHostCDC_WriteChunk( i ))
+                                        {
+                                            _USBHostCDC_TerminateTransfer( USB_CDC_RESET_ERROR );
+                                        }
+                                        break;
+                                    }
                                     deviceInfoCDC[i].state = STATE_RUNNING;
                                     if(deviceInfoCDC[i].endpointDATA == 0x00)
                                     {
@@ -1363,6 +1704,13 @@ bool USBHostCDCEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
             for (i=0; (i<USB_MAX_CDC_DEVICES) && (deviceInfoCDC[i].deviceAddress != address); i++);
             if (i < USB_MAX_CDC_DEVICES)
             {
+                #if defined( USB_CDC_RX_BUFFER_SIZE )
+                    if (deviceInfoCDC[i].rx.posted && (transfer_data->bEndpointAddress == deviceInfoCDC[i].dataInterface.endpointIN))
+                    {
+                        _USBHostCDC_RxTransferDone( i, transfer_data->bErrorCode, 0 );
+                        return true;
+                    }
+                #endif
                 if(transfer_data->bErrorCode == USB_ENDPOINT_NAK_TIMEOUT)
                 {
                     USB_HOST_APP_EVENT_HANDLER(deviceInfoCDC[i].deviceAddress,EVENT_CDC_NAK_TIMEOUT,NULL, 0);
@@ -1614,6 +1962,9 @@ bool USBHostCDCInitialize( uint8_t address, uint32_t flags, uint8_t clientDriver
         }
 
         deviceInfoCDC[device].clientDriverID = clientDriverID;
+        #if defined( USB_CDC_RX_BUFFER_SIZE )
+            _USBHostCDC_RxReset( device );
+        #endif
 
         #ifndef USB_ENABLE_TRANSFER_EVENT
            deviceInfoCDC[device].state                = STATE_INITIALIZE_DEVICE;
@@ -1695,6 +2046,397 @@ void _USBHostCDC_ResetStateJump( uint8_t i )
 }
 
 
+/*******************************************************************************
+  Function:
+    uint8_t _USBHostCDC_WriteChunk( uint8_t i )
+
+  Summary:
+    This function posts the next chunk of a write on the data OUT endpoint.
+
+  Description:
+    This function posts up to USB_CDC_MAX_PACKET_SIZE bytes of the current
+    write.  If the current buffer is done and buffers are queued with
+    USBHostCDCSendSegments(), the next one becomes the current buffer, and
+    it is posted whole as one multi-packet transfer.  A queued buffer shorter
+    than USB_CDC_TX_PACKET_SIZE is packed into one packet with what follows
+    it instead, see _USBHostCDC_PackSegments().  Otherwise the chunk is sent
+    straight from the application buffer.  The write only
+    advances if the chunk was posted, so a failed post can be tried again.
+
+  Precondition:
+    The last chunk has completed.
+
+  Parameters:
+    uint8_t i  - Index into the deviceInfoCDC structure for the device.
+
+  Returns:
+    The return value of USBHostWrite().
+
+  Remarks:
+    None
+*******************************************************************************/
+uint8_t _USBHostCDC_WriteChunk( uint8_t i )
+{
+    uint16_t   size;
+    uint8_t    errorCode;
+
+    #if defined( USB_CDC_TX_QUEUE_DEPTH )
+        if ((deviceInfoCDC[i].txPacketLength == 0) && (deviceInfoCDC[i].remainingBytes == 0) &&
+            (deviceInfoCDC[i].txCount != 0))
+        {
+            _USBHostCDC_NextSegment( i );
+            if (deviceInfoCDC[i].remainingBytes < USB_CDC_TX_PACKET_SIZE)
+            {
+                _USBHostCDC_PackSegments( i );
+            }
+        }
+        if (deviceInfoCDC[i].txPacketLength != 0)
+        {
+            errorCode = USBHostWrite( deviceInfoCDC[i].deviceAddress, deviceInfoCDC[i].endpointDATA,
+                                      deviceInfoCDC[i].txPacket, deviceInfoCDC[i].txPacketLength );
+            if (!errorCode)
+            {
+                deviceInfoCDC[i].bytesTransferred  = deviceInfoCDC[i].txPacketLength;
+                deviceInfoCDC[i].txPacketLength    = 0;
+            }
+            return errorCode;
+        }
+    #endif
+
+    size = deviceInfoCDC[i].remainingBytes;
+    #if defined( USB_CDC_TX_QUEUE_DEPTH )
+        // A segment is not split, so it costs one completion instead of one
+        // per packet.
+        if (!deviceInfoCDC[i].flags.bfSegment)
+    #endif
+    {
+        if (size > USB_CDC_MAX_PACKET_SIZE)
+        {
+            size = USB_CDC_MAX_PACKET_SIZE;
+        }
+    }
+
+    errorCode = USBHostWrite( deviceInfoCDC[i].deviceAddress, deviceInfoCDC[i].endpointDATA,
+                              deviceInfoCDC[i].userData, size );
+    if (!errorCode)
+    {
+        deviceInfoCDC[i].bytesTransferred  = size;
+        deviceInfoCDC[i].remainingBytes   -= size;
+        deviceInfoCDC[i].userData         += size;
+    }
+    return errorCode;
+}
+
+
+#if defined( USB_CDC_TX_QUEUE_DEPTH )
+
+/*******************************************************************************
+  Function:
+    void _USBHostCDC_NextSegment( uint8_t i )
+
+  Summary:
+    This function makes the next queued buffer the current buffer.
+
+  Description:
+    This function takes the oldest buffer off the send queue and makes it
+    the current buffer of the write.
+
+  Precondition:
+    The current buffer is done and the queue is not empty.
+
+  Parameters:
+    uint8_t i  - Index into the deviceInfoCDC structure for the device.
+
+  Returns:
+    None
+
+  Remarks:
+    None
+*******************************************************************************/
+void _USBHostCDC_NextSegment( uint8_t i )
+{
+    // The buffer is only read, so it may be const.
+    deviceInfoCDC[i].userData       = (uint8_t *)deviceInfoCDC[i].txQueue[deviceInfoCDC[i].txHead].data;
+    deviceInfoCDC[i].remainingBytes = deviceInfoCDC[i].txQueue[deviceInfoCDC[i].txHead].length;
+    if (++deviceInfoCDC[i].txHead == USB_CDC_TX_QUEUE_DEPTH)
+    {
+        deviceInfoCDC[i].txHead = 0;
+    }
+    deviceInfoCDC[i].txCount--;
+    deviceInfoCDC[i].flags.bfSegment = 1;
+}
+
+
+/*******************************************************************************
+  Function:
+    void _USBHostCDC_PackSegments( uint8_t i )
+
+  Summary:
+    This function packs short queued buffers into the packet buffer.
+
+  Description:
+    This function copies the current buffer into the packet buffer of the
+    device, followed by the queued buffers after it, until the packet buffer
+    is full or the queue is empty.  The buffer that does not fit whole stays
+    the current buffer, with the part that was copied skipped.
+
+    Sent on its own, a short buffer such as a message header would take a
+    packet, and a transfer, of its own.  Packed, a gathered send takes no
+    more packets than the same data copied into one buffer, and only up to
+    USB_CDC_TX_PACKET_SIZE bytes are copied.
+
+  Precondition:
+    The current buffer is a queued one.
+
+  Parameters:
+    uint8_t i  - Index into the deviceInfoCDC structure for the device.
+
+  Returns:
+    None
+
+  Remarks:
+    The packet is sent by _USBHostCDC_WriteChunk().
+*******************************************************************************/
+void _USBHostCDC_PackSegments( uint8_t i )
+{
+    uint16_t   size = 0;
+    uint16_t   part;
+
+    while (true)
+    {
+        part = USB_CDC_TX_PACKET_SIZE - size;
+        if (part > deviceInfoCDC[i].remainingBytes)
+        {
+            part = deviceInfoCDC[i].remainingBytes;
+        }
+        memcpy( &deviceInfoCDC[i].txPacket[size], deviceInfoCDC[i].userData, part );
+        size                            += part;
+        deviceInfoCDC[i].userData       += part;
+        deviceInfoCDC[i].remainingBytes -= part;
+
+        if ((size == USB_CDC_TX_PACKET_SIZE) || (deviceInfoCDC[i].txCount == 0))
+        {
+            break;
+        }
+        _USBHostCDC_NextSegment( i );
+    }
+    deviceInfoCDC[i].txPacketLength = size;
+}
+
+#endif
+
+
+
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+
+/*******************************************************************************
+  Function:
+    void _USBHostCDC_RxReset( uint8_t i )
+
+  Summary:
+    This function empties the receive buffers of a device.
+
+  Description:
+    This function empties the receive ring and the packet buffers, and
+    clears the receive statistics.  It is called when the device attaches.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t i  - Index into the deviceInfoCDC structure for the device.
+
+  Returns:
+    None
+
+  Remarks:
+    None
+*******************************************************************************/
+void _USBHostCDC_RxReset( uint8_t i )
+{
+    memset( &deviceInfoCDC[i].rx, 0, sizeof(USB_CDC_RX_BUFFER) );
+}
+
+
+/*******************************************************************************
+  Function:
+    void _USBHostCDC_RxTransferDone( uint8_t i, uint8_t errorCode, uint32_t byteCount )
+
+  Summary:
+    This function handles the completion of the posted read.
+
+  Description:
+    This function marks the posted packet buffer as holding byteCount bytes
+    and switches to the other buffer.  It then reposts and moves the data
+    into the ring.  A NAK timeout only means the device had nothing to send,
+    so the read is simply posted again.
+
+  Precondition:
+    A read is posted.
+
+  Parameters:
+    uint8_t i          - Index into the deviceInfoCDC structure for the device.
+    uint8_t errorCode  - Error code of the read
+    uint32_t byteCount - Number of bytes received
+
+  Returns:
+    None
+
+  Remarks:
+    None
+*******************************************************************************/
+void _USBHostCDC_RxTransferDone( uint8_t i, uint8_t errorCode, uint32_t byteCount )
+{
+    USB_CDC_RX_BUFFER  *rx = &deviceInfoCDC[i].rx;
+
+    rx->posted = false;
+    if (errorCode)
+    {
+        USBHostClearEndpointErrors( deviceInfoCDC[i].deviceAddress, deviceInfoCDC[i].dataInterface.endpointIN );
+        if (errorCode != USB_ENDPOINT_NAK_TIMEOUT)
+        {
+            rx->stats.errors++;
+        }
+    }
+    else if (byteCount != 0)
+    {
+        rx->packetLength[rx->post] = byteCount;
+        rx->packetOffset[rx->post] = 0;
+        rx->post ^= 1;
+    }
+
+    _USBHostCDC_RxService( i );
+}
+
+
+/*******************************************************************************
+  Function:
+    void _USBHostCDC_RxService( uint8_t i )
+
+  Summary:
+    This function keeps a read posted and moves received packets into the
+    ring.
+
+  Description:
+    This function posts a read into the next packet buffer if it is free,
+    then moves the packets that have been received into the ring, oldest
+    first, and posts again if that freed a buffer.  Posting first keeps the
+    IN endpoint busy while the data is copied.  If the ring cannot take a
+    whole packet, the rest waits in the packet buffer; with both buffers
+    waiting, no read is posted and the device NAKs.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t i  - Index into the deviceInfoCDC structure for the device.
+
+  Returns:
+    None
+
+  Remarks:
+    None
+*******************************************************************************/
+void _USBHostCDC_RxService( uint8_t i )
+{
+    USB_CDC_RX_BUFFER  *rx = &deviceInfoCDC[i].rx;
+    uint16_t            length;
+    uint16_t            tail;
+    uint16_t            part;
+
+    _USBHostCDC_RxPost( i );
+
+    while (rx->packetLength[rx->drain] != 0)
+    {
+        length = rx->packetLength[rx->drain];
+        if (length > USB_CDC_RX_BUFFER_SIZE - rx->count)
+        {
+            length = USB_CDC_RX_BUFFER_SIZE - rx->count;
+        }
+
+        // Copy in at most two pieces, up to the end of the ring and from its start.
+        while (length != 0)
+        {
+            tail = rx->head + rx->count;
+            if (tail >= USB_CDC_RX_BUFFER_SIZE)
+            {
+                tail -= USB_CDC_RX_BUFFER_SIZE;
+            }
+            part = length;
+            if (part > USB_CDC_RX_BUFFER_SIZE - tail)
+            {
+                part = USB_CDC_RX_BUFFER_SIZE - tail;
+            }
+            memcpy( &rx->ring[tail], &rx->packet[rx->drain][rx->packetOffset[rx->drain]], part );
+            rx->count                       += part;
+            rx->packetOffset[rx->drain]     += part;
+            rx->packetLength[rx->drain]     -= part;
+            rx->stats.bytes                 += part;
+            length                          -= part;
+        }
+        if (rx->count > rx->stats.highWater)
+        {
+            rx->stats.highWater = rx->count;
+        }
+
+        if (rx->packetLength[rx->drain] != 0)
+        {
+            // The ring is full.  Count each pause once.
+            if (!rx->paused)
+            {
+                rx->paused = true;
+                rx->stats.overruns++;
+            }
+            return;
+        }
+        rx->drain ^= 1;
+    }
+    rx->paused = false;
+
+    _USBHostCDC_RxPost( i );
+}
+
+
+/*******************************************************************************
+  Function:
+    void _USBHostCDC_RxPost( uint8_t i )
+
+  Summary:
+    This function posts a read into the next packet buffer.
+
+  Description:
+    This function posts a read on the bulk IN endpoint of the data interface
+    into the next packet buffer, unless a read is already posted or that
+    buffer still holds data.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t i  - Index into the deviceInfoCDC structure for the device.
+
+  Returns:
+    None
+
+  Remarks:
+    If the read cannot be posted, it is tried again on the next call.
+*******************************************************************************/
+void _USBHostCDC_RxPost( uint8_t i )
+{
+    USB_CDC_RX_BUFFER  *rx = &deviceInfoCDC[i].rx;
+
+    if (!rx->posted && (rx->packetLength[rx->post] == 0))
+    {
+        if (!USBHostRead( deviceInfoCDC[i].deviceAddress, deviceInfoCDC[i].dataInterface.endpointIN,
+                          rx->packet[rx->post], USB_CDC_RX_PACKET_SIZE ))
+        {
+            rx->posted = true;
+        }
+    }
+}
+
+#endif
+
 
 /*******************************************************************************
   Function:
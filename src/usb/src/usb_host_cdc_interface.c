@@ -133,7 +133,8 @@ extern uint8_t CDCdeviceAddress ;
     false   -   Transfer request failed.
 
   Remarks:
-    None
+    If USB_CDC_RX_BUFFER_SIZE is defined, the driver receives continuously
+    and this function always fails; use USBHostCDC_Api_Read_IN_Data.
 ***************************************************************************/
 bool USBHostCDC_Api_Get_IN_Data(uint8_t no_of_bytes, uint8_t* data)
 {
@@ -150,6 +151,64 @@ bool USBHostCDC_Api_Get_IN_Data(uint8_t no_of_bytes, uint8_t* data)
 }
 
 
+/****************************************************************************
+  Function:
+    uint16_t USBHostCDC_Api_IN_Data_Available(void)
+
+  Description:
+    This function is called by application to find out how many bytes
+    received over DATA interface are waiting to be read.
+
+  Precondition:
+    None
+
+  Parameters:
+    None
+
+  Returns:
+    Number of bytes that USBHostCDC_Api_Read_IN_Data can return at once.
+
+  Remarks:
+    Only available if USB_CDC_RX_BUFFER_SIZE is defined.
+***************************************************************************/
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+uint16_t USBHostCDC_Api_IN_Data_Available(void)
+{
+    return USBHostCDCRxAvailable(CDCdeviceAddress);
+}
+#endif
+
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostCDC_Api_Read_IN_Data(uint16_t no_of_bytes, uint8_t* data)
+
+  Description:
+    This function is called by application to take data received over DATA
+    interface. The driver keeps receiving into a ring in the background;
+    this function copies what is waiting and returns without blocking.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint16_t   no_of_bytes - Size of the application receive data buffer.
+    uint8_t*   data        - Pointer to application receive data buffer.
+
+  Returns:
+    Number of bytes copied, 0 if none were waiting.
+
+  Remarks:
+    Only available if USB_CDC_RX_BUFFER_SIZE is defined.
+***************************************************************************/
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+uint16_t USBHostCDC_Api_Read_IN_Data(uint16_t no_of_bytes, uint8_t* data)
+{
+    return USBHostCDCRxRead(CDCdeviceAddress, data, no_of_bytes);
+}
+#endif
+
+
 /****************************************************************************
   Function:
     bool USBHostCDC_Api_Send_OUT_Data(uint8_t no_of_bytes, uint8_t* data)
@@ -189,6 +248,40 @@ bool USBHostCDC_Api_Send_OUT_Data(uint16_t no_of_bytes, uint8_t* data)
 }
 
 
+/****************************************************************************
+  Function:
+    bool USBHostCDC_Api_Send_OUT_Segments(const USB_CDC_TX_SEGMENT* segments,
+                                          uint8_t count)
+
+  Description:
+    This function is called by application to transmit several buffers over
+    DATA interface as one stream, for example a message header and its
+    payload, without copying them into one buffer first. If a send is
+    already in progress, the buffers are sent after it.
+
+  Precondition:
+    None
+
+  Parameters:
+    const USB_CDC_TX_SEGMENT* segments - List of buffers to transmit.
+    uint8_t    count                   - Number of buffers in the list.
+
+  Return Values:
+    true    -   All of the buffers were queued.
+    false   -   None of the buffers were queued.
+
+  Remarks:
+    Only available if USB_CDC_TX_QUEUE_DEPTH is defined. The buffers must
+    not change until USBHostCDC_ApiTransferIsComplete reports the send done.
+***************************************************************************/
+#if defined( USB_CDC_TX_QUEUE_DEPTH )
+bool USBHostCDC_Api_Send_OUT_Segments(const USB_CDC_TX_SEGMENT* segments, uint8_t count)
+{
+    return (USBHostCDCSendSegments(CDCdeviceAddress, segments, count) == USB_SUCCESS);
+}
+#endif
+
+
 /****************************************************************************
   Function:
     bool USBHostCDC_ApiTransferIsComplete(uint8_t* errorCodeDriver,uint8_t* byteCount)
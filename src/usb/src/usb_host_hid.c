@@ -244,6 +244,7 @@ typedef struct _USB_HID_DEVICE_INFO
 //******************************************************************************
 void _USBHostHID_FreeRptDecriptorDataMem(uint8_t deviceAddress);
 void _USBHostHID_ResetStateJump( uint8_t i );
+static uint32_t _USBHostHID_ExtractValue(uint8_t *report, uint16_t bitOffset, uint8_t bitLength, bool signExtend);
 
 
 //******************************************************************************
@@ -261,6 +262,13 @@ void _USBHostHID_ResetStateJump( uint8_t i );
 
 #define USB_FREE_AND_CLEAR(ptr) {USB_FREE(ptr); ptr = NULL;}
 
+// The raw report descriptor is refused if it alone exceeds the parser cap.
+#ifdef USB_HID_MAX_PARSER_MEMORY
+    #define USB_MALLOC_RPT_DESCRIPTOR(size) (((size) > USB_HID_MAX_PARSER_MEMORY) ? NULL : USB_MALLOC(size))
+#else
+    #define USB_MALLOC_RPT_DESCRIPTOR(size) USB_MALLOC(size)
+#endif
+
 #define _USBHostHID_LockDevice(x)                   {                                                   \
                                                         deviceInfoHID[i].errorCode  = x;                \
                                                         deviceInfoHID[i].state      = STATE_HOLDING;    \
@@ -700,7 +708,7 @@ void USBHostHIDTasks( void )
                         {
                             if(pCurrInterfaceDetails->sizeOfRptDescriptor !=0) // interface must have a Report Descriptor
                             {
-                                if((deviceInfoHID[i].rptDescriptor = (uint8_t *)USB_MALLOC(pCurrInterfaceDetails->sizeOfRptDescriptor)) == NULL)
+                                if((deviceInfoHID[i].rptDescriptor = (uint8_t *)USB_MALLOC_RPT_DESCRIPTOR(pCurrInterfaceDetails->sizeOfRptDescriptor)) == NULL)
                                 {
                                     _USBHostHID_LockDevice( USB_MEMORY_ALLOCATION_ERROR );
                                     break;
@@ -749,6 +757,8 @@ void USBHostHIDTasks( void )
                         /* Invoke HID Parser ,, validate for all the errors in report Descriptor */
                         deviceInfoHID[i].HIDparserError = _USBHostHID_Parse_Report((uint8_t*)deviceInfoHID[i].rptDescriptor , (uint16_t)pCurrInterfaceDetails->sizeOfRptDescriptor,
                                                                                (uint16_t)pCurrInterfaceDetails->endpointPollInterval, pCurrInterfaceDetails->interfaceNumber);
+                        // The parser keeps nothing from the raw descriptor; release it before the application runs
+                        USB_FREE_AND_CLEAR(deviceInfoHID[i].rptDescriptor);
                         if(deviceInfoHID[i].HIDparserError)
                         {
                             /* Report Descriptor is flawed , flag error and free memory ,
@@ -779,8 +789,7 @@ void USBHostHIDTasks( void )
                                 USB_HOST_APP_EVENT_HANDLER( deviceInfoHID[i].ID.deviceAddress, EVENT_HID_BAD_REPORT_DESCRIPTOR, NULL, 0 );
                             }
                         }
-                        // free the previous allocated memory, reallocate for new interface if needed
-                        USB_FREE_AND_CLEAR(deviceInfoHID[i].rptDescriptor);
+                        // reallocate for new interface if needed
                         pCurrInterfaceDetails = pCurrInterfaceDetails->next;
                         if(pCurrInterfaceDetails != NULL)
                         {
@@ -1275,43 +1284,32 @@ bool USBHostHIDTransferIsComplete( uint8_t deviceAddress, uint8_t *errorCode, ui
 bool USBHostHID_ApiFindBit(uint16_t usagePage,uint16_t usage,HIDReportTypeEnum type,uint8_t* Report_ID,
                     uint8_t* Report_Length, uint8_t* Start_Bit)
 {
-    uint16_t iR;
     uint16_t index;
     uint16_t reportIndex;
+    uint8_t iR;
     HID_REPORTITEM *reportItem;
-    uint8_t* count;
 
 //  Disallow Null Pointers
 
     if((Report_ID == NULL)|(Report_Length == NULL)|(Start_Bit == NULL))
         return false;
 
-//  Search through all the report items
+//  Look up the first report item of the proper type with the usage
 
-    for (iR=0; iR < deviceRptInfo.reportItems; iR++)
-        {
-            reportItem = &itemListPtrs.reportItemList[iR];
-
-//      Search only reports of the proper type
+    if (!USBHostHID_FindUsage(usagePage, usage, type, 0, &iR, &index))
+        return false;
 
-            if ((reportItem->reportType==type))// && (reportItem->globals.reportsize == 1))
-                {
-                    if (USBHostHID_HasUsage(reportItem,usagePage,usage,(uint16_t*)&index,(uint8_t*)&count))
-                        {
-                             reportIndex = reportItem->globals.reportIndex;
-                             *Report_ID = itemListPtrs.reportList[reportIndex].reportID;
-                             *Start_Bit = reportItem->startBit + index;
-                             if (type == hidReportInput)
-                                 *Report_Length = (itemListPtrs.reportList[reportIndex].inputBits + 7)/8;
-                             else if (type == hidReportOutput)
-                                 *Report_Length = (itemListPtrs.reportList[reportIndex].outputBits + 7)/8;
-                             else
-                                 *Report_Length = (itemListPtrs.reportList[reportIndex].featureBits + 7)/8;
-                             return true;
-                         }
-                }
-        }
-    return false;
+    reportItem = &itemListPtrs.reportItemList[iR];
+    reportIndex = reportItem->globals.reportIndex;
+    *Report_ID = itemListPtrs.reportList[reportIndex].reportID;
+    *Start_Bit = reportItem->startBit + index;
+    if (type == hidReportInput)
+        *Report_Length = (itemListPtrs.reportList[reportIndex].inputBits + 7)/8;
+    else if (type == hidReportOutput)
+        *Report_Length = (itemListPtrs.reportList[reportIndex].outputBits + 7)/8;
+    else
+        *Report_Length = (itemListPtrs.reportList[reportIndex].featureBits + 7)/8;
+    return true;
 }
 
 /*******************************************************************************
@@ -1356,7 +1354,6 @@ bool USBHostHID_ApiFindValue(uint16_t usagePage,uint16_t usage,HIDReportTypeEnum
     uint16_t index;
     uint16_t reportIndex;
     uint8_t iR;
-    uint8_t count;
     HID_REPORTITEM *reportItem;
 
 //  Disallow Null Pointers
@@ -1364,34 +1361,133 @@ bool USBHostHID_ApiFindValue(uint16_t usagePage,uint16_t usage,HIDReportTypeEnum
      if((Report_ID == NULL)|(Report_Length == NULL)|(Start_Bit == NULL)|(Bit_Length == NULL))
         return false;
 
-//  Search through all the report items
+//  Look up the first variable, multi-bit report item of the proper type
+//  with the usage
 
-    for (iR=0; iR < deviceRptInfo.reportItems; iR++)
-    {
-        reportItem = &itemListPtrs.reportItemList[iR];
+    if (!USBHostHID_FindUsage(usagePage, usage, type, HID_FIND_NO_ARRAYS | HID_FIND_NO_BITS, &iR, &index))
+        return false;
 
-//      Search only reports of the proper type
+    reportItem = &itemListPtrs.reportItemList[iR];
+    reportIndex = reportItem->globals.reportIndex;
+    *Report_ID = itemListPtrs.reportList[reportIndex].reportID;
+    *Bit_Length = reportItem->globals.reportsize;
+    *Start_Bit = reportItem->startBit + index * (reportItem->globals.reportsize);
+    if (type == hidReportInput)
+        *Report_Length = (itemListPtrs.reportList[reportIndex].inputBits + 7)/8;
+    else if (type == hidReportOutput)
+        *Report_Length = (itemListPtrs.reportList[reportIndex].outputBits + 7)/8;
+    else
+        *Report_Length = (itemListPtrs.reportList[reportIndex].featureBits + 7)/8;
+    return true;
+}
 
-        if ((reportItem->reportType==type)&& ((reportItem->dataModes & HIDData_ArrayBit) != HIDData_Array)
-             && (reportItem->globals.reportsize != 1))
-        {
-            if (USBHostHID_HasUsage(reportItem,usagePage,usage,&index,&count))
-            {
-                 reportIndex = reportItem->globals.reportIndex;
-                 *Report_ID = itemListPtrs.reportList[reportIndex].reportID;
-                 *Bit_Length = reportItem->globals.reportsize;
-                 *Start_Bit = reportItem->startBit + index * (reportItem->globals.reportsize);
-                 if (type == hidReportInput)
-                     *Report_Length = (itemListPtrs.reportList[reportIndex].inputBits + 7)/8;
-                 else if (type == hidReportOutput)
-                     *Report_Length = (itemListPtrs.reportList[reportIndex].outputBits + 7)/8;
-                 else
-                     *Report_Length = (itemListPtrs.reportList[reportIndex].featureBits + 7)/8;
-                 return true;
-             }
-        }
-    }
-    return false;
+
+/*******************************************************************************
+  Function:
+    bool USBHostHID_ApiResolveUsage(uint16_t usagePage, uint16_t usage,
+                HIDReportTypeEnum type, HID_USAGE_HANDLE *pHandle)
+
+  Description:
+    This function looks up a button or value once and stores where it is in
+    a handle.  The application can then read the control from every report
+    with USBHostHID_ApiReadUsage(), without searching the report items again.
+
+  Precondition:
+    Application event handler with event 'EVENT_HID_RPT_DESC_PARSED' is
+    being called.
+
+  Parameters:
+    uint16_t usagePage          - usage page supported by application
+    uint16_t usage              - usage supported by application
+    HIDReportTypeEnum type      - report type Input/Output/Feature
+    HID_USAGE_HANDLE *pHandle   - returns the handle of the usage
+
+  Return Values:
+    true    - The usage is resolved into pHandle
+    false   - The device has no variable item with the usage, or the item
+              is wider than HID_MAX_DATA_FIELD_SIZE
+
+  Remarks:
+    Array items report usages as values and have no fixed position for a
+    usage; use USBHostHID_ApiImportReport() for them.
+*******************************************************************************/
+bool USBHostHID_ApiResolveUsage(uint16_t usagePage, uint16_t usage, HIDReportTypeEnum type, HID_USAGE_HANDLE *pHandle)
+{
+    uint16_t index;
+    uint16_t reportIndex;
+    uint8_t iR;
+    HID_REPORTITEM *reportItem;
+
+//  Disallow Null Pointers
+
+    if (pHandle == NULL)
+        return false;
+
+    if (!USBHostHID_FindUsage(usagePage, usage, type, HID_FIND_NO_ARRAYS, &iR, &index))
+        return false;
+
+    reportItem = &itemListPtrs.reportItemList[iR];
+    if ((index >= reportItem->globals.reportCount) || (reportItem->globals.reportsize > HID_MAX_DATA_FIELD_SIZE))
+        return false;
+
+    reportIndex = reportItem->globals.reportIndex;
+    pHandle->reportID = itemListPtrs.reportList[reportIndex].reportID;
+    pHandle->bitOffset = reportItem->startBit + index * reportItem->globals.reportsize;
+    pHandle->bitLength = reportItem->globals.reportsize;
+    pHandle->flags = 0;
+    if (reportItem->globals.logicalMinimum < 0)
+        pHandle->flags |= HID_FIELD_SIGNED;
+    if (reportItem->dataModes & HIDData_Relative)
+        pHandle->flags |= HID_FIELD_RELATIVE;
+    if (type == hidReportInput)
+        pHandle->reportLength = (itemListPtrs.reportList[reportIndex].inputBits + 7)/8;
+    else if (type == hidReportOutput)
+        pHandle->reportLength = (itemListPtrs.reportList[reportIndex].outputBits + 7)/8;
+    else
+        pHandle->reportLength = (itemListPtrs.reportList[reportIndex].featureBits + 7)/8;
+    pHandle->interfaceNum = deviceRptInfo.interfaceNumber;
+    return true;
+}
+
+
+/*******************************************************************************
+  Function:
+    bool USBHostHID_ApiReadUsage(uint8_t *report, uint16_t reportLength,
+                HID_USAGE_HANDLE *pHandle, HID_USER_DATA_SIZE *pValue)
+
+  Description:
+    This function reads the value of a usage resolved with
+    USBHostHID_ApiResolveUsage() from a report.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t *report             - Report received from device
+    uint16_t reportLength       - Length of the report
+    HID_USAGE_HANDLE *pHandle   - Handle of the usage
+    HID_USER_DATA_SIZE *pValue  - returns the value, sign extended if the
+                                  logical minimum is negative
+
+  Return Values:
+    true    - The value is read
+    false   - The report is not the one that holds the usage
+
+  Remarks:
+    None
+*******************************************************************************/
+bool USBHostHID_ApiReadUsage(uint8_t *report, uint16_t reportLength, HID_USAGE_HANDLE *pHandle, HID_USER_DATA_SIZE *pValue)
+{
+    if ((report == NULL) || (pHandle == NULL) || (pValue == NULL)) return false;
+    if ((pHandle->reportID != 0) && (pHandle->reportID != report[0])) return false;
+    if (pHandle->reportLength != reportLength) return false;
+
+    if ((pHandle->bitLength == 1) && !(pHandle->flags & HID_FIELD_SIGNED))
+        *pValue = (report[pHandle->bitOffset >> 3] >> (pHandle->bitOffset & 7)) & 1;
+    else
+        *pValue = _USBHostHID_ExtractValue(report, pHandle->bitOffset, pHandle->bitLength,
+                                           (pHandle->flags & HID_FIELD_SIGNED) != 0);
+    return true;
 }
 
 
@@ -1495,13 +1591,7 @@ uint8_t USBHostHID_ApiGetCurrentInterfaceNum(void)
 *******************************************************************************/
 bool USBHostHID_ApiImportData(uint8_t *report, uint16_t reportLength, HID_USER_DATA_SIZE *buffer, HID_DATA_DETAILS *pDataDetails)
 {
-    uint16_t data;
-    uint16_t signBit;
-    uint16_t mask;
-    uint16_t extendMask;
     uint16_t start;
-    uint16_t startByte;
-    uint16_t startBit;
     uint16_t lastByte;
     uint16_t i;
 
@@ -1523,53 +1613,263 @@ bool USBHostHID_ApiImportData(uint8_t *report, uint16_t reportLength, HID_USER_D
 
     start = pDataDetails->bitOffset;
     for (i=0; i<pDataDetails->count; i++) {
-        startByte = start/8;
-        startBit = start&7;
-        lastByte = (start + pDataDetails->bitLength - 1)/8;
+        *buffer++ = _USBHostHID_ExtractValue(report, start, pDataDetails->bitLength, pDataDetails->signExtend);
+        start += pDataDetails->bitLength;
+    }
+    return true;
+}
 
-//      Pick up the data bytes backwards
 
-        data = 0;
-        do {
-            data <<= 8;
-            data |= (int) report[lastByte];
-        }
-        while (lastByte-- > startByte);
+/*******************************************************************************
+  Function:
+    bool USBHostHID_ApiCompileReport(HIDReportTypeEnum type, uint8_t reportID,
+                    HID_REPORT_PLAN *pPlan, HID_FIELD *pFields, uint8_t maxFields)
 
-//      Shift to the right to byte align the least significant bit
+  Description:
+    This function copies the fields that the parser compiled for one report
+    into application memory and fills in the report plan.
 
-        if (startBit > 0) data >>= startBit;
+  Precondition:
+    Application event handler with event 'EVENT_HID_RPT_DESC_PARSED' is
+    being called.
 
-//      Done if 16 bits long
+  Parameters:
+    HIDReportTypeEnum type  - report type Input/Output/Feature
+    uint8_t reportID        - report ID, or 0 if the device has no report IDs
+    HID_REPORT_PLAN *pPlan  - returns the plan of the report
+    HID_FIELD *pFields      - array that receives the compiled fields
+    uint8_t maxFields       - number of entries in pFields
 
-        if (pDataDetails->bitLength < 16) {
+  Return Values:
+    true    - The report is compiled into pPlan
+    false   - The report does not exist, has more than maxFields fields,
+              or has a field wider than HID_MAX_DATA_FIELD_SIZE
 
-//          Mask off the other bits
+  Remarks:
+    None
+*******************************************************************************/
+bool USBHostHID_ApiCompileReport(HIDReportTypeEnum type, uint8_t reportID, HID_REPORT_PLAN *pPlan,
+                    HID_FIELD *pFields, uint8_t maxFields)
+{
+    HID_REPORT *report;
+    uint16_t bits;
+    uint16_t values;
+    uint8_t reportIndex;
+    uint8_t i;
+
+//  Disallow Null Pointers
+
+    if ((pPlan == NULL) || (pFields == NULL) || (type >= hidReportUnknown))
+        return false;
+
+//  Find the report
+
+    for (reportIndex=0; (reportIndex < deviceRptInfo.reports) && (itemListPtrs.reportList[reportIndex].reportID != reportID); reportIndex++);
+    if (reportIndex == deviceRptInfo.reports)
+        return false;
+    report = &itemListPtrs.reportList[reportIndex];
 
-            mask = 1 << pDataDetails->bitLength;
-            mask--;
-            data &= mask;
+    if (type == hidReportInput)
+        bits = report->inputBits;
+    else if (type == hidReportOutput)
+        bits = report->outputBits;
+    else
+        bits = report->featureBits;
 
-//          Sign extend the report item
+    if ((bits == 0) || (report->fields[type] > maxFields))
+        return false;
 
-            if (pDataDetails->signExtend) {
-                signBit = 1;
-                if (pDataDetails->bitLength > 1) signBit <<= (pDataDetails->bitLength-1);
-                extendMask = (signBit << 1) - 1;
-                if ((data & signBit)==0) data &= extendMask;
-                else data |= ~extendMask;
+//  Copy the compiled fields
+
+    values = 0;
+    for (i=0; i<report->fields[type]; i++)
+    {
+        pFields[i] = itemListPtrs.fieldList[report->firstField[type] + i];
+        if (pFields[i].bitLength > HID_MAX_DATA_FIELD_SIZE)
+            return false;
+        values += pFields[i].count;
+    }
+    if (values > 0xFF)
+        return false;
+
+    pPlan->fields = pFields;
+    pPlan->numFields = report->fields[type];
+    pPlan->numValues = values;
+    pPlan->reportID = reportID;
+    pPlan->reportLength = (bits + 7)/8;
+    pPlan->interfaceNum = deviceRptInfo.interfaceNumber;
+    return true;
+}
+
+
+/*******************************************************************************
+  Function:
+    uint8_t USBHostHID_ApiImportReport(uint8_t *report, uint16_t reportLength,
+                    HID_REPORT_PLAN *pPlan, HID_USER_DATA_SIZE *buffer)
+
+  Description:
+    This function extracts every value of a report compiled with
+    USBHostHID_ApiCompileReport(), field by field.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t *report             - Report received from device
+    uint16_t reportLength       - Length of the report
+    HID_REPORT_PLAN *pPlan      - Plan of the report
+    HID_USER_DATA_SIZE *buffer  - Buffer of at least pPlan->numValues
+                                  entries that receives the values
+
+  Return Values:
+    pPlan->numValues    - The report was imported
+    0                   - The report ID or length does not match the plan
+
+  Remarks:
+    None
+*******************************************************************************/
+uint8_t USBHostHID_ApiImportReport(uint8_t *report, uint16_t reportLength, HID_REPORT_PLAN *pPlan, HID_USER_DATA_SIZE *buffer)
+{
+    HID_FIELD *field;
+    uint8_t *data;
+    uint16_t bit;
+    uint8_t f;
+    uint8_t i;
+    bool isSigned;
+
+//  Must be the right report, and the plan guarantees that every field fits
+
+    if ((report == NULL) || (pPlan == NULL) || (buffer == NULL)) return 0;
+    if ((pPlan->reportID != 0) && (pPlan->reportID != report[0])) return 0;
+    if (pPlan->reportLength != reportLength) return 0;
+
+    field = pPlan->fields;
+    for (f=0; f<pPlan->numFields; f++, field++) {
+        bit = field->bitOffset;
+        isSigned = (field->flags & HID_FIELD_SIGNED) != 0;
+
+        if (field->flags & HID_FIELD_ALIGNED) {
+
+//          Whole bytes: copy them
+
+            data = &report[bit >> 3];
+            for (i=0; i<field->count; i++) {
+                if (field->bitLength == 8) {
+                    *buffer++ = isSigned ? (HID_USER_DATA_SIZE)(int8_t)data[0] : data[0];
+                    data += 1;
+                }
+                else if (field->bitLength == 16) {
+                    *buffer++ = isSigned ? (HID_USER_DATA_SIZE)(int16_t)(data[0] | ((uint16_t)data[1] << 8)) :
+                                           (HID_USER_DATA_SIZE)(data[0] | ((uint16_t)data[1] << 8));
+                    data += 2;
+                }
+                else {
+                    *buffer++ = (HID_USER_DATA_SIZE)(data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+                    data += 4;
+                }
             }
         }
+        else if ((field->bitLength == 1) && !isSigned) {
 
-//      Save the value
+//          Buttons and indicators
 
-        *buffer++ = data;
+            for (i=0; i<field->count; i++, bit++)
+                *buffer++ = (report[bit >> 3] >> (bit & 7)) & 1;
+        }
+        else {
+            for (i=0; i<field->count; i++, bit += field->bitLength)
+                *buffer++ = _USBHostHID_ExtractValue(report, bit, field->bitLength, isSigned);
+        }
+    }
+    return pPlan->numValues;
+}
 
-//      Next one
 
-        start += pDataDetails->bitLength;
+/*******************************************************************************
+  Function:
+    int32_t USBHostHID_ApiScaleValue(HID_FIELD *pField, int32_t value)
+
+  Description:
+    This function converts a logical value of a compiled field to physical
+    units, using the scale factor computed by the parser.
+
+  Precondition:
+    None
+
+  Parameters:
+    HID_FIELD *pField   - Compiled field the value belongs to
+    int32_t value       - Logical value, sign extended if the field is signed
+
+  Returns:
+    The physical value.
+
+  Remarks:
+    None
+*******************************************************************************/
+int32_t USBHostHID_ApiScaleValue(HID_FIELD *pField, int32_t value)
+{
+    if ((pField == NULL) || ((pField->flags & HID_FIELD_SCALED) == 0))
+        return value;
+
+    return pField->physicalMinimum + (int32_t)((((int64_t)value - pField->logicalMinimum) * pField->scale) / 65536);
+}
+
+
+/*******************************************************************************
+  Function:
+    static uint32_t _USBHostHID_ExtractValue(uint8_t *report, uint16_t bitOffset,
+                    uint8_t bitLength, bool signExtend)
+
+  Description:
+    This function extracts one value of up to 32 bits from a report.
+
+  Precondition:
+    The value lies within the report.
+
+  Parameters:
+    uint8_t *report     - Report received from device
+    uint16_t bitOffset  - Bit position of the value in the report
+    uint8_t bitLength   - Size of the value in bits, 1 to 32
+    bool signExtend     - Sign extend the value
+
+  Returns:
+    The value.
+
+  Remarks:
+    None
+*******************************************************************************/
+static uint32_t _USBHostHID_ExtractValue(uint8_t *report, uint16_t bitOffset, uint8_t bitLength, bool signExtend)
+{
+    uint8_t *data;
+    uint32_t value;
+    uint32_t signBit;
+    uint8_t shift;
+    uint8_t bytes;
+
+    data = &report[bitOffset >> 3];
+    shift = bitOffset & 7;
+    bytes = (shift + bitLength + 7) >> 3;
+
+//  Pick up the data bytes, least significant first, and byte align the
+//  least significant bit
+
+    value = data[0];
+    if (bytes > 1) value |= (uint32_t)data[1] << 8;
+    if (bytes > 2) value |= (uint32_t)data[2] << 16;
+    if (bytes > 3) value |= (uint32_t)data[3] << 24;
+    value >>= shift;
+    if (bytes > 4) value |= (uint32_t)data[4] << (32 - shift);
+
+//  Mask off the other bits and sign extend
+
+    if (bitLength < 32) {
+        value &= ((uint32_t)1 << bitLength) - 1;
+        if (signExtend) {
+            signBit = (uint32_t)1 << (bitLength - 1);
+            value = (value ^ signBit) - signBit;
+        }
     }
-    return true;
+    return value;
 }
 
 
@@ -1670,6 +1970,8 @@ bool USBHostHIDEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
 //                             deviceInfoHID[i].bytesTransferred = ((HOST_TRANSFER_DATA *)data)->dataCount;
                              deviceInfoHID[i].HIDparserError = _USBHostHID_Parse_Report((uint8_t*)deviceInfoHID[i].rptDescriptor , (uint16_t)pCurrInterfaceDetails->sizeOfRptDescriptor,
                                                                                     (uint16_t)pCurrInterfaceDetails->endpointPollInterval, pCurrInterfaceDetails->interfaceNumber);
+                             // The parser keeps nothing from the raw descriptor; release it before the application runs
+                             USB_FREE_AND_CLEAR(deviceInfoHID[i].rptDescriptor);
 
                             if(deviceInfoHID[i].HIDparserError)
                             {
@@ -1707,14 +2009,13 @@ bool USBHostHIDEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
                                         USB_HOST_APP_EVENT_HANDLER( deviceInfoHID[i].ID.deviceAddress, EVENT_HID_BAD_REPORT_DESCRIPTOR, NULL, 0 );
                                     }
                                 }
-                                USB_FREE_AND_CLEAR(deviceInfoHID[i].rptDescriptor);
                                 pCurrInterfaceDetails = pCurrInterfaceDetails->next;
 
                                 if(pCurrInterfaceDetails != NULL)
                                 {
                                     if(pCurrInterfaceDetails->sizeOfRptDescriptor !=0)
                                     {
-                                        if((deviceInfoHID[i].rptDescriptor = (uint8_t *)USB_MALLOC(pCurrInterfaceDetails->sizeOfRptDescriptor)) == NULL)
+                                        if((deviceInfoHID[i].rptDescriptor = (uint8_t *)USB_MALLOC_RPT_DESCRIPTOR(pCurrInterfaceDetails->sizeOfRptDescriptor)) == NULL)
                                         {
                                             #ifdef DEBUG_MODE
                                                 UART2PrintString( "HID: Out of memory\r\n" );
@@ -2128,7 +2429,7 @@ bool USBHostHIDInitialize( uint8_t address, uint32_t flags, uint8_t clientDriver
                     USB_FREE_AND_CLEAR( deviceInfoHID[device].rptDescriptor );
                 }
 
-                if((deviceInfoHID[device].rptDescriptor = (uint8_t *)USB_MALLOC(pCurrInterfaceDetails->sizeOfRptDescriptor)) == NULL)
+                if((deviceInfoHID[device].rptDescriptor = (uint8_t *)USB_MALLOC_RPT_DESCRIPTOR(pCurrInterfaceDetails->sizeOfRptDescriptor)) == NULL)
                 {
                     return false;
                 }
@@ -97,10 +97,15 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 //******************************************************************************
 
 static void _USBHostHID_InitDeviceRptInfo(void);
+static bool _USBHostHID_Read_Item(uint8_t** pDescriptor, uint16_t* pRemaining, HID_ITEM_INFO* item);
+static bool _USBHostHID_Count(uint8_t* counter);
 static void _USBHostHID_Parse_Collection(HID_ITEM_INFO* ptrItem);
 static void _USBHostHID_Parse_EndCollection(HID_ITEM_INFO* ptrItem);
 static USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_ReportType(HID_ITEM_INFO* item);
 static void _USBHostHID_ConvertDataToSigned(HID_ITEM_INFO* item);
+static void _USBHostHID_Compile_Fields(void);
+static void _USBHostHID_Build_UsageIndex(void);
+static bool _USBHostHID_UsageIndexBefore(HID_USAGEINDEX *a, HID_USAGEINDEX *b);
 
 //******************************************************************************
 //******************************************************************************
@@ -143,7 +148,7 @@ uint8_t*                   parsedDataMem = NULL;
 ***************************************************************************/
 USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , uint16_t lengthOfDescriptor , uint16_t pollRate, uint8_t interfaceNum)
 {
-   uint16_t  sizeRequired = 0;
+   uint32_t  sizeRequired = 0;
    uint16_t  len_to_be_parsed =0;
    uint8_t* currentRptDescPtr = NULL;
    uint8_t* assignMem = NULL;
@@ -166,8 +171,6 @@ USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , u
    HID_ITEM_INFO item;
 
    uint8_t  i=0;
-   uint8_t  dataByte=0 ;
-   uint8_t  ldataSize=0;
 
    if((hidReportDescriptor == NULL) ||(lengthOfDescriptor == 0))
     {
@@ -186,14 +189,9 @@ USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , u
 
     while(len_to_be_parsed > 0)    /* First parse to calculate the space required for all the items */
     {
-       item.ItemDetails.val = *currentRptDescPtr;
-       /* Data need not be parsed at this point */
-       ldataSize = item.ItemDetails.ItemSize ;
-       if(item.ItemDetails.ItemSize == 3) 
-           ldataSize = 4; 
-
-       currentRptDescPtr += (ldataSize+1) ; /* point to next item i.e size of item data + 1(item detail) */
-       len_to_be_parsed -= (ldataSize+1);   /* remaining bytes = current - (length of data + 1)*/
+       /* Data need not be parsed at this point, but the item must be complete */
+       if (!_USBHostHID_Read_Item(&currentRptDescPtr, &len_to_be_parsed, &item))
+           return(HID_ERR_UnexpectedEndOfDescriptor);
 
         switch (item.ItemDetails.ItemType)
             {
@@ -201,7 +199,8 @@ USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , u
                     switch (item.ItemDetails.ItemTag)
                     {
                         case HIDTag_Collection:
-                            deviceRptInfo.collections++;
+                            if (!_USBHostHID_Count(&deviceRptInfo.collections))
+                                  lhidError = HID_ERR_TooManyItems;
                             deviceRptInfo.collectionNesting++;
                             if (deviceRptInfo.collectionNesting > deviceRptInfo.maxCollectionNesting)
                                 deviceRptInfo.maxCollectionNesting = deviceRptInfo.collectionNesting;
@@ -213,7 +212,8 @@ USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , u
                         case HIDTag_Input:
                         case HIDTag_Output:
                         case HIDTag_Feature:
-                            deviceRptInfo.reportItems++;
+                            if (!_USBHostHID_Count(&deviceRptInfo.reportItems))
+                                  lhidError = HID_ERR_TooManyItems;
                             break;
                         default :
                     break;
@@ -223,10 +223,12 @@ USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , u
                     switch (item.ItemDetails.ItemTag)
                     {
                         case HIDTag_ReportID:
-                            deviceRptInfo.reports++;
+                            if (!_USBHostHID_Count(&deviceRptInfo.reports))
+                                lhidError = HID_ERR_TooManyItems;
                             break;
                         case HIDTag_Push:
-                            deviceRptInfo.globalsNesting++;
+                            if (!_USBHostHID_Count(&deviceRptInfo.globalsNesting))
+                                lhidError = HID_ERR_TooManyItems;
                             if (deviceRptInfo.globalsNesting > deviceRptInfo.maxGlobalsNesting)
                                 deviceRptInfo.maxGlobalsNesting = deviceRptInfo.globalsNesting;
                             break;
@@ -243,14 +245,16 @@ USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , u
                     switch (item.ItemDetails.ItemTag)
                     {
                         case HIDTag_Usage:
-                            deviceRptInfo.usages++;
+                            if (!_USBHostHID_Count(&deviceRptInfo.usages))
+                                lhidError = HID_ERR_TooManyItems;
                             break;
                         case HIDTag_UsageMinimum:
                         case HIDTag_UsageMaximum:
                             deviceRptInfo.usageRanges++;
                             break;
                         case HIDTag_StringIndex:
-                            deviceRptInfo.strings++;
+                            if (!_USBHostHID_Count(&deviceRptInfo.strings))
+                                lhidError = HID_ERR_TooManyItems;
                             break;
                         case HIDTag_StringMinimum:
                         case HIDTag_StringMaximum:
@@ -291,7 +295,12 @@ USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , u
     if ((deviceRptInfo.designatorRanges & 1) == 1) return(HID_ERR_UnmatchedDesignatorRange)/* HID_RPT_DESC_FORMAT_IMPROPER */;
 
 
-   /* usages , strings & descriptors are in pair */
+   /* usages , strings & descriptors are in pair , and are indexed by a byte */
+    if ((deviceRptInfo.usages + (deviceRptInfo.usageRanges/2) > 0xFF) ||
+        (deviceRptInfo.strings + (deviceRptInfo.stringRanges/2) > 0xFF) ||
+        (deviceRptInfo.designators + (deviceRptInfo.designatorRanges/2) > 0xFF))
+        return(HID_ERR_TooManyItems);
+
     deviceRptInfo.usages += (deviceRptInfo.usageRanges/2);
     deviceRptInfo.strings += (deviceRptInfo.stringRanges/2);
     deviceRptInfo.designators += (deviceRptInfo.designatorRanges/2);
@@ -300,13 +309,20 @@ USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , u
 
     sizeRequired = (sizeof(HID_COLLECTION) * deviceRptInfo.collections)
                    + (sizeof(HID_REPORTITEM) * deviceRptInfo.reportItems)
+                   + (sizeof(HID_FIELD) * deviceRptInfo.reportItems)
                    + (sizeof(HID_REPORT) * deviceRptInfo.reports)
                    + (sizeof(HID_USAGEITEM) * deviceRptInfo.usages)
+                   + (sizeof(HID_USAGEINDEX) * deviceRptInfo.usages)
                    + (sizeof(HID_STRINGITEM) * deviceRptInfo.strings)
                    + (sizeof(HID_DESIGITEM) * deviceRptInfo.designators)
                    + (sizeof(int) * deviceRptInfo.maxCollectionNesting)
                    + (sizeof(HID_GLOBALS) * deviceRptInfo.maxGlobalsNesting);
 
+#ifdef USB_HID_MAX_PARSER_MEMORY
+    /* The raw descriptor is still held while the tables are filled in */
+    if (sizeRequired + lengthOfDescriptor > USB_HID_MAX_PARSER_MEMORY) return(HID_ERR_NotEnoughMemory);
+#endif
+
     if (parsedDataMem != NULL)
     {
 		USB_FREE_AND_CLEAR( parsedDataMem );
@@ -322,22 +338,26 @@ USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , u
     if (parsedDataMem == NULL) return(HID_ERR_NotEnoughMemory); /* Error: Not enough memory */
     assignMem = (uint8_t*) parsedDataMem;
     
-    /* Allocate Space */   
+    /* Allocate Space , lists with 32 bit members first to keep them aligned */
     itemListPtrs.collectionList = (HID_COLLECTION *) assignMem;
     assignMem += (sizeof(HID_COLLECTION) * deviceRptInfo.collections);
     itemListPtrs.reportItemList = (HID_REPORTITEM *) assignMem;
     assignMem += (sizeof(HID_REPORTITEM) * deviceRptInfo.reportItems);
+    itemListPtrs.fieldList = (HID_FIELD *) assignMem;
+    assignMem += (sizeof(HID_FIELD) * deviceRptInfo.reportItems);
+    itemListPtrs.globalsStack = (HID_GLOBALS *) assignMem;
+    assignMem += (sizeof(HID_GLOBALS) * deviceRptInfo.maxGlobalsNesting);
     itemListPtrs.reportList = (HID_REPORT *) assignMem;
     assignMem += (sizeof(HID_REPORT) * deviceRptInfo.reports);
     itemListPtrs.usageItemList = (HID_USAGEITEM *) assignMem;
     assignMem += (sizeof(HID_USAGEITEM) * deviceRptInfo.usages);
+    itemListPtrs.usageIndex = (HID_USAGEINDEX *) assignMem;
+    assignMem += (sizeof(HID_USAGEINDEX) * deviceRptInfo.usages);
     itemListPtrs.stringItemList = (HID_STRINGITEM *) assignMem;
     assignMem += (sizeof(HID_STRINGITEM) * deviceRptInfo.strings);
     itemListPtrs.designatorItemList = (HID_DESIGITEM *) assignMem;
     assignMem += (sizeof(HID_DESIGITEM) * deviceRptInfo.designators);
     itemListPtrs.collectionStack = (uint8_t *) assignMem;
-    assignMem += (sizeof(int) * deviceRptInfo.maxCollectionNesting);
-    itemListPtrs.globalsStack = (HID_GLOBALS *) assignMem;
 
     _USBHostHID_InitDeviceRptInfo();
 
@@ -373,21 +393,9 @@ USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , u
 
     while(len_to_be_parsed > 0)     /* Second parse to fill the tables with each item detail */
     {
-       item.ItemDetails.val = *currentRptDescPtr;
-       item.Data.uItemData = 0;
-
-       ldataSize = item.ItemDetails.ItemSize ;
-       if(item.ItemDetails.ItemSize == 3) 
-           ldataSize = 4; 
-
-       currentRptDescPtr++; /* ptr points to data */
-       for (i = 0; i < ldataSize; i++)
-        {
-            dataByte = *currentRptDescPtr++;  /* signed data will be taken care in ItemTag it is expected */
-            item.Data.uItemData |= ((uint32_t)dataByte << (i*8));
-        }
-    
-       len_to_be_parsed -= (ldataSize+1);   /* remaining bytes = current - (length of current item + 1)*/
+       /* signed data will be taken care in ItemTag it is expected */
+       if (!_USBHostHID_Read_Item(&currentRptDescPtr, &len_to_be_parsed, &item))
+           return(HID_ERR_UnexpectedEndOfDescriptor);
 
        switch(item.ItemDetails.ItemType)
         {
@@ -719,6 +727,9 @@ USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t* hidReportDescriptor , u
         if (itemListPtrs.reportList[i].featureBits == 8) itemListPtrs.reportList[i].featureBits = 0;
     }
 
+    _USBHostHID_Compile_Fields();
+    _USBHostHID_Build_UsageIndex();
+
     return(lhidError);
 }
 
@@ -781,6 +792,100 @@ static void _USBHostHID_InitDeviceRptInfo(void)
 }
 
 
+/****************************************************************************
+  Function:
+    static bool _USBHostHID_Read_Item(uint8_t** pDescriptor, uint16_t* pRemaining,
+                                      HID_ITEM_INFO* item)
+
+  Description:
+    This function is called by _USBHostHID_Parse_Report() to read the next
+    item of the report descriptor and step past it.  Long Items are skipped
+    as a whole; they are returned with no data and type HIDType_Long, which
+    the parser ignores.
+
+  Precondition:
+    *pRemaining is not zero.
+
+  Parameters:
+    uint8_t** pDescriptor - pointer to the current position in the report
+                            descriptor, advanced past the item
+    uint16_t* pRemaining  - number of bytes left in the report descriptor,
+                            reduced by the size of the item
+    HID_ITEM_INFO* item   - returns the item header and its data
+
+  Return Values:
+    true    - The item was read
+    false   - The item runs past the end of the report descriptor
+
+  Remarks:
+    None
+***************************************************************************/
+static bool _USBHostHID_Read_Item(uint8_t** pDescriptor, uint16_t* pRemaining, HID_ITEM_INFO* item)
+{
+    uint8_t* data = *pDescriptor;
+    uint16_t size;
+    uint8_t  i;
+
+    item->ItemDetails.val = data[0];
+    item->Data.uItemData = 0;
+
+    if (data[0] == HIDItem_LongPrefix)
+    {
+        if (*pRemaining < 3)
+            return false;
+        size = 3 + data[1];         /* header, data size, tag and data */
+    }
+    else
+    {
+        size = item->ItemDetails.ItemSize;
+        if (size == 3)
+            size = 4;
+        if (*pRemaining < size + 1)
+            return false;
+        for (i = 0; i < size; i++)
+            item->Data.uItemData |= ((uint32_t)data[i+1] << (i*8));
+        size++;
+    }
+
+    if (*pRemaining < size)
+        return false;
+    *pDescriptor += size;
+    *pRemaining -= size;
+    return true;
+}
+
+
+/****************************************************************************
+  Function:
+    static bool _USBHostHID_Count(uint8_t* counter)
+
+  Description:
+    This function is called by _USBHostHID_Parse_Report() to count an item
+    during the first parse.  The tables index items with a byte, so a count
+    stops at 255.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t* counter - the count to increment
+
+  Return Values:
+    true    - The count was incremented
+    false   - The count is already 255
+
+  Remarks:
+    None
+***************************************************************************/
+static bool _USBHostHID_Count(uint8_t* counter)
+{
+    if (*counter == 0xFF)
+        return false;
+    (*counter)++;
+    return true;
+}
+
+
 /****************************************************************************
   Function:
     static void _USBHostHID_Parse_Collection(HID_ITEM_INFO* ptrItem)
@@ -894,20 +999,36 @@ static USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_ReportType(HID_ITEM_INFO* item)
     HID_REPORTITEM *lreportItem = NULL;
     HID_REPORT *lreport = NULL;
     uint16_t bits = 0;
+    uint16_t used = 0;
 
     if(item == NULL)
         return(HID_ERR_NullPointer);
    
 //  Reality Check on the Report Main Item
 
-    if (deviceRptInfo.globals.logicalMinimum >= ((int32_t)1<<deviceRptInfo.globals.reportsize)) return(HID_ERR_BadLogicalMin) ;
-    if (deviceRptInfo.globals.logicalMaximum >= ((int32_t)1<<deviceRptInfo.globals.reportsize))return(HID_ERR_BadLogicalMax);
+    if (deviceRptInfo.globals.reportsize < 31)
+    {
+        if (deviceRptInfo.globals.logicalMinimum >= ((int32_t)1<<deviceRptInfo.globals.reportsize)) return(HID_ERR_BadLogicalMin) ;
+        if (deviceRptInfo.globals.logicalMaximum >= ((int32_t)1<<deviceRptInfo.globals.reportsize))return(HID_ERR_BadLogicalMax);
+    }
     // The barcode scanner has this issue.  We'll ignore it.
 	// if (deviceRptInfo.globals.logicalMinimum > deviceRptInfo.globals.logicalMaximum)return(HID_ERR_BadLogical); 
     if (deviceRptInfo.haveUsageMin || deviceRptInfo.haveUsageMax)return(HID_ERR_UnmatchedUsageRange);
     if (deviceRptInfo.haveStringMin || deviceRptInfo.haveStringMax)return(HID_ERR_UnmatchedStringRange);
     if (deviceRptInfo.haveDesignatorMin || deviceRptInfo.haveDesignatorMax)return(HID_ERR_UnmatchedDesignatorRange);
 
+//  The report must stay within 65535 bits
+
+    lreport = &itemListPtrs.reportList[deviceRptInfo.globals.reportIndex];
+    bits = deviceRptInfo.globals.reportsize * deviceRptInfo.globals.reportCount;
+    if (item->ItemDetails.ItemTag == HIDTag_Feature)
+        used = lreport->featureBits;
+    else if (item->ItemDetails.ItemTag == HIDTag_Output)
+        used = lreport->outputBits;
+    else
+        used = lreport->inputBits;
+    if ((uint32_t)used + bits > 0xFFFF) return(HID_ERR_ReportTooLong);
+
 //  Initialize the new Report Item structure
 
     lreportItem = &itemListPtrs.reportItemList[deviceRptInfo.reportItems++];
@@ -926,8 +1047,6 @@ static USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_ReportType(HID_ITEM_INFO* item)
 
 //  Update the Report by the size of this item
 
-    lreport = &itemListPtrs.reportList[deviceRptInfo.globals.reportIndex];
-    bits = deviceRptInfo.globals.reportsize * deviceRptInfo.globals.reportCount;
     switch (item->ItemDetails.ItemTag) 
     {
         case HIDTag_Feature:
@@ -953,6 +1072,228 @@ static USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_ReportType(HID_ITEM_INFO* item)
     return HID_ERR;
 }
 
+/****************************************************************************
+  Function:
+    static void _USBHostHID_Compile_Fields(void)
+
+  Description:
+    This function is called by _USBHostHID_Parse_Report() once the report
+    items are complete.  It compiles every data item into a HID_FIELD, so
+    that a report can later be imported with one pass of shifts and masks,
+    without looking at the report items again.  The fields are stored
+    grouped by report and report type, in report order.
+
+  Precondition:
+    The report descriptor has been parsed without error.
+
+  Parameters:
+    None
+
+  Return Values:
+    None
+
+  Remarks:
+    Constant items (padding) and items without data are not compiled.
+***************************************************************************/
+static void _USBHostHID_Compile_Fields(void)
+{
+    HID_REPORTITEM *lreportItem;
+    HID_USAGEITEM *lusageItem;
+    HID_FIELD *lfield;
+    HID_REPORT *lreport;
+    int64_t scale;
+    int64_t logicalRange;
+    uint8_t reportIndex;
+    uint8_t iR;
+    uint8_t type;
+
+    deviceRptInfo.fields = 0;
+    lfield = itemListPtrs.fieldList;
+
+    for (reportIndex = 0; reportIndex < deviceRptInfo.reports; reportIndex++)
+    {
+        lreport = &itemListPtrs.reportList[reportIndex];
+        for (type = hidReportInput; type < hidReportUnknown; type++)
+        {
+            lreport->firstField[type] = deviceRptInfo.fields;
+            for (iR = 0; iR < deviceRptInfo.reportItems; iR++)
+            {
+                lreportItem = &itemListPtrs.reportItemList[iR];
+                if ((lreportItem->reportType != type) || (lreportItem->globals.reportIndex != reportIndex) ||
+                    (lreportItem->dataModes & HIDData_Constant) || (lreportItem->globals.reportCount == 0) ||
+                    (lreportItem->globals.reportsize == 0))
+                {
+                    continue;
+                }
+
+                lfield->bitOffset = lreportItem->startBit;
+                lfield->bitLength = lreportItem->globals.reportsize;
+                lfield->count = lreportItem->globals.reportCount;
+                lfield->usagePage = lreportItem->globals.usagePage;
+                lfield->usage = 0;
+                if (lreportItem->usageItems != 0)
+                {
+                    lusageItem = &itemListPtrs.usageItemList[lreportItem->firstUsageItem];
+                    lfield->usagePage = lusageItem->usagePage;
+                    lfield->usage = lusageItem->isRange ? lusageItem->usageMinimum : lusageItem->usage;
+                }
+
+                lfield->flags = 0;
+                if (lreportItem->globals.logicalMinimum < 0)
+                    lfield->flags |= HID_FIELD_SIGNED;
+                if ((lreportItem->dataModes & HIDData_VariableBit) == HIDData_Array)
+                    lfield->flags |= HID_FIELD_ARRAY;
+                if (lreportItem->dataModes & HIDData_Relative)
+                    lfield->flags |= HID_FIELD_RELATIVE;
+                if (((lfield->bitOffset & 7) == 0) &&
+                    ((lfield->bitLength == 8) || (lfield->bitLength == 16) || (lfield->bitLength == 32)))
+                    lfield->flags |= HID_FIELD_ALIGNED;
+
+//              Physical = physicalMinimum + (logical - logicalMinimum) * scale.  With
+//              no physical extent, physical units are the same as logical units.
+
+                lfield->logicalMinimum = lreportItem->globals.logicalMinimum;
+                lfield->physicalMinimum = lreportItem->globals.logicalMinimum;
+                lfield->scale = (int32_t)1 << 16;
+                logicalRange = (int64_t)lreportItem->globals.logicalMaximum - lreportItem->globals.logicalMinimum;
+                if (((lreportItem->globals.physicalMinimum != 0) || (lreportItem->globals.physicalMaximum != 0)) &&
+                    (logicalRange != 0))
+                {
+                    scale = ((int64_t)lreportItem->globals.physicalMaximum - lreportItem->globals.physicalMinimum) * 65536 / logicalRange;
+                    if (scale > INT32_MAX) scale = INT32_MAX;
+                    if (scale < INT32_MIN) scale = INT32_MIN;
+                    lfield->physicalMinimum = lreportItem->globals.physicalMinimum;
+                    lfield->scale = (int32_t)scale;
+                    lfield->flags |= HID_FIELD_SCALED;
+                }
+
+                lfield++;
+                deviceRptInfo.fields++;
+            }
+            lreport->fields[type] = deviceRptInfo.fields - lreport->firstField[type];
+        }
+    }
+}
+
+
+/****************************************************************************
+  Function:
+    static void _USBHostHID_Build_UsageIndex(void)
+
+  Description:
+    This function is called by _USBHostHID_Parse_Report() once the report
+    items are complete.  It adds every usage item of every report item to
+    the usage index, keeping the index sorted by report type, usage page and
+    first usage, and then records for each entry the highest usage reached
+    by the entries before it on the same page.
+
+  Precondition:
+    The report descriptor has been parsed without error.
+
+  Parameters:
+    None
+
+  Return Values:
+    None
+
+  Remarks:
+    Entries with equal keys stay in report item order, so a lookup that
+    prefers the lowest report item matches USBHostHID_HasUsage().
+***************************************************************************/
+static void _USBHostHID_Build_UsageIndex(void)
+{
+    HID_REPORTITEM *lreportItem;
+    HID_USAGEITEM *lusageItem;
+    HID_USAGEINDEX entry;
+    HID_USAGEINDEX *lindex;
+    uint16_t usageIndex;
+    int16_t usages;
+    uint8_t iR;
+    uint8_t i;
+    uint8_t j;
+
+    deviceRptInfo.usageIndexes = 0;
+    lindex = itemListPtrs.usageIndex;
+
+    for (iR = 0; iR < deviceRptInfo.reportItems; iR++)
+    {
+        lreportItem = &itemListPtrs.reportItemList[iR];
+        usageIndex = 0;
+        for (i = 0; i < lreportItem->usageItems; i++)
+        {
+            lusageItem = &itemListPtrs.usageItemList[lreportItem->firstUsageItem + i];
+            entry.usagePage = lusageItem->usagePage;
+            entry.firstIndex = usageIndex;
+            entry.reportItem = iR;
+            entry.usageItem = lreportItem->firstUsageItem + i;
+            entry.reportType = lreportItem->reportType;
+            if (lusageItem->isRange)
+            {
+                entry.usageMinimum = lusageItem->usageMinimum;
+                entry.usageMaximum = lusageItem->usageMaximum;
+                usages = lusageItem->usageMaximum - lusageItem->usageMinimum + 1;
+                if (usages < 0) usages = -usages;
+                usageIndex += usages;
+            }
+            else
+            {
+                entry.usageMinimum = lusageItem->usage;
+                entry.usageMaximum = lusageItem->usage;
+                usageIndex++;
+            }
+
+//          Insert in order; descriptors have few usage items
+
+            for (j = deviceRptInfo.usageIndexes; (j > 0) && _USBHostHID_UsageIndexBefore(&entry, &lindex[j-1]); j--)
+                lindex[j] = lindex[j-1];
+            lindex[j] = entry;
+            deviceRptInfo.usageIndexes++;
+        }
+    }
+
+    for (j = 0; j < deviceRptInfo.usageIndexes; j++)
+    {
+        lindex[j].reach = lindex[j].usageMaximum;
+        if ((j > 0) && (lindex[j-1].reportType == lindex[j].reportType) &&
+            (lindex[j-1].usagePage == lindex[j].usagePage) && (lindex[j-1].reach > lindex[j].reach))
+        {
+            lindex[j].reach = lindex[j-1].reach;
+        }
+    }
+}
+
+
+/****************************************************************************
+  Function:
+    static bool _USBHostHID_UsageIndexBefore(HID_USAGEINDEX *a, HID_USAGEINDEX *b)
+
+  Description:
+    This function compares the keys of two usage index entries.
+
+  Precondition:
+    None
+
+  Parameters:
+    HID_USAGEINDEX *a   - First entry
+    HID_USAGEINDEX *b   - Second entry
+
+  Return Values:
+    true    - a sorts before b
+    false   - a sorts with or after b
+
+  Remarks:
+    None
+***************************************************************************/
+static bool _USBHostHID_UsageIndexBefore(HID_USAGEINDEX *a, HID_USAGEINDEX *b)
+{
+    if (a->reportType != b->reportType)
+        return (a->reportType < b->reportType);
+    if (a->usagePage != b->usagePage)
+        return (a->usagePage < b->usagePage);
+    return (a->usageMinimum < b->usageMinimum);
+}
+
+
 /****************************************************************************
   Function:
     static void _USBHostHID_ConvertDataToSigned(HID_ITEM_INFO* item)
@@ -990,7 +1331,7 @@ static void _USBHostHID_ConvertDataToSigned(HID_ITEM_INFO* item)
        if ((dataByte & 0x80) != 0)
        {
            while (index < sizeof(int32_t))
-                item->Data.sItemData |= (0xFF << ((index++)*8)); /* extend one */
+                item->Data.uItemData |= ((uint32_t)0xFF << ((index++)*8)); /* extend one */
        }
     }
 }
@@ -1116,6 +1457,123 @@ bool USBHostHID_HasUsage(HID_REPORTITEM *reportItem,uint16_t usagePage, uint16_t
     return false;
 }
 
+
+/****************************************************************************
+  Function:
+    bool USBHostHID_FindUsage(uint16_t usagePage, uint16_t usage,
+                HIDReportTypeEnum type, uint8_t options, uint8_t *preportItem,
+                uint16_t *pindex)
+
+  Description:
+    This function locates the first report item of the given type that has
+    the usage.  A binary search finds the last index entry of the page that
+    starts at or below the usage; the entries before it are then checked
+    until none of them can reach the usage.  Of the matches, the first usage
+    item of the lowest report item wins.
+
+  Precondition:
+    The report descriptor has been parsed.
+
+  Parameters:
+    uint16_t usagePage          - Usage page, or 0 to match any page
+    uint16_t usage              - Usage to be searched
+    HIDReportTypeEnum type      - Report type Input/Output/Feature
+    uint8_t options             - HID_FIND_xxx, report items to skip
+    uint8_t *preportItem        - returns the index of the report item
+    uint16_t *pindex            - returns the usage index within the report item
+
+  Return Values:
+    bool                       - false - If requested usage is not found
+                                 true  - if requested usage is found
+  Remarks:
+    With usagePage 0 every entry of the report type is checked.
+***************************************************************************/
+bool USBHostHID_FindUsage(uint16_t usagePage, uint16_t usage, HIDReportTypeEnum type, uint8_t options,
+                uint8_t *preportItem, uint16_t *pindex)
+{
+    HID_USAGEINDEX *lindex;
+    HID_REPORTITEM *lreportItem;
+    uint16_t index;
+    bool found;
+    uint8_t reportItem;
+    uint8_t usageItem;
+    uint8_t low;
+    uint8_t high;
+    uint8_t middle;
+
+//  Disallow Null Pointers
+
+    if ((preportItem == NULL) || (pindex == NULL))
+        return false;
+
+//  Find the first entry past the usage, or scan the whole table for any page
+
+    low = 0;
+    high = deviceRptInfo.usageIndexes;
+    if (usagePage == 0)
+    {
+        low = high;
+    }
+    else
+    {
+        while (low < high)
+        {
+            middle = low + (high - low) / 2;
+            lindex = &itemListPtrs.usageIndex[middle];
+            if ((lindex->reportType < type) ||
+                ((lindex->reportType == type) && ((lindex->usagePage < usagePage) ||
+                ((lindex->usagePage == usagePage) && (lindex->usageMinimum <= usage)))))
+                low = middle + 1;
+            else
+                high = middle;
+        }
+    }
+
+//  Walk back through the entries that can hold the usage, keeping the one
+//  of the lowest report item
+
+    found = false;
+    reportItem = 0;
+    usageItem = 0;
+    index = 0;
+    while (low-- > 0)
+    {
+        lindex = &itemListPtrs.usageIndex[low];
+        if (usagePage != 0)
+        {
+            if ((lindex->reportType != type) || (lindex->usagePage != usagePage) || (lindex->reach < usage))
+                break;
+        }
+        else if (lindex->reportType != type)
+            continue;
+
+        if ((usage < lindex->usageMinimum) || (usage > lindex->usageMaximum))
+            continue;
+
+        lreportItem = &itemListPtrs.reportItemList[lindex->reportItem];
+        if ((options & HID_FIND_NO_ARRAYS) && ((lreportItem->dataModes & HIDData_ArrayBit) == HIDData_Array))
+            continue;
+        if ((options & HID_FIND_NO_BITS) && (lreportItem->globals.reportsize == 1))
+            continue;
+
+        if (!found || (lindex->reportItem < reportItem) ||
+            ((lindex->reportItem == reportItem) && (lindex->usageItem < usageItem)))
+        {
+            found = true;
+            reportItem = lindex->reportItem;
+            usageItem = lindex->usageItem;
+            index = lindex->firstIndex + (usage - lindex->usageMinimum);
+        }
+    }
+
+    if (!found)
+        return false;
+
+    *preportItem = reportItem;
+    *pindex = index;
+    return true;
+}
+
 #ifdef DEBUG_MODE
 void USBHID_ReportDecriptor_Dump(void)
 {
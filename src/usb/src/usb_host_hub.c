@@ -0,0 +1,1071 @@
+/******************************************************************************
+
+  USB Host Hub Client Driver
+
+This is the Hub Class Client driver file for a USB Embedded Host device.
+This file should be used in a project with usb_host.c to provide the USB
+hardware interface.
+
+To interface with usb_host.c, the routine USBHostHubInitialize() should be
+specified as the Initialize() function, USBHostHubEventHandler() should be
+specified as the EventHandler() function, and USBHostHubDataEventHandler()
+should be specified as the DataEventHandler() function in the
+usbClientDrvTable[] array declared in usb_config.h.  The TPL entry is the hub
+class, INIT_CL_SC_P( 9ul, 0ul, 0ul ) with TPL_CLASS_DRV.
+
+The driver reads the hub descriptor, powers the downstream ports, and polls
+the status change endpoint.  When a device connects, the port is debounced
+and reset, and the device is handed to the host layer with
+USBHostHubPortAttach().  usb_host.c gives it an entry in its device table,
+enumerates it, assigns it an address, and starts its client drivers, which
+then run alongside those of the other devices on the hub.
+EVENT_HUB_PORT_ATTACH is sent to the application with the speed of the
+device.  Removal, port disable, and overcurrent detach the device with
+USBHostHubPortDetach() and are reported the same way.
+
+Only one device may be at address 0, so a port is not reset while the
+device of another port is still being given its address (see
+USBHostHubPortBusy()).  The hub must be on the root port; hubs behind the
+hub are not supported.
+
+A failed hub request (a STALL, or a bus error) is tried again after
+USB_HUB_RETRY_MS.  If the same step fails USB_HUB_MAX_RETRIES times in a
+row, the driver starts over from the hub descriptor: the devices on the
+ports are reported detached, and the ports are powered and scanned again.
+A STALL on the status change endpoint is cleared with CLEAR_FEATURE
+(ENDPOINT_HALT).
+
+USBHostHubTasks() runs the state machine and must be called periodically.
+The power-on, debounce, and reset recovery delays are timed with EVENT_1MS,
+so USB_ENABLE_1MS_EVENT and USB_HOST_APP_DATA_EVENT_HANDLER must be defined.
+USB_HUB_SUPPORT_INCLUDED must be defined so that the host layer does not
+reject the hub during enumeration.
+
+* FileName:        usb_host_hub.c
+* Dependencies:    None
+* Processor:       PIC24/dsPIC30/dsPIC33/PIC32MX
+* Compiler:        C30/C32
+* Company:         Microchip Technology, Inc.
+
+Software License Agreement
+
+The software supplied herewith by Microchip Technology Incorporated
+(the "Company") for its PICmicro(R) Microcontroller is intended and
+supplied to you, the Company's customer, for use solely and
+exclusively on Microchip PICmicro Microcontroller products. The
+software is owned by the Company and/or its supplier, and is
+protected under applicable copyright laws. All rights are reserved.
+Any use in violation of the foregoing restrictions may subject the
+user to criminal sanctions under applicable laws, as well as to
+civil liability for the breach of the terms and conditions of this
+license.
+
+THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+
+*******************************************************************************/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <usb/usb.h>
+#include <usb/usb_host_hub.h>
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* Confirm Configuration
+
+Ensure that all of the proper configurations have been set up for this client
+driver.
+*/
+
+#ifndef USB_SUPPORT_INTERRUPT_TRANSFERS
+    #error The Hub Client Driver requires interrupt transfers.
+#endif
+
+#if !defined( USB_ENABLE_1MS_EVENT ) || !defined( USB_HOST_APP_DATA_EVENT_HANDLER )
+    #error The Hub Client Driver requires the 1ms event.
+#endif
+
+#ifndef USB_HUB_SUPPORT_INCLUDED
+    #error The Hub Client Driver requires USB_HUB_SUPPORT_INCLUDED.
+#endif
+
+#if (USB_MAX_HUB_PORTS < 1) || (USB_MAX_HUB_PORTS > 15)
+    #error USB_MAX_HUB_PORTS must be between 1 and 15.
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Constants
+// *****************************************************************************
+// *****************************************************************************
+
+#define USB_HUB_DESCRIPTOR_SIZE             (7 + 2 * ((USB_MAX_HUB_PORTS + 8) / 8))    // Hub descriptor up to PortPwrCtrlMask.
+#define USB_HUB_CHANGE_BITMAP_SIZE          4       // Status change bitmap, enough for hubs with up to 31 ports.
+
+#define USB_HUB_DEBOUNCE_MS                 100     // Connection debounce interval (TATTDB).
+#define USB_HUB_RESET_RECOVERY_MS           10      // Reset recovery time (TRSTRCY).
+#define USB_HUB_RETRY_MS                    100     // Wait before a failed request is tried again.
+#define USB_HUB_MAX_RETRIES                 3       // Failures in a row before the hub is set up again.
+
+// *****************************************************************************
+// Section: State Machine Constants
+// *****************************************************************************
+
+#define HUB_STATE_DETACHED                  0x00
+#define HUB_STATE_GET_DESCRIPTOR            0x01
+#define HUB_STATE_WAIT_DESCRIPTOR           0x02
+#define HUB_STATE_POWER_PORT                0x03
+#define HUB_STATE_WAIT_POWER_PORT           0x04
+#define HUB_STATE_WAIT_POWER_GOOD           0x05
+#define HUB_STATE_READ_CHANGES              0x06
+#define HUB_STATE_WAIT_CHANGES              0x07
+#define HUB_STATE_GET_STATUS                0x08
+#define HUB_STATE_WAIT_STATUS               0x09
+#define HUB_STATE_CLEAR_CHANGE              0x0A
+#define HUB_STATE_WAIT_CLEAR_CHANGE         0x0B
+#define HUB_STATE_WAIT_DEBOUNCE             0x0C
+#define HUB_STATE_RESET_PORT                0x0D
+#define HUB_STATE_WAIT_RESET_PORT           0x0E
+#define HUB_STATE_WAIT_RESET_RECOVERY       0x0F
+#define HUB_STATE_WAIT_RETRY                0x10
+#define HUB_STATE_CLEAR_HALT                0x11
+#define HUB_STATE_WAIT_CLEAR_HALT           0x12
+#define HUB_STATE_ERROR                     0xFF
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Structures
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* Hub Device Information
+
+This structure holds the state of the attached hub.  Port n is tracked in
+entry n-1 of the port arrays; in the port bitmaps, bit 0 is the hub itself
+and bit n is port n, as in the status change bitmap sent by the hub.
+*/
+typedef struct _USB_HUB_DEVICE
+{
+    uint8_t             deviceAddress;                          // Address of the hub, 0 if none is attached.
+    uint8_t             clientDriverID;                         // Client driver ID for device requests.
+    uint8_t             endpointIn;                             // Status change endpoint.
+    uint8_t             state;                                  // HUB_STATE_xxx
+    uint8_t             retryState;                             // State that started the last request.
+    uint8_t             errorCount;                             // Requests failed in a row.
+    uint8_t             hubPorts;                               // Number of ports on the hub (bNbrPorts).
+    uint8_t             numPorts;                               // Number of ports managed.
+    uint8_t             powerOnDelay;                           // bPwrOn2PwrGood, in 2ms units.
+    uint8_t             currentPort;                            // Port being serviced, 0 for the hub itself.
+    uint16_t            pendingPorts;                           // Ports with a status change still to service.
+    uint16_t            portStatus;                             // wPortStatus (or wHubStatus) of currentPort.
+    uint16_t            portChange;                             // Change bits of currentPort still to clear.
+    uint16_t            portChangeSeen;                         // Change bits read for currentPort.
+    volatile uint16_t   msDelay;                                // Counted down by EVENT_1MS.
+    uint8_t             portState[USB_MAX_HUB_PORTS];           // USB_HUB_PORT_xxx
+    uint8_t             portSpeed[USB_MAX_HUB_PORTS];           // USB_HUB_PORT_SPEED_xxx
+    uint8_t             buffer[USB_HUB_DESCRIPTOR_SIZE];        // Control transfer data.
+    uint8_t             changeBitmap[USB_HUB_CHANGE_BITMAP_SIZE];   // Status change endpoint data.
+} USB_HUB_DEVICE;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Global Variables
+// *****************************************************************************
+// *****************************************************************************
+
+static USB_HUB_DEVICE   hubDevice;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Prototypes
+// *****************************************************************************
+// *****************************************************************************
+
+static void _USBHostHub_DetachPort( uint8_t port );
+static void _USBHostHub_Failed( void );
+static void _USBHostHub_NextPort( void );
+static void _USBHostHub_NotifyPort( USB_EVENT event, uint8_t port );
+static void _USBHostHub_PortChanged( void );
+static bool _USBHostHub_RequestDone( void );
+static void _USBHostHub_StartRequest( uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue,
+                uint16_t wIndex, uint16_t wLength, uint8_t dataDirection, uint8_t nextState );
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Application Callable Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostHubPortStatus( uint8_t deviceAddress, uint8_t port )
+
+  Summary:
+    This function returns the state of a hub port.
+
+  Description:
+    This function returns the state of a downstream port of the hub.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress  - Address of the hub
+    uint8_t port           - Port number, starting at 1
+
+  Return Values:
+    USB_HUB_PORT_xxx            - State of the port
+    USB_HUB_DEVICE_NOT_FOUND    - No hub with this address is attached
+    USB_HUB_ILLEGAL_PORT        - The port is not managed
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint8_t USBHostHubPortStatus( uint8_t deviceAddress, uint8_t port )
+{
+    if ((deviceAddress == 0) || (hubDevice.deviceAddress != deviceAddress))
+    {
+        return USB_HUB_DEVICE_NOT_FOUND;
+    }
+    if ((port == 0) || (port > USB_MAX_HUB_PORTS))
+    {
+        return USB_HUB_ILLEGAL_PORT;
+    }
+
+    return hubDevice.portState[port-1];
+}
+
+
+/****************************************************************************
+  Function:
+    void USBHostHubTasks( void )
+
+  Summary:
+    This function performs the maintenance tasks of the hub client driver.
+
+  Description:
+    This function runs the hub state machine: it reads the hub descriptor,
+    powers the ports, polls the status change endpoint, and debounces and
+    resets ports as devices connect.  It must be called periodically,
+    whether or not transfer events are enabled.
+
+  Precondition:
+    USBHostHubInitialize() has been called.
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    A request the hub fails is tried again; if it keeps failing, the hub
+    is set up again from its descriptor.
+  ***************************************************************************/
+
+void USBHostHubTasks( void )
+{
+    uint8_t     errorCode;
+    uint32_t    byteCount;
+    uint8_t     recipient;
+    uint8_t     feature;
+    uint8_t     bit;
+
+    if ((hubDevice.deviceAddress == 0) ||
+        (USBHostDeviceStatus( hubDevice.deviceAddress ) != USB_DEVICE_ATTACHED))
+    {
+        return;
+    }
+
+    recipient = (hubDevice.currentPort == 0) ? USB_SETUP_RECIPIENT_DEVICE : USB_SETUP_RECIPIENT_OTHER;
+
+    switch (hubDevice.state)
+    {
+        case HUB_STATE_GET_DESCRIPTOR:
+            _USBHostHub_StartRequest( USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_CLASS | USB_SETUP_RECIPIENT_DEVICE,
+                    USB_REQUEST_GET_DESCRIPTOR, (uint16_t)USB_HUB_DESCRIPTOR << 8, 0, USB_HUB_DESCRIPTOR_SIZE,
+                    USB_DEVICE_REQUEST_GET, HUB_STATE_WAIT_DESCRIPTOR );
+            break;
+
+        case HUB_STATE_WAIT_DESCRIPTOR:
+            if (_USBHostHub_RequestDone())
+            {
+                hubDevice.hubPorts      = hubDevice.buffer[2];
+                hubDevice.powerOnDelay  = hubDevice.buffer[5];
+                hubDevice.numPorts      = hubDevice.hubPorts;
+                if (hubDevice.numPorts > USB_MAX_HUB_PORTS)
+                {
+                    hubDevice.numPorts = USB_MAX_HUB_PORTS;
+                }
+
+                if (hubDevice.numPorts == 0)
+                {
+                    // Nothing to manage.
+                    hubDevice.state = HUB_STATE_ERROR;
+                }
+                else
+                {
+                    hubDevice.currentPort = 1;
+                    hubDevice.state       = HUB_STATE_POWER_PORT;
+                }
+            }
+            break;
+
+        case HUB_STATE_POWER_PORT:
+            _USBHostHub_StartRequest( USB_SETUP_HOST_TO_DEVICE | USB_SETUP_TYPE_CLASS | USB_SETUP_RECIPIENT_OTHER,
+                    USB_REQUEST_SET_FEATURE, USB_HUB_FEATURE_PORT_POWER, hubDevice.currentPort, 0,
+                    USB_DEVICE_REQUEST_SET, HUB_STATE_WAIT_POWER_PORT );
+            break;
+
+        case HUB_STATE_WAIT_POWER_PORT:
+            if (_USBHostHub_RequestDone())
+            {
+                hubDevice.currentPort ++;
+                if (hubDevice.currentPort <= hubDevice.numPorts)
+                {
+                    hubDevice.state = HUB_STATE_POWER_PORT;
+                }
+                else
+                {
+                    // Once the power is good, every port is read, so devices
+                    // already plugged in are found.
+                    hubDevice.currentPort = 0;
+                    hubDevice.msDelay     = 2 * (uint16_t)hubDevice.powerOnDelay;
+                    hubDevice.state       = HUB_STATE_WAIT_POWER_GOOD;
+                }
+            }
+            break;
+
+        case HUB_STATE_WAIT_POWER_GOOD:
+            if (hubDevice.msDelay == 0)
+            {
+                hubDevice.pendingPorts = ((2u << hubDevice.numPorts) - 1) & ~1u;
+                _USBHostHub_NextPort();
+            }
+            break;
+
+        case HUB_STATE_READ_CHANGES:
+            memset( hubDevice.changeBitmap, 0, USB_HUB_CHANGE_BITMAP_SIZE );
+            errorCode = USBHostRead( hubDevice.deviceAddress, hubDevice.endpointIn, hubDevice.changeBitmap,
+                    ((hubDevice.hubPorts + 8) / 8 < USB_HUB_CHANGE_BITMAP_SIZE) ? (hubDevice.hubPorts + 8) / 8 : USB_HUB_CHANGE_BITMAP_SIZE );
+            if (errorCode == USB_SUCCESS)
+            {
+                hubDevice.state = HUB_STATE_WAIT_CHANGES;
+            }
+            else if (errorCode != USB_ENDPOINT_BUSY)
+            {
+                hubDevice.retryState = HUB_STATE_READ_CHANGES;
+                _USBHostHub_Failed();
+            }
+            break;
+
+        case HUB_STATE_WAIT_CHANGES:
+            // The hub NAKs the status change endpoint until something changes.
+            if (USBHostTransferIsComplete( hubDevice.deviceAddress, hubDevice.endpointIn, &errorCode, &byteCount ))
+            {
+                if (errorCode == USB_ENDPOINT_STALLED)
+                {
+                    USBHostClearEndpointErrors( hubDevice.deviceAddress, hubDevice.endpointIn );
+                    hubDevice.retryState = HUB_STATE_CLEAR_HALT;
+                    _USBHostHub_Failed();
+                }
+                else if (errorCode)
+                {
+                    USBHostClearEndpointErrors( hubDevice.deviceAddress, hubDevice.endpointIn );
+                    hubDevice.state = HUB_STATE_READ_CHANGES;
+                }
+                else
+                {
+                    hubDevice.pendingPorts = ((uint16_t)hubDevice.changeBitmap[1] << 8) | hubDevice.changeBitmap[0];
+                    hubDevice.pendingPorts &= (2u << hubDevice.numPorts) - 1;
+                    _USBHostHub_NextPort();
+                }
+            }
+            break;
+
+        case HUB_STATE_GET_STATUS:
+            _USBHostHub_StartRequest( USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_CLASS | recipient,
+                    USB_REQUEST_GET_STATUS, 0, hubDevice.currentPort, 4,
+                    USB_DEVICE_REQUEST_GET, HUB_STATE_WAIT_STATUS );
+            break;
+
+        case HUB_STATE_WAIT_STATUS:
+            if (_USBHostHub_RequestDone())
+            {
+                hubDevice.portStatus        = ((uint16_t)hubDevice.buffer[1] << 8) | hubDevice.buffer[0];
+                hubDevice.portChange        = ((uint16_t)hubDevice.buffer[3] << 8) | hubDevice.buffer[2];
+                hubDevice.portChangeSeen    = hubDevice.portChange;
+                hubDevice.state             = HUB_STATE_CLEAR_CHANGE;
+
+                // A device on a port the driver has as empty is new, whether
+                // or not the hub flagged the connection, as after power-on.
+                if ((hubDevice.currentPort != 0) &&
+                    (hubDevice.portState[hubDevice.currentPort-1] == USB_HUB_PORT_EMPTY) &&
+                    (hubDevice.portStatus & USB_HUB_PORT_STATUS_CONNECTION))
+                {
+                    hubDevice.portChangeSeen |= USB_HUB_PORT_CHANGE_CONNECTION;
+                }
+            }
+            break;
+
+        case HUB_STATE_CLEAR_CHANGE:
+            if (hubDevice.portChange == 0)
+            {
+                _USBHostHub_PortChanged();
+                break;
+            }
+
+            // Acknowledge the lowest change bit.  The C_PORT_xxx features are
+            // the wPortChange bit number + 16; the C_HUB_xxx features are the
+            // wHubChange bit number.
+            for (bit=0; (hubDevice.portChange & (1u << bit)) == 0; bit++) {}
+            feature = bit;
+            if (hubDevice.currentPort != 0)
+            {
+                feature += USB_HUB_FEATURE_C_PORT_CONNECTION;
+            }
+
+            _USBHostHub_StartRequest( USB_SETUP_HOST_TO_DEVICE | USB_SETUP_TYPE_CLASS | recipient,
+                    USB_REQUEST_CLEAR_FEATURE, feature, hubDevice.currentPort, 0,
+                    USB_DEVICE_REQUEST_SET, HUB_STATE_WAIT_CLEAR_CHANGE );
+            break;
+
+        case HUB_STATE_WAIT_CLEAR_CHANGE:
+            if (_USBHostHub_RequestDone())
+            {
+                // Drop the lowest change bit, the one just cleared.
+                hubDevice.portChange &= hubDevice.portChange - 1;
+                hubDevice.state = HUB_STATE_CLEAR_CHANGE;
+            }
+            break;
+
+        case HUB_STATE_WAIT_DEBOUNCE:
+            if (hubDevice.msDelay == 0)
+            {
+                hubDevice.state = HUB_STATE_RESET_PORT;
+            }
+            break;
+
+        case HUB_STATE_RESET_PORT:
+            // Wait until the device of the last port reset has its address.
+            if (USBHostHubPortBusy())
+            {
+                break;
+            }
+            hubDevice.portState[hubDevice.currentPort-1] = USB_HUB_PORT_RESETTING;
+            _USBHostHub_StartRequest( USB_SETUP_HOST_TO_DEVICE | USB_SETUP_TYPE_CLASS | USB_SETUP_RECIPIENT_OTHER,
+                    USB_REQUEST_SET_FEATURE, USB_HUB_FEATURE_PORT_RESET, hubDevice.currentPort, 0,
+                    USB_DEVICE_REQUEST_SET, HUB_STATE_WAIT_RESET_PORT );
+            break;
+
+        case HUB_STATE_WAIT_RESET_PORT:
+            // The hub reports the end of the reset with C_PORT_RESET on the
+            // status change endpoint.
+            if (_USBHostHub_RequestDone())
+            {
+                _USBHostHub_NextPort();
+            }
+            break;
+
+        case HUB_STATE_WAIT_RESET_RECOVERY:
+            if (hubDevice.msDelay == 0)
+            {
+                if (USBHostHubPortAttach( hubDevice.deviceAddress, hubDevice.currentPort,
+                        hubDevice.portSpeed[hubDevice.currentPort-1] == USB_HUB_PORT_SPEED_LOW ) == USB_BUSY)
+                {
+                    break;
+                }
+                hubDevice.portState[hubDevice.currentPort-1] = USB_HUB_PORT_ENABLED;
+                _USBHostHub_NotifyPort( EVENT_HUB_PORT_ATTACH, hubDevice.currentPort );
+                _USBHostHub_NextPort();
+            }
+            break;
+
+        case HUB_STATE_WAIT_RETRY:
+            if (hubDevice.msDelay == 0)
+            {
+                hubDevice.state = hubDevice.retryState;
+            }
+            break;
+
+        case HUB_STATE_CLEAR_HALT:
+            _USBHostHub_StartRequest( USB_SETUP_HOST_TO_DEVICE | USB_SETUP_TYPE_STANDARD | USB_SETUP_RECIPIENT_ENDPOINT,
+                    USB_REQUEST_CLEAR_FEATURE, USB_FEATURE_ENDPOINT_HALT, hubDevice.endpointIn, 0,
+                    USB_DEVICE_REQUEST_SET, HUB_STATE_WAIT_CLEAR_HALT );
+            break;
+
+        case HUB_STATE_WAIT_CLEAR_HALT:
+            if (_USBHostHub_RequestDone())
+            {
+                hubDevice.state = HUB_STATE_READ_CHANGES;
+            }
+            break;
+
+        case HUB_STATE_ERROR:
+        default:
+            break;
+    }
+}
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Host Stack Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************************
+  Function:
+    bool USBHostHubInitialize( uint8_t address, uint32_t flags, uint8_t clientDriverID )
+
+  Summary:
+    This function is the initialization routine for this client driver.
+
+  Description:
+    This function is the initialization routine for this client driver.  It
+    is called by the host layer when the USB device is being enumerated.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t address        - Address of the new device
+    uint32_t flags         - Initialization flags
+    uint8_t clientDriverID - ID to send when issuing a Device Request via
+                            USBHostIssueDeviceRequest() or USBHostSetDeviceConfiguration().
+
+  Return Values:
+    true   - We can support the device.
+    false  - We cannot support the device.
+
+  Remarks:
+    Device requests cannot be issued until enumeration is complete, so the
+    hub descriptor is read by USBHostHubTasks().
+  ***************************************************************************/
+
+bool USBHostHubInitialize( uint8_t address, uint32_t flags, uint8_t clientDriverID )
+{
+    uint8_t     *pDesc;
+    uint16_t    index;
+    uint16_t    wTotalLength;
+    uint8_t     i;
+
+    if (hubDevice.deviceAddress != 0)
+    {
+        // Only one hub is supported.
+        return false;
+    }
+
+    // Find the status change endpoint, the interrupt IN endpoint of the hub
+    // interface.
+    pDesc        = USBHostGetCurrentConfigurationDescriptor( address );
+    wTotalLength = ((uint16_t)pDesc[3] << 8) | pDesc[2];
+    hubDevice.endpointIn = 0;
+    for (index = 0; (index + 1 < wTotalLength) && (pDesc[index] != 0); index += pDesc[index])
+    {
+        if ((pDesc[index+1] == USB_DESCRIPTOR_ENDPOINT) &&
+            (pDesc[index+2] & USB_IN_EP) &&
+            ((pDesc[index+3] & 0x03) == USB_TRANSFER_TYPE_INTERRUPT))
+        {
+            hubDevice.endpointIn = pDesc[index+2];
+            break;
+        }
+    }
+    if (hubDevice.endpointIn == 0)
+    {
+        return false;
+    }
+
+    hubDevice.deviceAddress     = address;
+    hubDevice.clientDriverID    = clientDriverID;
+    hubDevice.currentPort       = 0;
+    hubDevice.pendingPorts      = 0;
+    hubDevice.errorCount        = 0;
+    hubDevice.msDelay           = 0;
+    for (i=0; i<USB_MAX_HUB_PORTS; i++)
+    {
+        hubDevice.portState[i]  = USB_HUB_PORT_EMPTY;
+        hubDevice.portSpeed[i]  = USB_HUB_PORT_SPEED_FULL;
+    }
+    hubDevice.state             = HUB_STATE_GET_DESCRIPTOR;
+
+    return true;
+}
+
+
+/****************************************************************************
+  Function:
+    bool USBHostHubEventHandler( uint8_t address, USB_EVENT event,
+                            void *data, uint32_t size )
+
+  Summary:
+    This function is the event handler for this client driver.
+
+  Description:
+    This function is the event handler for this client driver.  It is called
+    by the host layer when various events occur.
+
+  Precondition:
+    The device has been initialized.
+
+  Parameters:
+    uint8_t address    - Address of the device
+    USB_EVENT event - Event that has occurred
+    void *data      - Pointer to data pertinent to the event
+    uint32_t size       - Size of the data
+
+  Return Values:
+    true   - Event was handled
+    false  - Event was not handled
+
+  Remarks:
+    Transfer completion is polled by USBHostHubTasks(), so transfer events
+    are only acknowledged here.
+  ***************************************************************************/
+
+bool USBHostHubEventHandler( uint8_t address, USB_EVENT event, void *data, uint32_t size )
+{
+    uint8_t     port;
+
+    if ((address == 0) || (hubDevice.deviceAddress != address))
+    {
+        return false;
+    }
+
+    switch (event)
+    {
+        case EVENT_DETACH:
+            // Everything behind the hub is gone with it.
+            for (port=1; port<=USB_MAX_HUB_PORTS; port++)
+            {
+                _USBHostHub_DetachPort( port );
+                hubDevice.portState[port-1] = USB_HUB_PORT_EMPTY;
+            }
+            hubDevice.deviceAddress = 0;
+            hubDevice.state         = HUB_STATE_DETACHED;
+            return true;
+            break;
+
+        case EVENT_TRANSFER:
+        case EVENT_BUS_ERROR:
+            return true;
+            break;
+
+        default:
+            break;
+    }
+
+    return false;
+}
+
+
+/****************************************************************************
+  Function:
+    bool USBHostHubDataEventHandler( uint8_t address, USB_EVENT event,
+                            void *data, uint32_t size )
+
+  Summary:
+    This function is the data event handler for this client driver.
+
+  Description:
+    This function is the data event handler for this client driver.  It
+    uses EVENT_1MS to time the power-on, debounce, and reset recovery
+    delays.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t address    - Address of the device
+    USB_EVENT event - Event that has occurred
+    void *data      - Pointer to data pertinent to the event
+    uint32_t size       - Size of the data
+
+  Return Values:
+    true   - Event was handled
+    false  - Event was not handled
+
+  Remarks:
+    This is called from the USB interrupt.
+  ***************************************************************************/
+
+bool USBHostHubDataEventHandler( uint8_t address, USB_EVENT event, void *data, uint32_t size )
+{
+    if (event == EVENT_1MS)
+    {
+        if (hubDevice.msDelay != 0)
+        {
+            hubDevice.msDelay --;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Internal Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************************
+  Function:
+    void _USBHostHub_DetachPort( uint8_t port )
+
+  Description:
+    This function removes the device on an enabled port from the host layer
+    and sends EVENT_HUB_PORT_DETACH to the application.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t port    - Port number, starting at 1
+
+  Returns:
+    None
+
+  Remarks:
+    Nothing is done if the port is not enabled.  The caller updates the
+    port state.
+  ***************************************************************************/
+
+static void _USBHostHub_DetachPort( uint8_t port )
+{
+    if (hubDevice.portState[port-1] == USB_HUB_PORT_ENABLED)
+    {
+        USBHostHubPortDetach( hubDevice.deviceAddress, port );
+        _USBHostHub_NotifyPort( EVENT_HUB_PORT_DETACH, port );
+    }
+}
+
+
+/****************************************************************************
+  Function:
+    void _USBHostHub_Failed( void )
+
+  Description:
+    This function handles a failed request to the hub.  The step in
+    retryState is started again after USB_HUB_RETRY_MS.  After
+    USB_HUB_MAX_RETRIES failures in a row, the hub is set up again from the
+    hub descriptor instead.
+
+  Precondition:
+    retryState is the state that started the failed request.
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    When the hub is set up again, devices on enabled ports are reported
+    detached.  They are found again when the ports are scanned after
+    power-on.
+  ***************************************************************************/
+
+static void _USBHostHub_Failed( void )
+{
+    uint8_t     port;
+
+    hubDevice.errorCount ++;
+    if (hubDevice.errorCount > USB_HUB_MAX_RETRIES)
+    {
+        for (port=1; port<=USB_MAX_HUB_PORTS; port++)
+        {
+            _USBHostHub_DetachPort( port );
+            hubDevice.portState[port-1] = USB_HUB_PORT_EMPTY;
+        }
+        hubDevice.errorCount    = 0;
+        hubDevice.pendingPorts  = 0;
+        hubDevice.currentPort   = 0;
+        hubDevice.retryState    = HUB_STATE_GET_DESCRIPTOR;
+    }
+
+    hubDevice.msDelay   = USB_HUB_RETRY_MS;
+    hubDevice.state     = HUB_STATE_WAIT_RETRY;
+}
+
+
+/****************************************************************************
+  Function:
+    void _USBHostHub_NextPort( void )
+
+  Description:
+    This function selects the next port with a pending status change, or
+    goes back to polling the status change endpoint if there is none.
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static void _USBHostHub_NextPort( void )
+{
+    uint8_t     port;
+
+    if (hubDevice.pendingPorts == 0)
+    {
+        hubDevice.state = HUB_STATE_READ_CHANGES;
+        return;
+    }
+
+    for (port=0; (hubDevice.pendingPorts & (1u << port)) == 0; port++) {}
+    hubDevice.pendingPorts  &= ~(1u << port);
+    hubDevice.currentPort   = port;
+    hubDevice.state         = HUB_STATE_GET_STATUS;
+}
+
+
+/****************************************************************************
+  Function:
+    void _USBHostHub_NotifyPort( USB_EVENT event, uint8_t port )
+
+  Description:
+    This function sends a port event to the application.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_EVENT event - EVENT_HUB_PORT_xxx
+    uint8_t port    - Port number, starting at 1
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static void _USBHostHub_NotifyPort( USB_EVENT event, uint8_t port )
+{
+    USB_HUB_PORT_EVENT_DATA     eventData;
+
+    eventData.hubAddress    = hubDevice.deviceAddress;
+    eventData.port          = port;
+    eventData.speed         = hubDevice.portSpeed[port-1];
+
+    USB_HOST_APP_EVENT_HANDLER( hubDevice.deviceAddress, event, &eventData, sizeof(USB_HUB_PORT_EVENT_DATA) );
+}
+
+
+/****************************************************************************
+  Function:
+    void _USBHostHub_PortChanged( void )
+
+  Description:
+    This function acts on the status of the current port once all of its
+    change bits have been cleared.
+
+  Precondition:
+    portStatus and portChangeSeen hold the status read for currentPort.
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    A new connection starts the debounce interval; the end of a reset with
+    the port enabled starts the reset recovery interval.  Both continue in
+    USBHostHubTasks() before the next port is serviced.
+  ***************************************************************************/
+
+static void _USBHostHub_PortChanged( void )
+{
+    uint8_t     i;
+
+    if (hubDevice.currentPort == 0)
+    {
+        // Local power and overcurrent changes of the hub itself need no
+        // action beyond clearing them.
+        _USBHostHub_NextPort();
+        return;
+    }
+
+    i = hubDevice.currentPort - 1;
+
+    if ((hubDevice.portChangeSeen & USB_HUB_PORT_CHANGE_OVER_CURRENT) &&
+        (hubDevice.portStatus & USB_HUB_PORT_STATUS_OVER_CURRENT))
+    {
+        _USBHostHub_DetachPort( hubDevice.currentPort );
+        hubDevice.portState[i] = USB_HUB_PORT_OVERCURRENT;
+        _USBHostHub_NotifyPort( EVENT_HUB_PORT_OVERCURRENT, hubDevice.currentPort );
+    }
+
+    if (hubDevice.portChangeSeen & USB_HUB_PORT_CHANGE_CONNECTION)
+    {
+        _USBHostHub_DetachPort( hubDevice.currentPort );
+
+        if (hubDevice.portStatus & USB_HUB_PORT_STATUS_CONNECTION)
+        {
+            hubDevice.portState[i]  = USB_HUB_PORT_DEBOUNCING;
+            hubDevice.msDelay       = USB_HUB_DEBOUNCE_MS;
+            hubDevice.state         = HUB_STATE_WAIT_DEBOUNCE;
+            return;
+        }
+        hubDevice.portState[i] = USB_HUB_PORT_EMPTY;
+    }
+    else if ((hubDevice.portChangeSeen & USB_HUB_PORT_CHANGE_RESET) &&
+             (hubDevice.portState[i] == USB_HUB_PORT_RESETTING))
+    {
+        if (hubDevice.portStatus & USB_HUB_PORT_STATUS_ENABLE)
+        {
+            if (hubDevice.portStatus & USB_HUB_PORT_STATUS_LOW_SPEED)
+            {
+                hubDevice.portSpeed[i] = USB_HUB_PORT_SPEED_LOW;
+            }
+            else if (hubDevice.portStatus & USB_HUB_PORT_STATUS_HIGH_SPEED)
+            {
+                hubDevice.portSpeed[i] = USB_HUB_PORT_SPEED_HIGH;
+            }
+            else
+            {
+                hubDevice.portSpeed[i] = USB_HUB_PORT_SPEED_FULL;
+            }
+
+            hubDevice.msDelay   = USB_HUB_RESET_RECOVERY_MS;
+            hubDevice.state     = HUB_STATE_WAIT_RESET_RECOVERY;
+            return;
+        }
+
+        // The device went away during the reset.
+        hubDevice.portState[i] = USB_HUB_PORT_EMPTY;
+    }
+    else if ((hubDevice.portChangeSeen & USB_HUB_PORT_CHANGE_ENABLE) &&
+             !(hubDevice.portStatus & USB_HUB_PORT_STATUS_ENABLE) &&
+             (hubDevice.portState[i] == USB_HUB_PORT_ENABLED))
+    {
+        // The hub disabled the port because of an error on it.
+        _USBHostHub_DetachPort( hubDevice.currentPort );
+        hubDevice.portState[i] = USB_HUB_PORT_EMPTY;
+    }
+
+    _USBHostHub_NextPort();
+}
+
+
+/****************************************************************************
+  Function:
+    bool _USBHostHub_RequestDone( void )
+
+  Description:
+    This function checks whether the current control request has finished.
+
+  Precondition:
+    A request was started with _USBHostHub_StartRequest().
+
+  Parameters:
+    None - None
+
+  Return Values:
+    true    - The request completed successfully
+    false   - The request is still in progress, or it failed and will be
+                tried again, see _USBHostHub_Failed()
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static bool _USBHostHub_RequestDone( void )
+{
+    uint8_t     errorCode;
+    uint32_t    byteCount;
+
+    if (!USBHostTransferIsComplete( hubDevice.deviceAddress, 0, &errorCode, &byteCount ))
+    {
+        return false;
+    }
+
+    if (errorCode)
+    {
+        USBHostClearEndpointErrors( hubDevice.deviceAddress, 0 );
+        _USBHostHub_Failed();
+        return false;
+    }
+
+    hubDevice.errorCount = 0;
+    return true;
+}
+
+
+/****************************************************************************
+  Function:
+    void _USBHostHub_StartRequest( uint8_t bmRequestType, uint8_t bRequest,
+                uint16_t wValue, uint16_t wIndex, uint16_t wLength,
+                uint8_t dataDirection, uint8_t nextState )
+
+  Description:
+    This function starts a control request to the hub, using the driver's
+    data buffer.  If the request starts, the state machine moves to
+    nextState.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t bmRequestType  - Request type
+    uint8_t bRequest       - Request
+    uint16_t wValue        - Request value
+    uint16_t wIndex        - Request index
+    uint16_t wLength       - Data length, at most USB_HUB_DESCRIPTOR_SIZE
+    uint8_t dataDirection  - USB_DEVICE_REQUEST_SET or USB_DEVICE_REQUEST_GET
+    uint8_t nextState      - State to wait for completion in
+
+  Returns:
+    None
+
+  Remarks:
+    If EP0 is busy, the state is unchanged so the request is tried again
+    on the next call to USBHostHubTasks().  The calling state is kept in
+    retryState, to start the request again if it fails.
+  ***************************************************************************/
+
+static void _USBHostHub_StartRequest( uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue,
+                uint16_t wIndex, uint16_t wLength, uint8_t dataDirection, uint8_t nextState )
+{
+    uint8_t     errorCode;
+
+    hubDevice.retryState = hubDevice.state;
+    errorCode = USBHostIssueDeviceRequest( hubDevice.deviceAddress, bmRequestType, bRequest,
+                    wValue, wIndex, wLength, hubDevice.buffer, dataDirection, hubDevice.clientDriverID );
+
+    if (errorCode == USB_SUCCESS)
+    {
+        hubDevice.state = nextState;
+    }
+    else if (errorCode != USB_ENDPOINT_BUSY)
+    {
+        _USBHostHub_Failed();
+    }
+}
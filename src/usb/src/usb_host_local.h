@@ -43,6 +43,9 @@ Change History:
 #define _USB_HOST_LOCAL_
 
 #include "usb_hal_local.h"
+#if defined( USB_HUB_SUPPORT_INCLUDED )
+    #include <usb/usb_host_hub.h>
+#endif
 
 
 // *****************************************************************************
@@ -54,6 +57,82 @@ Change History:
 // *****************************************************************************
 // *****************************************************************************
 
+// *****************************************************************************
+// Section: Device Table
+// *****************************************************************************
+
+// The device on the root port always uses the first entry of the device
+// table.  With hub support, each device enumerated behind the hub (see
+// USBHostHubPortAttach()) takes one of the others.
+#if !defined( USB_MAX_DEVICES )
+    #if defined( USB_HUB_SUPPORT_INCLUDED )
+        #define USB_MAX_DEVICES             (1 + USB_MAX_HUB_PORTS)
+    #else
+        #define USB_MAX_DEVICES             1
+    #endif
+#endif
+#define USB_ROOT_DEVICE                     (&usbDeviceInfo[0])
+
+// *****************************************************************************
+// Section: Endpoint Lookup Table
+// *****************************************************************************
+
+// The active endpoints of the attached device are indexed by endpoint
+// address: OUT endpoints 1-15 use entries 1-15 and IN endpoints 0x81-0x8F
+// use entries 17-31.  EP0 is kept in pEndpoint0.
+#define USB_ENDPOINT_TABLE_SIZE             32
+#define _USB_EndpointTableIndex(a)          ((((a) & 0x80) >> 3) | ((a) & 0x0F))
+
+// *****************************************************************************
+// Section: Frame Scheduler
+// *****************************************************************************
+
+// Endpoints with a transfer queued are kept in a ready mask per transfer type
+// (bit n = endpoint table entry n).  A bit is set when a transfer is started
+// and cleared by the scheduler once it finds the transfer complete, so the
+// ISR only looks at endpoints that have work.
+//
+// Interrupt and isochronous endpoints are serviced in a fixed frame slot:
+// their interval is a power of 2 frames, and _USB_BuildEndpointTable()
+// gives each one a phase that spreads the periodic load over
+// USB_PERIODIC_SCHEDULE_FRAMES frames.
+#define USB_PERIODIC_SCHEDULE_FRAMES        32      // Power of 2.
+
+// Put an endpoint of device d on its ready list.  This must follow the write
+// that clears bfTransferComplete, so the ISR never drops a bit for a transfer
+// that is still being set up.  EP0 is checked separately and is not on a list.
+#define _USB_MarkEndpointReady(d,p)                                                     \
+    {                                                                                   \
+        if ((p)->bEndpointAddress != 0)                                                 \
+        {                                                                               \
+            (d)->readyEndpoints[(p)->bmAttributes.bfTransferType] |=                   \
+                (uint32_t)1 << _USB_EndpointTableIndex((p)->bEndpointAddress);          \
+        }                                                                               \
+    }
+
+// *****************************************************************************
+// Section: Enumeration Memory
+// *****************************************************************************
+
+// The device and configuration descriptors, the EP0 data buffer, and the
+// interface, setting, and endpoint lists of each attached device are bump
+// allocated from a fixed arena of its own.  Nothing is freed one block at a time: the
+// configuration lists are dropped by returning to the mark taken before they
+// were parsed, and the whole arena is reset when the device is detached or
+// enumeration starts over.
+//
+// The default holds a single configuration HID, MSD or CDC device.  Every
+// entry of the device table has an arena of this size.  Unlike
+// the heap it replaces, it does not grow: a device with several
+// configurations, or an audio device with many alternate settings, that
+// used to enumerate can now be held with USB_HOLDING_OUT_OF_MEMORY.  Size it
+// from the highWater of USBHostGetEnumerationMemoryStats().
+#if !defined( USB_ENUMERATION_ARENA_SIZE )
+    #define USB_ENUMERATION_ARENA_SIZE      1024    // Bytes.  Must be less than 65535.
+#endif
+#define USB_ENUMERATION_ARENA_ALIGNMENT     4       // Power of 2.
+#define USB_ENUMERATION_ARENA_NO_MARK       0xFFFF  // No configuration has been parsed.
+
 // *****************************************************************************
 // Section: State Machine Constants
 // *****************************************************************************
@@ -368,6 +447,8 @@ HOLDING state machine values
     #define USB_RESET_RECOVERY_TIME         (10+1)  // RESET recovery time.
 #elif defined( __PIC32MX__ )
     #define USB_RESET_RECOVERY_TIME         (100+1) // RESET recovery time - Changed to 100 ms from 10ms.  Some devices take longer.
+#elif defined(USB_SIMULATOR)
+    #define USB_RESET_RECOVERY_TIME         (10+1)  // RESET recovery time.
 #else
     #error Unknown USB_RESET_RECOVERY_TIME
 #endif
@@ -399,12 +480,15 @@ typedef struct _USB_BUS_INFO
             uint8_t        bfIsochronousTransfersDone  : 1;    // All isochronous transfers in the current frame are complete.
             uint8_t        bfBulkTransfersDone         : 1;    // All bulk transfers in the current frame are complete.
             uint8_t        bfTokenAlreadyWritten       : 1;    // A token has already been written to the USB module
+            uint8_t        bfPingPongIn                : 1;    // Ping-pong status of IN buffers (default = 0).
+            uint8_t        bfPingPongOut               : 1;    // Ping-pong status of OUT buffers (default = 0).
         };
         uint16_t            val;                                //
     }                   flags;                              //
 //    volatile uint32_t      dBytesSentInFrame;                  // The number of bytes sent during the current frame. Isochronous use only.
-    volatile uint8_t       lastBulkTransaction;                // The last bulk transaction sent.
-    volatile uint8_t       countBulkTransactions;              // The number of active bulk transactions.
+    volatile uint16_t      frameNumber;                        // Frame counter for the periodic schedule.
+    volatile uint8_t       bulkDevice;                         // Device table index where the next bulk search starts (round robin).
+    volatile uint8_t       countBulkTransactions;              // The number of bulk endpoints found ready in the last search.
 } USB_BUS_INFO;
 
 
@@ -449,8 +533,9 @@ typedef struct _USB_ENDPOINT_INFO
         };
         uint16_t            val;
     }                           status;
-    uint16_t                        wInterval;                      // Polling interval for interrupt and isochronous endpoints.
-    volatile uint16_t               wIntervalCount;                 // Current interval count.
+    uint16_t                        wInterval;                      // Polling interval for interrupt and isochronous endpoints, frames (power of 2).
+    volatile uint16_t               wIntervalCount;                 // 0 when the endpoint's frame slot has come up and it may be serviced.
+    uint8_t                        schedulePhase;                  // Frame slot of an interrupt or isochronous endpoint, see _USB_BuildEndpointTable().
     uint16_t                        wMaxPacketSize;                 // Endpoint packet size.
     uint32_t                       dataCountMax;                   // Amount of data to transfer during the transfer. Not used for isochronous transfers.
     uint16_t                        dataCountMaxSETUP;              // Amount of data in the SETUP packet (if applicable).
@@ -500,13 +585,40 @@ typedef struct _USB_INTERFACE_INFO
 } USB_INTERFACE_INFO;
 
 
+// *****************************************************************************
+/* Enumeration Arena
+
+This structure tracks the allocations from the enumeration arena.
+*/
+typedef struct _USB_ENUMERATION_ARENA
+{
+    uint16_t    top;                        // Offset of the first free byte.
+    uint16_t    configMark;                 // Offset where the configuration lists start.
+    uint16_t    highWater;                  // Largest value of top.
+    uint16_t    failedAllocations;          // Allocations that did not fit.
+} USB_ENUMERATION_ARENA;
+
+
 // *****************************************************************************
 /* USB Device Information
 
 This structure is used to hold all the information about an attached device.
+There is one for the device on the root port and one for each device
+enumerated behind the hub.  An entry other than the first is free when its
+hubAddress is 0.
 */
 typedef struct _USB_DEVICE_INFO
 {
+    volatile uint16_t   state;                              // State machine state of the device.
+    uint8_t             hubAddress;                         // Address of the hub the device is attached to, 0 for the root port.
+    uint8_t             hubPort;                            // Hub port the device is attached to.
+    uint8_t             countConfigurations;                // Count the Configuration Descriptors read during enumeration.
+    uint8_t             numCommandTries;                    // The number of times the current command has been tried.
+    uint8_t             numEnumerationTries;                // The number of times enumeration has been attempted on the device.
+    uint8_t             *pDeviceDescriptor;                 // Device Descriptor of the device.
+    uint8_t             *pCurrentConfigurationDescriptor;   // Current configuration descriptor of the device.
+    uint8_t             *pEP0Data;                          // A data buffer for use by EP0.
+    USB_ENUMERATION_ARENA arena;                            // Allocation state of the enumeration arena.
     USB_CONFIGURATION   *currentConfigurationDescriptor;    // Descriptor of the current Configuration.
     uint8_t                currentConfiguration;               // Value of current Configuration.
     uint8_t                attributesOTG;                      // OTG attributes.
@@ -520,6 +632,10 @@ typedef struct _USB_DEVICE_INFO
     USB_CONFIGURATION   *pConfigurationDescriptorList;      // Pointer to the list of Cnfiguration Descriptors of the attached device.
     USB_INTERFACE_INFO  *pInterfaceList;                    // List of interfaces on the attached device.
     USB_ENDPOINT_INFO   *pEndpoint0;                        // Pointer to a structure that describes EP0.
+    USB_ENDPOINT_INFO   *pEndpointTable[USB_ENDPOINT_TABLE_SIZE]; // Endpoints of the current interface settings, see _USB_EndpointTableIndex().
+    volatile uint32_t   readyEndpoints[4];                  // Per transfer type, the endpoint table entries with a transfer queued.
+    volatile uint32_t   bulkServedMask;                     // Bulk endpoints serviced in the current pass over the ready list.
+    volatile uint8_t    bulkNext;                           // Endpoint table index where the next bulk search starts (round robin).
 
     volatile union
     {
@@ -529,8 +645,6 @@ typedef struct _USB_DEVICE_INFO
             uint8_t        bfSupportsOTG               : 1;    // If the device supports OTG (default = 0).
             uint8_t        bfConfiguredOTG             : 1;    // If OTG on the device has been configured (default = 0).
             uint8_t        bfAllowHNP                  : 1;    // If Host Negotiation Protocol is allowed (default = 0).
-            uint8_t        bfPingPongIn                : 1;    // Ping-pong status of IN buffers (default = 0).
-            uint8_t        bfPingPongOut               : 1;    // Ping-pong status of OUT buffers (default = 0).
             uint8_t        bfUseDeviceClientDriver     : 1;    // Indicates driver should use a single client driver (deviceClientDriver)
             uint8_t        bfUseEP0Driver              : 1;
         };
@@ -572,6 +686,7 @@ the client drivers.
     typedef struct
     {
         USB_EVENT               event;          // Event that occured.
+        uint8_t                 deviceAddress;  // Device that the event is for.
         union
         {
             HOST_TRANSFER_DATA  TransferData;   // Event: EVENT_TRANSFER,
@@ -589,19 +704,32 @@ the client drivers.
 
 This structure defines the queue of USB events that can be generated by the
 ISR that need to be synchronized to the USB event tasks loop (see
-USB_EVENT_DATA, above).  See "struct_queue.h" for usage and operations.
+USB_EVENT_DATA, above).
+
+The queue is a single producer, single consumer ring.  Only the ISR writes
+head (in _USB_QueueTransferEvent()) and only USBHostTasks() writes tail (in
+_USB_DrainEventQueue()), so neither side has to mask interrupts.  The one
+exception is _USB_ReopenBulkPass(), which runs the bulk pass from the main
+context with the USB interrupts off in U1IE, so the ISR cannot write at the
+same time.  Both indexes
+run freely and are masked when used, so the number of waiting entries is
+always head - tail; the depth must be a power of 2 no larger than 128.
 */
 #if defined( USB_ENABLE_TRANSFER_EVENT )
     #ifndef USB_EVENT_QUEUE_DEPTH
         #define USB_EVENT_QUEUE_DEPTH   4       // Default depth of 4 events
     #endif
+    #if ((USB_EVENT_QUEUE_DEPTH & (USB_EVENT_QUEUE_DEPTH - 1)) != 0) || (USB_EVENT_QUEUE_DEPTH > 128)
+        #error USB_EVENT_QUEUE_DEPTH must be a power of 2 no larger than 128.
+    #endif
 
     typedef struct _usb_event_queue
     {
-        int             head;
-        int             tail;
-        int             count;
-        USB_EVENT_DATA  buffer[USB_EVENT_QUEUE_DEPTH];
+        volatile uint8_t    head;           // Next entry to fill.  Written by the ISR, or with U1IE cleared.
+        volatile uint8_t    tail;           // Next entry to deliver.  Written by USBHostTasks() only.
+        uint8_t             highWater;      // Most entries waiting at once.  Written with head.
+        uint16_t            overflows;      // Events dropped because the ring was full.  Written with head.
+        USB_EVENT_DATA      buffer[USB_EVENT_QUEUE_DEPTH];
 
     } USB_EVENT_QUEUE;
 #endif
@@ -625,15 +753,19 @@ USB_EVENT_DATA, above).  See "struct_queue.h" for usage and operations.
 //******************************************************************************
 //******************************************************************************
 
-#define _USB_InitErrorCounters()        { numCommandTries   = USB_NUM_COMMAND_TRIES; }
+#define _USB_DeviceInUse(i)             (((i) == 0) || (usbDeviceInfo[i].hubAddress != 0))
+#define _USB_EventQueueCount()          ((uint8_t)(usbEventQueue.head - usbEventQueue.tail))
+#define _USB_EventQueueEntry(i)         (&usbEventQueue.buffer[(i) & (USB_EVENT_QUEUE_DEPTH - 1)])
+#define _USB_InitErrorCounters()        { pCurrentDevice->numCommandTries = USB_NUM_COMMAND_TRIES; }
+#define _USB_ResetEnumerationArena()    { pCurrentDevice->arena.top = 0; pCurrentDevice->arena.configMark = USB_ENUMERATION_ARENA_NO_MARK; }
 #define _USB_SetDATA01(x)               { pCurrentEndpoint->status.bfNextDATA01 = x; }
-#define _USB_SetErrorCode(x)            { usbDeviceInfo.errorCode = x; }
-#define _USB_SetHoldState()             { usbHostState = STATE_HOLDING; }
-#define _USB_SetNextState()             { usbHostState = (usbHostState & STATE_MASK) + NEXT_STATE; }
-#define _USB_SetNextSubState()          { usbHostState = (usbHostState & (STATE_MASK | SUBSTATE_MASK)) + NEXT_SUBSTATE; }
-#define _USB_SetNextSubSubState()       { usbHostState =  usbHostState + NEXT_SUBSUBSTATE; }
+#define _USB_SetErrorCode(x)            { pCurrentDevice->errorCode = x; }
+#define _USB_SetHoldState()             { pCurrentDevice->state = STATE_HOLDING; }
+#define _USB_SetNextState()             { pCurrentDevice->state = (pCurrentDevice->state & STATE_MASK) + NEXT_STATE; }
+#define _USB_SetNextSubState()          { pCurrentDevice->state = (pCurrentDevice->state & (STATE_MASK | SUBSTATE_MASK)) + NEXT_SUBSTATE; }
+#define _USB_SetNextSubSubState()       { pCurrentDevice->state =  pCurrentDevice->state + NEXT_SUBSUBSTATE; }
 #define _USB_SetNextTransferState()     { pCurrentEndpoint->transferState ++; }
-#define _USB_SetPreviousSubSubState()   { usbHostState =  usbHostState - NEXT_SUBSUBSTATE; }
+#define _USB_SetPreviousSubSubState()   { pCurrentDevice->state =  pCurrentDevice->state - NEXT_SUBSUBSTATE; }
 #define _USB_SetTransferErrorState(x)   { x->transferState = (x->transferState & TSTATE_MASK) | TSUBSTATE_ERROR; }
 
 
@@ -643,10 +775,25 @@ USB_EVENT_DATA, above).  See "struct_queue.h" for usage and operations.
 //******************************************************************************
 //******************************************************************************
 
+void *               _USB_AllocEnumerationMemory( uint16_t size );
 void                 _USB_CheckCommandAndEnumerationAttempts( void );
+#if defined( USB_HUB_SUPPORT_INCLUDED )
+void                 _USB_DetachHubDevice( USB_DEVICE_INFO *pDevice );
+#endif
+void                 _USB_DeviceTasks( void );
+#if defined( USB_ENABLE_TRANSFER_EVENT )
+void                 _USB_DrainEventQueue( void );
+#endif
+void                 _USB_BuildEndpointTable( USB_DEVICE_INFO *pDevice );
 bool                 _USB_FindClassDriver( uint8_t bClass, uint8_t bSubClass, uint8_t bProtocol, uint8_t *pbClientDrv );
+USB_DEVICE_INFO *    _USB_FindDevice( uint8_t deviceAddress );
 bool                 _USB_FindDeviceLevelClientDriver( void );
-USB_ENDPOINT_INFO *  _USB_FindEndpoint( uint8_t endpoint );
+bool                 _USB_FindDeviceServiceEndpoint( USB_DEVICE_INFO *pDevice, uint8_t transferType );
+uint8_t              _USB_FindFreeAddress( void );
+USB_ENDPOINT_INFO *  _USB_FindEndpoint( USB_DEVICE_INFO *pDevice, uint8_t endpoint );
+#if defined( USB_SIMULATOR )
+USB_ENDPOINT_INFO *  _USB_FindEndpointInList( USB_DEVICE_INFO *pDevice, uint8_t endpoint );
+#endif
 USB_INTERFACE_INFO * _USB_FindInterface ( uint8_t bInterface, uint8_t bAltSetting );
 void                 _USB_FindNextToken( void );
 bool                 _USB_FindServiceEndpoint( uint8_t transferType );
@@ -656,14 +803,25 @@ void                 _USB_InitControlRead( USB_ENDPOINT_INFO *pEndpoint, uint8_t
                               uint8_t *pData, uint16_t size );
 void                 _USB_InitControlWrite( USB_ENDPOINT_INFO *pEndpoint, uint8_t *pControlData, uint16_t controlSize,
                                uint8_t *pData, uint16_t size );
+void                 _USB_InitDevice( void );
 void                 _USB_InitRead( USB_ENDPOINT_INFO *pEndpoint, uint8_t *pData, uint16_t size );
 void                 _USB_InitWrite( USB_ENDPOINT_INFO *pEndpoint, uint8_t *pData, uint16_t size );
+#ifdef USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+void                 _USB_IsochronousFillChanged( ISOCHRONOUS_DATA *isocData );
+#endif
 void                 _USB_NotifyClients( uint8_t DevAddress, USB_EVENT event, void *data, unsigned int size );
 bool                 _USB_ParseConfigurationDescriptor( void );
-void                 _USB_ResetDATA0( uint8_t endpoint );
+#if defined( USB_SUPPORT_BULK_TRANSFERS )
+void                 _USB_ReopenBulkPass( USB_ENDPOINT_INFO *pEndpoint );
+#endif
+#if defined( USB_ENABLE_TRANSFER_EVENT )
+void                 _USB_QueueTransferEvent( USB_EVENT event, uint32_t dataCount, uint8_t *pUserData, uint8_t errorCode );
+#endif
+void                 _USB_ResetDATA0( USB_DEVICE_INFO *pDevice, uint8_t endpoint );
 void                 _USB_SendToken( uint8_t endpoint, uint8_t tokenType );
 void                 _USB_SetBDT( uint8_t  direction );
-bool                 _USB_TransferInProgress( void );
+void                 _USB_StartBulkPass( void );
+bool                 _USB_TransferInProgress( USB_DEVICE_INFO *pDevice );
 
 
 #endif // _USB_HOST_LOCAL_
@@ -109,6 +109,21 @@ Currently this must be set to 1, due to limitations in the USB Host layer.
     #define USB_MAX_MASS_STORAGE_DEVICES        1
 #endif
 
+// *****************************************************************************
+/* Command Queue Depth
+
+If USB_MSD_QUEUE_DEPTH is defined, up to that many commands can be queued per
+device with USBHostMSDQueueTransfer(), for any of its LUNs.  The CBW of each
+command is prepared when it is queued, and sent as soon as the CSW of the
+command ahead of it has been received.  USBHostMSDTransfer() then also goes
+through the queue.  Each entry takes about 48 bytes of RAM.
+*/
+#if defined( USB_MSD_QUEUE_DEPTH )
+    #if (USB_MSD_QUEUE_DEPTH < 1) || (USB_MSD_QUEUE_DEPTH > 16)
+        #error "USB_MSD_QUEUE_DEPTH must be between 1 and 16."
+    #endif
+#endif
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Constants
@@ -201,6 +216,12 @@ Currently this must be set to 1, due to limitations in the USB Host layer.
 
 #define MARK_RESET_RECOVERY                 0x0E            // Maintain with USB_MSD_DEVICE_INFO
 
+#define QUEUE_ENTRY_FREE                    0               // Queue entry is not in use.
+#define QUEUE_ENTRY_QUEUED                  1               // Command is waiting for the device.
+#define QUEUE_ENTRY_ACTIVE                  2               // Command is on the bus.
+#define QUEUE_ENTRY_DONE                    3               // Command is complete, result not yet read.
+#define QUEUE_NO_ENTRY                      0xFF            // No queue entry.
+
 
 //******************************************************************************
 //******************************************************************************
@@ -248,6 +269,25 @@ typedef struct __attribute__((packed)) _USB_MSD_CSW
     uint8_t    dCSWStatus;                     // Result of requested operation.
 } USB_MSD_CSW;
 
+#if defined( USB_MSD_QUEUE_DEPTH )
+// *****************************************************************************
+/* Command Queue Entry
+
+This structure holds one command of the command queue, from the time it is
+queued until its result is read.
+*/
+typedef struct _USB_MSD_QUEUE_ENTRY
+{
+    USB_MSD_CBW     cbw;                        // CBW prepared when the command was queued.
+    uint8_t         *userData;                  // Pointer to the user's data buffer.
+    uint32_t        bytesTransferred;           // Number of bytes transferred, once done.
+    uint16_t        queuedFrame;                // Frame number when the command was queued.
+    uint16_t        frames;                     // Frames from queueing to the CSW, once done.
+    uint8_t         errorCode;                  // Result of the command, once done.
+    uint8_t         status;                     // QUEUE_ENTRY_xxx
+} USB_MSD_QUEUE_ENTRY;
+#endif
+
 
 /* USB Mass Storage Device Information
 This structure is used to hold all the information about an attached Mass Storage device.
@@ -286,6 +326,15 @@ typedef struct _USB_MSD_DEVICE_INFO
     uint32_t                               bytesTransferred;       // Number of bytes transferred to/from the user's data buffer.
     uint32_t                               dCBWTag;                // The value of the dCBWTag to verify against the dCSWtag.
     uint8_t                                attemptsCSW;            // Number of attempts to retrieve the CSW.
+    #if defined( USB_MSD_QUEUE_DEPTH )
+        USB_MSD_QUEUE_ENTRY                queue[USB_MSD_QUEUE_DEPTH];     // Command queue entries.
+        uint8_t                            pending[USB_MSD_QUEUE_DEPTH];   // Queued entries, in the order they are sent.
+        uint8_t                            pendingHead;            // Index in pending[] of the next entry to send.
+        uint8_t                            pendingCount;           // Number of entries in pending[].
+        uint8_t                            activeCommand;          // Entry of the command on the bus, or QUEUE_NO_ENTRY.
+        uint8_t                            transferCommand;        // Entry used by USBHostMSDTransfer(), or QUEUE_NO_ENTRY.
+        USB_MSD_QUEUE_STATS                queueStats;             // Latency statistics of the queue.
+    #endif
 } USB_MSD_DEVICE_INFO;
 
 //******************************************************************************
@@ -296,6 +345,13 @@ typedef struct _USB_MSD_DEVICE_INFO
 
 uint32_t   _USBHostMSD_GetNextTag( void );
 void    _USBHostMSD_ResetStateJump( uint8_t i );
+#if defined( USB_MSD_QUEUE_DEPTH )
+    uint8_t _USBHostMSD_QueueCommand( uint8_t i, uint8_t deviceLUN, uint8_t direction, uint8_t *commandBlock,
+                    uint8_t commandBlockLength, uint8_t *data, uint32_t dataLength, uint8_t *command );
+    void    _USBHostMSD_StartCommand( uint8_t i );
+    void    _USBHostMSD_CommandComplete( uint8_t i );
+    bool    _USBHostMSD_CommandIsComplete( uint8_t i, uint8_t command, uint8_t *errorCode, uint32_t *byteCount, uint16_t *frames );
+#endif
 
 
 //******************************************************************************
@@ -304,24 +360,34 @@ void    _USBHostMSD_ResetStateJump( uint8_t i );
 //******************************************************************************
 //******************************************************************************
 
+// Records the result of a queued command whenever a transfer terminates.
+#if defined( USB_MSD_QUEUE_DEPTH )
+  #define _USBHostMSD_QueueTransferDone()           _USBHostMSD_CommandComplete( i )
+#else
+  #define _USBHostMSD_QueueTransferDone()
+#endif
+
 #ifndef USB_ENABLE_TRANSFER_EVENT
   #define _USBHostMSD_SetNextState()                { deviceInfoMSD[i].state = (deviceInfoMSD[i].state & STATE_MASK) + NEXT_STATE; }
   #define _USBHostMSD_SetNextSubState()             { deviceInfoMSD[i].state += NEXT_SUBSTATE; }
   #define _USBHostMSD_TerminateTransfer( error )    {                                                                           \
                                                         deviceInfoMSD[i].errorCode  = error;                                    \
                                                         deviceInfoMSD[i].state      = STATE_RUNNING | SUBSTATE_TRANSFER_DONE;   \
+                                                        _USBHostMSD_QueueTransferDone();                                        \
                                                     }
 #else
   #ifdef USB_MSD_ENABLE_TRANSFER_EVENT
     #define _USBHostMSD_TerminateTransfer( error )  {                                                                                                           \
                                                         deviceInfoMSD[i].errorCode  = error;                                                                    \
                                                         deviceInfoMSD[i].state      = STATE_RUNNING;                                         \
+                                                        _USBHostMSD_QueueTransferDone();                                                                        \
                                                         usbMediaInterfaceTable.EventHandler( deviceInfoMSD[i].deviceAddress, EVENT_MSD_TRANSFER, NULL, 0 );     \
                                                     }
   #else
     #define _USBHostMSD_TerminateTransfer( error )  {                                                                                                           \
                                                         deviceInfoMSD[i].errorCode  = error;                                                                    \
                                                         deviceInfoMSD[i].state      = STATE_RUNNING;                                         \
+                                                        _USBHostMSD_QueueTransferDone();                                                                        \
                                                     }
   #endif
 #endif
@@ -472,6 +538,54 @@ uint8_t USBHostMSDDeviceStatus( uint8_t deviceAddress )
 }
 
 
+/****************************************************************************
+  Function:
+    uint8_t USBHostMSDGetQueueStats( uint8_t deviceAddress, USB_MSD_QUEUE_STATS *stats )
+
+  Description:
+    This function returns the latency statistics of the commands that have
+    completed through the command queue of a mass storage device.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress       - Device address
+    USB_MSD_QUEUE_STATS *stats  - Filled in with the statistics
+
+  Return Values:
+    USB_SUCCESS                 - The statistics were returned
+    USB_MSD_DEVICE_NOT_FOUND    - No device with specified address
+
+  Remarks:
+    Only available if USB_MSD_QUEUE_DEPTH is defined.  The statistics are
+    cleared when the device attaches.
+  ***************************************************************************/
+#if defined( USB_MSD_QUEUE_DEPTH )
+uint8_t USBHostMSDGetQueueStats( uint8_t deviceAddress, USB_MSD_QUEUE_STATS *stats )
+{
+    uint8_t    i;
+
+    // Make sure a valid device is being requested.
+    if ((deviceAddress == 0) || (deviceAddress > 127))
+    {
+        return USB_MSD_DEVICE_NOT_FOUND;
+    }
+
+    // Find the correct device.
+    for (i=0; (i<USB_MAX_MASS_STORAGE_DEVICES) && (deviceInfoMSD[i].deviceAddress != deviceAddress); i++);
+    if (i == USB_MAX_MASS_STORAGE_DEVICES)
+    {
+        return USB_MSD_DEVICE_NOT_FOUND;
+    }
+
+    *stats = deviceInfoMSD[i].queueStats;
+    stats->depth = USB_MSD_QUEUE_DEPTH;
+    return USB_SUCCESS;
+}
+#endif
+
+
 /****************************************************************************
   Function:
     uint8_t USBHostMSDResetDevice( uint8_t deviceAddress )
@@ -572,6 +686,7 @@ void USBHostMSDTasks( void )
     uint32_t   byteCount;
     uint8_t    errorCode;
     uint8_t    i;
+    uint8_t    lastState;
 
     for (i=0; i<USB_MAX_MASS_STORAGE_DEVICES; i++)
     {
@@ -653,212 +768,223 @@ void USBHostMSDTasks( void )
                     break;
 
                 case STATE_RUNNING:
-                    switch (deviceInfoMSD[i].state & SUBSTATE_MASK)
+                    // Run the phases of a command back to back: when one phase
+                    // completes, start the next in the same pass instead of on
+                    // the next call.  A queued command starts as soon as the
+                    // previous one is done.
+                    do
                     {
-                        case SUBSTATE_HOLDING:
-                            break;
-
-                        case SUBSTATE_SEND_CBW:
-                            #ifdef DEBUG_MODE
-                                UART2PrintString( "MSD: Writing CBW\r\n" );
-                            #endif
-                            errorCode = USBHostWrite( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointOUT, deviceInfoMSD[i].block.data, CBW_SIZE );
-                            if (errorCode)
-                            {
-                                _USBHostMSD_TerminateTransfer( errorCode );
-                            }
-                            else
-                            {
-                                _USBHostMSD_SetNextSubState();
-                            }
-                            break;
+                        lastState = deviceInfoMSD[i].state;
+                        switch (deviceInfoMSD[i].state & SUBSTATE_MASK)
+                        {
+                            case SUBSTATE_HOLDING:
+                                #if defined( USB_MSD_QUEUE_DEPTH )
+                                    _USBHostMSD_StartCommand( i );
+                                #endif
+                                break;
 
-                        case SUBSTATE_CBW_WAIT:
-                            if (USBHostTransferIsComplete( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointOUT, &errorCode, &byteCount ))
-                            {
+                            case SUBSTATE_SEND_CBW:
+                                #ifdef DEBUG_MODE
+                                    UART2PrintString( "MSD: Writing CBW\r\n" );
+                                #endif
+                                errorCode = USBHostWrite( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointOUT, deviceInfoMSD[i].block.data, CBW_SIZE );
                                 if (errorCode)
                                 {
-                                    #ifdef DEBUG_MODE
-                                        UART2PrintString( "MSD: Error with sending CBW\r\n" );
-                                    #endif
                                     _USBHostMSD_TerminateTransfer( errorCode );
                                 }
-                                else if (byteCount != CBW_SIZE)
+                                else
                                 {
-                                    #ifdef DEBUG_MODE
-                                        UART2PrintString( "MSD: CBW size not correct\r\n" );
-                                    #endif
-                                    _USBHostMSD_TerminateTransfer( USB_MSD_CBW_ERROR );
+                                    _USBHostMSD_SetNextSubState();
                                 }
-                                else
+                                break;
+
+                            case SUBSTATE_CBW_WAIT:
+                                if (USBHostTransferIsComplete( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointOUT, &errorCode, &byteCount ))
                                 {
-                                    if (deviceInfoMSD[i].block.cbw.dCBWDataTransferLength == 0)
+                                    if (errorCode)
                                     {
                                         #ifdef DEBUG_MODE
-                                            UART2PrintString( "MSD: Transfer length=0\r\n" );
+                                            UART2PrintString( "MSD: Error with sending CBW\r\n" );
                                         #endif
-                                        // Skip to get the CSW
-                                        deviceInfoMSD[i].state = STATE_RUNNING | SUBSTATE_REQUEST_CSW;
+                                        _USBHostMSD_TerminateTransfer( errorCode );
                                     }
-                                    else
+                                    else if (byteCount != CBW_SIZE)
                                     {
                                         #ifdef DEBUG_MODE
-                                            UART2PrintString( "MSD: Going on...\r\n" );
+                                            UART2PrintString( "MSD: CBW size not correct\r\n" );
                                         #endif
-                                        _USBHostMSD_SetNextSubState();
+                                        _USBHostMSD_TerminateTransfer( USB_MSD_CBW_ERROR );
+                                    }
+                                    else
+                                    {
+                                        if (deviceInfoMSD[i].block.cbw.dCBWDataTransferLength == 0)
+                                        {
+                                            #ifdef DEBUG_MODE
+                                                UART2PrintString( "MSD: Transfer length=0\r\n" );
+                                            #endif
+                                            // Skip to get the CSW
+                                            deviceInfoMSD[i].state = STATE_RUNNING | SUBSTATE_REQUEST_CSW;
+                                        }
+                                        else
+                                        {
+                                            #ifdef DEBUG_MODE
+                                                UART2PrintString( "MSD: Going on...\r\n" );
+                                            #endif
+                                            _USBHostMSD_SetNextSubState();
+                                        }
                                     }
                                 }
-                            }
-                            break;
+                                break;
 
-                        case SUBSTATE_TRANSFER_DATA:
-                            #ifdef DEBUG_MODE
-                                UART2PrintString( "MSD: Transferring data, length ");
-                                UART2PutHexDWord( deviceInfoMSD[i].userDataLength );
-                                UART2PrintString( "\r\n" );
-                            #endif
-                            if (deviceInfoMSD[i].userDataLength == 0)
-                            {
-                                deviceInfoMSD[i].state = STATE_RUNNING | SUBSTATE_REQUEST_CSW;
-                            }
-                            else
-                            {
-                                if (!deviceInfoMSD[i].flags.bfDirection) // OUT
+                            case SUBSTATE_TRANSFER_DATA:
+                                #ifdef DEBUG_MODE
+                                    UART2PrintString( "MSD: Transferring data, length ");
+                                    UART2PutHexDWord( deviceInfoMSD[i].userDataLength );
+                                    UART2PrintString( "\r\n" );
+                                #endif
+                                if (deviceInfoMSD[i].userDataLength == 0)
                                 {
-                                    errorCode = USBHostWrite( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointDATA, deviceInfoMSD[i].userData, deviceInfoMSD[i].userDataLength );
+                                    deviceInfoMSD[i].state = STATE_RUNNING | SUBSTATE_REQUEST_CSW;
                                 }
                                 else
                                 {
-                                    errorCode = USBHostRead( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointDATA, deviceInfoMSD[i].userData, deviceInfoMSD[i].userDataLength );
-                                }
+                                    if (!deviceInfoMSD[i].flags.bfDirection) // OUT
+                                    {
+                                        errorCode = USBHostWrite( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointDATA, deviceInfoMSD[i].userData, deviceInfoMSD[i].userDataLength );
+                                    }
+                                    else
+                                    {
+                                        errorCode = USBHostRead( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointDATA, deviceInfoMSD[i].userData, deviceInfoMSD[i].userDataLength );
+                                    }
 
-                                if (errorCode)
-                                {
-                                    _USBHostMSD_TerminateTransfer( errorCode );
-                                }
-                                else
-                                {
-                                    _USBHostMSD_SetNextSubState();
+                                    if (errorCode)
+                                    {
+                                        _USBHostMSD_TerminateTransfer( errorCode );
+                                    }
+                                    else
+                                    {
+                                        _USBHostMSD_SetNextSubState();
+                                    }
                                 }
-                            }
-                            break;
+                                break;
 
-                        case SUBSTATE_TRANSFER_WAIT:
-                            if (USBHostTransferIsComplete( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointDATA, &errorCode, &byteCount ))
-                            {
-                                if (errorCode)
+                            case SUBSTATE_TRANSFER_WAIT:
+                                if (USBHostTransferIsComplete( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointDATA, &errorCode, &byteCount ))
                                 {
-                                    if (errorCode == USB_ENDPOINT_STALLED)
+                                    if (errorCode)
                                     {
-                                        // Clear the stall, then try to get the CSW.
-                                        #ifdef DEBUG_MODE
-                                            UART2PrintString( "MSD: Stall on data\r\n" );
-                                        #endif
-                                        USBHostClearEndpointErrors( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointDATA );
-                                        if (!deviceInfoMSD[i].flags.bfDirection) // OUT
+                                        if (errorCode == USB_ENDPOINT_STALLED)
                                         {
-                                            deviceInfoMSD[i].flags.bfClearDataOUT = 1;
+                                            // Clear the stall, then try to get the CSW.
+                                            #ifdef DEBUG_MODE
+                                                UART2PrintString( "MSD: Stall on data\r\n" );
+                                            #endif
+                                            USBHostClearEndpointErrors( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointDATA );
+                                            if (!deviceInfoMSD[i].flags.bfDirection) // OUT
+                                            {
+                                                deviceInfoMSD[i].flags.bfClearDataOUT = 1;
+                                            }
+                                            else
+                                            {
+                                                deviceInfoMSD[i].flags.bfClearDataIN = 1;
+                                            }
+                                            deviceInfoMSD[i].returnState = STATE_RUNNING | SUBSTATE_REQUEST_CSW;
+                                            _USBHostMSD_ResetStateJump( i );
+
                                         }
                                         else
                                         {
-                                            deviceInfoMSD[i].flags.bfClearDataIN = 1;
+                                            //Error recovery here is not explicitly covered in the spec. Unfortunately, some
+                                            // thumb drives generate a turn-around time error here sometimes.
+                                            //_USBHostMSD_TerminateTransfer( errorCode );
+                                            deviceInfoMSD[i].flags.val |= MARK_RESET_RECOVERY;
+                                            deviceInfoMSD[i].returnState = STATE_RUNNING | SUBSTATE_SEND_CBW;   // Try the transfer again.
+                                            _USBHostMSD_ResetStateJump( i );
                                         }
-                                        deviceInfoMSD[i].returnState = STATE_RUNNING | SUBSTATE_REQUEST_CSW;
-                                        _USBHostMSD_ResetStateJump( i );
-
                                     }
                                     else
                                     {
-                                        //Error recovery here is not explicitly covered in the spec. Unfortunately, some
-                                        // thumb drives generate a turn-around time error here sometimes.
-                                        //_USBHostMSD_TerminateTransfer( errorCode );
-                                        deviceInfoMSD[i].flags.val |= MARK_RESET_RECOVERY;
-                                        deviceInfoMSD[i].returnState = STATE_RUNNING | SUBSTATE_SEND_CBW;   // Try the transfer again.
-                                        _USBHostMSD_ResetStateJump( i );
+                                        _USBHostMSD_SetNextSubState();
                                     }
                                 }
-                                else
-                                {
-                                    _USBHostMSD_SetNextSubState();
-                                }
-                            }
-                            break;
-
-                        case SUBSTATE_REQUEST_CSW:
-                            #ifdef DEBUG_MODE
-                                UART2PrintString( "MSD: Getting CSW\r\n" );
-                            #endif
-
-                            errorCode = USBHostRead( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointIN, deviceInfoMSD[i].block.data, CSW_SIZE );
-                            if (errorCode)
-                            {
-                                _USBHostMSD_TerminateTransfer( errorCode );
-                            }
-                            else
-                            {
-                                _USBHostMSD_SetNextSubState();
-                            }
-                            break;
+                                break;
 
-                        case SUBSTATE_CSW_WAIT:
-                            if (USBHostTransferIsComplete( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointIN, &errorCode, &byteCount ))
-                            {
+                            case SUBSTATE_REQUEST_CSW:
                                 #ifdef DEBUG_MODE
-                                    UART2PrintString( "MSD: Got CSW-" );
+                                    UART2PrintString( "MSD: Getting CSW\r\n" );
                                 #endif
+
+                                errorCode = USBHostRead( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointIN, deviceInfoMSD[i].block.data, CSW_SIZE );
                                 if (errorCode)
                                 {
-                                    deviceInfoMSD[i].attemptsCSW--;
-                                    if (deviceInfoMSD[i].attemptsCSW)
-                                    {
-                                        USBHostClearEndpointErrors( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointIN );
-                                        deviceInfoMSD[i].flags.bfClearDataIN = 1;
-                                        deviceInfoMSD[i].returnState = STATE_RUNNING | SUBSTATE_REQUEST_CSW;
-                                        _USBHostMSD_ResetStateJump( i );
-                                    }
-                                    else
-                                    {
-                                        _USBHostMSD_TerminateTransfer( errorCode );
-                                    }
-                                }
-                                else if ((byteCount != CSW_SIZE) |
-                                         (deviceInfoMSD[i].block.csw.dCSWSignature != USB_MSD_DCSWSIGNATURE) |
-                                         (deviceInfoMSD[i].block.csw.dCSWTag       != deviceInfoMSD[i].dCBWTag) )
-                                {
-                                    _USBHostMSD_TerminateTransfer( USB_MSD_CSW_ERROR );
+                                    _USBHostMSD_TerminateTransfer( errorCode );
                                 }
                                 else
                                 {
-                                    deviceInfoMSD[i].bytesTransferred = deviceInfoMSD[i].userDataLength - deviceInfoMSD[i].block.csw.dCSWDataResidue;
+                                    _USBHostMSD_SetNextSubState();
+                                }
+                                break;
 
-                                    if (deviceInfoMSD[i].block.csw.dCSWStatus != 0x00)
+                            case SUBSTATE_CSW_WAIT:
+                                if (USBHostTransferIsComplete( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointIN, &errorCode, &byteCount ))
+                                {
+                                    #ifdef DEBUG_MODE
+                                        UART2PrintString( "MSD: Got CSW-" );
+                                    #endif
+                                    if (errorCode)
                                     {
-                                        _USBHostMSD_TerminateTransfer( deviceInfoMSD[i].block.csw.dCSWStatus | USB_MSD_ERROR );
+                                        deviceInfoMSD[i].attemptsCSW--;
+                                        if (deviceInfoMSD[i].attemptsCSW)
+                                        {
+                                            USBHostClearEndpointErrors( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointIN );
+                                            deviceInfoMSD[i].flags.bfClearDataIN = 1;
+                                            deviceInfoMSD[i].returnState = STATE_RUNNING | SUBSTATE_REQUEST_CSW;
+                                            _USBHostMSD_ResetStateJump( i );
+                                        }
+                                        else
+                                        {
+                                            _USBHostMSD_TerminateTransfer( errorCode );
+                                        }
                                     }
-                                    else
+                                    else if ((byteCount != CSW_SIZE) |
+                                             (deviceInfoMSD[i].block.csw.dCSWSignature != USB_MSD_DCSWSIGNATURE) |
+                                             (deviceInfoMSD[i].block.csw.dCSWTag       != deviceInfoMSD[i].dCBWTag) )
                                     {
-                                        _USBHostMSD_TerminateTransfer( USB_SUCCESS );
+                                        _USBHostMSD_TerminateTransfer( USB_MSD_CSW_ERROR );
                                     }
-
-                                    // If we have a phase error, we need to perform corrective action instead of
-                                    // returning to normal running.
-                                    if (deviceInfoMSD[i].block.csw.dCSWStatus == MSD_PHASE_ERROR)
+                                    else
                                     {
-                                        deviceInfoMSD[i].flags.val |= MARK_RESET_RECOVERY;
-                                        deviceInfoMSD[i].returnState = STATE_RUNNING | SUBSTATE_HOLDING;
-                                        _USBHostMSD_ResetStateJump( i );
+                                        deviceInfoMSD[i].bytesTransferred = deviceInfoMSD[i].userDataLength - deviceInfoMSD[i].block.csw.dCSWDataResidue;
+
+                                        if (deviceInfoMSD[i].block.csw.dCSWStatus != 0x00)
+                                        {
+                                            _USBHostMSD_TerminateTransfer( deviceInfoMSD[i].block.csw.dCSWStatus | USB_MSD_ERROR );
+                                        }
+                                        else
+                                        {
+                                            _USBHostMSD_TerminateTransfer( USB_SUCCESS );
+                                        }
+
+                                        // If we have a phase error, we need to perform corrective action instead of
+                                        // returning to normal running.
+                                        if (deviceInfoMSD[i].block.csw.dCSWStatus == MSD_PHASE_ERROR)
+                                        {
+                                            deviceInfoMSD[i].flags.val |= MARK_RESET_RECOVERY;
+                                            deviceInfoMSD[i].returnState = STATE_RUNNING | SUBSTATE_HOLDING;
+                                            _USBHostMSD_ResetStateJump( i );
+                                        }
                                     }
                                 }
-                            }
-                            break;
+                                break;
 
-                        case SUBSTATE_TRANSFER_DONE:
-                            deviceInfoMSD[i].state = STATE_RUNNING | SUBSTATE_HOLDING;
-                            #ifdef USB_MSD_ENABLE_TRANSFER_EVENT
-                                usbMediaInterfaceTable.EventHandler( deviceInfoMSD[i].deviceAddress, EVENT_MSD_TRANSFER, NULL, 0 );
-                            #endif
-                            break;
-                    }
+                            case SUBSTATE_TRANSFER_DONE:
+                                deviceInfoMSD[i].state = STATE_RUNNING | SUBSTATE_HOLDING;
+                                #ifdef USB_MSD_ENABLE_TRANSFER_EVENT
+                                    usbMediaInterfaceTable.EventHandler( deviceInfoMSD[i].deviceAddress, EVENT_MSD_TRANSFER, NULL, 0 );
+                                #endif
+                                break;
+                        }
+                    } while ((deviceInfoMSD[i].state != lastState) && ((deviceInfoMSD[i].state & STATE_MASK) == STATE_RUNNING));
                     break;
 
                 case STATE_MSD_RESET_RECOVERY:
@@ -975,19 +1101,145 @@ void USBHostMSDTasks( void )
                             }
                             break;
 
-                        case SUBSTATE_CLEAR_OUT_COMPLETE:
-                            _USBHostMSD_ResetStateJump( i );
-                            break;
-                    }
-                    break;
+                        case SUBSTATE_CLEAR_OUT_COMPLETE:
+                            _USBHostMSD_ResetStateJump( i );
+                            break;
+                    }
+                    break;
+
+                case STATE_HOLDING:
+                    break;
+            }
+        }
+    }
+#endif
+}
+
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostMSDQueueTransfer( uint8_t deviceAddress, uint8_t deviceLUN,
+                uint8_t direction, uint8_t *commandBlock, uint8_t commandBlockLength,
+                uint8_t *data, uint32_t dataLength, uint8_t *command )
+
+  Summary:
+    This function queues a mass storage transfer.
+
+  Description:
+    This function adds a mass storage transfer to the command queue of the
+    device, behind any commands already queued for any LUN.  The CBW is
+    prepared now, so that it is sent as soon as the CSW of the previous
+    command has been received.  Use USBHostMSDQueuedTransferIsComplete()
+    with the returned command number to get the result.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress      - Device address
+    uint8_t deviceLUN          - Device LUN to access
+    uint8_t direction          - 1=read, 0=write
+    uint8_t *commandBlock      - Pointer to the command block for the CBW
+    uint8_t commandBlockLength - Length of the command block
+    uint8_t *data              - Pointer to the data buffer
+    uint32_t dataLength        - Byte size of the data buffer
+    uint8_t *command           - Returns the number of the queued command
+
+  Return Values:
+    USB_SUCCESS                 - Command queued
+    USB_MSD_DEVICE_NOT_FOUND    - No device with specified address
+    USB_MSD_DEVICE_BUSY         - The queue is full, or the device is not
+                                    running
+    USB_MSD_INVALID_LUN         - Specified LUN does not exist
+
+  Remarks:
+    Only available if USB_MSD_QUEUE_DEPTH is defined.  The command block is
+    copied; the data buffer must stay valid until the command completes.
+    A queue entry stays in use until its result has been read with
+    USBHostMSDQueuedTransferIsComplete().
+  ***************************************************************************/
+#if defined( USB_MSD_QUEUE_DEPTH )
+uint8_t USBHostMSDQueueTransfer( uint8_t deviceAddress, uint8_t deviceLUN, uint8_t direction, uint8_t *commandBlock,
+                        uint8_t commandBlockLength, uint8_t *data, uint32_t dataLength, uint8_t *command )
+{
+    uint8_t    i;
+
+    // Make sure a valid device is being requested.
+    if ((deviceAddress == 0) || (deviceAddress > 127))
+    {
+        return USB_MSD_DEVICE_NOT_FOUND;
+    }
+
+    // Find the correct device.
+    for (i=0; (i<USB_MAX_MASS_STORAGE_DEVICES) && (deviceInfoMSD[i].deviceAddress != deviceAddress); i++);
+    if (i == USB_MAX_MASS_STORAGE_DEVICES)
+    {
+        return USB_MSD_DEVICE_NOT_FOUND;
+    }
+
+    return _USBHostMSD_QueueCommand( i, deviceLUN, direction, commandBlock, commandBlockLength, data, dataLength, command );
+}
+#endif
+
+
+/****************************************************************************
+  Function:
+    bool USBHostMSDQueuedTransferIsComplete( uint8_t deviceAddress, uint8_t command,
+                        uint8_t *errorCode, uint32_t *byteCount, uint16_t *frames )
+
+  Summary:
+    This function indicates whether or not a queued transfer is complete.
+
+  Description:
+    This function indicates whether or not a transfer queued with
+    USBHostMSDQueueTransfer() is complete.  If the function returns true,
+    the returned error code, byte count and latency are valid, and the
+    queue entry is free for another command.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress  - Device address
+    uint8_t command        - Command number from USBHostMSDQueueTransfer()
+    uint8_t *errorCode     - Error code of the command
+    uint32_t *byteCount    - Number of bytes transferred
+    uint16_t *frames       - Frames from queueing the command to receiving
+                             its CSW.  May be NULL.
+
+  Return Values:
+    true    - Transfer is complete, errorCode is valid
+    false   - Transfer is not complete, errorCode is not valid
+
+  Remarks:
+    Only available if USB_MSD_QUEUE_DEPTH is defined.  If the device has
+    detached, the function returns true with USB_MSD_DEVICE_NOT_FOUND.
+  ***************************************************************************/
+#if defined( USB_MSD_QUEUE_DEPTH )
+bool USBHostMSDQueuedTransferIsComplete( uint8_t deviceAddress, uint8_t command, uint8_t *errorCode, uint32_t *byteCount, uint16_t *frames )
+{
+    uint8_t    i;
+
+    // Make sure a valid device is being requested.
+    if ((deviceAddress == 0) || (deviceAddress > 127))
+    {
+        *errorCode = USB_MSD_DEVICE_NOT_FOUND;
+        *byteCount = 0;
+        return true;
+    }
 
-                case STATE_HOLDING:
-                    break;
-            }
-        }
+    // Find the correct device.
+    for (i=0; (i<USB_MAX_MASS_STORAGE_DEVICES) && (deviceInfoMSD[i].deviceAddress != deviceAddress); i++);
+    if ((i == USB_MAX_MASS_STORAGE_DEVICES) || (deviceInfoMSD[i].state == STATE_DETACHED) || (command >= USB_MSD_QUEUE_DEPTH))
+    {
+        *errorCode = USB_MSD_DEVICE_NOT_FOUND;
+        *byteCount = 0;
+        return true;
     }
-#endif
+
+    return _USBHostMSD_CommandIsComplete( i, command, errorCode, byteCount, frames );
 }
+#endif
 
 
 /****************************************************************************
@@ -1008,7 +1260,9 @@ void USBHostMSDTasks( void )
 
   Remarks:
     After executing this function, the application may have to reset the
-    device in order for the device to continue working properly.
+    device in order for the device to continue working properly.  If
+    USB_MSD_QUEUE_DEPTH is defined, the commands waiting in the queue are
+    terminated as well, with USB_MSD_TRANSFER_TERMINATED.
   ***************************************************************************/
 
 void USBHostMSDTerminateTransfer( uint8_t deviceAddress )
@@ -1038,6 +1292,26 @@ void USBHostMSDTerminateTransfer( uint8_t deviceAddress )
         USBHostTerminateTransfer( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointIN );
         USBHostTerminateTransfer( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointOUT );
 
+        #if defined( USB_MSD_QUEUE_DEPTH )
+            // Terminate the active command and everything queued behind it.
+            deviceInfoMSD[i].errorCode = USB_MSD_TRANSFER_TERMINATED;
+            do
+            {
+                _USBHostMSD_CommandComplete( i );
+                if (deviceInfoMSD[i].pendingCount != 0)
+                {
+                    deviceInfoMSD[i].activeCommand = deviceInfoMSD[i].pending[deviceInfoMSD[i].pendingHead];
+                    deviceInfoMSD[i].pendingHead++;
+                    if (deviceInfoMSD[i].pendingHead == USB_MSD_QUEUE_DEPTH)
+                    {
+                        deviceInfoMSD[i].pendingHead = 0;
+                    }
+                    deviceInfoMSD[i].pendingCount--;
+                    deviceInfoMSD[i].bytesTransferred = 0;
+                }
+            } while (deviceInfoMSD[i].activeCommand != QUEUE_NO_ENTRY);
+        #endif
+
         // Set the state back to running and waiting for a transfer request.
         #ifndef USB_ENABLE_TRANSFER_EVENT
             deviceInfoMSD[i].state = STATE_RUNNING | SUBSTATE_HOLDING;
@@ -1089,7 +1363,9 @@ uint8_t USBHostMSDTransfer( uint8_t deviceAddress, uint8_t deviceLUN, uint8_t di
                         uint8_t commandBlockLength, uint8_t *data, uint32_t dataLength )
 {
     uint8_t    i;
-    uint8_t    j;
+    #if !defined( USB_MSD_QUEUE_DEPTH )
+        uint8_t    j;
+    #endif
 
     #ifdef DEBUG_MODE
         UART2PrintString( "MSD: Transfer: " );
@@ -1116,71 +1392,81 @@ uint8_t USBHostMSDTransfer( uint8_t deviceAddress, uint8_t deviceLUN, uint8_t di
         return USB_MSD_DEVICE_NOT_FOUND;
     }
 
-    // Make sure the device is in a state ready to read/write.
-    #ifndef USB_ENABLE_TRANSFER_EVENT
-        if (deviceInfoMSD[i].state != (STATE_RUNNING | SUBSTATE_HOLDING))
+    #if defined( USB_MSD_QUEUE_DEPTH )
+        // Go through the queue, so that the transfer is ordered with the
+        // queued ones.  Only one such transfer can be outstanding.
+        if (deviceInfoMSD[i].transferCommand != QUEUE_NO_ENTRY)
+        {
+            return USB_MSD_DEVICE_BUSY;
+        }
+        return _USBHostMSD_QueueCommand( i, deviceLUN, direction, commandBlock, commandBlockLength, data, dataLength, &deviceInfoMSD[i].transferCommand );
     #else
-        if (deviceInfoMSD[i].state != STATE_RUNNING)
-    #endif
-    {
-        return USB_MSD_DEVICE_BUSY;
-    }
-
-    // Verify the selected LUN.
-    if (deviceLUN > deviceInfoMSD[i].maxLUN)
-    {
-        return USB_MSD_INVALID_LUN;
-    }
-
-    // Initialize the transfer information.
-    deviceInfoMSD[i].attemptsCSW       = CSW_RECEIVE_ATTEMPTS;
-    deviceInfoMSD[i].bytesTransferred  = 0;
-    deviceInfoMSD[i].errorCode         = USB_SUCCESS;
-    deviceInfoMSD[i].flags.val         = 0;
-    deviceInfoMSD[i].flags.bfDirection = direction;
-    deviceInfoMSD[i].userData          = data;
-    deviceInfoMSD[i].userDataLength    = dataLength;
-    deviceInfoMSD[i].dCBWTag           = _USBHostMSD_GetNextTag();
-    deviceInfoMSD[i].endpointDATA      = deviceInfoMSD[i].endpointIN;
-    if (!direction) // OUT
-    {
-        deviceInfoMSD[i].endpointDATA  = deviceInfoMSD[i].endpointOUT;
-    }
-    #ifdef DEBUG_MODE
-        UART2PrintString( "Data EP: " );
-        UART2PutHex( deviceInfoMSD[i].endpointDATA );
-        UART2PrintString( "\r\n" );
-    #endif
+        // Make sure the device is in a state ready to read/write.
+        #ifndef USB_ENABLE_TRANSFER_EVENT
+            if (deviceInfoMSD[i].state != (STATE_RUNNING | SUBSTATE_HOLDING))
+        #else
+            if (deviceInfoMSD[i].state != STATE_RUNNING)
+        #endif
+        {
+            return USB_MSD_DEVICE_BUSY;
+        }
 
-    // Prepare the CBW so we can give the user back his command block RAM.
-    deviceInfoMSD[i].block.cbw.dCBWSignature             = USB_MSD_DCBWSIGNATURE;
-    deviceInfoMSD[i].block.cbw.dCBWTag                   = deviceInfoMSD[i].dCBWTag;
-    deviceInfoMSD[i].block.cbw.dCBWDataTransferLength    = deviceInfoMSD[i].userDataLength;
-    deviceInfoMSD[i].block.cbw.bmCBWflags.val            = 0;
-    deviceInfoMSD[i].block.cbw.bmCBWflags.bfDirection    = direction;
-    deviceInfoMSD[i].block.cbw.bCBWLUN                   = deviceLUN;
-    deviceInfoMSD[i].block.cbw.bCBWCBLength              = commandBlockLength;
-    for (j=0; j<commandBlockLength; j++)
-    {
-        deviceInfoMSD[i].block.cbw.CBWCB[j]              = commandBlock[j];
-    }
+        // Verify the selected LUN.
+        if (deviceLUN > deviceInfoMSD[i].maxLUN)
+        {
+            return USB_MSD_INVALID_LUN;
+        }
 
-    #ifndef USB_ENABLE_TRANSFER_EVENT
-        // Jump to the transfer state.
-        deviceInfoMSD[i].state             = STATE_RUNNING | SUBSTATE_SEND_CBW;
-    #else
-        j = USBHostWrite( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointOUT, deviceInfoMSD[i].block.data, CBW_SIZE );
-        if (j)
+        // Initialize the transfer information.
+        deviceInfoMSD[i].attemptsCSW       = CSW_RECEIVE_ATTEMPTS;
+        deviceInfoMSD[i].bytesTransferred  = 0;
+        deviceInfoMSD[i].errorCode         = USB_SUCCESS;
+        deviceInfoMSD[i].flags.val         = 0;
+        deviceInfoMSD[i].flags.bfDirection = direction;
+        deviceInfoMSD[i].userData          = data;
+        deviceInfoMSD[i].userDataLength    = dataLength;
+        deviceInfoMSD[i].dCBWTag           = _USBHostMSD_GetNextTag();
+        deviceInfoMSD[i].endpointDATA      = deviceInfoMSD[i].endpointIN;
+        if (!direction) // OUT
         {
-            _USBHostMSD_TerminateTransfer( j );
+            deviceInfoMSD[i].endpointDATA  = deviceInfoMSD[i].endpointOUT;
         }
-        else
+        #ifdef DEBUG_MODE
+            UART2PrintString( "Data EP: " );
+            UART2PutHex( deviceInfoMSD[i].endpointDATA );
+            UART2PrintString( "\r\n" );
+        #endif
+
+        // Prepare the CBW so we can give the user back his command block RAM.
+        deviceInfoMSD[i].block.cbw.dCBWSignature             = USB_MSD_DCBWSIGNATURE;
+        deviceInfoMSD[i].block.cbw.dCBWTag                   = deviceInfoMSD[i].dCBWTag;
+        deviceInfoMSD[i].block.cbw.dCBWDataTransferLength    = deviceInfoMSD[i].userDataLength;
+        deviceInfoMSD[i].block.cbw.bmCBWflags.val            = 0;
+        deviceInfoMSD[i].block.cbw.bmCBWflags.bfDirection    = direction;
+        deviceInfoMSD[i].block.cbw.bCBWLUN                   = deviceLUN;
+        deviceInfoMSD[i].block.cbw.bCBWCBLength              = commandBlockLength;
+        for (j=0; j<commandBlockLength; j++)
         {
-            deviceInfoMSD[i].state = STATE_CBW_WAIT;
+            deviceInfoMSD[i].block.cbw.CBWCB[j]              = commandBlock[j];
         }
-    #endif
 
-    return USB_SUCCESS;
+        #ifndef USB_ENABLE_TRANSFER_EVENT
+            // Jump to the transfer state.
+            deviceInfoMSD[i].state             = STATE_RUNNING | SUBSTATE_SEND_CBW;
+        #else
+            j = USBHostWrite( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointOUT, deviceInfoMSD[i].block.data, CBW_SIZE );
+            if (j)
+            {
+                _USBHostMSD_TerminateTransfer( j );
+            }
+            else
+            {
+                deviceInfoMSD[i].state = STATE_CBW_WAIT;
+            }
+        #endif
+
+        return USB_SUCCESS;
+    #endif
 }
 
 
@@ -1235,6 +1521,18 @@ bool USBHostMSDTransferIsComplete( uint8_t deviceAddress, uint8_t *errorCode, ui
         return true;
     }
 
+    #if defined( USB_MSD_QUEUE_DEPTH )
+        if (deviceInfoMSD[i].transferCommand != QUEUE_NO_ENTRY)
+        {
+            if (!_USBHostMSD_CommandIsComplete( i, deviceInfoMSD[i].transferCommand, errorCode, byteCount, NULL ))
+            {
+                return false;
+            }
+            deviceInfoMSD[i].transferCommand = QUEUE_NO_ENTRY;
+            return true;
+        }
+    #endif
+
     #ifndef USB_ENABLE_TRANSFER_EVENT
         if  ( (deviceInfoMSD[i].state               == (STATE_RUNNING | SUBSTATE_HOLDING)) ||
              ((deviceInfoMSD[i].state & STATE_MASK) == STATE_HOLDING))
@@ -1382,6 +1680,17 @@ bool USBHostMSDInitialize( uint8_t address, uint32_t flags, uint8_t clientDriver
                         deviceInfoMSD[device].clientDriverID   = clientDriverID;
                         deviceInfoMSD[device].endpointIN       = endpointIN;
                         deviceInfoMSD[device].endpointOUT      = endpointOUT;
+                        #if defined( USB_MSD_QUEUE_DEPTH )
+                            for (i=0; i<USB_MSD_QUEUE_DEPTH; i++)
+                            {
+                                deviceInfoMSD[device].queue[i].status = QUEUE_ENTRY_FREE;
+                            }
+                            deviceInfoMSD[device].pendingHead      = 0;
+                            deviceInfoMSD[device].pendingCount     = 0;
+                            deviceInfoMSD[device].activeCommand    = QUEUE_NO_ENTRY;
+                            deviceInfoMSD[device].transferCommand  = QUEUE_NO_ENTRY;
+                            memset( &deviceInfoMSD[device].queueStats, 0, sizeof(USB_MSD_QUEUE_STATS) );
+                        #endif
                         #ifdef DEBUG_MODE
                             UART2PrintString( "MSD: Bulk endpoint IN: " );
                             UART2PutHex( endpointIN );
@@ -1614,7 +1923,6 @@ bool USBHostMSDEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
                                 }
                             }
                         }
-                        return true;
                         break;
 
                     case STATE_TRANSFER_WAIT:
@@ -1754,6 +2062,14 @@ bool USBHostMSDEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
                     case STATE_HOLDING:
                         break;
                 }
+
+                #if defined( USB_MSD_QUEUE_DEPTH )
+                    // Send the next queued CBW as soon as the device is idle.
+                    if (deviceInfoMSD[i].state == STATE_RUNNING)
+                    {
+                        _USBHostMSD_StartCommand( i );
+                    }
+                #endif
             #endif
 
         case EVENT_SOF:              // Start of frame - NOT NEEDED
@@ -1906,6 +2222,14 @@ bool USBHostMSDEventHandler( uint8_t address, USB_EVENT event, void *data, uint3
                 case STATE_HOLDING:
                     break;
             }
+
+            #if defined( USB_MSD_QUEUE_DEPTH )
+                // Send the next queued CBW as soon as the device is idle.
+                if (deviceInfoMSD[i].state == STATE_RUNNING)
+                {
+                    _USBHostMSD_StartCommand( i );
+                }
+            #endif
             return true;
             #endif
         default:
@@ -2075,3 +2399,305 @@ void _USBHostMSD_ResetStateJump( uint8_t i )
 }
 
 
+#if defined( USB_MSD_QUEUE_DEPTH )
+
+/****************************************************************************
+  Function:
+    uint8_t _USBHostMSD_QueueCommand( uint8_t i, uint8_t deviceLUN, uint8_t direction,
+                uint8_t *commandBlock, uint8_t commandBlockLength, uint8_t *data,
+                uint32_t dataLength, uint8_t *command )
+
+  Description:
+    This function prepares the CBW of a command in a free queue entry and
+    adds the entry to the end of the pending list.  If the device is idle,
+    the command is started.
+
+  Precondition:
+    The device information must be in the deviceInfoMSD array.
+
+  Parameters:
+    uint8_t i                  - Index into the deviceInfoMSD structure
+    uint8_t deviceLUN          - Device LUN to access
+    uint8_t direction          - 1=read, 0=write
+    uint8_t *commandBlock      - Pointer to the command block for the CBW
+    uint8_t commandBlockLength - Length of the command block
+    uint8_t *data              - Pointer to the data buffer
+    uint32_t dataLength        - Byte size of the data buffer
+    uint8_t *command           - Returns the queue entry used, only if the
+                                 command was queued
+
+  Return Values:
+    USB_SUCCESS                 - Command queued
+    USB_MSD_DEVICE_BUSY         - The queue is full, or the device is not
+                                    running
+    USB_MSD_INVALID_LUN         - Specified LUN does not exist
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint8_t _USBHostMSD_QueueCommand( uint8_t i, uint8_t deviceLUN, uint8_t direction, uint8_t *commandBlock,
+                        uint8_t commandBlockLength, uint8_t *data, uint32_t dataLength, uint8_t *command )
+{
+    USB_MSD_QUEUE_ENTRY *pCommand;
+    uint8_t             j;
+    uint8_t             queued;
+    uint8_t             slot;
+    uint8_t             status;
+
+    // Commands can be queued while the device is running or recovering from
+    // an error.  They are started when the device is idle again.
+    status = USBHostMSDDeviceStatus( deviceInfoMSD[i].deviceAddress );
+    if ((status != USB_MSD_NORMAL_RUNNING) && (status != USB_MSD_RESETTING_DEVICE))
+    {
+        return USB_MSD_DEVICE_BUSY;
+    }
+
+    // Verify the selected LUN.
+    if (deviceLUN > deviceInfoMSD[i].maxLUN)
+    {
+        return USB_MSD_INVALID_LUN;
+    }
+
+    for (slot=0; (slot<USB_MSD_QUEUE_DEPTH) && (deviceInfoMSD[i].queue[slot].status != QUEUE_ENTRY_FREE); slot++);
+    if (slot == USB_MSD_QUEUE_DEPTH)
+    {
+        return USB_MSD_DEVICE_BUSY;
+    }
+
+    // Prepare the CBW now, so that it can be sent as soon as the device is
+    // done with the command ahead of it.
+    pCommand = &deviceInfoMSD[i].queue[slot];
+    pCommand->cbw.dCBWSignature             = USB_MSD_DCBWSIGNATURE;
+    pCommand->cbw.dCBWTag                   = _USBHostMSD_GetNextTag();
+    pCommand->cbw.dCBWDataTransferLength    = dataLength;
+    pCommand->cbw.bmCBWflags.val            = 0;
+    pCommand->cbw.bmCBWflags.bfDirection    = direction;
+    pCommand->cbw.bCBWLUN                   = deviceLUN;
+    pCommand->cbw.bCBWCBLength              = commandBlockLength;
+    for (j=0; j<commandBlockLength; j++)
+    {
+        pCommand->cbw.CBWCB[j]              = commandBlock[j];
+    }
+    pCommand->userData                      = data;
+    pCommand->bytesTransferred              = 0;
+    pCommand->queuedFrame                   = USBHostGetFrameNumber();
+    pCommand->errorCode                     = USB_SUCCESS;
+    pCommand->status                        = QUEUE_ENTRY_QUEUED;
+
+    j = deviceInfoMSD[i].pendingHead + deviceInfoMSD[i].pendingCount;
+    if (j >= USB_MSD_QUEUE_DEPTH)
+    {
+        j -= USB_MSD_QUEUE_DEPTH;
+    }
+    deviceInfoMSD[i].pending[j] = slot;
+    deviceInfoMSD[i].pendingCount++;
+
+    queued = deviceInfoMSD[i].pendingCount + (deviceInfoMSD[i].activeCommand != QUEUE_NO_ENTRY);
+    if (queued > deviceInfoMSD[i].queueStats.highWater)
+    {
+        deviceInfoMSD[i].queueStats.highWater = queued;
+    }
+
+    *command = slot;
+
+    #ifndef USB_ENABLE_TRANSFER_EVENT
+        if (deviceInfoMSD[i].state == (STATE_RUNNING | SUBSTATE_HOLDING))
+    #else
+        if (deviceInfoMSD[i].state == STATE_RUNNING)
+    #endif
+    {
+        _USBHostMSD_StartCommand( i );
+    }
+
+    return USB_SUCCESS;
+}
+
+
+/****************************************************************************
+  Function:
+    void _USBHostMSD_StartCommand( uint8_t i )
+
+  Description:
+    This function takes the oldest command off the pending list and starts
+    it.  The prepared CBW is copied into the device buffer, and the transfer
+    information is loaded from the queue entry.
+
+  Precondition:
+    The device is idle: no command is active.
+
+  Parameters:
+    uint8_t i  - Index into the deviceInfoMSD structure for the device.
+
+  Returns:
+    None
+
+  Remarks:
+    With transfer events, the CBW is written here.  If that fails, the
+    command completes with the error and the next one is tried.  When
+    polling, USBHostMSDTasks() writes the CBW.
+  ***************************************************************************/
+
+void _USBHostMSD_StartCommand( uint8_t i )
+{
+    USB_MSD_QUEUE_ENTRY *pCommand;
+    #ifdef USB_ENABLE_TRANSFER_EVENT
+        uint8_t         errorCode;
+    #endif
+
+    while (deviceInfoMSD[i].pendingCount != 0)
+    {
+        deviceInfoMSD[i].activeCommand = deviceInfoMSD[i].pending[deviceInfoMSD[i].pendingHead];
+        deviceInfoMSD[i].pendingHead++;
+        if (deviceInfoMSD[i].pendingHead == USB_MSD_QUEUE_DEPTH)
+        {
+            deviceInfoMSD[i].pendingHead = 0;
+        }
+        deviceInfoMSD[i].pendingCount--;
+
+        pCommand = &deviceInfoMSD[i].queue[deviceInfoMSD[i].activeCommand];
+        pCommand->status = QUEUE_ENTRY_ACTIVE;
+
+        // Initialize the transfer information.
+        deviceInfoMSD[i].attemptsCSW       = CSW_RECEIVE_ATTEMPTS;
+        deviceInfoMSD[i].bytesTransferred  = 0;
+        deviceInfoMSD[i].errorCode         = USB_SUCCESS;
+        deviceInfoMSD[i].flags.val         = 0;
+        deviceInfoMSD[i].flags.bfDirection = pCommand->cbw.bmCBWflags.bfDirection;
+        deviceInfoMSD[i].userData          = pCommand->userData;
+        deviceInfoMSD[i].userDataLength    = pCommand->cbw.dCBWDataTransferLength;
+        deviceInfoMSD[i].dCBWTag           = pCommand->cbw.dCBWTag;
+        deviceInfoMSD[i].endpointDATA      = deviceInfoMSD[i].endpointIN;
+        if (!deviceInfoMSD[i].flags.bfDirection) // OUT
+        {
+            deviceInfoMSD[i].endpointDATA  = deviceInfoMSD[i].endpointOUT;
+        }
+        memcpy( deviceInfoMSD[i].block.data, &pCommand->cbw, CBW_SIZE );
+
+        #ifndef USB_ENABLE_TRANSFER_EVENT
+            deviceInfoMSD[i].state = STATE_RUNNING | SUBSTATE_SEND_CBW;
+            return;
+        #else
+            errorCode = USBHostWrite( deviceInfoMSD[i].deviceAddress, deviceInfoMSD[i].endpointOUT, deviceInfoMSD[i].block.data, CBW_SIZE );
+            if (!errorCode)
+            {
+                deviceInfoMSD[i].state = STATE_CBW_WAIT;
+                return;
+            }
+            deviceInfoMSD[i].errorCode = errorCode;
+            _USBHostMSD_CommandComplete( i );
+        #endif
+    }
+}
+
+
+/****************************************************************************
+  Function:
+    void _USBHostMSD_CommandComplete( uint8_t i )
+
+  Description:
+    This function records the result of the active command in its queue
+    entry, and adds its latency to the queue statistics.
+
+  Precondition:
+    The device information must be in the deviceInfoMSD array.
+
+  Parameters:
+    uint8_t i  - Index into the deviceInfoMSD structure for the device.
+
+  Returns:
+    None
+
+  Remarks:
+    Called whenever a transfer terminates.  Does nothing if the transfer
+    was not started from the queue, e.g. after a reset error.
+  ***************************************************************************/
+
+void _USBHostMSD_CommandComplete( uint8_t i )
+{
+    USB_MSD_QUEUE_ENTRY *pCommand;
+    uint16_t            frames;
+
+    if (deviceInfoMSD[i].activeCommand == QUEUE_NO_ENTRY)
+    {
+        return;
+    }
+
+    pCommand = &deviceInfoMSD[i].queue[deviceInfoMSD[i].activeCommand];
+    deviceInfoMSD[i].activeCommand = QUEUE_NO_ENTRY;
+
+    frames = USBHostGetFrameNumber() - pCommand->queuedFrame;
+    pCommand->errorCode         = deviceInfoMSD[i].errorCode;
+    pCommand->bytesTransferred  = deviceInfoMSD[i].bytesTransferred;
+    pCommand->frames            = frames;
+    pCommand->status            = QUEUE_ENTRY_DONE;
+
+    deviceInfoMSD[i].queueStats.commands++;
+    if (pCommand->errorCode != USB_SUCCESS)
+    {
+        deviceInfoMSD[i].queueStats.errors++;
+    }
+    deviceInfoMSD[i].queueStats.totalFrames += frames;
+    deviceInfoMSD[i].queueStats.lastFrames   = frames;
+    if (frames > deviceInfoMSD[i].queueStats.maxFrames)
+    {
+        deviceInfoMSD[i].queueStats.maxFrames = frames;
+    }
+}
+
+
+/****************************************************************************
+  Function:
+    bool _USBHostMSD_CommandIsComplete( uint8_t i, uint8_t command,
+                uint8_t *errorCode, uint32_t *byteCount, uint16_t *frames )
+
+  Description:
+    This function returns the result of a queued command once it is done,
+    and frees its queue entry.
+
+  Precondition:
+    The device information must be in the deviceInfoMSD array.
+
+  Parameters:
+    uint8_t i          - Index into the deviceInfoMSD structure
+    uint8_t command    - Queue entry of the command
+    uint8_t *errorCode - Error code of the command
+    uint32_t *byteCount - Number of bytes transferred
+    uint16_t *frames   - Latency of the command in frames.  May be NULL.
+
+  Return Values:
+    true    - Command is complete, or the entry is not in use
+              (USB_MSD_ILLEGAL_REQUEST)
+    false   - Command is queued or active
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+bool _USBHostMSD_CommandIsComplete( uint8_t i, uint8_t command, uint8_t *errorCode, uint32_t *byteCount, uint16_t *frames )
+{
+    USB_MSD_QUEUE_ENTRY *pCommand;
+
+    pCommand = &deviceInfoMSD[i].queue[command];
+    if (pCommand->status == QUEUE_ENTRY_FREE)
+    {
+        *errorCode = USB_MSD_ILLEGAL_REQUEST;
+        *byteCount = 0;
+        return true;
+    }
+    if (pCommand->status != QUEUE_ENTRY_DONE)
+    {
+        return false;
+    }
+
+    *errorCode = pCommand->errorCode;
+    *byteCount = pCommand->bytesTransferred;
+    if (frames != NULL)
+    {
+        *frames = pCommand->frames;
+    }
+    pCommand->status = QUEUE_ENTRY_FREE;
+    return true;
+}
+
+#endif
@@ -81,6 +81,20 @@ Change History:
 #define INITIALIZATION_ATTEMPTS     100         // How many times to try to initialize the media before failing
 #define RDPROTECT_NORMAL            0x00        // Normal Read Protect behavior.
 #define WRPROTECT_NORMAL            0x00        // Normal Write Protect behavior.
+#define SCSI_READ_10                0x28        // READ10 operation code
+#define SCSI_WRITE_10               0x2A        // WRITE10 operation code
+
+#if defined( USB_MSD_SCSI_CACHE_SECTORS )
+    #if (USB_MSD_SCSI_CACHE_SECTORS < 1) || (USB_MSD_SCSI_CACHE_SECTORS > 255)
+        #error "USB_MSD_SCSI_CACHE_SECTORS must be between 1 and 255."
+    #endif
+    #if !defined( USB_MSD_SCSI_CACHE_SECTOR_SIZE )
+        #define USB_MSD_SCSI_CACHE_SECTOR_SIZE  512
+    #endif
+
+    #define CACHE_SECTOR_VALID      0x01        // The cache slot holds the sector's data.
+    #define CACHE_SECTOR_DIRTY      0x02        // The cache slot was written and not yet flushed.
+#endif
 
 
 //******************************************************************************
@@ -101,6 +115,20 @@ Change History:
     bool    _USBHostMSDSCSI_TestUnitReady( uint8_t * address );
 #endif
 
+static bool _USBHostMSDSCSI_ReadWrite10( uint8_t * address, uint8_t operationCode, uint32_t sectorAddress,
+                uint16_t sectorCount, uint8_t *dataBuffer );
+
+#if defined( USB_MSD_SCSI_CACHE_SECTORS )
+    static void _USBHostMSDSCSI_CacheInvalidate( void );
+    static bool _USBHostMSDSCSI_CacheFlush( uint8_t * address );
+    static bool _USBHostMSDSCSI_CacheRead( uint8_t * address, uint32_t sectorAddress, uint8_t *dataBuffer );
+    static bool _USBHostMSDSCSI_CacheWrite( uint8_t * address, uint32_t sectorAddress, uint8_t *dataBuffer );
+
+    // The cache is only used when its slots are exactly one media sector, so
+    // that a run of slots can be sent as one transfer.
+    #define _USBHostMSDSCSI_CacheUsable()   (mediaInformation.sectorSize == USB_MSD_SCSI_CACHE_SECTOR_SIZE)
+#endif
+
 
 //******************************************************************************
 //******************************************************************************
@@ -113,6 +141,15 @@ Change History:
 //******************************************************************************
 
 static FILEIO_MEDIA_INFORMATION   mediaInformation;   // Information about the attached media.
+static uint32_t                   mediaLastSector;    // Last LBA of the media, from READ CAPACITY 10.
+
+#if defined( USB_MSD_SCSI_CACHE_SECTORS )
+    static uint8_t  cacheData[USB_MSD_SCSI_CACHE_SECTORS][USB_MSD_SCSI_CACHE_SECTOR_SIZE];
+    static uint8_t  cacheFlags[USB_MSD_SCSI_CACHE_SECTORS];    // CACHE_SECTOR_xxx flags of each slot
+    static uint32_t cacheSectorAddress;                         // Sector held by slot 0
+    static uint32_t cacheNextSector;                            // Sector after the last one read, to detect sequential reads
+    static uint8_t  cacheDirtySectors;                          // Number of slots marked CACHE_SECTOR_DIRTY
+#endif
 
 // *****************************************************************************
 // *****************************************************************************
@@ -218,6 +255,10 @@ bool USBHostMSDSCSIEventHandler( uint8_t address, USB_EVENT event, void *data, u
             #endif
             address                           = 0;
             mediaInformation.validityFlags.value    = 0;
+            #if defined( USB_MSD_SCSI_CACHE_SECTORS )
+                // Anything not yet flushed is lost with the device.
+                _USBHostMSDSCSI_CacheInvalidate();
+            #endif
             return true;
             break;
 
@@ -393,6 +434,10 @@ FILEIO_MEDIA_INFORMATION * USBHostMSDSCSIMediaInitialize( uint8_t * address )
             #endif
             mediaInformation.sectorSize                     = (inquiryData[7] << 12) + (inquiryData[6] << 8) + (inquiryData[5] << 4) + (inquiryData[4]);
             mediaInformation.validityFlags.bits.sectorSize  = 1;
+            mediaLastSector = ((uint32_t)inquiryData[0] << 24) | ((uint32_t)inquiryData[1] << 16) | ((uint32_t)inquiryData[2] << 8) | inquiryData[3];
+            #if defined( USB_MSD_SCSI_CACHE_SECTORS )
+                _USBHostMSDSCSI_CacheInvalidate();
+            #endif
 
             mediaInformation.errorCode = MEDIA_NO_ERROR;
             return &mediaInformation;
@@ -539,6 +584,10 @@ FILEIO_MEDIA_INFORMATION * USBHostMSDSCSIMediaInitialize( uint8_t * address )
             #endif
             mediaInformation.sectorSize                     = (inquiryData[7] << 12) + (inquiryData[6] << 8) + (inquiryData[5] << 4) + (inquiryData[4]);
             mediaInformation.validityFlags.bits.sectorSize  = 1;
+            mediaLastSector = ((uint32_t)inquiryData[0] << 24) | ((uint32_t)inquiryData[1] << 16) | ((uint32_t)inquiryData[2] << 8) | inquiryData[3];
+            #if defined( USB_MSD_SCSI_CACHE_SECTORS )
+                _USBHostMSDSCSI_CacheInvalidate();
+            #endif
 
             mediaInformation.errorCode = MEDIA_NO_ERROR;
             return &mediaInformation;
@@ -658,6 +707,11 @@ uint8_t USBHostMSDSCSIMediaReset( uint8_t * address )
     false   - read was not successful
 
   Remarks:
+    If USB_MSD_SCSI_CACHE_SECTORS is defined, the sector is read through the
+    sector cache.  A miss that continues the previous read reads ahead to
+    fill the cache; see USBHostMSDSCSISectorsRead() to read a known range in
+    one command.
+
     The READ10 command block is as follows:
 
     <code>
@@ -677,10 +731,6 @@ uint8_t USBHostMSDSCSIMediaReset( uint8_t * address )
 
 uint8_t USBHostMSDSCSISectorRead(uint8_t * address, uint32_t sectorAddress, uint8_t *dataBuffer )
 {
-    uint32_t   byteCount;
-    uint8_t    commandBlock[10];
-    uint8_t    errorCode;
-
     #ifdef DEBUG_MODE
         UART2PrintString( "SCSI: Reading sector " );
         UART2PutHex(sectorAddress >> 24);
@@ -697,51 +747,17 @@ uint8_t USBHostMSDSCSISectorRead(uint8_t * address, uint32_t sectorAddress, uint
         return false;       // USB_MSD_DEVICE_NOT_FOUND;
     }
 
-    // Fill in the command block with the READ10 parameters.
-    commandBlock[0] = 0x28;     // Operation code
-    commandBlock[1] = RDPROTECT_NORMAL | FUA_ALLOW_CACHE;
-    commandBlock[2] = (uint8_t) (sectorAddress >> 24);     // Big endian!
-    commandBlock[3] = (uint8_t) (sectorAddress >> 16);
-    commandBlock[4] = (uint8_t) (sectorAddress >> 8);
-    commandBlock[5] = (uint8_t) (sectorAddress);
-    commandBlock[6] = 0x00;     // Group Number
-    commandBlock[7] = 0x00;     // Number of blocks - Big endian!
-    commandBlock[8] = 0x01;
-    commandBlock[9] = 0x00;     // Control
-
-    // Currently using LUN=0.  When the File System supports multiple LUN's, this will change.
-    errorCode = USBHostMSDRead( *address, 0, commandBlock, 10, dataBuffer, mediaInformation.sectorSize );
-    #ifdef DEBUG_MODE
-        UART2PrintString( "SCSI: Read sector init error " );
-        UART2PutHex( errorCode );
-        UART2PrintString( "\r\n" );
-    #endif
-
-    if (!errorCode)
-    {
-        while (!USBHostMSDTransferIsComplete( *address, &errorCode, &byteCount ))
+    #if defined( USB_MSD_SCSI_CACHE_SECTORS )
+        if (_USBHostMSDSCSI_CacheUsable())
         {
-            USBTasks();
+            return _USBHostMSDSCSI_CacheRead( address, sectorAddress, dataBuffer );
         }
-    }
-
-    #ifdef DEBUG_MODE
-        UART2PrintString( "SCSI: Read sector error " );
-        UART2PutHex( errorCode );
-        UART2PrintString( "\r\n" );
     #endif
 
-    if (!errorCode)
-    {
-        return true;
-    }
-    else
-    {
-//        USBHostMSDSCSIMediaReset();
-        return false;
-    }
+    return _USBHostMSDSCSI_ReadWrite10( address, SCSI_READ_10, sectorAddress, 1, dataBuffer );
 }
 
+
 /****************************************************************************
   Function:
     uint8_t USBHostMSDSCSISectorWrite( uint32_t sectorAddress, uint8_t *dataBuffer, uint8_t allowWriteToZero )
@@ -768,6 +784,9 @@ uint8_t USBHostMSDSCSISectorRead(uint8_t * address, uint32_t sectorAddress, uint
 
   Remarks:
     To follow convention, this function blocks until the write is complete.
+    If USB_MSD_SCSI_CACHE_SECTORS is defined, the sector is only copied into
+    the sector cache, and reaches the media when the cache is flushed; see
+    USBHostMSDSCSICacheFlush().
 
     The WRITE10 command block is as follows:
 
@@ -788,10 +807,6 @@ uint8_t USBHostMSDSCSISectorRead(uint8_t * address, uint32_t sectorAddress, uint
 
 uint8_t USBHostMSDSCSISectorWrite(uint8_t * address, uint32_t sectorAddress, uint8_t *dataBuffer, uint8_t allowWriteToZero )
 {
-    uint32_t   byteCount;
-    uint8_t    commandBlock[10];
-    uint8_t    errorCode;
-
     #ifdef DEBUG_MODE
         UART2PrintString( "SCSI: Writing sector " );
         UART2PutHex(sectorAddress >> 24);
@@ -813,49 +828,187 @@ uint8_t USBHostMSDSCSISectorWrite(uint8_t * address, uint32_t sectorAddress, uin
         return false;
     }
 
-    // Fill in the command block with the WRITE 10 parameters.
-    commandBlock[0] = 0x2A;     // Operation code
-    commandBlock[1] = WRPROTECT_NORMAL | FUA_ALLOW_CACHE;
-    commandBlock[2] = (uint8_t) (sectorAddress >> 24);     // Big endian!
-    commandBlock[3] = (uint8_t) (sectorAddress >> 16);
-    commandBlock[4] = (uint8_t) (sectorAddress >> 8);
-    commandBlock[5] = (uint8_t) (sectorAddress);
-    commandBlock[6] = 0x00;     // Group Number
-    commandBlock[7] = 0x00;     // Number of blocks - Big endian!
-    commandBlock[8] = 0x01;
-    commandBlock[9] = 0x00;     // Control
-
-    // Currently using LUN=0.  When the File System supports multiple LUN's, this will change.
-    errorCode = USBHostMSDWrite( *address, 0, commandBlock, 10, dataBuffer, mediaInformation.sectorSize );
-    #ifdef DEBUG_MODE
-        UART2PrintString( "SCSI: Write sector init error " );
-        UART2PutHex( errorCode );
-        UART2PrintString( "\r\n" );
+    #if defined( USB_MSD_SCSI_CACHE_SECTORS )
+        if (_USBHostMSDSCSI_CacheUsable())
+        {
+            return _USBHostMSDSCSI_CacheWrite( address, sectorAddress, dataBuffer );
+        }
     #endif
 
-    if (!errorCode)
+    return _USBHostMSDSCSI_ReadWrite10( address, SCSI_WRITE_10, sectorAddress, 1, dataBuffer );
+}
+
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostMSDSCSISectorsRead( uint8_t * address, uint32_t sectorAddress,
+                uint16_t sectorCount, uint8_t *dataBuffer )
+
+  Summary:
+    This function reads several contiguous sectors.
+
+  Description:
+    This function uses one SCSI READ10 command to read sectorCount sectors,
+    starting at sectorAddress.  The device sees a single command/data/status
+    round trip instead of one per sector.  The data is stored in the
+    application buffer, which must hold sectorCount times the sector size
+    determined in USBHostMSDSCSIMediaInitialize().
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t * address - Endpoint address of the device
+    uint32_t   sectorAddress   - address of the first sector to read
+    uint16_t   sectorCount     - number of sectors to read
+    uint8_t    *dataBuffer     - buffer to store data
+
+  Return Values:
+    true    - read performed successfully
+    false   - read was not successful
+
+  Remarks:
+    If the sector cache is enabled, sectors in the range that are waiting to
+    be written are flushed first.  The data itself bypasses the cache.
+  ***************************************************************************/
+
+uint8_t USBHostMSDSCSISectorsRead( uint8_t * address, uint32_t sectorAddress, uint16_t sectorCount, uint8_t *dataBuffer )
+{
+    if (*address == 0)
     {
-        while (!USBHostMSDTransferIsComplete( *address, &errorCode, &byteCount ))
-        {
-            USBTasks();
-        }
+        return false;       // USB_MSD_DEVICE_NOT_FOUND;
     }
 
-    #ifdef DEBUG_MODE
-        UART2PrintString( "SCSI: Write sector error " );
-        UART2PutHex( errorCode );
-        UART2PrintString( "\r\n" );
+    if (sectorCount == 0)
+    {
+        return true;
+    }
+
+    #if defined( USB_MSD_SCSI_CACHE_SECTORS )
+        if ((cacheDirtySectors != 0) &&
+            (sectorAddress < cacheSectorAddress + USB_MSD_SCSI_CACHE_SECTORS) &&
+            (cacheSectorAddress < sectorAddress + sectorCount))
+        {
+            if (!_USBHostMSDSCSI_CacheFlush( address ))
+            {
+                return false;
+            }
+        }
     #endif
 
-    if (!errorCode)
+    return _USBHostMSDSCSI_ReadWrite10( address, SCSI_READ_10, sectorAddress, sectorCount, dataBuffer );
+}
+
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostMSDSCSISectorsWrite( uint8_t * address, uint32_t sectorAddress,
+                uint16_t sectorCount, uint8_t *dataBuffer, uint8_t allowWriteToZero )
+
+  Summary:
+    This function writes several contiguous sectors.
+
+  Description:
+    This function uses one SCSI WRITE10 command to write sectorCount sectors,
+    starting at sectorAddress.  The data is read from the application
+    buffer, which must hold sectorCount times the sector size determined in
+    USBHostMSDSCSIMediaInitialize().
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t * address - Endpoint address of the device
+    uint32_t   sectorAddress   - address of the first sector to write
+    uint16_t   sectorCount     - number of sectors to write
+    uint8_t    *dataBuffer     - buffer with application data
+    uint8_t    allowWriteToZero- If a write to sector 0 is allowed.
+
+  Return Values:
+    true    - write performed successfully
+    false   - write was not successful
+
+  Remarks:
+    This function blocks until the write is complete.  The data is written
+    through to the media even if the sector cache is enabled; any cached
+    copy of the range is flushed and dropped first.
+  ***************************************************************************/
+
+uint8_t USBHostMSDSCSISectorsWrite( uint8_t * address, uint32_t sectorAddress, uint16_t sectorCount, uint8_t *dataBuffer, uint8_t allowWriteToZero )
+{
+    if (*address == 0)
     {
-        return true;
+        return false;   //USB_MSD_DEVICE_NOT_FOUND;
     }
-    else
+
+    if ((sectorAddress == 0) && (allowWriteToZero == false))
     {
-//        USBHostMSDSCSIMediaReset();
         return false;
     }
+
+    if (sectorCount == 0)
+    {
+        return true;
+    }
+
+    #if defined( USB_MSD_SCSI_CACHE_SECTORS )
+        if ((sectorAddress < cacheSectorAddress + USB_MSD_SCSI_CACHE_SECTORS) &&
+            (cacheSectorAddress < sectorAddress + sectorCount))
+        {
+            if (!_USBHostMSDSCSI_CacheFlush( address ))
+            {
+                return false;
+            }
+            _USBHostMSDSCSI_CacheInvalidate();
+        }
+    #endif
+
+    return _USBHostMSDSCSI_ReadWrite10( address, SCSI_WRITE_10, sectorAddress, sectorCount, dataBuffer );
+}
+
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostMSDSCSICacheFlush( uint8_t * address )
+
+  Summary:
+    This function writes any cached sectors to the media.
+
+  Description:
+    When the sector cache is enabled, USBHostMSDSCSISectorWrite() only
+    copies the sector into the cache.  Written sectors reach the media when
+    the cache needs the space for other sectors, or when this function is
+    called.  Each run of contiguous written sectors is sent with one WRITE10
+    command.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t * address - Endpoint address of the device
+
+  Return Values:
+    true    - all written sectors are on the media
+    false   - a write was not successful; the sectors stay in the cache
+
+  Remarks:
+    Call this after closing files and before the media is removed.  Sectors
+    still in the cache when the device detaches are lost.  If the cache is
+    not enabled, this function does nothing and returns true.
+  ***************************************************************************/
+
+uint8_t USBHostMSDSCSICacheFlush( uint8_t * address )
+{
+    #if defined( USB_MSD_SCSI_CACHE_SECTORS )
+        if (*address == 0)
+        {
+            return false;   //USB_MSD_DEVICE_NOT_FOUND;
+        }
+
+        return _USBHostMSDSCSI_CacheFlush( address );
+    #else
+        return true;
+    #endif
 }
 
 
@@ -978,3 +1131,308 @@ bool _USBHostMSDSCSI_TestUnitReady( uint8_t * address)
 }
 #endif
 
+
+/*******************************************************************************
+  Function:
+    static bool _USBHostMSDSCSI_ReadWrite10( uint8_t * address, uint8_t operationCode,
+                uint32_t sectorAddress, uint16_t sectorCount, uint8_t *dataBuffer )
+
+  Precondition:
+    None
+
+  Overview:
+    This function sends a READ10 or WRITE10 command for sectorCount
+    contiguous sectors and waits until the command completes.
+
+  Parameters:
+    uint8_t * address       - Endpoint address of the device
+    uint8_t operationCode   - SCSI_READ_10 or SCSI_WRITE_10
+    uint32_t sectorAddress  - address of the first sector
+    uint16_t sectorCount    - number of sectors, at least one
+    uint8_t *dataBuffer     - sectorCount sectors of data
+
+  Return Values:
+    true    - Command completed without error
+    false   - Error while performing command
+
+  Remarks:
+    The command blocks are shown in USBHostMSDSCSISectorRead() and
+    USBHostMSDSCSISectorWrite().
+  ***************************************************************************/
+
+static bool _USBHostMSDSCSI_ReadWrite10( uint8_t * address, uint8_t operationCode, uint32_t sectorAddress,
+                uint16_t sectorCount, uint8_t *dataBuffer )
+{
+    uint32_t   byteCount;
+    uint8_t    commandBlock[10];
+    uint8_t    errorCode;
+    uint32_t   dataLength;
+
+    // Fill in the command block with the READ10 or WRITE10 parameters.
+    commandBlock[0] = operationCode;
+    commandBlock[1] = ((operationCode == SCSI_READ_10) ? RDPROTECT_NORMAL : WRPROTECT_NORMAL) | FUA_ALLOW_CACHE;
+    commandBlock[2] = (uint8_t) (sectorAddress >> 24);     // Big endian!
+    commandBlock[3] = (uint8_t) (sectorAddress >> 16);
+    commandBlock[4] = (uint8_t) (sectorAddress >> 8);
+    commandBlock[5] = (uint8_t) (sectorAddress);
+    commandBlock[6] = 0x00;     // Group Number
+    commandBlock[7] = (uint8_t) (sectorCount >> 8);        // Number of blocks - Big endian!
+    commandBlock[8] = (uint8_t) (sectorCount);
+    commandBlock[9] = 0x00;     // Control
+
+    dataLength = (uint32_t)sectorCount * mediaInformation.sectorSize;
+
+    // Currently using LUN=0.  When the File System supports multiple LUN's, this will change.
+    if (operationCode == SCSI_READ_10)
+    {
+        errorCode = USBHostMSDRead( *address, 0, commandBlock, 10, dataBuffer, dataLength );
+    }
+    else
+    {
+        errorCode = USBHostMSDWrite( *address, 0, commandBlock, 10, dataBuffer, dataLength );
+    }
+    #ifdef DEBUG_MODE
+        UART2PrintString( "SCSI: Read/write init error " );
+        UART2PutHex( errorCode );
+        UART2PrintString( "\r\n" );
+    #endif
+
+    if (!errorCode)
+    {
+        while (!USBHostMSDTransferIsComplete( *address, &errorCode, &byteCount ))
+        {
+            USBTasks();
+        }
+    }
+
+    #ifdef DEBUG_MODE
+        UART2PrintString( "SCSI: Read/write error " );
+        UART2PutHex( errorCode );
+        UART2PrintString( "\r\n" );
+    #endif
+
+    if (!errorCode)
+    {
+        return true;
+    }
+    else
+    {
+//        USBHostMSDSCSIMediaReset();
+        return false;
+    }
+}
+
+
+#if defined( USB_MSD_SCSI_CACHE_SECTORS )
+
+/*******************************************************************************
+  Function:
+    static void _USBHostMSDSCSI_CacheInvalidate( void )
+
+  Precondition:
+    None
+
+  Overview:
+    This function empties the sector cache, dropping any sectors that have
+    not been flushed.
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static void _USBHostMSDSCSI_CacheInvalidate( void )
+{
+    memset( cacheFlags, 0, sizeof(cacheFlags) );
+    cacheDirtySectors   = 0;
+    cacheSectorAddress  = 0;
+    cacheNextSector     = 0;
+}
+
+
+/*******************************************************************************
+  Function:
+    static bool _USBHostMSDSCSI_CacheFlush( uint8_t * address )
+
+  Precondition:
+    None
+
+  Overview:
+    This function writes the dirty sectors of the cache to the media.  Each
+    run of contiguous dirty slots is one WRITE10 command.
+
+  Parameters:
+    uint8_t * address - Endpoint address of the device
+
+  Return Values:
+    true    - No dirty sectors remain
+    false   - A write failed; the unwritten sectors stay dirty
+
+  Remarks:
+    The flushed sectors stay in the cache as valid, clean sectors.
+  ***************************************************************************/
+
+static bool _USBHostMSDSCSI_CacheFlush( uint8_t * address )
+{
+    uint16_t    first;
+    uint16_t    last;
+
+    first = 0;
+    while ((cacheDirtySectors != 0) && (first < USB_MSD_SCSI_CACHE_SECTORS))
+    {
+        if (!(cacheFlags[first] & CACHE_SECTOR_DIRTY))
+        {
+            first ++;
+            continue;
+        }
+
+        last = first;
+        while ((last + 1 < USB_MSD_SCSI_CACHE_SECTORS) && (cacheFlags[last + 1] & CACHE_SECTOR_DIRTY))
+        {
+            last ++;
+        }
+
+        if (!_USBHostMSDSCSI_ReadWrite10( address, SCSI_WRITE_10, cacheSectorAddress + first,
+                last - first + 1, cacheData[first] ))
+        {
+            return false;
+        }
+
+        for ( ; first <= last; first++)
+        {
+            cacheFlags[first] &= ~CACHE_SECTOR_DIRTY;
+            cacheDirtySectors --;
+        }
+    }
+
+    return true;
+}
+
+
+/*******************************************************************************
+  Function:
+    static bool _USBHostMSDSCSI_CacheRead( uint8_t * address, uint32_t sectorAddress,
+                uint8_t *dataBuffer )
+
+  Precondition:
+    The media sector size matches USB_MSD_SCSI_CACHE_SECTOR_SIZE.
+
+  Overview:
+    This function reads one sector through the cache.  On a miss, the cache
+    is flushed and refilled starting at the requested sector.  If the miss
+    continues the previous read, the refill reads ahead to fill the whole
+    cache with one READ10 command; otherwise only the one sector is read.
+
+  Parameters:
+    uint8_t * address       - Endpoint address of the device
+    uint32_t sectorAddress  - address of sector to read
+    uint8_t *dataBuffer     - buffer to store data
+
+  Return Values:
+    true    - read performed successfully
+    false   - read was not successful
+
+  Remarks:
+    Read-ahead stops at the last sector reported by READ CAPACITY 10.
+  ***************************************************************************/
+
+static bool _USBHostMSDSCSI_CacheRead( uint8_t * address, uint32_t sectorAddress, uint8_t *dataBuffer )
+{
+    uint32_t    slot;
+    uint16_t    count;
+
+    slot = sectorAddress - cacheSectorAddress;
+    if ((sectorAddress < cacheSectorAddress) || (slot >= USB_MSD_SCSI_CACHE_SECTORS) ||
+        !(cacheFlags[slot] & CACHE_SECTOR_VALID))
+    {
+        if (!_USBHostMSDSCSI_CacheFlush( address ))
+        {
+            return false;
+        }
+
+        count = 1;
+        if ((sectorAddress == cacheNextSector) && (sectorAddress <= mediaLastSector))
+        {
+            count = USB_MSD_SCSI_CACHE_SECTORS;
+            if (mediaLastSector - sectorAddress < count)
+            {
+                count = mediaLastSector - sectorAddress + 1;
+            }
+        }
+
+        memset( cacheFlags, 0, sizeof(cacheFlags) );
+        cacheSectorAddress = sectorAddress;
+        if (!_USBHostMSDSCSI_ReadWrite10( address, SCSI_READ_10, sectorAddress, count, cacheData[0] ))
+        {
+            return false;
+        }
+        memset( cacheFlags, CACHE_SECTOR_VALID, count );
+        slot = 0;
+    }
+
+    memcpy( dataBuffer, cacheData[slot], USB_MSD_SCSI_CACHE_SECTOR_SIZE );
+    cacheNextSector = sectorAddress + 1;
+    return true;
+}
+
+
+/*******************************************************************************
+  Function:
+    static bool _USBHostMSDSCSI_CacheWrite( uint8_t * address, uint32_t sectorAddress,
+                uint8_t *dataBuffer )
+
+  Precondition:
+    The media sector size matches USB_MSD_SCSI_CACHE_SECTOR_SIZE.
+
+  Overview:
+    This function writes one sector into the cache and marks it dirty.  If
+    the sector is outside the sectors the cache covers, the cache is
+    flushed first and moved to start at this sector, so that sequential
+    writes collect into one WRITE10 command.
+
+  Parameters:
+    uint8_t * address       - Endpoint address of the device
+    uint32_t sectorAddress  - address of sector to write
+    uint8_t *dataBuffer     - buffer with application data
+
+  Return Values:
+    true    - the sector is in the cache
+    false   - flushing the cache was not successful
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static bool _USBHostMSDSCSI_CacheWrite( uint8_t * address, uint32_t sectorAddress, uint8_t *dataBuffer )
+{
+    uint32_t    slot;
+
+    slot = sectorAddress - cacheSectorAddress;
+    if ((sectorAddress < cacheSectorAddress) || (slot >= USB_MSD_SCSI_CACHE_SECTORS))
+    {
+        if (!_USBHostMSDSCSI_CacheFlush( address ))
+        {
+            return false;
+        }
+
+        memset( cacheFlags, 0, sizeof(cacheFlags) );
+        cacheSectorAddress = sectorAddress;
+        slot = 0;
+    }
+
+    memcpy( cacheData[slot], dataBuffer, USB_MSD_SCSI_CACHE_SECTOR_SIZE );
+    if (!(cacheFlags[slot] & CACHE_SECTOR_DIRTY))
+    {
+        cacheDirtySectors ++;
+    }
+    cacheFlags[slot] = CACHE_SECTOR_VALID | CACHE_SECTOR_DIRTY;
+    return true;
+}
+
+#endif
+
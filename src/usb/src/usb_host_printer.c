@@ -101,6 +101,7 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 #include <usb/usb_struct_queue.h>
 #include <usb/usb.h>
 #include <usb/usb_host_printer.h>
+#include <usb/usb_host_printer_pool.h>
 
 #ifdef USB_PRINTER_LANGUAGE_PCL_5
     #include <usb/usb_host_printer_pcl_5.h>
@@ -207,6 +208,7 @@ typedef struct _USB_PRINTER_DEVICE
 
     USB_PRINTER_QUEUE               transferQueueIN;
     USB_PRINTER_QUEUE               transferQueueOUT;
+    USB_PRINTER_QUEUE_STATS         queueStats;     // Statistics of transferQueueOUT
 
     union
     {
@@ -217,6 +219,7 @@ typedef struct _USB_PRINTER_DEVICE
             uint8_t initialized                    : 1;    // Driver has been initialized
             uint8_t txBusy                         : 1;    // Driver busy transmitting data
             uint8_t rxBusy                         : 1;    // Driver busy receiving data
+            uint8_t imageOpen                      : 1;    // Between USB_PRINTER_IMAGE_START and USB_PRINTER_IMAGE_STOP
             #ifdef USB_PRINTER_ALLOW_DYNAMIC_LANGUAGE_DETERMINATION
                 uint8_t deviceIDStringLengthValid  : 1;    // Device ID string length is valid
             #endif
@@ -330,6 +333,7 @@ bool USBHostPrinterInitialize ( uint8_t address, uint32_t flags, uint8_t clientD
     // Initialize state
     usbPrinters[currentPrinterRecord].rxLength                  = 0;
     usbPrinters[currentPrinterRecord].flags.value               = 0x01; // Set the inUse flag.
+    memset( &usbPrinters[currentPrinterRecord].queueStats, 0, sizeof(USB_PRINTER_QUEUE_STATS) );
     #ifdef USB_PRINTER_ALLOW_DYNAMIC_LANGUAGE_DETERMINATION
         usbPrinters[currentPrinterRecord].deviceIDStringIndex   = 0;
     #endif
@@ -428,7 +432,7 @@ bool USBHostPrinterInitialize ( uint8_t address, uint32_t flags, uint8_t clientD
                             // Get the printer device ID string, so we can try to determine
                             // what printer languages it supports.
                             errorCode = USBHostIssueDeviceRequest( address, USB_SETUP_DEVICE_TO_HOST | USB_SETUP_TYPE_CLASS | USB_SETUP_RECIPIENT_INTERFACE,
-                                            PRINTER_DEVICE_REQUEST_GET_DEVICE_ID, 0, 0, ((USB_DEVICE_DESCRIPTOR*)pDeviceDescriptor)->bMaxPacketSize0,
+                                            PRINTER_DEVICE_REQUEST_GET_DEVICE_ID, 0, 0, ((USB_DEVICE_DESCRIPTOR*)USBHostGetDeviceDescriptor( address ))->bMaxPacketSize0,
                                             (uint8_t *)usbPrinters[currentPrinterRecord].deviceIDString, USB_DEVICE_REQUEST_GET,
                                             usbPrinters[currentPrinterRecord].clientDriverID );
                             if (errorCode)
@@ -528,7 +532,7 @@ bool USBHostPrinterEventHandler ( uint8_t address, USB_EVENT event, void *data,
                 transfer = StructQueueRemove( &(usbPrinters[currentPrinterRecord].transferQueueOUT), USB_PRINTER_TRANSFER_QUEUE_SIZE );
                 if (transfer->flags & USB_PRINTER_TRANSFER_COPY_DATA)
                 {
-                    USB_FREE( transfer->data );
+                    USB_PRINTER_FREE( transfer->data );
                 }
             }
 
@@ -557,7 +561,7 @@ bool USBHostPrinterEventHandler ( uint8_t address, USB_EVENT event, void *data,
                     transfer = StructQueueRemove( &(usbPrinters[currentPrinterRecord].transferQueueIN), USB_PRINTER_TRANSFER_QUEUE_SIZE );
                     if (transfer->flags & USB_PRINTER_TRANSFER_COPY_DATA)
                     {
-                        USB_FREE( transfer->data );
+                        USB_PRINTER_FREE( transfer->data );
                     }
 
                     if (StructQueueIsNotEmpty( &(usbPrinters[currentPrinterRecord].transferQueueIN), USB_PRINTER_TRANSFER_QUEUE_SIZE ))
@@ -577,7 +581,7 @@ bool USBHostPrinterEventHandler ( uint8_t address, USB_EVENT event, void *data,
                     transfer = StructQueueRemove( &(usbPrinters[currentPrinterRecord].transferQueueOUT), USB_PRINTER_TRANSFER_QUEUE_SIZE );
                     if (transfer->flags & USB_PRINTER_TRANSFER_COPY_DATA)
                     {
-                        USB_FREE( transfer->data );
+                        USB_PRINTER_FREE( transfer->data );
                     }
 
                     if (StructQueueIsNotEmpty( &(usbPrinters[currentPrinterRecord].transferQueueOUT), USB_PRINTER_TRANSFER_QUEUE_SIZE ))
@@ -633,7 +637,7 @@ bool USBHostPrinterEventHandler ( uint8_t address, USB_EVENT event, void *data,
                     transfer = StructQueueRemove( &(usbPrinters[currentPrinterRecord].transferQueueIN), USB_PRINTER_TRANSFER_QUEUE_SIZE );
                     if (transfer->flags & USB_PRINTER_TRANSFER_COPY_DATA)
                     {
-                        USB_FREE( transfer->data );
+                        USB_PRINTER_FREE( transfer->data );
                     }
 
                     if (StructQueueIsNotEmpty( &(usbPrinters[currentPrinterRecord].transferQueueIN), USB_PRINTER_TRANSFER_QUEUE_SIZE ))
@@ -653,7 +657,7 @@ bool USBHostPrinterEventHandler ( uint8_t address, USB_EVENT event, void *data,
                     transfer = StructQueueRemove( &(usbPrinters[currentPrinterRecord].transferQueueOUT), USB_PRINTER_TRANSFER_QUEUE_SIZE );
                     if (transfer->flags & USB_PRINTER_TRANSFER_COPY_DATA)
                     {
-                        USB_FREE( transfer->data );
+                        USB_PRINTER_FREE( transfer->data );
                     }
 
                     if (StructQueueIsNotEmpty( &(usbPrinters[currentPrinterRecord].transferQueueOUT), USB_PRINTER_TRANSFER_QUEUE_SIZE ))
@@ -786,13 +790,29 @@ bool USBHostPrinterEventHandler ( uint8_t address, USB_EVENT event, void *data,
 uint8_t USBHostPrinterCommand( uint8_t deviceAddress, USB_PRINTER_COMMAND command,
                     USB_DATA_POINTER data, uint32_t size, uint8_t flags )
 {
+    uint8_t     returnValue;
+
     if (!_USBHostPrinter_FindDevice( deviceAddress ))
     {
         // The device was not found.
         return USB_PRINTER_UNKNOWN_DEVICE;
     }
 
-    return usbPrinters[currentPrinterRecord].languageHandler( deviceAddress, command, data, size, flags );
+    returnValue = usbPrinters[currentPrinterRecord].languageHandler( deviceAddress, command, data, size, flags );
+
+    // Track open images, so USBHostPrinterCommandReady() knows when the
+    // next command needs a row-sized buffer.  An image stop that failed
+    // leaves the image open, so that it can be retried.
+    if (command == USB_PRINTER_IMAGE_START)
+    {
+        usbPrinters[currentPrinterRecord].flags.imageOpen = (returnValue == USB_PRINTER_SUCCESS);
+    }
+    else if ((command == USB_PRINTER_IMAGE_STOP) && (returnValue == USB_PRINTER_SUCCESS))
+    {
+        usbPrinters[currentPrinterRecord].flags.imageOpen = 0;
+    }
+
+    return returnValue;
 }
 
 
@@ -815,7 +835,8 @@ uint8_t USBHostPrinterCommand( uint8_t deviceAddress, USB_PRINTER_COMMAND comman
                 transfer request, or the device is not attached.  The latter
                 allows this routine to be called without generating an
                 infinite loop if the device detaches.
-    false   - The transfer queue is full.
+    false   - The transfer queue is full, or no pool buffer is free for
+                the next command and a queued transfer will return one.
 
   Example:
     <code>
@@ -829,6 +850,15 @@ uint8_t USBHostPrinterCommand( uint8_t deviceAddress, USB_PRINTER_COMMAND comman
     This routine will return true if a single transfer can be enqueued.  Since
     this routine is the check to see if USBHostPrinterCommand() can be called,
     every command can generate at most one transfer.
+
+    If USB_PRINTER_BUFFER_POOL is defined, this routine also waits for a
+    buffer to be free in the pool, so that a command is not refused with
+    USB_PRINTER_OUT_OF_MEMORY only because the printer is slow.  Between
+    USB_PRINTER_IMAGE_START and USB_PRINTER_IMAGE_STOP it waits for a row
+    block, since image rows and bands need one; otherwise it only waits for
+    a command-sized buffer, so text and vector commands are not held up by
+    another printer's image.  Use USBHostPrinterBufferAvailable() to check
+    for a row block before USB_PRINTER_IMAGE_START or a long text command.
   ***************************************************************************/
 
 bool USBHostPrinterCommandReady( uint8_t deviceAddress )
@@ -839,11 +869,35 @@ bool USBHostPrinterCommandReady( uint8_t deviceAddress )
         return true;
     }
 
-    if (StructQueueSpaceAvailable( 1, &(usbPrinters[currentPrinterRecord].transferQueueOUT), USB_PRINTER_TRANSFER_QUEUE_SIZE ))
+    if (!StructQueueSpaceAvailable( 1, &(usbPrinters[currentPrinterRecord].transferQueueOUT), USB_PRINTER_TRANSFER_QUEUE_SIZE ))
     {
-        return true;
+        return false;
     }
-    return false;
+
+    #if defined( USB_PRINTER_BUFFER_POOL )
+        // Inside an image the next command needs a row block, otherwise a
+        // command block will do.  If none is free, wait while a queued
+        // transfer can still return one.  If nothing is queued, waiting
+        // would never end, so let the command fail with
+        // USB_PRINTER_OUT_OF_MEMORY instead.
+        if (!USBHostPrinterBufferAvailable( usbPrinters[currentPrinterRecord].flags.imageOpen ?
+                USB_PRINTER_POOL_ROW_SIZE : USB_PRINTER_POOL_COMMAND_SIZE ))
+        {
+            uint8_t     i;
+
+            for (i=0; i<USB_MAX_PRINTER_DEVICES; i++)
+            {
+                if (usbPrinters[i].flags.inUse &&
+                    StructQueueIsNotEmpty( &(usbPrinters[i].transferQueueOUT), USB_PRINTER_TRANSFER_QUEUE_SIZE ))
+                {
+                    usbPrinters[currentPrinterRecord].queueStats.bufferWaits++;
+                    return false;
+                }
+            }
+        }
+    #endif
+
+    return true;
 }
 
 
@@ -919,6 +973,44 @@ uint32_t USBHostPrinterGetRxLength( uint8_t deviceAddress )
 }
 
 
+/****************************************************************************
+  Function:
+    uint8_t USBHostPrinterGetQueueStats( uint8_t deviceAddress,
+                USB_PRINTER_QUEUE_STATS *stats )
+
+  Description:
+    This function returns the statistics of the output transfer queue of a
+    printer.
+
+  Preconditions:
+    None
+
+  Parameters:
+    deviceAddress   - USB Address of the device
+    *stats          - Filled in with the statistics
+
+  Return Values:
+    USB_SUCCESS                 - The statistics were returned
+    USB_PRINTER_UNKNOWN_DEVICE  - No printer with specified address
+
+  Remarks:
+    The statistics are cleared when the printer attaches.
+  ***************************************************************************/
+
+uint8_t USBHostPrinterGetQueueStats( uint8_t deviceAddress, USB_PRINTER_QUEUE_STATS *stats )
+{
+    if (!_USBHostPrinter_FindDevice( deviceAddress ))
+    {
+        return USB_PRINTER_UNKNOWN_DEVICE;
+    }
+
+    *stats          = usbPrinters[currentPrinterRecord].queueStats;
+    stats->size     = USB_PRINTER_TRANSFER_QUEUE_SIZE;
+    stats->depth    = usbPrinters[currentPrinterRecord].transferQueueOUT.count;
+    return USB_SUCCESS;
+}
+
+
 /****************************************************************************
   Function:
     uint8_t USBHostPrinterGetStatus( uint8_t deviceAddress, uint8_t *status )
@@ -1186,8 +1278,9 @@ uint8_t USBHostPrinterWrite( uint8_t deviceAddress, void *buffer, uint32_t lengt
         // deallocate the memory.
         if (transferFlags & USB_PRINTER_TRANSFER_COPY_DATA)
         {
-            USB_FREE( buffer );
+            USB_PRINTER_FREE( buffer );
         }
+        usbPrinters[currentPrinterRecord].queueStats.busy++;
         return USB_PRINTER_BUSY;
     }
 
@@ -1198,6 +1291,12 @@ uint8_t USBHostPrinterWrite( uint8_t deviceAddress, void *buffer, uint32_t lengt
     transfer->size  = length;
     transfer->flags = transferFlags;
 
+    usbPrinters[currentPrinterRecord].queueStats.transfers++;
+    if (usbPrinters[currentPrinterRecord].transferQueueOUT.count > usbPrinters[currentPrinterRecord].queueStats.highWater)
+    {
+        usbPrinters[currentPrinterRecord].queueStats.highWater = usbPrinters[currentPrinterRecord].transferQueueOUT.count;
+    }
+
     if (usbPrinters[currentPrinterRecord].flags.txBusy)
     {
         // The request has been queued.  We'll execute it when the current transfer is complete.
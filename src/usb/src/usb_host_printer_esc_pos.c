@@ -50,6 +50,13 @@
     to be sent directly from its original RAM location, the data must already
     be in the format required by the printer language.
 
+    If USB_PRINTER_POS_RASTER_IMAGE_SUPPORT is defined, images are printed
+    with GS v 0 raster bit image blocks.  USB_PRINTER_IMAGE_DATA then takes
+    one row of the bitmap, as it does for full sheet printers, so
+    USBHostPrinterPOSImageDataFormat() is not needed.  The rows are
+    collected in a band buffer of USB_PRINTER_POS_RASTER_BAND_SIZE bytes,
+    and each full band is sent as one block in a single transfer.
+
 *******************************************************************************/
 //DOM-IGNORE-BEGIN
 /******************************************************************************
@@ -96,6 +103,10 @@ Change History:
 #include "USB/usb.h"
 #include "USB/usb_host_printer.h"
 #include "USB/usb_host_printer_esc_pos.h"
+#include "USB/usb_host_printer_pool.h"
+#if defined( USB_PRINTER_POS_RASTER_IMAGE_SUPPORT )
+    #include "USB/usb_host_printer_raster.h"
+#endif
 
 
 //#define DEBUG_MODE
@@ -117,6 +128,27 @@ Change History:
     #error The USB Host Printer Client Driver requires transfer events.
 #endif
 
+// If USB_PRINTER_POS_RASTER_IMAGE_SUPPORT is defined, images are sent with
+// the GS v 0 raster bit image command instead of ESC *, and each
+// USB_PRINTER_IMAGE_DATA command takes one row of the bitmap.
+#if defined( USB_PRINTER_POS_RASTER_IMAGE_SUPPORT )
+    // Most rows the printer takes in one GS v 0 block.
+    #ifndef USB_PRINTER_POS_RASTER_MAX_ROWS
+        #define USB_PRINTER_POS_RASTER_MAX_ROWS     2047
+    #endif
+
+    // Size of the band buffer, and so of the largest image transfer.  Each
+    // band is one bulk transfer, so every packet but its last is full.  A
+    // band from the buffer pool fills one row block.
+    #ifndef USB_PRINTER_POS_RASTER_BAND_SIZE
+        #if defined( USB_PRINTER_BUFFER_POOL )
+            #define USB_PRINTER_POS_RASTER_BAND_SIZE    USB_PRINTER_POOL_ROW_SIZE
+        #else
+            #define USB_PRINTER_POS_RASTER_BAND_SIZE    2048
+        #endif
+    #endif
+#endif
+
 
 // *****************************************************************************
 // *****************************************************************************
@@ -204,6 +236,10 @@ typedef struct
                             // currently printing image;
     uint16_t    imageWidth;     // Dot width of the currently printing image.
 
+    #if defined( USB_PRINTER_POS_RASTER_IMAGE_SUPPORT )
+        USB_PRINTER_RASTER_BAND band;   // GS v 0 block being filled.
+    #endif
+
     union
     {
         uint8_t    value;
@@ -273,7 +309,7 @@ PRINTER_STATUS_ESC_POS          printerListESCPOS[USB_MAX_PRINTER_DEVICES];
     #define USB_FREE(ptr) free(ptr)
 #endif
 
-#define USB_FREE_AND_CLEAR(ptr) {USB_FREE(ptr); ptr = NULL;}
+#define USB_FREE_AND_CLEAR(ptr) {USB_PRINTER_FREE(ptr); ptr = NULL;}
 
 // *****************************************************************************
 // *****************************************************************************
@@ -289,6 +325,9 @@ PRINTER_STATUS_ESC_POS          printerListESCPOS[USB_MAX_PRINTER_DEVICES];
 #endif
 static uint8_t _PrintFontCommand( uint8_t printer, uint8_t transferFlags );
 static uint8_t _PrintStaticCommand( uint8_t printer, char *command, uint8_t transferFlags );
+#if defined( USB_PRINTER_POS_RASTER_IMAGE_SUPPORT )
+    static uint8_t _SendRasterBand( uint8_t printer, uint8_t transferFlags );
+#endif
 
 
 // *****************************************************************************
@@ -403,6 +442,9 @@ uint8_t USBHostPrinterLanguageESCPOS( uint8_t address,
             if (printer != USB_MAX_PRINTER_DEVICES)
             {
                 printerListESCPOS[printer].deviceAddress = 0;
+                #if defined( USB_PRINTER_POS_RASTER_IMAGE_SUPPORT )
+                    USB_FREE_AND_CLEAR( printerListESCPOS[printer].band.buffer );
+                #endif
             }
             return USB_PRINTER_SUCCESS;
             break;
@@ -411,7 +453,7 @@ uint8_t USBHostPrinterLanguageESCPOS( uint8_t address,
         case USB_PRINTER_JOB_START:
             _SetCurrentPosition( 0, 0 );
 
-            buffer = (char *)USB_MALLOC( 2 );
+            buffer = (char *)USB_PRINTER_MALLOC( 2 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -499,7 +541,7 @@ uint8_t USBHostPrinterLanguageESCPOS( uint8_t address,
         //---------------------------------------------------------------------
         case USB_PRINTER_EJECT_PAGE:
 EjectPage:
-            buffer = (char *)USB_MALLOC( 1 );
+            buffer = (char *)USB_PRINTER_MALLOC( 1 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -528,7 +570,7 @@ EjectPage:
             }
             if (transferFlags & USB_PRINTER_TRANSFER_COPY_DATA)
             {
-                buffer = (char *)USB_MALLOC( size );
+                buffer = (char *)USB_PRINTER_MALLOC( size );
                 if (buffer == NULL)
                 {
                     return USB_PRINTER_OUT_OF_MEMORY;
@@ -571,7 +613,7 @@ EjectPage:
 
         //---------------------------------------------------------------------
         case USB_PRINTER_TEXT_STOP:
-            buffer = (char *)USB_MALLOC( 3 );
+            buffer = (char *)USB_PRINTER_MALLOC( 3 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -606,6 +648,31 @@ EjectPage:
                 return USB_PRINTER_BAD_PARAMETER;
             }
 
+            #if defined( USB_PRINTER_POS_RASTER_IMAGE_SUPPORT )
+            // GS v 0 always prints at the full dot density, so lower
+            // densities are printed with double width or double height dots.
+            printerListESCPOS[printer].density          = 0;
+            if (HORIZONTAL_DENSITY == 1)
+            {
+                printerListESCPOS[printer].density     |= USB_PRINTER_RASTER_BAND_DOUBLE_WIDTH;
+            }
+            if (VERTICAL_DENSITY == 8)
+            {
+                printerListESCPOS[printer].density     |= USB_PRINTER_RASTER_BAND_DOUBLE_HEIGHT;
+            }
+
+            // Rows are collected into bands, each sent as one GS v 0 block.
+            printerListESCPOS[printer].imageWidth       = ((USB_PRINTER_IMAGE_INFO *)(data.pointerRAM))->width;
+            USB_FREE_AND_CLEAR( printerListESCPOS[printer].band.buffer );
+            if (!USBHostPrinterRasterBandStart( &printerListESCPOS[printer].band, printerListESCPOS[printer].imageWidth,
+                        printerListESCPOS[printer].density, USB_PRINTER_POS_RASTER_BAND_SIZE, USB_PRINTER_POS_RASTER_MAX_ROWS ))
+            {
+                return USB_PRINTER_BAD_PARAMETER;
+            }
+
+            // Nothing is sent until the first band is full.
+            return USB_PRINTER_SUCCESS;
+            #else
             // Set up dot density specification.
             printerListESCPOS[printer].density          = 0;    // 8-dot image
             printerListESCPOS[printer].imageDataWidth   = 1;
@@ -634,7 +701,7 @@ EjectPage:
 
             printerListESCPOS[printer].imageWidth       = ((USB_PRINTER_IMAGE_INFO *)(data.pointerRAM))->width;
 
-            buffer = (char *)USB_MALLOC( 3 );
+            buffer = (char *)USB_PRINTER_MALLOC( 3 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -649,11 +716,16 @@ EjectPage:
 
             USBHOSTPRINTER_SETFLAG_COPY_DATA( transferFlags );
             return USBHostPrinterWrite( printerListESCPOS[printer].deviceAddress, buffer, i, transferFlags );
+            #endif
             break;
 
         //---------------------------------------------------------------------
         case USB_PRINTER_IMAGE_DATA_HEADER:
-            buffer = (char *)USB_MALLOC( 6 );
+            #if defined( USB_PRINTER_POS_RASTER_IMAGE_SUPPORT )
+                // The GS v 0 header is sent with each band.
+                return USB_PRINTER_SUCCESS;
+            #endif
+            buffer = (char *)USB_PRINTER_MALLOC( 6 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -681,6 +753,68 @@ EjectPage:
             // To maintain compatibility, the values will be flipped for all
             // copied data.
 
+            #if defined( USB_PRINTER_POS_RASTER_IMAGE_SUPPORT )
+            // The data is one row of the image, and size is its width in
+            // dots.  It is copied into the band, and the band is sent once
+            // it is full.
+            size = (size + 7) / 8;
+            if ((size == 0) || (size > printerListESCPOS[printer].band.rowBytes))
+            {
+                return USB_PRINTER_BAD_PARAMETER;
+            }
+
+            if (printerListESCPOS[printer].band.buffer == NULL)
+            {
+                printerListESCPOS[printer].band.buffer = (uint8_t *)USB_PRINTER_MALLOC(
+                        USB_PRINTER_RASTER_BAND_BYTES( &printerListESCPOS[printer].band ) );
+                if (printerListESCPOS[printer].band.buffer == NULL)
+                {
+                    return USB_PRINTER_OUT_OF_MEMORY;
+                }
+            }
+
+            {
+                uint8_t    *row;
+                uint16_t    j;
+
+                row = USBHostPrinterRasterBandRow( &printerListESCPOS[printer].band );
+                if (transferFlags & USB_PRINTER_TRANSFER_FROM_ROM)
+                {
+                    #if defined( __C30__ ) || defined __XC16__
+                        uint8_t __prog__   *ptr;
+                    #elif defined( __PIC32MX__ )
+                        const uint8_t      *ptr;
+                    #endif
+
+                    ptr = ((USB_DATA_POINTER)data).pointerROM;
+                    for (j=0; j<size; j++)
+                    {
+                        row[j] = ~(*ptr++);
+                    }
+                }
+                else if (transferFlags & USB_PRINTER_TRANSFER_COPY_DATA)
+                {
+                    uint8_t    *ptr;
+
+                    ptr = ((USB_DATA_POINTER)data).pointerRAM;
+                    for (j=0; j<size; j++)
+                    {
+                        row[j] = ~(*ptr++);
+                    }
+                }
+                else
+                {
+                    memcpy( row, ((USB_DATA_POINTER)data).pointerRAM, size );
+                }
+            }
+
+            // A short row is blank to the end of the image.
+            if (!USBHostPrinterRasterBandAddRow( &printerListESCPOS[printer].band, size ))
+            {
+                return USB_PRINTER_SUCCESS;
+            }
+            return _SendRasterBand( printer, transferFlags );
+            #else
             // For ESC/POS, the amount of data to transfer is the width of the
             // image times the byte depth of the data, as specified by the
             // vertical dot density.
@@ -694,7 +828,7 @@ EjectPage:
             }
             if (transferFlags & USB_PRINTER_TRANSFER_COPY_DATA)
             {
-                buffer = (char *)USB_MALLOC( size );
+                buffer = (char *)USB_PRINTER_MALLOC( size );
                 if (buffer == NULL)
                 {
                     return USB_PRINTER_OUT_OF_MEMORY;
@@ -733,13 +867,23 @@ EjectPage:
             }
 
             return USBHostPrinterWrite( address, buffer, size, transferFlags );
+            #endif
             break;
 
         //---------------------------------------------------------------------
         case USB_PRINTER_IMAGE_STOP:
+            #if defined( USB_PRINTER_POS_RASTER_IMAGE_SUPPORT )
+                // Send the last, partial band.
+                if ((printerListESCPOS[printer].band.buffer == NULL) || (printerListESCPOS[printer].band.rowCount == 0))
+                {
+                    USB_FREE_AND_CLEAR( printerListESCPOS[printer].band.buffer );
+                    return USB_PRINTER_SUCCESS;
+                }
+                return _SendRasterBand( printer, transferFlags );
+            #endif
             // No termination required.
             //return USB_PRINTER_SUCCESS;
-            buffer = (char *)USB_MALLOC( 3 );
+            buffer = (char *)USB_PRINTER_MALLOC( 3 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -787,7 +931,7 @@ EjectPage:
                 {
                     length = strlen( ptr );
                 }
-                buffer  = (char *)USB_MALLOC( length + 3 );
+                buffer  = (char *)USB_PRINTER_MALLOC( length + 3 );
                 if (buffer == NULL)
                 {
                     return USB_PRINTER_OUT_OF_MEMORY;
@@ -811,7 +955,7 @@ EjectPage:
         case USB_PRINTER_POS_CUT:
         case USB_PRINTER_POS_CUT_PARTIAL:
             // Using Function B
-            buffer = (char *)USB_MALLOC( 4 );
+            buffer = (char *)USB_PRINTER_MALLOC( 4 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -974,7 +1118,7 @@ EjectPage:
                         break;
                 }
 
-                buffer = (char *)USB_MALLOC( 21 + dataLength );
+                buffer = (char *)USB_PRINTER_MALLOC( 21 + dataLength );
                 if (buffer == NULL)
                 {
                     return USB_PRINTER_OUT_OF_MEMORY;
@@ -1336,6 +1480,9 @@ bool USBHostPrinterLanguageESCPOSIsSupported( char *deviceID,
     density, 24-dot vertical density should be used instead.
 
     This routine does not yet support reading from external memory.
+
+    This routine is not needed if USB_PRINTER_POS_RASTER_IMAGE_SUPPORT is
+    defined.  Send the bitmap rows with USB_PRINTER_IMAGE_DATA instead.
   ***************************************************************************/
 
 USB_DATA_POINTER USBHostPrinterPOSImageDataFormat( USB_DATA_POINTER image,
@@ -1695,7 +1842,7 @@ static uint8_t _PrintFontCommand( uint8_t printer, uint8_t transferFlags )
 {
     char    *buffer;
 
-    buffer = (char *)USB_MALLOC( 3 );
+    buffer = (char *)USB_PRINTER_MALLOC( 3 );
     if (buffer == NULL)
     {
         return USB_PRINTER_OUT_OF_MEMORY;
@@ -1754,7 +1901,7 @@ static uint8_t _PrintStaticCommand( uint8_t printer, char *command, uint8_t tran
 
     USBHOSTPRINTER_SETFLAG_COPY_DATA( transferFlags );
 
-    buffer = (char *)USB_MALLOC( strlen(command) + 1 );
+    buffer = (char *)USB_PRINTER_MALLOC( strlen(command) + 1 );
     if (buffer == NULL)
     {
         return USB_PRINTER_OUT_OF_MEMORY;
@@ -1764,5 +1911,45 @@ static uint8_t _PrintStaticCommand( uint8_t printer, char *command, uint8_t tran
 }
 
 
+/****************************************************************************
+  Function:
+    static uint8_t _SendRasterBand( uint8_t printer, uint8_t transferFlags )
+
+  Description:
+    This function fills in the GS v 0 header of the current band and sends
+    the band, header and rows, as a single transfer.  The band buffer is
+    handed to the transfer queue, which frees it when it has been sent, and
+    the next row starts a new band.
+
+  Preconditions:
+    The band holds at least one row.
+
+  Parameters:
+    uint8_t printer        - Index of the target printer.
+    uint8_t transferFlags  - Transfer control string.
+
+  Return Values:
+    USB_PRINTER_SUCCESS         - Band was queued.
+    others                      - See the return values for the function
+                                    USBHostPrinterWrite().
+
+  Remarks:
+    Only available if USB_PRINTER_POS_RASTER_IMAGE_SUPPORT is defined.
+  ***************************************************************************/
+
+#if defined( USB_PRINTER_POS_RASTER_IMAGE_SUPPORT )
+static uint8_t _SendRasterBand( uint8_t printer, uint8_t transferFlags )
+{
+    uint8_t    *buffer;
+    uint32_t   length;
+
+    buffer = USBHostPrinterRasterBandEnd( &printerListESCPOS[printer].band, &length );
+
+    USBHOSTPRINTER_SETFLAG_COPY_DATA( transferFlags );
+    return USBHostPrinterWrite( printerListESCPOS[printer].deviceAddress, buffer, length, transferFlags );
+}
+#endif
+
+
 #endif
 
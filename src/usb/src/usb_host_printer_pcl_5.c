@@ -36,6 +36,12 @@
     to be sent directly from its original RAM location, the data must already
     be in the format required by the printer language.
 
+    Raster image rows are compressed with TIFF PackBits (method 2) or as
+    changes from the previous row (delta row, method 3), whichever sends
+    fewer bytes, or sent uncompressed if neither helps.  The row buffers are
+    allocated once per image by USB_PRINTER_IMAGE_START and released by
+    USB_PRINTER_IMAGE_STOP.
+
     PCL 5 is not compatible with PCL 6; PCL 5 utilizes ASCII input, whereas
     PCL 6 utilizes binary data.  However, some printers that advertise support
     for only PCL 5 do support PCL 6.
@@ -98,6 +104,8 @@ Change History:
 #include "USB/usb.h"
 #include "USB/usb_host_printer.h"
 #include "USB/usb_host_printer_pcl_5.h"
+#include "USB/usb_host_printer_pool.h"
+#include "USB/usb_host_printer_raster.h"
 
 //#define DEBUG_MODE
 #if defined( DEBUG_MODE )
@@ -197,6 +205,7 @@ Change History:
 #define COMMAND_RASTER_COMPRESSION_RES      ESCAPE "*b4M"
 #define COMMAND_RASTER_COMPRESSION_RLE      ESCAPE "*b1M"
 #define COMMAND_RASTER_COMPRESSION_TIFF     ESCAPE "*b2M"
+#define COMMAND_RASTER_COMPRESSION          ESCAPE "*b%dM"
 #define COMMAND_RASTER_DATA                 ESCAPE "*b%dW"      // In bytes of data
 #define COMMAND_RASTER_END                  ESCAPE "*rC"
 #define COMMAND_RASTER_HEIGHT               ESCAPE "*r%dT"     // In pixels
@@ -206,6 +215,8 @@ Change History:
 #define COMMAND_RASTER_WIDTH                ESCAPE "*r%dS"     // In pixels
 //#define COMMAND_RASTER_Y_OFFSET             ESCAPE "*b%dY"      // In pixels
 
+#define PCL_RASTER_HEADER_SIZE              (5 + 9 + 1)         // ESC*b#M ESC*b#####W and the terminator
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Data Structures
@@ -237,6 +248,13 @@ typedef struct _PRINTER_STATUS_PCL
                             // image width.  We must explicitly set these to 0, or we
                             // will get a line down the right side of the image.
 
+    uint8_t    *rasterBuffer;   // Allocation holding the three row buffers below.
+    uint8_t    *rasterRow;      // Row being compressed.
+    uint8_t    *rasterSeed;     // Previous row, as the printer has decoded it.
+    uint8_t    *rasterScratch;  // Work space for the compression.
+    uint16_t    rasterRowBytes; // Bytes in each row of the current image.
+    uint8_t    rasterMethod;   // Compression method selected on the printer.
+
     union
     {
         uint8_t    value;
@@ -313,7 +331,7 @@ PRINTER_STATUS_PCL  printerListPCL[USB_MAX_PRINTER_DEVICES];
     #define USB_FREE(ptr) free(ptr)
 #endif
 
-#define USB_FREE_AND_CLEAR(ptr) {USB_FREE(ptr); ptr = NULL;}
+#define USB_FREE_AND_CLEAR(ptr) {USB_PRINTER_FREE(ptr); ptr = NULL;}
 
 // *****************************************************************************
 // *****************************************************************************
@@ -448,6 +466,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
             if (printer != USB_MAX_PRINTER_DEVICES)
             {
                 printerListPCL[printer].deviceAddress = 0;
+                USB_FREE_AND_CLEAR( printerListPCL[printer].rasterBuffer );
             }
             return USB_PRINTER_SUCCESS;
             break;
@@ -592,7 +611,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
             }
             if (transferFlags & USB_PRINTER_TRANSFER_COPY_DATA)
             {
-                buffer = (char *)USB_MALLOC( size );
+                buffer = (char *)USB_PRINTER_MALLOC( size );
                 if (buffer == NULL)
                 {
                     return USB_PRINTER_OUT_OF_MEMORY;
@@ -651,7 +670,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
             // Used only when not doing vector graphics.
             // This command sets the cursor to the specified position.  Note
             // that we must convert the specification to use decipoints.
-            buffer = (char *)USB_MALLOC( 10 + 10 );
+            buffer = (char *)USB_PRINTER_MALLOC( 10 + 10 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -666,9 +685,27 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
         //---------------------------------------------------------------------
         case USB_PRINTER_IMAGE_START:
             // This command sets up the printer for printing raster data.
-            buffer = (char *)USB_MALLOC( 4 + 8 + 8 + 6 + 11 + 11 + 11 );
+            // Allocate the row buffers for the whole image here, so the rows
+            // themselves need only their transfer buffer.
+            USB_FREE_AND_CLEAR( printerListPCL[printer].rasterBuffer );
+            printerListPCL[printer].rasterRowBytes  = (((USB_PRINTER_IMAGE_INFO *)(data.pointerRAM))->width + 7) / 8;
+            printerListPCL[printer].rasterBuffer    = (uint8_t *)USB_PRINTER_MALLOC( 3 * (uint32_t)printerListPCL[printer].rasterRowBytes );
+            if (printerListPCL[printer].rasterBuffer == NULL)
+            {
+                return USB_PRINTER_OUT_OF_MEMORY;
+            }
+            printerListPCL[printer].rasterRow       = printerListPCL[printer].rasterBuffer;
+            printerListPCL[printer].rasterSeed      = printerListPCL[printer].rasterRow + printerListPCL[printer].rasterRowBytes;
+            printerListPCL[printer].rasterScratch   = printerListPCL[printer].rasterSeed + printerListPCL[printer].rasterRowBytes;
+            printerListPCL[printer].rasterMethod    = USB_PRINTER_RASTER_METHOD_UNKNOWN;
+
+            // Start raster graphics clears the printer's seed row.
+            memset( printerListPCL[printer].rasterSeed, 0, printerListPCL[printer].rasterRowBytes );
+
+            buffer = (char *)USB_PRINTER_MALLOC( 4 + 8 + 8 + 6 + 11 + 11 + 11 );
             if (buffer == NULL)
             {
+                USB_FREE_AND_CLEAR( printerListPCL[printer].rasterBuffer );
                 return USB_PRINTER_OUT_OF_MEMORY;
             }
 
@@ -740,17 +777,9 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
 
         //---------------------------------------------------------------------
         case USB_PRINTER_IMAGE_DATA_HEADER:
-            // This command sends the command for the raster data.  Therefore, the
-            // command USB_PRINTER_IMAGE_DATA must follow this command.
-            buffer = (char *)USB_MALLOC( 20 );
-            if (buffer == NULL)
-            {
-                return USB_PRINTER_OUT_OF_MEMORY;
-            }
-
-            sprintf( buffer, COMMAND_RASTER_COMPRESSION_NONE COMMAND_RASTER_DATA, (uint16_t)((size+7)/8) );
-            USBHOSTPRINTER_SETFLAG_COPY_DATA( transferFlags );
-            return USBHostPrinterWrite( printerListPCL[printer].deviceAddress, buffer, strlen(buffer), transferFlags );
+            // The command for the raster data depends on how the row
+            // compresses, so USB_PRINTER_IMAGE_DATA sends it with the data.
+            return USB_PRINTER_SUCCESS;
             break;
 
         //---------------------------------------------------------------------
@@ -769,22 +798,19 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
             size += 7;
             size /= 8;
 
-            // If the user's data is in ROM, we have to copy it to RAM first,
-            // so the USB Host routines can read it.
-            if (transferFlags & USB_PRINTER_TRANSFER_FROM_ROM)
+            if ((printerListPCL[printer].rasterBuffer == NULL) || (size > printerListPCL[printer].rasterRowBytes))
             {
-                USBHOSTPRINTER_SETFLAG_COPY_DATA( transferFlags );
+                return USB_PRINTER_BAD_PARAMETER;
             }
-            if (transferFlags & USB_PRINTER_TRANSFER_COPY_DATA)
+
+            // The row is always copied into the row buffer, since it becomes
+            // the seed row for the next one.  Data that is copied, which
+            // includes all ROM data, is flipped as it is copied.
             {
+                uint8_t    *row;
                 uint32_t   i;
 
-                buffer = (char *)USB_MALLOC( size );
-                if (buffer == NULL)
-                {
-                    return USB_PRINTER_OUT_OF_MEMORY;
-                }
-
+                row = printerListPCL[printer].rasterRow;
                 if (transferFlags & USB_PRINTER_TRANSFER_FROM_ROM)
                 {
                     #if defined( __C30__ ) || defined __XC16__
@@ -796,31 +822,75 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                     ptr = ((USB_DATA_POINTER)data).pointerROM;
                     for (i=0; i<size; i++)
                     {
-                        buffer[i] = ~(*ptr++);
+                        row[i] = ~(*ptr++);
                     }
+                    row[i-1] &= printerListPCL[printer].imageEndMask;
                 }
-                else
+                else if (transferFlags & USB_PRINTER_TRANSFER_COPY_DATA)
                 {
                     char    *ptr;
 
                     ptr = ((USB_DATA_POINTER)data).pointerRAM;
                     for (i=0; i<size; i++)
                     {
-                        buffer[i] = ~(*ptr++);
+                        row[i] = ~(*ptr++);
                     }
+                    row[i-1] &= printerListPCL[printer].imageEndMask;
                 }
-                buffer[i-1] &= printerListPCL[printer].imageEndMask;
+                else
+                {
+                    memcpy( row, ((USB_DATA_POINTER)data).pointerRAM, size );
+                }
+
+                // A short row is blank to the end of the image.
+                memset( &row[size], 0, printerListPCL[printer].rasterRowBytes - size );
             }
-            else
+
+            // Compress the row into the transfer buffer after room for the
+            // command, then move it down behind the command that fits it.
+            buffer = (char *)USB_PRINTER_MALLOC( PCL_RASTER_HEADER_SIZE + printerListPCL[printer].rasterRowBytes );
+            if (buffer == NULL)
             {
-                buffer = ((USB_DATA_POINTER)data).pointerRAM;
+                return USB_PRINTER_OUT_OF_MEMORY;
             }
 
+            {
+                char       command[PCL_RASTER_HEADER_SIZE];
+                uint16_t   commandLength;
+                uint16_t   length;
+                uint8_t    method;
+                uint8_t    *swap;
+
+                method = printerListPCL[printer].rasterMethod;
+                length = USBHostPrinterRasterCompressRow( printerListPCL[printer].rasterRow, printerListPCL[printer].rasterSeed,
+                            printerListPCL[printer].rasterRowBytes, &method, (uint8_t *)&buffer[PCL_RASTER_HEADER_SIZE],
+                            printerListPCL[printer].rasterScratch );
+
+                commandLength = 0;
+                if (method != printerListPCL[printer].rasterMethod)
+                {
+                    commandLength = sprintf( command, COMMAND_RASTER_COMPRESSION, method );
+                    printerListPCL[printer].rasterMethod = method;
+                }
+                commandLength += sprintf( &command[commandLength], COMMAND_RASTER_DATA, length );
+
+                memcpy( buffer, command, commandLength );
+                memmove( &buffer[commandLength], &buffer[PCL_RASTER_HEADER_SIZE], length );
+                size = commandLength + length;
+
+                // The printer now holds this row as its seed row.
+                swap                                = printerListPCL[printer].rasterSeed;
+                printerListPCL[printer].rasterSeed  = printerListPCL[printer].rasterRow;
+                printerListPCL[printer].rasterRow   = swap;
+            }
+
+            USBHOSTPRINTER_SETFLAG_COPY_DATA( transferFlags );
             return USBHostPrinterWrite( address, buffer, size, transferFlags );
             break;
 
         //---------------------------------------------------------------------
         case USB_PRINTER_IMAGE_STOP:
+            USB_FREE_AND_CLEAR( printerListPCL[printer].rasterBuffer );
             if (USING_VECTOR_GRAPHICS)
             {
                 if (printerListPCL[printer].printerFlags.isLandscape)
@@ -888,7 +958,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                 (((USB_PRINTER_GRAPHICS_PARAMETERS *)(data.pointerRAM))->sFillType.fillType == PRINTER_FILL_HATCHED) ||
                 (((USB_PRINTER_GRAPHICS_PARAMETERS *)(data.pointerRAM))->sFillType.fillType == PRINTER_FILL_CROSS_HATCHED))
             {
-                buffer = (char *)USB_MALLOC( 14 );
+                buffer = (char *)USB_PRINTER_MALLOC( 14 );
                 if (buffer == NULL)
                 {
                     return USB_PRINTER_OUT_OF_MEMORY;
@@ -939,7 +1009,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 14 );
+            buffer = (char *)USB_PRINTER_MALLOC( 14 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -960,7 +1030,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 16 );
+            buffer = (char *)USB_PRINTER_MALLOC( 16 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -982,7 +1052,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 28 );
+            buffer = (char *)USB_PRINTER_MALLOC( 28 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1004,7 +1074,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                     return USB_PRINTER_BAD_PARAMETER;
                 }
             #endif
-            buffer = (char *)USB_MALLOC( 18 );
+            buffer = (char *)USB_PRINTER_MALLOC( 18 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1024,7 +1094,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                     return USB_PRINTER_BAD_PARAMETER;
                 }
             #endif
-            buffer = (char *)USB_MALLOC( 22 );
+            buffer = (char *)USB_PRINTER_MALLOC( 22 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1046,7 +1116,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( (30 + 3)* 2 + 4 );
+            buffer = (char *)USB_PRINTER_MALLOC( (30 + 3)* 2 + 4 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1166,7 +1236,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 12 + 8 + 4 );
+            buffer = (char *)USB_PRINTER_MALLOC( 12 + 8 + 4 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1200,7 +1270,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 12 + 12+ 14 + 4 );
+            buffer = (char *)USB_PRINTER_MALLOC( 12 + 12+ 14 + 4 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1225,7 +1295,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 12 + (24 + 18) * 4 + 4 );
+            buffer = (char *)USB_PRINTER_MALLOC( 12 + (24 + 18) * 4 + 4 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1292,7 +1362,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 12 + 2 * (12 + 12) + 4 * (12 + 13) + 4 );
+            buffer = (char *)USB_PRINTER_MALLOC( 12 + 2 * (12 + 12) + 4 * (12 + 13) + 4 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1353,7 +1423,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 12 + 12 + 4 );
+            buffer = (char *)USB_PRINTER_MALLOC( 12 + 12 + 4 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1379,7 +1449,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 12 + 12 + 12 + 4 );
+            buffer = (char *)USB_PRINTER_MALLOC( 12 + 12 + 12 + 4 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1413,7 +1483,7 @@ uint8_t USBHostPrinterLanguagePCL5( uint8_t address,
             }
             #endif
 
-            buffer = (char *)USB_MALLOC( 12 + (10 * (((USB_PRINTER_GRAPHICS_PARAMETERS *)(data.pointerRAM))->sPolygon.numPoints + 1)) + 4 );
+            buffer = (char *)USB_PRINTER_MALLOC( 12 + (10 * (((USB_PRINTER_GRAPHICS_PARAMETERS *)(data.pointerRAM))->sPolygon.numPoints + 1)) + 4 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1556,7 +1626,7 @@ static uint8_t _PrintFontCommand( uint8_t printer, uint8_t transferFlags )
     char    *buffer;
     uint8_t    font;
 
-    buffer = (char *)USB_MALLOC( 40 );
+    buffer = (char *)USB_PRINTER_MALLOC( 40 );
     if (buffer == NULL)
     {
         return USB_PRINTER_OUT_OF_MEMORY;
@@ -1684,7 +1754,7 @@ static uint8_t _PrintFontCommand( uint8_t printer, uint8_t transferFlags )
 
     USBHOSTPRINTER_SETFLAG_COPY_DATA( transferFlags );
 
-    buffer = (char *)USB_MALLOC( strlen(command) + 1 );
+    buffer = (char *)USB_PRINTER_MALLOC( strlen(command) + 1 );
     if (buffer == NULL)
     {
         return USB_PRINTER_OUT_OF_MEMORY;
@@ -0,0 +1,352 @@
+/******************************************************************************
+
+  USB Host Printer Client Driver, Buffer Pool
+
+Summary:
+    This file provides the fixed buffers used by the printer language
+    drivers.
+
+Description:
+    This file provides the fixed buffers used by the printer language
+    drivers when USB_PRINTER_BUFFER_POOL is defined.  Every command builds
+    its output in a buffer that the printer client frees once the transfer
+    is done, so a long print job allocates and frees the heap thousands of
+    times with buffers of many sizes, and the heap fragments until an
+    allocation fails.
+
+    The pool has two sizes of blocks: command blocks of
+    USB_PRINTER_POOL_COMMAND_SIZE bytes, and row blocks of
+    USB_PRINTER_POOL_ROW_SIZE bytes for image rows and bands.  Which blocks
+    are in use is kept in a bit mask, so taking and returning a block takes
+    the same time however long the job runs, and nothing can fragment.
+
+* FileName:        usb_host_printer_pool.c
+* Dependencies:    None
+* Processor:       PIC24/dsPIC30/dsPIC33/PIC32MX
+* Compiler:        C30/C32
+* Company:         Microchip Technology, Inc.
+
+Software License Agreement
+
+The software supplied herewith by Microchip Technology Incorporated
+(the "Company") for its PICmicro(R) Microcontroller is intended and
+supplied to you, the Company's customer, for use solely and
+exclusively on Microchip PICmicro Microcontroller products. The
+software is owned by the Company and/or its supplier, and is
+protected under applicable copyright laws. All rights are reserved.
+Any use in violation of the foregoing restrictions may subject the
+user to criminal sanctions under applicable laws, as well as to
+civil liability for the breach of the terms and conditions of this
+license.
+
+THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+
+*******************************************************************************/
+
+
+#include <stdlib.h>
+#include "usb_config.h"
+#include <usb/usb_host_printer_pool.h>
+
+#if defined( USB_PRINTER_BUFFER_POOL )
+
+#ifndef USB_FREE
+    #define USB_FREE(ptr) free(ptr)
+#endif
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Constants
+// *****************************************************************************
+// *****************************************************************************
+
+#define NO_BLOCK                    0xFF    // Returned by _TakeBlock() when all blocks are in use.
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Structures
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* Block List
+
+This structure keeps track of the blocks of one size.
+*/
+typedef struct _BLOCK_LIST
+{
+    uint32_t    used;           // Bit n is set if block n is in use.
+    uint8_t     free;           // Number of blocks not in use.
+    uint8_t     lowWater;       // Fewest blocks ever free.
+} BLOCK_LIST;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Global Variables
+// *****************************************************************************
+// *****************************************************************************
+
+static uint8_t      commandBlocks[USB_PRINTER_POOL_COMMAND_BLOCKS][USB_PRINTER_POOL_COMMAND_SIZE];
+static uint8_t      rowBlocks[USB_PRINTER_POOL_ROW_BLOCKS][USB_PRINTER_POOL_ROW_SIZE];
+
+static BLOCK_LIST   commandList = { 0, USB_PRINTER_POOL_COMMAND_BLOCKS, USB_PRINTER_POOL_COMMAND_BLOCKS };
+static BLOCK_LIST   rowList     = { 0, USB_PRINTER_POOL_ROW_BLOCKS, USB_PRINTER_POOL_ROW_BLOCKS };
+static uint32_t     poolFailures;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Prototypes
+// *****************************************************************************
+// *****************************************************************************
+
+static uint8_t _TakeBlock( BLOCK_LIST *list, uint8_t count );
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************************
+  Function:
+    void * USBHostPrinterBufferGet( uint32_t size )
+
+  Summary:
+    This function takes a buffer from the printer buffer pool.
+
+  Description:
+    This function takes the smallest free block of the printer buffer pool
+    that holds size bytes.  A command that does not find a free command
+    block is given a row block.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint32_t size   - Number of bytes needed
+
+  Returns:
+    The buffer, or NULL if no free block is large enough.
+
+  Remarks:
+    Like the heap, the pool must not be used from an interrupt.
+  ***************************************************************************/
+
+void * USBHostPrinterBufferGet( uint32_t size )
+{
+    uint8_t     i;
+
+    if (size <= USB_PRINTER_POOL_COMMAND_SIZE)
+    {
+        i = _TakeBlock( &commandList, USB_PRINTER_POOL_COMMAND_BLOCKS );
+        if (i != NO_BLOCK)
+        {
+            return commandBlocks[i];
+        }
+    }
+
+    if (size <= USB_PRINTER_POOL_ROW_SIZE)
+    {
+        i = _TakeBlock( &rowList, USB_PRINTER_POOL_ROW_BLOCKS );
+        if (i != NO_BLOCK)
+        {
+            return rowBlocks[i];
+        }
+    }
+
+    poolFailures++;
+    return NULL;
+}
+
+
+/****************************************************************************
+  Function:
+    void USBHostPrinterBufferRelease( void *buffer )
+
+  Summary:
+    This function returns a buffer to the printer buffer pool.
+
+  Description:
+    This function returns a buffer from USBHostPrinterBufferGet() to the
+    printer buffer pool.  A buffer that is not from the pool is passed to
+    USB_FREE().
+
+  Precondition:
+    None
+
+  Parameters:
+    void *buffer    - The buffer, or NULL
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+void USBHostPrinterBufferRelease( void *buffer )
+{
+    uintptr_t   address;
+    uint8_t     i;
+
+    if (buffer == NULL)
+    {
+        return;
+    }
+
+    address = (uintptr_t)buffer;
+    if ((address >= (uintptr_t)commandBlocks) && (address < (uintptr_t)commandBlocks + sizeof(commandBlocks)))
+    {
+        i = (address - (uintptr_t)commandBlocks) / USB_PRINTER_POOL_COMMAND_SIZE;
+        if (commandList.used & (1UL << i))
+        {
+            commandList.used &= ~(1UL << i);
+            commandList.free++;
+        }
+    }
+    else if ((address >= (uintptr_t)rowBlocks) && (address < (uintptr_t)rowBlocks + sizeof(rowBlocks)))
+    {
+        i = (address - (uintptr_t)rowBlocks) / USB_PRINTER_POOL_ROW_SIZE;
+        if (rowList.used & (1UL << i))
+        {
+            rowList.used &= ~(1UL << i);
+            rowList.free++;
+        }
+    }
+    else
+    {
+        USB_FREE( buffer );
+    }
+}
+
+
+/****************************************************************************
+  Function:
+    bool USBHostPrinterBufferAvailable( uint32_t size )
+
+  Summary:
+    This function tells if a buffer of the given size can be taken from the
+    pool.
+
+  Description:
+    This function tells if USBHostPrinterBufferGet() would return a buffer
+    of size bytes now: a command block or a row block is free for a buffer
+    of up to USB_PRINTER_POOL_COMMAND_SIZE bytes, and a row block for a
+    buffer of up to USB_PRINTER_POOL_ROW_SIZE bytes.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint32_t size   - Number of bytes needed
+
+  Return Values:
+    true    - A block large enough is free
+    false   - All blocks large enough are in use, or size is larger than a
+                row block
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+bool USBHostPrinterBufferAvailable( uint32_t size )
+{
+    if ((size <= USB_PRINTER_POOL_COMMAND_SIZE) && (commandList.free != 0))
+    {
+        return true;
+    }
+
+    return ((size <= USB_PRINTER_POOL_ROW_SIZE) && (rowList.free != 0));
+}
+
+
+/****************************************************************************
+  Function:
+    void USBHostPrinterBufferGetStats( USB_PRINTER_BUFFER_POOL_STATS *stats )
+
+  Description:
+    This function returns the statistics of the printer buffer pool.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_PRINTER_BUFFER_POOL_STATS *stats    - Filled in with the statistics
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+void USBHostPrinterBufferGetStats( USB_PRINTER_BUFFER_POOL_STATS *stats )
+{
+    stats->failures         = poolFailures;
+    stats->commandBlocks    = USB_PRINTER_POOL_COMMAND_BLOCKS;
+    stats->commandFree      = commandList.free;
+    stats->commandLowWater  = commandList.lowWater;
+    stats->rowBlocks        = USB_PRINTER_POOL_ROW_BLOCKS;
+    stats->rowFree          = rowList.free;
+    stats->rowLowWater      = rowList.lowWater;
+}
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Internal Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************************
+  Function:
+    static uint8_t _TakeBlock( BLOCK_LIST *list, uint8_t count )
+
+  Description:
+    This function marks the first free block of a list as in use.
+
+  Preconditions:
+    None
+
+  Parameters:
+    BLOCK_LIST *list    - The blocks of one size
+    uint8_t count       - Number of blocks in the list
+
+  Returns:
+    The index of the block, or NO_BLOCK if all are in use.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static uint8_t _TakeBlock( BLOCK_LIST *list, uint8_t count )
+{
+    uint8_t     i;
+
+    if (list->free == 0)
+    {
+        return NO_BLOCK;
+    }
+
+    for (i=0; (i<count) && (list->used & (1UL << i)); i++);
+
+    list->used |= 1UL << i;
+    list->free--;
+    if (list->free < list->lowWater)
+    {
+        list->lowWater = list->free;
+    }
+    return i;
+}
+
+#endif
@@ -20,6 +20,10 @@
     origin is located at the top left corner.  This matches the coordinate
     system use by the Microchip Graphics library.
 
+    Image data is sent run length encoded and in ASCII85, through the
+    RunLengthDecode and ASCII85Decode filters, so images require a PostScript
+    Level 2 printer.
+
 *******************************************************************************/
 //DOM-IGNORE-BEGIN
 /******************************************************************************
@@ -67,6 +71,8 @@ Change History:
 #include "USB/usb.h"
 #include "USB/usb_host_printer.h"
 #include "USB/usb_host_printer_postscript.h"
+#include "USB/usb_host_printer_pool.h"
+#include "USB/usb_host_printer_raster.h"
 
 //#define DEBUG_MODE
 #ifdef DEBUG_MODE
@@ -120,7 +126,9 @@ Change History:
 #define COMMAND_GRAPHICS_CIRCLE             "%d %d %d 0 360 arc "
 #define COMMAND_GRAPHICS_CLOSEPATH          "closepath "
 
-#define COMMAND_IMAGE_STOP                  ">} image grestore "
+#define COMMAND_IMAGE_START                 "gsave %d %d %d %7.2f mul sub translate %d %7.2f mul %d %7.2f mul scale " \
+                                            "{currentfile /ASCII85Decode filter dup /RunLengthDecode filter %d %d 1 [%d 0 0 -%d 0 %d] 5 -1 roll image flushfile} exec\n"
+#define COMMAND_IMAGE_STOP                  "\ngrestore "
 #define COMMAND_JOB_START                   ESCAPE "%-12345X"
 #define COMMAND_LANDSCAPE                   "612 0 translate 90 rotate "
 #define COMMAND_JOB_STOP                    "showpage " ESCAPE "%-12345X"
@@ -160,6 +168,10 @@ typedef struct _PRINTER_STATUS_POSTSCRIPT
     uint8_t    fontName;       // Currently selected font
     uint8_t    fontSize;       // Size of the current font
 
+    uint8_t    *imageBuffer;   // Row buffer, then run length encoded row buffer.
+    uint16_t    imageRowBytes;  // Bytes in each row of the current image.
+    USB_PRINTER_ASCII85 imageEncoder;   // ASCII85 state of the current image.
+
     union
     {
         uint8_t    value;
@@ -182,7 +194,6 @@ typedef struct _PRINTER_STATUS_POSTSCRIPT
 // *****************************************************************************
 // *****************************************************************************
 
-const unsigned char         _psCharacterArray[]={'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
 const char                  _psFontNames[USB_PRINTER_FONT_MAX_FONT][4][30] = {
     { "AvantGarde-Book", "AvantGarde-Demi", "AvantGarde-Oblique", "AvantGarde-DemiOblique" },
     { "Bookman-Light", "Bookman-Demi", "Bookman-LightOblique", "Bookman-DemiOblique" },
@@ -221,7 +232,7 @@ PRINTER_STATUS_POSTSCRIPT   printerListPostScript[USB_MAX_PRINTER_DEVICES];
     #define USB_FREE(ptr) free(ptr)
 #endif
 
-#define USB_FREE_AND_CLEAR(ptr) {USB_FREE(ptr); ptr = NULL;}
+#define USB_FREE_AND_CLEAR(ptr) {USB_PRINTER_FREE(ptr); ptr = NULL;}
 
 // *****************************************************************************
 // *****************************************************************************
@@ -344,6 +355,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
             if (printer != USB_MAX_PRINTER_DEVICES)
             {
                 printerListPostScript[printer].deviceAddress = 0;
+                USB_FREE_AND_CLEAR( printerListPostScript[printer].imageBuffer );
             }
             return USB_PRINTER_SUCCESS;
             break;
@@ -449,7 +461,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
             }
             if (transferFlags & USB_PRINTER_TRANSFER_COPY_DATA)
             {
-                buffer = (char *)USB_MALLOC( size );
+                buffer = (char *)USB_PRINTER_MALLOC( size );
                 if (buffer == NULL)
                 {
                     return USB_PRINTER_OUT_OF_MEMORY;
@@ -507,7 +519,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
             // This command sets the cursor to the specified position.  Note
             // that we must convert the specification to use PostScript's
             // orientation of the Y-axis.
-            buffer = (char *)USB_MALLOC( 16 );
+            buffer = (char *)USB_PRINTER_MALLOC( 16 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -521,18 +533,35 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
 
         //---------------------------------------------------------------------
         case USB_PRINTER_IMAGE_START:
-            buffer = (char *)USB_MALLOC( 146 );
-            if (buffer == NULL)
-            {
-                return USB_PRINTER_OUT_OF_MEMORY;
-            }
-
+            // The image data is read from the job itself, through the
+            // ASCII85Decode and RunLengthDecode filters.  The procedure runs
+            // flushfile after image, so the rest of the data, up to the end
+            // of data marker, is read before the next command.
             {
                 USB_PRINTER_IMAGE_INFO  *info;
 
                 info = (USB_PRINTER_IMAGE_INFO *)(data.pointerRAM);
 
-                sprintf( buffer, "gsave %d %d %d %7.2f mul sub translate %d %7.2f mul %d %7.2f mul scale %d %d 1 [%d 0 0 -%d 0 %d] {<",
+                // Allocate the row buffers for the whole image here, so the
+                // rows themselves need only their transfer buffer.
+                USB_FREE_AND_CLEAR( printerListPostScript[printer].imageBuffer );
+                printerListPostScript[printer].imageRowBytes = (info->width + 7) / 8;
+                printerListPostScript[printer].imageBuffer   = (uint8_t *)USB_PRINTER_MALLOC( (uint32_t)printerListPostScript[printer].imageRowBytes +
+                                                                    USB_PRINTER_RASTER_PACKBITS_MAX( (uint32_t)printerListPostScript[printer].imageRowBytes ) );
+                if (printerListPostScript[printer].imageBuffer == NULL)
+                {
+                    return USB_PRINTER_OUT_OF_MEMORY;
+                }
+                USBHostPrinterRasterASCII85Start( &(printerListPostScript[printer].imageEncoder) );
+
+                buffer = (char *)USB_PRINTER_MALLOC( 239 );
+                if (buffer == NULL)
+                {
+                    USB_FREE_AND_CLEAR( printerListPostScript[printer].imageBuffer );
+                    return USB_PRINTER_OUT_OF_MEMORY;
+                }
+
+                sprintf( buffer, COMMAND_IMAGE_START,
                     info->positionX, printerListPostScript[printer].currentHeight - info->positionY, info->height, (double)info->scale,
                     info->width, (double)info->scale, info->height, (double)info->scale,
                     info->width, info->height,
@@ -553,94 +582,99 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
 
         //---------------------------------------------------------------------
         case USB_PRINTER_IMAGE_DATA:
-            // We have to translate the data here from binary to an ASCII representation
-            // of the binary.  For each four bits, we need one uint8_t for the ASCII, plus one
-            // for a NULL at the end.  We cannot do this in terms of uint8_ts - PostScript will
-            // ignore extra bits at the end of a single character only, not at the end of
-            // a uint8_t.
-
-            // Determine the number of data nibbles.  We might have a size that is
-            // not an even multiple of 4 bits.  To account for this, add 3 to the
-            // size, and then divide by 4.
-            size += 3;
-            size /= 4;
-
-            buffer = (char *)USB_MALLOC( size + 1 ); // Add one for possible truncation error.
-            if (buffer == NULL)
+            // Each row is run length encoded, then the stream is encoded in
+            // ASCII85, which takes 5 characters for every 4 bytes.  Rows are
+            // padded to a whole byte, as image expects.
+            size += 7;
+            size /= 8;
+
+            if ((printerListPostScript[printer].imageBuffer == NULL) || (size > printerListPostScript[printer].imageRowBytes))
             {
-                return USB_PRINTER_OUT_OF_MEMORY;
+                return USB_PRINTER_BAD_PARAMETER;
             }
-            else
+
             {
-                uint16_t    i;
-                uint8_t    printVar;
-                char    *tempNew;
+                uint16_t    length;
+                uint8_t     *packed;
+                uint8_t     *row;
+
+                row    = printerListPostScript[printer].imageBuffer;
+                packed = row + printerListPostScript[printer].imageRowBytes;
 
-                // If the data is being read from ROM, then we have to
-                // use a different pointer type to get the data.
+                // The encoder reads RAM, so data from ROM is copied to the row
+                // buffer first.  So is a short row, which is padded with white.
                 if (transferFlags & USB_PRINTER_TRANSFER_FROM_ROM)
                 {
                     #if defined( __C30__ ) || defined __XC16__
-                        uint8_t __prog__   *tempOld;
+                        uint8_t __prog__   *ptr;
                     #elif defined( __PIC32MX__ )
-                        const uint8_t      *tempOld;
+                        const uint8_t      *ptr;
                     #endif
+                    uint16_t    i;
 
-                    tempNew = (char *)buffer;
-                    tempOld = ((USB_DATA_POINTER)data).pointerROM;
-
-                    // PostScript will ignore extra bits at the end of a nibble, but
-                    // not at the end of a uint8_t.  Therefore, we have to print one
-                    // nibble at a time.
+                    ptr = ((USB_DATA_POINTER)data).pointerROM;
                     for (i=0; i<size; i++)
                     {
-                        if (!(i & 0x01))
-                        {
-                            // Most significant nibble.  Don't advance the uint8_t pointer.
-                            printVar = (*tempOld>>4) & 0x0F;
-                        }
-                        else
-                        {
-                            // Least significant nibble.  Advance the uint8_t pointer.
-                            printVar = *tempOld++ & 0x0F;
-                        }
-                        *tempNew++ = _psCharacterArray[printVar];
+                        row[i] = *ptr++;
                     }
                 }
+                else if (size < printerListPostScript[printer].imageRowBytes)
+                {
+                    memcpy( row, ((USB_DATA_POINTER)data).pointerRAM, size );
+                }
                 else
                 {
-                    uint8_t    *tempOld;
+                    row = (uint8_t *)((USB_DATA_POINTER)data).pointerRAM;
+                }
+                if (size < printerListPostScript[printer].imageRowBytes)
+                {
+                    memset( &row[size], 0xFF, printerListPostScript[printer].imageRowBytes - size );
+                }
 
-                    tempNew = (char *)buffer;
-                    tempOld = ((USB_DATA_POINTER)data).pointerRAM;
+                length = USBHostPrinterRasterPackBits( row, printerListPostScript[printer].imageRowBytes, packed,
+                            USB_PRINTER_RASTER_PACKBITS_MAX( printerListPostScript[printer].imageRowBytes ) );
 
-                    // PostScript will ignore extra bits at the end of a nibble, but
-                    // not at the end of a uint8_t.  Therefore, we have to print one
-                    // nibble at a time.
-                    for (i=0; i<size; i++)
-                    {
-                        if (!(i & 0x01))
-                        {
-                            // Most significant nibble.  Don't advance the uint8_t pointer.
-                            printVar = (*tempOld>>4) & 0x0F;
-                        }
-                        else
-                        {
-                            // Least significant nibble.  Advance the uint8_t pointer.
-                            printVar = *tempOld++ & 0x0F;
-                        }
-                        *tempNew++ = _psCharacterArray[printVar];
-                    }
+                buffer = (char *)USB_PRINTER_MALLOC( USB_PRINTER_RASTER_ASCII85_MAX( length ) + 1 );
+                if (buffer == NULL)
+                {
+                    return USB_PRINTER_OUT_OF_MEMORY;
                 }
 
-                USBHOSTPRINTER_SETFLAG_COPY_DATA( transferFlags );
-                return USBHostPrinterWrite( printerListPostScript[printer].deviceAddress, buffer, size, transferFlags );
+                // End each row with a new line, which the filter ignores.
+                size = USBHostPrinterRasterASCII85( &(printerListPostScript[printer].imageEncoder), packed, length, buffer );
+                buffer[size++] = '\n';
             }
+
+            USBHOSTPRINTER_SETFLAG_COPY_DATA( transferFlags );
+            return USBHostPrinterWrite( printerListPostScript[printer].deviceAddress, buffer, size, transferFlags );
             break;
 
         //---------------------------------------------------------------------
         case USB_PRINTER_IMAGE_STOP:
-            return _PrintStaticCommand( address, COMMAND_IMAGE_STOP, transferFlags );
+            // End the run length data and the ASCII85 data, then the image.
+            // The image buffer marks the image as open, so it is only freed
+            // once the stop buffer is taken, and a failed stop can be retried.
+            if (printerListPostScript[printer].imageBuffer == NULL)
+            {
+                return USB_PRINTER_BAD_PARAMETER;
+            }
+
+            buffer = (char *)USB_PRINTER_MALLOC( 5 + 2 + sizeof(COMMAND_IMAGE_STOP) );
+            if (buffer == NULL)
+            {
+                return USB_PRINTER_OUT_OF_MEMORY;
+            }
+            USB_FREE_AND_CLEAR( printerListPostScript[printer].imageBuffer );
+            {
+                uint8_t     end;
+
+                end  = USB_PRINTER_RASTER_RLE_END;
+                size = USBHostPrinterRasterASCII85( &(printerListPostScript[printer].imageEncoder), &end, 1, buffer );
+                size += USBHostPrinterRasterASCII85End( &(printerListPostScript[printer].imageEncoder), &buffer[size] );
+                strcpy( &buffer[size], COMMAND_IMAGE_STOP );
+            }
+            USBHOSTPRINTER_SETFLAG_COPY_DATA( transferFlags );
+            return USBHostPrinterWrite( printerListPostScript[printer].deviceAddress, buffer, strlen(buffer), transferFlags );
             break;
 
 
@@ -731,7 +765,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
                     }
                 #endif
 
-                buffer = (char *)USB_MALLOC( 16 );
+                buffer = (char *)USB_PRINTER_MALLOC( 16 );
                 if (buffer == NULL)
                 {
                     return USB_PRINTER_OUT_OF_MEMORY;
@@ -757,7 +791,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 73 );
+            buffer = (char *)USB_PRINTER_MALLOC( 73 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -783,7 +817,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 46 );
+            buffer = (char *)USB_PRINTER_MALLOC( 46 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -809,7 +843,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 46 );
+            buffer = (char *)USB_PRINTER_MALLOC( 46 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -838,7 +872,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 15 + (56 + 11)* 2 );
+            buffer = (char *)USB_PRINTER_MALLOC( 15 + (56 + 11)* 2 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -956,7 +990,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 50 );
+            buffer = (char *)USB_PRINTER_MALLOC( 50 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -996,7 +1030,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 155 );
+            buffer = (char *)USB_PRINTER_MALLOC( 155 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1068,7 +1102,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
                 }
             #endif
 
-            buffer = (char *)USB_MALLOC( 80 );
+            buffer = (char *)USB_PRINTER_MALLOC( 80 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1128,7 +1162,7 @@ uint8_t USBHostPrinterLanguagePostScript( uint8_t address,
             }
             #endif
 
-            buffer = (char *)USB_MALLOC( 15 + ( 15 * ((USB_PRINTER_GRAPHICS_PARAMETERS *)(data.pointerRAM))->sPolygon.numPoints) + 18 );
+            buffer = (char *)USB_PRINTER_MALLOC( 15 + ( 15 * ((USB_PRINTER_GRAPHICS_PARAMETERS *)(data.pointerRAM))->sPolygon.numPoints) + 18 );
             if (buffer == NULL)
             {
                 return USB_PRINTER_OUT_OF_MEMORY;
@@ -1251,7 +1285,7 @@ static uint8_t _PrintFontCommand( uint8_t printer, uint8_t transferFlags )
     char    *buffer;
 //    char    temp[6];
 
-    buffer = (char *)USB_MALLOC( 1 + 30 + 10 + 5 + 20 );
+    buffer = (char *)USB_PRINTER_MALLOC( 1 + 30 + 10 + 5 + 20 );
     if (buffer == NULL)
     {
         return USB_PRINTER_OUT_OF_MEMORY;
@@ -1306,7 +1340,7 @@ static uint8_t _PrintStaticCommand( uint8_t address, char *command, uint8_t tran
 
     USBHOSTPRINTER_SETFLAG_COPY_DATA( transferFlags );
 
-    buffer = (char *)USB_MALLOC( strlen(command) + 1 );
+    buffer = (char *)USB_PRINTER_MALLOC( strlen(command) + 1 );
     if (buffer == NULL)
     {
         return USB_PRINTER_OUT_OF_MEMORY;
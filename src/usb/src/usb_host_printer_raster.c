@@ -0,0 +1,742 @@
+/******************************************************************************
+
+  USB Host Printer Client Driver, Raster Compression
+
+Summary:
+    This file compresses raster image rows for the printer language drivers.
+
+Description:
+    This file compresses raster image rows for the printer language drivers.
+    It provides TIFF PackBits (PCL method 2, and the PostScript
+    RunLengthDecode format) and delta row (PCL method 3) encoders, and
+    USBHostPrinterRasterCompressRow(), which picks whichever of them, or no
+    compression, sends the fewest bytes for each row.  For PostScript, it
+    also provides an ASCII85 encoder, which sends 5 characters for every 4
+    bytes instead of the 8 characters of hexadecimal.  For ESC/POS, it
+    collects image rows into GS v 0 raster bit image blocks, each sent in one
+    transfer.
+
+    The encoders only use the buffers they are given, so they can be used
+    for any printer, and built for other targets to check them.
+
+* FileName:        usb_host_printer_raster.c
+* Dependencies:    None
+* Processor:       PIC24/dsPIC30/dsPIC33/PIC32MX
+* Compiler:        C30/C32
+* Company:         Microchip Technology, Inc.
+
+Software License Agreement
+
+The software supplied herewith by Microchip Technology Incorporated
+(the "Company") for its PICmicro(R) Microcontroller is intended and
+supplied to you, the Company's customer, for use solely and
+exclusively on Microchip PICmicro Microcontroller products. The
+software is owned by the Company and/or its supplier, and is
+protected under applicable copyright laws. All rights are reserved.
+Any use in violation of the foregoing restrictions may subject the
+user to criminal sanctions under applicable laws, as well as to
+civil liability for the breach of the terms and conditions of this
+license.
+
+THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+
+*******************************************************************************/
+
+
+#include <string.h>
+#include <usb/usb_host_printer_raster.h>
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Constants
+// *****************************************************************************
+// *****************************************************************************
+
+#define PACKBITS_MAX_RUN            128     // Longest run or literal in one control byte.
+#define DELTA_ROW_MAX_RUN           8       // Most bytes replaced by one command byte.
+#define DELTA_ROW_MAX_OFFSET        31      // Offset that continues in further bytes.
+
+#define ASCII85_FIRST               '!'     // Character for a digit of 0.
+#define ASCII85_ZERO_GROUP          'z'     // Character for a group of four zero bytes.
+#define ASCII85_END                 "~>"    // End of data marker.
+#define ASCII85_85_CUBED            614125ul
+#define ASCII85_85_SQUARED          7225u
+
+#define BAND_GS                     0x1D    // First byte of GS v 0.
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Macros
+// *****************************************************************************
+// *****************************************************************************
+
+#define _MethodCost(m,current)      (((m) == (current)) ? 0 : USB_PRINTER_RASTER_METHOD_CHANGE_COST)
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Prototypes
+// *****************************************************************************
+// *****************************************************************************
+
+static void _ASCII85Digits( uint32_t group, char *out );
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostPrinterRasterPackBits( const uint8_t *data, uint16_t size,
+                uint8_t *out, uint16_t limit )
+
+  Description:
+    This function compresses data with TIFF PackBits.  Runs of three or more
+    bytes are always packed.  A run of two is packed only if no literal is
+    pending, since splitting a literal for it would cost a control byte.
+
+  Precondition:
+    None
+
+  Parameters:
+    const uint8_t *data - Data to compress
+    uint16_t size       - Number of bytes of data
+    uint8_t *out        - Where to put the compressed data
+    uint16_t limit      - Most bytes to put in out
+
+  Returns:
+    The number of compressed bytes, or USB_PRINTER_RASTER_TOO_LONG if they
+    would be more than limit.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint16_t USBHostPrinterRasterPackBits( const uint8_t *data, uint16_t size, uint8_t *out, uint16_t limit )
+{
+    uint16_t    i;
+    uint16_t    literal;
+    uint16_t    n;
+    uint16_t    run;
+
+    i       = 0;
+    literal = 0;
+    n       = 0;
+    while (i < size)
+    {
+        run = 1;
+        while ((i + run < size) && (run < PACKBITS_MAX_RUN) && (data[i + run] == data[i]))
+        {
+            run++;
+        }
+
+        if ((run > 2) || ((run == 2) && (literal == 0)))
+        {
+            if (literal)
+            {
+                if ((uint32_t)n + 1 + literal > limit)
+                {
+                    return USB_PRINTER_RASTER_TOO_LONG;
+                }
+                out[n++] = (uint8_t)(literal - 1);
+                memcpy( &out[n], &data[i - literal], literal );
+                n      += literal;
+                literal = 0;
+            }
+
+            if ((uint32_t)n + 2 > limit)
+            {
+                return USB_PRINTER_RASTER_TOO_LONG;
+            }
+            out[n++] = (uint8_t)(257 - run);
+            out[n++] = data[i];
+            i       += run;
+        }
+        else
+        {
+            literal++;
+            i++;
+            if ((literal == PACKBITS_MAX_RUN) || (i == size))
+            {
+                if ((uint32_t)n + 1 + literal > limit)
+                {
+                    return USB_PRINTER_RASTER_TOO_LONG;
+                }
+                out[n++] = (uint8_t)(literal - 1);
+                memcpy( &out[n], &data[i - literal], literal );
+                n      += literal;
+                literal = 0;
+            }
+        }
+    }
+
+    return n;
+}
+
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostPrinterRasterDeltaRow( const uint8_t *data,
+                const uint8_t *seed, uint16_t size, uint8_t *out,
+                uint16_t limit )
+
+  Description:
+    This function encodes a raster row as the changes from the seed row.
+
+  Precondition:
+    None
+
+  Parameters:
+    const uint8_t *data - Row to encode
+    const uint8_t *seed - Previous row, the same size
+    uint16_t size       - Number of bytes in the row
+    uint8_t *out        - Where to put the encoded row
+    uint16_t limit      - Most bytes to put in out
+
+  Returns:
+    The number of encoded bytes, or USB_PRINTER_RASTER_TOO_LONG if they
+    would be more than limit.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint16_t USBHostPrinterRasterDeltaRow( const uint8_t *data, const uint8_t *seed, uint16_t size, uint8_t *out, uint16_t limit )
+{
+    uint16_t    i;
+    uint16_t    n;
+    uint16_t    offset;
+    uint16_t    position;
+    uint8_t     run;
+    uint16_t    start;
+
+    i        = 0;
+    n        = 0;
+    position = 0;
+    while (i < size)
+    {
+        if (data[i] == seed[i])
+        {
+            i++;
+            continue;
+        }
+
+        start = i;
+        run   = 0;
+        while ((i < size) && (run < DELTA_ROW_MAX_RUN) && (data[i] != seed[i]))
+        {
+            i++;
+            run++;
+        }
+
+        // The offset counts from the byte after the last run.
+        offset = start - position;
+        if ((uint32_t)n + 1 + run + ((offset >= DELTA_ROW_MAX_OFFSET) ? (offset - DELTA_ROW_MAX_OFFSET) / 255 + 1 : 0) > limit)
+        {
+            return USB_PRINTER_RASTER_TOO_LONG;
+        }
+
+        if (offset < DELTA_ROW_MAX_OFFSET)
+        {
+            out[n++] = (uint8_t)(((run - 1) << 5) | offset);
+        }
+        else
+        {
+            out[n++] = (uint8_t)(((run - 1) << 5) | DELTA_ROW_MAX_OFFSET);
+            offset  -= DELTA_ROW_MAX_OFFSET;
+            while (offset >= 255)
+            {
+                out[n++] = 255;
+                offset  -= 255;
+            }
+            out[n++] = (uint8_t)offset;
+        }
+
+        memcpy( &out[n], &data[start], run );
+        n       += run;
+        position = i;
+    }
+
+    return n;
+}
+
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostPrinterRasterCompressRow( const uint8_t *data,
+                const uint8_t *seed, uint16_t size, uint8_t *method,
+                uint8_t *out, uint8_t *scratch )
+
+  Description:
+    This function compresses a raster row with the method that sends the
+    fewest bytes, counting the cost of changing the method.  Each encoder is
+    given the length to beat as its limit, so it stops as soon as it cannot
+    win.
+
+  Precondition:
+    None
+
+  Parameters:
+    const uint8_t *data - Row to compress
+    const uint8_t *seed - Previous row of the image, or zeros for the first
+    uint16_t size       - Number of bytes in the row
+    uint8_t *method     - In: the method currently selected on the printer.
+                          Out: the method used for this row.
+    uint8_t *out        - Where to put the compressed row, size bytes
+    uint8_t *scratch    - Work space, size bytes
+
+  Returns:
+    The number of compressed bytes in out.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint16_t USBHostPrinterRasterCompressRow( const uint8_t *data, const uint8_t *seed, uint16_t size,
+            uint8_t *method, uint8_t *out, uint8_t *scratch )
+{
+    uint8_t     bestMethod;
+    uint32_t    bestCost;
+    uint16_t    bestLength;
+    uint32_t    limit;
+    uint16_t    length;
+    uint16_t    used;
+
+    // Uncompressed and PackBits rows are zero filled by the printer.
+    used = size;
+    while (used && (data[used - 1] == 0))
+    {
+        used--;
+    }
+
+    bestMethod = USB_PRINTER_RASTER_UNCOMPRESSED;
+    bestLength = used;
+    bestCost   = used + _MethodCost( USB_PRINTER_RASTER_UNCOMPRESSED, *method );
+
+    // Delta row, straight into out.
+    if (bestCost > _MethodCost( USB_PRINTER_RASTER_DELTA_ROW, *method ))
+    {
+        limit = bestCost - _MethodCost( USB_PRINTER_RASTER_DELTA_ROW, *method ) - 1;
+        if (limit > size)
+        {
+            limit = size;
+        }
+        length = USBHostPrinterRasterDeltaRow( data, seed, size, out, (uint16_t)limit );
+        if (length != USB_PRINTER_RASTER_TOO_LONG)
+        {
+            bestMethod = USB_PRINTER_RASTER_DELTA_ROW;
+            bestLength = length;
+            bestCost   = length + _MethodCost( USB_PRINTER_RASTER_DELTA_ROW, *method );
+        }
+    }
+
+    // PackBits, into scratch if out holds the delta row.
+    if (bestCost > _MethodCost( USB_PRINTER_RASTER_PACKBITS, *method ))
+    {
+        limit = bestCost - _MethodCost( USB_PRINTER_RASTER_PACKBITS, *method ) - 1;
+        if (limit > size)
+        {
+            limit = size;
+        }
+        length = USBHostPrinterRasterPackBits( data, used,
+                    (bestMethod == USB_PRINTER_RASTER_DELTA_ROW) ? scratch : out, (uint16_t)limit );
+        if (length != USB_PRINTER_RASTER_TOO_LONG)
+        {
+            if (bestMethod == USB_PRINTER_RASTER_DELTA_ROW)
+            {
+                memcpy( out, scratch, length );
+            }
+            bestMethod = USB_PRINTER_RASTER_PACKBITS;
+            bestLength = length;
+        }
+    }
+
+    if (bestMethod == USB_PRINTER_RASTER_UNCOMPRESSED)
+    {
+        memcpy( out, data, used );
+    }
+
+    *method = bestMethod;
+    return bestLength;
+}
+
+
+/****************************************************************************
+  Function:
+    void USBHostPrinterRasterASCII85Start( USB_PRINTER_ASCII85 *state )
+
+  Description:
+    This function starts an ASCII85 stream.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_PRINTER_ASCII85 *state  - Encoder state of the stream
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+void USBHostPrinterRasterASCII85Start( USB_PRINTER_ASCII85 *state )
+{
+    state->group = 0;
+    state->count = 0;
+}
+
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostPrinterRasterASCII85( USB_PRINTER_ASCII85 *state,
+                const uint8_t *data, uint16_t size, char *out )
+
+  Description:
+    This function encodes data in ASCII85.  Once a partial group from the
+    last call is completed, the data is taken a whole group at a time.
+
+  Precondition:
+    USBHostPrinterRasterASCII85Start() has been called for the stream.
+
+  Parameters:
+    USB_PRINTER_ASCII85 *state  - Encoder state of the stream
+    const uint8_t *data         - Data to encode
+    uint16_t size               - Number of bytes of data
+    char *out                   - Where to put the characters
+
+  Returns:
+    The number of characters put in out.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint16_t USBHostPrinterRasterASCII85( USB_PRINTER_ASCII85 *state, const uint8_t *data, uint16_t size, char *out )
+{
+    uint32_t    group;
+    char        *start;
+
+    start = out;
+
+    // Complete the partial group from the last call.
+    if (state->count)
+    {
+        while (size && (state->count < 4))
+        {
+            state->group = (state->group << 8) | *data++;
+            state->count++;
+            size--;
+        }
+        if (state->count < 4)
+        {
+            return 0;
+        }
+
+        if (state->group == 0)
+        {
+            *out++ = ASCII85_ZERO_GROUP;
+        }
+        else
+        {
+            _ASCII85Digits( state->group, out );
+            out += 5;
+        }
+        state->group = 0;
+        state->count = 0;
+    }
+
+    while (size >= 4)
+    {
+        group = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint16_t)data[2] << 8) | data[3];
+        if (group == 0)
+        {
+            *out++ = ASCII85_ZERO_GROUP;
+        }
+        else
+        {
+            _ASCII85Digits( group, out );
+            out += 5;
+        }
+        data += 4;
+        size -= 4;
+    }
+
+    while (size)
+    {
+        state->group = (state->group << 8) | *data++;
+        state->count++;
+        size--;
+    }
+
+    return out - start;
+}
+
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostPrinterRasterASCII85End( USB_PRINTER_ASCII85 *state,
+                char *out )
+
+  Description:
+    This function encodes the partial group left in state, if any, and adds
+    the end of data marker.  A partial group of n bytes is padded with zeros
+    and sent as its first n+1 characters.
+
+  Precondition:
+    USBHostPrinterRasterASCII85Start() has been called for the stream.
+
+  Parameters:
+    USB_PRINTER_ASCII85 *state  - Encoder state of the stream
+    char *out                   - Where to put the characters
+
+  Returns:
+    The number of characters put in out.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint16_t USBHostPrinterRasterASCII85End( USB_PRINTER_ASCII85 *state, char *out )
+{
+    char        digits[5];
+    uint16_t    length;
+
+    length = 0;
+    if (state->count)
+    {
+        _ASCII85Digits( state->group << (8 * (4 - state->count)), digits );
+        memcpy( out, digits, state->count + 1 );
+        length = state->count + 1;
+    }
+    memcpy( &out[length], ASCII85_END, 2 );
+
+    state->group = 0;
+    state->count = 0;
+    return length + 2;
+}
+
+
+/****************************************************************************
+  Function:
+    bool USBHostPrinterRasterBandStart( USB_PRINTER_RASTER_BAND *band,
+                uint16_t width, uint8_t mode, uint16_t bufferSize,
+                uint16_t maxRows )
+
+  Description:
+    This function sets up the GS v 0 bands of an image width dots wide.  A
+    band holds as many rows as fit in bufferSize bytes after the header, but
+    no more than maxRows, and at least one.
+
+  Precondition:
+    band->buffer is NULL.
+
+  Parameters:
+    USB_PRINTER_RASTER_BAND *band   - Band state of the image
+    uint16_t width                  - Width of the image in dots
+    uint8_t mode                    - GS v 0 mode, USB_PRINTER_RASTER_BAND_*
+    uint16_t bufferSize             - Size of a band buffer
+    uint16_t maxRows                - Most rows the printer takes in a block
+
+  Returns:
+    true if the bands were set up, false if width is 0.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+bool USBHostPrinterRasterBandStart( USB_PRINTER_RASTER_BAND *band, uint16_t width, uint8_t mode,
+            uint16_t bufferSize, uint16_t maxRows )
+{
+    band->buffer    = NULL;
+    band->rowCount  = 0;
+    band->rowBytes  = (width + 7) / 8;
+    band->endMask   = 0xFF << ((8 - (width & 0x07)) & 0x07);
+    band->mode      = mode;
+    if (band->rowBytes == 0)
+    {
+        return false;
+    }
+
+    band->rows = 0;
+    if (bufferSize > USB_PRINTER_RASTER_BAND_HEADER_SIZE)
+    {
+        band->rows = (bufferSize - USB_PRINTER_RASTER_BAND_HEADER_SIZE) / band->rowBytes;
+    }
+    if (band->rows > maxRows)
+    {
+        band->rows = maxRows;
+    }
+    if (band->rows == 0)
+    {
+        band->rows = 1;
+    }
+    return true;
+}
+
+
+/****************************************************************************
+  Function:
+    uint8_t *USBHostPrinterRasterBandRow( USB_PRINTER_RASTER_BAND *band )
+
+  Description:
+    This function returns where the next row of the band goes, after the
+    header and the rows already in the band.
+
+  Precondition:
+    band->buffer has been allocated and the band is not full.
+
+  Parameters:
+    USB_PRINTER_RASTER_BAND *band   - Band state of the image
+
+  Returns:
+    Where to put the next row.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint8_t *USBHostPrinterRasterBandRow( USB_PRINTER_RASTER_BAND *band )
+{
+    return &band->buffer[USB_PRINTER_RASTER_BAND_HEADER_SIZE + (uint32_t)band->rowCount * band->rowBytes];
+}
+
+
+/****************************************************************************
+  Function:
+    bool USBHostPrinterRasterBandAddRow( USB_PRINTER_RASTER_BAND *band,
+                uint16_t size )
+
+  Description:
+    This function blanks the row from size bytes to the end of the image,
+    clears the bits of its last byte that are outside the image, and counts
+    it in the band.
+
+  Precondition:
+    The row has been put at USBHostPrinterRasterBandRow().
+
+  Parameters:
+    USB_PRINTER_RASTER_BAND *band   - Band state of the image
+    uint16_t size                   - Bytes of the row that were put there,
+                                        1 to rowBytes
+
+  Returns:
+    true if the band is full.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+bool USBHostPrinterRasterBandAddRow( USB_PRINTER_RASTER_BAND *band, uint16_t size )
+{
+    uint8_t     *row;
+
+    row = USBHostPrinterRasterBandRow( band );
+    memset( &row[size], 0, band->rowBytes - size );
+    row[band->rowBytes - 1] &= band->endMask;
+
+    band->rowCount++;
+    return (band->rowCount == band->rows);
+}
+
+
+/****************************************************************************
+  Function:
+    uint8_t *USBHostPrinterRasterBandEnd( USB_PRINTER_RASTER_BAND *band,
+                uint32_t *length )
+
+  Description:
+    This function fills in the GS v 0 header, GS v 0 m xL xH yL yH, with the
+    mode, the bytes in each row and the rows in the band, and takes the
+    buffer off the band state.
+
+  Precondition:
+    The band holds at least one row.
+
+  Parameters:
+    USB_PRINTER_RASTER_BAND *band   - Band state of the image
+    uint32_t *length                - Returns the number of bytes to send
+
+  Returns:
+    The band buffer.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint8_t *USBHostPrinterRasterBandEnd( USB_PRINTER_RASTER_BAND *band, uint32_t *length )
+{
+    uint8_t     *buffer;
+
+    buffer      = band->buffer;
+    buffer[0]   = BAND_GS;
+    buffer[1]   = 'v';
+    buffer[2]   = '0';
+    buffer[3]   = band->mode;
+    buffer[4]   = band->rowBytes & 0xFF;
+    buffer[5]   = band->rowBytes >> 8;
+    buffer[6]   = band->rowCount & 0xFF;
+    buffer[7]   = band->rowCount >> 8;
+    *length     = USB_PRINTER_RASTER_BAND_HEADER_SIZE + (uint32_t)band->rowCount * band->rowBytes;
+
+    band->buffer    = NULL;
+    band->rowCount  = 0;
+    return buffer;
+}
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************************
+  Function:
+    static void _ASCII85Digits( uint32_t group, char *out )
+
+  Description:
+    This function writes the five base 85 digits of a group, most
+    significant first.  The group is split at 85^3 first, so only two
+    divisions need 32 bits and the rest are done in 16 bits.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint32_t group  - Four bytes, the first in the most significant byte
+    char *out       - Where to put the five characters
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+static void _ASCII85Digits( uint32_t group, char *out )
+{
+    uint16_t    high;
+    uint32_t    low;
+    uint16_t    rest;
+
+    high    = (uint16_t)(group / ASCII85_85_CUBED);             // Below 85^2
+    low     = group - (uint32_t)high * ASCII85_85_CUBED;        // Below 85^3
+    out[0]  = ASCII85_FIRST + high / 85;
+    out[1]  = ASCII85_FIRST + high % 85;
+    out[2]  = ASCII85_FIRST + (uint8_t)(low / ASCII85_85_SQUARED);
+    rest    = (uint16_t)(low % ASCII85_85_SQUARED);
+    out[3]  = ASCII85_FIRST + rest / 85;
+    out[4]  = ASCII85_FIRST + rest % 85;
+}
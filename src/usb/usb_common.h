@@ -218,7 +218,8 @@ typedef enum
 
     EVENT_HOST_STACK_BASE = 100,
 
-    // A USB hub has been attached.  Hub support is not currently available.
+    // A USB hub has been attached and USB_HUB_SUPPORT_INCLUDED is not
+    // defined.  See usb_host_hub.h for the hub client driver.
     EVENT_HUB_ATTACH,           
     
     // A stall has occured.  This event is not used by the Host stack.
@@ -341,6 +342,7 @@ typedef enum
     EVENT_CHARGER_BASE  = 900,      // Offset for Charger client driver events.
 
     EVENT_AUDIO_BASE    = 1000,      // Offset for Audio client driver events.
+    EVENT_HUB_BASE      = 1100,      // Offset for Hub client driver events.
         
 	EVENT_USER_BASE     = 10000,    // Add integral values to this event number
                                     // to create user-defined events.
@@ -49,6 +49,8 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 	#endif
 #elif defined(__PIC32MX__)
     #include "usb/usb_hal_pic32.h"
+#elif defined(USB_SIMULATOR)
+    #include <usb/usb_hal_sim.h>
 #else
     #error "Silicon Platform not defined"
 #endif
@@ -0,0 +1,557 @@
+//DOM-IGNORE-BEGIN
+/*******************************************************************************
+Software License Agreement
+
+The software supplied herewith by Microchip Technology Incorporated
+(the "Company") for its PICmicro(R) Microcontroller is intended and
+supplied to you, the Company's customer, for use solely and
+exclusively on Microchip PICmicro Microcontroller products. The
+software is owned by the Company and/or its supplier, and is
+protected under applicable copyright laws. All rights are reserved.
+Any use in violation of the foregoing restrictions may subject the
+user to criminal sanctions under applicable laws, as well as to
+civil liability for the breach of the terms and conditions of this
+license.
+
+THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+
+*******************************************************************************/
+//DOM-IGNORE-END
+
+#ifndef USB_HAL_SIM_H
+#define USB_HAL_SIM_H
+
+/*****************************************************************************/
+/****** include files ********************************************************/
+/*****************************************************************************/
+
+#include "system.h"
+#include "system_config.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <usb/usb_common.h>
+
+/*****************************************************************************/
+/****** Constant definitions *************************************************/
+/*****************************************************************************/
+
+// The simulated host controller is selected with USB_SIMULATOR.  It replaces
+// the PIC24/PIC32 USB OTG module with a register file in RAM and a software
+// model of the bus, so that usb_host.c and the host client drivers can be
+// built and run on a PC.  Devices on the bus are software models, see
+// USB_SIM_DEVICE.  All timing is taken from a virtual clock that advances
+// with the simulated bus traffic, so a run is fully repeatable.
+
+#define USB_SIM_FRAME_TIME              1000000ul   // Frame length, in ns.
+#define USB_SIM_FULL_SPEED_BIT_TIME     83          // Bit time at 12 Mbit/s, in ns.
+#define USB_SIM_LOW_SPEED_BIT_TIME      667         // Bit time at 1.5 Mbit/s, in ns.
+
+// Size of the control transfer data buffer of the simulated device.  Longer
+// descriptors and class requests are truncated.
+#ifndef USB_SIM_CONTROL_BUFFER_SIZE
+    #define USB_SIM_CONTROL_BUFFER_SIZE 512
+#endif
+
+// Number of devices that can be connected behind a hub on the root port,
+// see USBSimHubPortAttach().
+#ifndef USB_SIM_HUB_PORTS
+    #define USB_SIM_HUB_PORTS           4
+#endif
+
+// Return values of the USB_SIM_DEVICE In(), Out() and Request() functions.
+#define USB_SIM_ACK                     0           // Out()/Request(): data accepted.
+#define USB_SIM_NAK                     (-1)        // The device is not ready, the host retries.
+#define USB_SIM_STALL                   (-2)        // The endpoint or request is stalled.
+
+#define BDT_BASE_ADDR_TAG   __attribute__ ((aligned (512)))
+#define CTRL_TRF_SETUP_ADDR_TAG
+#define CTRL_TRF_DATA_ADDR_TAG
+
+/*****************************************************************************/
+/****** Type definitions *****************************************************/
+/*****************************************************************************/
+
+// Buffer Descriptor Status Register layout.
+typedef union _BD_STAT
+{
+    struct{
+        uint8_t             :2;     //Byte count
+        uint8_t     BSTALL  :1;     //Buffer Stall Enable
+        uint8_t     DTSEN   :1;     //Data Toggle Synch Enable
+        uint8_t             :2;     //Reserved - write as 00
+        uint8_t     DTS     :1;     //Data Toggle Synch Value
+        uint8_t     UOWN    :1;     //USB Ownership
+    };
+    struct{
+        uint8_t             :2;
+        uint8_t     PID     :4;     // Packet Identifier
+    };
+    uint8_t            Val;
+} BD_STAT;                      //Buffer Descriptor Status Register
+
+// BDT Entry Layout.  The buffer address is a full pointer on the PC, so
+// the entry is not packed like the hardware entry.
+typedef struct __BDT
+{
+    BD_STAT         STAT;
+    uint16_t        count;          // Byte count
+    uint8_t         *ADR;           // Buffer Address
+} BDT_ENTRY;
+
+// USB OTG module register layouts.  Only the bits used by the host stack
+// are named.
+typedef union
+{
+    struct
+    {
+        uint8_t VBUSVDIF:1, :1, SESENDIF:1, SESVDIF:1, ACTVIF:1, LSTATEIF:1, T1MSECIF:1, IDIF:1;
+    };
+    struct
+    {
+        uint8_t VBUSVDIE:1, :1, SESENDIE:1, SESVDIE:1, ACTVIE:1, LSTATEIE:1, T1MSECIE:1, IDIE:1;
+    };
+    struct
+    {
+        uint8_t VBUSVD:1, :1, SESEND:1, SESVD:1, :1, LSTATE:1, :1, ID:1;
+    };
+    uint8_t Val;
+} USB_SIM_OTG_REGISTER;
+
+typedef union
+{
+    struct
+    {
+        uint8_t DETACHIF:1, UERRIF:1, SOFIF:1, TRNIF:1, IDLEIF:1, RESUMEIF:1, ATTACHIF:1, STALLIF:1;
+    };
+    struct
+    {
+        uint8_t DETACHIE:1, UERRIE:1, SOFIE:1, TRNIE:1, IDLEIE:1, RESUMEIE:1, ATTACHIE:1, STALLIE:1;
+    };
+    uint8_t Val;
+} USB_SIM_INTERRUPT_REGISTER;
+
+typedef union
+{
+    struct
+    {
+        uint8_t PIDEF:1, EOFEF:1, CRC16EF:1, DFN8EF:1, BTOEF:1, DMAEF:1, BMXEF:1, BTSEF:1;
+    };
+    uint8_t Val;
+} USB_SIM_ERROR_REGISTER;
+
+typedef union
+{
+    struct
+    {
+        uint8_t :2, PPBI:1, DIR:1, ENDPT:4;
+    };
+    uint8_t Val;
+} USB_SIM_STAT_REGISTER;
+
+typedef union
+{
+    struct
+    {
+        uint8_t SOFEN:1, PPBRST:1, RESUME:1, HOSTEN:1, USBRST:1, TOKBUSY:1, SE0:1, JSTATE:1;
+    };
+    uint8_t Val;
+} USB_SIM_CON_REGISTER;
+
+typedef union
+{
+    struct
+    {
+        uint8_t EPHSHK:1, EPSTALL:1, EPTXEN:1, EPRXEN:1, EPCONDIS:1, :1, RETRYDIS:1, LSPD:1;
+    };
+    uint8_t Val;
+} USB_SIM_EP_REGISTER;
+
+typedef union
+{
+    struct
+    {
+        uint8_t USBPWR:1, USUSPND:1, :1, USBBUSY:1, :3, UACTPND:1;
+    };
+    uint8_t Val;
+} USB_SIM_PWRC_REGISTER;
+
+typedef USB_SIM_STAT_REGISTER   U1STATBITS;
+
+// USB OTG module register file.
+typedef struct
+{
+    USB_SIM_OTG_REGISTER        otgir;
+    USB_SIM_OTG_REGISTER        otgie;
+    USB_SIM_OTG_REGISTER        otgstat;
+    uint8_t                     otgcon;
+    USB_SIM_PWRC_REGISTER       pwrc;
+    USB_SIM_INTERRUPT_REGISTER  ir;
+    USB_SIM_INTERRUPT_REGISTER  ie;
+    USB_SIM_ERROR_REGISTER      eir;
+    uint8_t                     eie;
+    USB_SIM_STAT_REGISTER       stat;
+    USB_SIM_CON_REGISTER        con;
+    uint8_t                     addr;
+    uint8_t                     bdtp1;
+    uint8_t                     tok;
+    uint8_t                     sof;
+    uint8_t                     cnfg1;
+    uint8_t                     cnfg2;
+    USB_SIM_EP_REGISTER         ep[16];
+    BDT_ENTRY                   *pBDT;      // Set by USBSimSetBDTAddress() in place of U1BDTPx.
+} USB_SIM_REGISTERS;
+
+extern USB_SIM_REGISTERS usbSimRegisters;
+
+#define U1OTGIR         usbSimRegisters.otgir.Val
+#define U1OTGIRbits     usbSimRegisters.otgir
+#define U1OTGIE         usbSimRegisters.otgie.Val
+#define U1OTGIEbits     usbSimRegisters.otgie
+#define U1OTGSTAT       usbSimRegisters.otgstat.Val
+#define U1OTGSTATbits   usbSimRegisters.otgstat
+#define U1OTGCON        usbSimRegisters.otgcon
+#define U1PWRC          usbSimRegisters.pwrc.Val
+#define U1PWRCbits      usbSimRegisters.pwrc
+#define U1IR            usbSimRegisters.ir.Val
+#define U1IRbits        usbSimRegisters.ir
+#define U1IE            usbSimRegisters.ie.Val
+#define U1IEbits        usbSimRegisters.ie
+#define U1EIR           usbSimRegisters.eir.Val
+#define U1EIRbits       usbSimRegisters.eir
+#define U1EIE           usbSimRegisters.eie
+#define U1STAT          usbSimRegisters.stat.Val
+#define U1STATbits      usbSimRegisters.stat
+#define U1CON           usbSimRegisters.con.Val
+#define U1CONbits       usbSimRegisters.con
+#define U1ADDR          usbSimRegisters.addr
+#define U1BDTP1         usbSimRegisters.bdtp1
+#define U1TOK           usbSimRegisters.tok
+#define U1SOF           usbSimRegisters.sof
+#define U1CNFG1         usbSimRegisters.cnfg1
+#define U1CNFG2         usbSimRegisters.cnfg2
+#define U1EP0           usbSimRegisters.ep[0].Val
+#define U1EP0bits       usbSimRegisters.ep[0]
+#define U1EP1           usbSimRegisters.ep[1].Val
+#define U1EP2           usbSimRegisters.ep[2].Val
+#define U1EP3           usbSimRegisters.ep[3].Val
+#define U1EP4           usbSimRegisters.ep[4].Val
+#define U1EP5           usbSimRegisters.ep[5].Val
+#define U1EP6           usbSimRegisters.ep[6].Val
+#define U1EP7           usbSimRegisters.ep[7].Val
+#define U1EP8           usbSimRegisters.ep[8].Val
+#define U1EP9           usbSimRegisters.ep[9].Val
+#define U1EP10          usbSimRegisters.ep[10].Val
+#define U1EP11          usbSimRegisters.ep[11].Val
+#define U1EP12          usbSimRegisters.ep[12].Val
+#define U1EP13          usbSimRegisters.ep[13].Val
+#define U1EP14          usbSimRegisters.ep[14].Val
+#define U1EP15          usbSimRegisters.ep[15].Val
+
+// *****************************************************************************
+/* Simulated Device SETUP Packet
+
+This is the decoded SETUP packet passed to USB_SIM_DEVICE Request().
+*/
+typedef struct
+{
+    uint8_t     bmRequestType;
+    uint8_t     bRequest;
+    uint16_t    wValue;
+    uint16_t    wIndex;
+    uint16_t    wLength;
+} USB_SIM_SETUP_PACKET;
+
+// *****************************************************************************
+/* Simulated Device
+
+This structure describes a device model on the simulated bus.  The
+simulated controller answers the standard requests (GET_DESCRIPTOR,
+SET_ADDRESS, SET_CONFIGURATION, SET_INTERFACE, GET_STATUS, CLEAR_FEATURE)
+from the descriptors and keeps the data toggles, so a model only implements
+its class behaviour.  Any of the functions may be NULL.
+
+Request() is called for class and vendor requests, and for standard
+requests that the controller does not answer itself, such as GET_DESCRIPTOR
+for a HID report descriptor.  For a device to host
+request it fills data with up to wLength bytes and returns the length; for a
+host to device request data holds the wLength bytes of the data stage and it
+returns USB_SIM_ACK.  Either may return USB_SIM_STALL.
+
+In() is called for an IN token on endpoint 1-15.  It fills data with up to
+maxSize bytes and returns the length, or returns USB_SIM_NAK or
+USB_SIM_STALL.  Out() is called with the data of an OUT token and returns
+USB_SIM_ACK, USB_SIM_NAK or USB_SIM_STALL.
+
+Frame() is called at every start of frame while the device is attached.
+*/
+typedef struct _USB_SIM_DEVICE
+{
+    const char          *name;                      // Name for trace output.
+    bool                lowSpeed;                   // Device is low speed.
+    const uint8_t       *pDeviceDescriptor;         // Device descriptor.
+    const uint8_t       *pConfigurationDescriptor;  // Configuration 1, wTotalLength bytes.
+    const uint8_t * const *pStringDescriptors;      // String descriptors, index 0 is the language ID.
+    uint8_t             numStringDescriptors;       // Number of entries in pStringDescriptors.
+
+    void    (*Reset)( void *context );
+    int16_t (*Request)( void *context, const USB_SIM_SETUP_PACKET *setup, uint8_t *data );
+    int16_t (*In)( void *context, uint8_t endpoint, uint8_t *data, uint16_t maxSize );
+    int16_t (*Out)( void *context, uint8_t endpoint, const uint8_t *data, uint16_t size );
+    void    (*Frame)( void *context, uint32_t frameNumber );
+    void                *context;                   // Passed to the functions above.
+} USB_SIM_DEVICE;
+
+// *****************************************************************************
+/* Simulated Bus Statistics
+
+These counters are returned by USBSimGetStatistics().
+*/
+typedef struct
+{
+    uint32_t    frames;         // Frames elapsed.
+    uint32_t    tokens;         // Tokens sent by the host.
+    uint32_t    naks;           // Transactions answered with NAK.
+    uint32_t    stalls;         // Transactions answered with STALL.
+    uint32_t    timeouts;       // Tokens that no device answered.
+    uint32_t    bytesIn;        // Data bytes sent by the device.
+    uint32_t    bytesOut;       // Data bytes sent by the host, including SETUP packets.
+    uint64_t    busTime;        // Time the bus was busy, in ns.
+} USB_SIM_STATISTICS;
+
+/*****************************************************************************/
+/****** Function prototypes and macro functions ******************************/
+/*****************************************************************************/
+
+#define ConvertToPhysicalAddress(a) ((uint8_t *)(a))
+#define ConvertToVirtualAddress(a)  ((void *)(a))
+
+#define USBMaskInterrupts()
+#define USBUnmaskInterrupts()
+#define USBEnableInterrupts()
+#define USBDisableInterrupts()
+
+/****************************************************************************
+  Function:
+    void USBSimInitialize( void )
+
+  Description:
+    This function resets the simulated controller, the bus statistics and the
+    virtual clock, and detaches all devices, including those behind a hub.
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+void USBSimInitialize( void );
+
+/****************************************************************************
+  Function:
+    void USBSimAttach( USB_SIM_DEVICE *pDevice )
+
+  Description:
+    This function connects a device model to the root port.  The host sees
+    the attach the next time it enables the attach interrupt.
+
+  Precondition:
+    USBSimInitialize() has been called.
+
+  Parameters:
+    USB_SIM_DEVICE *pDevice - Device model to attach
+
+  Returns:
+    None
+
+  Remarks:
+    Any device already attached is detached first.
+  ***************************************************************************/
+
+void USBSimAttach( USB_SIM_DEVICE *pDevice );
+
+/****************************************************************************
+  Function:
+    void USBSimDetach( void )
+
+  Description:
+    This function disconnects the device model from the root port.
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    If the device is a hub, the devices behind it are disconnected too.
+  ***************************************************************************/
+
+void USBSimDetach( void );
+
+/****************************************************************************
+  Function:
+    void USBSimHubPortAttach( uint8_t port, USB_SIM_DEVICE *pDevice )
+
+  Description:
+    This function connects a device model behind the hub on the root port.
+    The device is in the default state, at address 0, and answers tokens
+    right away.
+
+  Precondition:
+    USBSimInitialize() has been called.
+
+  Parameters:
+    uint8_t port            - Hub port, 1 to USB_SIM_HUB_PORTS
+    USB_SIM_DEVICE *pDevice - Device model to attach
+
+  Returns:
+    None
+
+  Remarks:
+    The hub model calls this when the host has reset and enabled the port,
+    so the host never sees two devices at address 0.  Any device already on
+    the port is disconnected first.
+  ***************************************************************************/
+
+void USBSimHubPortAttach( uint8_t port, USB_SIM_DEVICE *pDevice );
+
+/****************************************************************************
+  Function:
+    void USBSimHubPortDetach( uint8_t port )
+
+  Description:
+    This function disconnects the device model behind the given hub port.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t port    - Hub port, 1 to USB_SIM_HUB_PORTS
+
+  Returns:
+    None
+
+  Remarks:
+    The host only learns of the detach through the hub.
+  ***************************************************************************/
+
+void USBSimHubPortDetach( uint8_t port );
+
+/****************************************************************************
+  Function:
+    bool USBSimStep( void )
+
+  Description:
+    This function runs the next event on the simulated bus.  If the host has
+    written a token, the transaction is run with the addressed device, the
+    virtual clock advances by its length on the wire, and the transfer done
+    (or error) interrupt is serviced.  Otherwise, or if the transaction
+    would not fit in the current frame, the clock advances to the next frame
+    and the start of frame and 1ms timer interrupts are serviced.
+
+  Precondition:
+    USBSimInitialize() has been called.
+
+  Parameters:
+    None - None
+
+  Return Values:
+    true    - A transaction was run.
+    false   - The clock advanced to the next frame.
+
+  Remarks:
+    The application calls this between calls to USBHostTasks(), in place of
+    the hardware running in parallel with the CPU.  USB_HostInterruptHandler()
+    is called from here.
+  ***************************************************************************/
+
+bool USBSimStep( void );
+
+/****************************************************************************
+  Function:
+    uint64_t USBSimGetTime( void )
+
+  Description:
+    This function returns the virtual clock, in ns since USBSimInitialize().
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Returns:
+    Virtual time, in ns
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint64_t USBSimGetTime( void );
+
+/****************************************************************************
+  Function:
+    void USBSimGetStatistics( USB_SIM_STATISTICS *pStatistics )
+
+  Description:
+    This function returns the bus statistics since USBSimInitialize().
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_SIM_STATISTICS *pStatistics - Returned statistics
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+void USBSimGetStatistics( USB_SIM_STATISTICS *pStatistics );
+
+/****************************************************************************
+  Function:
+    void USBSimSetBDTAddress( BDT_ENTRY *pBDT )
+
+  Description:
+    This function sets the Buffer Descriptor Table used by the simulated
+    controller.  It takes the place of the U1BDTPx registers, which cannot
+    hold a PC address.
+
+  Precondition:
+    None
+
+  Parameters:
+    BDT_ENTRY *pBDT - Buffer Descriptor Table
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+void USBSimSetBDTAddress( BDT_ENTRY *pBDT );
+
+#define USBSetBDTAddress(addr)          USBSimSetBDTAddress(addr)
+
+#endif  // USB_HAL_SIM_H
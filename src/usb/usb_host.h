@@ -160,13 +160,15 @@ store data to RAM in a linear fashion only.  Therefore, we cannot use a simple
 circular buffer for the data.  Instead, the application or client driver must
 allocate multiple independent data buffers.  These buffers must be the
 maximum transfer size.  This structure contains a pointer to an allocated
-buffer, plus the valid data length of the buffer.
+buffer, plus the valid data length of the buffer and the frame in which it
+was transferred.
 */
 
 typedef struct _ISOCHRONOUS_DATA_BUFFER
 {
     uint8_t                *pBuffer;               // Data buffer pointer.
     uint16_t                dataLength;             // Amount of valid data in the buffer.
+    uint16_t                frameNumber;            // Frame in which the buffer was received or sent.
     uint8_t                bfDataLengthValid : 1;  // dataLength value is valid.
 } ISOCHRONOUS_DATA_BUFFER;
 
@@ -183,6 +185,17 @@ of type ISOCHRONOUS_DATA for each concurrent transfer.  When the device
 attaches, the client driver must inform the application layer of the maximum
 transfer size.  At this point, the application must allocate space for the 
 data buffers, and set the data buffer points in this structure to point to them.
+
+The buffers form a ring of totalBuffers entries, up to
+USB_MAX_ISOCHRONOUS_DATA_BUFFERS.  For a read, a buffer holds data from the
+time it is received until the application releases it, unless the data event
+handler processed it as it was received; if the next buffer
+is still held when its interval comes, the interval is skipped and counted
+in overruns.  For a write, an interval with no buffer ready is skipped and
+counted in underruns.  The number of buffers held is the fill level.  If
+watermark is not 0 and pWatermarkHandler is not NULL, the handler is called
+from the USB interrupt when a received buffer raises the fill level to
+watermark, or a sent buffer lowers it to watermark.
 */
 
 #if !defined( USB_MAX_ISOCHRONOUS_DATA_BUFFERS )
@@ -192,6 +205,9 @@ data buffers, and set the data buffer points in this structure to point to them.
     #error At least two buffers must be defined for isochronous data.
 #endif
 
+struct _ISOCHRONOUS_DATA;
+typedef void (*USB_ISOCHRONOUS_WATERMARK_HANDLER)( struct _ISOCHRONOUS_DATA *isocData, uint8_t fillLevel );
+
 typedef struct _ISOCHRONOUS_DATA
 {
     uint8_t    totalBuffers;       // Total number of buffers available.
@@ -200,7 +216,48 @@ typedef struct _ISOCHRONOUS_DATA
     uint8_t    *pDataUser;         // User pointer for accessing data.
     
     ISOCHRONOUS_DATA_BUFFER buffers[USB_MAX_ISOCHRONOUS_DATA_BUFFERS];  // Data buffer information.
+
+    uint8_t    watermark;          // Fill level that calls pWatermarkHandler, 0 for none.
+    uint8_t    highWater;          // Highest fill level seen.
+    uint16_t   overruns;           // Read intervals skipped because the next buffer was held.
+    uint16_t   underruns;          // Write intervals skipped because no buffer was ready.
+    USB_ISOCHRONOUS_WATERMARK_HANDLER pWatermarkHandler;   // Called when the fill level reaches watermark.
 } ISOCHRONOUS_DATA;
+
+
+// *****************************************************************************
+/* Enumeration Memory Statistics
+
+This structure reports the use of the fixed-size arena that holds the
+descriptors and the interface and endpoint lists of the attached device.  It is
+filled in by USBHostGetEnumerationMemoryStats().  Use highWater to size
+USB_ENUMERATION_ARENA_SIZE for the devices in the TPL.  The 1024 byte default
+can be too small for a device with several configurations or an audio device
+with many alternate settings, which the heap used to accept.
+*/
+typedef struct _USB_ENUMERATION_MEMORY_STATS
+{
+    uint16_t    size;                   // Size of the arena, in bytes (USB_ENUMERATION_ARENA_SIZE).
+    uint16_t    used;                   // Bytes in use for the current device.
+    uint16_t    highWater;              // Most bytes ever in use since USBHostInit() was first called.
+    uint16_t    failedAllocations;      // Number of allocations that did not fit.
+} USB_ENUMERATION_MEMORY_STATS;
+
+
+// *****************************************************************************
+/* Event Queue Statistics
+
+This structure reports how full the queue that carries transfer events from the
+USB interrupt to USBHostTasks() has been.  It is filled in by
+USBHostGetEventQueueStats().  If overflows is not zero, events were lost;
+increase USB_EVENT_QUEUE_DEPTH or call USBHostTasks() more often.
+*/
+typedef struct _USB_EVENT_QUEUE_STATS
+{
+    uint8_t     depth;                  // Number of entries (USB_EVENT_QUEUE_DEPTH).
+    uint8_t     highWater;              // Most entries ever waiting at once.
+    uint16_t    overflows;              // Events dropped because the queue was full.
+} USB_EVENT_QUEUE_STATS;
     
 
 // *****************************************************************************
@@ -435,15 +492,17 @@ typedef bool (*USB_CLIENT_INIT)   ( uint8_t address, uint32_t flags, uint8_t cli
     false   - Event was not processed successfully
 
   Remarks:
-    If this function is not provided by the application, then all application
-    events are assumed to function without error.
+    If this function is not provided by the application, then no data
+    events are processed.  For EVENT_DATA_ISOC_READ this means the received
+    data stays in the isochronous data buffers until the application takes
+    it with USBHostIsochronousBufferGet().
   ***************************************************************************/
 #if defined( USB_HOST_APP_DATA_EVENT_HANDLER )
     bool USB_HOST_APP_DATA_EVENT_HANDLER ( uint8_t address, USB_EVENT event, void *data, uint32_t size );
 #else
-    // If the application does not provide an event handler, then we will
-    // assume that all events function without error.
-    #define USB_HOST_APP_DATA_EVENT_HANDLER(a,e,d,s) true
+    // If the application does not provide a data event handler, then the
+    // data is left to be processed from the main loop.
+    #define USB_HOST_APP_DATA_EVENT_HANDLER(a,e,d,s) false
 #endif
 
 
@@ -476,8 +535,6 @@ typedef struct _CLIENT_DRIVER_TABLE
 // *****************************************************************************
 // *****************************************************************************
 
-extern uint8_t                *pCurrentConfigurationDescriptor;    // Pointer to the current Configuration Descriptor of the attached device.
-extern uint8_t                *pDeviceDescriptor;                  // Pointer to the Device Descriptor of the attached device.
 extern USB_TPL              usbTPL[];                           // Application's Targeted Peripheral List.
 extern CLIENT_DRIVER_TABLE  usbClientDrvTable[];                // Application's client driver table.
 
@@ -590,7 +647,7 @@ bool    USBHostDeviceSpecificClientDriver( uint8_t deviceAddress );
     USB_DEVICE_ATTACHED                 - Device is attached and running
     USB_DEVICE_DETACHED                 - No device is attached
     USB_DEVICE_ENUMERATING              - Device is enumerating
-    USB_HOLDING_OUT_OF_MEMORY           - Not enough heap space available
+    USB_HOLDING_OUT_OF_MEMORY           - Not enough enumeration memory available
     USB_HOLDING_UNSUPPORTED_DEVICE      - Invalid configuration or
                                             unsupported class
     USB_HOLDING_UNSUPPORTED_HUB         - Hubs are not supported
@@ -625,14 +682,15 @@ uint8_t    USBHostDeviceStatus( uint8_t deviceAddress );
     uint8_t deviceAddress  - Address of device
 
   Returns:
-    uint8_t *  - Pointer to the Configuration Descriptor.
+    uint8_t *  - Pointer to the Configuration Descriptor, or NULL if the
+                device is not attached.
 
   Remarks:
-    This will need to be expanded to a full function when multiple device
-    support is added.
+    During enumeration, this is the configuration being set up, so client
+    drivers can read it from their initialization routines.
   ***************************************************************************/
 
-#define USBHostGetCurrentConfigurationDescriptor( deviceAddress) ( pCurrentConfigurationDescriptor )
+uint8_t * USBHostGetCurrentConfigurationDescriptor( uint8_t deviceAddress );
 
 
 /****************************************************************************
@@ -650,14 +708,204 @@ uint8_t    USBHostDeviceStatus( uint8_t deviceAddress );
     uint8_t deviceAddress  - Address of device
 
   Returns:
-    uint8_t *  - Pointer to the Device Descriptor.
+    uint8_t *  - Pointer to the Device Descriptor, or NULL if the device is
+                not attached.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint8_t * USBHostGetDeviceDescriptor( uint8_t deviceAddress );
+
+
+/****************************************************************************
+  Function:
+    void USBHostGetEnumerationMemoryStats( USB_ENUMERATION_MEMORY_STATS *stats )
+
+  Description:
+    This function returns the current and high-water use of the memory
+    that holds the descriptors and configuration lists of the device on the
+    root port.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_ENUMERATION_MEMORY_STATS *stats - Filled in with the statistics
+
+  Returns:
+    None
+
+  Remarks:
+    If a device is holding with USB_HOLDING_OUT_OF_MEMORY,
+    failedAllocations will be non-zero; increase
+    USB_ENUMERATION_ARENA_SIZE.  Each device behind the hub has an arena
+    of the same size.
+  ***************************************************************************/
+
+void    USBHostGetEnumerationMemoryStats( USB_ENUMERATION_MEMORY_STATS *stats );
+
+
+/****************************************************************************
+  Function:
+    void USBHostGetEventQueueStats( USB_EVENT_QUEUE_STATS *stats )
+
+  Description:
+    This function returns the high-water mark and overflow count of the
+    transfer event queue.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_EVENT_QUEUE_STATS *stats - Filled in with the statistics
+
+  Returns:
+    None
+
+  Remarks:
+    Only available if USB_ENABLE_TRANSFER_EVENT is defined.
+  ***************************************************************************/
+
+#if defined( USB_ENABLE_TRANSFER_EVENT )
+    void    USBHostGetEventQueueStats( USB_EVENT_QUEUE_STATS *stats );
+#endif
+
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostGetFrameNumber( void )
+
+  Description:
+    This function returns the number of frames that have started since the
+    host was initialized, modulo 65536.
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Returns:
+    The frame counter
 
   Remarks:
-    This will need to be expanded to a full function when multiple device
-    support is added.
+    The counter advances once per millisecond while the bus is running.
+    Class drivers use differences of it to measure transfer latency.
   ***************************************************************************/
 
-#define USBHostGetDeviceDescriptor( deviceAddress )     ( pDeviceDescriptor )
+uint16_t USBHostGetFrameNumber( void );
+
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostHubPortAttach( uint8_t hubAddress, uint8_t port,
+                bool lowSpeed )
+
+  Summary:
+    This function starts the enumeration of a device behind the hub.
+
+  Description:
+    This function is called by the hub client driver once a hub port has
+    been reset and the device on it is waiting at address 0.  The device
+    gets an entry in the device table and is enumerated by USBHostTasks()
+    like the device on the root port: it is given the next free address,
+    configured, and handed to its client drivers, which are sent the
+    device's own address.
+
+  Precondition:
+    USBHostHubPortBusy() is false.  The port was reset after that was
+    checked.
+
+  Parameters:
+    uint8_t hubAddress - Address of the hub
+    uint8_t port       - Port number on the hub, starting at 1
+    bool lowSpeed      - The device on the port is low speed
+
+  Return Values:
+    USB_SUCCESS         - Enumeration has started
+    USB_UNKNOWN_DEVICE  - The hub is not attached
+    USB_BUSY            - Another device is at address 0, or the device
+                            table is full; try again later
+
+  Remarks:
+    Only available if USB_HUB_SUPPORT_INCLUDED is defined.  The device is
+    not reset again if enumeration fails; it is held with
+    USB_CANNOT_ENUMERATE until USBHostHubPortDetach() is called.
+  ***************************************************************************/
+
+
+#if defined( USB_HUB_SUPPORT_INCLUDED )
+    uint8_t    USBHostHubPortAttach( uint8_t hubAddress, uint8_t port, bool lowSpeed );
+#endif
+
+
+/****************************************************************************
+  Function:
+    bool USBHostHubPortBusy( void )
+
+  Summary:
+    This function tells whether a device behind the hub is at address 0.
+
+  Description:
+    This function tells whether a device behind the hub is still at address
+    0.  A hub port must not be reset while this is true, since two devices
+    would then answer at address 0.
+
+  Precondition:
+    None
+
+  Parameters:
+    None - None
+
+  Return Values:
+    true    - A device behind the hub has not been given an address yet
+    false   - Another hub port can be reset
+
+  Remarks:
+    Only available if USB_HUB_SUPPORT_INCLUDED is defined.  A device that
+    fails enumeration before it has an address keeps this true until its
+    port is detached.
+  ***************************************************************************/
+
+
+#if defined( USB_HUB_SUPPORT_INCLUDED )
+    bool    USBHostHubPortBusy( void );
+#endif
+
+
+/****************************************************************************
+  Function:
+    void USBHostHubPortDetach( uint8_t hubAddress, uint8_t port )
+
+  Summary:
+    This function removes the device behind a hub port.
+
+  Description:
+    This function is called by the hub client driver when the device on a
+    hub port is removed, or the port is disabled.  The client drivers of
+    the device are sent EVENT_DETACH and its entry in the device table is
+    released.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t hubAddress - Address of the hub
+    uint8_t port       - Port number on the hub, starting at 1
+
+  Returns:
+    None
+
+  Remarks:
+    Only available if USB_HUB_SUPPORT_INCLUDED is defined.  Nothing is done
+    if no device was attached through the port.
+  ***************************************************************************/
+
+
+#if defined( USB_HUB_SUPPORT_INCLUDED )
+    void    USBHostHubPortDetach( uint8_t hubAddress, uint8_t port );
+#endif
 
 
 /****************************************************************************
@@ -858,6 +1106,93 @@ void USBHostIsochronousBuffersReset( ISOCHRONOUS_DATA * isocData, uint8_t number
 #endif
 
 
+/****************************************************************************
+  Function:
+    uint8_t USBHostIsochronousBuffersFilled( ISOCHRONOUS_DATA * isocData )
+    
+  Description:
+    This function returns the fill level of the isochronous data buffers: the
+    number of buffers that hold received data not yet released (read), or
+    data not yet sent (write).
+
+  Precondition:
+    None
+
+  Parameters:
+    ISOCHRONOUS_DATA * isocData - The isochronous data buffers
+
+  Returns:
+    The number of buffers held
+
+  Remarks:
+    This function is available only if USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+    is defined in usb_config.h.
+***************************************************************************/
+
+#ifdef USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+uint8_t USBHostIsochronousBuffersFilled( ISOCHRONOUS_DATA * isocData );
+#endif
+
+
+/****************************************************************************
+  Function:
+    ISOCHRONOUS_DATA_BUFFER * USBHostIsochronousBufferGet( ISOCHRONOUS_DATA * isocData )
+    
+  Description:
+    This function returns the oldest received buffer of an isochronous read,
+    in the order the buffers were received.  The buffer stays held until it
+    is released with USBHostIsochronousBufferRelease().
+
+  Precondition:
+    None
+
+  Parameters:
+    ISOCHRONOUS_DATA * isocData - The isochronous data buffers
+
+  Returns:
+    The buffer at currentBufferUser, or NULL if no data has been received
+    into it yet.
+
+  Remarks:
+    This function is available only if USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+    is defined in usb_config.h.  A buffer that the client driver's data
+    event handler processed as it was received (returned true for
+    EVENT_DATA_ISOC_READ) is released at once and is not returned here.
+***************************************************************************/
+
+#ifdef USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+ISOCHRONOUS_DATA_BUFFER * USBHostIsochronousBufferGet( ISOCHRONOUS_DATA * isocData );
+#endif
+
+
+/****************************************************************************
+  Function:
+    void USBHostIsochronousBufferRelease( ISOCHRONOUS_DATA * isocData )
+    
+  Description:
+    This function releases the buffer returned by
+    USBHostIsochronousBufferGet(), so that it can receive data again, and
+    moves currentBufferUser to the next buffer.
+
+  Precondition:
+    USBHostIsochronousBufferGet() returned a buffer.
+
+  Parameters:
+    ISOCHRONOUS_DATA * isocData - The isochronous data buffers
+
+  Returns:
+    None
+
+  Remarks:
+    This function is available only if USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+    is defined in usb_config.h.
+***************************************************************************/
+
+#ifdef USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+void USBHostIsochronousBufferRelease( ISOCHRONOUS_DATA * isocData );
+#endif
+
+
 /****************************************************************************
   Function:
     uint8_t USBHostIssueDeviceRequest( uint8_t deviceAddress, uint8_t bmRequestType,
@@ -1050,6 +1385,9 @@ uint8_t    USBHostRead( uint8_t deviceAddress, uint8_t endpoint, uint8_t *data,
     rather than a reset state.  The ATTACH interrupt will automatically be
     triggered when the module is re-enabled, and the proper reset will be
     performed.
+
+    Devices behind the hub cannot be reset this way; USB_ILLEGAL_REQUEST
+    is returned.
   ***************************************************************************/
 
 uint8_t    USBHostResetDevice( uint8_t deviceAddress );
@@ -1078,7 +1416,7 @@ uint8_t    USBHostResetDevice( uint8_t deviceAddress );
     USB_ILLEGAL_REQUEST - Device cannot RESUME unless it is suspended
 
   Remarks:
-    None
+    Devices behind the hub return USB_ILLEGAL_REQUEST.
   ***************************************************************************/
 
 uint8_t    USBHostResumeDevice( uint8_t deviceAddress );
@@ -1234,7 +1572,7 @@ void    USBHostShutdown( void );
     USB_ILLEGAL_REQUEST - Cannot suspend unless device is in normal run mode
 
   Remarks:
-    None
+    Devices behind the hub return USB_ILLEGAL_REQUEST.
   ****************************************************************************/
 
 uint8_t    USBHostSuspendDevice( uint8_t deviceAddress );
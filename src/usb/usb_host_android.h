@@ -58,6 +58,20 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
     #define NUM_ANDROID_DEVICES_SUPPORTED 1
 #endif
 
+#ifndef ANDROID_HID_EVENT_QUEUE_SIZE
+    /* Defines the number of HID reports that can wait to be sent to each Android device.
+       AndroidAppHIDSendEvent() and AndroidAppHIDSendState() copy the report into this
+       queue, and the driver sends the queued reports back to back.  If this is not
+       defined by the user, a default of 8 is used. */
+    #define ANDROID_HID_EVENT_QUEUE_SIZE 8
+#endif
+
+#ifndef ANDROID_HID_MAX_REPORT_SIZE
+    /* Defines the longest HID report that can be queued, in bytes.  If this is not
+       defined by the user, a default of 16 is used. */
+    #define ANDROID_HID_MAX_REPORT_SIZE 16
+#endif
+
 #define ANDROID_EVENT_BASE EVENT_USER_BASE + ANDROID_BASE_OFFSET
 
 
@@ -79,7 +93,9 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
    now available for use by the application */
 #define EVENT_ANDROID_HID_REGISTRATION_COMPLETE ANDROID_EVENT_BASE + 2
 
-/* The requested report has been sent to the requested device.  */
+/* A queued HID report has been sent to the device.  The data portion of the event is
+   the handle of the device.  A report replaced by a newer one with
+   AndroidAppHIDSendState() does not get this event. */
 #define EVENT_ANDROID_HID_SEND_EVENT_COMPLETE   ANDROID_EVENT_BASE + 3
 
 /* Defines the available audio modes */
@@ -438,7 +454,11 @@ bool AndroidAppDataEventHandler( uint8_t address, USB_EVENT event, void *data, u
     Sends a HID report to the associated Android device
 
   Description:
-    Sends a HID report to the associated Android device
+    Sends a HID report to the associated Android device.  The report is copied
+    into the HID queue of the device and sent after the reports already there,
+    so the buffer can be reused as soon as this function returns.  Every report
+    queued with this function is sent, so use it for reports that must not be
+    lost, such as key presses and releases, and for relative reports.
 
   Precondition:
     HID device should have already been registers with the AndroidAppHIDRegister() function
@@ -450,14 +470,60 @@ bool AndroidAppDataEventHandler( uint8_t address, USB_EVENT event, void *data, u
     uint8_t length - length of the report
 
   Return Values:
-    None
+    USB_SUCCESS - the report was queued
+    USB_UNKNOWN_DEVICE - no Android device with that address
+    USB_INVALID_STATE - the device is not ready yet
+    USB_ILLEGAL_REQUEST - the report is longer than ANDROID_HID_MAX_REPORT_SIZE
+    USB_ENDPOINT_BUSY - the HID queue is full (see ANDROID_HID_EVENT_QUEUE_SIZE)
 
   Remarks:
-    None
+    EVENT_ANDROID_HID_SEND_EVENT_COMPLETE is thrown as each report is sent.
   ***************************************************************************/
 uint8_t AndroidAppHIDSendEvent(uint8_t address, uint8_t id, uint8_t* report, uint8_t length);
 
 
+/****************************************************************************
+  Function:
+    uint8_t AndroidAppHIDSendState(uint8_t address, uint8_t id, uint8_t* report, uint8_t length);
+
+  Summary:
+    Sends an absolute HID report to the associated Android device
+
+  Description:
+    Sends a HID report that holds the whole state of the HID device, such as the
+    position of an absolute pointer or touch screen.  If the last report in the
+    queue was queued by this function with the same id and is still waiting to
+    be sent, it is replaced by this one, since only the latest state matters.
+    Otherwise the report is queued as with AndroidAppHIDSendEvent().  A burst of
+    moves therefore takes only one entry in the queue, the device always ends up
+    with the latest state, and the reports keep the order they were queued in.
+
+  Precondition:
+    HID device should have already been registers with the AndroidAppHIDRegister() function
+
+  Parameters:
+    uint8_t address - address of the USB peripheral to send the report to
+    uint8_t id - Report ID of the report being sent
+    uint8_t* report - data for the report
+    uint8_t length - length of the report
+
+  Return Values:
+    USB_SUCCESS - the report was queued, or replaced a waiting one
+    USB_UNKNOWN_DEVICE - no Android device with that address
+    USB_INVALID_STATE - the device is not ready yet
+    USB_ILLEGAL_REQUEST - the report is longer than ANDROID_HID_MAX_REPORT_SIZE
+    USB_ENDPOINT_BUSY - the HID queue is full (see ANDROID_HID_EVENT_QUEUE_SIZE)
+
+  Remarks:
+    Only use this function for reports in which nothing but the axes changed.
+    A report that presses or releases a button or key must be sent with
+    AndroidAppHIDSendEvent(), or the replacement can lose the transition; later
+    moves can be sent with this function again.  For the same reason, do not use
+    it for keyboards.
+  ***************************************************************************/
+uint8_t AndroidAppHIDSendState(uint8_t address, uint8_t id, uint8_t* report, uint8_t length);
+
+
 /****************************************************************************
   Function:
     bool AndroidAppHIDRegister(uint8_t address, uint8_t id, uint8_t* descriptor, uint8_t length);
@@ -135,6 +135,23 @@ typedef struct _USB_AUDIO_V1_DEVICE_ID
 } USB_AUDIO_V1_DEVICE_ID;
 
 
+// *****************************************************************************
+/* Audio Rate Information
+
+This structure is returned by USBHostAudioV1GetRateInfo() if
+USB_AUDIO_RATE_MATCHING is defined.  The measured rate is that of the
+device's clock as seen by the host's frame clock; the difference from the
+nominal rate is the drift between the two clocks.
+*/
+typedef struct _USB_AUDIO_V1_RATE_INFO
+{
+    uint32_t                            nominalRate;            // Sampling frequency, Hz.
+    uint32_t                            measuredRate;           // Measured device rate, 1/256 Hz.
+    uint32_t                            step;                   // Received samples per output sample, 8.24 fixed point.
+    uint16_t                            measurements;           // Rate measurements completed, one per second.
+} USB_AUDIO_V1_RATE_INFO;
+
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Function Prototypes and Macro Functions
@@ -175,6 +192,15 @@ typedef struct _USB_AUDIO_V1_DEVICE_ID
     Some devices require other operations between setting the full bandwidth
     interface and starting the streaming audio data.  Therefore, these two 
     functions are broken out separately.
+
+    Received packets are passed to the application's data event handler as
+    EVENT_AUDIO_STREAM_RECEIVED.  If it does not handle them (returns false,
+    or USB_HOST_APP_DATA_EVENT_HANDLER is not defined), they stay in the
+    buffers of pIsochronousData until the application takes them with
+    USBHostIsochronousBufferGet() and USBHostIsochronousBufferRelease().
+    Use enough buffers to cover the longest time the application may not
+    get to them; packets that arrive while all buffers are held are counted
+    in pIsochronousData->overruns.
   ***************************************************************************/
 
 uint8_t USBHostAudioV1ReceiveAudioData( uint8_t deviceAddress,
@@ -463,6 +489,84 @@ uint8_t * USBHostAudioV1SupportedFrequencies( uint8_t deviceAddress );
 void    USBHostAudioV1TerminateTransfer( uint8_t deviceAddress );
 
 
+/****************************************************************************
+  Function:
+    uint16_t USBHostAudioV1ReadSamples( uint8_t deviceAddress, int16_t *samples,
+        uint16_t count )
+
+  Summary:
+    This function reads received audio at the nominal sampling frequency.
+
+  Description:
+    This function takes received audio out of the isochronous data buffers
+    of the current stream and resamples it from the rate the device's clock
+    actually runs at to the nominal sampling frequency.  An application that
+    consumes samples at the nominal rate, by the same crystal as the USB
+    frames, can then stream indefinitely without the buffers filling up or
+    running dry as the two clocks drift apart.
+
+  Precondition:
+    USBHostAudioV1ReceiveAudioData() has started the stream, and the
+    received packets are not taken by the application's data event handler.
+
+  Parameters:
+    uint8_t deviceAddress  - Device address
+    int16_t *samples    - Buffer for count samples of each channel,
+                            interleaved as they are received
+    uint16_t count      - Number of samples per channel to read
+
+  Returns:
+    The number of samples per channel read.  This is less than count if
+    the buffers ran out of received data, or 0 if the format is not 16 bit
+    PCM with up to USB_AUDIO_MAX_CHANNELS channels.
+
+  Remarks:
+    Only available if USB_AUDIO_RATE_MATCHING is defined.  The nominal rate
+    is the frequency last set with USBHostAudioV1SetSamplingFrequency(), or
+    the first one the device supports.  Do not also take buffers with
+    USBHostIsochronousBufferGet() while using this function.
+  ***************************************************************************/
+
+#if defined( USB_AUDIO_RATE_MATCHING )
+uint16_t USBHostAudioV1ReadSamples( uint8_t deviceAddress, int16_t *samples, uint16_t count );
+#endif
+
+
+/****************************************************************************
+  Function:
+    bool USBHostAudioV1GetRateInfo( uint8_t deviceAddress,
+        USB_AUDIO_V1_RATE_INFO *pInfo )
+
+  Summary:
+    This function returns the measured device sample rate.
+
+  Description:
+    This function returns the nominal sampling frequency, the rate the
+    device's clock actually runs at as measured against the host's frame
+    clock, and the resampling step USBHostAudioV1ReadSamples() uses.  The
+    rate is measured once a second, starting from
+    USBHostAudioV1ReceiveAudioData().
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress           - Device address
+    USB_AUDIO_V1_RATE_INFO *pInfo   - Returns the rate information
+
+  Return Values:
+    true    - The rate information was returned
+    false   - No device with the specified address
+
+  Remarks:
+    Only available if USB_AUDIO_RATE_MATCHING is defined.
+  ***************************************************************************/
+
+#if defined( USB_AUDIO_RATE_MATCHING )
+bool USBHostAudioV1GetRateInfo( uint8_t deviceAddress, USB_AUDIO_V1_RATE_INFO *pInfo );
+#endif
+
+
 
 // *****************************************************************************
 // *****************************************************************************
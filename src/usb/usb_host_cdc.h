@@ -155,6 +155,53 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 #define USB_CDC_LINE_CODING_LENGTH          0x07   // Number of uint8_ts Line Coding transfer
 #define USB_CDC_CONTROL_LINE_LENGTH         0x00   // Number of uint8_ts Control line transfer
 #define USB_CDC_MAX_PACKET_SIZE             0x200   // Max transfer size is 64 uint8_ts for Full Speed USB
+
+// *****************************************************************************
+/* Continuous Receive
+
+If USB_CDC_RX_BUFFER_SIZE is defined, the driver keeps a read posted on the
+bulk IN endpoint of the data interface from the time the device is running.
+The reads alternate between two buffers of USB_CDC_RX_PACKET_SIZE bytes, so
+the next read is posted before the data of the last one is moved into a ring
+of USB_CDC_RX_BUFFER_SIZE bytes.  The application takes data from the ring
+with USBHostCDCRxRead(), and USBHostCDC_Api_Get_IN_Data() is not available.
+If the ring is full, reception pauses and the device NAKs until there is
+room again; no data is lost.
+*/
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+    #ifndef USB_CDC_RX_PACKET_SIZE
+        #define USB_CDC_RX_PACKET_SIZE      64      // Size of each of the two receive buffers
+    #endif
+    #if (USB_CDC_RX_BUFFER_SIZE < USB_CDC_RX_PACKET_SIZE)
+        #error "USB_CDC_RX_BUFFER_SIZE must be at least USB_CDC_RX_PACKET_SIZE."
+    #endif
+#endif
+
+// *****************************************************************************
+/* Gathered Send
+
+If USB_CDC_TX_QUEUE_DEPTH is defined, USBHostCDCSendSegments() sends a list
+of application buffers on the bulk OUT endpoint of the data interface as one
+stream, without copying them together first.  Up to USB_CDC_TX_QUEUE_DEPTH
+buffers can be waiting; more can be added while earlier ones are still being
+sent.  Each buffer is sent straight from where it lives, so it may be const
+data, and must not change until the send completes.  Each buffer is posted
+as one multi-packet transfer, which the host layer sends in as few frames
+as the bus allows; the next one is posted as soon as it completes.
+
+A buffer shorter than USB_CDC_TX_PACKET_SIZE, such as a message header, is
+copied into a packet buffer together with the start of what follows it, so
+that it does not take a packet of its own.  USB_CDC_TX_PACKET_SIZE defaults
+to 64, the largest full speed bulk packet.
+*/
+#if defined( USB_CDC_TX_QUEUE_DEPTH )
+    #if (USB_CDC_TX_QUEUE_DEPTH < 1) || (USB_CDC_TX_QUEUE_DEPTH > 255)
+        #error "USB_CDC_TX_QUEUE_DEPTH must be between 1 and 255."
+    #endif
+    #ifndef USB_CDC_TX_PACKET_SIZE
+        #define USB_CDC_TX_PACKET_SIZE      64      // Size of the buffer short segments are packed into
+    #endif
+#endif
 //******************************************************************************
 //******************************************************************************
 // Data Structures
@@ -265,6 +312,50 @@ typedef struct _DATA_INTERFACE_DETAILS
     uint8_t                            endpointOUT;          // IN endpoint for comm interface.
 }   DATA_INTERFACE_DETAILS;
 
+/*
+   This structure reports the activity of the continuous receive of a device.
+   It is filled in by USBHostCDCGetRxStats().
+*/
+typedef struct _USB_CDC_RX_STATS
+{
+    uint32_t                            bytes;                 // Bytes received into the ring.
+    uint16_t                            size;                  // Size of the ring (USB_CDC_RX_BUFFER_SIZE).
+    uint16_t                            highWater;             // Most bytes ever waiting in the ring.
+    uint16_t                            overruns;              // Times reception paused because the ring was full.
+    uint16_t                            errors;                // Reads that ended with an error other than a NAK timeout.
+} USB_CDC_RX_STATS;
+
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+/*
+   This structure holds the receive buffers of a device when continuous
+   receive is enabled.  The two packet buffers are posted in turn; a packet
+   holds data until it has been moved into the ring.
+*/
+typedef struct _USB_CDC_RX_BUFFER
+{
+    uint8_t                             packet[2][USB_CDC_RX_PACKET_SIZE];  // Alternating read buffers.
+    uint16_t                            packetLength[2];       // Bytes in each packet not yet in the ring.
+    uint16_t                            packetOffset[2];       // Offset of those bytes in the packet.
+    uint8_t                             ring[USB_CDC_RX_BUFFER_SIZE];       // Received data for the application.
+    uint16_t                            head;                  // Index of the oldest byte in the ring.
+    uint16_t                            count;                 // Number of bytes in the ring.
+    uint8_t                             post;                  // Packet to post next.
+    uint8_t                             drain;                 // Packet to move into the ring next.
+    bool                                posted;                // A read is posted on the IN endpoint.
+    bool                                paused;                // The ring was full at the last drain.
+    USB_CDC_RX_STATS                    stats;                 // Reception statistics.
+} USB_CDC_RX_BUFFER;
+#endif
+
+/*
+   This structure describes one application buffer of a gathered send.
+*/
+typedef struct _USB_CDC_TX_SEGMENT
+{
+    const uint8_t                       *data;                 // Start of the buffer.
+    uint16_t                            length;                // Number of bytes to send from it.
+} USB_CDC_TX_SEGMENT;
+
 /*
    This structure is used to hold information about an attached CDC device
 */
@@ -282,6 +373,7 @@ typedef struct _USB_CDC_DEVICE_INFO
             uint8_t                        bfReset              : 1;   // Flag indicating to perform CDC Reset.
             uint8_t                        bfClearDataIN        : 1;   // Flag indicating to clear the IN endpoint.
             uint8_t                        bfClearDataOUT       : 1;   // Flag indicating to clear the OUT endpoint.
+            uint8_t                        bfSegment            : 1;   // The current buffer is a queued segment, posted whole.
         };
         uint8_t                            val;
     }                                   flags;
@@ -297,6 +389,16 @@ typedef struct _USB_CDC_DEVICE_INFO
     uint8_t                                clientDriverID;        // Client driver ID for device requests.
     COMM_INTERFACE_DETAILS              commInterface;         // This structure stores communication interface details.
     DATA_INTERFACE_DETAILS              dataInterface;         // This structure stores data interface details.
+    #if defined( USB_CDC_RX_BUFFER_SIZE )
+    USB_CDC_RX_BUFFER                   rx;                    // Continuous receive buffers.
+    #endif
+    #if defined( USB_CDC_TX_QUEUE_DEPTH )
+    USB_CDC_TX_SEGMENT                  txQueue[USB_CDC_TX_QUEUE_DEPTH];   // Buffers waiting to be sent.
+    uint8_t                             txHead;                // Index of the next buffer to send.
+    uint8_t                             txCount;               // Number of buffers waiting.
+    uint16_t                            txPacketLength;        // Bytes packed into txPacket and not yet posted.
+    uint8_t                             txPacket[USB_CDC_TX_PACKET_SIZE];  // Short buffers packed together.
+    #endif
 } USB_CDC_DEVICE_INFO;
 
 
@@ -400,6 +502,38 @@ typedef struct _USB_CDC_DEVICE_INFO
 *******************************************************************************/
 uint8_t    USBHostCDCDeviceStatus( uint8_t deviceAddress );
 
+/*******************************************************************************
+  Function:
+    uint8_t USBHostCDCGetRxStats( uint8_t deviceAddress, USB_CDC_RX_STATS *stats )
+
+  Summary:
+    This function returns the continuous receive statistics of a device.
+
+  Description:
+    This function returns the number of bytes received, the high-water mark
+    of the receive ring, and the number of times reception paused because
+    the ring was full.
+
+  Preconditions:
+    None
+
+  Parameters:
+    uint8_t deviceAddress      - Device address
+    USB_CDC_RX_STATS *stats    - Filled in with the statistics
+
+  Return Values:
+    USB_SUCCESS                 - The statistics were returned
+    USB_CDC_DEVICE_NOT_FOUND    - No device with specified address
+
+  Remarks:
+    Only available if USB_CDC_RX_BUFFER_SIZE is defined.  If overruns keeps
+    increasing, the application does not read the data fast enough; call
+    USBHostCDCRxRead() more often or increase USB_CDC_RX_BUFFER_SIZE.
+*******************************************************************************/
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+    uint8_t USBHostCDCGetRxStats( uint8_t deviceAddress, USB_CDC_RX_STATS *stats );
+#endif
+
 /*******************************************************************************
   Function:
     uint8_t USBHostCDCResetDevice( uint8_t deviceAddress )
@@ -427,6 +561,106 @@ uint8_t    USBHostCDCDeviceStatus( uint8_t deviceAddress );
 *******************************************************************************/
 uint8_t    USBHostCDCResetDevice( uint8_t deviceAddress );
 
+/*******************************************************************************
+  Function:
+    uint16_t USBHostCDCRxAvailable( uint8_t deviceAddress )
+
+  Summary:
+    This function returns the number of received bytes waiting to be read.
+
+  Description:
+    This function returns the number of bytes in the receive ring of the
+    device.  That many bytes can be taken with USBHostCDCRxRead() without
+    waiting.
+
+  Preconditions:
+    None
+
+  Parameters:
+    uint8_t deviceAddress      - Device address
+
+  Returns:
+    Number of bytes that can be read.  0 if the device is not found.
+
+  Remarks:
+    Only available if USB_CDC_RX_BUFFER_SIZE is defined.
+*******************************************************************************/
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+    uint16_t USBHostCDCRxAvailable( uint8_t deviceAddress );
+#endif
+
+/*******************************************************************************
+  Function:
+    uint16_t USBHostCDCRxRead( uint8_t deviceAddress, uint8_t *data, uint16_t size )
+
+  Summary:
+    This function takes received data from the receive ring.
+
+  Description:
+    This function copies up to size bytes from the receive ring of the
+    device into the application buffer, and returns at once.  If reception
+    was paused because the ring was full, it resumes.
+
+  Preconditions:
+    None
+
+  Parameters:
+    uint8_t deviceAddress      - Device address
+    uint8_t *data              - Pointer to the application buffer
+    uint16_t size              - Size of the application buffer
+
+  Returns:
+    Number of bytes copied.  0 if no data was waiting or the device is not
+    found.
+
+  Remarks:
+    Only available if USB_CDC_RX_BUFFER_SIZE is defined.
+*******************************************************************************/
+#if defined( USB_CDC_RX_BUFFER_SIZE )
+    uint16_t USBHostCDCRxRead( uint8_t deviceAddress, uint8_t *data, uint16_t size );
+#endif
+
+/*******************************************************************************
+  Function:
+    uint8_t USBHostCDCSendSegments( uint8_t deviceAddress,
+                        const USB_CDC_TX_SEGMENT *segments, uint8_t count )
+
+  Summary:
+    This function sends several application buffers as one stream.
+
+  Description:
+    This function queues count buffers to be sent in order on the data OUT
+    endpoint.  If the device is idle, the send starts at once.  If the
+    device is already sending on the data OUT endpoint, the buffers are
+    sent after the ones before them.  Only the list is copied; the data is
+    sent from the application buffers.
+
+    The send completes when the last queued buffer has been sent, and is
+    reported the same way as a USBHostCDC_Api_Send_OUT_Data() send.
+
+  Preconditions:
+    None
+
+  Parameters:
+    uint8_t deviceAddress              - Device address
+    const USB_CDC_TX_SEGMENT *segments - List of buffers to send
+    uint8_t count                      - Number of buffers in the list
+
+  Return Values:
+    USB_SUCCESS                 - The buffers were queued
+    USB_CDC_DEVICE_NOT_FOUND    - No device with specified address
+    USB_CDC_DEVICE_BUSY         - The device is busy with another transfer,
+                                  or there is no room for all of the buffers
+
+  Remarks:
+    Only available if USB_CDC_TX_QUEUE_DEPTH is defined.  Either all of the
+    buffers are queued or none are, so a message is never split.  The
+    buffers must not change until the send completes.
+*******************************************************************************/
+#if defined( USB_CDC_TX_QUEUE_DEPTH )
+    uint8_t USBHostCDCSendSegments( uint8_t deviceAddress, const USB_CDC_TX_SEGMENT *segments, uint8_t count );
+#endif
+
 /*******************************************************************************
   Function:
      void USBHostCDCTasks( void )
@@ -159,6 +159,45 @@ This defines the data type required to hold the maximum field size data.
 #endif
 
 
+// *****************************************************************************
+/* HID Report Plan
+
+This structure holds the compiled fields of one report, as filled in by
+USBHostHID_ApiCompileReport().  The fields themselves are stored in an array
+provided by the application, so the plan stays valid after the parser data
+is released.  USBHostHID_ApiImportReport() uses it to extract every value of
+the report in one pass.
+*/
+typedef struct _HID_REPORT_PLAN
+{
+    HID_FIELD   *fields;                  // fields - compiled fields of the report, in report order.
+    uint16_t    reportLength;             // reportLength - the expected length of the report in bytes.
+    uint8_t     reportID;                 // reportID - report ID, or 0 if the device does not use them.
+    uint8_t     numFields;                // numFields - number of entries in fields.
+    uint8_t     numValues;                // numValues - total of the field counts; values per imported report.
+    uint8_t     interfaceNum;             // interfaceNum - interface the report belongs to.
+}   HID_REPORT_PLAN;
+
+
+// *****************************************************************************
+/* HID Usage Handle
+
+This structure holds where one button or value is, as resolved by
+USBHostHID_ApiResolveUsage().  It is owned by the application and stays
+valid after the parser data is released, so a control can be looked up once
+and read from every report with USBHostHID_ApiReadUsage().
+*/
+typedef struct _HID_USAGE_HANDLE
+{
+    uint16_t    bitOffset;                // bitOffset - bit position of the value, counting the report ID byte.
+    uint16_t    reportLength;             // reportLength - the expected length of the report in bytes.
+    uint8_t     reportID;                 // reportID - report ID, or 0 if the device does not use them.
+    uint8_t     bitLength;                // bitLength - size of the value in bits.
+    uint8_t     flags;                    // flags - HID_FIELD_SIGNED and HID_FIELD_RELATIVE.
+    uint8_t     interfaceNum;             // interfaceNum - interface the report belongs to.
+}   HID_USAGE_HANDLE;
+
+
 // *****************************************************************************
 /* HID Device ID Information
 
@@ -569,6 +608,63 @@ bool USBHostHID_ApiFindValue(uint16_t usagePage,uint16_t usage,HIDReportTypeEnum
                     uint8_t* Report_Length,uint8_t* Start_Bit, uint8_t* Bit_Length);
 
 
+/*******************************************************************************
+  Function:
+    bool USBHostHID_ApiResolveUsage(uint16_t usagePage, uint16_t usage,
+                HIDReportTypeEnum type, HID_USAGE_HANDLE *pHandle)
+
+  Description:
+    This function looks up a button or value once and stores where it is in
+    a handle, for use with USBHostHID_ApiReadUsage().
+
+  Precondition:
+    Application event handler with event 'EVENT_HID_RPT_DESC_PARSED' is
+    being called.
+
+  Parameters:
+    uint16_t usagePage          - usage page supported by application
+    uint16_t usage              - usage supported by application
+    HIDReportTypeEnum type      - report type Input/Output/Feature
+    HID_USAGE_HANDLE *pHandle   - returns the handle of the usage
+
+  Return Values:
+    true    - The usage is resolved into pHandle
+    false   - The device has no variable item with the usage, or the item
+              is wider than HID_MAX_DATA_FIELD_SIZE
+
+  Remarks:
+    Array items have no fixed position for a usage and are not resolved.
+*******************************************************************************/
+bool USBHostHID_ApiResolveUsage(uint16_t usagePage, uint16_t usage, HIDReportTypeEnum type, HID_USAGE_HANDLE *pHandle);
+
+
+/*******************************************************************************
+  Function:
+    bool USBHostHID_ApiReadUsage(uint8_t *report, uint16_t reportLength,
+                HID_USAGE_HANDLE *pHandle, HID_USER_DATA_SIZE *pValue)
+
+  Description:
+    This function reads the value of a resolved usage from a report.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t *report             - Report received from device
+    uint16_t reportLength       - Length of the report
+    HID_USAGE_HANDLE *pHandle   - Handle of the usage
+    HID_USER_DATA_SIZE *pValue  - returns the value
+
+  Return Values:
+    true    - The value is read
+    false   - The report is not the one that holds the usage
+
+  Remarks:
+    None
+*******************************************************************************/
+bool USBHostHID_ApiReadUsage(uint8_t *report, uint16_t reportLength, HID_USAGE_HANDLE *pHandle, HID_USER_DATA_SIZE *pValue);
+
+
 /*******************************************************************************
   Function:
     uint8_t USBHostHID_ApiGetCurrentInterfaceNum(void)
@@ -668,6 +764,97 @@ uint8_t USBHostHID_ApiGetCurrentInterfaceNum(void);
 bool USBHostHID_ApiImportData(uint8_t *report,uint16_t reportLength,HID_USER_DATA_SIZE *buffer, HID_DATA_DETAILS *pDataDetails);
 
 
+/*******************************************************************************
+  Function:
+    bool USBHostHID_ApiCompileReport(HIDReportTypeEnum type, uint8_t reportID,
+                    HID_REPORT_PLAN *pPlan, HID_FIELD *pFields, uint8_t maxFields)
+
+  Description:
+    This function copies the fields that the parser compiled for one report
+    into application memory and fills in the report plan.  Once compiled, a
+    report is imported with USBHostHID_ApiImportReport(), which extracts all
+    of its values in a single pass.
+
+  Precondition:
+    Application event handler with event 'EVENT_HID_RPT_DESC_PARSED' is
+    being called.
+
+  Parameters:
+    HIDReportTypeEnum type  - report type Input/Output/Feature
+    uint8_t reportID        - report ID, or 0 if the device has no report IDs
+    HID_REPORT_PLAN *pPlan  - returns the plan of the report
+    HID_FIELD *pFields      - array that receives the compiled fields
+    uint8_t maxFields       - number of entries in pFields
+
+  Return Values:
+    true    - The report is compiled into pPlan
+    false   - The report does not exist, has more than maxFields fields,
+              or has a field wider than HID_MAX_DATA_FIELD_SIZE
+
+  Remarks:
+    Constant (padding) items are not part of the plan.
+*******************************************************************************/
+bool USBHostHID_ApiCompileReport(HIDReportTypeEnum type, uint8_t reportID, HID_REPORT_PLAN *pPlan,
+                    HID_FIELD *pFields, uint8_t maxFields);
+
+
+/*******************************************************************************
+  Function:
+    uint8_t USBHostHID_ApiImportReport(uint8_t *report, uint16_t reportLength,
+                    HID_REPORT_PLAN *pPlan, HID_USER_DATA_SIZE *buffer)
+
+  Description:
+    This function extracts every value of a report compiled with
+    USBHostHID_ApiCompileReport().  The values are stored in buffer field by
+    field, in the order of pPlan->fields; signed fields are sign extended.
+    Byte aligned 8, 16 and 32 bit fields and single bit fields are copied
+    without the general shift and mask.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t *report             - Report received from device
+    uint16_t reportLength       - Length of the report
+    HID_REPORT_PLAN *pPlan      - Plan of the report
+    HID_USER_DATA_SIZE *buffer  - Buffer of at least pPlan->numValues
+                                  entries that receives the values
+
+  Return Values:
+    pPlan->numValues    - The report was imported
+    0                   - The report ID or length does not match the plan
+
+  Remarks:
+    None
+*******************************************************************************/
+uint8_t USBHostHID_ApiImportReport(uint8_t *report, uint16_t reportLength, HID_REPORT_PLAN *pPlan, HID_USER_DATA_SIZE *buffer);
+
+
+/*******************************************************************************
+  Function:
+    int32_t USBHostHID_ApiScaleValue(HID_FIELD *pField, int32_t value)
+
+  Description:
+    This function converts a logical value of a compiled field to physical
+    units, using the scale factor computed by the parser.
+
+  Precondition:
+    None
+
+  Parameters:
+    HID_FIELD *pField   - Compiled field the value belongs to
+    int32_t value       - Logical value, sign extended if the field is signed
+
+  Returns:
+    The physical value.  If the field has no physical extent
+    (HID_FIELD_SCALED is clear), the logical value is returned.
+
+  Remarks:
+    None
+*******************************************************************************/
+int32_t USBHostHID_ApiScaleValue(HID_FIELD *pField, int32_t value);
+
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: USB Host Callback Function Prototypes
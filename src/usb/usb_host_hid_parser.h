@@ -34,6 +34,19 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 #define HIDItem_TagShift           0x04     // Shift Value for Tag bitfield in Item header
 #define HIDItem_TypeMask           0xC      // Mask for Type bitfield in Item header
 #define HIDItem_TypeShift          0x02     // Shift Value for Tag bitfield
+#define HIDItem_LongPrefix         0xFE     // Item header of a Long Item, followed by data size and tag
+
+//------------------------------------------------------------------------------
+//
+// Parser Configuration
+//
+//------------------------------------------------------------------------------
+
+// USB_HID_MAX_PARSER_MEMORY - If defined in usb_config.h, the most heap, in
+// bytes, that one report descriptor may take: the raw descriptor plus the
+// tables the parser builds from it.  A larger descriptor is rejected with
+// HID_ERR_NotEnoughMemory (or USB_MEMORY_ALLOCATION_ERROR, if the raw
+// descriptor alone is too large) before anything is allocated for it.
 
 //------------------------------------------------------------------------------
 //
@@ -197,6 +210,8 @@ typedef struct _HID_REPORT
     uint16_t                     inputBits;         // If input report then length of report in bits
     uint16_t                     outputBits;        // If output report then length of report in bits
     uint16_t                     featureBits;       // If feature report then length of report in bits
+    uint8_t                     firstField[hidReportUnknown];  // Index of the first compiled field of each report type
+    uint8_t                     fields[hidReportUnknown];      // Number of compiled fields of each report type
 }   HID_REPORT;
 
 
@@ -227,7 +242,7 @@ typedef struct _HID_REPORTITEM
 {
     HIDReportTypeEnum        reportType;          // Type of Report Input/Output/Feature
     HID_GLOBALS              globals;             // Stores all the global items associated with the current report
-    uint8_t                     startBit;            // Starting Bit Position of the report
+    uint16_t                    startBit;            // Starting Bit Position of the report
     uint8_t                     parent;              // Index of parent collection
     uint32_t                    dataModes;           // this tells the data mode is array or not
     uint8_t                     firstUsageItem;      // Index to first usage item related to the report
@@ -266,6 +281,59 @@ typedef struct _HID_STRINGITEM
 }   HID_STRINGITEM, HID_DESIGITEM;
 
 
+// *****************************************************************************
+/* HID Compiled Field
+
+This structure describes one data Main Item of a report, resolved to what is
+needed to extract its values: where they are, how wide they are and how to
+scale them.  The parser compiles one field per Input, Output or Feature item
+that is not constant, grouped by report and report type (see HID_REPORT).
+Application copies the fields of a report with USBHostHID_ApiCompileReport().
+*/
+typedef struct _HID_FIELD
+{
+    uint16_t                     bitOffset;     // Bit position of the first value, counting the report ID byte
+    uint16_t                     usagePage;     // Usage page of the first usage of the item
+    uint16_t                     usage;         // First usage (or usage minimum) of the item
+    uint8_t                     bitLength;     // Size of each value in bits
+    uint8_t                     count;         // Number of values
+    uint8_t                     flags;         // HID_FIELD_xxx
+    int32_t                     logicalMinimum; // Logical extent of the values
+    int32_t                     physicalMinimum;// Physical value of logicalMinimum
+    int32_t                     scale;         // Physical units per logical unit, 16.16 fixed point
+}   HID_FIELD;
+
+#define HID_FIELD_SIGNED           0x01     // Logical minimum is negative, values are sign extended
+#define HID_FIELD_ARRAY            0x02     // Array item, values are usage indexes
+#define HID_FIELD_RELATIVE         0x04     // Values are relative
+#define HID_FIELD_ALIGNED          0x08     // Values are whole bytes (8, 16 or 32 bits) on byte boundaries
+#define HID_FIELD_SCALED           0x10     // A physical extent is defined, see USBHostHID_ApiScaleValue()
+
+
+// *****************************************************************************
+/* HID Usage Index Entry
+
+The parser builds one entry per usage item of a report item, sorted by report
+type, usage page and first usage, so that a usage can be located with a
+binary search instead of a scan of every report item.  See
+USBHostHID_FindUsage().
+*/
+typedef struct _HID_USAGEINDEX
+{
+    uint16_t                     usagePage;     // Usage page of the usage item
+    uint16_t                     usageMinimum;  // First usage of the usage item
+    uint16_t                     usageMaximum;  // Last usage of the usage item
+    uint16_t                     reach;         // Highest usageMaximum of this and earlier entries of the same type and page
+    uint16_t                     firstIndex;    // Usage index of usageMinimum within the report item
+    uint8_t                     reportItem;    // Index of the report item
+    uint8_t                     usageItem;     // Index of the usage item
+    uint8_t                     reportType;    // Report type of the report item
+}   HID_USAGEINDEX;
+
+#define HID_FIND_NO_ARRAYS         0x01     // USBHostHID_FindUsage(): skip array items
+#define HID_FIND_NO_BITS           0x02     // USBHostHID_FindUsage(): skip one bit items
+
+
 // *****************************************************************************
 /* Report Descriptor Information
 
@@ -300,6 +368,7 @@ typedef struct _USB_HID_DEVICE_RPT_INFO
     uint8_t collectionNesting;     // this number tells depth of collection nesting
     uint8_t collections;           // total number of collections
     uint8_t designatorItems;       // total number of designator items
+    uint8_t fields;                // total number of compiled fields
     uint8_t firstUsageItem;        // index of first usage item for the current collection
     uint8_t firstDesignatorItem;   // index of first designator item for the current collection
     uint8_t firstStringItem;       // index of first string item for the current collection
@@ -312,6 +381,7 @@ typedef struct _USB_HID_DEVICE_RPT_INFO
     uint8_t sibling;               // current sibling collection
     uint8_t stringItems;           // total number of string items , used to index the array of strings
     uint8_t strings;               // total sumber of strings
+    uint8_t usageIndexes;          // total number of usage index entries
     uint8_t usageItems;            // total number of usage items , used to index the array of usage
     uint8_t usages;                // total sumber of usages
     HID_GLOBALS globals;        // holds cuurent globals items
@@ -332,10 +402,12 @@ typedef struct _USB_HID_ITEM_LIST
 {
     HID_COLLECTION *collectionList;     // List of collections, see HID_COLLECTION for details in the structure
     HID_DESIGITEM *designatorItemList;  // List of designator Items, see HID_DESIGITEM for details in the structure
+    HID_FIELD *fieldList;               // List of compiled fields, see HID_FIELD for details in the structure
     HID_GLOBALS *globalsStack;          // List of global Items, see HID_GLOBALS for details in the structure
     HID_REPORTITEM *reportItemList;     // List of report Items, see HID_REPORTITEM for details in the structure
     HID_REPORT *reportList;             // List of reports , see HID_REPORT for details in the structure
     HID_STRINGITEM *stringItemList;     // List of string item , see HID_STRINGITEM for details in the structure
+    HID_USAGEINDEX *usageIndex;         // Sorted index of the usages of the report items, see HID_USAGEINDEX
     HID_USAGEITEM *usageItemList;       // List of Usage item , see HID_USAGEITEM for details in the structure
     uint8_t *collectionStack;              // stores the array of parents ids for the collection
 }   USB_HID_ITEM_LIST;
@@ -366,7 +438,9 @@ typedef enum {
     HID_ERR_ZeroReportID,               // report ID is zero
     HID_ERR_ZeroReportCount,            // Number of reports is zero
     HID_ERR_BadUsageRangePage,          // Bad Usage page range
-    HID_ERR_BadUsageRange               // Bad Usage range
+    HID_ERR_BadUsageRange,              // Bad Usage range
+    HID_ERR_TooManyItems,               // More items of one kind than the tables can index (255)
+    HID_ERR_ReportTooLong               // Report longer than 65535 bits
 } USB_HID_RPT_DESC_ERROR;
 
 /****************************************************************************
@@ -400,6 +474,38 @@ typedef enum {
 bool USBHostHID_HasUsage(HID_REPORTITEM *reportItem,uint16_t usagePage, uint16_t usage,uint16_t *pindex,uint8_t* count);
 
 
+/****************************************************************************
+  Function:
+    bool USBHostHID_FindUsage(uint16_t usagePage, uint16_t usage,
+                HIDReportTypeEnum type, uint8_t options, uint8_t *preportItem,
+                uint16_t *pindex)
+
+  Description:
+    This function locates the first report item of the given type that has
+    the usage, using the sorted usage index built by the parser.
+
+  Precondition:
+    The report descriptor has been parsed.
+
+  Parameters:
+    uint16_t usagePage          - Usage page, or 0 to match any page
+    uint16_t usage              - Usage to be searched
+    HIDReportTypeEnum type      - Report type Input/Output/Feature
+    uint8_t options             - HID_FIND_xxx, report items to skip
+    uint8_t *preportItem        - returns the index of the report item
+    uint16_t *pindex            - returns the usage index within the report item
+
+  Return Values:
+    bool                       - FALSE - If requested usage is not found
+                                 TRUE  - if requested usage is found
+  Remarks:
+    The result is the same as calling USBHostHID_HasUsage() on each report
+    item in turn.
+***************************************************************************/
+bool USBHostHID_FindUsage(uint16_t usagePage, uint16_t usage, HIDReportTypeEnum type, uint8_t options,
+                uint8_t *preportItem, uint16_t *pindex);
+
+
 //******************************************************************************
 //******************************************************************************
 // Section: External Variables
@@ -0,0 +1,321 @@
+//DOM-IGNORE-BEGIN
+/*******************************************************************************
+Software License Agreement
+
+The software supplied herewith by Microchip Technology Incorporated
+(the "Company") for its PICmicro(R) Microcontroller is intended and
+supplied to you, the Company's customer, for use solely and
+exclusively on Microchip PICmicro Microcontroller products. The
+software is owned by the Company and/or its supplier, and is
+protected under applicable copyright laws. All rights are reserved.
+Any use in violation of the foregoing restrictions may subject the
+user to criminal sanctions under applicable laws, as well as to
+civil liability for the breach of the terms and conditions of this
+license.
+
+THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+
+*******************************************************************************/
+//DOM-IGNORE-END
+
+//DOM-IGNORE-BEGIN
+#ifndef _USB_HOST_HUB_H_
+#define _USB_HOST_HUB_H_
+//DOM-IGNORE-END
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Constants
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+
+// Number of downstream ports that are managed.  Ports above this number on
+// a larger hub are left unpowered.  At most 15.
+#ifndef USB_MAX_HUB_PORTS
+    #define USB_MAX_HUB_PORTS                   4
+#endif
+
+// *****************************************************************************
+// Section: Hub Class Error Codes
+// *****************************************************************************
+
+#define USB_HUB_ERROR                           USB_ERROR_CLASS_DEFINED     // Error code offset.
+
+#define USB_HUB_COMMAND_PASSED                  USB_SUCCESS                 // Command was successful.
+#define USB_HUB_DEVICE_NOT_FOUND                (USB_HUB_ERROR | 0x01)      // Hub with the specified address is not available.
+#define USB_HUB_ILLEGAL_PORT                    (USB_HUB_ERROR | 0x02)      // The port number is not managed by this driver.
+
+// *****************************************************************************
+// Section: Port States, returned by USBHostHubPortStatus()
+// *****************************************************************************
+
+#define USB_HUB_PORT_EMPTY                      0x00    // Nothing is connected.
+#define USB_HUB_PORT_DEBOUNCING                 0x01    // A device has connected; waiting for the connection to settle.
+#define USB_HUB_PORT_RESETTING                  0x02    // The port is being reset.
+#define USB_HUB_PORT_ENABLED                    0x03    // A device is connected, reset, and handed to the host layer.
+#define USB_HUB_PORT_OVERCURRENT                0x04    // The hub reported an overcurrent condition on the port.
+
+// *****************************************************************************
+// Section: Port Speeds, see USB_HUB_PORT_EVENT_DATA
+// *****************************************************************************
+
+#define USB_HUB_PORT_SPEED_FULL                 0x00    // Full speed device.
+#define USB_HUB_PORT_SPEED_LOW                  0x01    // Low speed device.
+#define USB_HUB_PORT_SPEED_HIGH                 0x02    // High speed device (operates at full speed on this host).
+
+// *****************************************************************************
+// Section: Interface and Protocol Constants
+// *****************************************************************************
+
+#define DEVICE_CLASS_HUB                        0x09    // Class code for a hub.
+
+#define USB_HUB_DESCRIPTOR                      0x29    // Hub class descriptor type.
+
+#define USB_HUB_FEATURE_C_HUB_LOCAL_POWER       0
+#define USB_HUB_FEATURE_C_HUB_OVER_CURRENT      1
+
+#define USB_HUB_FEATURE_PORT_CONNECTION         0
+#define USB_HUB_FEATURE_PORT_ENABLE             1
+#define USB_HUB_FEATURE_PORT_SUSPEND            2
+#define USB_HUB_FEATURE_PORT_OVER_CURRENT       3
+#define USB_HUB_FEATURE_PORT_RESET              4
+#define USB_HUB_FEATURE_PORT_POWER              8
+#define USB_HUB_FEATURE_PORT_LOW_SPEED          9
+#define USB_HUB_FEATURE_C_PORT_CONNECTION       16      // The change features are the wPortChange bit number + 16.
+
+#define USB_HUB_PORT_STATUS_CONNECTION          0x0001  // wPortStatus bits
+#define USB_HUB_PORT_STATUS_ENABLE              0x0002
+#define USB_HUB_PORT_STATUS_SUSPEND             0x0004
+#define USB_HUB_PORT_STATUS_OVER_CURRENT        0x0008
+#define USB_HUB_PORT_STATUS_RESET               0x0010
+#define USB_HUB_PORT_STATUS_POWER               0x0100
+#define USB_HUB_PORT_STATUS_LOW_SPEED           0x0200
+#define USB_HUB_PORT_STATUS_HIGH_SPEED          0x0400
+
+#define USB_HUB_PORT_CHANGE_CONNECTION          0x0001  // wPortChange bits
+#define USB_HUB_PORT_CHANGE_ENABLE              0x0002
+#define USB_HUB_PORT_CHANGE_SUSPEND             0x0004
+#define USB_HUB_PORT_CHANGE_OVER_CURRENT        0x0008
+#define USB_HUB_PORT_CHANGE_RESET               0x0010
+
+// *****************************************************************************
+// Section: Hub Event Definition
+// *****************************************************************************
+
+// If the application has not defined an offset for hub events, set it to 0.
+#ifndef EVENT_HUB_OFFSET
+    #define EVENT_HUB_OFFSET    0
+#endif
+
+    // A device on a hub port has been reset, and the host layer has started
+    // to enumerate it.  Its client drivers are initialized with its own
+    // address once it is configured.  The returned data pointer points to a
+    // USB_HUB_PORT_EVENT_DATA structure.
+#define EVENT_HUB_PORT_ATTACH       EVENT_HUB_BASE + EVENT_HUB_OFFSET + 0
+    // The device on a hub port has been removed, or the hub disabled the
+    // port.  The returned data pointer points to a USB_HUB_PORT_EVENT_DATA
+    // structure.
+#define EVENT_HUB_PORT_DETACH       EVENT_HUB_BASE + EVENT_HUB_OFFSET + 1
+    // The hub reported an overcurrent condition on a port.  The returned
+    // data pointer points to a USB_HUB_PORT_EVENT_DATA structure.
+#define EVENT_HUB_PORT_OVERCURRENT  EVENT_HUB_BASE + EVENT_HUB_OFFSET + 2
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Structures
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* Hub Port Event Data
+
+This structure is passed with the EVENT_HUB_PORT_xxx events.
+*/
+typedef struct _USB_HUB_PORT_EVENT_DATA
+{
+    uint8_t     hubAddress;         // Address of the hub.
+    uint8_t     port;               // Port number, starting at 1.
+    uint8_t     speed;              // USB_HUB_PORT_SPEED_xxx, valid for EVENT_HUB_PORT_ATTACH.
+} USB_HUB_PORT_EVENT_DATA;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Function Prototypes
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostHubPortStatus( uint8_t deviceAddress, uint8_t port )
+
+  Summary:
+    This function returns the state of a hub port.
+
+  Description:
+    This function returns the state of a downstream port of the hub.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress  - Address of the hub
+    uint8_t port           - Port number, starting at 1
+
+  Return Values:
+    USB_HUB_PORT_xxx            - State of the port
+    USB_HUB_DEVICE_NOT_FOUND    - No hub with this address is attached
+    USB_HUB_ILLEGAL_PORT        - The port is not managed
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+uint8_t USBHostHubPortStatus( uint8_t deviceAddress, uint8_t port );
+
+
+/****************************************************************************
+  Function:
+    void USBHostHubTasks( void )
+
+  Summary:
+    This function performs the maintenance tasks of the hub client driver.
+
+  Description:
+    This function runs the hub state machine: it reads the hub descriptor,
+    powers the ports, polls the status change endpoint, and debounces and
+    resets ports as devices connect.  It must be called periodically,
+    whether or not transfer events are enabled.
+
+  Precondition:
+    USBHostHubInitialize() has been called.
+
+  Parameters:
+    None - None
+
+  Returns:
+    None
+
+  Remarks:
+    A request the hub fails is tried again; if it keeps failing, the hub
+    is set up again from its descriptor.
+  ***************************************************************************/
+
+void    USBHostHubTasks( void );
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Host Stack Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************************
+  Function:
+    bool USBHostHubInitialize( uint8_t address, uint32_t flags, uint8_t clientDriverID )
+
+  Summary:
+    This function is the initialization routine for this client driver.
+
+  Description:
+    This function is the initialization routine for this client driver.  It
+    is called by the host layer when the USB device is being enumerated.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t address        - Address of the new device
+    uint32_t flags         - Initialization flags
+    uint8_t clientDriverID - ID to send when issuing a Device Request via
+                            USBHostIssueDeviceRequest() or USBHostSetDeviceConfiguration().
+
+  Return Values:
+    true   - We can support the device.
+    false  - We cannot support the device.
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+bool USBHostHubInitialize( uint8_t address, uint32_t flags, uint8_t clientDriverID );
+
+
+/****************************************************************************
+  Function:
+    bool USBHostHubEventHandler( uint8_t address, USB_EVENT event,
+                            void *data, uint32_t size )
+
+  Summary:
+    This function is the event handler for this client driver.
+
+  Description:
+    This function is the event handler for this client driver.  It is called
+    by the host layer when various events occur.
+
+  Precondition:
+    The device has been initialized.
+
+  Parameters:
+    uint8_t address    - Address of the device
+    USB_EVENT event - Event that has occurred
+    void *data      - Pointer to data pertinent to the event
+    uint32_t size       - Size of the data
+
+  Return Values:
+    true   - Event was handled
+    false  - Event was not handled
+
+  Remarks:
+    None
+  ***************************************************************************/
+
+bool USBHostHubEventHandler( uint8_t address, USB_EVENT event, void *data, uint32_t size );
+
+
+/****************************************************************************
+  Function:
+    bool USBHostHubDataEventHandler( uint8_t address, USB_EVENT event,
+                            void *data, uint32_t size )
+
+  Summary:
+    This function is the data event handler for this client driver.
+
+  Description:
+    This function is the data event handler for this client driver.  It
+    uses EVENT_1MS to time the power-on, debounce, and reset recovery
+    delays.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t address    - Address of the device
+    USB_EVENT event - Event that has occurred
+    void *data      - Pointer to data pertinent to the event
+    uint32_t size       - Size of the data
+
+  Return Values:
+    true   - Event was handled
+    false  - Event was not handled
+
+  Remarks:
+    This is called from the USB interrupt.
+  ***************************************************************************/
+
+bool USBHostHubDataEventHandler( uint8_t address, USB_EVENT event, void *data, uint32_t size );
+
+
+#endif
@@ -56,6 +56,7 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 #define USB_MSD_MEDIA_INTERFACE_ERROR       (USB_MSD_ERROR | 0x09)              // The media interface layer cannot support the device.
 #define USB_MSD_RESET_ERROR                 (USB_MSD_ERROR | 0x0A)              // An error occurred while resetting the device.
 #define USB_MSD_ILLEGAL_REQUEST             (USB_MSD_ERROR | 0x0B)              // Cannot perform requested operation.
+#define USB_MSD_TRANSFER_TERMINATED         (USB_MSD_ERROR | 0x0C)              // The queued transfer was terminated by the application.
 
 // *****************************************************************************
 // Section: Additional return values for USBHostMSDDeviceStatus (see USBHostDeviceStatus also)
@@ -98,6 +99,32 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 #define EVENT_MSD_MAX_LUN   EVENT_MSD_BASE + EVENT_MSD_OFFSET + 3   // Set maximum LUN for the device
 #define EVENT_MSD_ATTACH    EVENT_MSD_BASE + EVENT_MSD_OFFSET + 4   // MSD device has attached
 
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Structures
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* Command Queue Statistics
+
+This structure reports the latency of the commands that completed through the
+command queue of a device (see USB_MSD_QUEUE_DEPTH).  It is filled in by
+USBHostMSDGetQueueStats().  Latencies are counted in frames, from queueing a
+command to receiving its CSW, so they include the time spent behind other
+commands.
+*/
+typedef struct _USB_MSD_QUEUE_STATS
+{
+    uint32_t    commands;               // Number of commands completed.
+    uint32_t    errors;                 // Number of those that completed with an error.
+    uint32_t    totalFrames;            // Sum of the latencies; divide by commands for the average.
+    uint16_t    lastFrames;             // Latency of the most recent command.
+    uint16_t    maxFrames;              // Longest latency.
+    uint8_t     depth;                  // Number of queue entries (USB_MSD_QUEUE_DEPTH).
+    uint8_t     highWater;              // Most commands ever queued or active at once.
+} USB_MSD_QUEUE_STATS;
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Function Prototypes and Macro Functions
@@ -139,6 +166,123 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 uint8_t    USBHostMSDDeviceStatus( uint8_t deviceAddress );
 
 
+/****************************************************************************
+  Function:
+    uint8_t USBHostMSDGetQueueStats( uint8_t deviceAddress, USB_MSD_QUEUE_STATS *stats )
+
+  Description:
+    This function returns the latency statistics of the commands that have
+    completed through the command queue of a mass storage device.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress       - Device address
+    USB_MSD_QUEUE_STATS *stats  - Filled in with the statistics
+
+  Return Values:
+    USB_SUCCESS                 - The statistics were returned
+    USB_MSD_DEVICE_NOT_FOUND    - No device with specified address
+
+  Remarks:
+    Only available if USB_MSD_QUEUE_DEPTH is defined.  The statistics are
+    cleared when the device attaches.
+  ***************************************************************************/
+
+#if defined( USB_MSD_QUEUE_DEPTH )
+    uint8_t    USBHostMSDGetQueueStats( uint8_t deviceAddress, USB_MSD_QUEUE_STATS *stats );
+#endif
+
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostMSDQueueTransfer( uint8_t deviceAddress, uint8_t deviceLUN,
+                uint8_t direction, uint8_t *commandBlock, uint8_t commandBlockLength,
+                uint8_t *data, uint32_t dataLength, uint8_t *command )
+
+  Summary:
+    This function queues a mass storage transfer.
+
+  Description:
+    This function adds a mass storage transfer to the command queue of the
+    device, behind any commands already queued for any LUN.  The CBW is
+    prepared now, so that it is sent as soon as the CSW of the previous
+    command has been received.  Use USBHostMSDQueuedTransferIsComplete()
+    with the returned command number to get the result.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress      - Device address
+    uint8_t deviceLUN          - Device LUN to access
+    uint8_t direction          - 1=read, 0=write
+    uint8_t *commandBlock      - Pointer to the command block for the CBW
+    uint8_t commandBlockLength - Length of the command block
+    uint8_t *data              - Pointer to the data buffer
+    uint32_t dataLength        - Byte size of the data buffer
+    uint8_t *command           - Returns the number of the queued command
+
+  Return Values:
+    USB_SUCCESS                 - Command queued
+    USB_MSD_DEVICE_NOT_FOUND    - No device with specified address
+    USB_MSD_DEVICE_BUSY         - The queue is full, or the device is not
+                                    running
+    USB_MSD_INVALID_LUN         - Specified LUN does not exist
+
+  Remarks:
+    Only available if USB_MSD_QUEUE_DEPTH is defined.  The command block is
+    copied; the data buffer must stay valid until the command completes.
+    A queue entry stays in use until its result has been read with
+    USBHostMSDQueuedTransferIsComplete().
+  ***************************************************************************/
+
+#if defined( USB_MSD_QUEUE_DEPTH )
+    uint8_t    USBHostMSDQueueTransfer( uint8_t deviceAddress, uint8_t deviceLUN, uint8_t direction, uint8_t *commandBlock,
+                        uint8_t commandBlockLength, uint8_t *data, uint32_t dataLength, uint8_t *command );
+#endif
+
+
+/****************************************************************************
+  Function:
+    bool USBHostMSDQueuedTransferIsComplete( uint8_t deviceAddress, uint8_t command,
+                        uint8_t *errorCode, uint32_t *byteCount, uint16_t *frames )
+
+  Summary:
+    This function indicates whether or not a queued transfer is complete.
+
+  Description:
+    This function indicates whether or not a transfer queued with
+    USBHostMSDQueueTransfer() is complete.  If the function returns true,
+    the returned error code, byte count and latency are valid, and the
+    queue entry is free for another command.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress  - Device address
+    uint8_t command        - Command number from USBHostMSDQueueTransfer()
+    uint8_t *errorCode     - Error code of the command
+    uint32_t *byteCount    - Number of bytes transferred
+    uint16_t *frames       - Frames from queueing the command to receiving
+                             its CSW.  May be NULL.
+
+  Return Values:
+    true    - Transfer is complete, errorCode is valid
+    false   - Transfer is not complete, errorCode is not valid
+
+  Remarks:
+    Only available if USB_MSD_QUEUE_DEPTH is defined.  If the device has
+    detached, the function returns true with USB_MSD_DEVICE_NOT_FOUND.
+  ***************************************************************************/
+
+#if defined( USB_MSD_QUEUE_DEPTH )
+    bool    USBHostMSDQueuedTransferIsComplete( uint8_t deviceAddress, uint8_t command, uint8_t *errorCode, uint32_t *byteCount, uint16_t *frames );
+#endif
+
+
 /*******************************************************************************
   Function:
     uint8_t USBHostMSDRead( uint8_t deviceAddress, uint8_t deviceLUN, uint8_t *commandBlock,
@@ -37,6 +37,16 @@ CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
 // *****************************************************************************
 // *****************************************************************************
 
+// USB_MSD_SCSI_CACHE_SECTORS - If defined in usb_config.h, the number of
+// sectors (1 to 255) in the sector cache.  USBHostMSDSCSISectorRead() reads
+// through the cache, reading ahead to fill it when reads are sequential, and
+// USBHostMSDSCSISectorWrite() writes into it.  Written sectors are sent to the
+// media, contiguous runs as one WRITE10, when the cache is needed for other
+// sectors or when USBHostMSDSCSICacheFlush() is called.
+
+// USB_MSD_SCSI_CACHE_SECTOR_SIZE - Size in bytes of one cache slot, 512 if not
+// defined.  Media with a different sector size are not cached.
+
 
 // *****************************************************************************
 // *****************************************************************************
@@ -184,6 +194,11 @@ uint8_t    USBHostMSDSCSIMediaReset( uint8_t * address );
     false   - read was not successful
 
   Remarks:
+    If USB_MSD_SCSI_CACHE_SECTORS is defined, the sector is read through the
+    sector cache.  A miss that continues the previous read reads ahead to
+    fill the cache; see USBHostMSDSCSISectorsRead() to read a known range in
+    one command.
+
     The READ10 command block is as follows:
 
     <code>
@@ -231,6 +246,9 @@ uint8_t    USBHostMSDSCSISectorRead( uint8_t * address, uint32_t sectorAddress,
 
   Remarks:
     To follow convention, this function blocks until the write is complete.
+    If USB_MSD_SCSI_CACHE_SECTORS is defined, the sector is only copied into
+    the sector cache, and reaches the media when the cache is flushed; see
+    USBHostMSDSCSICacheFlush().
 
     The WRITE10 command block is as follows:
 
@@ -252,6 +270,112 @@ uint8_t    USBHostMSDSCSISectorRead( uint8_t * address, uint32_t sectorAddress,
 uint8_t    USBHostMSDSCSISectorWrite( uint8_t * address, uint32_t sectorAddress, uint8_t *dataBuffer, uint8_t allowWriteToZero);
 
 
+/****************************************************************************
+  Function:
+    uint8_t USBHostMSDSCSISectorsRead( uint8_t * address, uint32_t sectorAddress,
+                uint16_t sectorCount, uint8_t *dataBuffer )
+
+  Summary:
+    This function reads several contiguous sectors.
+
+  Description:
+    This function uses one SCSI READ10 command to read sectorCount sectors,
+    starting at sectorAddress.  The device sees a single command/data/status
+    round trip instead of one per sector.  The data is stored in the
+    application buffer, which must hold sectorCount times the sector size
+    determined in USBHostMSDSCSIMediaInitialize().
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t * address - Endpoint address of the device
+    uint32_t   sectorAddress   - address of the first sector to read
+    uint16_t   sectorCount     - number of sectors to read
+    uint8_t    *dataBuffer     - buffer to store data
+
+  Return Values:
+    true    - read performed successfully
+    false   - read was not successful
+
+  Remarks:
+    If the sector cache is enabled, sectors in the range that are waiting to
+    be written are flushed first.  The data itself bypasses the cache.
+  ***************************************************************************/
+
+uint8_t    USBHostMSDSCSISectorsRead( uint8_t * address, uint32_t sectorAddress, uint16_t sectorCount, uint8_t *dataBuffer );
+
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostMSDSCSISectorsWrite( uint8_t * address, uint32_t sectorAddress,
+                uint16_t sectorCount, uint8_t *dataBuffer, uint8_t allowWriteToZero )
+
+  Summary:
+    This function writes several contiguous sectors.
+
+  Description:
+    This function uses one SCSI WRITE10 command to write sectorCount sectors,
+    starting at sectorAddress.  The data is read from the application
+    buffer, which must hold sectorCount times the sector size determined in
+    USBHostMSDSCSIMediaInitialize().
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t * address - Endpoint address of the device
+    uint32_t   sectorAddress   - address of the first sector to write
+    uint16_t   sectorCount     - number of sectors to write
+    uint8_t    *dataBuffer     - buffer with application data
+    uint8_t    allowWriteToZero- If a write to sector 0 is allowed.
+
+  Return Values:
+    true    - write performed successfully
+    false   - write was not successful
+
+  Remarks:
+    This function blocks until the write is complete.  The data is written
+    through to the media even if the sector cache is enabled; any cached
+    copy of the range is flushed and dropped first.
+  ***************************************************************************/
+
+uint8_t    USBHostMSDSCSISectorsWrite( uint8_t * address, uint32_t sectorAddress, uint16_t sectorCount, uint8_t *dataBuffer, uint8_t allowWriteToZero );
+
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostMSDSCSICacheFlush( uint8_t * address )
+
+  Summary:
+    This function writes any cached sectors to the media.
+
+  Description:
+    When the sector cache is enabled, USBHostMSDSCSISectorWrite() only
+    copies the sector into the cache.  Written sectors reach the media when
+    the cache needs the space for other sectors, or when this function is
+    called.  Each run of contiguous written sectors is sent with one WRITE10
+    command.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t * address - Endpoint address of the device
+
+  Return Values:
+    true    - all written sectors are on the media
+    false   - a write was not successful; the sectors stay in the cache
+
+  Remarks:
+    Call this after closing files and before the media is removed.  Sectors
+    still in the cache when the device detaches are lost.  If the cache is
+    not enabled, this function does nothing and returns true.
+  ***************************************************************************/
+
+uint8_t    USBHostMSDSCSICacheFlush( uint8_t * address );
+
+
 /****************************************************************************
   Function:
     uint8_t USBHostMSDSCSIWriteProtectState( uint8_t * address )
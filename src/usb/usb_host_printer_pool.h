@@ -0,0 +1,261 @@
+//DOM-IGNORE-BEGIN
+/*******************************************************************************
+Software License Agreement
+
+The software supplied herewith by Microchip Technology Incorporated
+(the "Company") for its PICmicro(R) Microcontroller is intended and
+supplied to you, the Company's customer, for use solely and
+exclusively on Microchip PICmicro Microcontroller products. The
+software is owned by the Company and/or its supplier, and is
+protected under applicable copyright laws. All rights are reserved.
+Any use in violation of the foregoing restrictions may subject the
+user to criminal sanctions under applicable laws, as well as to
+civil liability for the breach of the terms and conditions of this
+license.
+
+THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+
+*******************************************************************************/
+//DOM-IGNORE-END
+
+//DOM-IGNORE-BEGIN
+#ifndef _USB_HOST_PRINTER_POOL_H_
+#define _USB_HOST_PRINTER_POOL_H_
+//DOM-IGNORE-END
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+// If USB_PRINTER_BUFFER_POOL is defined, the printer language drivers take
+// their command and image buffers from fixed blocks owned by the printer
+// client instead of the heap.  A buffer that does not fit in a block is
+// refused with USB_PRINTER_OUT_OF_MEMORY; it is never taken from the heap.
+#if defined( USB_PRINTER_BUFFER_POOL )
+    // Size and number of the blocks for commands.
+    #ifndef USB_PRINTER_POOL_COMMAND_SIZE
+        #define USB_PRINTER_POOL_COMMAND_SIZE   96
+    #endif
+    #ifndef USB_PRINTER_POOL_COMMAND_BLOCKS
+        #define USB_PRINTER_POOL_COMMAND_BLOCKS 8
+    #endif
+
+    // Size and number of the blocks for image rows and bands, and for the
+    // working buffers a driver keeps for the length of an image.  With 3,
+    // one can be held as a working buffer while two rows take turns in
+    // the transfer queue.
+    #ifndef USB_PRINTER_POOL_ROW_SIZE
+        #define USB_PRINTER_POOL_ROW_SIZE       2048
+    #endif
+    #ifndef USB_PRINTER_POOL_ROW_BLOCKS
+        #define USB_PRINTER_POOL_ROW_BLOCKS     3
+    #endif
+
+    #if (USB_PRINTER_POOL_COMMAND_BLOCKS > 32) || (USB_PRINTER_POOL_ROW_BLOCKS > 32)
+        #error The printer buffer pool supports at most 32 blocks of each size.
+    #endif
+
+    #define USB_PRINTER_MALLOC(size)    USBHostPrinterBufferGet(size)
+    #define USB_PRINTER_FREE(ptr)       USBHostPrinterBufferRelease(ptr)
+#else
+    #define USB_PRINTER_MALLOC(size)    USB_MALLOC(size)
+    #define USB_PRINTER_FREE(ptr)       USB_FREE(ptr)
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Structures
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* Printer Transfer Queue Statistics
+
+This structure reports how full the output transfer queue of a printer has
+been.  It is filled in by USBHostPrinterGetQueueStats().  If highWater
+reaches size, the application is producing commands faster than the printer
+takes them, and busy counts the commands that were refused because of it.
+*/
+typedef struct _USB_PRINTER_QUEUE_STATS
+{
+    uint32_t    transfers;              // Number of transfers queued.
+    uint32_t    busy;                   // Number of transfers refused because the queue was full.
+    uint32_t    bufferWaits;            // Number of times USBHostPrinterCommandReady() waited for a pool buffer.
+    uint8_t     size;                   // Number of queue entries (USB_PRINTER_TRANSFER_QUEUE_SIZE).
+    uint8_t     depth;                  // Transfers queued now, including the one being sent.
+    uint8_t     highWater;              // Most transfers ever queued at once.
+} USB_PRINTER_QUEUE_STATS;
+
+
+// *****************************************************************************
+/* Printer Buffer Pool Statistics
+
+This structure reports the use of the printer buffer pool, which is shared by
+all printers.  It is filled in by USBHostPrinterBufferGetStats().  The low
+water marks are the fewest blocks that were ever free; if one stays at 0,
+more blocks of that size would let more transfers be queued.
+*/
+typedef struct _USB_PRINTER_BUFFER_POOL_STATS
+{
+    uint32_t    failures;               // Number of buffers refused.
+    uint8_t     commandBlocks;          // Number of command blocks (USB_PRINTER_POOL_COMMAND_BLOCKS).
+    uint8_t     commandFree;            // Command blocks free now.
+    uint8_t     commandLowWater;        // Fewest command blocks ever free.
+    uint8_t     rowBlocks;              // Number of row blocks (USB_PRINTER_POOL_ROW_BLOCKS).
+    uint8_t     rowFree;                // Row blocks free now.
+    uint8_t     rowLowWater;            // Fewest row blocks ever free.
+} USB_PRINTER_BUFFER_POOL_STATS;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Function Prototypes
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************************
+  Function:
+    uint8_t USBHostPrinterGetQueueStats( uint8_t deviceAddress,
+                USB_PRINTER_QUEUE_STATS *stats )
+
+  Description:
+    This function returns the statistics of the output transfer queue of a
+    printer.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint8_t deviceAddress           - Device address
+    USB_PRINTER_QUEUE_STATS *stats  - Filled in with the statistics
+
+  Return Values:
+    USB_SUCCESS                 - The statistics were returned
+    USB_PRINTER_UNKNOWN_DEVICE  - No printer with specified address
+
+  Remarks:
+    The statistics are cleared when the printer attaches.
+  ***************************************************************************/
+uint8_t USBHostPrinterGetQueueStats( uint8_t deviceAddress, USB_PRINTER_QUEUE_STATS *stats );
+
+/****************************************************************************
+  Function:
+    void * USBHostPrinterBufferGet( uint32_t size )
+
+  Summary:
+    This function takes a buffer from the printer buffer pool.
+
+  Description:
+    This function takes the smallest free block of the printer buffer pool
+    that holds size bytes.  A command that does not find a free command
+    block is given a row block.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint32_t size   - Number of bytes needed
+
+  Returns:
+    The buffer, or NULL if no free block is large enough.
+
+  Remarks:
+    Only available if USB_PRINTER_BUFFER_POOL is defined.  Like the heap,
+    the pool must not be used from an interrupt.
+  ***************************************************************************/
+void * USBHostPrinterBufferGet( uint32_t size );
+
+/****************************************************************************
+  Function:
+    void USBHostPrinterBufferRelease( void *buffer )
+
+  Summary:
+    This function returns a buffer to the printer buffer pool.
+
+  Description:
+    This function returns a buffer from USBHostPrinterBufferGet() to the
+    printer buffer pool.  The printer client calls it for every transfer
+    queued with USB_PRINTER_TRANSFER_COPY_DATA once it is done.  A buffer
+    that is not from the pool is passed to USB_FREE(), so an application
+    can still queue its own heap buffers with that flag.
+
+  Precondition:
+    None
+
+  Parameters:
+    void *buffer    - The buffer, or NULL
+
+  Returns:
+    None
+
+  Remarks:
+    Only available if USB_PRINTER_BUFFER_POOL is defined.
+  ***************************************************************************/
+void USBHostPrinterBufferRelease( void *buffer );
+
+/****************************************************************************
+  Function:
+    bool USBHostPrinterBufferAvailable( uint32_t size )
+
+  Summary:
+    This function tells if a buffer of the given size can be taken from the
+    pool.
+
+  Description:
+    This function tells if USBHostPrinterBufferGet() would return a buffer
+    of size bytes now: a command block or a row block is free for a buffer
+    of up to USB_PRINTER_POOL_COMMAND_SIZE bytes, and a row block for a
+    buffer of up to USB_PRINTER_POOL_ROW_SIZE bytes.
+    USBHostPrinterCommandReady() uses it so that commands wait for a buffer
+    instead of failing with USB_PRINTER_OUT_OF_MEMORY.  An application can
+    use it with USB_PRINTER_POOL_ROW_SIZE before USB_PRINTER_IMAGE_START,
+    which takes a row block for the image with the PCL 5 and PostScript
+    drivers.
+
+  Precondition:
+    None
+
+  Parameters:
+    uint32_t size   - Number of bytes needed
+
+  Return Values:
+    true    - A block large enough is free
+    false   - All blocks large enough are in use, or size is larger than a
+                row block
+
+  Remarks:
+    Only available if USB_PRINTER_BUFFER_POOL is defined.
+  ***************************************************************************/
+bool USBHostPrinterBufferAvailable( uint32_t size );
+
+/****************************************************************************
+  Function:
+    void USBHostPrinterBufferGetStats( USB_PRINTER_BUFFER_POOL_STATS *stats )
+
+  Description:
+    This function returns the statistics of the printer buffer pool.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_PRINTER_BUFFER_POOL_STATS *stats    - Filled in with the statistics
+
+  Returns:
+    None
+
+  Remarks:
+    Only available if USB_PRINTER_BUFFER_POOL is defined.
+  ***************************************************************************/
+void USBHostPrinterBufferGetStats( USB_PRINTER_BUFFER_POOL_STATS *stats );
+
+#endif
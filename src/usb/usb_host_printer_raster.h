@@ -0,0 +1,437 @@
+//DOM-IGNORE-BEGIN
+/*******************************************************************************
+Software License Agreement
+
+The software supplied herewith by Microchip Technology Incorporated
+(the "Company") for its PICmicro(R) Microcontroller is intended and
+supplied to you, the Company's customer, for use solely and
+exclusively on Microchip PICmicro Microcontroller products. The
+software is owned by the Company and/or its supplier, and is
+protected under applicable copyright laws. All rights are reserved.
+Any use in violation of the foregoing restrictions may subject the
+user to criminal sanctions under applicable laws, as well as to
+civil liability for the breach of the terms and conditions of this
+license.
+
+THIS SOFTWARE IS PROVIDED IN AN "AS IS" CONDITION. NO WARRANTIES,
+WHETHER EXPRESS, IMPLIED OR STATUTORY, INCLUDING, BUT NOT LIMITED
+TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE APPLY TO THIS SOFTWARE. THE COMPANY SHALL NOT,
+IN ANY CIRCUMSTANCES, BE LIABLE FOR SPECIAL, INCIDENTAL OR
+CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+
+*******************************************************************************/
+//DOM-IGNORE-END
+
+//DOM-IGNORE-BEGIN
+#ifndef _USB_HOST_PRINTER_RASTER_H_
+#define _USB_HOST_PRINTER_RASTER_H_
+//DOM-IGNORE-END
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Constants
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+// Section: Raster Compression Methods
+// *****************************************************************************
+
+// The values are the PCL raster compression method numbers, ESC*b#M.
+
+#define USB_PRINTER_RASTER_UNCOMPRESSED         0       // Row bytes as they are.
+#define USB_PRINTER_RASTER_PACKBITS             2       // TIFF PackBits runs and literals.
+#define USB_PRINTER_RASTER_DELTA_ROW            3       // Changes from the seed row.
+#define USB_PRINTER_RASTER_METHOD_UNKNOWN       0xFF    // No method selected on the printer yet.
+
+// Number of bytes it costs to select a different compression method, the
+// length of ESC*b#M.  USBHostPrinterRasterCompressRow() charges this to a
+// method other than the current one.
+#define USB_PRINTER_RASTER_METHOD_CHANGE_COST   5
+
+// Returned by the encoders when the output would not fit in the limit.
+#define USB_PRINTER_RASTER_TOO_LONG             0xFFFF
+
+// End of data byte of the PostScript RunLengthDecode filter.
+#define USB_PRINTER_RASTER_RLE_END              0x80
+
+// Most bytes of PackBits output for size bytes of data.
+#define USB_PRINTER_RASTER_PACKBITS_MAX(size)   ((size) + ((size) + 127) / 128)
+
+// Most characters of ASCII85 output for size more bytes of data, not
+// counting the end of data marker.
+#define USB_PRINTER_RASTER_ASCII85_MAX(size)    ((((uint32_t)(size) + 3) / 4) * 5)
+
+// Length of the ESC/POS GS v 0 raster bit image header, GS v 0 m xL xH yL yH.
+#define USB_PRINTER_RASTER_BAND_HEADER_SIZE     8
+
+// GS v 0 modes, the m byte of the header.
+#define USB_PRINTER_RASTER_BAND_DOUBLE_WIDTH    0x01    // Each dot is printed two dots wide.
+#define USB_PRINTER_RASTER_BAND_DOUBLE_HEIGHT   0x02    // Each dot is printed two dots high.
+
+// Bytes of a full band, header included; the size of its buffer.
+#define USB_PRINTER_RASTER_BAND_BYTES(band)     (USB_PRINTER_RASTER_BAND_HEADER_SIZE + (uint32_t)(band)->rows * (band)->rowBytes)
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Structures
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* ASCII85 Encoder State
+
+ASCII85 encodes each group of four bytes as five characters.  This structure
+holds the bytes of a partial group from one call of
+USBHostPrinterRasterASCII85() to the next, so a stream can be encoded in
+pieces of any size.  Clear it with USBHostPrinterRasterASCII85Start().
+*/
+typedef struct _USB_PRINTER_ASCII85
+{
+    uint32_t    group;      // Bytes of the partial group, first in the most significant byte.
+    uint8_t     count;      // Number of bytes in the partial group.
+} USB_PRINTER_ASCII85;
+
+// *****************************************************************************
+/* GS v 0 Raster Band
+
+ESC/POS printers take a raster image in GS v 0 blocks, each an 8 byte header
+followed by rows of the image.  This structure collects image rows into such
+a block, a band, so that it can be sent in one transfer.  The caller
+allocates buffer, USB_PRINTER_RASTER_BAND_BYTES() bytes, before the first row
+of each band, and fills in each row at USBHostPrinterRasterBandRow().
+*/
+typedef struct _USB_PRINTER_RASTER_BAND
+{
+    uint8_t     *buffer;    // Header and rows of the band being filled, or NULL.
+    uint16_t    rows;       // Rows in a full band.
+    uint16_t    rowCount;   // Rows in the band so far.
+    uint16_t    rowBytes;   // Bytes in each row of the image.
+    uint8_t     endMask;    // Bits of the last byte of a row that are inside the image.
+    uint8_t     mode;       // GS v 0 mode, the m byte of the header.
+} USB_PRINTER_RASTER_BAND;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Function Prototypes
+// *****************************************************************************
+// *****************************************************************************
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostPrinterRasterPackBits( const uint8_t *data, uint16_t size,
+                uint8_t *out, uint16_t limit )
+
+  Summary:
+    This function compresses data with TIFF PackBits.
+
+  Description:
+    This function compresses data with TIFF PackBits, PCL raster compression
+    method 2.  A control byte of 0 to 127 is followed by that many plus one
+    literal bytes; a control byte of -1 to -127 is followed by one byte that
+    is repeated one minus that many times.  This is also the PostScript
+    RunLengthDecode format, without its end of data byte.
+
+  Precondition:
+    None
+
+  Parameters:
+    const uint8_t *data - Data to compress
+    uint16_t size       - Number of bytes of data
+    uint8_t *out        - Where to put the compressed data
+    uint16_t limit      - Most bytes to put in out
+
+  Returns:
+    The number of compressed bytes, or USB_PRINTER_RASTER_TOO_LONG if they
+    would be more than limit.
+
+  Remarks:
+    None
+  ***************************************************************************/
+uint16_t USBHostPrinterRasterPackBits( const uint8_t *data, uint16_t size, uint8_t *out, uint16_t limit );
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostPrinterRasterDeltaRow( const uint8_t *data,
+                const uint8_t *seed, uint16_t size, uint8_t *out,
+                uint16_t limit )
+
+  Summary:
+    This function encodes the changes from the seed row.
+
+  Description:
+    This function encodes a raster row as the changes from the previous row
+    (the seed row), PCL raster compression method 3.  Each run of up to 8
+    changed bytes is a command byte, with the run length minus one in the
+    upper 3 bits and the offset from the end of the last run in the lower 5
+    bits, followed by the new bytes.  An offset of 31 or more is continued in
+    further bytes.  A row that is the same as the seed row encodes to no
+    bytes at all.
+
+  Precondition:
+    None
+
+  Parameters:
+    const uint8_t *data - Row to encode
+    const uint8_t *seed - Previous row, the same size
+    uint16_t size       - Number of bytes in the row
+    uint8_t *out        - Where to put the encoded row
+    uint16_t limit      - Most bytes to put in out
+
+  Returns:
+    The number of encoded bytes, or USB_PRINTER_RASTER_TOO_LONG if they
+    would be more than limit.
+
+  Remarks:
+    None
+  ***************************************************************************/
+uint16_t USBHostPrinterRasterDeltaRow( const uint8_t *data, const uint8_t *seed, uint16_t size, uint8_t *out, uint16_t limit );
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostPrinterRasterCompressRow( const uint8_t *data,
+                const uint8_t *seed, uint16_t size, uint8_t *method,
+                uint8_t *out, uint8_t *scratch )
+
+  Summary:
+    This function compresses a raster row with the method that sends the
+    fewest bytes.
+
+  Description:
+    This function compresses a raster row uncompressed, with PackBits, and
+    as a delta row, and keeps the shortest.  Changing the compression method
+    costs USB_PRINTER_RASTER_METHOD_CHANGE_COST bytes, which is counted
+    against the methods other than the current one.  Uncompressed and
+    PackBits rows leave off trailing zero bytes, which the printer fills in.
+
+  Precondition:
+    None
+
+  Parameters:
+    const uint8_t *data - Row to compress
+    const uint8_t *seed - Previous row of the image, or zeros for the first
+    uint16_t size       - Number of bytes in the row
+    uint8_t *method     - In: the method currently selected on the printer,
+                            or USB_PRINTER_RASTER_METHOD_UNKNOWN.
+                          Out: the method used for this row.
+    uint8_t *out        - Where to put the compressed row, size bytes
+    uint8_t *scratch    - Work space, size bytes
+
+  Returns:
+    The number of compressed bytes in out.  This is never more than size.
+
+  Remarks:
+    The printer decodes every row into its seed row, whatever the method,
+    so the caller keeps data as the seed for the next row.
+  ***************************************************************************/
+uint16_t USBHostPrinterRasterCompressRow( const uint8_t *data, const uint8_t *seed, uint16_t size,
+            uint8_t *method, uint8_t *out, uint8_t *scratch );
+
+/****************************************************************************
+  Function:
+    void USBHostPrinterRasterASCII85Start( USB_PRINTER_ASCII85 *state )
+
+  Summary:
+    This function starts an ASCII85 stream.
+
+  Description:
+    This function starts an ASCII85 stream.
+
+  Precondition:
+    None
+
+  Parameters:
+    USB_PRINTER_ASCII85 *state  - Encoder state of the stream
+
+  Returns:
+    None
+
+  Remarks:
+    None
+  ***************************************************************************/
+void USBHostPrinterRasterASCII85Start( USB_PRINTER_ASCII85 *state );
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostPrinterRasterASCII85( USB_PRINTER_ASCII85 *state,
+                const uint8_t *data, uint16_t size, char *out )
+
+  Summary:
+    This function encodes data in ASCII85.
+
+  Description:
+    This function encodes data in ASCII85, the format read by the PostScript
+    ASCII85Decode filter.  Each group of four bytes becomes five characters
+    from '!' to 'u', or 'z' if all four bytes are zero.  Bytes that do not
+    complete a group are kept in state for the next call.
+
+  Precondition:
+    USBHostPrinterRasterASCII85Start() has been called for the stream.
+
+  Parameters:
+    USB_PRINTER_ASCII85 *state  - Encoder state of the stream
+    const uint8_t *data         - Data to encode
+    uint16_t size               - Number of bytes of data
+    char *out                   - Where to put the characters, at least
+                                    USB_PRINTER_RASTER_ASCII85_MAX(size)
+
+  Returns:
+    The number of characters put in out.  No terminator is added.
+
+  Remarks:
+    None
+  ***************************************************************************/
+uint16_t USBHostPrinterRasterASCII85( USB_PRINTER_ASCII85 *state, const uint8_t *data, uint16_t size, char *out );
+
+/****************************************************************************
+  Function:
+    uint16_t USBHostPrinterRasterASCII85End( USB_PRINTER_ASCII85 *state,
+                char *out )
+
+  Summary:
+    This function ends an ASCII85 stream.
+
+  Description:
+    This function encodes the partial group left in state, if any, and adds
+    the end of data marker "~>".
+
+  Precondition:
+    USBHostPrinterRasterASCII85Start() has been called for the stream.
+
+  Parameters:
+    USB_PRINTER_ASCII85 *state  - Encoder state of the stream
+    char *out                   - Where to put the characters, at least 7
+
+  Returns:
+    The number of characters put in out.  No terminator is added.
+
+  Remarks:
+    None
+  ***************************************************************************/
+uint16_t USBHostPrinterRasterASCII85End( USB_PRINTER_ASCII85 *state, char *out );
+
+/****************************************************************************
+  Function:
+    bool USBHostPrinterRasterBandStart( USB_PRINTER_RASTER_BAND *band,
+                uint16_t width, uint8_t mode, uint16_t bufferSize,
+                uint16_t maxRows )
+
+  Summary:
+    This function sets up the GS v 0 bands of an image.
+
+  Description:
+    This function sets up the GS v 0 bands of an image width dots wide.  A
+    band holds as many rows as fit in bufferSize bytes after the header, but
+    no more than maxRows, and at least one.
+
+  Precondition:
+    band->buffer is NULL.
+
+  Parameters:
+    USB_PRINTER_RASTER_BAND *band   - Band state of the image
+    uint16_t width                  - Width of the image in dots
+    uint8_t mode                    - GS v 0 mode, USB_PRINTER_RASTER_BAND_*
+    uint16_t bufferSize             - Size of a band buffer
+    uint16_t maxRows                - Most rows the printer takes in a block
+
+  Returns:
+    true if the bands were set up, false if width is 0.
+
+  Remarks:
+    A row longer than bufferSize still goes in a band of its own.
+  ***************************************************************************/
+bool USBHostPrinterRasterBandStart( USB_PRINTER_RASTER_BAND *band, uint16_t width, uint8_t mode,
+            uint16_t bufferSize, uint16_t maxRows );
+
+/****************************************************************************
+  Function:
+    uint8_t *USBHostPrinterRasterBandRow( USB_PRINTER_RASTER_BAND *band )
+
+  Summary:
+    This function returns where the next row of the band goes.
+
+  Description:
+    This function returns where the next row of the band goes, rowBytes
+    bytes in band->buffer.  The caller puts the row there, in the polarity
+    of the printer (1 is black), and then calls
+    USBHostPrinterRasterBandAddRow().
+
+  Precondition:
+    band->buffer has been allocated and the band is not full.
+
+  Parameters:
+    USB_PRINTER_RASTER_BAND *band   - Band state of the image
+
+  Returns:
+    Where to put the next row.
+
+  Remarks:
+    None
+  ***************************************************************************/
+uint8_t *USBHostPrinterRasterBandRow( USB_PRINTER_RASTER_BAND *band );
+
+/****************************************************************************
+  Function:
+    bool USBHostPrinterRasterBandAddRow( USB_PRINTER_RASTER_BAND *band,
+                uint16_t size )
+
+  Summary:
+    This function adds the row put at USBHostPrinterRasterBandRow() to the
+    band.
+
+  Description:
+    This function adds the row put at USBHostPrinterRasterBandRow() to the
+    band.  A row of fewer than rowBytes bytes is blank to the end of the
+    image, and the bits of the last byte that are outside the image are
+    cleared, or they would print.
+
+  Precondition:
+    The row has been put at USBHostPrinterRasterBandRow().
+
+  Parameters:
+    USB_PRINTER_RASTER_BAND *band   - Band state of the image
+    uint16_t size                   - Bytes of the row that were put there,
+                                        1 to rowBytes
+
+  Returns:
+    true if the band is full, and should be sent with
+    USBHostPrinterRasterBandEnd().
+
+  Remarks:
+    None
+  ***************************************************************************/
+bool USBHostPrinterRasterBandAddRow( USB_PRINTER_RASTER_BAND *band, uint16_t size );
+
+/****************************************************************************
+  Function:
+    uint8_t *USBHostPrinterRasterBandEnd( USB_PRINTER_RASTER_BAND *band,
+                uint32_t *length )
+
+  Summary:
+    This function ends the band and returns it ready to send.
+
+  Description:
+    This function fills in the GS v 0 header of the band and takes the
+    buffer off the band state, so the next row starts a new band.  The
+    buffer then holds the whole block, header and rows, for one transfer.
+
+  Precondition:
+    The band holds at least one row.
+
+  Parameters:
+    USB_PRINTER_RASTER_BAND *band   - Band state of the image
+    uint32_t *length                - Returns the number of bytes to send
+
+  Returns:
+    The band buffer.  The caller sends it and frees it.
+
+  Remarks:
+    None
+  ***************************************************************************/
+uint8_t *USBHostPrinterRasterBandEnd( USB_PRINTER_RASTER_BAND *band, uint32_t *length );
+
+#endif
@@ -37,8 +37,8 @@
 								// that use EP0 IN or OUT for sending large amounts of
 								// application related data.
 									
-#define USB_MAX_NUM_INT     	3  //Set this number to match the maximum interface number used in the descriptors for this firmware project
-#define USB_MAX_EP_NUMBER	    3   //Set this number to match the maximum endpoint number used in the descriptors for this firmware project
+#define USB_MAX_NUM_INT     	5  //Set this number to match the maximum interface number used in the descriptors for this firmware project
+#define USB_MAX_EP_NUMBER	    4   //Set this number to match the maximum endpoint number used in the descriptors for this firmware project
 
 //Device descriptor - if these two definitions are not defined then
 //  a const USB_DEVICE_DESCRIPTOR variable by the exact name of device_dsc
@@ -74,8 +74,10 @@
 //  is available on the target processor.
 //#define USB_TRANSCEIVER_OPTION USB_EXTERNAL_TRANSCEIVER
 
-//#define USB_SPEED_OPTION USB_FULL_SPEED
-#define USB_SPEED_OPTION USB_LOW_SPEED //(not valid option for PIC24F devices)
+//Full speed: low speed allows neither the bulk CDC and MIDI endpoints nor
+//interrupt packets over 8 bytes.  The clock is 48MHz either way.
+#define USB_SPEED_OPTION USB_FULL_SPEED
+//#define USB_SPEED_OPTION USB_LOW_SPEED //(not valid option for PIC24F devices)
 
 #define MY_VID 0x04D8
 #define MY_PID 0x0055
@@ -139,10 +141,16 @@
 /* HID */
 #define HID_INTF_ID             0x00
 #define HID_EP 					1
-#define HID_INT_OUT_EP_SIZE     1
-#define HID_INT_IN_EP_SIZE      8
+#define HID_INT_OUT_EP_SIZE     2
+#define HID_INT_IN_EP_SIZE      9       // report ID + 8 byte boot keyboard report
 #define HID_NUM_OF_DSC          1
-#define HID_RPT01_SIZE          63
+#define HID_RPT01_SIZE          89
+
+/* The HID interface carries two top-level collections, told apart by the
+ * report ID in the first byte of every report. */
+#define HID_REPORT_ID_KEYBOARD  1
+#define HID_REPORT_ID_JOYSTICK  2
+#define HID_JOYSTICK_REPORT_SIZE    (1 + (2 * ANALOG_CHANNEL_COUNT))
 //#define USER_GET_REPORT_HANDLER USBHIDCBGetReportHandler	
 #define USER_SET_REPORT_HANDLER USBHIDCBSetReportHandler	
 #define USB_DEVICE_HID_IDLE_RATE_CALLBACK(reportID, newIdleRate)    USBHIDCBSetIdleRateHandler(reportID, newIdleRate)
@@ -161,6 +169,13 @@
 
 //#define USB_CDC_SUPPORT_ABSTRACT_CONTROL_MANAGEMENT_CAPABILITIES_D2 //Send_Break command
 #define USB_CDC_SUPPORT_ABSTRACT_CONTROL_MANAGEMENT_CAPABILITIES_D1 //Set_Line_Coding, Set_Control_Line_State, Get_Line_Coding, and Serial_State commands
+
+/* MIDI (Audio class AudioControl + MIDIStreaming) */
+#define MIDI_AC_INTF_ID         0x03
+#define MIDI_MS_INTF_ID         0x04
+#define MIDI_EP                 4
+#define MIDI_IN_EP_SIZE         64      // 16 USB-MIDI events
+#define MIDI_OUT_EP_SIZE        8       // host data is discarded
 /** DEFINITIONS ****************************************************/
 
 #endif //USBCFG_H
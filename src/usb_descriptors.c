@@ -50,9 +50,11 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 // *****************************************************************************
 #include <stdint.h>
 
+#include <io_mapping.h>
 #include <usb/usb.h>
 #include <usb/usb_device_hid.h>
 #include <usb/usb_device_cdc.h>
+#include <usb/usb_device_audio.h>
 
 // *****************************************************************************
 // *****************************************************************************
@@ -90,8 +92,8 @@ const uint8_t configDescriptor1[]={
     /* Configuration Descriptor */
     0x09,//sizeof(USB_CFG_DSC),    // Size of this descriptor in bytes
     USB_DESCRIPTOR_CONFIGURATION,                // CONFIGURATION descriptor type
-    DESC_CONFIG_WORD(0x006B),   // Total length of data for this cfg
-    3,                      // Number of interfaces in this cfg
+    DESC_CONFIG_WORD(0x00CF),   // Total length of data for this cfg
+    5,                      // Number of interfaces in this cfg
     1,                      // Index value of this configuration
     1,                      // Configuration string index
     _DEFAULT,               // Attributes, see usb_device.h
@@ -115,14 +117,14 @@ const uint8_t configDescriptor1[]={
     0x00,                   // Country Code (0x00 for Not supported)
     HID_NUM_OF_DSC,         // Number of class descriptors, see usbcfg.h
     DSC_RPT,                // Report descriptor type
-    DESC_CONFIG_WORD(63),   //sizeof(hid_rpt01),      // Size of the report descriptor
+    DESC_CONFIG_WORD(HID_RPT01_SIZE),   //sizeof(hid_rpt01),      // Size of the report descriptor
     
     /* Endpoint Descriptor */
     0x07,/*sizeof(USB_EP_DSC)*/
     USB_DESCRIPTOR_ENDPOINT,    //Endpoint Descriptor
     HID_EP | _EP_IN,            //EndpointAddress
     _INTERRUPT,                       //Attributes
-    DESC_CONFIG_WORD(8),        //size
+    DESC_CONFIG_WORD(HID_INT_IN_EP_SIZE),   //size
     0x01,                        //Interval
 
     /* Endpoint Descriptor */
@@ -218,6 +220,128 @@ const uint8_t configDescriptor1[]={
     _BULK,                      //Attributes
     DESC_CONFIG_WORD(0x40),     //size
     0x00,                       //Interval
+
+    // IAD ------------------------------------------------------------------------------------------------------------
+
+    // Interface Association Descriptor
+    0x08,                               // Size of this descriptor in bytes
+    0x0B,                               // Interface association descriptor type
+    MIDI_AC_INTF_ID,                    // First associated interface
+    0x02,                               // Number of contiguous associated interfaces
+    AUDIO_DEVICE,                       // bInterfaceClass of the first interface
+    0x00,                               // bInterfaceSubClass of the first interface
+    0x00,                               // bInterfaceProtocol of the first interface
+    0x00,                               // Interface string index
+
+    /* Interface Descriptor for the Audio Control interface */
+    0x09,//sizeof(USB_INTF_DSC),   // Size of this descriptor in bytes
+    USB_DESCRIPTOR_INTERFACE,               // INTERFACE descriptor type
+    MIDI_AC_INTF_ID,        // Interface Number
+    0,                      // Alternate Setting Number
+    0,                      // Number of endpoints in this intf
+    AUDIO_DEVICE,           // Class code
+    AUDIOCONTROL,           // Subclass code
+    0,                      // Protocol code
+    0,                      // Interface string index
+
+    /* Class-specific AC Interface Header Descriptor */
+    0x09,                   // Size of this descriptor in bytes
+    CS_INTERFACE,           // CS_INTERFACE descriptor type
+    0x01,                   // HEADER subtype
+    0x00,0x01,              // ADC release number 1.00
+    0x09,0x00,              // Total size of class-specific descriptors
+    0x01,                   // Number of streaming interfaces
+    MIDI_MS_INTF_ID,        // MIDIStreaming interface belongs to this AC interface
+
+    /* Interface Descriptor for the MIDI Streaming interface */
+    0x09,//sizeof(USB_INTF_DSC),   // Size of this descriptor in bytes
+    USB_DESCRIPTOR_INTERFACE,               // INTERFACE descriptor type
+    MIDI_MS_INTF_ID,        // Interface Number
+    0,                      // Alternate Setting Number
+    2,                      // Number of endpoints in this intf
+    AUDIO_DEVICE,           // Class code
+    MIDISTREAMING,          // Subclass code
+    0,                      // Protocol code
+    0,                      // Interface string index
+
+    /* Class-specific MS Interface Header Descriptor */
+    0x07,                   // Size of this descriptor in bytes
+    CS_INTERFACE,           // CS_INTERFACE descriptor type
+    0x01,                   // MS_HEADER subtype
+    0x00,0x01,              // MIDIStreaming release number 1.00
+    0x41,0x00,              // Total size of class-specific descriptors (incl. endpoints)
+
+    // MIDI IN Jack Descriptor (embedded, host -> device)
+    0x06,                   // Size of this descriptor in bytes
+    CS_INTERFACE,           // CS_INTERFACE descriptor type
+    0x02,                   // MIDI_IN_JACK subtype
+    0x01,                   // EMBEDDED
+    0x01,                   // Jack ID
+    0x00,                   // Jack string index
+
+    // MIDI IN Jack Descriptor (external, the buttons)
+    0x06,                   // Size of this descriptor in bytes
+    CS_INTERFACE,           // CS_INTERFACE descriptor type
+    0x02,                   // MIDI_IN_JACK subtype
+    0x02,                   // EXTERNAL
+    0x02,                   // Jack ID
+    0x00,                   // Jack string index
+
+    // MIDI OUT Jack Descriptor (embedded, device -> host)
+    0x09,                   // Size of this descriptor in bytes
+    CS_INTERFACE,           // CS_INTERFACE descriptor type
+    0x03,                   // MIDI_OUT_JACK subtype
+    0x01,                   // EMBEDDED
+    0x03,                   // Jack ID
+    0x01,                   // Number of input pins
+    0x02,                   // Source jack ID (external IN jack)
+    0x01,                   // Source pin
+    0x00,                   // Jack string index
+
+    // MIDI OUT Jack Descriptor (external, not connected to anything)
+    0x09,                   // Size of this descriptor in bytes
+    CS_INTERFACE,           // CS_INTERFACE descriptor type
+    0x03,                   // MIDI_OUT_JACK subtype
+    0x02,                   // EXTERNAL
+    0x04,                   // Jack ID
+    0x01,                   // Number of input pins
+    0x01,                   // Source jack ID (embedded IN jack)
+    0x01,                   // Source pin
+    0x00,                   // Jack string index
+
+    /* Endpoint Descriptor (Audio class, 9 bytes) */
+    0x09,                       // Size of this descriptor in bytes
+    USB_DESCRIPTOR_ENDPOINT,    //Endpoint Descriptor
+    MIDI_EP | _EP_OUT,          //EndpointAddress
+    _BULK,                      //Attributes
+    DESC_CONFIG_WORD(MIDI_OUT_EP_SIZE), //size
+    0x00,                       //Interval
+    0x00,                       //bRefresh
+    0x00,                       //bSynchAddress
+
+    // Class-specific MS Bulk Data Endpoint Descriptor
+    0x05,                   // Size of this descriptor in bytes
+    CS_ENDPOINT,            // CS_ENDPOINT descriptor type
+    0x01,                   // MS_GENERAL subtype
+    0x01,                   // Number of embedded MIDI IN jacks
+    0x01,                   // Embedded MIDI IN jack ID
+
+    /* Endpoint Descriptor (Audio class, 9 bytes) */
+    0x09,                       // Size of this descriptor in bytes
+    USB_DESCRIPTOR_ENDPOINT,    //Endpoint Descriptor
+    MIDI_EP | _EP_IN,           //EndpointAddress
+    _BULK,                      //Attributes
+    DESC_CONFIG_WORD(MIDI_IN_EP_SIZE),  //size
+    0x00,                       //Interval
+    0x00,                       //bRefresh
+    0x00,                       //bSynchAddress
+
+    // Class-specific MS Bulk Data Endpoint Descriptor
+    0x05,                   // Size of this descriptor in bytes
+    CS_ENDPOINT,            // CS_ENDPOINT descriptor type
+    0x01,                   // MS_GENERAL subtype
+    0x01,                   // Number of embedded MIDI OUT jacks
+    0x03,                   // Embedded MIDI OUT jack ID
 };
 
 //Language code string descriptor
@@ -263,11 +387,12 @@ const struct{uint8_t bLength;uint8_t bDscType;uint16_t string[12];}sd003={
 sizeof(sd003),USB_DESCRIPTOR_STRING,
 {'1','2','3','4','5','6','7','8','9','0','9','9'}};
 
-//Class specific descriptor - HID Keyboard
+//Class specific descriptor - HID Keyboard and Joystick
 const struct{uint8_t report[HID_RPT01_SIZE];}hid_rpt01={
 {   0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
     0x09, 0x06,                    // USAGE (Keyboard)
     0xa1, 0x01,                    // COLLECTION (Application)
+    0x85, HID_REPORT_ID_KEYBOARD,  //   REPORT_ID (1)
     0x05, 0x07,                    //   USAGE_PAGE (Keyboard)
     0x19, 0xe0,                    //   USAGE_MINIMUM (Keyboard LeftControl)
     0x29, 0xe7,                    //   USAGE_MAXIMUM (Keyboard Right GUI)
@@ -296,6 +421,19 @@ const struct{uint8_t report[HID_RPT01_SIZE];}hid_rpt01={
     0x19, 0x00,                    //   USAGE_MINIMUM (Reserved (no event indicated))
     0x29, 0x65,                    //   USAGE_MAXIMUM (Keyboard Application)
     0x81, 0x00,                    //   INPUT (Data,Ary,Abs)
+    0xc0,                          // End Collection
+
+    0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
+    0x09, 0x04,                    // USAGE (Joystick)
+    0xa1, 0x01,                    // COLLECTION (Application)
+    0x85, HID_REPORT_ID_JOYSTICK,  //   REPORT_ID (2)
+    0x19, 0x30,                    //   USAGE_MINIMUM (X)
+    0x29, 0x30 + ANALOG_CHANNEL_COUNT - 1, //   USAGE_MAXIMUM (X, Y, ...)
+    0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+    0x26, 0xff, 0x0f,              //   LOGICAL_MAXIMUM (4095)
+    0x75, 0x10,                    //   REPORT_SIZE (16)
+    0x95, ANALOG_CHANNEL_COUNT,    //   REPORT_COUNT (ANALOG_CHANNEL_COUNT)
+    0x81, 0x02,                    //   INPUT (Data,Var,Abs)
     0xc0}                          // End Collection
 };
 
@@ -658,6 +658,45 @@ bool USBCDCEventHandler(USB_EVENT event, void *pdata, uint16_t size);
   **********************************************************************************/
 uint8_t getsUSBUSART(uint8_t *buffer, uint8_t len);
 
+/******************************************************************************
+    Function:
+        uint8_t *USBUSARTRxBuffer(void)
+
+    Summary:
+        Returns a pointer to the CDC bulk OUT endpoint buffer.
+
+    Description:
+        Received data can be read from this buffer in place, instead of being
+        copied out with getsUSBUSART().  The contents are only valid after
+        USBUSARTRxBufferGetLength() returned a non-zero value, and until
+        USBUSARTRxBufferRelease() is called.
+
+ *****************************************************************************/
+#define USBUSARTRxBuffer()          ((uint8_t*)cdc_data_rx)
+
+/**********************************************************************************
+  Function:
+        uint8_t USBUSARTRxBufferGetLength(void)
+
+  Summary:
+    Returns the number of bytes waiting in USBUSARTRxBuffer(), or 0 if no
+    packet has been received.  The data stays in place until
+    USBUSARTRxBufferRelease() is called.
+
+  **********************************************************************************/
+uint8_t USBUSARTRxBufferGetLength(void);
+
+/**********************************************************************************
+  Function:
+        void USBUSARTRxBufferRelease(void)
+
+  Summary:
+    Hands USBUSARTRxBuffer() back to the USB module so the next packet can be
+    received.
+
+  **********************************************************************************/
+void USBUSARTRxBufferRelease(void);
+
 /******************************************************************************
   Function:
 	void putUSBUSART(char *data, uint8_t length)
@@ -700,6 +739,36 @@ uint8_t getsUSBUSART(uint8_t *buffer, uint8_t len);
  *****************************************************************************/
 void putUSBUSART(uint8_t *data, uint8_t Length);
 
+/******************************************************************************
+    Function:
+        uint8_t *USBUSARTTxBuffer(void)
+
+    Summary:
+        Returns a pointer to the CDC bulk IN endpoint buffer.
+
+    Description:
+        The application can build a packet in this buffer in place and send
+        it with USBUSARTTxBufferSend(), instead of keeping its own copy and
+        calling putUSBUSART().  Only write to the buffer while
+        USBUSARTIsTxTrfReady() returns true.
+
+ *****************************************************************************/
+#define USBUSARTTxBuffer()          ((uint8_t*)cdc_data_tx)
+
+/******************************************************************************
+  Function:
+	void USBUSARTTxBufferSend(uint8_t length)
+
+  Summary:
+    Sends the first 'length' bytes of USBUSARTTxBuffer() to the host without
+    copying them.  'length' is limited to CDC_DATA_IN_EP_SIZE.
+
+  Conditions:
+    USBUSARTIsTxTrfReady() must return true.
+
+ *****************************************************************************/
+void USBUSARTTxBufferSend(uint8_t length);
+
 /******************************************************************************
 	Function:
 		void putsUSBUSART(char *data)
@@ -957,6 +1026,9 @@ extern uint8_t cdc_mem_type;
 extern CDC_NOTICE cdc_notice;
 extern LINE_CODING line_coding;
 
+extern volatile unsigned char cdc_data_tx[CDC_DATA_IN_EP_SIZE];
+extern volatile unsigned char cdc_data_rx[CDC_DATA_OUT_EP_SIZE];
+
 extern volatile CTRL_TRF_SETUP SetupPkt;
 extern const uint8_t configDescriptor1[];
 
@@ -970,7 +1042,10 @@ extern const uint8_t configDescriptor1[];
 //void CDCInitEP(void);
 //bool USBCDCEventHandler(USB_EVENT event, void *pdata, uint16_t size);
 //uint8_t getsUSBUSART(char *buffer, uint8_t len);
+//uint8_t USBUSARTRxBufferGetLength(void);
+//void USBUSARTRxBufferRelease(void);
 //void putUSBUSART(char *data, uint8_t Length);
+//void USBUSARTTxBufferSend(uint8_t length);
 //void putsUSBUSART(char *data);
 //void putrsUSBUSART(const const char *data);
 //void CDCTxService(void);
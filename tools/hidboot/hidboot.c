@@ -0,0 +1,373 @@
+/*
+ * hidboot - upload an application image to the USB HID bootloader
+ *
+ * Usage: hidboot [-t /dev/ttyACMn] [-d /dev/hidrawN] application.hex
+ *
+ *   -t  serial port of the running application; it is sent the CDC
+ *       "enter bootloader" message first, so no button has to be held
+ *   -d  bootloader hidraw device (default: searched by VID/PID)
+ *
+ * The protocol and memory map are described in src/bootloader/bootloader.h.
+ * Row packets are written back to back without waiting for an answer: the
+ * bootloader keeps two OUT buffers armed, so the next row is already on
+ * its way while the previous one is being programmed.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../../src/bootloader/bootloader.h"
+
+#define HIDBOOT_VID             0x04D8
+#define HIDBOOT_PID             0x005F
+#define HIDBOOT_ROW_SIZE        32          /* words, FLASH_ROW_SIZE */
+#define HIDBOOT_TIMEOUT_MS      5000
+
+/* CDC message understood by the application, see src/io_mapping.h */
+#define CDC_TYPE_BOOTLOADER     0x04
+
+#define APP_WORDS   (BOOTLOADER_APP_END_ADDRESS - BOOTLOADER_APP_START_ADDRESS)
+
+static uint8_t image[APP_WORDS * 2];
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static int hex_byte(const char *s)
+{
+    int hi = hex_nibble(s[0]);
+    int lo = hex_nibble(s[1]);
+
+    return (hi < 0 || lo < 0) ? -1 : (hi << 4) | lo;
+}
+
+/* Reads an Intel HEX file (byte addresses, two bytes per word) into image.
+ * Words outside the application area are ignored, except that anything in
+ * the bootloader area means the image was not linked for the bootloader. */
+static int load_hex(const char *path)
+{
+    char line[600];
+    uint32_t base = 0;
+    FILE *f;
+    int lineno = 0;
+
+    for (size_t i = 0; i < sizeof(image); i += 2) {
+        image[i] = 0xFF;
+        image[i + 1] = 0x3F;
+    }
+
+    f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        uint8_t rec[256];
+        int count, type, sum = 0;
+        uint32_t offset;
+
+        lineno++;
+        if (line[0] != ':')
+            continue;
+        count = hex_byte(&line[1]);
+        if (count < 0 || strlen(line) < (size_t)(11 + count * 2))
+            goto bad;
+        for (int i = 0; i < count + 5; i++) {
+            int b = hex_byte(&line[1 + i * 2]);
+            if (b < 0)
+                goto bad;
+            rec[i] = (uint8_t)b;
+            sum += b;
+        }
+        if ((sum & 0xFF) != 0)
+            goto bad;
+
+        offset = ((uint32_t)rec[1] << 8) | rec[2];
+        type = rec[3];
+        if (type == 0x01)
+            break;
+        if (type == 0x04) {
+            base = (((uint32_t)rec[4] << 8) | rec[5]) << 16;
+            continue;
+        }
+        if (type != 0x00)
+            continue;
+
+        for (int i = 0; i < count; i++) {
+            uint32_t byte = base + offset + i;
+            uint32_t word = byte / 2;
+
+            if (word < BOOTLOADER_APP_START_ADDRESS) {
+                fprintf(stderr, "%s: data at 0x%04X, link the application with "
+                        "--codeoffset=0x%X\n", path, (unsigned)word,
+                        BOOTLOADER_APP_START_ADDRESS);
+                fclose(f);
+                return -1;
+            }
+            if (word >= BOOTLOADER_APP_CRC_ADDRESS)
+                continue;   /* CRC, HEF, configuration words */
+            image[(word - BOOTLOADER_APP_START_ADDRESS) * 2 + (byte & 1)] = rec[4 + i];
+        }
+    }
+    fclose(f);
+    return 0;
+
+bad:
+    fprintf(stderr, "%s:%d: bad record\n", path, lineno);
+    fclose(f);
+    return -1;
+}
+
+/* Same CRC as BOOT_ApplicationCRC() over the whole application area. */
+static uint16_t image_crc(void)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (unsigned i = 0; i < (BOOTLOADER_APP_CRC_ADDRESS - BOOTLOADER_APP_START_ADDRESS) * 2; i++) {
+        uint8_t x = (uint8_t)(crc >> 8) ^ image[i];
+        x ^= x >> 4;
+        crc = (uint16_t)((crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x);
+    }
+    return crc;
+}
+
+/* Number of rows to program: trailing erased rows are left to ERASE. */
+static unsigned image_rows(void)
+{
+    unsigned rows = APP_WORDS / HIDBOOT_ROW_SIZE;
+
+    while (rows > 0) {
+        const uint8_t *row = &image[(rows - 1) * HIDBOOT_ROW_SIZE * 2];
+        int blank = 1;
+
+        for (int i = 0; i < HIDBOOT_ROW_SIZE * 2; i += 2)
+            if (row[i] != 0xFF || (row[i + 1] & 0x3F) != 0x3F)
+                blank = 0;
+        if (!blank)
+            break;
+        rows--;
+    }
+    return rows;
+}
+
+static int find_hidraw(char *path, size_t size)
+{
+    char want[32];
+    DIR *dir;
+    struct dirent *ent;
+    int found = 0;
+
+    snprintf(want, sizeof(want), "HID_ID=0003:%08X:%08X", HIDBOOT_VID, HIDBOOT_PID);
+
+    dir = opendir("/sys/class/hidraw");
+    if (dir == NULL)
+        return -1;
+    while (!found && (ent = readdir(dir)) != NULL) {
+        char uevent[300], line[256];
+        FILE *f;
+
+        if (ent->d_name[0] == '.')
+            continue;
+        snprintf(uevent, sizeof(uevent), "/sys/class/hidraw/%s/device/uevent", ent->d_name);
+        f = fopen(uevent, "r");
+        if (f == NULL)
+            continue;
+        while (fgets(line, sizeof(line), f) != NULL)
+            if (strncasecmp(line, want, strlen(want)) == 0)
+                found = 1;
+        fclose(f);
+        if (found)
+            snprintf(path, size, "/dev/%s", ent->d_name);
+    }
+    closedir(dir);
+    return found ? 0 : -1;
+}
+
+static int hid_send(int fd, const uint8_t *packet)
+{
+    uint8_t report[1 + BOOTLOADER_PACKET_SIZE];
+
+    report[0] = 0;  /* no report ID */
+    memcpy(&report[1], packet, BOOTLOADER_PACKET_SIZE);
+    if (write(fd, report, sizeof(report)) != (ssize_t)sizeof(report)) {
+        perror("hidraw write");
+        return -1;
+    }
+    return 0;
+}
+
+static int hid_command(int fd, uint8_t *packet, uint8_t *reply)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    if (hid_send(fd, packet) < 0)
+        return -1;
+    if (poll(&pfd, 1, HIDBOOT_TIMEOUT_MS) != 1) {
+        fprintf(stderr, "no answer to command 0x%02X\n", packet[0]);
+        return -1;
+    }
+    if (read(fd, reply, BOOTLOADER_PACKET_SIZE) <= 1) {
+        perror("hidraw read");
+        return -1;
+    }
+    if (reply[0] != packet[0]) {
+        fprintf(stderr, "unexpected answer 0x%02X to command 0x%02X\n", reply[0], packet[0]);
+        return -1;
+    }
+    return 0;
+}
+
+static void request_bootloader(const char *tty)
+{
+    uint8_t msg[2] = { CDC_TYPE_BOOTLOADER, BOOTLOADER_KEY };
+    struct termios t;
+    int fd;
+
+    fd = open(tty, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(tty);
+        return;
+    }
+    if (tcgetattr(fd, &t) == 0) {
+        cfmakeraw(&t);
+        tcsetattr(fd, TCSANOW, &t);
+    }
+    if (write(fd, msg, sizeof(msg)) != (ssize_t)sizeof(msg))
+        perror(tty);
+    close(fd);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    const char *tty = NULL, *dev = NULL, *hexfile;
+    char devpath[300];
+    uint8_t packet[BOOTLOADER_PACKET_SIZE], reply[BOOTLOADER_PACKET_SIZE];
+    unsigned rows, start, end;
+    uint16_t crc;
+    double t0;
+    int opt, fd;
+
+    while ((opt = getopt(argc, argv, "t:d:")) != -1) {
+        switch (opt) {
+        case 't': tty = optarg; break;
+        case 'd': dev = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-t tty] [-d hidraw] application.hex\n", argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-t tty] [-d hidraw] application.hex\n", argv[0]);
+        return 2;
+    }
+    hexfile = argv[optind];
+
+    if (load_hex(hexfile) < 0)
+        return 1;
+    rows = image_rows();
+    crc = image_crc();
+
+    t0 = now();
+    if (tty != NULL)
+        request_bootloader(tty);
+
+    if (dev == NULL) {
+        /* Wait for the bootloader to enumerate. */
+        while (find_hidraw(devpath, sizeof(devpath)) < 0) {
+            if (now() - t0 > HIDBOOT_TIMEOUT_MS / 1000.0) {
+                fprintf(stderr, "bootloader %04X:%04X not found\n", HIDBOOT_VID, HIDBOOT_PID);
+                return 1;
+            }
+            usleep(100000);
+        }
+        dev = devpath;
+    }
+    fd = open(dev, O_RDWR);
+    if (fd < 0) {
+        perror(dev);
+        return 1;
+    }
+
+    memset(packet, 0, sizeof(packet));
+    packet[0] = BOOTLOADER_CMD_QUERY;
+    if (hid_command(fd, packet, reply) < 0)
+        return 1;
+    start = reply[3] | (reply[4] << 8);
+    end = reply[5] | (reply[6] << 8);
+    if (reply[1] != BOOTLOADER_VERSION || reply[2] != HIDBOOT_ROW_SIZE ||
+        start != BOOTLOADER_APP_START_ADDRESS || end != BOOTLOADER_APP_END_ADDRESS) {
+        fprintf(stderr, "bootloader version %u, area 0x%04X-0x%04X not supported\n",
+                reply[1], start, end);
+        return 1;
+    }
+
+    memset(packet, 0, sizeof(packet));
+    packet[0] = BOOTLOADER_CMD_ERASE;
+    if (hid_command(fd, packet, reply) < 0 || reply[1] != BOOTLOADER_STATUS_OK) {
+        fprintf(stderr, "erase failed\n");
+        return 1;
+    }
+
+    if (rows > 0) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+        memset(packet, 0, sizeof(packet));
+        packet[0] = BOOTLOADER_CMD_PROGRAM;
+        packet[1] = (uint8_t)BOOTLOADER_APP_START_ADDRESS;
+        packet[2] = (uint8_t)(BOOTLOADER_APP_START_ADDRESS >> 8);
+        packet[3] = (uint8_t)rows;
+        if (hid_send(fd, packet) < 0)
+            return 1;
+        for (unsigned r = 0; r < rows; r++)
+            if (hid_send(fd, &image[r * HIDBOOT_ROW_SIZE * 2]) < 0)
+                return 1;
+        if (poll(&pfd, 1, HIDBOOT_TIMEOUT_MS) != 1 ||
+            read(fd, reply, sizeof(reply)) <= 1 ||
+            reply[0] != BOOTLOADER_CMD_PROGRAM || reply[1] != BOOTLOADER_STATUS_OK) {
+            fprintf(stderr, "program failed\n");
+            return 1;
+        }
+    }
+
+    memset(packet, 0, sizeof(packet));
+    packet[0] = BOOTLOADER_CMD_VERIFY;
+    packet[1] = (uint8_t)crc;
+    packet[2] = (uint8_t)(crc >> 8);
+    if (hid_command(fd, packet, reply) < 0 || reply[1] != BOOTLOADER_STATUS_OK) {
+        fprintf(stderr, "verify failed: image CRC 0x%04X, device CRC 0x%04X\n",
+                crc, reply[2] | (reply[3] << 8));
+        return 1;
+    }
+
+    memset(packet, 0, sizeof(packet));
+    packet[0] = BOOTLOADER_CMD_RESET;
+    hid_send(fd, packet);
+    close(fd);
+
+    printf("%s: %u rows, CRC 0x%04X, %.2f s\n", hexfile, rows, crc, now() - t0);
+    return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * pooltest - exhausts the printer buffer pool on Linux.
+ *
+ * Builds usb_host_printer_pool.c on its own, with ASan and UBSan (see the
+ * Makefile), and checks that:
+ *
+ *   - every block can be taken, and is distinct and writable to its size
+ *   - a command that finds no command block is given a row block, and a
+ *     request larger than a row block is always refused
+ *   - USBHostPrinterBufferAvailable() agrees with USBHostPrinterBufferGet()
+ *     for command and row sizes, so USBHostPrinterCommandReady() only makes
+ *     commands wait for a row block inside an image
+ *   - releasing NULL does nothing, releasing a block twice is harmless, and
+ *     a heap buffer is passed to USB_FREE()
+ *   - the statistics count the refusals and the low water marks
+ *
+ * and then takes and releases random sizes for a while, checking that no
+ * block is handed out twice.
+ *
+ *   ./pooltest [operations]
+ *
+ * The exit status is 1 if a check failed.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "usb_config.h"
+#include "usb/usb_host_printer_pool.h"
+
+#define COMMAND_SIZE        USB_PRINTER_POOL_COMMAND_SIZE
+#define COMMAND_BLOCKS      USB_PRINTER_POOL_COMMAND_BLOCKS
+#define ROW_SIZE            USB_PRINTER_POOL_ROW_SIZE
+#define ROW_BLOCKS          USB_PRINTER_POOL_ROW_BLOCKS
+#define ALL_BLOCKS          (COMMAND_BLOCKS + ROW_BLOCKS)
+#define DEFAULT_OPERATIONS  100000
+
+static int      errors;
+static int      heapFrees;
+
+static void Check(int ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("  failed: %s\n", what);
+        errors++;
+    }
+}
+
+void PoolTestFree(void *ptr)
+{
+    heapFrees++;
+    free(ptr);
+}
+
+static uint32_t seed = 1;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+/* A buffer taken from the pool, filled with its own pattern. */
+typedef struct
+{
+    uint8_t     *buffer;
+    uint32_t    size;
+    uint8_t     fill;
+} HELD;
+
+static HELD     held[ALL_BLOCKS];
+static int      heldCount;
+
+static int Take(uint32_t size)
+{
+    uint8_t     *buffer = USBHostPrinterBufferGet(size);
+    int         i;
+
+    if (buffer == NULL)
+        return 0;
+    for (i = 0; i < heldCount; i++)
+        Check(held[i].buffer != buffer, "a block was handed out twice");
+    Check(heldCount < ALL_BLOCKS, "more buffers than blocks");
+    if (heldCount >= ALL_BLOCKS)
+        return 0;
+    held[heldCount].buffer = buffer;
+    held[heldCount].size   = size;
+    held[heldCount].fill   = (uint8_t)(heldCount * 37 + 1);
+    memset(buffer, held[heldCount].fill, size);
+    heldCount++;
+    return 1;
+}
+
+static void Give(int i)
+{
+    uint32_t    n;
+
+    for (n = 0; n < held[i].size; n++)
+    {
+        if (held[i].buffer[n] != held[i].fill)
+        {
+            Check(0, "a block was overwritten while held");
+            break;
+        }
+    }
+    USBHostPrinterBufferRelease(held[i].buffer);
+    held[i] = held[--heldCount];
+}
+
+static void GiveAll(void)
+{
+    while (heldCount != 0)
+        Give(heldCount - 1);
+}
+
+static void Exhaust(void)
+{
+    USB_PRINTER_BUFFER_POOL_STATS   stats;
+    uint8_t                         *heap;
+    uint8_t                         *row;
+    int                             i;
+
+    /* Command blocks first, then commands spill into row blocks. */
+    for (i = 0; i < COMMAND_BLOCKS; i++)
+        Check(Take(COMMAND_SIZE), "a command block was refused");
+    Check(USBHostPrinterBufferAvailable(1), "a small command must find a row block");
+    Check(Take(1), "a command was not given a row block");
+    USBHostPrinterBufferGetStats(&stats);
+    Check((stats.commandFree == 0) && (stats.rowFree == ROW_BLOCKS - 1), "free counts after commands");
+
+    /* The rest of the row blocks; then nothing is left for any size. */
+    for (i = 1; i < ROW_BLOCKS; i++)
+        Check(Take(ROW_SIZE), "a row block was refused");
+    Check(!USBHostPrinterBufferAvailable(1), "an empty pool reported a command buffer");
+    Check(!USBHostPrinterBufferAvailable(ROW_SIZE), "an empty pool reported a row buffer");
+    Check(!Take(1) && !Take(ROW_SIZE), "an empty pool gave a buffer");
+
+    /* One command block back: commands go on, image rows still wait. */
+    Give(0);
+    Check(USBHostPrinterBufferAvailable(COMMAND_SIZE), "a free command block was not reported");
+    Check(!USBHostPrinterBufferAvailable(COMMAND_SIZE + 1), "a command block was offered for a row");
+    Check(!Take(COMMAND_SIZE + 1), "a row was given a command block");
+    Check(Take(COMMAND_SIZE), "the free command block was refused");
+
+    /* One row block back: rows go on, larger requests never do. */
+    for (i = 0; (i < heldCount) && (held[i].size != ROW_SIZE); i++);
+    Give(i);
+    Check(USBHostPrinterBufferAvailable(ROW_SIZE), "a free row block was not reported");
+    Check(!USBHostPrinterBufferAvailable(ROW_SIZE + 1), "a request larger than a row was offered a block");
+    Check(!Take(ROW_SIZE + 1), "a request larger than a row was given a block");
+    Check(Take(ROW_SIZE), "the free row block was refused");
+
+    /* Releases that are not pool blocks in use. */
+    heapFrees = 0;
+    USBHostPrinterBufferRelease(NULL);
+    Check(heapFrees == 0, "NULL was passed to USB_FREE");
+    heap = malloc(ROW_SIZE);
+    USBHostPrinterBufferRelease(heap);
+    Check(heapFrees == 1, "a heap buffer was not passed to USB_FREE");
+
+    row = held[heldCount - 1].buffer;
+    Give(heldCount - 1);
+    USBHostPrinterBufferRelease(row);
+    USBHostPrinterBufferGetStats(&stats);
+    Check((heapFrees == 1) && (stats.rowFree == 1), "a second release of a block changed the pool");
+    Check(Take(ROW_SIZE) && !Take(ROW_SIZE), "a block released twice was handed out twice");
+
+    USBHostPrinterBufferGetStats(&stats);
+    Check((stats.commandBlocks == COMMAND_BLOCKS) && (stats.rowBlocks == ROW_BLOCKS), "block counts");
+    Check((stats.commandLowWater == 0) && (stats.rowLowWater == 0), "low water marks");
+    Check(stats.failures == 5, "refusals");
+    printf("exhaust: %u refusals, low water %u/%u command and %u/%u row blocks\n",
+           (unsigned)stats.failures, stats.commandLowWater, stats.commandBlocks,
+           stats.rowLowWater, stats.rowBlocks);
+
+    GiveAll();
+    USBHostPrinterBufferGetStats(&stats);
+    Check((stats.commandFree == COMMAND_BLOCKS) && (stats.rowFree == ROW_BLOCKS), "blocks lost");
+}
+
+static void Stress(long operations)
+{
+    USB_PRINTER_BUFFER_POOL_STATS   stats;
+    uint32_t                        size;
+    long                            n, taken = 0;
+    int                             available;
+
+    for (n = 0; n < operations; n++)
+    {
+        if ((heldCount != 0) && (Random() % 2))
+        {
+            Give(Random() % heldCount);
+            continue;
+        }
+        switch (Random() % 3)
+        {
+            case 0:     size = 1 + Random() % COMMAND_SIZE;        break;
+            case 1:     size = 1 + Random() % ROW_SIZE;            break;
+            default:    size = ROW_SIZE - 2 + Random() % 4;        break;
+        }
+        available = USBHostPrinterBufferAvailable(size);
+        Check(available == Take(size), "USBHostPrinterBufferAvailable() disagrees with the pool");
+        taken += available;
+
+        USBHostPrinterBufferGetStats(&stats);
+        if (stats.commandFree + stats.rowFree + heldCount != ALL_BLOCKS)
+        {
+            Check(0, "free counts do not match the blocks held");
+            break;
+        }
+    }
+    GiveAll();
+    printf("stress: %ld operations, %ld buffers taken\n", operations, taken);
+}
+
+int main(int argc, char **argv)
+{
+    long    operations = (argc > 1) ? atol(argv[1]) : DEFAULT_OPERATIONS;
+
+    Exhaust();
+    Stress(operations);
+
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
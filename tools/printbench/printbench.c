@@ -0,0 +1,724 @@
+/*
+ * printbench - compares the raster image encodings of the printer language
+ * drivers on Linux.
+ *
+ * Builds usb_host_printer_raster.c on its own and runs a few representative
+ * bitmaps through the old and new USB_PRINTER_IMAGE_DATA paths of the PCL 5
+ * and PostScript drivers.  For PCL 5:
+ *
+ *   plain       each row flipped into a new buffer and sent uncompressed,
+ *               with ESC*b0M ESC*b#W in front, as the driver used to
+ *   compressed  each row flipped into the row buffer and compressed with
+ *               USBHostPrinterRasterCompressRow(), with ESC*b#M only when
+ *               the method changes
+ *
+ * For PostScript:
+ *
+ *   hex         each row as two hexadecimal digits per byte, as the driver
+ *               used to
+ *   rle+a85     each row run length encoded, and the stream in ASCII85;
+ *               the a85 column is ASCII85 alone
+ *
+ * It reports the bytes sent and the encode time per row for each.  Every
+ * compressed row or stream is decoded again the way the printer would and
+ * compared with the original.
+ *
+ * For ESC/POS, each image is collected into GS v 0 bands the way the
+ * driver does, with the USBHostPrinterRasterBand functions, and compared
+ * with 8 dot ESC * slices, a header and a data transfer each.  The bands
+ * are parsed again the way the printer would, and their rows and byte
+ * counts checked.  So are an image whose width is not a multiple of 8 with
+ * some short rows, a band buffer smaller than a row, and a row limit.
+ *
+ *   ./printbench [passes]
+ *
+ * The exit status is 1 if a row did not decode to the original.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <usb/usb_host_printer_raster.h>
+
+#define DEFAULT_PASSES      200
+#define HEADER_SIZE         (5 + 9 + 1)
+#define BAND_SIZE           2048        /* USB_PRINTER_POS_RASTER_BAND_SIZE */
+#define BAND_MAX_ROWS       2047        /* USB_PRINTER_POS_RASTER_MAX_ROWS */
+#define SLICE_HEADER_SIZE   6           /* LF ESC * m nL nH */
+
+typedef struct
+{
+    const char  *name;
+    uint16_t    width;          /* pixels */
+    uint16_t    height;
+    uint8_t     *bits;          /* graphics library polarity, 1 = white */
+} IMAGE;
+
+static uint32_t seed = 1;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+/* ------------------------------------------------------------------------ */
+
+static uint16_t RowBytes(const IMAGE *image)
+{
+    return (image->width + 7) / 8;
+}
+
+static void SetBlack(IMAGE *image, int x, int y)
+{
+    if ((x >= 0) && (x < image->width) && (y >= 0) && (y < image->height))
+        image->bits[y * RowBytes(image) + x / 8] &= ~(0x80 >> (x & 7));
+}
+
+static IMAGE *NewImage(const char *name, uint16_t width, uint16_t height)
+{
+    IMAGE   *image = malloc(sizeof(IMAGE));
+
+    image->name   = name;
+    image->width  = width;
+    image->height = height;
+    image->bits   = malloc((size_t)RowBytes(image) * height);
+    memset(image->bits, 0xFF, (size_t)RowBytes(image) * height);
+    return image;
+}
+
+/* Blocky glyphs, 12x24 dots each, in lines of text. */
+static void DrawText(IMAGE *image, int top, int lines, int charsPerLine)
+{
+    int     line, c, gy, x, y;
+    uint8_t glyph[6];
+
+    for (line = 0; line < lines; line++)
+    {
+        for (c = 0; c < charsPerLine; c++)
+        {
+            if (Random() % 7 == 0)
+                continue;                       /* space */
+            for (gy = 0; gy < 6; gy++)
+                glyph[gy] = Random() & 0x0F;
+            for (y = 0; y < 24; y++)
+                for (x = 0; x < 12; x++)
+                    if ((y < 21) && (glyph[y * 6 / 21] & (1 << (x / 3))))
+                        SetBlack(image, 8 + c * 12 + x, top + line * 28 + y);
+        }
+    }
+}
+
+/* An 80 mm receipt at 203 dpi: logo, text, and a barcode. */
+static IMAGE *Receipt(void)
+{
+    IMAGE   *image = NewImage("receipt 576x800", 576, 800);
+    int     x, y, r;
+
+    for (y = 0; y < 160; y++)
+    {
+        for (x = 0; x < 576; x++)
+        {
+            r = (x - 288) * (x - 288) + (y - 80) * (y - 80);
+            if ((r < 70 * 70) && ((r > 50 * 50) || ((x / 6 + y / 6) & 1)))
+                SetBlack(image, x, y);
+        }
+    }
+    DrawText(image, 180, 16, 46);
+    for (x = 40; x < 536; x += 2 + (Random() % 3) * 2)
+    {
+        int bar = 1 + Random() % 3;
+        for (y = 650; y < 760; y++)
+            for (r = 0; r < bar; r++)
+                SetBlack(image, x + r, y);
+        x += bar;
+    }
+    return image;
+}
+
+/* A 4 inch label at 300 dpi, with an ordered dither gradient. */
+static IMAGE *Label(void)
+{
+    static const uint8_t bayer[4][4] = { { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+    IMAGE   *image = NewImage("label 1200x600", 1200, 600);
+    int     x, y;
+
+    for (x = 0; x < 1200; x++)
+        for (y = 0; y < 10; y++)
+        {
+            SetBlack(image, x, y);
+            SetBlack(image, x, 599 - y);
+        }
+    DrawText(image, 40, 6, 96);
+    for (y = 240; y < 560; y++)
+        for (x = 20; x < 1180; x++)
+            if (bayer[y & 3][x & 3] < (x - 20) * 16 / 1160)
+                SetBlack(image, x, y);
+    return image;
+}
+
+/* Random dots, the worst case for every method. */
+static IMAGE *RandomImage(const char *name, uint16_t width, uint16_t height)
+{
+    IMAGE   *image = NewImage(name, width, height);
+    size_t  i;
+
+    for (i = 0; i < (size_t)RowBytes(image) * image->height; i++)
+        image->bits[i] = (uint8_t)Random();
+    return image;
+}
+
+static IMAGE *Noise(void)
+{
+    return RandomImage("noise 576x200", 576, 200);
+}
+
+/* ------------------------------------------------------------------------ */
+
+static double Now(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* Stands in for the transfer, so the compiler keeps the buffer's contents. */
+static void Send(const void *buffer)
+{
+    __asm__ volatile ("" : : "r" (buffer) : "memory");
+}
+
+/* The driver's old path, one buffer per row. */
+static uint32_t EncodePlain(const IMAGE *image, uint8_t endMask)
+{
+    uint16_t    bytes = RowBytes(image);
+    uint32_t    total = 0;
+    uint16_t    row, i;
+    char        *buffer;
+
+    for (row = 0; row < image->height; row++)
+    {
+        const uint8_t *ptr = &image->bits[row * bytes];
+
+        buffer = malloc(20);
+        sprintf(buffer, "\033*b0M\033*b%dW", bytes);
+        total += strlen(buffer);
+        Send(buffer);
+        free(buffer);
+
+        buffer = malloc(bytes);
+        for (i = 0; i < bytes; i++)
+            buffer[i] = ~(*ptr++);
+        buffer[i - 1] &= endMask;
+        total += bytes;
+        Send(buffer);
+        free(buffer);
+    }
+    return total;
+}
+
+/* Applies one compressed row to the printer's seed row. */
+static int Decode(uint8_t *seedRow, uint16_t bytes, uint8_t method, const uint8_t *data, uint16_t length)
+{
+    uint16_t    n = 0, position = 0, offset, count, i;
+    int8_t      control;
+
+    switch (method)
+    {
+        case USB_PRINTER_RASTER_UNCOMPRESSED:
+            if (length > bytes)
+                return -1;
+            memset(seedRow, 0, bytes);
+            memcpy(seedRow, data, length);
+            return 0;
+
+        case USB_PRINTER_RASTER_PACKBITS:
+            memset(seedRow, 0, bytes);
+            while (n < length)
+            {
+                control = (int8_t)data[n++];
+                if (control >= 0)
+                {
+                    count = control + 1;
+                    if ((n + count > length) || (position + count > bytes))
+                        return -1;
+                    memcpy(&seedRow[position], &data[n], count);
+                    n += count;
+                }
+                else if (control != -128)
+                {
+                    count = 1 - control;
+                    if ((n >= length) || (position + count > bytes))
+                        return -1;
+                    memset(&seedRow[position], data[n++], count);
+                }
+                else
+                    count = 0;
+                position += count;
+            }
+            return 0;
+
+        case USB_PRINTER_RASTER_DELTA_ROW:
+            while (n < length)
+            {
+                count  = (data[n] >> 5) + 1;
+                offset = data[n++] & 0x1F;
+                if (offset == 31)
+                {
+                    do
+                    {
+                        if (n >= length)
+                            return -1;
+                        offset += data[n];
+                    } while (data[n++] == 255);
+                }
+                position += offset;
+                if ((n + count > length) || (position + count > bytes))
+                    return -1;
+                for (i = 0; i < count; i++)
+                    seedRow[position++] = data[n++];
+            }
+            return 0;
+    }
+    return -1;
+}
+
+/* The driver's new path; checks every row when check is set. */
+static uint32_t EncodeCompressed(const IMAGE *image, uint8_t endMask, uint32_t *methods, int check, int *errors)
+{
+    uint16_t    bytes = RowBytes(image);
+    uint32_t    total = 0;
+    uint16_t    row, i, length, commandLength;
+    uint8_t     *rows = malloc(3 * bytes);
+    uint8_t     *current = rows, *previous = rows + bytes, *scratch = rows + 2 * bytes, *swap;
+    uint8_t     *printerSeed = calloc(bytes, 1);
+    uint8_t     method = USB_PRINTER_RASTER_METHOD_UNKNOWN, selected;
+    char        *buffer;
+    char        command[HEADER_SIZE];
+
+    memset(previous, 0, bytes);
+    for (row = 0; row < image->height; row++)
+    {
+        const uint8_t *ptr = &image->bits[row * bytes];
+
+        for (i = 0; i < bytes; i++)
+            current[i] = ~(*ptr++);
+        current[i - 1] &= endMask;
+
+        buffer = malloc(HEADER_SIZE + bytes);
+        selected = method;
+        length = USBHostPrinterRasterCompressRow(current, previous, bytes, &selected,
+                    (uint8_t *)&buffer[HEADER_SIZE], scratch);
+        commandLength = 0;
+        if (selected != method)
+        {
+            commandLength = sprintf(command, "\033*b%dM", selected);
+            method = selected;
+        }
+        commandLength += sprintf(&command[commandLength], "\033*b%dW", length);
+        memcpy(buffer, command, commandLength);
+        memmove(&buffer[commandLength], &buffer[HEADER_SIZE], length);
+        total += commandLength + length;
+        Send(buffer);
+
+        if (methods)
+            methods[method]++;
+        if (check)
+        {
+            if ((length > bytes) ||
+                (Decode(printerSeed, bytes, method, (uint8_t *)&buffer[commandLength], length) != 0) ||
+                (memcmp(printerSeed, current, bytes) != 0))
+            {
+                if (*errors < 5)
+                    printf("  %s: row %u, method %u, does not decode\n", image->name, row, method);
+                (*errors)++;
+            }
+        }
+        free(buffer);
+
+        swap     = previous;
+        previous = current;
+        current  = swap;
+    }
+    free(rows);
+    free(printerSeed);
+    return total;
+}
+
+/* ------------------------------------------------------------------------ */
+
+/* The PostScript driver's old path, a hex digit per nibble. */
+static uint32_t EncodeHex(const IMAGE *image)
+{
+    static const char hex[] = "0123456789abcdef";
+    uint16_t    nibbles = (image->width + 3) / 4;
+    uint32_t    total = 0;
+    uint16_t    row, i;
+    char        *buffer;
+
+    for (row = 0; row < image->height; row++)
+    {
+        const uint8_t *ptr = &image->bits[row * RowBytes(image)];
+
+        buffer = malloc(nibbles + 1);
+        for (i = 0; i < nibbles; i++)
+            buffer[i] = hex[(i & 1) ? (*ptr++ & 0x0F) : (*ptr >> 4)];
+        total += nibbles;
+        Send(buffer);
+        free(buffer);
+    }
+    return total;
+}
+
+/*
+ * The PostScript driver's new path, each row run length encoded and the
+ * stream in ASCII85.  The stream is kept in out, if given, for checking.
+ * Without packing, the rows go straight to ASCII85, to show what that saves
+ * on its own.
+ */
+static uint32_t EncodeASCII85(const IMAGE *image, int pack, char *out)
+{
+    uint16_t            bytes = RowBytes(image);
+    uint32_t            total = 0;
+    uint16_t            row, length, size;
+    uint8_t             *packed = malloc(USB_PRINTER_RASTER_PACKBITS_MAX(bytes));
+    uint8_t             end = USB_PRINTER_RASTER_RLE_END;
+    USB_PRINTER_ASCII85 encoder;
+    char                *buffer;
+
+    USBHostPrinterRasterASCII85Start(&encoder);
+    for (row = 0; row < image->height; row++)
+    {
+        const uint8_t *data = &image->bits[row * bytes];
+
+        length = bytes;
+        if (pack)
+        {
+            length = USBHostPrinterRasterPackBits(data, bytes, packed, USB_PRINTER_RASTER_PACKBITS_MAX(bytes));
+            data   = packed;
+        }
+        buffer = malloc(USB_PRINTER_RASTER_ASCII85_MAX(length) + 1);
+        size = USBHostPrinterRasterASCII85(&encoder, data, length, buffer);
+        buffer[size++] = '\n';
+        if (out)
+            memcpy(&out[total], buffer, size);
+        total += size;
+        Send(buffer);
+        free(buffer);
+    }
+
+    buffer = malloc(16);
+    size = pack ? USBHostPrinterRasterASCII85(&encoder, &end, 1, buffer) : 0;
+    size += USBHostPrinterRasterASCII85End(&encoder, &buffer[size]);
+    if (out)
+        memcpy(&out[total], buffer, size);
+    total += size;
+    free(buffer);
+    free(packed);
+    return total;
+}
+
+/* ASCII85Decode then RunLengthDecode, as the printer would; -1 on error. */
+static long DecodeASCII85(const char *in, uint32_t length, uint8_t *out, uint32_t max)
+{
+    uint8_t     *bytes = malloc(length);
+    uint32_t    n = 0, i = 0, group = 0, digit;
+    int         count = 0, k;
+    long        size = 0;
+    int8_t      control;
+
+    for (;;)
+    {
+        if (i >= length)
+            goto fail;
+        if ((in[i] == '~') && (i + 1 < length) && (in[i + 1] == '>'))
+            break;
+        if ((in[i] == '\n') || (in[i] == ' '))
+        {
+            i++;
+            continue;
+        }
+        if (in[i] == 'z')
+        {
+            if (count)
+                goto fail;
+            memset(&bytes[n], 0, 4);
+            n += 4;
+            i++;
+            continue;
+        }
+        if ((in[i] < '!') || (in[i] > 'u'))
+            goto fail;
+        digit = in[i++] - '!';
+        group = group * 85 + digit;
+        if (++count == 5)
+        {
+            for (k = 3; k >= 0; k--)
+                bytes[n++] = (uint8_t)(group >> (8 * k));
+            group = 0;
+            count = 0;
+        }
+    }
+    if (count == 1)
+        goto fail;
+    if (count)
+    {
+        for (k = count; k < 5; k++)
+            group = group * 85 + 84;
+        for (k = 3; k > 4 - count; k--)
+            bytes[n++] = (uint8_t)(group >> (8 * k));
+    }
+
+    for (i = 0; ; )
+    {
+        if (i >= n)
+            goto fail;
+        control = (int8_t)bytes[i++];
+        if (control == -128)
+            break;
+        if (control >= 0)
+        {
+            if ((i + control + 1 > n) || (size + control + 1 > (long)max))
+                goto fail;
+            memcpy(&out[size], &bytes[i], control + 1);
+            i    += control + 1;
+            size += control + 1;
+        }
+        else
+        {
+            if ((i >= n) || (size + 1 - control > (long)max))
+                goto fail;
+            memset(&out[size], bytes[i++], 1 - control);
+            size += 1 - control;
+        }
+    }
+    free(bytes);
+    return size;
+
+fail:
+    free(bytes);
+    return -1;
+}
+
+/* ------------------------------------------------------------------------ */
+
+/*
+ * Parses a stream of GS v 0 blocks the way the printer would, into page.
+ * Returns the number of rows, or -1 if a block does not have the expected
+ * mode and width, has more than maxRows rows, or runs past the stream.
+ */
+static long DecodeBands(const uint8_t *stream, uint32_t length, uint8_t mode, uint16_t rowBytes,
+                        uint16_t maxRows, uint8_t *page, uint32_t pageRows)
+{
+    uint32_t    n = 0, size;
+    uint16_t    x, y;
+    long        rows = 0;
+
+    while (n < length)
+    {
+        if ((n + USB_PRINTER_RASTER_BAND_HEADER_SIZE > length) ||
+            (stream[n] != 0x1D) || (stream[n + 1] != 'v') || (stream[n + 2] != '0') || (stream[n + 3] != mode))
+            return -1;
+        x = stream[n + 4] | (stream[n + 5] << 8);
+        y = stream[n + 6] | (stream[n + 7] << 8);
+        n += USB_PRINTER_RASTER_BAND_HEADER_SIZE;
+        size = (uint32_t)x * y;
+        if ((x != rowBytes) || (y == 0) || (y > maxRows) || (n + size > length) || (rows + y > (long)pageRows))
+            return -1;
+        memcpy(&page[rows * rowBytes], &stream[n], size);
+        n    += size;
+        rows += y;
+    }
+    return rows;
+}
+
+/*
+ * The ESC/POS driver's raster path.  Each row is flipped into the band,
+ * every shortEvery'th row only half of it, and each full band and the last
+ * one are sent.  The bands are checked against what the driver was given,
+ * and the byte count against the number of bands.  Returns the bytes sent.
+ */
+static uint32_t EncodeBands(const IMAGE *image, uint16_t bandSize, uint16_t maxRows, int shortEvery,
+                            uint32_t *bands, int *errors)
+{
+    USB_PRINTER_RASTER_BAND band;
+    uint16_t    bytes = RowBytes(image);
+    uint8_t     endMask = (uint8_t)(0xFF00 >> (((image->width - 1) & 7) + 1));
+    uint8_t     mode = USB_PRINTER_RASTER_BAND_DOUBLE_WIDTH;
+    uint8_t     *expected = calloc((size_t)bytes * image->height, 1);
+    uint8_t     *page = calloc((size_t)bytes * image->height, 1);
+    uint8_t     *stream = malloc(((size_t)image->height + 1) * (USB_PRINTER_RASTER_BAND_HEADER_SIZE + bytes));
+    uint8_t     *buffer, *out;
+    uint32_t    total = 0, length, fullBands;
+    uint16_t    row, size, i;
+    int         failed = 0;
+
+    *bands = 0;
+    if (!USBHostPrinterRasterBandStart(&band, image->width, mode, bandSize, maxRows) ||
+        (band.rowBytes != bytes) || (band.rows == 0) || (band.rows > maxRows) ||
+        ((band.rows > 1) && (USB_PRINTER_RASTER_BAND_BYTES(&band) > bandSize)))
+        failed = 1;
+
+    for (row = 0; !failed && (row < image->height); row++)
+    {
+        const uint8_t *ptr = &image->bits[row * bytes];
+
+        size = (shortEvery && (row % shortEvery == 0)) ? (bytes + 1) / 2 : bytes;
+        if (band.buffer == NULL)
+            band.buffer = malloc(USB_PRINTER_RASTER_BAND_BYTES(&band));
+        out = USBHostPrinterRasterBandRow(&band);
+        for (i = 0; i < size; i++)
+            out[i] = expected[row * bytes + i] = ~ptr[i];
+        expected[row * bytes + bytes - 1] &= endMask;
+
+        if (USBHostPrinterRasterBandAddRow(&band, size) || (row == image->height - 1))
+        {
+            buffer = USBHostPrinterRasterBandEnd(&band, &length);
+            if ((band.buffer != NULL) || (band.rowCount != 0) ||
+                (length > USB_PRINTER_RASTER_BAND_HEADER_SIZE + (uint32_t)band.rows * bytes))
+                failed = 1;
+            memcpy(&stream[total], buffer, length);
+            total += length;
+            (*bands)++;
+            Send(buffer);
+            free(buffer);
+        }
+    }
+
+    /* Every band but the last is full, and each costs one header. */
+    fullBands = (image->height + band.rows - 1) / band.rows;
+    if (failed || (*bands != fullBands) ||
+        (total != fullBands * USB_PRINTER_RASTER_BAND_HEADER_SIZE + (uint32_t)image->height * bytes) ||
+        (DecodeBands(stream, total, mode, bytes, maxRows, page, image->height) != image->height) ||
+        (memcmp(page, expected, (size_t)bytes * image->height) != 0))
+    {
+        printf("  %s: GS v 0 bands of %u bytes, %u rows at most, are wrong\n", image->name, bandSize, maxRows);
+        (*errors)++;
+    }
+
+    free(expected);
+    free(page);
+    free(stream);
+    return total;
+}
+
+/* ------------------------------------------------------------------------ */
+
+int main(int argc, char **argv)
+{
+    IMAGE       *images[3];
+    int         passes = (argc > 1) ? atoi(argv[1]) : DEFAULT_PASSES;
+    int         errors = 0;
+    int         i, pass;
+    uint8_t     endMask;
+    uint32_t    plainBytes, compressedBytes;
+    uint32_t    methods[4];
+    double      start, plainTime, compressedTime;
+
+    if (passes < 1)
+        passes = 1;
+
+    images[0] = Receipt();
+    images[1] = Label();
+    images[2] = Noise();
+
+    printf("%-18s %10s %10s %7s %10s %10s  %s\n", "image", "plain B", "packed B", "ratio",
+           "plain us", "packed us", "rows none/packbits/delta");
+    for (i = 0; i < 3; i++)
+    {
+        endMask = (uint8_t)(0xFF00 >> (((images[i]->width - 1) & 7) + 1));
+
+        memset(methods, 0, sizeof(methods));
+        plainBytes      = EncodePlain(images[i], endMask);
+        compressedBytes = EncodeCompressed(images[i], endMask, methods, 1, &errors);
+
+        start = Now();
+        for (pass = 0; pass < passes; pass++)
+            EncodePlain(images[i], endMask);
+        plainTime = (Now() - start) / passes / images[i]->height * 1e6;
+
+        start = Now();
+        for (pass = 0; pass < passes; pass++)
+            EncodeCompressed(images[i], endMask, NULL, 0, NULL);
+        compressedTime = (Now() - start) / passes / images[i]->height * 1e6;
+
+        printf("%-18s %10u %10u %6.1f%% %10.3f %10.3f  %u/%u/%u\n", images[i]->name,
+               plainBytes, compressedBytes, 100.0 * compressedBytes / plainBytes,
+               plainTime, compressedTime,
+               methods[USB_PRINTER_RASTER_UNCOMPRESSED], methods[USB_PRINTER_RASTER_PACKBITS],
+               methods[USB_PRINTER_RASTER_DELTA_ROW]);
+    }
+
+    printf("\n%-18s %10s %10s %10s %7s %10s %10s\n", "image", "hex B", "a85 B", "rle+a85 B", "ratio",
+           "hex us", "rle+a85 us");
+    for (i = 0; i < 3; i++)
+    {
+        uint32_t    hexBytes, a85Bytes, rleBytes;
+        uint32_t    imageBytes = (uint32_t)RowBytes(images[i]) * images[i]->height;
+        char        *stream = malloc((USB_PRINTER_RASTER_ASCII85_MAX(USB_PRINTER_RASTER_PACKBITS_MAX(RowBytes(images[i]))) + 1) *
+                                images[i]->height + 16);
+        uint8_t     *decoded = malloc(imageBytes);
+
+        hexBytes = EncodeHex(images[i]);
+        a85Bytes = EncodeASCII85(images[i], 0, NULL);
+        rleBytes = EncodeASCII85(images[i], 1, stream);
+        if ((DecodeASCII85(stream, rleBytes, decoded, imageBytes) != (long)imageBytes) ||
+            (memcmp(decoded, images[i]->bits, imageBytes) != 0))
+        {
+            printf("  %s: PostScript stream does not decode\n", images[i]->name);
+            errors++;
+        }
+        free(stream);
+        free(decoded);
+
+        start = Now();
+        for (pass = 0; pass < passes; pass++)
+            EncodeHex(images[i]);
+        plainTime = (Now() - start) / passes / images[i]->height * 1e6;
+
+        start = Now();
+        for (pass = 0; pass < passes; pass++)
+            EncodeASCII85(images[i], 1, NULL);
+        compressedTime = (Now() - start) / passes / images[i]->height * 1e6;
+
+        printf("%-18s %10u %10u %10u %6.1f%% %10.3f %10.3f\n", images[i]->name,
+               hexBytes, a85Bytes, rleBytes, 100.0 * rleBytes / hexBytes, plainTime, compressedTime);
+    }
+
+    printf("\n%-18s %10s %10s %10s %10s %10s\n", "image", "ESC * B", "transfers", "GS v 0 B", "transfers",
+           "rows/band");
+    for (i = 0; i < 3; i++)
+    {
+        uint32_t    slices = (images[i]->height + 7) / 8;
+        uint32_t    bandBytes, bands;
+
+        bandBytes = EncodeBands(images[i], BAND_SIZE, BAND_MAX_ROWS, 0, &bands, &errors);
+        printf("%-18s %10u %10u %10u %10u %10u\n", images[i]->name,
+               slices * (SLICE_HEADER_SIZE + images[i]->width), 2 * slices, bandBytes, bands,
+               (images[i]->height + bands - 1) / bands);
+    }
+    {
+        IMAGE       *odd = RandomImage("odd 100x50", 100, 50);
+        uint32_t    bands;
+
+        EncodeBands(odd, BAND_SIZE, BAND_MAX_ROWS, 3, &bands, &errors);
+        EncodeBands(odd, 64, BAND_MAX_ROWS, 3, &bands, &errors);
+        EncodeBands(odd, 8, BAND_MAX_ROWS, 0, &bands, &errors);
+        EncodeBands(odd, BAND_SIZE, 7, 0, &bands, &errors);
+        free(odd->bits);
+        free(odd);
+    }
+
+    for (i = 0; i < 3; i++)
+    {
+        free(images[i]->bits);
+        free(images[i]);
+    }
+
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
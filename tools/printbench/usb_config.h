@@ -0,0 +1,18 @@
+/*
+ * usb_config.h for pooltest, see pooltest.c.
+ *
+ * Only the printer buffer pool is built, with its default block sizes.
+ * USB_FREE counts the buffers that USBHostPrinterBufferRelease() passes on
+ * to the heap.
+ */
+
+#ifndef USBCFG_H
+#define USBCFG_H
+
+#define USB_PRINTER_BUFFER_POOL
+
+void PoolTestFree(void *ptr);
+
+#define USB_FREE(ptr)                       PoolTestFree(ptr)
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * Stand-in for the fileio/fileio.h of the MLA file system library, see
+ * usbhostsim.c.  It only has the media information that the SCSI layer,
+ * usb_host_msd_scsi.c, hands to the file system.
+ */
+
+#ifndef FILEIO_H
+#define FILEIO_H
+
+#include <stdint.h>
+
+typedef enum
+{
+    MEDIA_NO_ERROR,                     // No errors
+    MEDIA_DEVICE_NOT_PRESENT,           // The requested device is not present
+    MEDIA_CANNOT_INITIALIZE             // Cannot initialize media
+} FILEIO_MEDIA_ERRORS;
+
+typedef struct
+{
+    FILEIO_MEDIA_ERRORS errorCode;      // The status of the initialization
+    union
+    {
+        uint8_t     value;
+        struct
+        {
+            uint8_t sectorSize  : 1;    // The sector size parameter is valid.
+            uint8_t maxLUN      : 1;    // The max LUN parameter is valid.
+        } bits;
+    } validityFlags;                    // Flags to indicate which parameters are valid
+
+    uint16_t        sectorSize;         // The sector size of the target device.
+    uint8_t         maxLUN;             // The maximum Logical Unit Number of the device.
+} FILEIO_MEDIA_INFORMATION;
+
+#endif /* FILEIO_H */
@@ -0,0 +1,309 @@
+/*
+ * hidfuzz - fuzzes the HID report descriptor parser on Linux.
+ *
+ * Builds usb_host_hid_parser.c on its own (see the Makefile, target hidfuzz,
+ * which also enables AddressSanitizer and UndefinedBehaviorSanitizer) and
+ * feeds _USBHostHID_Parse_Report() mutated copies of a few seed descriptors:
+ * bit flips, random bytes, inserted and deleted bytes, truncation, and
+ * repeated runs that push the item counts past what the tables can index.
+ * Each descriptor is copied into a buffer of exactly its length, so a read
+ * past the end is caught by the sanitizer.
+ *
+ * When a descriptor parses, the parser's tables are checked: every compiled
+ * field lies within its report, the usage index is sorted, and
+ * USBHostHID_FindUsage() agrees with a scan of USBHostHID_HasUsage().
+ *
+ *   ./hidfuzz [iterations] [seed]
+ *
+ * The run is deterministic for a given seed.  The exit status is 1 if a check
+ * failed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "system.h"
+#include "usb_config.h"
+#include <usb/usb.h>
+#include <usb/usb_host_hid_parser.h>
+
+extern USB_HID_RPT_DESC_ERROR _USBHostHID_Parse_Report(uint8_t *, uint16_t, uint16_t, uint8_t);
+extern uint8_t *parsedDataMem;
+
+#define MAX_DESCRIPTOR      4096
+
+/* ------------------------------------------------------------------------ */
+
+static const uint8_t seedKeyboard[] =
+{
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7,
+    0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x95, 0x01,
+    0x75, 0x08, 0x81, 0x01, 0x95, 0x05, 0x75, 0x01, 0x05, 0x08, 0x19, 0x01,
+    0x29, 0x05, 0x91, 0x02, 0x95, 0x01, 0x75, 0x03, 0x91, 0x01, 0x95, 0x06,
+    0x75, 0x08, 0x15, 0x00, 0x25, 0x65, 0x05, 0x07, 0x19, 0x00, 0x29, 0x65,
+    0x81, 0x00, 0xC0
+};
+
+static const uint8_t seedComposite[] =
+{
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x85, 0x01, 0x09, 0x01, 0xA1, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x05, 0x15, 0x00, 0x25, 0x01, 0x95, 0x05,
+    0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x03, 0x81, 0x01, 0x05, 0x01,
+    0x09, 0x30, 0x09, 0x31, 0x09, 0x38, 0x15, 0x81, 0x25, 0x7F, 0x35, 0x00,
+    0x46, 0xE8, 0x03, 0x75, 0x08, 0x95, 0x03, 0x81, 0x06, 0xC0, 0xC0,
+    0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01, 0x85, 0x02, 0x19, 0x00, 0x2A, 0x3C,
+    0x02, 0x15, 0x00, 0x26, 0x3C, 0x02, 0x95, 0x01, 0x75, 0x10, 0x81, 0x00,
+    0x09, 0xE9, 0x09, 0xEA, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x02,
+    0xB1, 0x02, 0x95, 0x06, 0xB1, 0x01, 0xC0
+};
+
+/* Vendor collection with push/pop, string and designator ranges and a long
+   item. */
+static const uint8_t seedVendor[] =
+{
+    0x06, 0x00, 0xFF, 0x09, 0x01, 0xA1, 0x01, 0xA4, 0x15, 0x80, 0x25, 0x7F,
+    0x75, 0x08, 0x95, 0x20, 0x09, 0x02, 0x79, 0x01, 0x89, 0x04, 0x99, 0x07,
+    0x81, 0x02, 0xB4, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x20,
+    0x09, 0x03, 0x39, 0x01, 0x49, 0x02, 0x59, 0x03, 0x91, 0x02,
+    0xFE, 0x02, 0x10, 0xAA, 0xBB,
+    0x09, 0x04, 0x75, 0x20, 0x95, 0x01, 0x17, 0x00, 0x00, 0x00, 0x80, 0x27,
+    0xFF, 0xFF, 0xFF, 0x7F, 0xB1, 0x02, 0xC0
+};
+
+static const struct
+{
+    const uint8_t   *data;
+    uint16_t        length;
+} seeds[] =
+{
+    { seedKeyboard,  sizeof(seedKeyboard)  },
+    { seedComposite, sizeof(seedComposite) },
+    { seedVendor,    sizeof(seedVendor)    },
+};
+
+#define NUM_SEEDS   (sizeof(seeds) / sizeof(seeds[0]))
+
+/* ------------------------------------------------------------------------ */
+
+static uint32_t rng;
+
+static uint32_t Random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static uint16_t Mutate(uint8_t *d, uint16_t length)
+{
+    uint16_t    at;
+    uint16_t    n;
+    uint16_t    from;
+    int         edits = 1 + Random() % 4;
+
+    while (edits-- > 0)
+    {
+        at = (length != 0) ? Random() % length : 0;
+        switch (Random() % 7)
+        {
+            case 0:                             /* flip a bit */
+                if (length != 0)
+                    d[at] ^= 1 << (Random() % 8);
+                break;
+            case 1:                             /* random byte */
+                if (length != 0)
+                    d[at] = Random();
+                break;
+            case 2:                             /* insert a byte */
+                if (length < MAX_DESCRIPTOR)
+                {
+                    memmove(&d[at + 1], &d[at], length - at);
+                    d[at] = Random();
+                    length++;
+                }
+                break;
+            case 3:                             /* delete a byte */
+                if (length != 0)
+                {
+                    memmove(&d[at], &d[at + 1], length - at - 1);
+                    length--;
+                }
+                break;
+            case 4:                             /* truncate */
+                length = at;
+                break;
+            case 5:                             /* repeat a run many times */
+                if (length != 0)
+                {
+                    from = Random() % length;
+                    n = 1 + Random() % 8;
+                    if (from + n > length)
+                        n = length - from;
+                    while (length + n <= MAX_DESCRIPTOR / 2 && (Random() % 64) != 0)
+                    {
+                        memmove(&d[at + n], &d[at], length - at);
+                        memmove(&d[at], &d[from < at ? from : from + n], n);
+                        length += n;
+                    }
+                }
+                break;
+            default:                            /* small integer in a data byte */
+                if (length != 0)
+                    d[at] = (uint8_t)(Random() % 3 == 0 ? 0x00 : Random() % 3 == 0 ? 0xFF : Random() % 40);
+                break;
+        }
+    }
+    return length;
+}
+
+/* ------------------------------------------------------------------------ */
+
+static unsigned failures;
+
+static void Fail(const char *what, const uint8_t *d, uint16_t length)
+{
+    uint16_t    i;
+
+    if (failures++ < 10)
+    {
+        printf("check failed: %s\n  descriptor (%u bytes):", what, length);
+        for (i = 0; i < length && i < 64; i++)
+            printf(" %02X", d[i]);
+        printf("%s\n", (length > 64) ? " ..." : "");
+    }
+}
+
+static void Check(const uint8_t *d, uint16_t length)
+{
+    HID_REPORT      *report;
+    HID_FIELD       *field;
+    HID_USAGEINDEX  *index;
+    uint16_t        bits[hidReportUnknown];
+    uint16_t        usage;
+    uint16_t        page;
+    uint16_t        found;
+    uint16_t        scanned;
+    uint8_t         item;
+    uint8_t         count;
+    uint8_t         r;
+    uint8_t         t;
+    uint8_t         f;
+    uint8_t         i;
+    int             k;
+    bool            hit;
+    bool            scanHit;
+
+    for (r = 0; r < deviceRptInfo.reports; r++)
+    {
+        report = &itemListPtrs.reportList[r];
+        bits[hidReportInput] = report->inputBits;
+        bits[hidReportOutput] = report->outputBits;
+        bits[hidReportFeature] = report->featureBits;
+        for (t = hidReportInput; t < hidReportUnknown; t++)
+        {
+            if ((uint16_t)report->firstField[t] + report->fields[t] > deviceRptInfo.fields)
+            {
+                Fail("field range of a report", d, length);
+                return;
+            }
+            for (f = 0; f < report->fields[t]; f++)
+            {
+                field = &itemListPtrs.fieldList[report->firstField[t] + f];
+                if ((uint32_t)field->bitOffset + (uint32_t)field->bitLength * field->count > bits[t])
+                    Fail("field outside its report", d, length);
+            }
+        }
+    }
+
+    for (i = 1; i < deviceRptInfo.usageIndexes; i++)
+    {
+        index = &itemListPtrs.usageIndex[i];
+        if ((index[-1].reportType > index->reportType) ||
+            ((index[-1].reportType == index->reportType) && ((index[-1].usagePage > index->usagePage) ||
+            ((index[-1].usagePage == index->usagePage) && (index[-1].usageMinimum > index->usageMinimum)))))
+            Fail("usage index order", d, length);
+    }
+
+    for (k = 0; k < 16; k++)
+    {
+        t = Random() % hidReportUnknown;
+        if ((deviceRptInfo.usageIndexes != 0) && (Random() % 4 != 0))
+        {
+            index = &itemListPtrs.usageIndex[Random() % deviceRptInfo.usageIndexes];
+            page = (Random() % 8 == 0) ? 0 : index->usagePage;
+            usage = index->usageMinimum + Random() % 3;
+        }
+        else
+        {
+            page = Random() % 16;
+            usage = Random() % 256;
+        }
+
+        hit = USBHostHID_FindUsage(page, usage, t, 0, &item, &found);
+        scanHit = false;
+        for (i = 0; (i < deviceRptInfo.reportItems) && !scanHit; i++)
+        {
+            if ((itemListPtrs.reportItemList[i].reportType == t) &&
+                USBHostHID_HasUsage(&itemListPtrs.reportItemList[i], page, usage, &scanned, &count))
+            {
+                scanHit = true;
+                if (!hit || (item != i) || (found != scanned))
+                    Fail("usage index lookup", d, length);
+            }
+        }
+        if (hit && !scanHit)
+            Fail("usage index lookup", d, length);
+    }
+}
+
+/* ------------------------------------------------------------------------ */
+
+int main(int argc, char **argv)
+{
+    static uint8_t  work[MAX_DESCRIPTOR];
+    unsigned long   iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+    unsigned long   parsed = 0;
+    unsigned long   errors[32] = { 0 };
+    unsigned long   n;
+    uint16_t        length;
+    uint8_t         *buffer;
+    int             error;
+    int             i;
+
+    rng = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 1;
+    if (rng == 0)
+        rng = 1;
+
+    for (n = 0; n < iterations; n++)
+    {
+        i = (n < NUM_SEEDS) ? (int)n : (int)(Random() % NUM_SEEDS);
+        memcpy(work, seeds[i].data, seeds[i].length);
+        length = (n < NUM_SEEDS) ? seeds[i].length : Mutate(work, seeds[i].length);
+
+        buffer = malloc(length != 0 ? length : 1);
+        memcpy(buffer, work, length);
+        error = _USBHostHID_Parse_Report(buffer, length, 10, 0);
+        if (error == HID_ERR)
+        {
+            parsed++;
+            Check(buffer, length);
+        }
+        else
+        {
+            errors[error & 31]++;
+        }
+        free(buffer);
+    }
+    if (parsedDataMem != NULL)
+        free(parsedDataMem);
+
+    printf("hidfuzz: %lu descriptors, %lu parsed, %u checks failed\n", iterations, parsed, failures);
+    printf("         rejected:");
+    for (i = 0; i < 32; i++)
+        if (errors[i] != 0)
+            printf(" %d:%lu", i, errors[i]);
+    printf("\n");
+    return (failures != 0) ? 1 : 0;
+}
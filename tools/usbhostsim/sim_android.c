@@ -0,0 +1,148 @@
+/*
+ * Android accessory model for the simulated host controller.
+ *
+ * The device is already in accessory mode (Google VID, accessory PID), so
+ * the host skips the accessory start sequence.  It accepts the AOA HID
+ * requests: REGISTER_HID and SET_HID_REPORT_DESC are acknowledged, and
+ * every SEND_HID_EVENT is recorded with its id and report so a scenario can
+ * check what reached the phone.  The bulk endpoints always NAK.
+ */
+
+#include <string.h>
+
+#include "sim_devices.h"
+
+#define ACCESSORY_PACKET_SIZE   64
+#define ACCESSORY_EP_DATA       1
+
+#define AOA_REGISTER_HID        54
+#define AOA_SET_HID_REPORT_DESC 56
+#define AOA_SEND_HID_EVENT      57
+
+static const uint8_t accessoryDeviceDescriptor[] =
+{
+    18, USB_DESCRIPTOR_DEVICE,
+    0x00, 0x02,                         /* USB 2.0 */
+    0x00, 0x00, 0x00,                   /* class defined by the interface */
+    64,                                 /* EP0 max packet size */
+    0xD1, 0x18, 0x01, 0x2D,             /* Google, accessory + ADB */
+    0x00, 0x01,                         /* device release */
+    1, 2, 0,                            /* strings */
+    1                                   /* configurations */
+};
+
+static const uint8_t accessoryConfigurationDescriptor[] =
+{
+    9, USB_DESCRIPTOR_CONFIGURATION,
+    32, 0,                              /* total length */
+    1, 1, 0,                            /* interfaces, value, string */
+    0x80, 250,                          /* bus powered, 500 mA */
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    0, 0, 2,                            /* number, alternate, endpoints */
+    0xFF, 0xFF, 0,                      /* accessory interface */
+    0,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x80 | ACCESSORY_EP_DATA, 0x02,     /* bulk IN */
+    ACCESSORY_PACKET_SIZE, 0,
+    0,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    ACCESSORY_EP_DATA, 0x02,            /* bulk OUT */
+    ACCESSORY_PACKET_SIZE, 0,
+    0
+};
+
+static const uint8_t accessoryString0[] = { 4, USB_DESCRIPTOR_STRING, 0x09, 0x04 };
+static const uint8_t accessoryString1[] = { 8, USB_DESCRIPTOR_STRING, 'S', 0, 'i', 0, 'm', 0 };
+static const uint8_t accessoryString2[] = { 12, USB_DESCRIPTOR_STRING, 'P', 0, 'h', 0, 'o', 0, 'n', 0, 'e', 0 };
+
+static const uint8_t * const accessoryStrings[] = { accessoryString0, accessoryString1, accessoryString2 };
+
+static struct
+{
+    SIM_HID_EVENT   events[SIM_ACCESSORY_EVENTS];
+    uint16_t        count;
+    uint8_t         registered;         /* bit n: HID id n has a report descriptor */
+} accessory;
+
+static void AccessoryReset(void *context)
+{
+    (void)context;
+    memset(&accessory, 0, sizeof(accessory));
+}
+
+static int16_t AccessoryRequest(void *context, const USB_SIM_SETUP_PACKET *setup, uint8_t *data)
+{
+    SIM_HID_EVENT   *event;
+
+    (void)context;
+
+    if ((setup->bmRequestType & 0x60) == USB_SETUP_TYPE_STANDARD)
+        return (setup->bRequest == USB_REQUEST_CLEAR_FEATURE) ? USB_SIM_ACK : USB_SIM_STALL;
+
+    switch (setup->bRequest)
+    {
+        case AOA_REGISTER_HID:
+            return USB_SIM_ACK;
+        case AOA_SET_HID_REPORT_DESC:
+            if (setup->wValue < 8)
+                accessory.registered |= 1u << setup->wValue;
+            return USB_SIM_ACK;
+        case AOA_SEND_HID_EVENT:
+            if ((setup->wValue >= 8) || !(accessory.registered & (1u << setup->wValue)) ||
+                (setup->wLength > sizeof(event->report)))
+                return USB_SIM_STALL;
+            if (accessory.count < SIM_ACCESSORY_EVENTS)
+            {
+                event = &accessory.events[accessory.count++];
+                event->id     = (uint8_t)setup->wValue;
+                event->length = (uint8_t)setup->wLength;
+                memcpy(event->report, data, setup->wLength);
+            }
+            return USB_SIM_ACK;
+        default:
+            return USB_SIM_STALL;
+    }
+}
+
+static int16_t AccessoryIn(void *context, uint8_t endpoint, uint8_t *data, uint16_t maxSize)
+{
+    (void)context;
+    (void)endpoint;
+    (void)data;
+    (void)maxSize;
+    return USB_SIM_NAK;
+}
+
+static int16_t AccessoryOut(void *context, uint8_t endpoint, const uint8_t *data, uint16_t size)
+{
+    (void)context;
+    (void)endpoint;
+    (void)data;
+    (void)size;
+    return USB_SIM_NAK;
+}
+
+USB_SIM_DEVICE simAccessory =
+{
+    "accessory",
+    false,
+    accessoryDeviceDescriptor,
+    accessoryConfigurationDescriptor,
+    accessoryStrings,
+    sizeof(accessoryStrings) / sizeof(accessoryStrings[0]),
+    AccessoryReset,
+    AccessoryRequest,
+    AccessoryIn,
+    AccessoryOut,
+    NULL,
+    NULL
+};
+
+const SIM_HID_EVENT *SimAccessoryEvents(uint16_t *count)
+{
+    *count = accessory.count;
+    return accessory.events;
+}
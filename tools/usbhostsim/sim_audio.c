@@ -0,0 +1,187 @@
+/*
+ * USB Audio 1.0 microphone model for the simulated host controller.
+ *
+ * One mono 16 bit channel on an isochronous IN endpoint.  The samples are a
+ * running counter, so the host can check that none were lost or repeated.
+ * At each start of frame the samples of the last millisecond become the
+ * packet for the new frame; a packet the host did not read in its frame is
+ * lost, as it is on a real device.  The sampling frequency is set with
+ * SET_CUR on the endpoint and defaults to 48 kHz.  The device's clock can
+ * be made to run fast or slow against the host's frame clock with
+ * SimMicrophoneSetDrift().
+ */
+
+#include <string.h>
+
+#include "sim_devices.h"
+
+#define MIC_EP_STREAM           1
+#define MIC_PACKET_SIZE         100             /* room for 50 samples */
+#define MIC_DEFAULT_RATE        48000ul
+
+static const uint8_t micDeviceDescriptor[] =
+{
+    18, USB_DESCRIPTOR_DEVICE,
+    0x00, 0x02,                         /* USB 2.0 */
+    0x00, 0x00, 0x00,                   /* class defined by the interface */
+    64,                                 /* EP0 max packet size */
+    0xD8, 0x04, 0x04, 0xF0,             /* VID/PID */
+    0x00, 0x01,                         /* device release */
+    1, 2, 0,                            /* strings */
+    1                                   /* configurations */
+};
+
+static const uint8_t micConfigurationDescriptor[] =
+{
+    9, USB_DESCRIPTOR_CONFIGURATION,
+    100, 0,                             /* total length */
+    2, 1, 0,                            /* interfaces, value, string */
+    0x80, 50,                           /* bus powered, 100 mA */
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    0, 0, 0,                            /* number, alternate, endpoints */
+    1, 1, 0,                            /* audio control */
+    0,
+
+    9, 0x24, 0x01, 0x00, 0x01,          /* header, ADC 1.00 */
+    30, 0,                              /* class specific length */
+    1, 1,                               /* one streaming interface, 1 */
+    12, 0x24, 0x02, 1,                  /* input terminal 1 */
+    0x01, 0x02, 0,                      /* microphone */
+    1, 0x00, 0x00, 0, 0,                /* mono */
+    9, 0x24, 0x03, 2,                   /* output terminal 2 */
+    0x01, 0x01, 0,                      /* USB streaming */
+    1, 0,                               /* source terminal 1 */
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    1, 0, 0,                            /* number, alternate, endpoints */
+    1, 2, 0,                            /* audio streaming, zero bandwidth */
+    0,
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    1, 1, 1,                            /* number, alternate, endpoints */
+    1, 2, 0,                            /* audio streaming */
+    0,
+
+    7, 0x24, 0x01, 2, 1, 0x01, 0x00,    /* general, terminal 2, PCM */
+    11, 0x24, 0x02, 1,                  /* format type I */
+    1, 2, 16,                           /* mono, 2 bytes, 16 bits */
+    1, 0x80, 0xBB, 0x00,                /* 48000 Hz */
+
+    9, USB_DESCRIPTOR_ENDPOINT,
+    0x80 | MIC_EP_STREAM, 0x05,         /* isochronous IN, asynchronous */
+    MIC_PACKET_SIZE, 0,
+    1, 0, 0,                            /* every frame */
+
+    7, 0x25, 0x01, 0x01, 0, 0, 0        /* sampling frequency control */
+};
+
+static const uint8_t micString0[] = { 4, USB_DESCRIPTOR_STRING, 0x09, 0x04 };
+static const uint8_t micString1[] = { 8, USB_DESCRIPTOR_STRING, 'S', 0, 'i', 0, 'm', 0 };
+static const uint8_t micString2[] = { 22, USB_DESCRIPTOR_STRING, 'M', 0, 'i', 0, 'c', 0, 'r', 0, 'o', 0, 'p', 0, 'h', 0, 'o', 0, 'n', 0, 'e', 0 };
+
+static const uint8_t * const micStrings[] = { micString0, micString1, micString2 };
+
+static int32_t  micDrift;       /* ppm, kept over resets */
+
+static struct
+{
+    uint32_t    rate;           /* sampling frequency, Hz */
+    uint64_t    fraction;       /* samples * 10^9 not yet in a packet */
+    uint32_t    next;           /* first sample of the next packet */
+    uint32_t    packetStart;    /* first sample of the packet for this frame */
+    uint16_t    packetSamples;
+    bool        packetReady;
+} mic;
+
+static void MicReset(void *context)
+{
+    (void)context;
+    memset(&mic, 0, sizeof(mic));
+    mic.rate = MIC_DEFAULT_RATE;
+}
+
+static int16_t MicRequest(void *context, const USB_SIM_SETUP_PACKET *setup, uint8_t *data)
+{
+    (void)context;
+
+    if (((setup->bmRequestType & 0x60) != USB_SETUP_TYPE_CLASS) || (setup->wValue != 0x0100))
+        return USB_SIM_STALL;
+
+    switch (setup->bRequest)
+    {
+        case 0x01:                              /* SET_CUR sampling frequency */
+            mic.rate = (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16);
+            return USB_SIM_ACK;
+        case 0x81:                              /* GET_CUR sampling frequency */
+            data[0] = (uint8_t)mic.rate;
+            data[1] = (uint8_t)(mic.rate >> 8);
+            data[2] = (uint8_t)(mic.rate >> 16);
+            return 3;
+        default:
+            return USB_SIM_STALL;
+    }
+}
+
+static int16_t MicIn(void *context, uint8_t endpoint, uint8_t *data, uint16_t maxSize)
+{
+    uint16_t    i;
+    uint16_t    size;
+
+    (void)context;
+
+    if (endpoint != MIC_EP_STREAM)
+        return USB_SIM_STALL;
+    if (!mic.packetReady)
+        return USB_SIM_NAK;
+
+    size = mic.packetSamples * 2;
+    if (size > maxSize)
+        size = maxSize & ~1;
+    for (i = 0; i < size / 2; i++)
+    {
+        data[2 * i]     = (uint8_t)(mic.packetStart + i);
+        data[2 * i + 1] = (uint8_t)((mic.packetStart + i) >> 8);
+    }
+    mic.packetReady = false;
+    return size;
+}
+
+static void MicFrame(void *context, uint32_t frameNumber)
+{
+    (void)context;
+    (void)frameNumber;
+
+    mic.fraction         += (uint64_t)mic.rate * (1000000 + micDrift);
+    mic.packetSamples     = mic.fraction / 1000000000ull;
+    mic.fraction         -= mic.packetSamples * 1000000000ull;
+    mic.packetStart       = mic.next;
+    mic.next             += mic.packetSamples;
+    mic.packetReady       = true;
+}
+
+USB_SIM_DEVICE simMicrophone =
+{
+    "microphone",
+    false,
+    micDeviceDescriptor,
+    micConfigurationDescriptor,
+    micStrings,
+    sizeof(micStrings) / sizeof(micStrings[0]),
+    MicReset,
+    MicRequest,
+    MicIn,
+    NULL,
+    MicFrame,
+    NULL
+};
+
+uint32_t SimMicrophoneSamples(void)
+{
+    return mic.next;
+}
+
+void SimMicrophoneSetDrift(int32_t ppm)
+{
+    micDrift = ppm;
+}
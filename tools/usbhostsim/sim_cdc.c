@@ -0,0 +1,200 @@
+/*
+ * CDC ACM loopback model for the simulated host controller.
+ *
+ * Everything written to the bulk OUT endpoint is queued in a FIFO and read
+ * back from the bulk IN endpoint.  The OUT endpoint NAKs while the FIFO is
+ * full and the IN endpoint NAKs while it is empty.  The line coding and
+ * control line state requests are stored and answered; the notification
+ * endpoint always NAKs.  SimSerialCapture() makes the OUT endpoint store
+ * into a buffer instead, so the host can send without waiting for the
+ * loopback data to be read.
+ */
+
+#include <string.h>
+
+#include "sim_devices.h"
+
+#define SERIAL_PACKET_SIZE      64
+#define SERIAL_EP_NOTIFY        1
+#define SERIAL_EP_DATA          2
+
+static const uint8_t serialDeviceDescriptor[] =
+{
+    18, USB_DESCRIPTOR_DEVICE,
+    0x00, 0x02,                         /* USB 2.0 */
+    0x00, 0x00, 0x00,                   /* class defined by the interface */
+    64,                                 /* EP0 max packet size */
+    0xD8, 0x04, 0x03, 0xF0,             /* VID/PID */
+    0x00, 0x01,                         /* device release */
+    1, 2, 0,                            /* strings */
+    1                                   /* configurations */
+};
+
+static const uint8_t serialConfigurationDescriptor[] =
+{
+    9, USB_DESCRIPTOR_CONFIGURATION,
+    67, 0,                              /* total length */
+    2, 1, 0,                            /* interfaces, value, string */
+    0x80, 50,                           /* bus powered, 100 mA */
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    0, 0, 1,                            /* number, alternate, endpoints */
+    2, 2, 1,                            /* CDC, ACM, AT commands */
+    0,
+
+    5, 0x24, 0x00, 0x10, 0x01,          /* header, CDC 1.10 */
+    5, 0x24, 0x01, 0x00, 1,             /* call management, data interface */
+    4, 0x24, 0x02, 0x02,                /* ACM, line coding and serial state */
+    5, 0x24, 0x06, 0, 1,                /* union, master 0, slave 1 */
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x80 | SERIAL_EP_NOTIFY, 0x03,      /* interrupt IN */
+    8, 0,
+    2,
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    1, 0, 2,                            /* number, alternate, endpoints */
+    0x0A, 0, 0,                         /* CDC data */
+    0,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    SERIAL_EP_DATA, 0x02,               /* bulk OUT */
+    SERIAL_PACKET_SIZE, 0,
+    0,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x80 | SERIAL_EP_DATA, 0x02,        /* bulk IN */
+    SERIAL_PACKET_SIZE, 0,
+    0
+};
+
+static const uint8_t serialString0[] = { 4, USB_DESCRIPTOR_STRING, 0x09, 0x04 };
+static const uint8_t serialString1[] = { 8, USB_DESCRIPTOR_STRING, 'S', 0, 'i', 0, 'm', 0 };
+static const uint8_t serialString2[] = { 18, USB_DESCRIPTOR_STRING, 'L', 0, 'o', 0, 'o', 0, 'p', 0, 'b', 0, 'a', 0, 'c', 0, 'k', 0 };
+
+static const uint8_t * const serialStrings[] = { serialString0, serialString1, serialString2 };
+
+static struct
+{
+    uint8_t     lineCoding[7];
+    uint16_t    lineState;
+    uint8_t     fifo[SIM_SERIAL_FIFO_SIZE];
+    uint16_t    head;           /* next byte to read */
+    uint16_t    count;
+    uint8_t     *capture;       /* OUT data goes here instead of the FIFO */
+    uint32_t    captureSize;
+    uint32_t    captured;
+} serial;
+
+static void SerialReset(void *context)
+{
+    static const uint8_t defaultCoding[7] = { 0x80, 0x25, 0, 0, 0, 0, 8 };     /* 9600 8N1 */
+
+    (void)context;
+    memcpy(serial.lineCoding, defaultCoding, sizeof(defaultCoding));
+    serial.lineState = 0;
+    serial.head      = 0;
+    serial.count     = 0;
+}
+
+static int16_t SerialRequest(void *context, const USB_SIM_SETUP_PACKET *setup, uint8_t *data)
+{
+    (void)context;
+
+    if ((setup->bmRequestType & 0x60) == USB_SETUP_TYPE_STANDARD)
+        return (setup->bRequest == USB_REQUEST_CLEAR_FEATURE) ? USB_SIM_ACK : USB_SIM_STALL;
+
+    switch (setup->bRequest)
+    {
+        case 0x20:                              /* SET_LINE_CODING */
+            memcpy(serial.lineCoding, data, sizeof(serial.lineCoding));
+            return USB_SIM_ACK;
+        case 0x21:                              /* GET_LINE_CODING */
+            memcpy(data, serial.lineCoding, sizeof(serial.lineCoding));
+            return sizeof(serial.lineCoding);
+        case 0x22:                              /* SET_CONTROL_LINE_STATE */
+            serial.lineState = setup->wValue;
+            return USB_SIM_ACK;
+        default:
+            return USB_SIM_STALL;
+    }
+}
+
+static int16_t SerialIn(void *context, uint8_t endpoint, uint8_t *data, uint16_t maxSize)
+{
+    uint16_t    size;
+    uint16_t    i;
+
+    (void)context;
+
+    if ((endpoint != SERIAL_EP_DATA) || (serial.count == 0))
+        return USB_SIM_NAK;
+
+    size = (serial.count < maxSize) ? serial.count : maxSize;
+    for (i = 0; i < size; i++)
+    {
+        data[i]     = serial.fifo[serial.head];
+        serial.head = (serial.head + 1) % SIM_SERIAL_FIFO_SIZE;
+    }
+    serial.count -= size;
+    return size;
+}
+
+static int16_t SerialOut(void *context, uint8_t endpoint, const uint8_t *data, uint16_t size)
+{
+    uint16_t    i;
+
+    (void)context;
+
+    if (endpoint != SERIAL_EP_DATA)
+        return USB_SIM_STALL;
+    if (serial.capture != NULL)
+    {
+        if (serial.captured + size > serial.captureSize)
+            return USB_SIM_NAK;
+        memcpy(&serial.capture[serial.captured], data, size);
+        serial.captured += size;
+        return USB_SIM_ACK;
+    }
+    if (serial.count + size > SIM_SERIAL_FIFO_SIZE)
+        return USB_SIM_NAK;
+
+    for (i = 0; i < size; i++)
+        serial.fifo[(serial.head + serial.count + i) % SIM_SERIAL_FIFO_SIZE] = data[i];
+    serial.count += size;
+    return USB_SIM_ACK;
+}
+
+USB_SIM_DEVICE simSerial =
+{
+    "serial",
+    false,
+    serialDeviceDescriptor,
+    serialConfigurationDescriptor,
+    serialStrings,
+    sizeof(serialStrings) / sizeof(serialStrings[0]),
+    SerialReset,
+    SerialRequest,
+    SerialIn,
+    SerialOut,
+    NULL,
+    NULL
+};
+
+uint32_t SimSerialLineRate(void)
+{
+    return (uint32_t)serial.lineCoding[0] | ((uint32_t)serial.lineCoding[1] << 8) |
+           ((uint32_t)serial.lineCoding[2] << 16) | ((uint32_t)serial.lineCoding[3] << 24);
+}
+
+void SimSerialCapture(uint8_t *buffer, uint32_t size)
+{
+    serial.capture     = buffer;
+    serial.captureSize = size;
+    serial.captured    = 0;
+}
+
+uint32_t SimSerialCaptured(void)
+{
+    return serial.captured;
+}
@@ -0,0 +1,201 @@
+/*
+ * Composite audio, HID and CDC device model for the simulated host
+ * controller.
+ *
+ * The device has six interfaces: audio control, a microphone and a speaker
+ * streaming interface with two bandwidth settings each, a HID interface with
+ * interrupt IN and OUT endpoints, and a CDC ACM pair.  It only exists to
+ * give the host a long interface and endpoint list; it has no class
+ * behaviour, and every data endpoint NAKs.  It is matched by VID/PID, so all
+ * of its interfaces go to one client driver, see usb_config.c.
+ */
+
+#include "sim_devices.h"
+
+static const uint8_t compositeDeviceDescriptor[] =
+{
+    18, USB_DESCRIPTOR_DEVICE,
+    0x00, 0x02,                         /* USB 2.0 */
+    0x00, 0x00, 0x00,                   /* class defined by the interface */
+    64,                                 /* EP0 max packet size */
+    0xD8, 0x04, 0x05, 0xF0,             /* VID/PID */
+    0x00, 0x01,                         /* device release */
+    1, 2, 0,                            /* strings */
+    1                                   /* configurations */
+};
+
+static const uint8_t compositeConfigurationDescriptor[] =
+{
+    9, USB_DESCRIPTOR_CONFIGURATION,
+    233, 0,                             /* total length */
+    6, 1, 0,                            /* interfaces, value, string */
+    0x80, 250,                          /* bus powered, 500 mA */
+
+    /* Audio control */
+    9, USB_DESCRIPTOR_INTERFACE,
+    0, 0, 1,                            /* number, alternate, endpoints */
+    1, 1, 0,                            /* audio control */
+    0,
+
+    10, 0x24, 0x01, 0x00, 0x01,         /* header, ADC 1.00 */
+    10, 0,                              /* class specific length */
+    2, 1, 2,                            /* streaming interfaces 1 and 2 */
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x81, 0x03,                         /* interrupt IN, status */
+    8, 0,
+    16,
+
+    /* Microphone */
+    9, USB_DESCRIPTOR_INTERFACE,
+    1, 0, 0,                            /* number, alternate, endpoints */
+    1, 2, 0,                            /* audio streaming, zero bandwidth */
+    0,
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    1, 1, 1,                            /* number, alternate, endpoints */
+    1, 2, 0,                            /* audio streaming, 48 kHz mono */
+    0,
+
+    9, USB_DESCRIPTOR_ENDPOINT,
+    0x82, 0x05,                         /* isochronous IN, asynchronous */
+    96, 0,
+    1, 0, 0,
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    1, 2, 1,                            /* number, alternate, endpoints */
+    1, 2, 0,                            /* audio streaming, 48 kHz stereo */
+    0,
+
+    9, USB_DESCRIPTOR_ENDPOINT,
+    0x82, 0x05,                         /* isochronous IN, asynchronous */
+    192, 0,
+    1, 0, 0,
+
+    /* Speaker */
+    9, USB_DESCRIPTOR_INTERFACE,
+    2, 0, 0,                            /* number, alternate, endpoints */
+    1, 2, 0,                            /* audio streaming, zero bandwidth */
+    0,
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    2, 1, 2,                            /* number, alternate, endpoints */
+    1, 2, 0,                            /* audio streaming, 48 kHz mono */
+    0,
+
+    9, USB_DESCRIPTOR_ENDPOINT,
+    0x03, 0x05,                         /* isochronous OUT, asynchronous */
+    96, 0,
+    1, 0, 0x83,                         /* feedback on EP3 IN */
+
+    9, USB_DESCRIPTOR_ENDPOINT,
+    0x83, 0x11,                         /* isochronous IN, feedback */
+    3, 0,
+    1, 5, 0,                            /* every 32 ms */
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    2, 2, 2,                            /* number, alternate, endpoints */
+    1, 2, 0,                            /* audio streaming, 48 kHz stereo */
+    0,
+
+    9, USB_DESCRIPTOR_ENDPOINT,
+    0x03, 0x05,                         /* isochronous OUT, asynchronous */
+    192, 0,
+    1, 0, 0x83,                         /* feedback on EP3 IN */
+
+    9, USB_DESCRIPTOR_ENDPOINT,
+    0x83, 0x11,                         /* isochronous IN, feedback */
+    3, 0,
+    1, 5, 0,                            /* every 32 ms */
+
+    /* HID */
+    9, USB_DESCRIPTOR_INTERFACE,
+    3, 0, 2,                            /* number, alternate, endpoints */
+    3, 0, 0,                            /* HID, no boot protocol */
+    0,
+
+    9, 0x21,                            /* HID descriptor */
+    0x11, 0x01, 0, 1,                   /* HID 1.11, country, descriptors */
+    0x22, 32, 0,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x84, 0x03,                         /* interrupt IN */
+    16, 0,
+    4,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x04, 0x03,                         /* interrupt OUT */
+    16, 0,
+    4,
+
+    /* CDC ACM */
+    9, USB_DESCRIPTOR_INTERFACE,
+    4, 0, 1,                            /* number, alternate, endpoints */
+    2, 2, 1,                            /* CDC, ACM, AT commands */
+    0,
+
+    5, 0x24, 0x00, 0x10, 0x01,          /* header, CDC 1.10 */
+    5, 0x24, 0x01, 0x00, 5,             /* call management, data interface */
+    4, 0x24, 0x02, 0x02,                /* ACM, line coding and serial state */
+    5, 0x24, 0x06, 4, 5,                /* union, master 4, slave 5 */
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x85, 0x03,                         /* interrupt IN */
+    8, 0,
+    16,
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    5, 0, 2,                            /* number, alternate, endpoints */
+    0x0A, 0, 0,                         /* CDC data */
+    0,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x06, 0x02,                         /* bulk OUT */
+    64, 0,
+    0,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x86, 0x02,                         /* bulk IN */
+    64, 0,
+    0
+};
+
+static const uint8_t compositeString0[] = { 4, USB_DESCRIPTOR_STRING, 0x09, 0x04 };
+static const uint8_t compositeString1[] = { 8, USB_DESCRIPTOR_STRING, 'S', 0, 'i', 0, 'm', 0 };
+static const uint8_t compositeString2[] = { 20, USB_DESCRIPTOR_STRING, 'C', 0, 'o', 0, 'm', 0, 'p', 0, 'o', 0, 's', 0, 'i', 0, 't', 0, 'e', 0 };
+
+static const uint8_t * const compositeStrings[] = { compositeString0, compositeString1, compositeString2 };
+
+static int16_t CompositeIn(void *context, uint8_t endpoint, uint8_t *data, uint16_t maxSize)
+{
+    (void)context;
+    (void)endpoint;
+    (void)data;
+    (void)maxSize;
+    return USB_SIM_NAK;
+}
+
+static int16_t CompositeOut(void *context, uint8_t endpoint, const uint8_t *data, uint16_t size)
+{
+    (void)context;
+    (void)endpoint;
+    (void)data;
+    (void)size;
+    return USB_SIM_NAK;
+}
+
+USB_SIM_DEVICE simComposite =
+{
+    "composite",
+    false,
+    compositeDeviceDescriptor,
+    compositeConfigurationDescriptor,
+    compositeStrings,
+    sizeof(compositeStrings) / sizeof(compositeStrings[0]),
+    NULL,
+    NULL,
+    CompositeIn,
+    CompositeOut,
+    NULL,
+    NULL
+};
@@ -0,0 +1,75 @@
+/*
+ * Device models for the simulated host controller, see usbhostsim.c and
+ * src/usb/usb_hal_sim.h.
+ */
+
+#ifndef SIM_DEVICES_H
+#define SIM_DEVICES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "system.h"
+#include "system_config.h"
+#include <usb/usb.h>
+
+/* Low speed HID boot keyboard.  It types the given text, one key press and
+ * one release report per poll, starting at the given frame. */
+extern USB_SIM_DEVICE simKeyboard;
+void SimKeyboardType(const char *text, uint32_t startFrame);
+bool SimKeyboardIdle(void);
+
+/* Full speed bulk only mass storage device with a RAM disk of
+ * SIM_DISK_BLOCKS blocks of 512 bytes. */
+#define SIM_DISK_BLOCK_SIZE     512
+#define SIM_DISK_BLOCKS         256
+extern USB_SIM_DEVICE simDisk;
+uint8_t *SimDiskImage(void);
+
+/* Full speed CDC ACM device that echoes everything written to it. */
+#define SIM_SERIAL_FIFO_SIZE    1024
+extern USB_SIM_DEVICE simSerial;
+uint32_t SimSerialLineRate(void);
+void SimSerialCapture(uint8_t *buffer, uint32_t size);     /* NULL for loopback */
+uint32_t SimSerialCaptured(void);
+
+/* Full speed composite device with audio control, two audio streaming
+ * interfaces with two settings each, HID and CDC ACM interfaces.  It has no
+ * class behaviour; it is only enumerated. */
+extern USB_SIM_DEVICE simComposite;
+
+/* Full speed hub with SIM_HUB_PORTS individually powered ports.
+ * SimHubConnect() plugs one of the other device models into a port and
+ * SimHubDisconnect() unplugs it; the host reaches the device once it has
+ * reset the port.  SimHubStall() makes the hub stall its next class requests, and its
+ * status change endpoint until the host clears the halt;
+ * SimHubStalls() counts the stalls sent. */
+#define SIM_HUB_PORTS           4
+#define SIM_HUB_RESET_MS        10
+extern USB_SIM_DEVICE simHub;
+void SimHubConnect(uint8_t port, USB_SIM_DEVICE *device);
+void SimHubDisconnect(uint8_t port);
+void SimHubStall(uint16_t requests, bool statusEndpoint);
+uint16_t SimHubStalls(void);
+
+/* Full speed USB Audio 1.0 microphone, 16 bit mono at 48 kHz.  The samples
+ * are a running counter; SimMicrophoneSamples() returns how many it has
+ * produced.  SimMicrophoneSetDrift() makes its clock run the given parts per
+ * million fast (or slow, if negative) against the host's frame clock. */
+extern USB_SIM_DEVICE simMicrophone;
+uint32_t SimMicrophoneSamples(void);
+void SimMicrophoneSetDrift(int32_t ppm);
+
+/* Full speed Android device that is already in accessory mode.  The first
+ * SIM_ACCESSORY_EVENTS AOA HID reports it receives are recorded in order. */
+#define SIM_ACCESSORY_EVENTS    256
+typedef struct
+{
+    uint8_t     id;
+    uint8_t     length;
+    uint8_t     report[16];
+} SIM_HID_EVENT;
+extern USB_SIM_DEVICE simAccessory;
+const SIM_HID_EVENT *SimAccessoryEvents(uint16_t *count);
+
+#endif /* SIM_DEVICES_H */
@@ -0,0 +1,304 @@
+/*
+ * Four port full speed hub model for the simulated host controller.
+ *
+ * The ports are individually switched.  SimHubConnect() plugs a device
+ * model into a port and SimHubDisconnect() unplugs it.  A port reset lasts
+ * SIM_HUB_RESET_MS and enables the port if the device is still connected;
+ * the device is then put on the bus with USBSimHubPortAttach(), at address
+ * 0, and taken off it again when the port is disabled or reset.  Changes are reported on the status
+ * change endpoint, which NAKs while there are none.  SimHubStall() makes
+ * the hub stall the next class requests, or its status change endpoint,
+ * to exercise the recovery of the hub driver.
+ */
+
+#include <string.h>
+
+#include "sim_devices.h"
+
+#define HUB_EP_STATUS           1
+#define HUB_INTERVAL            16          /* ms */
+
+#define PORT_CONNECTION         0x0001      /* wPortStatus */
+#define PORT_ENABLE             0x0002
+#define PORT_RESET              0x0010
+#define PORT_POWER              0x0100
+#define PORT_LOW_SPEED          0x0200
+
+#define C_PORT_CONNECTION       0x0001      /* wPortChange */
+#define C_PORT_ENABLE           0x0002
+#define C_PORT_RESET            0x0010
+
+#define FEATURE_PORT_ENABLE     1
+#define FEATURE_PORT_RESET      4
+#define FEATURE_PORT_POWER      8
+
+static const uint8_t hubDeviceDescriptor[] =
+{
+    18, USB_DESCRIPTOR_DEVICE,
+    0x10, 0x01,                         /* USB 1.1 */
+    0x09, 0x00, 0x00,                   /* hub, full speed */
+    64,                                 /* EP0 max packet size */
+    0xD8, 0x04, 0x06, 0xF0,             /* VID/PID */
+    0x00, 0x01,                         /* device release */
+    1, 2, 0,                            /* strings */
+    1                                   /* configurations */
+};
+
+static const uint8_t hubConfigurationDescriptor[] =
+{
+    9, USB_DESCRIPTOR_CONFIGURATION,
+    25, 0,                              /* total length */
+    1, 1, 0,                            /* interfaces, value, string */
+    0xE0, 50,                           /* self powered, remote wakeup, 100 mA */
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    0, 0, 1,                            /* number, alternate, endpoints */
+    0x09, 0, 0,                         /* hub */
+    0,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x80 | HUB_EP_STATUS, 0x03,         /* interrupt IN */
+    1, 0,
+    HUB_INTERVAL
+};
+
+static const uint8_t hubDescriptor[] =
+{
+    9, 0x29,
+    SIM_HUB_PORTS,
+    0x09, 0x00,                         /* individual power switching and overcurrent */
+    50,                                 /* 100 ms from power on to power good */
+    100,                                /* 100 mA */
+    0x00,                               /* all ports removable */
+    0xFF
+};
+
+static const uint8_t hubString0[] = { 4, USB_DESCRIPTOR_STRING, 0x09, 0x04 };
+static const uint8_t hubString1[] = { 8, USB_DESCRIPTOR_STRING, 'S', 0, 'i', 0, 'm', 0 };
+static const uint8_t hubString2[] = { 8, USB_DESCRIPTOR_STRING, 'H', 0, 'u', 0, 'b', 0 };
+
+static const uint8_t * const hubStrings[] = { hubString0, hubString1, hubString2 };
+
+static struct
+{
+    USB_SIM_DEVICE *device[SIM_HUB_PORTS];  /* plugged in device, kept over resets */
+    uint16_t    status[SIM_HUB_PORTS];
+    uint16_t    change[SIM_HUB_PORTS];
+    uint8_t     resetLeft[SIM_HUB_PORTS];   /* ms */
+    uint16_t    stallRequests;
+    bool        stallStatus;
+    uint16_t    stalls;
+} hub;
+
+/* Updates the connection bit of a powered port after a plug or unplug. */
+static void HubConnection(uint8_t i)
+{
+    bool    connected = (hub.device[i] != NULL) && (hub.status[i] & PORT_POWER);
+
+    if (connected == ((hub.status[i] & PORT_CONNECTION) != 0))
+        return;
+    hub.change[i] |= C_PORT_CONNECTION;
+    if (connected)
+    {
+        hub.status[i] |= PORT_CONNECTION;
+        if (hub.device[i]->lowSpeed)
+            hub.status[i] |= PORT_LOW_SPEED;
+    }
+    else
+    {
+        if (hub.status[i] & PORT_ENABLE)
+            hub.change[i] |= C_PORT_ENABLE;
+        hub.status[i] &= ~(PORT_CONNECTION | PORT_ENABLE | PORT_RESET | PORT_LOW_SPEED);
+        hub.resetLeft[i] = 0;
+        USBSimHubPortDetach(i + 1);
+    }
+}
+
+static void HubReset(void *context)
+{
+    uint8_t     i;
+
+    (void)context;
+    for (i = 0; i < SIM_HUB_PORTS; i++)
+    {
+        hub.status[i] = 0;
+        hub.change[i] = 0;
+        hub.resetLeft[i] = 0;
+        USBSimHubPortDetach(i + 1);
+    }
+    hub.stallStatus = false;
+}
+
+static int16_t HubRequest(void *context, const USB_SIM_SETUP_PACKET *setup, uint8_t *data)
+{
+    uint8_t     i = (uint8_t)(setup->wIndex - 1);
+    bool        port = (setup->bmRequestType & 0x1F) == USB_SETUP_RECIPIENT_OTHER;
+    uint16_t    length;
+
+    (void)context;
+
+    if ((setup->bmRequestType & 0x60) == USB_SETUP_TYPE_STANDARD)
+    {
+        /* The controller has cleared the halt of the status endpoint. */
+        if ((setup->bRequest == USB_REQUEST_CLEAR_FEATURE) && (setup->wIndex == (0x80 | HUB_EP_STATUS)))
+            hub.stallStatus = false;
+        return USB_SIM_ACK;
+    }
+    if (hub.stallRequests != 0)
+    {
+        hub.stallRequests--;
+        hub.stalls++;
+        return USB_SIM_STALL;
+    }
+    if (port && (setup->wIndex == 0 || setup->wIndex > SIM_HUB_PORTS))
+        return USB_SIM_STALL;
+
+    switch (setup->bRequest)
+    {
+        case USB_REQUEST_GET_DESCRIPTOR:
+            if (port || ((setup->wValue >> 8) != 0x29))
+                return USB_SIM_STALL;
+            length = (setup->wLength < sizeof(hubDescriptor)) ? setup->wLength : sizeof(hubDescriptor);
+            memcpy(data, hubDescriptor, length);
+            return length;
+
+        case USB_REQUEST_GET_STATUS:
+            memset(data, 0, 4);
+            if (port)
+            {
+                data[0] = (uint8_t)hub.status[i];
+                data[1] = (uint8_t)(hub.status[i] >> 8);
+                data[2] = (uint8_t)hub.change[i];
+                data[3] = (uint8_t)(hub.change[i] >> 8);
+            }
+            return 4;
+
+        case USB_REQUEST_SET_FEATURE:
+            if (!port)
+                return USB_SIM_STALL;
+            switch (setup->wValue)
+            {
+                case FEATURE_PORT_POWER:
+                    hub.status[i] |= PORT_POWER;
+                    HubConnection(i);
+                    return USB_SIM_ACK;
+                case FEATURE_PORT_RESET:
+                    if (hub.status[i] & PORT_CONNECTION)
+                    {
+                        hub.status[i] = (hub.status[i] | PORT_RESET) & ~PORT_ENABLE;
+                        hub.resetLeft[i] = SIM_HUB_RESET_MS;
+                        USBSimHubPortDetach(i + 1);
+                    }
+                    return USB_SIM_ACK;
+                default:
+                    return USB_SIM_STALL;
+            }
+
+        case USB_REQUEST_CLEAR_FEATURE:
+            if (!port)
+                return USB_SIM_ACK;             /* C_HUB_LOCAL_POWER, C_HUB_OVER_CURRENT */
+            if (setup->wValue >= 16)
+            {
+                hub.change[i] &= ~(1u << (setup->wValue - 16));
+                return USB_SIM_ACK;
+            }
+            if (setup->wValue == FEATURE_PORT_ENABLE)
+            {
+                hub.status[i] &= ~PORT_ENABLE;
+                USBSimHubPortDetach(i + 1);
+                return USB_SIM_ACK;
+            }
+            if (setup->wValue == FEATURE_PORT_POWER)
+            {
+                hub.status[i] &= ~PORT_POWER;
+                HubConnection(i);
+                return USB_SIM_ACK;
+            }
+            return USB_SIM_STALL;
+
+        default:
+            return USB_SIM_STALL;
+    }
+}
+
+static int16_t HubIn(void *context, uint8_t endpoint, uint8_t *data, uint16_t maxSize)
+{
+    uint8_t     bitmap = 0;
+    uint8_t     i;
+
+    (void)context;
+
+    if ((endpoint != HUB_EP_STATUS) || (maxSize < 1))
+        return USB_SIM_STALL;
+    if (hub.stallStatus)
+    {
+        hub.stalls++;
+        return USB_SIM_STALL;
+    }
+    for (i = 0; i < SIM_HUB_PORTS; i++)
+    {
+        if (hub.change[i] != 0)
+            bitmap |= 2u << i;
+    }
+    if (bitmap == 0)
+        return USB_SIM_NAK;
+    data[0] = bitmap;
+    return 1;
+}
+
+static void HubFrame(void *context, uint32_t frameNumber)
+{
+    uint8_t     i;
+
+    (void)context;
+    (void)frameNumber;
+
+    for (i = 0; i < SIM_HUB_PORTS; i++)
+    {
+        if ((hub.resetLeft[i] != 0) && (--hub.resetLeft[i] == 0))
+        {
+            hub.status[i] = (hub.status[i] & ~PORT_RESET) | PORT_ENABLE;
+            hub.change[i] |= C_PORT_RESET;
+            USBSimHubPortAttach(i + 1, hub.device[i]);
+        }
+    }
+}
+
+USB_SIM_DEVICE simHub =
+{
+    "hub",
+    false,
+    hubDeviceDescriptor,
+    hubConfigurationDescriptor,
+    hubStrings,
+    sizeof(hubStrings) / sizeof(hubStrings[0]),
+    HubReset,
+    HubRequest,
+    HubIn,
+    NULL,
+    HubFrame,
+    NULL
+};
+
+void SimHubConnect(uint8_t port, USB_SIM_DEVICE *device)
+{
+    hub.device[port - 1] = device;
+    HubConnection(port - 1);
+}
+
+void SimHubDisconnect(uint8_t port)
+{
+    hub.device[port - 1] = NULL;
+    HubConnection(port - 1);
+}
+
+void SimHubStall(uint16_t requests, bool statusEndpoint)
+{
+    hub.stallRequests = requests;
+    hub.stallStatus = statusEndpoint;
+}
+
+uint16_t SimHubStalls(void)
+{
+    return hub.stalls;
+}
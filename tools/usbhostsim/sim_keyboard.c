@@ -0,0 +1,249 @@
+/*
+ * Scripted HID boot keyboard model for the simulated host controller.
+ *
+ * The keyboard is a low speed device with one interrupt IN endpoint.  Text
+ * given to SimKeyboardType() is sent as a key press report followed by a
+ * key release report for every character; between keys the endpoint NAKs,
+ * like a real keyboard with an idle rate of 0.
+ */
+
+#include <string.h>
+
+#include "sim_devices.h"
+
+#define KBD_REPORT_SIZE     8
+#define KBD_INTERVAL        10          /* ms */
+#define KBD_SHIFT           0x02        /* left shift modifier bit */
+
+static const uint8_t kbdDeviceDescriptor[] =
+{
+    18, USB_DESCRIPTOR_DEVICE,
+    0x10, 0x01,                         /* USB 1.1 */
+    0x00, 0x00, 0x00,                   /* class defined by the interface */
+    8,                                  /* EP0 max packet size */
+    0xD8, 0x04, 0x01, 0xF0,             /* VID/PID */
+    0x00, 0x01,                         /* device release */
+    1, 2, 0,                            /* strings */
+    1                                   /* configurations */
+};
+
+static const uint8_t kbdReportDescriptor[] =
+{
+    0x05, 0x01,         /* Usage Page (Generic Desktop) */
+    0x09, 0x06,         /* Usage (Keyboard) */
+    0xA1, 0x01,         /* Collection (Application) */
+    0x05, 0x07,         /*   Usage Page (Keyboard) */
+    0x19, 0xE0,         /*   Usage Minimum (Left Control) */
+    0x29, 0xE7,         /*   Usage Maximum (Right GUI) */
+    0x15, 0x00,         /*   Logical Minimum (0) */
+    0x25, 0x01,         /*   Logical Maximum (1) */
+    0x75, 0x01,         /*   Report Size (1) */
+    0x95, 0x08,         /*   Report Count (8) */
+    0x81, 0x02,         /*   Input (Data, Variable, Absolute) */
+    0x95, 0x01,         /*   Report Count (1) */
+    0x75, 0x08,         /*   Report Size (8) */
+    0x81, 0x01,         /*   Input (Constant) */
+    0x95, 0x05,         /*   Report Count (5) */
+    0x75, 0x01,         /*   Report Size (1) */
+    0x05, 0x08,         /*   Usage Page (LEDs) */
+    0x19, 0x01,         /*   Usage Minimum (Num Lock) */
+    0x29, 0x05,         /*   Usage Maximum (Kana) */
+    0x91, 0x02,         /*   Output (Data, Variable, Absolute) */
+    0x95, 0x01,         /*   Report Count (1) */
+    0x75, 0x03,         /*   Report Size (3) */
+    0x91, 0x01,         /*   Output (Constant) */
+    0x95, 0x06,         /*   Report Count (6) */
+    0x75, 0x08,         /*   Report Size (8) */
+    0x15, 0x00,         /*   Logical Minimum (0) */
+    0x25, 0x65,         /*   Logical Maximum (101) */
+    0x05, 0x07,         /*   Usage Page (Keyboard) */
+    0x19, 0x00,         /*   Usage Minimum (0) */
+    0x29, 0x65,         /*   Usage Maximum (101) */
+    0x81, 0x00,         /*   Input (Data, Array) */
+    0xC0                /* End Collection */
+};
+
+static const uint8_t kbdConfigurationDescriptor[] =
+{
+    9, USB_DESCRIPTOR_CONFIGURATION,
+    34, 0,                              /* total length */
+    1, 1, 0,                            /* interfaces, value, string */
+    0xA0, 50,                           /* bus powered, remote wakeup, 100 mA */
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    0, 0, 1,                            /* number, alternate, endpoints */
+    3, 1, 1,                            /* HID, boot, keyboard */
+    0,
+
+    9, 0x21,                            /* HID descriptor */
+    0x11, 0x01, 0, 1,                   /* HID 1.11, country, descriptors */
+    0x22, sizeof(kbdReportDescriptor), 0,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x81, 0x03,                         /* EP1 IN, interrupt */
+    KBD_REPORT_SIZE, 0,
+    KBD_INTERVAL
+};
+
+static const uint8_t kbdString0[] = { 4, USB_DESCRIPTOR_STRING, 0x09, 0x04 };
+static const uint8_t kbdString1[] = { 8, USB_DESCRIPTOR_STRING, 'S', 0, 'i', 0, 'm', 0 };
+static const uint8_t kbdString2[] = { 18, USB_DESCRIPTOR_STRING, 'K', 0, 'e', 0, 'y', 0, 'b', 0, 'o', 0, 'a', 0, 'r', 0, 'd', 0 };
+
+static const uint8_t * const kbdStrings[] = { kbdString0, kbdString1, kbdString2 };
+
+static struct
+{
+    const char  *text;          /* what is left to type */
+    uint32_t    startFrame;
+    uint32_t    frame;
+    bool        released;       /* the last report sent was a release */
+    uint8_t     leds;
+    uint8_t     idle;
+    uint8_t     protocol;
+} kbd;
+
+/* Maps an ASCII character to a boot keyboard usage and modifier. */
+static uint8_t KbdUsage(char c, uint8_t *modifier)
+{
+    static const char shifted[] = "!@#$%^&*()";
+
+    *modifier = 0;
+    if ((c >= 'A') && (c <= 'Z'))
+    {
+        *modifier = KBD_SHIFT;
+        c = c - 'A' + 'a';
+    }
+    if ((c >= 'a') && (c <= 'z'))
+        return 0x04 + (c - 'a');
+    if ((c >= '1') && (c <= '9'))
+        return 0x1E + (c - '1');
+    if (c == '0')
+        return 0x27;
+    if (strchr(shifted, c) != NULL)
+    {
+        *modifier = KBD_SHIFT;
+        return 0x1E + (strchr(shifted, c) - shifted);
+    }
+    switch (c)
+    {
+        case '\n':  return 0x28;
+        case '\t':  return 0x2B;
+        case ' ':   return 0x2C;
+        case ',':   return 0x36;
+        case '-':   return 0x2D;
+        case '.':   return 0x37;
+        default:    return 0x38;                /* '/' for anything else */
+    }
+}
+
+static void KbdReset(void *context)
+{
+    (void)context;
+    kbd.released = true;
+    kbd.leds     = 0;
+    kbd.idle     = 0;
+    kbd.protocol = 1;
+}
+
+static int16_t KbdRequest(void *context, const USB_SIM_SETUP_PACKET *setup, uint8_t *data)
+{
+    (void)context;
+
+    if ((setup->bmRequestType & 0x60) == USB_SETUP_TYPE_STANDARD)
+    {
+        if ((setup->bRequest == USB_REQUEST_GET_DESCRIPTOR) && ((setup->wValue >> 8) == 0x22))
+        {
+            memcpy(data, kbdReportDescriptor, sizeof(kbdReportDescriptor));
+            return sizeof(kbdReportDescriptor);
+        }
+        if ((setup->bRequest == USB_REQUEST_GET_DESCRIPTOR) && ((setup->wValue >> 8) == 0x21))
+        {
+            memcpy(data, &kbdConfigurationDescriptor[18], 9);
+            return 9;
+        }
+        if (setup->bRequest == USB_REQUEST_CLEAR_FEATURE)
+            return USB_SIM_ACK;
+        return USB_SIM_STALL;
+    }
+
+    switch (setup->bRequest)
+    {
+        case 0x01:                              /* GET_REPORT */
+            memset(data, 0, KBD_REPORT_SIZE);
+            return KBD_REPORT_SIZE;
+        case 0x02:                              /* GET_IDLE */
+            data[0] = kbd.idle;
+            return 1;
+        case 0x03:                              /* GET_PROTOCOL */
+            data[0] = kbd.protocol;
+            return 1;
+        case 0x09:                              /* SET_REPORT, the LEDs */
+            kbd.leds = data[0];
+            return USB_SIM_ACK;
+        case 0x0A:                              /* SET_IDLE */
+            kbd.idle = setup->wValue >> 8;
+            return USB_SIM_ACK;
+        case 0x0B:                              /* SET_PROTOCOL */
+            kbd.protocol = setup->wValue & 0xFF;
+            return USB_SIM_ACK;
+        default:
+            return USB_SIM_STALL;
+    }
+}
+
+static int16_t KbdIn(void *context, uint8_t endpoint, uint8_t *data, uint16_t maxSize)
+{
+    (void)context;
+
+    if ((endpoint != 1) || (maxSize < KBD_REPORT_SIZE))
+        return USB_SIM_STALL;
+    if ((kbd.text == NULL) || (kbd.frame < kbd.startFrame))
+        return USB_SIM_NAK;
+
+    memset(data, 0, KBD_REPORT_SIZE);
+    if (kbd.released)
+    {
+        if (*kbd.text == '\0')
+        {
+            kbd.text = NULL;
+            return USB_SIM_NAK;
+        }
+        data[2] = KbdUsage(*kbd.text++, &data[0]);
+    }
+    kbd.released = !kbd.released;
+    return KBD_REPORT_SIZE;
+}
+
+static void KbdFrame(void *context, uint32_t frameNumber)
+{
+    (void)context;
+    kbd.frame = frameNumber;
+}
+
+USB_SIM_DEVICE simKeyboard =
+{
+    "keyboard",
+    true,
+    kbdDeviceDescriptor,
+    kbdConfigurationDescriptor,
+    kbdStrings,
+    sizeof(kbdStrings) / sizeof(kbdStrings[0]),
+    KbdReset,
+    KbdRequest,
+    KbdIn,
+    NULL,
+    KbdFrame,
+    NULL
+};
+
+void SimKeyboardType(const char *text, uint32_t startFrame)
+{
+    kbd.text       = text;
+    kbd.startFrame = startFrame;
+    kbd.released   = true;
+}
+
+bool SimKeyboardIdle(void)
+{
+    return (kbd.text == NULL);
+}
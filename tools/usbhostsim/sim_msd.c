@@ -0,0 +1,328 @@
+/*
+ * Bulk only mass storage RAM disk model for the simulated host controller.
+ *
+ * The disk answers the SCSI commands used by the host MSD driver and the
+ * media layers on top of it: TEST UNIT READY, REQUEST SENSE, INQUIRY,
+ * MODE SENSE(6), READ CAPACITY(10), READ(10) and WRITE(10).  Any other
+ * command fails with ILLEGAL REQUEST; if it has a data in stage, the bulk
+ * IN endpoint is stalled until the host clears it, as the BOT specification
+ * requires.
+ */
+
+#include <string.h>
+
+#include "sim_devices.h"
+
+#define DISK_PACKET_SIZE    64
+#define DISK_EP_IN          1
+#define DISK_EP_OUT         2
+
+#define CBW_SIGNATURE       0x43425355ul
+#define CSW_SIGNATURE       0x53425355ul
+#define CBW_SIZE            31
+#define CSW_SIZE            13
+
+#define SENSE_NONE              0x00
+#define SENSE_ILLEGAL_REQUEST   0x05
+
+static const uint8_t diskDeviceDescriptor[] =
+{
+    18, USB_DESCRIPTOR_DEVICE,
+    0x00, 0x02,                         /* USB 2.0 */
+    0x00, 0x00, 0x00,                   /* class defined by the interface */
+    64,                                 /* EP0 max packet size */
+    0xD8, 0x04, 0x02, 0xF0,             /* VID/PID */
+    0x00, 0x01,                         /* device release */
+    1, 2, 3,                            /* strings */
+    1                                   /* configurations */
+};
+
+static const uint8_t diskConfigurationDescriptor[] =
+{
+    9, USB_DESCRIPTOR_CONFIGURATION,
+    32, 0,                              /* total length */
+    1, 1, 0,                            /* interfaces, value, string */
+    0x80, 100,                          /* bus powered, 200 mA */
+
+    9, USB_DESCRIPTOR_INTERFACE,
+    0, 0, 2,                            /* number, alternate, endpoints */
+    8, 6, 0x50,                         /* MSD, SCSI, bulk only */
+    0,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    0x80 | DISK_EP_IN, 0x02,            /* bulk IN */
+    DISK_PACKET_SIZE, 0,
+    0,
+
+    7, USB_DESCRIPTOR_ENDPOINT,
+    DISK_EP_OUT, 0x02,                  /* bulk OUT */
+    DISK_PACKET_SIZE, 0,
+    0
+};
+
+static const uint8_t diskString0[] = { 4, USB_DESCRIPTOR_STRING, 0x09, 0x04 };
+static const uint8_t diskString1[] = { 8, USB_DESCRIPTOR_STRING, 'S', 0, 'i', 0, 'm', 0 };
+static const uint8_t diskString2[] = { 18, USB_DESCRIPTOR_STRING, 'R', 0, 'A', 0, 'M', 0, ' ', 0, 'd', 0, 'i', 0, 's', 0, 'k', 0 };
+static const uint8_t diskString3[] = { 26, USB_DESCRIPTOR_STRING, '0', 0, '0', 0, '0', 0, '0', 0, '0', 0, '0', 0,
+                                       '0', 0, '0', 0, '0', 0, '0', 0, '0', 0, '1', 0 };
+
+static const uint8_t * const diskStrings[] = { diskString0, diskString1, diskString2, diskString3 };
+
+static const uint8_t diskInquiry[36] =
+{
+    0x00, 0x80, 0x04, 0x02, 31, 0, 0, 0,
+    'S', 'i', 'm', ' ', ' ', ' ', ' ', ' ',
+    'R', 'A', 'M', ' ', 'd', 'i', 's', 'k', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',
+    '1', '.', '0', '0'
+};
+
+typedef enum
+{
+    DISK_CBW,
+    DISK_DATA_IN,
+    DISK_DATA_OUT,
+    DISK_STALLED,
+    DISK_CSW
+} DISK_STATE;
+
+static uint8_t diskImage[SIM_DISK_BLOCKS * SIM_DISK_BLOCK_SIZE];
+
+static struct
+{
+    DISK_STATE  state;
+    uint32_t    tag;
+    uint32_t    expected;       /* dCBWDataTransferLength */
+    uint32_t    transferred;
+    uint8_t     *data;          /* data stage buffer */
+    uint32_t    length;         /* bytes the command has in its data stage */
+    uint8_t     status;         /* bCSWStatus */
+    uint8_t     sense;
+    uint8_t     reply[36];      /* data of the short commands */
+} disk;
+
+static uint32_t GetBE32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint32_t GetLE32(const uint8_t *p)
+{
+    return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+}
+
+static void PutBE32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void PutLE32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+/* Sets up the data stage of the command in the CBW. */
+static void DiskCommand(const uint8_t *cbw)
+{
+    const uint8_t   *cb = &cbw[15];
+    uint32_t        lba;
+    uint32_t        blocks;
+    bool            toHost = (cbw[12] & 0x80) != 0;
+
+    disk.tag         = GetLE32(&cbw[4]);
+    disk.expected    = GetLE32(&cbw[8]);
+    disk.transferred = 0;
+    disk.data        = disk.reply;
+    disk.length      = 0;
+    disk.status      = 0;
+
+    switch (cb[0])
+    {
+        case 0x00:                              /* TEST UNIT READY */
+        case 0x1E:                              /* PREVENT ALLOW MEDIUM REMOVAL */
+        case 0x35:                              /* SYNCHRONIZE CACHE(10) */
+            break;
+
+        case 0x03:                              /* REQUEST SENSE */
+            memset(disk.reply, 0, 18);
+            disk.reply[0]  = 0x70;
+            disk.reply[2]  = disk.sense;
+            disk.reply[7]  = 10;
+            disk.length    = 18;
+            disk.sense     = SENSE_NONE;
+            break;
+
+        case 0x12:                              /* INQUIRY */
+            memcpy(disk.reply, diskInquiry, sizeof(diskInquiry));
+            disk.length = sizeof(diskInquiry);
+            break;
+
+        case 0x1A:                              /* MODE SENSE(6) */
+            memset(disk.reply, 0, 4);
+            disk.reply[0] = 3;
+            disk.length   = 4;
+            break;
+
+        case 0x25:                              /* READ CAPACITY(10) */
+            PutBE32(&disk.reply[0], SIM_DISK_BLOCKS - 1);
+            PutBE32(&disk.reply[4], SIM_DISK_BLOCK_SIZE);
+            disk.length = 8;
+            break;
+
+        case 0x28:                              /* READ(10) */
+        case 0x2A:                              /* WRITE(10) */
+            lba    = GetBE32(&cb[2]);
+            blocks = ((uint32_t)cb[7] << 8) | cb[8];
+            if (lba + blocks > SIM_DISK_BLOCKS)
+            {
+                disk.status = 1;
+                disk.sense  = SENSE_ILLEGAL_REQUEST;
+                break;
+            }
+            disk.data   = &diskImage[lba * SIM_DISK_BLOCK_SIZE];
+            disk.length = blocks * SIM_DISK_BLOCK_SIZE;
+            break;
+
+        default:
+            disk.status = 1;
+            disk.sense  = SENSE_ILLEGAL_REQUEST;
+            break;
+    }
+
+    if (disk.length > disk.expected)
+        disk.length = disk.expected;
+
+    if (disk.expected == 0)
+        disk.state = DISK_CSW;
+    else if (disk.status != 0)
+        disk.state = toHost ? DISK_STALLED : DISK_DATA_OUT;
+    else
+        disk.state = toHost ? DISK_DATA_IN : DISK_DATA_OUT;
+}
+
+static void DiskReset(void *context)
+{
+    (void)context;
+    disk.state = DISK_CBW;
+    disk.sense = SENSE_NONE;
+}
+
+static int16_t DiskRequest(void *context, const USB_SIM_SETUP_PACKET *setup, uint8_t *data)
+{
+    (void)context;
+
+    if ((setup->bmRequestType & 0x60) == USB_SETUP_TYPE_STANDARD)
+    {
+        /* CLEAR_FEATURE(ENDPOINT_HALT): the stalled data stage is over. */
+        if ((setup->bRequest == USB_REQUEST_CLEAR_FEATURE) && (disk.state == DISK_STALLED))
+            disk.state = DISK_CSW;
+        return (setup->bRequest == USB_REQUEST_CLEAR_FEATURE) ? USB_SIM_ACK : USB_SIM_STALL;
+    }
+
+    switch (setup->bRequest)
+    {
+        case 0xFE:                              /* GET_MAX_LUN */
+            data[0] = 0;
+            return 1;
+        case 0xFF:                              /* Bulk only mass storage reset */
+            disk.state = DISK_CBW;
+            return USB_SIM_ACK;
+        default:
+            return USB_SIM_STALL;
+    }
+}
+
+static int16_t DiskIn(void *context, uint8_t endpoint, uint8_t *data, uint16_t maxSize)
+{
+    uint32_t    size;
+
+    (void)context;
+
+    if (endpoint != DISK_EP_IN)
+        return USB_SIM_STALL;
+
+    switch (disk.state)
+    {
+        case DISK_DATA_IN:
+            size = disk.length - disk.transferred;
+            if (size > maxSize)
+                size = maxSize;
+            memcpy(data, &disk.data[disk.transferred], size);
+            disk.transferred += size;
+            if ((disk.transferred == disk.length) &&
+                ((size < maxSize) || (disk.transferred == disk.expected)))
+                disk.state = DISK_CSW;
+            return size;
+
+        case DISK_STALLED:
+            return USB_SIM_STALL;
+
+        case DISK_CSW:
+            size = (disk.status == 0) ? disk.transferred : 0;
+            if (size > disk.length)
+                size = disk.length;
+            PutLE32(&data[0], CSW_SIGNATURE);
+            PutLE32(&data[4], disk.tag);
+            PutLE32(&data[8], disk.expected - size);
+            data[12]   = disk.status;
+            disk.state = DISK_CBW;
+            return CSW_SIZE;
+
+        default:
+            return USB_SIM_NAK;
+    }
+}
+
+static int16_t DiskOut(void *context, uint8_t endpoint, const uint8_t *data, uint16_t size)
+{
+    (void)context;
+
+    if (endpoint != DISK_EP_OUT)
+        return USB_SIM_STALL;
+
+    switch (disk.state)
+    {
+        case DISK_CBW:
+            if ((size != CBW_SIZE) || (GetLE32(data) != CBW_SIGNATURE))
+                return USB_SIM_STALL;
+            DiskCommand(data);
+            return USB_SIM_ACK;
+
+        case DISK_DATA_OUT:
+            if ((disk.status == 0) && (disk.transferred + size <= disk.length))
+                memcpy(&disk.data[disk.transferred], data, size);
+            disk.transferred += size;
+            if (disk.transferred >= disk.expected)
+                disk.state = DISK_CSW;
+            return USB_SIM_ACK;
+
+        default:
+            return USB_SIM_NAK;
+    }
+}
+
+USB_SIM_DEVICE simDisk =
+{
+    "disk",
+    false,
+    diskDeviceDescriptor,
+    diskConfigurationDescriptor,
+    diskStrings,
+    sizeof(diskStrings) / sizeof(diskStrings[0]),
+    DiskReset,
+    DiskRequest,
+    DiskIn,
+    DiskOut,
+    NULL,
+    NULL
+};
+
+uint8_t *SimDiskImage(void)
+{
+    return diskImage;
+}
@@ -0,0 +1,29 @@
+/*
+ * A second copy of the SCSI layer, built with a sector cache, see the scsi
+ * scenario in usbhostsim.c.
+ *
+ * The cache is a build option of usb_host_msd_scsi.c, so to time the
+ * layer with and without it in one program this file includes the source
+ * again with USB_MSD_SCSI_CACHE_SECTORS defined and its functions renamed
+ * to SimCachedSCSI...().  Its static data are separate from those of the
+ * uncached copy.
+ */
+
+#include "sim_scsi_cached.h"
+
+#define USB_MSD_SCSI_CACHE_SECTORS          SIM_SCSI_CACHE_SECTORS
+
+#define USBHostMSDSCSIInitialize            SimCachedSCSIInitialize
+#define USBHostMSDSCSIEventHandler          SimCachedSCSIEventHandler
+#define USBHostMSDSCSIMediaDetect           SimCachedSCSIMediaDetect
+#define USBHostMSDSCSIMediaInitialize       SimCachedSCSIMediaInitialize
+#define USBHostMSDSCSIMediaReset            SimCachedSCSIMediaReset
+#define USBHostMSDSCSISectorRead            SimCachedSCSISectorRead
+#define USBHostMSDSCSISectorWrite           SimCachedSCSISectorWrite
+#define USBHostMSDSCSISectorsRead           SimCachedSCSISectorsRead
+#define USBHostMSDSCSISectorsWrite          SimCachedSCSISectorsWrite
+#define USBHostMSDSCSICacheFlush            SimCachedSCSICacheFlush
+#define USBHostMSDSCSIWriteProtectState     SimCachedSCSIWriteProtectState
+#define _USBHostMSDSCSI_TestUnitReady       _SimCachedSCSI_TestUnitReady
+
+#include <usb/src/usb_host_msd_scsi.c>
@@ -0,0 +1,27 @@
+/*
+ * The SCSI layer built with a sector cache, see sim_scsi_cached.c.
+ */
+
+#ifndef SIM_SCSI_CACHED_H
+#define SIM_SCSI_CACHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "system.h"
+#include "system_config.h"
+#include "fileio/fileio.h"
+#include <usb/usb.h>
+
+#define SIM_SCSI_CACHE_SECTORS  8
+
+bool SimCachedSCSIInitialize(uint8_t address, uint32_t flags, uint8_t clientDriverID);
+bool SimCachedSCSIEventHandler(uint8_t address, USB_EVENT event, void *data, uint32_t size);
+FILEIO_MEDIA_INFORMATION *SimCachedSCSIMediaInitialize(uint8_t *address);
+uint8_t SimCachedSCSISectorRead(uint8_t *address, uint32_t sectorAddress, uint8_t *dataBuffer);
+uint8_t SimCachedSCSISectorWrite(uint8_t *address, uint32_t sectorAddress, uint8_t *dataBuffer, uint8_t allowWriteToZero);
+uint8_t SimCachedSCSISectorsRead(uint8_t *address, uint32_t sectorAddress, uint16_t sectorCount, uint8_t *dataBuffer);
+uint8_t SimCachedSCSISectorsWrite(uint8_t *address, uint32_t sectorAddress, uint16_t sectorCount, uint8_t *dataBuffer, uint8_t allowWriteToZero);
+uint8_t SimCachedSCSICacheFlush(uint8_t *address);
+
+#endif /* SIM_SCSI_CACHED_H */
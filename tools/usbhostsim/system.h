@@ -0,0 +1,11 @@
+/*
+ * system.h for the simulated host build, see usbhostsim.c.
+ */
+
+#ifndef SYSTEM_H
+#define SYSTEM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#endif /* SYSTEM_H */
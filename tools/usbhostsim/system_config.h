@@ -0,0 +1,10 @@
+/*
+ * system_config.h for the simulated host build, see usbhostsim.c.
+ */
+
+#ifndef SYSTEM_CONFIG_H
+#define SYSTEM_CONFIG_H
+
+#include "usb_config.h"
+
+#endif /* SYSTEM_CONFIG_H */
@@ -0,0 +1,55 @@
+/*
+ * Targeted peripheral list and client driver table for the simulated host
+ * build, see usbhostsim.c.
+ */
+
+#include "system.h"
+#include "system_config.h"
+
+#include <usb/usb.h>
+#include <usb/usb_host_hid.h>
+#include <usb/usb_host_msd.h>
+#include <usb/usb_host_cdc.h>
+#include <usb/usb_host_hub.h>
+#if defined(USB_SUPPORT_ISOCHRONOUS_TRANSFERS)
+#include <usb/usb_host_audio_v1.h>
+#include <usb/usb_host_android.h>
+#endif
+
+/* The program itself is the media interface layer of the MSD driver. */
+bool SimMediaInitialize(uint8_t address, uint32_t flags, uint8_t clientDriverID);
+bool SimMediaEventHandler(uint8_t address, USB_EVENT event, void *data, uint32_t size);
+
+CLIENT_DRIVER_TABLE usbMediaInterfaceTable = { SimMediaInitialize, SimMediaEventHandler, NULL, 0 };
+
+/* ... and the client driver of the composite device, which only looks up
+ * its endpoints. */
+bool SimCompositeInitialize(uint8_t address, uint32_t flags, uint8_t clientDriverID);
+bool SimCompositeEventHandler(uint8_t address, USB_EVENT event, void *data, uint32_t size);
+
+CLIENT_DRIVER_TABLE usbClientDrvTable[NUM_CLIENT_DRIVER_ENTRIES] =
+{
+    { USBHostHIDInitialize, USBHostHIDEventHandler, NULL, 0 },
+    { USBHostMSDInitialize, USBHostMSDEventHandler, NULL, 0 },
+    { USBHostCDCInitialize, USBHostCDCEventHandler, NULL, 0 },
+    { SimCompositeInitialize, SimCompositeEventHandler, NULL, 0 },
+    { USBHostHubInitialize, USBHostHubEventHandler, USBHostHubDataEventHandler, 0 },
+#if defined(USB_SUPPORT_ISOCHRONOUS_TRANSFERS)
+    { USBHostAudioV1Initialize, USBHostAudioV1EventHandler, USBHostAudioV1DataEventHandler, 0 },
+    { AndroidAppInitialize, AndroidAppEventHandler, AndroidAppDataEventHandler, ANDROID_INIT_FLAG_BYPASS_PROTOCOL },
+#endif
+};
+
+USB_TPL usbTPL[NUM_TPL_ENTRIES] =
+{
+    { INIT_CL_SC_P( 3ul, 1ul, 1ul ),     0, 0, {TPL_CLASS_DRV} },  /* HID boot keyboard */
+    { INIT_CL_SC_P( 8ul, 6ul, 0x50ul ),  0, 1, {TPL_CLASS_DRV} },  /* MSD, SCSI, bulk only */
+    { INIT_CL_SC_P( 2ul, 2ul, 1ul ),     0, 2, {TPL_CLASS_DRV} },  /* CDC ACM */
+    { INIT_CL_SC_P( 0x0Aul, 0ul, 0ul ),  0, 2, {TPL_CLASS_DRV} },  /* CDC data interface */
+    { INIT_VID_PID( 0x04D8ul, 0xF005ul ), 0, 3, {0} },              /* composite, see sim_composite.c */
+    { INIT_CL_SC_P( 9ul, 0ul, 0ul ),     0, 4, {TPL_CLASS_DRV} },  /* hub */
+#if defined(USB_SUPPORT_ISOCHRONOUS_TRANSFERS)
+    { INIT_CL_SC_P( 1ul, 2ul, 0ul ),     0, 5, {TPL_CLASS_DRV} },  /* Audio streaming */
+    { INIT_VID_PID( 0x18D1ul, 0x2D01ul ), 0, 6, {0} },              /* Android accessory */
+#endif
+};
@@ -0,0 +1,71 @@
+/*
+ * usb_config.h for the simulated host build, see usbhostsim.c.
+ *
+ * The host stack runs on the simulated controller (USB_SIMULATOR, set in the
+ * Makefile) with the HID, MSD, CDC and hub client drivers.  The Audio client
+ * driver needs isochronous transfers, which need transfer events, and the
+ * Android accessory driver needs transfer events, so they are only included
+ * when built with -DUSB_ENABLE_TRANSFER_EVENT.
+ */
+
+#ifndef USBCFG_H
+#define USBCFG_H
+
+#define USB_SUPPORT_HOST
+
+#define USB_PING_PONG_MODE                  USB_PING_PONG__FULL_PING_PONG
+
+#if defined(USB_ENABLE_TRANSFER_EVENT)
+    #define NUM_TPL_ENTRIES                 8
+    #define NUM_CLIENT_DRIVER_ENTRIES       7
+#else
+    #define NUM_TPL_ENTRIES                 6
+    #define NUM_CLIENT_DRIVER_ENTRIES       5
+#endif
+
+// The interface and endpoint lists hold pointers, which are twice as large
+// on the PC as on a PIC32, and the composite device of the lookup scenario
+// has six interfaces.
+#define USB_ENUMERATION_ARENA_SIZE          4096
+
+#define USB_NUM_CONTROL_NAKS                20
+#define USB_SUPPORT_INTERRUPT_TRANSFERS
+#define USB_NUM_INTERRUPT_NAKS              3
+#define USB_SUPPORT_BULK_TRANSFERS
+#define USB_NUM_BULK_NAKS                   10000
+#define USB_INITIAL_VBUS_CURRENT            (100/2)
+#define USB_INSERT_TIME                     (250+1)
+#define USB_HOST_APP_EVENT_HANDLER          USB_ApplicationEventHandler
+#define USB_HOST_APP_DATA_EVENT_HANDLER     USB_ApplicationDataEventHandler
+#define USB_ENABLE_1MS_EVENT                // hub driver delays
+#define USB_HUB_SUPPORT_INCLUDED
+#define USB_MAX_HUB_PORTS                   4
+
+#define USB_MAX_HID_DEVICES                 1
+#define HID_MAX_DATA_FIELD_SIZE             8
+#define USB_HID_MAX_PARSER_MEMORY           2048
+#define USB_MAX_MASS_STORAGE_DEVICES        1
+#define USB_MSD_QUEUE_DEPTH                 4
+
+// The blocking calls of the SCSI layer, usb_host_msd_scsi.c, run the host
+// stack while they wait.  Here that has to move the simulated bus as well.
+#define USBTasks()                          SimUSBTasks()
+void SimUSBTasks(void);
+
+#define USB_MAX_CDC_DEVICES                 1
+#define USB_CDC_BAUDRATE_SUPPORTED          115200UL
+#define USB_CDC_PARITY_TYPE                 0
+#define USB_CDC_STOP_BITS                   0
+#define USB_CDC_NO_OF_DATA_BITS             8
+#define USB_CDC_RX_BUFFER_SIZE              1024
+#define USB_CDC_TX_QUEUE_DEPTH              8
+
+#if defined(USB_ENABLE_TRANSFER_EVENT)
+    #define USB_SUPPORT_ISOCHRONOUS_TRANSFERS
+    #define USB_ENABLE_ISOC_TRANSFER_EVENT      // one event per packet, see the audio scenario
+    #define USB_MAX_ISOCHRONOUS_DATA_BUFFERS    8
+    #define USB_MAX_AUDIO_DEVICES           1
+    #define USB_AUDIO_RATE_MATCHING
+#endif
+
+#endif
@@ -0,0 +1,1995 @@
+/*
+ * usbhostsim - run the USB host stack against simulated devices
+ *
+ * Usage: usbhostsim [-v] [keyboard|disk|scsi|serial|lookup|hotplug|hub|hubclass|audio|drift|android ...]
+ *
+ *   -v  print the host events as they happen
+ *
+ * usb_host.c, the HID, MSD, CDC and hub client drivers and the SCSI layer of
+ * the MSD driver are built for the
+ * simulated host controller (src/usb/usb_hal_sim.h) and run against
+ * software device models (sim_*.c).  Each scenario attaches one device,
+ * waits for it to enumerate, moves data through its class driver, checks
+ * the result and detaches it again.  With no arguments all scenarios run.
+ *
+ * Bus timing comes from the virtual clock of the simulated controller, so
+ * enumeration time and throughput are those of a full speed bus and are
+ * identical from run to run.  The CPU time spent in USBHostTasks() is
+ * measured on the PC running the program.
+ *
+ * The scsi scenario drives the disk through the SCSI layer, without and
+ * with its sector cache (see sim_scsi_cached.c): it times sequential single
+ * sector transfers with both, and checks random reads and writes through
+ * the cache against a shadow copy of the disk.
+ *
+ * The serial scenario sends messages of a header and a payload through the
+ * loopback device.  It then times them sent gathered from the two buffers
+ * and copied into one, to a device that only takes the data.
+ *
+ * The lookup scenario enumerates a composite device and times the
+ * endpoint table of _USB_FindEndpoint() against the interface list walk it
+ * replaced, _USB_FindEndpointInList().  The hotplug scenario attaches and
+ * detaches the devices over and over and checks the enumeration arena.
+ * The hub scenario plugs devices into the ports of a hub model and checks
+ * the port events, also while the hub stalls its requests.  The hubclass
+ * scenario puts the keyboard, the disk and the serial device behind the hub
+ * and runs their class drivers at the same time.
+ *
+ * The audio and drift scenarios need isochronous transfers, and the android
+ * scenario needs transfer events; they are only built with
+ * -DUSB_ENABLE_TRANSFER_EVENT, see usb_config.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "system.h"
+#include "system_config.h"
+#include <usb/usb.h>
+#include <usb/usb_host_hid.h>
+#include <usb/usb_host_msd.h>
+#include <usb/usb_host_msd_scsi.h>
+#include <usb/usb_host_cdc.h>
+#include <usb/usb_host_cdc_interface.h>
+#include <usb/usb_host_hub.h>
+#include <usb/src/usb_host_local.h>
+#if defined(USB_SUPPORT_ISOCHRONOUS_TRANSFERS)
+#include <usb/usb_host_audio_v1.h>
+#endif
+#if defined(USB_ENABLE_TRANSFER_EVENT)
+#include <usb/usb_host_android.h>
+#endif
+
+#include "sim_devices.h"
+#include "sim_scsi_cached.h"
+
+#define SIM_TIMEOUT_NS          (30ull * 1000000000ull)     /* per scenario */
+#define SIM_DETACH_NS           (100ull * 1000000ull)
+
+#define DISK_BLOCKS_PER_IO      8
+#define SCSI_OPERATIONS         3000    /* random reads and writes */
+#define SCSI_MAX_SECTORS        8       /* per multi-sector call */
+#define SCSI_SEED               0x2545F491u
+#define SERIAL_BYTES            16384
+#define SERIAL_CHUNK            64
+#define SERIAL_HEADER           8
+#define SERIAL_MESSAGE          256
+
+#define LOOKUP_ROUNDS           20000   /* lookups of all 256 addresses */
+#define HOTPLUG_CYCLES          25
+#define HOTPLUG_RECONFIGURE     3       /* SET CONFIGURATIONs per composite attach */
+
+#define AUDIO_STREAM_MS         2000
+#define AUDIO_BUSY_EVERY_MS     250
+#define AUDIO_BUSY_MS           5
+#define AUDIO_STALL_MS          10      /* longer than the event queue is deep */
+#define AUDIO_RATE              48000
+#define DRIFT_PPM               1000
+#define DRIFT_STREAM_MS         8000
+
+#define ANDROID_TEXT            "hello, android accessory"
+#define ANDROID_MOVES_PER_KEY   4
+#define ANDROID_KEYBOARD_ID     1
+#define ANDROID_POINTER_ID      2
+#define ANDROID_BURST_NS        (24 * 1000000ull)   /* time between bursts */
+#define ANDROID_DRAIN_NS        (100 * 1000000ull)  /* time for the last reports */
+
+static bool verbose;
+
+static struct
+{
+    uint64_t    calls;          /* USBHostTasks() calls */
+    uint64_t    cpuTime;        /* ns spent in them */
+    uint64_t    start;          /* virtual time of the attach */
+    uint64_t    enumerated;     /* virtual time the class driver was ready */
+    bool        timedOut;
+    USB_SIM_STATISTICS  stats;  /* bus statistics at the attach */
+} run;
+
+static uint64_t CpuNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Runs the host stack and the bus for one step.  Returns false once the
+ * scenario has run out of time. */
+static bool Step(void)
+{
+    uint64_t    t;
+
+    t = CpuNow();
+    USBHostTasks();
+    run.cpuTime += CpuNow() - t;
+    run.calls++;
+
+    USBHostHIDTasks();
+    USBHostMSDTasks();
+    USBHostCDCTasks();
+    USBHostHubTasks();
+#if defined(USB_ENABLE_TRANSFER_EVENT)
+    AndroidTasks();
+#endif
+    USBSimStep();
+
+    if (USBSimGetTime() - run.start > SIM_TIMEOUT_NS)
+    {
+        run.timedOut = true;
+        return false;
+    }
+    return true;
+}
+
+static double Ms(uint64_t ns)
+{
+    return ns / 1000000.0;
+}
+
+static void Attach(USB_SIM_DEVICE *device)
+{
+    memset(&run, 0, sizeof(run));
+    run.start = USBSimGetTime();
+    USBSimGetStatistics(&run.stats);
+    USBSimAttach(device);
+}
+
+static void Detach(void)
+{
+    uint64_t    end;
+
+    USBSimDetach();
+    end = USBSimGetTime() + SIM_DETACH_NS;
+    while (USBSimGetTime() < end)
+    {
+        USBHostTasks();
+        USBHostHIDTasks();
+        USBHostMSDTasks();
+        USBHostCDCTasks();
+        USBHostHubTasks();
+#if defined(USB_ENABLE_TRANSFER_EVENT)
+        AndroidTasks();
+#endif
+        USBSimStep();
+    }
+}
+
+static void Report(const char *name, bool passed, const char *detail)
+{
+    USB_SIM_STATISTICS  stats;
+    uint64_t            elapsed;
+
+    USBSimGetStatistics(&stats);
+    elapsed = USBSimGetTime() - run.start;
+
+    printf("%-9s %s%s%s\n", name, passed ? "PASS" : "FAIL",
+           run.timedOut ? " (timeout)" : "", detail);
+    if (run.enumerated != 0)
+        printf("          enumeration %.1f ms\n", Ms(run.enumerated - run.start));
+    printf("          %.1f ms virtual, bus %.1f%% busy, %lu tokens, %lu NAKs, %lu stalls, %lu timeouts\n",
+           Ms(elapsed), (elapsed != 0) ? 100.0 * (stats.busTime - run.stats.busTime) / elapsed : 0.0,
+           (unsigned long)(stats.tokens - run.stats.tokens), (unsigned long)(stats.naks - run.stats.naks),
+           (unsigned long)(stats.stalls - run.stats.stalls), (unsigned long)(stats.timeouts - run.stats.timeouts));
+    printf("          USBHostTasks() %llu calls, %.0f ns each\n",
+           (unsigned long long)run.calls, (run.calls != 0) ? (double)run.cpuTime / run.calls : 0.0);
+}
+
+/* ------------------------------------------------------------------------ */
+
+/* Boot keyboard input report, compiled when the descriptor is parsed:
+   8 modifier bits and 6 key usages.  The reserved byte is constant and is
+   not part of the plan.  The shift keys are resolved to handles. */
+static HID_REPORT_PLAN  keyboardPlan;
+static HID_FIELD        keyboardFields[4];
+static HID_USAGE_HANDLE keyboardShift[2];
+static bool             keyboardCompiled;
+
+static char KeyboardChar(uint8_t *report, uint8_t length)
+{
+    static const char digits[] = "1234567890";
+    static const char shifted[] = "!@#$%^&*()";
+    HID_USER_DATA_SIZE  values[16];
+    HID_USER_DATA_SIZE  left;
+    HID_USER_DATA_SIZE  right;
+    bool                shift;
+    uint8_t             usage;
+
+    if (!keyboardCompiled || (keyboardPlan.numValues > 16) ||
+        (keyboardPlan.numValues < 9) ||
+        (USBHostHID_ApiImportReport(report, length, &keyboardPlan, values) == 0))
+        return 0;
+    if (!USBHostHID_ApiReadUsage(report, length, &keyboardShift[0], &left) ||
+        !USBHostHID_ApiReadUsage(report, length, &keyboardShift[1], &right))
+        return 0;
+    shift = (left != 0) || (right != 0);
+    usage = (uint8_t)values[8];
+
+    if ((usage >= 0x04) && (usage <= 0x1D))
+        return (shift ? 'A' : 'a') + (usage - 0x04);
+    if ((usage >= 0x1E) && (usage <= 0x27))
+        return shift ? shifted[usage - 0x1E] : digits[usage - 0x1E];
+    switch (usage)
+    {
+        case 0x28:  return '\n';
+        case 0x2B:  return '\t';
+        case 0x2C:  return ' ';
+        case 0x2D:  return '-';
+        case 0x36:  return ',';
+        case 0x37:  return '.';
+        case 0x38:  return '/';
+        default:    return 0;
+    }
+}
+
+static bool ScenarioKeyboard(void)
+{
+    static const char   text[] = "Hello, USB host 123!\n";
+    char                typed[sizeof(text)];
+    uint8_t             report[8];
+    uint8_t             length = 0;
+    uint8_t             errorCode;
+    uint8_t             count;
+    bool                reading = false;
+    char                c;
+    char                detail[64];
+
+    keyboardCompiled = false;
+    Attach(&simKeyboard);
+    while (!USBHostHIDDeviceDetect(USB_SINGLE_DEVICE_ADDRESS) && Step())
+        ;
+    run.enumerated = USBSimGetTime();
+
+    SimKeyboardType(text, USBSimGetTime() / USB_SIM_FRAME_TIME + 10);
+    while (!run.timedOut && (length < sizeof(text) - 1))
+    {
+        if (!reading)
+        {
+            reading = (USBHostHIDRead(USB_SINGLE_DEVICE_ADDRESS, 0, 0, sizeof(report), report) == USB_SUCCESS);
+        }
+        else if (USBHostHIDTransferIsComplete(USB_SINGLE_DEVICE_ADDRESS, &errorCode, &count))
+        {
+            reading = false;
+            if ((errorCode == USB_SUCCESS) && (count == sizeof(report)) &&
+                ((c = KeyboardChar(report, count)) != 0))
+            {
+                typed[length++] = c;
+            }
+        }
+        Step();
+    }
+    typed[length] = '\0';
+
+    snprintf(detail, sizeof(detail), ", %u of %u keys", length, (unsigned)(sizeof(text) - 1));
+    Report("keyboard", strcmp(typed, text) == 0, detail);
+    Detach();
+    return strcmp(typed, text) == 0;
+}
+
+/* ------------------------------------------------------------------------ */
+
+static bool DiskIo(bool write, uint32_t lba, uint16_t blocks, uint8_t *data)
+{
+    uint8_t     cdb[10] = { 0 };
+    uint8_t     errorCode;
+    uint32_t    count;
+    uint32_t    length = (uint32_t)blocks * SIM_DISK_BLOCK_SIZE;
+
+    cdb[0] = write ? 0x2A : 0x28;
+    cdb[2] = lba >> 24;
+    cdb[3] = lba >> 16;
+    cdb[4] = lba >> 8;
+    cdb[5] = lba;
+    cdb[7] = blocks >> 8;
+    cdb[8] = blocks;
+
+    while ((write ? USBHostMSDWrite(USB_SINGLE_DEVICE_ADDRESS, 0, cdb, sizeof(cdb), data, length) :
+                    USBHostMSDRead(USB_SINGLE_DEVICE_ADDRESS, 0, cdb, sizeof(cdb), data, length)) != USB_SUCCESS)
+    {
+        if (!Step())
+            return false;
+    }
+    while (!USBHostMSDTransferIsComplete(USB_SINGLE_DEVICE_ADDRESS, &errorCode, &count))
+    {
+        if (!Step())
+            return false;
+    }
+    return (errorCode == USB_SUCCESS) && (count == length);
+}
+
+#if defined(USB_MSD_QUEUE_DEPTH)
+/* Reads the whole disk with USB_MSD_QUEUE_DEPTH reads kept in the command
+ * queue, so that each CBW goes out as soon as the CSW ahead of it is in. */
+static bool DiskQueuedRead(const uint8_t *image)
+{
+    static uint8_t  buffers[USB_MSD_QUEUE_DEPTH][DISK_BLOCKS_PER_IO * SIM_DISK_BLOCK_SIZE];
+    uint8_t         cdb[10] = { 0 };
+    uint8_t         command[USB_MSD_QUEUE_DEPTH];
+    uint32_t        lba[USB_MSD_QUEUE_DEPTH];
+    uint32_t        next = 0;
+    uint32_t        done = 0;
+    uint32_t        count;
+    uint16_t        frames;
+    uint8_t         errorCode;
+    unsigned        busy = 0;
+    unsigned        k;
+
+    while (done < SIM_DISK_BLOCKS)
+    {
+        for (k = 0; k < USB_MSD_QUEUE_DEPTH; k++)
+        {
+            if ((busy & (1u << k)) == 0)
+            {
+                if (next >= SIM_DISK_BLOCKS)
+                    continue;
+                cdb[0] = 0x28;
+                cdb[2] = next >> 24;
+                cdb[3] = next >> 16;
+                cdb[4] = next >> 8;
+                cdb[5] = next;
+                cdb[8] = DISK_BLOCKS_PER_IO;
+                if (USBHostMSDQueueTransfer(USB_SINGLE_DEVICE_ADDRESS, 0, 1, cdb, sizeof(cdb),
+                        buffers[k], sizeof(buffers[k]), &command[k]) == USB_SUCCESS)
+                {
+                    lba[k] = next;
+                    next += DISK_BLOCKS_PER_IO;
+                    busy |= 1u << k;
+                }
+            }
+            else if (USBHostMSDQueuedTransferIsComplete(USB_SINGLE_DEVICE_ADDRESS, command[k], &errorCode, &count, &frames))
+            {
+                if ((errorCode != USB_SUCCESS) || (count != sizeof(buffers[k])) ||
+                    (memcmp(buffers[k], &image[lba[k] * SIM_DISK_BLOCK_SIZE], sizeof(buffers[k])) != 0))
+                    return false;
+                done += DISK_BLOCKS_PER_IO;
+                busy &= ~(1u << k);
+            }
+        }
+        if (!Step())
+            return false;
+    }
+    return true;
+}
+#endif
+
+static bool ScenarioDisk(void)
+{
+    static uint8_t  buffer[DISK_BLOCKS_PER_IO * SIM_DISK_BLOCK_SIZE];
+    uint8_t         *image = SimDiskImage();
+    uint32_t        lba;
+    uint32_t        i;
+    uint64_t        t;
+    uint64_t        writeTime;
+    uint64_t        readTime;
+    bool            passed = true;
+    char            detail[192];
+    #if defined(USB_MSD_QUEUE_DEPTH)
+    USB_MSD_QUEUE_STATS stats;
+    uint64_t        queuedTime;
+    #endif
+
+    Attach(&simDisk);
+    while ((USBHostMSDDeviceStatus(USB_SINGLE_DEVICE_ADDRESS) != USB_MSD_NORMAL_RUNNING) && Step())
+        ;
+    run.enumerated = USBSimGetTime();
+
+    t = USBSimGetTime();
+    for (lba = 0; passed && (lba < SIM_DISK_BLOCKS); lba += DISK_BLOCKS_PER_IO)
+    {
+        for (i = 0; i < sizeof(buffer); i++)
+            buffer[i] = (uint8_t)((lba * SIM_DISK_BLOCK_SIZE + i) * 7);
+        passed = DiskIo(true, lba, DISK_BLOCKS_PER_IO, buffer);
+    }
+    writeTime = USBSimGetTime() - t;
+    for (i = 0; passed && (i < sizeof(buffer)); i++)
+        passed = (image[i] == (uint8_t)(i * 7));
+
+    t = USBSimGetTime();
+    for (lba = 0; passed && (lba < SIM_DISK_BLOCKS); lba += DISK_BLOCKS_PER_IO)
+    {
+        passed = DiskIo(false, lba, DISK_BLOCKS_PER_IO, buffer) &&
+                 (memcmp(buffer, &image[lba * SIM_DISK_BLOCK_SIZE], sizeof(buffer)) == 0);
+    }
+    readTime = USBSimGetTime() - t;
+
+    snprintf(detail, sizeof(detail), ", write %.0f kB/s, read %.0f kB/s",
+             (writeTime != 0) ? SIM_DISK_BLOCKS * SIM_DISK_BLOCK_SIZE / 1.024 / Ms(writeTime) : 0.0,
+             (readTime != 0) ? SIM_DISK_BLOCKS * SIM_DISK_BLOCK_SIZE / 1.024 / Ms(readTime) : 0.0);
+
+    #if defined(USB_MSD_QUEUE_DEPTH)
+    t = USBSimGetTime();
+    passed = passed && DiskQueuedRead(image);
+    queuedTime = USBSimGetTime() - t;
+    USBHostMSDGetQueueStats(USB_SINGLE_DEVICE_ADDRESS, &stats);
+    snprintf(detail + strlen(detail), sizeof(detail) - strlen(detail),
+             ", queued read %.0f kB/s\n          queue depth %u, high water %u, %lu commands, latency %.1f avg %u max frames",
+             (queuedTime != 0) ? SIM_DISK_BLOCKS * SIM_DISK_BLOCK_SIZE / 1.024 / Ms(queuedTime) : 0.0,
+             stats.depth, stats.highWater, (unsigned long)stats.commands,
+             (stats.commands != 0) ? (double)stats.totalFrames / stats.commands : 0.0, stats.maxFrames);
+    #endif
+    Report("disk", passed, passed ? detail : "");
+    Detach();
+    return passed;
+}
+
+/* ------------------------------------------------------------------------ */
+
+/* One copy of the SCSI layer, see sim_scsi_cached.c. */
+typedef struct
+{
+    FILEIO_MEDIA_INFORMATION *(*mediaInitialize)(uint8_t *address);
+    uint8_t (*sectorRead)(uint8_t *address, uint32_t sectorAddress, uint8_t *dataBuffer);
+    uint8_t (*sectorWrite)(uint8_t *address, uint32_t sectorAddress, uint8_t *dataBuffer, uint8_t allowWriteToZero);
+    uint8_t (*sectorsRead)(uint8_t *address, uint32_t sectorAddress, uint16_t sectorCount, uint8_t *dataBuffer);
+    uint8_t (*sectorsWrite)(uint8_t *address, uint32_t sectorAddress, uint16_t sectorCount, uint8_t *dataBuffer, uint8_t allowWriteToZero);
+    uint8_t (*cacheFlush)(uint8_t *address);
+} SCSI_LAYER;
+
+static const SCSI_LAYER scsiUncached =
+{
+    USBHostMSDSCSIMediaInitialize, USBHostMSDSCSISectorRead, USBHostMSDSCSISectorWrite,
+    USBHostMSDSCSISectorsRead, USBHostMSDSCSISectorsWrite, USBHostMSDSCSICacheFlush
+};
+
+static const SCSI_LAYER scsiCached =
+{
+    SimCachedSCSIMediaInitialize, SimCachedSCSISectorRead, SimCachedSCSISectorWrite,
+    SimCachedSCSISectorsRead, SimCachedSCSISectorsWrite, SimCachedSCSICacheFlush
+};
+
+static uint8_t  scsiAddress = USB_SINGLE_DEVICE_ADDRESS;
+static uint32_t scsiRandom;
+
+/* USBTasks() of the SCSI layer, see usb_config.h.  Its calls block until
+ * the device answers, so a device that never does ends the program. */
+void SimUSBTasks(void)
+{
+    if (!Step())
+    {
+        fprintf(stderr, "usbhostsim: SCSI layer timed out\n");
+        exit(1);
+    }
+}
+
+static uint32_t ScsiRandom(void)
+{
+    scsiRandom ^= scsiRandom << 13;
+    scsiRandom ^= scsiRandom >> 17;
+    scsiRandom ^= scsiRandom << 5;
+    return scsiRandom;
+}
+
+static bool ScsiMediaInitialize(const SCSI_LAYER *layer)
+{
+    FILEIO_MEDIA_INFORMATION    *media = layer->mediaInitialize(&scsiAddress);
+
+    return (media->errorCode == MEDIA_NO_ERROR) && media->validityFlags.bits.sectorSize &&
+           (media->sectorSize == SIM_DISK_BLOCK_SIZE);
+}
+
+/* Writes the whole disk with single sector calls and flushes the cache, or
+ * reads it back and checks it.  Returns the virtual time taken, 0 on error. */
+static uint64_t ScsiSequential(const SCSI_LAYER *layer, bool write, uint8_t seed)
+{
+    uint8_t     buffer[SIM_DISK_BLOCK_SIZE];
+    uint8_t     *image = SimDiskImage();
+    uint64_t    t = USBSimGetTime();
+    uint32_t    lba;
+    uint32_t    i;
+
+    for (lba = 0; lba < SIM_DISK_BLOCKS; lba++)
+    {
+        for (i = 0; i < sizeof(buffer); i++)
+            buffer[i] = (uint8_t)((lba * SIM_DISK_BLOCK_SIZE + i) * 13 + seed);
+        if (write)
+        {
+            if (!layer->sectorWrite(&scsiAddress, lba, buffer, true))
+                return 0;
+        }
+        else
+        {
+            memset(buffer, 0, sizeof(buffer));
+            if (!layer->sectorRead(&scsiAddress, lba, buffer) ||
+                (memcmp(buffer, &image[lba * SIM_DISK_BLOCK_SIZE], sizeof(buffer)) != 0))
+                return 0;
+        }
+    }
+    if (write && !layer->cacheFlush(&scsiAddress))
+        return 0;
+    return USBSimGetTime() - t;
+}
+
+/* Random single and multi-sector reads and writes, checked against a
+ * shadow copy of the disk.  Writes that have not been flushed are only in
+ * the cache, so the reads see them only if the cache is coherent. */
+static bool ScsiRandomTransfers(const SCSI_LAYER *layer, uint8_t *shadow)
+{
+    static uint8_t  buffer[SCSI_MAX_SECTORS * SIM_DISK_BLOCK_SIZE];
+    uint32_t        operation;
+    uint32_t        r;
+    uint32_t        lba;
+    uint32_t        length;
+    uint32_t        i;
+    uint16_t        count;
+    bool            write;
+    bool            multiple;
+
+    for (operation = 0; operation < SCSI_OPERATIONS; operation++)
+    {
+        r = ScsiRandom();
+        lba = r % SIM_DISK_BLOCKS;
+        write = (r & 0x100) != 0;
+        multiple = (r & 0x200) != 0;
+        count = multiple ? (uint16_t)(1 + (r >> 12) % SCSI_MAX_SECTORS) : 1;
+        if (lba + count > SIM_DISK_BLOCKS)
+            count = (uint16_t)(SIM_DISK_BLOCKS - lba);
+        length = (uint32_t)count * SIM_DISK_BLOCK_SIZE;
+
+        if (write)
+        {
+            for (i = 0; i < length; i++)
+                buffer[i] = (uint8_t)ScsiRandom();
+            memcpy(&shadow[lba * SIM_DISK_BLOCK_SIZE], buffer, length);
+            if (!(multiple ? layer->sectorsWrite(&scsiAddress, lba, count, buffer, true) :
+                             layer->sectorWrite(&scsiAddress, lba, buffer, true)))
+                return false;
+        }
+        else
+        {
+            memset(buffer, 0, length);
+            if (!(multiple ? layer->sectorsRead(&scsiAddress, lba, count, buffer) :
+                             layer->sectorRead(&scsiAddress, lba, buffer)) ||
+                (memcmp(buffer, &shadow[lba * SIM_DISK_BLOCK_SIZE], length) != 0))
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool ScenarioScsi(void)
+{
+    static uint8_t  shadow[SIM_DISK_BLOCKS * SIM_DISK_BLOCK_SIZE];
+    uint8_t         *image = SimDiskImage();
+    uint64_t        uncachedWrite = 0;
+    uint64_t        uncachedRead = 0;
+    uint64_t        cachedWrite = 0;
+    uint64_t        cachedRead = 0;
+    bool            passed;
+    char            detail[256];
+
+    Attach(&simDisk);
+    while ((USBHostMSDDeviceStatus(USB_SINGLE_DEVICE_ADDRESS) != USB_MSD_NORMAL_RUNNING) && Step())
+        ;
+    run.enumerated = USBSimGetTime();
+
+    passed = !run.timedOut && ScsiMediaInitialize(&scsiUncached) && ScsiMediaInitialize(&scsiCached);
+
+    /* The copies do not see each other's writes, so each one works on the
+     * disk only after the other has flushed, and the cached copy drops its
+     * cache first by initializing the media again. */
+    passed = passed && ((uncachedWrite = ScsiSequential(&scsiUncached, true, 1)) != 0) &&
+                       ((uncachedRead = ScsiSequential(&scsiUncached, false, 1)) != 0) &&
+                       ScsiMediaInitialize(&scsiCached) &&
+                       ((cachedWrite = ScsiSequential(&scsiCached, true, 2)) != 0) &&
+                       ((cachedRead = ScsiSequential(&scsiCached, false, 2)) != 0);
+    passed = passed && (cachedWrite < uncachedWrite) && (cachedRead < uncachedRead);
+
+    memcpy(shadow, image, sizeof(shadow));
+    scsiRandom = SCSI_SEED;
+    passed = passed && ScsiRandomTransfers(&scsiCached, shadow) &&
+             scsiCached.cacheFlush(&scsiAddress) && (memcmp(image, shadow, sizeof(shadow)) == 0);
+
+    snprintf(detail, sizeof(detail), ", %u random transfers\n"
+             "          %u single sector writes %.0f ms, reads %.0f ms; with %u cache sectors %.0f ms, %.0f ms",
+             SCSI_OPERATIONS, SIM_DISK_BLOCKS, Ms(uncachedWrite), Ms(uncachedRead),
+             SIM_SCSI_CACHE_SECTORS, Ms(cachedWrite), Ms(cachedRead));
+    Report("scsi", passed, passed ? detail : "");
+    Detach();
+    return passed;
+}
+
+/* ------------------------------------------------------------------------ */
+
+#if defined(USB_CDC_RX_BUFFER_SIZE) && defined(USB_CDC_TX_QUEUE_DEPTH)
+/* Sends the stream as messages of a header and a payload and checks the
+ * loopback, or with capture the data the device got.  Gathered, both go out
+ * straight from the stream buffer, queued behind the messages still being
+ * sent.  Otherwise each message is copied into one buffer and sent once the
+ * last one has gone. */
+static bool SerialMessages(const uint8_t *stream, bool gather, bool capture)
+{
+    static uint8_t      copy[SERIAL_MESSAGE];
+    static uint8_t      received[SERIAL_CHUNK];
+    static uint8_t      captured[SERIAL_BYTES];
+    USB_CDC_TX_SEGMENT  message[2];
+    uint32_t            total = 0;
+    uint32_t            checked = 0;
+    uint16_t            n;
+    uint16_t            i;
+    uint8_t             errorCode;
+    uint8_t             size;
+    bool                sending = false;
+    bool                passed = true;
+
+    if (capture)
+        SimSerialCapture(captured, sizeof(captured));
+    while (passed && (capture ? (sending || (SimSerialCaptured() < SERIAL_BYTES)) : (checked < SERIAL_BYTES)))
+    {
+        /* A main loop runs faster than the bus, so the send that has just
+           completed is seen before the next transaction, not a frame later
+           once the bus has gone idle. */
+        USBHostTasks();
+        USBHostCDCTasks();
+        if (sending && USBHostCDC_ApiTransferIsComplete(&errorCode, &size))
+        {
+            sending = false;
+            passed = (errorCode == USB_SUCCESS);
+        }
+        while (passed && (total < SERIAL_BYTES) && (gather || !sending))
+        {
+            if (gather)
+            {
+                message[0].data = &stream[total];
+                message[0].length = SERIAL_HEADER;
+                message[1].data = &stream[total + SERIAL_HEADER];
+                message[1].length = SERIAL_MESSAGE - SERIAL_HEADER;
+                if (!USBHostCDC_Api_Send_OUT_Segments(message, 2))
+                    break;
+            }
+            else
+            {
+                memcpy(copy, &stream[total], SERIAL_HEADER);
+                memcpy(&copy[SERIAL_HEADER], &stream[total + SERIAL_HEADER], SERIAL_MESSAGE - SERIAL_HEADER);
+                if (!USBHostCDC_Api_Send_OUT_Data(SERIAL_MESSAGE, copy))
+                    break;
+            }
+            sending = true;
+            total += SERIAL_MESSAGE;
+        }
+        while (passed && ((n = USBHostCDC_Api_Read_IN_Data(sizeof(received), received)) != 0))
+        {
+            for (i = 0; passed && (i < n); i++, checked++)
+                passed = (received[i] == stream[checked]);
+        }
+        if (!Step())
+            passed = false;
+    }
+    if (capture)
+    {
+        SimSerialCapture(NULL, 0);
+        passed = passed && (memcmp(captured, stream, SERIAL_BYTES) == 0);
+    }
+    return passed;
+}
+#endif
+
+static bool ScenarioSerial(void)
+{
+    uint32_t        i;
+    uint64_t        t;
+    bool            passed = true;
+    char            detail[192];
+#if defined(USB_CDC_RX_BUFFER_SIZE)
+    USB_CDC_RX_STATS    stats;
+#endif
+#if defined(USB_CDC_RX_BUFFER_SIZE) && defined(USB_CDC_TX_QUEUE_DEPTH)
+    static uint8_t  stream[SERIAL_BYTES];
+    uint64_t        gatherTime;
+    uint64_t        copyTime;
+#else
+    static uint8_t  sent[SERIAL_CHUNK];
+    static uint8_t  received[SERIAL_CHUNK];
+    uint32_t        total;
+    uint8_t         errorCode;
+    uint8_t         count;
+    #if defined(USB_CDC_RX_BUFFER_SIZE)
+    uint32_t        checked = 0;
+    uint16_t        n;
+    bool            sending = false;
+    #endif
+#endif
+
+    Attach(&simSerial);
+    while (!USBHostCDC_ApiDeviceDetect() && Step())
+        ;
+    run.enumerated = USBSimGetTime();
+
+#if defined(USB_CDC_RX_BUFFER_SIZE) && defined(USB_CDC_TX_QUEUE_DEPTH)
+    for (i = 0; i < SERIAL_BYTES; i++)
+        stream[i] = (uint8_t)(i / SERIAL_CHUNK * SERIAL_CHUNK + (i % SERIAL_CHUNK) * 3);
+#endif
+
+    t = USBSimGetTime();
+#if defined(USB_CDC_RX_BUFFER_SIZE) && defined(USB_CDC_TX_QUEUE_DEPTH)
+    passed = SerialMessages(stream, true, false);
+    t = USBSimGetTime() - t;
+
+    /* Looped back, both ways run at the rate the loopback data is read, so
+       the send paths are compared with the device only taking the data.
+       Each starts with a frame, so both get the same share of the bus, and
+       gathering must not be the slower. */
+    while ((USBSimGetTime() % 1000000ull != 0) && Step())
+        ;
+    gatherTime = USBSimGetTime();
+    passed = passed && SerialMessages(stream, true, true);
+    gatherTime = USBSimGetTime() - gatherTime;
+    while ((USBSimGetTime() % 1000000ull != 0) && Step())
+        ;
+    copyTime = USBSimGetTime();
+    passed = passed && SerialMessages(stream, false, true);
+    copyTime = USBSimGetTime() - copyTime;
+    passed = passed && (gatherTime <= copyTime);
+#elif defined(USB_CDC_RX_BUFFER_SIZE)
+    /* The driver receives in the background, so the next chunk is sent while
+       the loopback data of the last one is still coming in. */
+    for (total = 0; passed && (checked < SERIAL_BYTES); )
+    {
+        if (sending && USBHostCDC_ApiTransferIsComplete(&errorCode, &count))
+        {
+            sending = false;
+            passed = (errorCode == USB_SUCCESS);
+            total += SERIAL_CHUNK;
+        }
+        if (!sending && (total < SERIAL_BYTES))
+        {
+            for (i = 0; i < SERIAL_CHUNK; i++)
+                sent[i] = (uint8_t)(total + i * 3);
+            sending = USBHostCDC_Api_Send_OUT_Data(SERIAL_CHUNK, sent);
+        }
+        while (passed && ((n = USBHostCDC_Api_Read_IN_Data(sizeof(received), received)) != 0))
+        {
+            for (i = 0; passed && (i < n); i++, checked++)
+                passed = (received[i] == (uint8_t)(checked / SERIAL_CHUNK * SERIAL_CHUNK + (checked % SERIAL_CHUNK) * 3));
+        }
+        if (!Step())
+            passed = false;
+    }
+#else
+    for (total = 0; passed && (total < SERIAL_BYTES); total += SERIAL_CHUNK)
+    {
+        for (i = 0; i < SERIAL_CHUNK; i++)
+            sent[i] = (uint8_t)(total + i * 3);
+
+        while (!USBHostCDC_Api_Send_OUT_Data(SERIAL_CHUNK, sent) && Step())
+            ;
+        while (!USBHostCDC_ApiTransferIsComplete(&errorCode, &count) && Step())
+            ;
+        passed = !run.timedOut && (errorCode == USB_SUCCESS);
+
+        while (passed && !USBHostCDC_Api_Get_IN_Data(SERIAL_CHUNK, received) && Step())
+            ;
+        while (passed && !USBHostCDC_ApiTransferIsComplete(&errorCode, &count) && Step())
+            ;
+        passed = passed && !run.timedOut && (errorCode == USB_SUCCESS) && (count == SERIAL_CHUNK) &&
+                 (memcmp(sent, received, SERIAL_CHUNK) == 0);
+    }
+    t = USBSimGetTime() - t;
+#endif
+
+    snprintf(detail, sizeof(detail), ", %lu baud, loopback %.0f kB/s",
+             (unsigned long)SimSerialLineRate(), (t != 0) ? SERIAL_BYTES / 1.024 / Ms(t) : 0.0);
+#if defined(USB_CDC_RX_BUFFER_SIZE) && defined(USB_CDC_TX_QUEUE_DEPTH)
+    snprintf(detail + strlen(detail), sizeof(detail) - strlen(detail),
+             "\n          %u byte messages of %u + %u bytes sent gathered %.0f kB/s, copied %.0f kB/s",
+             SERIAL_MESSAGE, SERIAL_HEADER, SERIAL_MESSAGE - SERIAL_HEADER,
+             (gatherTime != 0) ? SERIAL_BYTES / 1.024 / Ms(gatherTime) : 0.0,
+             (copyTime != 0) ? SERIAL_BYTES / 1.024 / Ms(copyTime) : 0.0);
+#endif
+#if defined(USB_CDC_RX_BUFFER_SIZE)
+    USBHostCDCGetRxStats(USB_SINGLE_DEVICE_ADDRESS, &stats);
+    snprintf(detail + strlen(detail), sizeof(detail) - strlen(detail),
+             "\n          receive ring %u bytes, high water %u, %u overruns, %u errors",
+             stats.size, stats.highWater, stats.overruns, stats.errors);
+#endif
+    Report("serial", passed, passed ? detail : "");
+    Detach();
+    return passed;
+}
+
+/* ------------------------------------------------------------------------ */
+
+#if defined(USB_SUPPORT_ISOCHRONOUS_TRANSFERS)
+static struct
+{
+    USB_AUDIO_V1_DEVICE_ID  id;
+    bool        attached;
+    bool        interfaceSet;
+    bool        frequencySet;
+    unsigned    watermarkCalls;
+} audio;
+
+static void AudioWatermark(ISOCHRONOUS_DATA *isocData, uint8_t fillLevel)
+{
+    (void)isocData;
+    (void)fillLevel;
+    audio.watermarkCalls++;
+}
+
+/* Ends the stream.  A token already on the bus still completes into the
+ * buffers, so the frame is let end before they can be freed. */
+static void AudioStop(void)
+{
+    uint64_t    frame;
+
+    USBHostAudioV1TerminateTransfer(audio.id.deviceAddress);
+    frame = USBSimGetTime() / USB_SIM_FRAME_TIME;
+    while (USBSimGetTime() / USB_SIM_FRAME_TIME == frame)
+        Step();
+}
+
+/* Streams the microphone for AUDIO_STREAM_MS into a ring of depth buffers,
+ * with the main loop too busy to take them for AUDIO_BUSY_MS every
+ * AUDIO_BUSY_EVERY_MS.  The samples are a running counter, so every sample
+ * that was lost shows as a gap.  Each skipped frame must be counted as an
+ * overrun, and must be the only cause of lost samples.
+ *
+ * If stall is set, the main loop is instead stopped for AUDIO_STALL_MS, so
+ * USBHostTasks() does not run either and the transfer events of the
+ * interrupt pile up in the event queue.  Without a stall the queue must
+ * never fill; with one it must overflow, and the samples must still all be
+ * accounted for, since the buffers are filled by the interrupt. */
+static bool AudioStream(uint8_t depth, bool stall, char *detail, size_t size)
+{
+    static ISOCHRONOUS_DATA isoc;
+    ISOCHRONOUS_DATA_BUFFER *buffer;
+    uint64_t    start;
+    uint64_t    ms;
+    uint32_t    samples = 0;
+    uint32_t    lost = 0;
+    uint32_t    skipped = 0;
+    uint16_t    first;
+    uint16_t    expected = 0;
+    uint16_t    frame = 0;
+    uint16_t    busyMs = stall ? AUDIO_STALL_MS : AUDIO_BUSY_MS;
+    USB_EVENT_QUEUE_STATS   before;
+    USB_EVENT_QUEUE_STATS   after;
+    bool        started = false;
+    bool        passed;
+
+    USBHostGetEventQueueStats(&before);
+    memset(&isoc, 0, sizeof(isoc));
+    if (!USBHostIsochronousBuffersCreate(&isoc, depth, audio.id.audioDataPacketSize))
+        return false;
+    isoc.watermark = depth / 2;
+    isoc.pWatermarkHandler = AudioWatermark;
+    audio.watermarkCalls = 0;
+
+    passed = (USBHostAudioV1ReceiveAudioData(audio.id.deviceAddress, &isoc) == USB_SUCCESS);
+    start = USBSimGetTime();
+    while (passed && ((ms = (USBSimGetTime() - start) / 1000000) < AUDIO_STREAM_MS))
+    {
+        while ((ms % AUDIO_BUSY_EVERY_MS >= busyMs) &&
+               ((buffer = USBHostIsochronousBufferGet(&isoc)) != NULL))
+        {
+            if (buffer->dataLength != 0)
+            {
+                first = buffer->pBuffer[0] | (buffer->pBuffer[1] << 8);
+                if (started)
+                {
+                    lost += (uint16_t)(first - expected);
+                    skipped += (uint16_t)(buffer->frameNumber - frame - 1);
+                }
+                started = true;
+                expected = first + buffer->dataLength / 2;
+                frame = buffer->frameNumber;
+                samples += buffer->dataLength / 2;
+            }
+            USBHostIsochronousBufferRelease(&isoc);
+        }
+        if (stall && (ms % AUDIO_BUSY_EVERY_MS < busyMs))
+            USBSimStep();                       /* only the interrupt runs */
+        else
+            passed = Step();
+    }
+    AudioStop();
+    USBHostGetEventQueueStats(&after);
+
+    passed = passed && (samples > (AUDIO_STREAM_MS - busyMs) * (AUDIO_RATE / 1000) / 2) &&
+             (skipped == isoc.overruns) && (lost == skipped * (AUDIO_RATE / 1000)) &&
+             (stall ? ((after.overflows != before.overflows) && (after.highWater == after.depth)) :
+                      ((after.overflows == before.overflows) && (after.highWater < after.depth)));
+    snprintf(detail, size, "\n          %u buffers%s: %lu samples, %lu lost, %u overruns, high water %u, %u watermark calls"
+             "\n            event queue %u deep, high water %u, %u overflows",
+             depth, stall ? ", stalled" : "", (unsigned long)samples, (unsigned long)lost, isoc.overruns, isoc.highWater,
+             audio.watermarkCalls, after.depth, after.highWater, (unsigned)(after.overflows - before.overflows));
+    USBHostIsochronousBuffersDestroy(&isoc, depth);
+    return passed;
+}
+
+/* Attaches the microphone and selects its streaming interface and rate. */
+static bool AudioAttach(void)
+{
+    static uint8_t  frequency[3] = { (uint8_t)AUDIO_RATE, (uint8_t)(AUDIO_RATE >> 8), (uint8_t)(AUDIO_RATE >> 16) };
+    bool            passed;
+
+    memset(&audio, 0, sizeof(audio));
+    Attach(&simMicrophone);
+    while (!audio.attached && Step())
+        ;
+    run.enumerated = USBSimGetTime();
+
+    passed = !run.timedOut && (USBHostAudioV1SetInterfaceFullBandwidth(audio.id.deviceAddress) == USB_SUCCESS);
+    while (passed && !audio.interfaceSet && Step())
+        ;
+    passed = passed && !run.timedOut &&
+             (USBHostAudioV1SetSamplingFrequency(audio.id.deviceAddress, frequency) == USB_SUCCESS);
+    while (passed && !audio.frequencySet && Step())
+        ;
+    return passed && !run.timedOut;
+}
+
+static bool ScenarioAudio(void)
+{
+    char            detail[768];
+    bool            passed;
+
+    passed = AudioAttach();
+
+    /* Two buffers cannot cover the busy main loop, the full ring can.  A
+     * stalled main loop overflows the event queue. */
+    detail[0] = '\0';
+    if (passed)
+    {
+        AudioStream(2, false, detail, sizeof(detail) / 3);
+        passed = AudioStream(USB_MAX_ISOCHRONOUS_DATA_BUFFERS, false, detail + strlen(detail), sizeof(detail) / 3) &&
+                 AudioStream(USB_MAX_ISOCHRONOUS_DATA_BUFFERS, true, detail + strlen(detail), sizeof(detail) / 3);
+    }
+    Report("audio", passed, detail);
+    Detach();
+    return passed;
+}
+
+#if defined(USB_AUDIO_RATE_MATCHING)
+/* Records DRIFT_STREAM_MS from the microphone with its clock ppm off the
+ * host's, taking AUDIO_RATE / 1000 samples every millisecond by the host's
+ * clock, as a codec running from the host's crystal would.  Reading starts
+ * once half the ring is filled.  Taken as received, the samples the clocks
+ * differ by pile up in the ring, or drain it, until it overruns or runs dry.
+ * Taken through USBHostAudioV1ReadSamples() they are resampled to the
+ * host's clock and the ring stays half full.  Resampled, the counter the
+ * microphone sends must rise by 0 to 2 from one sample to the next. */
+static bool DriftStream(int32_t ppm, bool resample, char *detail, size_t size)
+{
+    static ISOCHRONOUS_DATA isoc;
+    static int16_t          samples[AUDIO_RATE / 1000];
+    ISOCHRONOUS_DATA_BUFFER *buffer;
+    USB_AUDIO_V1_RATE_INFO  rate;
+    const uint8_t   depth = USB_MAX_ISOCHRONOUS_DATA_BUFFERS;
+    uint64_t        start;
+    uint64_t        ms;
+    uint64_t        taken = 0;
+    uint32_t        short_ = 0;
+    uint32_t        glitches = 0;
+    uint16_t        offset = 0;
+    uint16_t        got;
+    uint16_t        k;
+    int16_t         last = 0;
+    bool            started = false;
+    uint8_t         fill;
+    uint8_t         minFill = 0xFF;
+    uint8_t         maxFill = 0;
+    bool            reading = false;
+    bool            passed;
+
+    SimMicrophoneSetDrift(ppm);
+    memset(&isoc, 0, sizeof(isoc));
+    if (!USBHostIsochronousBuffersCreate(&isoc, depth, audio.id.audioDataPacketSize))
+        return false;
+
+    passed = (USBHostAudioV1ReceiveAudioData(audio.id.deviceAddress, &isoc) == USB_SUCCESS);
+    start = USBSimGetTime();
+    while (passed && ((ms = (USBSimGetTime() - start) / 1000000) < DRIFT_STREAM_MS))
+    {
+        if (!reading)
+        {
+            reading = (USBHostIsochronousBuffersFilled(&isoc) >= depth / 2);
+            taken = ms;
+        }
+        for ( ; reading && (taken < ms); taken++)
+        {
+            if (resample)
+            {
+                got = USBHostAudioV1ReadSamples(audio.id.deviceAddress, samples, AUDIO_RATE / 1000);
+            }
+            else
+            {
+                for (got = 0; (got < AUDIO_RATE / 1000) && ((buffer = USBHostIsochronousBufferGet(&isoc)) != NULL); )
+                {
+                    if (offset + 2 <= buffer->dataLength)
+                    {
+                        samples[got++] = (int16_t)(buffer->pBuffer[offset] | (buffer->pBuffer[offset + 1] << 8));
+                        offset += 2;
+                    }
+                    if (offset + 2 > buffer->dataLength)
+                    {
+                        USBHostIsochronousBufferRelease(&isoc);
+                        offset = 0;
+                    }
+                }
+            }
+            short_ += AUDIO_RATE / 1000 - got;
+
+            /* Interpolating across the wrap of the counter is not a glitch. */
+            for (k = 0; k < got; k++)
+            {
+                if (started && ((uint16_t)(samples[k] - last) > 2) && (last < 32000) && (samples[k] > -32000))
+                    glitches++;
+                last = samples[k];
+                started = true;
+            }
+
+            fill = USBHostIsochronousBuffersFilled(&isoc);
+            minFill = (fill < minFill) ? fill : minFill;
+            maxFill = (fill > maxFill) ? fill : maxFill;
+        }
+        passed = Step();
+    }
+    AudioStop();
+    SimMicrophoneSetDrift(0);
+
+    USBHostAudioV1GetRateInfo(audio.id.deviceAddress, &rate);
+    snprintf(detail, size, "\n          %+5ld ppm %s: %u overruns, %lu samples short, %lu glitches, ring %u..%u of %u",
+             (long)ppm, resample ? "resampled" : "as received", isoc.overruns, (unsigned long)short_,
+             (unsigned long)glitches, minFill, maxFill, depth);
+    if (resample)
+    {
+        snprintf(detail + strlen(detail), size - strlen(detail), ", measured %.2f Hz",
+                 rate.measuredRate / 256.0);
+        passed = passed && (isoc.overruns == 0) && (short_ == 0) && (glitches == 0) &&
+                 (rate.measuredRate / 256.0 > AUDIO_RATE * (1.0 + ppm / 1e6) - 1.0) &&
+                 (rate.measuredRate / 256.0 < AUDIO_RATE * (1.0 + ppm / 1e6) + 1.0);
+    }
+    USBHostIsochronousBuffersDestroy(&isoc, depth);
+    return passed;
+}
+
+static bool ScenarioDrift(void)
+{
+    char            detail[768];
+    bool            passed;
+
+    passed = AudioAttach();
+
+    /* Taken as received, the fast microphone overruns the ring; resampled,
+       neither a fast nor a slow one does. */
+    detail[0] = '\0';
+    if (passed)
+    {
+        DriftStream(DRIFT_PPM, false, detail, sizeof(detail));
+        passed = DriftStream(DRIFT_PPM, true, detail + strlen(detail), sizeof(detail) - strlen(detail)) &&
+                 DriftStream(-DRIFT_PPM, true, detail + strlen(detail), sizeof(detail) - strlen(detail));
+    }
+    Report("drift", passed, detail);
+    Detach();
+    return passed;
+}
+#endif
+#endif
+
+/* ------------------------------------------------------------------------ */
+
+#if defined(USB_ENABLE_TRANSFER_EVENT)
+static struct
+{
+    uint8_t     address;
+    bool        attached;
+    uint8_t     registered;         /* HID registrations completed */
+    uint16_t    completed;          /* EVENT_ANDROID_HID_SEND_EVENT_COMPLETE events */
+} android;
+
+static char accessoryManufacturer[] = "Microchip";
+static char accessoryModel[] = "usbhostsim";
+static char accessoryDescription[] = "Simulated accessory";
+static char accessoryVersion[] = "1.0";
+static char accessoryURI[] = "http://www.microchip.com";
+static char accessorySerial[] = "1";
+
+static ANDROID_ACCESSORY_INFORMATION accessoryInfo =
+{
+    accessoryManufacturer, sizeof(accessoryManufacturer),
+    accessoryModel, sizeof(accessoryModel),
+    accessoryDescription, sizeof(accessoryDescription),
+    accessoryVersion, sizeof(accessoryVersion),
+    accessoryURI, sizeof(accessoryURI),
+    accessorySerial, sizeof(accessorySerial),
+    ANDROID_AUDIO_MODE__NONE
+};
+
+/* Boot keyboard: 8 modifier bits, a reserved byte and 6 key usages. */
+static uint8_t androidKeyboardDescriptor[] =
+{
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7,
+    0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x95, 0x01,
+    0x75, 0x08, 0x81, 0x01, 0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x25, 0x65,
+    0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00, 0xC0
+};
+
+/* Absolute pointer: one button and 16 bit X and Y from 0 to 32767. */
+static uint8_t androidPointerDescriptor[] =
+{
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00, 0x05, 0x09,
+    0x19, 0x01, 0x29, 0x01, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x01,
+    0x81, 0x02, 0x75, 0x07, 0x81, 0x01, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31,
+    0x16, 0x00, 0x00, 0x26, 0xFF, 0x7F, 0x75, 0x10, 0x95, 0x02, 0x81, 0x02,
+    0xC0, 0xC0
+};
+
+static uint8_t AndroidUsage(char c)
+{
+    if ((c >= 'a') && (c <= 'z'))
+        return 0x04 + (c - 'a');
+    return (c == ',') ? 0x36 : 0x2C;
+}
+
+/* Queues a report, running the bus while the HID queue is full.  Returns
+ * false if the report was refused for any other reason. */
+static bool AndroidSend(bool state, uint8_t id, uint8_t *report, uint8_t length, uint32_t *busy)
+{
+    uint8_t     errorCode;
+
+    while ((errorCode = state ? AndroidAppHIDSendState(android.address, id, report, length) :
+                                AndroidAppHIDSendEvent(android.address, id, report, length)) == USB_ENDPOINT_BUSY)
+    {
+        (*busy)++;
+        if (!Step())
+            return false;
+    }
+    return (errorCode == USB_SUCCESS);
+}
+
+/* Types ANDROID_TEXT into the phone as key press and release reports, with
+ * a drag of ANDROID_MOVES_PER_KEY absolute pointer moves after each key: half
+ * of them, a button press, the other half with the button held, and a
+ * release.  Each key and its drag are queued in one burst, with
+ * ANDROID_BURST_NS between bursts.  The keys and the button changes are sent
+ * with AndroidAppHIDSendEvent() and must all arrive, in order.  The moves
+ * are sent with AndroidAppHIDSendState(), so a move still waiting at the end
+ * of the queue is replaced by the next one, but never one that a button
+ * change was queued after. */
+static bool ScenarioAndroid(void)
+{
+    static const char   text[] = ANDROID_TEXT;
+    const SIM_HID_EVENT *events;
+    uint8_t             keys[8];
+    uint8_t             pointer[5];
+    uint16_t            count;
+    uint16_t            keyReports = 0;
+    uint16_t            pointerReports = 0;
+    uint16_t            clicks = 0;         /* button presses */
+    bool                pressed = false;
+    uint16_t            x = 0;
+    uint16_t            i;
+    uint16_t            j;
+    uint32_t            busy = 0;
+    uint64_t            t;
+    uint64_t            burst;
+    uint64_t            elapsed;
+    bool                passed;
+    char                detail[192];
+
+    memset(&android, 0, sizeof(android));
+    Attach(&simAccessory);
+    while (!android.attached && Step())
+        ;
+    run.enumerated = USBSimGetTime();
+
+    passed = !run.timedOut &&
+             AndroidAppHIDRegister(android.address, ANDROID_KEYBOARD_ID, androidKeyboardDescriptor, sizeof(androidKeyboardDescriptor));
+    while (passed && (android.registered < 1) && Step())
+        ;
+    passed = passed && !run.timedOut &&
+             AndroidAppHIDRegister(android.address, ANDROID_POINTER_ID, androidPointerDescriptor, sizeof(androidPointerDescriptor));
+    while (passed && (android.registered < 2) && Step())
+        ;
+    passed = passed && !run.timedOut;
+
+    t = USBSimGetTime();
+    for (i = 0; passed && (i < sizeof(text) - 1); i++)
+    {
+        memset(keys, 0, sizeof(keys));
+        keys[2] = AndroidUsage(text[i]);
+        passed = AndroidSend(false, ANDROID_KEYBOARD_ID, keys, sizeof(keys), &busy);
+        keys[2] = 0;
+        passed = passed && AndroidSend(false, ANDROID_KEYBOARD_ID, keys, sizeof(keys), &busy);
+
+        pointer[0] = 0;
+        pointer[3] = (uint8_t)i;
+        pointer[4] = 0;
+        for (j = 0; passed && (j < ANDROID_MOVES_PER_KEY); j++)
+        {
+            if (j == ANDROID_MOVES_PER_KEY / 2)
+            {
+                pointer[0] = 1;
+                passed = AndroidSend(false, ANDROID_POINTER_ID, pointer, sizeof(pointer), &busy);
+            }
+            x += 100;
+            pointer[1] = (uint8_t)x;
+            pointer[2] = (uint8_t)(x >> 8);
+            passed = passed && AndroidSend(true, ANDROID_POINTER_ID, pointer, sizeof(pointer), &busy);
+        }
+        pointer[0] = 0;
+        passed = passed && AndroidSend(false, ANDROID_POINTER_ID, pointer, sizeof(pointer), &busy);
+
+        burst = USBSimGetTime();
+        while (passed && (USBSimGetTime() - burst < ANDROID_BURST_NS))
+            passed = Step();
+    }
+    elapsed = USBSimGetTime() - t;
+    burst = USBSimGetTime();
+    while (passed && (USBSimGetTime() - burst < ANDROID_DRAIN_NS))
+        passed = Step();
+
+    /* The key reports must arrive in order, and each pointer report after
+       the keys of its burst.  The pointer must only move forward, end at
+       the last move, and press and release the button in place once per
+       key. */
+    events = SimAccessoryEvents(&count);
+    keyReports = 0;
+    x = 0;
+    for (j = 0; passed && (j < count); j++)
+    {
+        if (events[j].id == ANDROID_KEYBOARD_ID)
+        {
+            passed = (events[j].length == sizeof(keys)) &&
+                     (events[j].report[2] == ((keyReports % 2 == 0) ? AndroidUsage(text[keyReports / 2]) : 0));
+            keyReports++;
+        }
+        else
+        {
+            uint16_t    position = events[j].report[1] | (events[j].report[2] << 8);
+
+            passed = (events[j].length == sizeof(pointer)) &&
+                     (keyReports == 2 * (events[j].report[3] + 1));
+            if ((events[j].report[0] != 0) != pressed)
+            {
+                passed = passed && (position == x);
+                pressed = !pressed;
+                clicks += pressed;
+            }
+            else
+            {
+                passed = passed && (position > x);
+                pointerReports++;
+            }
+            x = position;
+        }
+    }
+    passed = passed && (keyReports == 2 * (sizeof(text) - 1)) && !pressed &&
+             (clicks == sizeof(text) - 1) &&
+             (x == 100 * ANDROID_MOVES_PER_KEY * (sizeof(text) - 1)) &&
+             (android.completed == count) && (busy == 0);
+
+    snprintf(detail, sizeof(detail), ", %u key reports, %u of %u pointer moves sent, %lu busy, %.1f ms",
+             keyReports, pointerReports, (unsigned)(ANDROID_MOVES_PER_KEY * (sizeof(text) - 1)),
+             (unsigned long)busy, Ms(elapsed));
+    Report("android", passed, detail);
+    Detach();
+    return passed;
+}
+#endif
+
+/* ------------------------------------------------------------------------ */
+
+static struct
+{
+    uint8_t     clientDriverID;
+    bool        attached;
+} composite;
+
+bool SimCompositeInitialize(uint8_t address, uint32_t flags, uint8_t clientDriverID)
+{
+    (void)address;
+    (void)flags;
+    composite.clientDriverID = clientDriverID;
+    composite.attached = true;
+    return true;
+}
+
+bool SimCompositeEventHandler(uint8_t address, USB_EVENT event, void *data, uint32_t size)
+{
+    (void)address;
+    (void)data;
+    (void)size;
+    if (event == EVENT_DETACH)
+        composite.attached = false;
+    return true;
+}
+
+static bool LookupSetInterface(uint8_t interface, uint8_t alternate)
+{
+    uint8_t     errorCode;
+    uint32_t    count;
+
+    /* EP0 is busy until the host has finished the SET CONFIGURATION. */
+    while ((errorCode = USBHostIssueDeviceRequest(USB_SINGLE_DEVICE_ADDRESS, 0x01, USB_REQUEST_SET_INTERFACE,
+                alternate, interface, 0, NULL, USB_DEVICE_REQUEST_SET, composite.clientDriverID)) != USB_SUCCESS)
+    {
+        if ((errorCode != USB_ENDPOINT_BUSY) || !Step())
+            return false;
+    }
+    while (!USBHostTransferIsComplete(USB_SINGLE_DEVICE_ADDRESS, 0, &errorCode, &count))
+    {
+        if (!Step())
+            return false;
+    }
+    return errorCode == USB_SUCCESS;
+}
+
+/* Both lookups must give the same endpoint, or none, for every address. */
+static bool LookupCompare(unsigned *found)
+{
+    USB_DEVICE_INFO *pDevice = _USB_FindDevice(USB_SINGLE_DEVICE_ADDRESS);
+    unsigned        address;
+
+    *found = 0;
+    for (address = 0; address < 256; address++)
+    {
+        if (_USB_FindEndpoint(pDevice, address) != _USB_FindEndpointInList(pDevice, address))
+            return false;
+        *found += (_USB_FindEndpoint(pDevice, address) != NULL);
+    }
+    return true;
+}
+
+static double LookupTime(USB_ENDPOINT_INFO *(*find)(USB_DEVICE_INFO *, uint8_t))
+{
+    USB_DEVICE_INFO     *pDevice = _USB_FindDevice(USB_SINGLE_DEVICE_ADDRESS);
+    USB_ENDPOINT_INFO   *pEndpoint;
+    uint64_t            t;
+    unsigned            round;
+    unsigned            address;
+
+    t = CpuNow();
+    for (round = 0; round < LOOKUP_ROUNDS; round++)
+    {
+        for (address = 0; address < 256; address++)
+        {
+            pEndpoint = find(pDevice, address);
+            __asm__ volatile ("" : : "r" (pEndpoint) : "memory");
+        }
+    }
+    return (double)(CpuNow() - t) / (LOOKUP_ROUNDS * 256.0);
+}
+
+/* Enumerates the composite device and checks the endpoint table against
+ * the list walk with the streaming interfaces at zero bandwidth and again
+ * with both streaming, then times every endpoint address through each. */
+static bool ScenarioLookup(void)
+{
+    unsigned    idle = 0;
+    unsigned    streaming = 0;
+    double      list = 0.0;
+    double      table = 0.0;
+    bool        passed;
+    char        detail[160];
+
+    memset(&composite, 0, sizeof(composite));
+    Attach(&simComposite);
+    while (!composite.attached && Step())
+        ;
+    run.enumerated = USBSimGetTime();
+
+    passed = composite.attached && !run.timedOut && LookupCompare(&idle) &&
+             LookupSetInterface(1, 2) && LookupSetInterface(2, 1) && LookupCompare(&streaming);
+    if (passed)
+    {
+        list = LookupTime(_USB_FindEndpointInList);
+        table = LookupTime(_USB_FindEndpoint);
+    }
+    passed = passed && (idle == 7) && (streaming == 10);
+
+    snprintf(detail, sizeof(detail), ", %u then %u endpoints with EP0\n"
+             "          list walk %.2f ns, table %.2f ns per lookup (%.1fx)",
+             idle, streaming, list, table, (table > 0.0) ? list / table : 0.0);
+    Report("lookup", passed, detail);
+    Detach();
+    return passed;
+}
+
+/* ------------------------------------------------------------------------ */
+
+/* Checks the arena statistics against what the host should be holding: an
+ * attached device uses some of it, nothing has failed to fit, and the high
+ * water mark covers the current use. */
+static bool HotplugCheck(bool attached, USB_ENUMERATION_MEMORY_STATS *stats)
+{
+    USBHostGetEnumerationMemoryStats(stats);
+    return (stats->size == USB_ENUMERATION_ARENA_SIZE) && (stats->failedAllocations == 0) &&
+           (stats->used <= stats->size) && (stats->highWater >= stats->used) &&
+           (attached ? (stats->used != 0) : (stats->used == 0));
+}
+
+/* Attaches each device, waits for it to be configured and detaches it
+ * again, HOTPLUG_CYCLES times; every other cycle the device is pulled in
+ * the middle of its enumeration instead.  The arena must be empty after
+ * every detach.  The composite device is also configured again
+ * HOTPLUG_RECONFIGURE times while attached: the configuration lists are
+ * dropped back to the mark and parsed again, so the arena must hold the
+ * same number of bytes each time. */
+static bool ScenarioHotplug(void)
+{
+    static USB_SIM_DEVICE * const devices[] = { &simKeyboard, &simDisk, &simSerial, &simComposite };
+    const unsigned  numDevices = sizeof(devices) / sizeof(devices[0]);
+    USB_ENUMERATION_MEMORY_STATS    stats;
+    USB_SIM_STATISTICS  bus;
+    uint16_t        used[sizeof(devices) / sizeof(devices[0])] = { 0 };
+    uint16_t        configured;
+    uint64_t        start;
+    uint64_t        calls = 0;
+    uint64_t        cpuTime = 0;
+    uint64_t        pull;
+    unsigned        attaches = 0;
+    unsigned        midway = 0;
+    unsigned        cycle;
+    unsigned        d;
+    unsigned        k;
+    bool            passed = true;
+    char            detail[160];
+
+    start = USBSimGetTime();
+    USBSimGetStatistics(&bus);
+    for (cycle = 0; passed && (cycle < HOTPLUG_CYCLES); cycle++)
+    {
+        for (d = 0; passed && (d < numDevices); d++)
+        {
+            memset(&composite, 0, sizeof(composite));
+            Attach(devices[d]);
+            attaches++;
+            if (cycle & 1)
+            {
+                /* Pulled somewhere between the reset and SET CONFIGURATION. */
+                pull = USBSimGetTime() + (260 + (7 * cycle + 13 * d) % 90) * 1000000ull;
+                while ((USBSimGetTime() < pull) && Step())
+                    ;
+                USBHostGetEnumerationMemoryStats(&stats);
+                midway += (stats.used != 0);
+            }
+            else
+            {
+                while ((USBHostDeviceStatus(USB_SINGLE_DEVICE_ADDRESS) != USB_DEVICE_ATTACHED) && Step())
+                    ;
+                passed = !run.timedOut && HotplugCheck(true, &stats) &&
+                         ((used[d] == 0) || (stats.used == used[d]));
+                used[d] = stats.used;
+
+                for (k = 0; passed && (devices[d] == &simComposite) && (k < HOTPLUG_RECONFIGURE); k++)
+                {
+                    while (!composite.attached && Step())
+                        ;
+                    configured = stats.used;
+                    composite.attached = false;
+                    while ((USBHostSetDeviceConfiguration(USB_SINGLE_DEVICE_ADDRESS, 1) != USB_SUCCESS) && Step())
+                        ;
+                    while (!composite.attached && Step())
+                        ;
+                    passed = !run.timedOut && HotplugCheck(true, &stats) && (stats.used == configured);
+                }
+            }
+            calls += run.calls;
+            cpuTime += run.cpuTime;
+            Detach();
+            passed = passed && HotplugCheck(false, &stats);
+        }
+    }
+
+    run.start = start;
+    run.stats = bus;
+    run.enumerated = 0;
+    run.calls = calls;
+    run.cpuTime = cpuTime;
+    snprintf(detail, sizeof(detail), ", %u attaches, %u pulled while enumerating\n"
+             "          arena %u bytes, high water %u; keyboard %u, disk %u, serial %u, composite %u",
+             attaches, midway, stats.size, stats.highWater, used[0], used[1], used[2], used[3]);
+    Report("hotplug", passed, detail);
+    return passed;
+}
+
+/* ------------------------------------------------------------------------ */
+
+static struct
+{
+    uint8_t     address;                        /* of the hub */
+    uint8_t     attached[SIM_HUB_PORTS + 1];    /* EVENT_HUB_PORT_ATTACH per port */
+    uint8_t     detached[SIM_HUB_PORTS + 1];    /* EVENT_HUB_PORT_DETACH per port */
+    uint8_t     speed[SIM_HUB_PORTS + 1];
+} hubPorts;
+
+static void HubPortEvent(USB_EVENT event, const USB_HUB_PORT_EVENT_DATA *data)
+{
+    hubPorts.address = data->hubAddress;
+    if ((data->port == 0) || (data->port > SIM_HUB_PORTS))
+        return;
+    if (event == EVENT_HUB_PORT_ATTACH)
+    {
+        hubPorts.attached[data->port]++;
+        hubPorts.speed[data->port] = data->speed;
+    }
+    else if (event == EVENT_HUB_PORT_DETACH)
+    {
+        hubPorts.detached[data->port]++;
+    }
+}
+
+/* Runs the host until the port has been reported attached (or detached)
+ * count times in all. */
+static bool HubWaitAttached(uint8_t port, uint8_t count)
+{
+    while ((hubPorts.attached[port] < count) && Step())
+        ;
+    return hubPorts.attached[port] == count;
+}
+
+static bool HubWaitDetached(uint8_t port, uint8_t count)
+{
+    while ((hubPorts.detached[port] < count) && Step())
+        ;
+    return hubPorts.detached[port] == count;
+}
+
+static struct
+{
+    uint8_t     hid;                            /* addresses given by the host */
+    uint8_t     msd;
+    uint8_t     cdc;
+} classAddress;
+
+/* Finds the devices that the HID, MSD and CDC drivers run behind the hub.
+ * Returns true once the disk, the serial device and, with keyboard, the
+ * keyboard are ready.  USB_CDC_DEVICE_NOT_FOUND has the value of
+ * USB_CDC_NORMAL_RUNNING, so the serial device is the one attached device
+ * that is neither the hub nor run by the other two drivers. */
+static bool ClassesReady(bool keyboard)
+{
+    uint8_t     address;
+
+    memset(&classAddress, 0, sizeof(classAddress));
+    for (address = 1; address < 128; address++)
+    {
+        if (USBHostHIDDeviceDetect(address))
+            classAddress.hid = address;
+        else if (USBHostMSDDeviceStatus(address) == USB_MSD_NORMAL_RUNNING)
+            classAddress.msd = address;
+        else if ((address != hubPorts.address) && (USBHostDeviceStatus(address) == USB_DEVICE_ATTACHED))
+            classAddress.cdc = address;
+    }
+    return (!keyboard || (classAddress.hid != 0)) && (classAddress.msd != 0) && (classAddress.cdc != 0) &&
+           USBHostCDC_ApiDeviceDetect();
+}
+
+/* Attaches the hub with a device already on port 1, then plugs and
+ * unplugs devices on the other ports.  Each step must be reported on its
+ * port with the right speed.  Then the hub fails requests: two stalled
+ * requests must be retried, a stalled status change endpoint must be
+ * cleared, and a hub that keeps stalling must be set up again from its
+ * descriptor, with its devices reported detached and found again, and
+ * enumerated again by the host. */
+static bool ScenarioHub(void)
+{
+    uint8_t     step = 0;
+    uint8_t     port;
+    bool        passed;
+    char        detail[160];
+
+    memset(&hubPorts, 0, sizeof(hubPorts));
+    SimHubConnect(1, &simSerial);
+    Attach(&simHub);
+    while ((USBHostDeviceStatus(USB_SINGLE_DEVICE_ADDRESS) != USB_DEVICE_ATTACHED) && Step())
+        ;
+    run.enumerated = USBSimGetTime();
+
+    passed = HubWaitAttached(1, 1) && (hubPorts.speed[1] == USB_HUB_PORT_SPEED_FULL);
+    step++;
+    if (passed)
+    {
+        SimHubConnect(3, &simKeyboard);
+        passed = HubWaitAttached(3, 1) && (hubPorts.speed[3] == USB_HUB_PORT_SPEED_LOW);
+        step++;
+    }
+    if (passed)
+    {
+        SimHubDisconnect(1);
+        passed = HubWaitDetached(1, 1);
+        step++;
+    }
+    if (passed)
+    {
+        SimHubStall(2, false);
+        SimHubConnect(2, &simDisk);
+        passed = HubWaitAttached(2, 1);
+        step++;
+    }
+    if (passed)
+    {
+        SimHubStall(0, true);
+        SimHubDisconnect(3);
+        passed = HubWaitDetached(3, 1);
+        step++;
+    }
+    if (passed)
+    {
+        /* Enough stalls to set the hub up again twice over.  Port 2 is
+         * reported detached and, once the ports are scanned again, attached
+         * a second time. */
+        SimHubStall(10, false);
+        SimHubConnect(4, &simSerial);
+        passed = HubWaitDetached(2, 1) && HubWaitAttached(2, 2) && HubWaitAttached(4, 1);
+        step++;
+    }
+    if (passed)
+    {
+        /* The disk and the serial device behind the hub run again. */
+        while (!ClassesReady(false) && Step())
+            ;
+        passed = !run.timedOut;
+        step++;
+    }
+    for (port = 1; passed && (port <= SIM_HUB_PORTS); port++)
+    {
+        passed = (USBHostHubPortStatus(hubPorts.address, port) ==
+                  (((port == 2) || (port == 4)) ? USB_HUB_PORT_ENABLED : USB_HUB_PORT_EMPTY));
+    }
+
+    snprintf(detail, sizeof(detail), ", %u of 7 steps, %u stalls sent\n"
+             "          attached %u/%u/%u/%u, detached %u/%u/%u/%u on ports 1-4",
+             step - !passed, SimHubStalls(), hubPorts.attached[1], hubPorts.attached[2], hubPorts.attached[3],
+             hubPorts.attached[4], hubPorts.detached[1], hubPorts.detached[2], hubPorts.detached[3], hubPorts.detached[4]);
+    Report("hub", passed, detail);
+    Detach();
+    for (port = 1; port <= SIM_HUB_PORTS; port++)
+        SimHubDisconnect(port);
+    return passed;
+}
+
+#if defined(USB_CDC_RX_BUFFER_SIZE)
+/* Plugs the keyboard, the disk and the serial device into the hub and runs
+ * all three at once: the keyboard types while the disk is written and read
+ * back and the serial data is looped back.  Each device must get an
+ * address of its own, and each transfer must reach the right one. */
+static bool ScenarioHubClass(void)
+{
+    static const char   text[] = "Three at once 42\n";
+    static uint8_t      buffer[DISK_BLOCKS_PER_IO * SIM_DISK_BLOCK_SIZE];
+    static uint8_t      sent[SERIAL_CHUNK];
+    static uint8_t      received[SERIAL_CHUNK];
+    uint8_t             *image = SimDiskImage();
+    char                typed[sizeof(text)];
+    uint8_t             report[8];
+    uint8_t             cdb[10];
+    uint8_t             length = 0;
+    uint8_t             errorCode;
+    uint8_t             count;
+    uint32_t            diskCount;
+    uint32_t            lba = 0;
+    uint32_t            blocks = 0;         /* written, then read back */
+    uint32_t            total = 0;
+    uint32_t            checked = 0;
+    uint32_t            i;
+    uint16_t            n;
+    uint64_t            keysDone = 0;
+    uint64_t            diskDone = 0;
+    uint64_t            serialDone = 0;
+    bool                reading = false;
+    bool                diskBusy = false;
+    bool                sending = false;
+    bool                passed = true;
+    char                c;
+    char                detail[192];
+
+    memset(&hubPorts, 0, sizeof(hubPorts));
+    keyboardCompiled = false;
+    SimHubConnect(1, &simKeyboard);
+    SimHubConnect(2, &simDisk);
+    SimHubConnect(3, &simSerial);
+    Attach(&simHub);
+    while (!ClassesReady(true) && Step())
+        ;
+    run.enumerated = USBSimGetTime();
+    passed = !run.timedOut && (classAddress.hid != classAddress.msd) && (classAddress.msd != classAddress.cdc) &&
+             (classAddress.cdc != classAddress.hid) && (hubPorts.address != classAddress.hid) &&
+             (hubPorts.address != classAddress.msd) && (hubPorts.address != classAddress.cdc);
+
+    SimKeyboardType(text, USBSimGetTime() / USB_SIM_FRAME_TIME + 10);
+    while (passed && ((keysDone == 0) || (diskDone == 0) || (serialDone == 0)))
+    {
+        /* Keyboard */
+        if (!reading && (length < sizeof(text) - 1))
+        {
+            reading = (USBHostHIDRead(classAddress.hid, 0, 0, sizeof(report), report) == USB_SUCCESS);
+        }
+        else if (reading && USBHostHIDTransferIsComplete(classAddress.hid, &errorCode, &count))
+        {
+            reading = false;
+            if ((errorCode == USB_SUCCESS) && (count == sizeof(report)) &&
+                ((c = KeyboardChar(report, count)) != 0))
+            {
+                typed[length++] = c;
+                if (length == sizeof(text) - 1)
+                {
+                    typed[length] = '\0';
+                    passed = (strcmp(typed, text) == 0);
+                    keysDone = USBSimGetTime();
+                }
+            }
+        }
+
+        /* Disk: every block is written, then read back. */
+        if (diskBusy && USBHostMSDTransferIsComplete(classAddress.msd, &errorCode, &diskCount))
+        {
+            diskBusy = false;
+            passed = passed && (errorCode == USB_SUCCESS) && (diskCount == sizeof(buffer));
+            for (i = 0; passed && (blocks >= SIM_DISK_BLOCKS) && (i < sizeof(buffer)); i++)
+                passed = (buffer[i] == (uint8_t)((lba * SIM_DISK_BLOCK_SIZE + i) * 5));
+            blocks += DISK_BLOCKS_PER_IO;
+            if (blocks == 2 * SIM_DISK_BLOCKS)
+                diskDone = USBSimGetTime();
+        }
+        if (passed && !diskBusy && (blocks < 2 * SIM_DISK_BLOCKS))
+        {
+            memset(cdb, 0, sizeof(cdb));
+            lba = blocks % SIM_DISK_BLOCKS;
+            cdb[0] = (blocks < SIM_DISK_BLOCKS) ? 0x2A : 0x28;
+            cdb[2] = lba >> 24;
+            cdb[3] = lba >> 16;
+            cdb[4] = lba >> 8;
+            cdb[5] = lba;
+            cdb[8] = DISK_BLOCKS_PER_IO;
+            if (blocks < SIM_DISK_BLOCKS)
+            {
+                for (i = 0; i < sizeof(buffer); i++)
+                    buffer[i] = (uint8_t)((lba * SIM_DISK_BLOCK_SIZE + i) * 5);
+                diskBusy = (USBHostMSDWrite(classAddress.msd, 0, cdb, sizeof(cdb), buffer, sizeof(buffer)) == USB_SUCCESS);
+            }
+            else
+            {
+                memset(buffer, 0, sizeof(buffer));
+                diskBusy = (USBHostMSDRead(classAddress.msd, 0, cdb, sizeof(cdb), buffer, sizeof(buffer)) == USB_SUCCESS);
+            }
+        }
+
+        /* Serial loopback */
+        if (sending && USBHostCDC_ApiTransferIsComplete(&errorCode, &count))
+        {
+            sending = false;
+            passed = passed && (errorCode == USB_SUCCESS);
+            total += SERIAL_CHUNK;
+        }
+        if (!sending && (total < SERIAL_BYTES))
+        {
+            for (i = 0; i < SERIAL_CHUNK; i++)
+                sent[i] = (uint8_t)(total + i * 3);
+            sending = USBHostCDC_Api_Send_OUT_Data(SERIAL_CHUNK, sent);
+        }
+        while (passed && ((n = USBHostCDC_Api_Read_IN_Data(sizeof(received), received)) != 0))
+        {
+            for (i = 0; passed && (i < n); i++, checked++)
+                passed = (received[i] == (uint8_t)(checked / SERIAL_CHUNK * SERIAL_CHUNK + (checked % SERIAL_CHUNK) * 3));
+        }
+        if ((checked == SERIAL_BYTES) && (serialDone == 0))
+            serialDone = USBSimGetTime();
+
+        if (!Step())
+            passed = false;
+    }
+    for (i = 0; passed && (i < SIM_DISK_BLOCKS * SIM_DISK_BLOCK_SIZE); i++)
+        passed = (image[i] == (uint8_t)(i * 5));
+
+    snprintf(detail, sizeof(detail), ", addresses %u/%u/%u behind hub %u\n"
+             "          %u of %u keys in %.1f ms, disk %u kB in %.1f ms, serial %u kB in %.1f ms",
+             classAddress.hid, classAddress.msd, classAddress.cdc, hubPorts.address,
+             length, (unsigned)(sizeof(text) - 1), (keysDone != 0) ? Ms(keysDone - run.enumerated) : 0.0,
+             (unsigned)(2 * SIM_DISK_BLOCKS * SIM_DISK_BLOCK_SIZE / 1024), (diskDone != 0) ? Ms(diskDone - run.enumerated) : 0.0,
+             (unsigned)(SERIAL_BYTES / 1024), (serialDone != 0) ? Ms(serialDone - run.enumerated) : 0.0);
+    Report("hubclass", passed, detail);
+    Detach();
+    SimHubDisconnect(1);
+    SimHubDisconnect(2);
+    SimHubDisconnect(3);
+    return passed;
+}
+#endif
+
+/* ------------------------------------------------------------------------ */
+
+/* The media interface layer of the MSD driver hands its calls to both
+ * copies of the SCSI layer, see ScenarioScsi(). */
+bool SimMediaInitialize(uint8_t address, uint32_t flags, uint8_t clientDriverID)
+{
+    return USBHostMSDSCSIInitialize(address, flags, clientDriverID) &&
+           SimCachedSCSIInitialize(address, flags, clientDriverID);
+}
+
+bool SimMediaEventHandler(uint8_t address, USB_EVENT event, void *data, uint32_t size)
+{
+    bool    handled;
+
+    handled = USBHostMSDSCSIEventHandler(address, event, data, size);
+    handled = SimCachedSCSIEventHandler(address, event, data, size) && handled;
+    return handled || USB_ApplicationEventHandler(address, event, data, size);
+}
+
+bool USB_ApplicationEventHandler(uint8_t address, USB_EVENT event, void *data, uint32_t size)
+{
+    (void)data;
+    (void)size;
+
+    if (verbose)
+        printf("          [%9.3f ms] event %d, address %u\n", Ms(USBSimGetTime()), (int)event, address);
+
+    switch ((int)event)
+    {
+        case EVENT_VBUS_REQUEST_POWER:
+        case EVENT_VBUS_RELEASE_POWER:
+        case EVENT_DETACH:
+        case EVENT_HUB_ATTACH:
+        case EVENT_MSD_ATTACH:
+        case EVENT_MSD_MAX_LUN:
+        case EVENT_CDC_ATTACH:
+        case EVENT_CDC_NAK_TIMEOUT:
+            return true;
+
+        case EVENT_HID_RPT_DESC_PARSED:         /* accept the keyboard */
+            keyboardCompiled = USBHostHID_ApiCompileReport(hidReportInput, 0, &keyboardPlan,
+                                    keyboardFields, sizeof(keyboardFields) / sizeof(keyboardFields[0])) &&
+                               USBHostHID_ApiResolveUsage(0x07, 0xE1, hidReportInput, &keyboardShift[0]) &&
+                               USBHostHID_ApiResolveUsage(0x07, 0xE5, hidReportInput, &keyboardShift[1]);
+            return true;
+
+        case EVENT_HID_ATTACH:
+            return true;
+
+        case EVENT_HUB_PORT_ATTACH:
+        case EVENT_HUB_PORT_DETACH:
+        case EVENT_HUB_PORT_OVERCURRENT:
+            HubPortEvent(event, (USB_HUB_PORT_EVENT_DATA *)data);
+            return true;
+
+#if defined(USB_SUPPORT_ISOCHRONOUS_TRANSFERS)
+        case EVENT_AUDIO_ATTACH:
+            audio.id = *(USB_AUDIO_V1_DEVICE_ID *)data;
+            audio.attached = true;
+            return true;
+
+        case EVENT_AUDIO_INTERFACE_SET:
+            audio.interfaceSet = true;
+            return true;
+
+        case EVENT_AUDIO_FREQUENCY_SET:
+            audio.frequencySet = true;
+            return true;
+
+        case EVENT_AUDIO_STREAM_RECEIVED:
+        case EVENT_AUDIO_DETACH:
+            return true;
+
+        case EVENT_ANDROID_ATTACH:
+            android.address = address;
+            android.attached = true;
+            return true;
+
+        case EVENT_ANDROID_HID_REGISTRATION_COMPLETE:
+            android.registered++;
+            return true;
+
+        case EVENT_ANDROID_HID_SEND_EVENT_COMPLETE:
+            android.completed++;
+            return true;
+
+        case EVENT_ANDROID_DETACH:
+            return true;
+#endif
+
+        case EVENT_UNSUPPORTED_DEVICE:
+        case EVENT_CANNOT_ENUMERATE:
+        case EVENT_CLIENT_INIT_ERROR:
+        case EVENT_OUT_OF_MEMORY:
+        case EVENT_UNSPECIFIED_ERROR:
+            printf("          host error event %d\n", (int)event);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool USB_ApplicationDataEventHandler(uint8_t address, USB_EVENT event, void *data, uint32_t size)
+{
+    (void)address;
+    (void)event;
+    (void)data;
+    (void)size;
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct
+    {
+        const char  *name;
+        bool        (*run)(void);
+    } scenarios[] =
+    {
+        { "keyboard",   ScenarioKeyboard },
+        { "disk",       ScenarioDisk },
+        { "scsi",       ScenarioScsi },
+        { "serial",     ScenarioSerial },
+        { "lookup",     ScenarioLookup },
+        { "hotplug",    ScenarioHotplug },
+        { "hub",        ScenarioHub },
+#if defined(USB_CDC_RX_BUFFER_SIZE)
+        { "hubclass",   ScenarioHubClass },
+#endif
+#if defined(USB_SUPPORT_ISOCHRONOUS_TRANSFERS)
+        { "audio",      ScenarioAudio },
+#if defined(USB_AUDIO_RATE_MATCHING)
+        { "drift",      ScenarioDrift },
+#endif
+#endif
+#if defined(USB_ENABLE_TRANSFER_EVENT)
+        { "android",    ScenarioAndroid },
+#endif
+    };
+    const int   count = sizeof(scenarios) / sizeof(scenarios[0]);
+    int         failed = 0;
+    int         first;
+    int         i;
+    int         j;
+
+    first = 1;
+    if ((argc > 1) && (strcmp(argv[1], "-v") == 0))
+    {
+        verbose = true;
+        first = 2;
+    }
+
+    USBSimInitialize();
+#if defined(USB_ENABLE_TRANSFER_EVENT)
+    AndroidAppStart(&accessoryInfo);
+#endif
+    if (!USBHostInit(0))
+    {
+        fprintf(stderr, "usbhostsim: USBHostInit() failed\n");
+        return 2;
+    }
+
+    if (first >= argc)
+    {
+        for (i = 0; i < count; i++)
+            failed += !scenarios[i].run();
+        return (failed != 0);
+    }
+
+    for (j = first; j < argc; j++)
+    {
+        for (i = 0; (i < count) && (strcmp(argv[j], scenarios[i].name) != 0); i++)
+            ;
+        if (i == count)
+        {
+            fprintf(stderr, "usage: usbhostsim [-v] [keyboard|disk|scsi|serial|lookup|hotplug|hub|hubclass|audio|drift|android ...]\n");
+            return 2;
+        }
+        failed += !scenarios[i].run();
+    }
+    return (failed != 0);
+}